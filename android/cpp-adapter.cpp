@@ -1,8 +1,25 @@
 #include <jni.h>
+#include <fbjni/fbjni.h>
+#include <ReactCommon/CallInvokerHolder.h>
 #include "react-native-opaque.h"
 
+JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM *vm, void *)
+{
+    return facebook::jni::initialize(vm, [] {});
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_opaque_OpaqueModule_initialize(JNIEnv *env, jclass clazz, jlong jsiPtr, jobject callInvokerHolder)
+{
+    auto holder = facebook::jni::alias_ref<facebook::react::CallInvokerHolder::javaobject>{
+        reinterpret_cast<facebook::react::CallInvokerHolder::javaobject>(callInvokerHolder)};
+    NativeOpaque::installOpaque(
+        *reinterpret_cast<facebook::jsi::Runtime *>(jsiPtr),
+        holder->cthis()->getCallInvoker());
+}
+
 extern "C" JNIEXPORT void JNICALL
-Java_com_opaque_OpaqueModule_initialize(JNIEnv *env, jclass clazz, jlong jsiPtr, jstring docPath)
+Java_com_opaque_OpaqueModule_trimMemory(JNIEnv *env, jclass clazz)
 {
-    NativeOpaque::installOpaque(*reinterpret_cast<facebook::jsi::Runtime *>(jsiPtr));
-}
\ No newline at end of file
+    NativeOpaque::trimMemory();
+}
@@ -1,14 +1,20 @@
 package com.opaque;
 
+import android.content.ComponentCallbacks2;
+import android.content.res.Configuration;
+
 import androidx.annotation.NonNull;
 
 import com.facebook.react.bridge.ReactApplicationContext;
 import com.facebook.react.bridge.ReactContextBaseJavaModule;
 import com.facebook.react.bridge.ReactMethod;
+import com.facebook.react.turbomodule.core.CallInvokerHolderImpl;
 
-public class OpaqueModule extends ReactContextBaseJavaModule {
+public class OpaqueModule extends ReactContextBaseJavaModule implements ComponentCallbacks2 {
   public static final String NAME = "Opaque";
-  private static native void initialize(long jsiPtr);
+  private static native void initialize(long jsiPtr, CallInvokerHolderImpl callInvokerHolder);
+  private static native void trimMemory();
+  private boolean installed = false;
 
   public OpaqueModule(ReactApplicationContext reactContext) {
     super(reactContext);
@@ -27,11 +33,43 @@ public class OpaqueModule extends ReactContextBaseJavaModule {
 
       ReactApplicationContext context = getReactApplicationContext();
       initialize(
-        context.getJavaScriptContextHolder().get()
+        context.getJavaScriptContextHolder().get(),
+        (CallInvokerHolderImpl) context.getCatalystInstance().getJSCallInvokerHolder()
       );
+      if (!installed) {
+        context.getApplicationContext().registerComponentCallbacks(this);
+        installed = true;
+      }
       return true;
     } catch (Exception exception) {
       return false;
     }
   }
-}
\ No newline at end of file
+
+  @Override
+  public void invalidate() {
+    if (installed) {
+      getReactApplicationContext().getApplicationContext().unregisterComponentCallbacks(this);
+      installed = false;
+    }
+    super.invalidate();
+  }
+
+  // Frees the memory kept for the key stretching once the app is in the
+  // background or the system runs low on memory.
+  @Override
+  public void onTrimMemory(int level) {
+    if (level >= TRIM_MEMORY_RUNNING_LOW) {
+      trimMemory();
+    }
+  }
+
+  @Override
+  public void onLowMemory() {
+    trimMemory();
+  }
+
+  @Override
+  public void onConfigurationChanged(@NonNull Configuration newConfig) {
+  }
+}
@@ -0,0 +1,78 @@
+#include "./alloc-counter.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+
+// Counts allocations by interposing the malloc family of functions and
+// forwarding them to the glibc implementations. Rust's system allocator as
+// well as operator new end up here, so the counter covers both sides of the
+// bridge.
+
+extern "C" {
+  void* __libc_malloc(size_t size);
+  void* __libc_calloc(size_t count, size_t size);
+  void* __libc_realloc(void* ptr, size_t size);
+  void* __libc_memalign(size_t alignment, size_t size);
+  void __libc_free(void* ptr);
+}
+
+namespace {
+  std::atomic<uint64_t> allocations{0};
+
+  void countAllocation() {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+  }
+}  // namespace
+
+namespace NativeOpaque {
+
+  uint64_t allocationCount() {
+    return allocations.load(std::memory_order_relaxed);
+  }
+
+}  // namespace NativeOpaque
+
+extern "C" {
+  void* malloc(size_t size) noexcept {
+    countAllocation();
+    return __libc_malloc(size);
+  }
+
+  void* calloc(size_t count, size_t size) noexcept {
+    countAllocation();
+    return __libc_calloc(count, size);
+  }
+
+  void* realloc(void* ptr, size_t size) noexcept {
+    countAllocation();
+    return __libc_realloc(ptr, size);
+  }
+
+  void* memalign(size_t alignment, size_t size) noexcept {
+    countAllocation();
+    return __libc_memalign(alignment, size);
+  }
+
+  void* aligned_alloc(size_t alignment, size_t size) noexcept {
+    countAllocation();
+    return __libc_memalign(alignment, size);
+  }
+
+  int posix_memalign(void** ptr, size_t alignment, size_t size) noexcept {
+    if (alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0) {
+      return EINVAL;
+    }
+    countAllocation();
+    void* result = __libc_memalign(alignment, size);
+    if (result == nullptr && size != 0) {
+      return ENOMEM;
+    }
+    *ptr = result;
+    return 0;
+  }
+
+  void free(void* ptr) noexcept {
+    __libc_free(ptr);
+  }
+}
@@ -0,0 +1,15 @@
+#ifndef BENCHMARKS_ALLOC_COUNTER_H_
+#define BENCHMARKS_ALLOC_COUNTER_H_
+
+#include <cstdint>
+
+namespace NativeOpaque {
+
+  // Number of heap allocations made by the process so far. The counter is
+  // maintained by the malloc family overrides in alloc-counter.cpp, which
+  // also catch the allocations made by the Rust library.
+  uint64_t allocationCount();
+
+}  // namespace NativeOpaque
+
+#endif  // BENCHMARKS_ALLOC_COUNTER_H_
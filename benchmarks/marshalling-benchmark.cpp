@@ -0,0 +1,198 @@
+#include <benchmark/benchmark.h>
+#include <hermes/hermes.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "./alloc-counter.h"
+#include "opaque-marshalling.h"
+#include "opaque-rust.h"
+
+// Times the JSI marshalling layer of the module on its own: reading the
+// params from JS objects and building the results, without calling into
+// Rust. Runs on a host build of Hermes.
+namespace NativeOpaque {
+  // Lengths of the base64 encoded messages of the default cipher suite.
+  const size_t kClientLoginStateLength = 256;
+  const size_t kLoginResponseLength = 427;
+  const size_t kKeyLength = 86;
+  const size_t kPublicKeyLength = 43;
+
+  struct Fixture {
+    Fixture() : runtime(facebook::hermes::makeHermesRuntime()), names(std::make_unique<PropNames>(*runtime)) {
+      auto& rt = *runtime;
+      auto params = jsi::Object(rt);
+      params.setProperty(rt, "clientLoginState", std::string(kClientLoginStateLength, 'A'));
+      params.setProperty(rt, "loginResponse", std::string(kLoginResponseLength, 'B'));
+      params.setProperty(rt, "password", "hunter42");
+      finishClientLoginParams = std::make_unique<jsi::Object>(std::move(params));
+
+      finishClientLoginResult = std::make_unique<OpaqueFinishClientLoginResult>(OpaqueFinishClientLoginResult{
+        .finish_login_request = std::string(kKeyLength, 'C'),
+        .session_key = std::string(kKeyLength, 'D'),
+        .export_key = std::string(kKeyLength, 'E'),
+        .server_static_public_key = std::string(kPublicKeyLength, 'F'),
+      });
+    }
+
+    // Members are destroyed in reverse order, so all JSI values are
+    // released before the runtime.
+    std::unique_ptr<jsi::Runtime> runtime;
+    std::unique_ptr<PropNames> names;
+    std::unique_ptr<jsi::Object> finishClientLoginParams;
+    std::unique_ptr<OpaqueFinishClientLoginResult> finishClientLoginResult;
+  };
+
+  Fixture& fixture() {
+    static Fixture f;
+    return f;
+  }
+
+  // Runs `call` in a plain Google Benchmark loop, the calls are too short to
+  // be timed one by one. Reports the heap allocations per call, including
+  // the ones of the runtime.
+  template <typename Call>
+  void measure(benchmark::State& state, Call call) {
+    auto allocations = allocationCount();
+    for (auto _ : state) {
+      call();
+    }
+    state.counters["allocs"] = static_cast<double>(allocationCount() - allocations) / state.iterations();
+  }
+
+  void BM_getPropertyByName(benchmark::State& state) {
+    auto& f = fixture();
+    auto& rt = *f.runtime;
+    measure(state, [&] {
+      benchmark::DoNotOptimize(f.finishClientLoginParams->getProperty(rt, "clientLoginState"));
+      benchmark::DoNotOptimize(f.finishClientLoginParams->getProperty(rt, "loginResponse"));
+      benchmark::DoNotOptimize(f.finishClientLoginParams->getProperty(rt, "password"));
+    });
+  }
+  BENCHMARK(BM_getPropertyByName)->Name("marshalling/getProperty/char");
+
+  void BM_getPropertyByPropNameID(benchmark::State& state) {
+    auto& f = fixture();
+    auto& rt = *f.runtime;
+    measure(state, [&] {
+      benchmark::DoNotOptimize(f.finishClientLoginParams->getProperty(rt, f.names->clientLoginState));
+      benchmark::DoNotOptimize(f.finishClientLoginParams->getProperty(rt, f.names->loginResponse));
+      benchmark::DoNotOptimize(f.finishClientLoginParams->getProperty(rt, f.names->password));
+    });
+  }
+  BENCHMARK(BM_getPropertyByPropNameID)->Name("marshalling/getProperty/propNameId");
+
+  void BM_readFinishClientLoginParams(benchmark::State& state) {
+    auto& f = fixture();
+    measure(state, [&] {
+      benchmark::DoNotOptimize(readFinishClientLoginParams(*f.runtime, *f.names, *f.finishClientLoginParams));
+    });
+  }
+  BENCHMARK(BM_readFinishClientLoginParams)->Name("marshalling/readFinishClientLoginParams");
+
+  void BM_makeFinishClientLoginResult(benchmark::State& state) {
+    auto& f = fixture();
+    measure(state, [&] {
+      benchmark::DoNotOptimize(makeFinishClientLoginResult(*f.runtime, *f.names, f.finishClientLoginResult.get()));
+    });
+  }
+  BENCHMARK(BM_makeFinishClientLoginResult)->Name("marshalling/makeFinishClientLoginResult");
+
+  // Creating a JS string from a Rust string, with and without the copy into
+  // a std::string.
+  void BM_stringFromStdString(benchmark::State& state) {
+    auto& f = fixture();
+    auto& rt = *f.runtime;
+    const ::rust::String str = std::string(kLoginResponseLength, 'B');
+    measure(state, [&] {
+      benchmark::DoNotOptimize(jsi::String::createFromUtf8(rt, std::string(str)));
+    });
+  }
+  BENCHMARK(BM_stringFromStdString)->Name("marshalling/string/stdString");
+
+  void BM_makeString(benchmark::State& state) {
+    auto& f = fixture();
+    auto& rt = *f.runtime;
+    const ::rust::String str = std::string(kLoginResponseLength, 'B');
+    measure(state, [&] {
+      benchmark::DoNotOptimize(makeString(rt, str));
+    });
+  }
+  BENCHMARK(BM_makeString)->Name("marshalling/string/makeString");
+
+  void BM_makeUint8Array(benchmark::State& state) {
+    auto& f = fixture();
+    ::rust::Vec<uint8_t> bytes;
+    for (int64_t i = 0; i < state.range(0); i++) {
+      bytes.push_back(static_cast<uint8_t>(i));
+    }
+    measure(state, [&] {
+      benchmark::DoNotOptimize(makeUint8Array(*f.runtime, *f.names, bytes));
+    });
+  }
+  BENCHMARK(BM_makeUint8Array)->Name("marshalling/makeUint8Array")->Arg(32)->Arg(320);
+
+  // A failed login as seen from JS: the host function throws a JSError
+  // which the caller catches, or it returns the failed result of the
+  // result mode. Both return the error message to the benchmark.
+  const char* const kFailureMessage =
+    "opaque protocol error at \"finish server login\"; Error in validating credentials";
+
+  // Evaluates `caller`, a JS function which takes the host function and
+  // returns the function to benchmark.
+  jsi::Value makeJsCaller(jsi::Runtime& rt, jsi::Function host, const char* caller) {
+    auto code = std::make_shared<jsi::StringBuffer>(caller);
+    auto func = rt.evaluateJavaScript(code, "marshalling-benchmark").asObject(rt).asFunction(rt);
+    return func.call(rt, std::move(host));
+  }
+
+  void BM_failedLoginThrow(benchmark::State& state) {
+    auto& f = fixture();
+    auto& rt = *f.runtime;
+    auto host = jsi::Function::createFromHostFunction(rt, jsi::PropNameID::forAscii(rt, "fail"), 0,
+      [](jsi::Runtime& rt, const jsi::Value&, const jsi::Value*, size_t) -> jsi::Value {
+        throw jsi::JSError(rt, kFailureMessage);
+      });
+    auto call = makeJsCaller(rt, std::move(host), R"JS(
+      (function (fail) {
+        return function () {
+          try {
+            return fail();
+          } catch (e) {
+            return e.message;
+          }
+        };
+      })
+    )JS").asObject(rt).asFunction(rt);
+    measure(state, [&] {
+      benchmark::DoNotOptimize(call.call(rt));
+    });
+  }
+  BENCHMARK(BM_failedLoginThrow)->Name("marshalling/failedLogin/throw");
+
+  void BM_failedLoginResult(benchmark::State& state) {
+    auto& f = fixture();
+    auto& rt = *f.runtime;
+    auto host = jsi::Function::createFromHostFunction(rt, jsi::PropNameID::forAscii(rt, "fail"), 0,
+      [&f](jsi::Runtime& rt, const jsi::Value&, const jsi::Value*, size_t) -> jsi::Value {
+        return makeFailedResult(rt, *f.names, OpaqueErrorCode::InvalidLogin,
+          jsi::String::createFromAscii(rt, kFailureMessage));
+      });
+    auto call = makeJsCaller(rt, std::move(host), R"JS(
+      (function (fail) {
+        return function () {
+          var result = fail();
+          return result.ok ? result.value : result.message;
+        };
+      })
+    )JS").asObject(rt).asFunction(rt);
+    measure(state, [&] {
+      benchmark::DoNotOptimize(call.call(rt));
+    });
+  }
+  BENCHMARK(BM_failedLoginResult)->Name("marshalling/failedLogin/result");
+}  // namespace NativeOpaque
+
+BENCHMARK_MAIN();
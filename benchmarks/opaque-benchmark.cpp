@@ -0,0 +1,612 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "./alloc-counter.h"
+#include "opaque-rust.h"
+
+extern "C" {
+  // Phase entry points from rust/src/bench.rs, see the "bench" cargo feature.
+  void opaque_bench_argon2();
+  void opaque_bench_base64(size_t len);
+  void opaque_bench_curve_registration();
+  void opaque_bench_curve_login();
+}
+
+namespace NativeOpaque {
+  using Clock = std::chrono::steady_clock;
+  using Bytes = std::vector<uint8_t>;
+
+  // Collects the latency and the number of allocations of every single call.
+  // Google Benchmark only reports the mean, so the percentiles are computed
+  // here and attached as counters.
+  class CallStats {
+   public:
+    void add(Clock::duration duration, uint64_t allocations) {
+      durations_.push_back(duration);
+      allocations_ += allocations;
+    }
+
+    void report(benchmark::State& state) {
+      if (durations_.empty()) {
+        return;
+      }
+      std::sort(durations_.begin(), durations_.end());
+      state.counters["p50_us"] = percentile(0.5);
+      state.counters["p90_us"] = percentile(0.9);
+      state.counters["p99_us"] = percentile(0.99);
+      state.counters["max_us"] = toMicroseconds(durations_.back());
+      state.counters["allocs"] = static_cast<double>(allocations_) / durations_.size();
+    }
+
+   private:
+    static double toMicroseconds(Clock::duration duration) {
+      return std::chrono::duration<double, std::micro>(duration).count();
+    }
+
+    double percentile(double p) const {
+      auto index = static_cast<size_t>(p * (durations_.size() - 1));
+      return toMicroseconds(durations_[index]);
+    }
+
+    std::vector<Clock::duration> durations_;
+    uint64_t allocations_ = 0;
+  };
+
+  // Times `call(input)` with a fresh input from `prepare()` for every
+  // iteration. Building the input (e.g. copying the params) is excluded from
+  // both the timing and the allocation count.
+  template <typename Prepare, typename Call>
+  void measure(benchmark::State& state, Prepare prepare, Call call) {
+    CallStats stats;
+    for (auto _ : state) {
+      auto input = prepare();
+      auto allocations = allocationCount();
+      auto start = Clock::now();
+      call(input);
+      auto end = Clock::now();
+      stats.add(end - start, allocationCount() - allocations);
+      state.SetIterationTime(std::chrono::duration<double>(end - start).count());
+    }
+    stats.report(state);
+  }
+
+  // Times a call without inputs.
+  template <typename Call>
+  void measure(benchmark::State& state, Call call) {
+    measure(state, [] { return 0; }, [&call](int) { call(); });
+  }
+
+  Bytes toBytes(const ::rust::Vec<uint8_t>& vec) {
+    return Bytes(vec.begin(), vec.end());
+  }
+
+  ::rust::Slice<const uint8_t> toSlice(const Bytes& bytes) {
+    return {bytes.data(), bytes.size()};
+  }
+
+  const char* const kUserIdentifier = "user123";
+  const char* const kPassword = "hunter42";
+  // The benchmarks measure the default suite, rust/benches/cipher_suites.rs
+  // compares the suites.
+  const OpaqueCipherSuite kSuite = OpaqueCipherSuite::Default;
+  // same as the OutputBuffer of the JSI module
+  const size_t kOutputBufferSize = 2048;
+
+  // Inputs for every step of the protocol, produced by one registration and
+  // one login. The states and messages can be reused since every call only
+  // deserializes them.
+  struct Fixture {
+    std::string serverSetup;
+    ::rust::Box<ServerSetupHandle> serverSetupHandle;
+    std::string registrationRequest;
+    std::string registrationResponse;
+    std::string clientRegistrationState;
+    std::string registrationRecord;
+    std::string clientLoginState;
+    std::string startLoginRequest;
+    std::string loginResponse;
+    std::string serverLoginState;
+    std::string finishLoginRequest;
+    // the finish request of a second login, which fails with serverLoginState
+    std::string forgedFinishLoginRequest;
+  };
+
+  struct BinaryFixture {
+    Bytes serverSetup;
+    Bytes registrationRequest;
+    Bytes registrationResponse;
+    Bytes clientRegistrationState;
+    Bytes registrationRecord;
+    Bytes clientLoginState;
+    Bytes startLoginRequest;
+    Bytes loginResponse;
+    Bytes serverLoginState;
+    Bytes finishLoginRequest;
+  };
+
+  OpaqueStartServerLoginParams startServerLoginParams(const Fixture& f) {
+    ::rust::Vec<::rust::String> registrationRecord;
+    registrationRecord.push_back(f.registrationRecord);
+    return {
+      .registration_record = std::move(registrationRecord),
+      .start_login_request = f.startLoginRequest,
+      .user_identifier = kUserIdentifier,
+    };
+  }
+
+  const Fixture& fixture() {
+    static const Fixture f = [] {
+      auto serverSetup = std::string(opaque_create_server_setup(kSuite));
+      Fixture f = {
+        .serverSetup = serverSetup,
+        .serverSetupHandle = opaque_create_server_setup_handle(serverSetup, kSuite),
+      };
+      auto registrationStart = opaque_start_client_registration({.password = kPassword});
+      f.registrationRequest = std::string(registrationStart.registration_request);
+      f.clientRegistrationState = std::string(registrationStart.client_registration_state);
+      f.registrationResponse = std::string(opaque_create_server_registration_response(f.serverSetup, {
+        .user_identifier = kUserIdentifier,
+        .registration_request = f.registrationRequest,
+      }).registration_response);
+      f.registrationRecord = std::string(opaque_finish_client_registration({
+        .password = kPassword,
+        .registration_response = f.registrationResponse,
+        .client_registration_state = f.clientRegistrationState,
+      }).registration_record);
+
+      auto loginStart = opaque_start_client_login({.password = kPassword});
+      f.clientLoginState = std::string(loginStart.client_login_state);
+      f.startLoginRequest = std::string(loginStart.start_login_request);
+      auto serverLoginStart = opaque_start_server_login(f.serverSetup, startServerLoginParams(f));
+      f.serverLoginState = std::string(serverLoginStart.server_login_state);
+      f.loginResponse = std::string(serverLoginStart.login_response);
+      f.finishLoginRequest = std::string(opaque_finish_client_login({
+        .client_login_state = f.clientLoginState,
+        .login_response = f.loginResponse,
+        .password = kPassword,
+      })->finish_login_request);
+
+      auto secondLoginStart = opaque_start_client_login({.password = kPassword});
+      auto secondParams = startServerLoginParams(f);
+      secondParams.start_login_request = secondLoginStart.start_login_request;
+      auto secondServerLoginStart = opaque_start_server_login(f.serverSetup, std::move(secondParams));
+      f.forgedFinishLoginRequest = std::string(opaque_finish_client_login({
+        .client_login_state = secondLoginStart.client_login_state,
+        .login_response = secondServerLoginStart.login_response,
+        .password = kPassword,
+      })->finish_login_request);
+      return f;
+    }();
+    return f;
+  }
+
+  const BinaryFixture& binaryFixture() {
+    static const BinaryFixture f = [] {
+      BinaryFixture f;
+      f.serverSetup = toBytes(opaque_create_server_setup_binary(kSuite));
+      auto registrationStart = opaque_start_client_registration_binary(kPassword, kSuite);
+      f.registrationRequest = toBytes(registrationStart.registration_request);
+      f.clientRegistrationState = toBytes(registrationStart.client_registration_state);
+      f.registrationResponse = toBytes(opaque_create_server_registration_response_binary(
+        toSlice(f.serverSetup), kUserIdentifier, toSlice(f.registrationRequest), kSuite).registration_response);
+      f.registrationRecord = toBytes(opaque_finish_client_registration_binary(
+        kPassword, toSlice(f.registrationResponse), toSlice(f.clientRegistrationState), {}, {}, {}, kSuite)
+        .registration_record);
+
+      auto loginStart = opaque_start_client_login_binary(kPassword, kSuite);
+      f.clientLoginState = toBytes(loginStart.client_login_state);
+      f.startLoginRequest = toBytes(loginStart.start_login_request);
+      auto serverLoginStart = opaque_start_server_login_binary(
+        toSlice(f.serverSetup), toSlice(f.registrationRecord), true, toSlice(f.startLoginRequest),
+        kUserIdentifier, {}, {}, kSuite);
+      f.serverLoginState = toBytes(serverLoginStart.server_login_state);
+      f.loginResponse = toBytes(serverLoginStart.login_response);
+      f.finishLoginRequest = toBytes(opaque_finish_client_login_binary(
+        toSlice(f.clientLoginState), toSlice(f.loginResponse), kPassword, {}, {}, {}, kSuite)->finish_login_request);
+      return f;
+    }();
+    return f;
+  }
+
+  void registerBenchmark(const std::string& name, std::function<void(benchmark::State&)> func) {
+    benchmark::RegisterBenchmark(name.c_str(), [func](benchmark::State& state) { func(state); })
+      ->UseManualTime()
+      ->Unit(benchmark::kMicrosecond);
+  }
+
+  void registerClientBenchmarks() {
+    registerBenchmark("opaque_start_client_registration/string", [](benchmark::State& state) {
+      measure(state, [] {
+        return OpaqueStartClientRegistrationParams{.password = kPassword};
+      }, [](OpaqueStartClientRegistrationParams& params) {
+        benchmark::DoNotOptimize(opaque_start_client_registration(std::move(params)));
+      });
+    });
+    registerBenchmark("opaque_start_client_registration/binary", [](benchmark::State& state) {
+      measure(state, [] {
+        benchmark::DoNotOptimize(opaque_start_client_registration_binary(kPassword, kSuite));
+      });
+    });
+
+    registerBenchmark("opaque_finish_client_registration/string", [](benchmark::State& state) {
+      const auto& f = fixture();
+      measure(state, [&f] {
+        return OpaqueFinishClientRegistrationParams{
+          .password = kPassword,
+          .registration_response = f.registrationResponse,
+          .client_registration_state = f.clientRegistrationState,
+        };
+      }, [](OpaqueFinishClientRegistrationParams& params) {
+        benchmark::DoNotOptimize(opaque_finish_client_registration(std::move(params)));
+      });
+    });
+    registerBenchmark("opaque_finish_client_registration/binary", [](benchmark::State& state) {
+      const auto& f = binaryFixture();
+      measure(state, [&f] {
+        benchmark::DoNotOptimize(opaque_finish_client_registration_binary(
+          kPassword, toSlice(f.registrationResponse), toSlice(f.clientRegistrationState), {}, {}, {}, kSuite));
+      });
+    });
+
+    registerBenchmark("opaque_start_client_login/string", [](benchmark::State& state) {
+      measure(state, [] {
+        return OpaqueStartClientLoginParams{.password = kPassword};
+      }, [](OpaqueStartClientLoginParams& params) {
+        benchmark::DoNotOptimize(opaque_start_client_login(std::move(params)));
+      });
+    });
+    registerBenchmark("opaque_start_client_login/binary", [](benchmark::State& state) {
+      measure(state, [] {
+        benchmark::DoNotOptimize(opaque_start_client_login_binary(kPassword, kSuite));
+      });
+    });
+
+    registerBenchmark("opaque_finish_client_login/string", [](benchmark::State& state) {
+      const auto& f = fixture();
+      measure(state, [&f] {
+        return OpaqueFinishClientLoginParams{
+          .client_login_state = f.clientLoginState,
+          .login_response = f.loginResponse,
+          .password = kPassword,
+        };
+      }, [](OpaqueFinishClientLoginParams& params) {
+        benchmark::DoNotOptimize(opaque_finish_client_login(std::move(params)));
+      });
+    });
+    registerBenchmark("opaque_finish_client_login/binary", [](benchmark::State& state) {
+      const auto& f = binaryFixture();
+      measure(state, [&f] {
+        benchmark::DoNotOptimize(opaque_finish_client_login_binary(
+          toSlice(f.clientLoginState), toSlice(f.loginResponse), kPassword, {}, {}, {}, kSuite));
+      });
+    });
+    registerBenchmark("opaque_finish_client_login/into", [](benchmark::State& state) {
+      const auto& f = fixture();
+      measure(state, [&f] {
+        std::array<uint8_t, kOutputBufferSize> out;
+        benchmark::DoNotOptimize(opaque_finish_client_login_into({
+          .client_login_state = f.clientLoginState,
+          .login_response = f.loginResponse,
+          .password = kPassword,
+        }, {out.data(), out.size()}));
+      });
+    });
+  }
+
+  void registerServerBenchmarks() {
+    registerBenchmark("opaque_create_server_setup/string", [](benchmark::State& state) {
+      measure(state, [] {
+        benchmark::DoNotOptimize(opaque_create_server_setup(kSuite));
+      });
+    });
+    registerBenchmark("opaque_create_server_setup/binary", [](benchmark::State& state) {
+      measure(state, [] {
+        benchmark::DoNotOptimize(opaque_create_server_setup_binary(kSuite));
+      });
+    });
+
+    registerBenchmark("opaque_create_server_setup_handle/string", [](benchmark::State& state) {
+      const auto& f = fixture();
+      measure(state, [&f] {
+        return ::rust::String(f.serverSetup);
+      }, [](::rust::String& serverSetup) {
+        benchmark::DoNotOptimize(opaque_create_server_setup_handle(std::move(serverSetup), kSuite));
+      });
+    });
+    registerBenchmark("opaque_create_server_setup_handle/binary", [](benchmark::State& state) {
+      const auto& f = binaryFixture();
+      measure(state, [&f] {
+        benchmark::DoNotOptimize(opaque_create_server_setup_handle_binary(toSlice(f.serverSetup), kSuite));
+      });
+    });
+
+    registerBenchmark("opaque_get_server_public_key/string", [](benchmark::State& state) {
+      const auto& f = fixture();
+      measure(state, [&f] {
+        return ::rust::String(f.serverSetup);
+      }, [](::rust::String& serverSetup) {
+        benchmark::DoNotOptimize(opaque_get_server_public_key(std::move(serverSetup), kSuite));
+      });
+    });
+    registerBenchmark("opaque_get_server_public_key/handle", [](benchmark::State& state) {
+      const auto& f = fixture();
+      measure(state, [&f] {
+        benchmark::DoNotOptimize(opaque_get_server_public_key_with_setup(*f.serverSetupHandle));
+      });
+    });
+    registerBenchmark("opaque_get_server_public_key/binary", [](benchmark::State& state) {
+      const auto& f = binaryFixture();
+      measure(state, [&f] {
+        benchmark::DoNotOptimize(opaque_get_server_public_key_binary(toSlice(f.serverSetup), kSuite));
+      });
+    });
+
+    registerBenchmark("opaque_create_server_registration_response/string", [](benchmark::State& state) {
+      const auto& f = fixture();
+      measure(state, [&f] {
+        return std::make_pair(::rust::String(f.serverSetup), OpaqueCreateServerRegistrationResponseParams{
+          .user_identifier = kUserIdentifier,
+          .registration_request = f.registrationRequest,
+        });
+      }, [](auto& input) {
+        benchmark::DoNotOptimize(opaque_create_server_registration_response(
+          std::move(input.first), std::move(input.second)));
+      });
+    });
+    registerBenchmark("opaque_create_server_registration_response/handle", [](benchmark::State& state) {
+      const auto& f = fixture();
+      measure(state, [&f] {
+        return OpaqueCreateServerRegistrationResponseParams{
+          .user_identifier = kUserIdentifier,
+          .registration_request = f.registrationRequest,
+        };
+      }, [&f](OpaqueCreateServerRegistrationResponseParams& params) {
+        benchmark::DoNotOptimize(opaque_create_server_registration_response_with_setup(
+          *f.serverSetupHandle, std::move(params)));
+      });
+    });
+    registerBenchmark("opaque_create_server_registration_response/binary", [](benchmark::State& state) {
+      const auto& f = binaryFixture();
+      measure(state, [&f] {
+        benchmark::DoNotOptimize(opaque_create_server_registration_response_binary(
+          toSlice(f.serverSetup), kUserIdentifier, toSlice(f.registrationRequest), kSuite));
+      });
+    });
+
+    registerBenchmark("opaque_start_server_login/string", [](benchmark::State& state) {
+      const auto& f = fixture();
+      measure(state, [&f] {
+        return std::make_pair(::rust::String(f.serverSetup), startServerLoginParams(f));
+      }, [](auto& input) {
+        benchmark::DoNotOptimize(opaque_start_server_login(std::move(input.first), std::move(input.second)));
+      });
+    });
+    registerBenchmark("opaque_start_server_login/handle", [](benchmark::State& state) {
+      const auto& f = fixture();
+      measure(state, [&f] {
+        return startServerLoginParams(f);
+      }, [&f](OpaqueStartServerLoginParams& params) {
+        benchmark::DoNotOptimize(opaque_start_server_login_with_setup(*f.serverSetupHandle, std::move(params)));
+      });
+    });
+    registerBenchmark("opaque_start_server_login/binary", [](benchmark::State& state) {
+      const auto& f = binaryFixture();
+      measure(state, [&f] {
+        benchmark::DoNotOptimize(opaque_start_server_login_binary(
+          toSlice(f.serverSetup), toSlice(f.registrationRecord), true, toSlice(f.startLoginRequest),
+          kUserIdentifier, {}, {}, kSuite));
+      });
+    });
+    registerBenchmark("opaque_start_server_login/into", [](benchmark::State& state) {
+      const auto& f = fixture();
+      measure(state, [&f] {
+        std::array<uint8_t, kOutputBufferSize> out;
+        benchmark::DoNotOptimize(opaque_start_server_login_with_setup_into(*f.serverSetupHandle, {
+          .registration_record = f.registrationRecord,
+          .has_registration_record = true,
+          .start_login_request = f.startLoginRequest,
+          .user_identifier = kUserIdentifier,
+        }, {out.data(), out.size()}));
+      });
+    });
+
+    registerBenchmark("opaque_start_server_login_batch/64", [](benchmark::State& state) {
+      const auto& f = fixture();
+      measure(state, [&f] {
+        ::rust::Vec<OpaqueStartServerLoginParams> requests;
+        for (int i = 0; i < 64; i++) {
+          requests.push_back(startServerLoginParams(f));
+        }
+        return requests;
+      }, [&f](::rust::Vec<OpaqueStartServerLoginParams>& requests) {
+        benchmark::DoNotOptimize(opaque_start_server_login_batch(*f.serverSetupHandle, std::move(requests)));
+      });
+    });
+
+    registerBenchmark("opaque_finish_server_login/string", [](benchmark::State& state) {
+      const auto& f = fixture();
+      measure(state, [&f] {
+        return OpaqueFinishServerLoginParams{
+          .server_login_state = f.serverLoginState,
+          .finish_login_request = f.finishLoginRequest,
+        };
+      }, [](OpaqueFinishServerLoginParams& params) {
+        benchmark::DoNotOptimize(opaque_finish_server_login(std::move(params)));
+      });
+    });
+    registerBenchmark("opaque_finish_server_login/binary", [](benchmark::State& state) {
+      const auto& f = binaryFixture();
+      measure(state, [&f] {
+        benchmark::DoNotOptimize(opaque_finish_server_login_binary(
+          toSlice(f.serverLoginState), toSlice(f.finishLoginRequest), kSuite));
+      });
+    });
+    registerBenchmark("opaque_finish_server_login/into", [](benchmark::State& state) {
+      const auto& f = fixture();
+      measure(state, [&f] {
+        std::array<uint8_t, kOutputBufferSize> out;
+        benchmark::DoNotOptimize(opaque_finish_server_login_into({
+          .server_login_state = f.serverLoginState,
+          .finish_login_request = f.finishLoginRequest,
+        }, {out.data(), out.size()}));
+      });
+    });
+  }
+
+  // Failed logins through the throwing `*_into` functions and their
+  // `opaque_try_*` variants of the result mode, which report the error
+  // without unwinding. finish_server_login fails the key confirmation of a
+  // forged finish request, start_server_login a malformed request before
+  // any curve operation, where the cost of the exception dominates.
+  void registerFailedLoginBenchmarks() {
+    registerBenchmark("failed_login/finish_server_login/throw", [](benchmark::State& state) {
+      const auto& f = fixture();
+      measure(state, [&f] {
+        std::array<uint8_t, kOutputBufferSize> out;
+        try {
+          benchmark::DoNotOptimize(opaque_finish_server_login_into({
+            .server_login_state = f.serverLoginState,
+            .finish_login_request = f.forgedFinishLoginRequest,
+          }, {out.data(), out.size()}));
+        } catch (const std::exception& e) {
+          benchmark::DoNotOptimize(e.what());
+        }
+      });
+    });
+    registerBenchmark("failed_login/finish_server_login/status", [](benchmark::State& state) {
+      const auto& f = fixture();
+      measure(state, [&f] {
+        std::array<uint8_t, kOutputBufferSize> out;
+        size_t sessionKey = 0;
+        benchmark::DoNotOptimize(opaque_try_finish_server_login_into({
+          .server_login_state = f.serverLoginState,
+          .finish_login_request = f.forgedFinishLoginRequest,
+        }, {out.data(), out.size()}, sessionKey));
+      });
+    });
+
+    registerBenchmark("failed_login/start_server_login/throw", [](benchmark::State& state) {
+      const auto& f = fixture();
+      measure(state, [&f] {
+        std::array<uint8_t, kOutputBufferSize> out;
+        try {
+          benchmark::DoNotOptimize(opaque_start_server_login_with_setup_into(*f.serverSetupHandle, {
+            .registration_record = f.registrationRecord,
+            .has_registration_record = true,
+            .start_login_request = "AAAA",
+            .user_identifier = kUserIdentifier,
+          }, {out.data(), out.size()}));
+        } catch (const std::exception& e) {
+          benchmark::DoNotOptimize(e.what());
+        }
+      });
+    });
+    registerBenchmark("failed_login/start_server_login/status", [](benchmark::State& state) {
+      const auto& f = fixture();
+      measure(state, [&f] {
+        std::array<uint8_t, kOutputBufferSize> out;
+        OpaqueStartServerLoginOutput lengths;
+        benchmark::DoNotOptimize(opaque_try_start_server_login_with_setup_into(*f.serverSetupHandle, {
+          .registration_record = f.registrationRecord,
+          .has_registration_record = true,
+          .start_login_request = "AAAA",
+          .user_identifier = kUserIdentifier,
+        }, {out.data(), out.size()}, lengths));
+      });
+    });
+  }
+
+  // A whole client login with a simulated network round trip between
+  // startClientLogin and finishClientLogin, during which the server runs
+  // startServerLogin. The pipelined variant prepares the key stretching on
+  // another thread in the meantime, like startLoginPipelined of the JSI
+  // module. The registration uses the default key stretching.
+  void registerLoginRoundTripBenchmarks() {
+    for (int rttMs : {0, 50, 150}) {
+      for (bool pipelined : {false, true}) {
+        auto name = std::string("login_rtt/") + std::to_string(rttMs) + "ms/" +
+          (pipelined ? "pipelined" : "sequential");
+        registerBenchmark(name, [rttMs, pipelined](benchmark::State& state) {
+          const auto& f = fixture();
+          measure(state, [&state, &f, rttMs, pipelined] {
+            std::thread prepare;
+            if (pipelined) {
+              prepare = std::thread([] { opaque_prepare_client_login_finish({}); });
+            }
+            auto start = opaque_start_client_login({.password = kPassword});
+            std::array<uint8_t, kOutputBufferSize> out;
+            auto serverStart = opaque_start_server_login_with_setup_into(*f.serverSetupHandle, {
+              .registration_record = f.registrationRecord,
+              .has_registration_record = true,
+              .start_login_request = start.start_login_request,
+              .user_identifier = kUserIdentifier,
+            }, {out.data(), out.size()});
+            std::this_thread::sleep_for(std::chrono::milliseconds(rttMs));
+            auto loginResponse = std::string(reinterpret_cast<const char*>(out.data()) +
+              serverStart.server_login_state, serverStart.login_response);
+            auto result = opaque_finish_client_login({
+              .client_login_state = start.client_login_state,
+              .login_response = loginResponse,
+              .password = kPassword,
+            });
+            if (!result) {
+              state.SkipWithError("login failed");
+            }
+            if (prepare.joinable()) {
+              prepare.join();
+            }
+          });
+        });
+      }
+    }
+  }
+
+  // The protocol functions split into their phases: key stretching, the
+  // curve operations of a whole registration or login without key
+  // stretching, and the base64 round trip of a message of the given size.
+  // The remaining difference between the string and binary variants above
+  // is the marshalling of the strings across the bridge.
+  void registerPhaseBenchmarks() {
+    registerBenchmark("phase/argon2", [](benchmark::State& state) {
+      measure(state, [] { opaque_bench_argon2(); });
+    });
+    registerBenchmark("phase/curve/registration", [](benchmark::State& state) {
+      measure(state, [] { opaque_bench_curve_registration(); });
+    });
+    registerBenchmark("phase/curve/login", [](benchmark::State& state) {
+      measure(state, [] { opaque_bench_curve_login(); });
+    });
+    // registration request, start login request, registration record and
+    // login response sizes of the default cipher suite
+    for (size_t len : {32, 96, 192, 320}) {
+      registerBenchmark("phase/base64/" + std::to_string(len), [len](benchmark::State& state) {
+        measure(state, [len] { opaque_bench_base64(len); });
+      });
+    }
+  }
+}  // namespace NativeOpaque
+
+int main(int argc, char** argv) {
+  NativeOpaque::registerClientBenchmarks();
+  NativeOpaque::registerServerBenchmarks();
+  NativeOpaque::registerFailedLoginBenchmarks();
+  NativeOpaque::registerLoginRoundTripBenchmarks();
+  NativeOpaque::registerPhaseBenchmarks();
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
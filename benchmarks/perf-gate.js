@@ -0,0 +1,198 @@
+'use strict';
+
+// Compares two runs of opaque-benchmark or marshalling-benchmark and fails
+// if a benchmark got slower or allocates more than the baseline. Both files
+// are written with --benchmark_out=<file> --benchmark_out_format=json, with
+// --benchmark_repetitions the medians are compared.
+//
+//   node benchmarks/perf-gate.js baseline.json current.json
+//     [--latency-threshold=0.15] [--alloc-tolerance=0] [--filter=<regex>]
+//
+// The latency is the p50_us counter where a benchmark reports it, and the
+// real time per iteration otherwise. A benchmark regresses if its latency
+// grows by more than the threshold (a fraction) or its allocations per call
+// by more than the tolerance. Baselines only compare with runs on the same
+// machine, so none are checked in; CI runs the base and head commit back to
+// back.
+
+const fs = require('fs');
+
+const TIME_UNITS_NS = { ns: 1, us: 1e3, ms: 1e6, s: 1e9 };
+
+function parseArgs(argv) {
+  const options = {
+    latencyThreshold: 0.15,
+    allocTolerance: 0,
+    filter: null,
+    files: [],
+  };
+  for (const arg of argv) {
+    const [key, value] = arg.split('=');
+    if (key === '--latency-threshold') {
+      options.latencyThreshold = Number(value);
+    } else if (key === '--alloc-tolerance') {
+      options.allocTolerance = Number(value);
+    } else if (key === '--filter') {
+      options.filter = new RegExp(value);
+    } else {
+      options.files.push(arg);
+    }
+  }
+  if (
+    options.files.length !== 2 ||
+    !(options.latencyThreshold >= 0) ||
+    !(options.allocTolerance >= 0)
+  ) {
+    console.error(
+      'usage: node benchmarks/perf-gate.js baseline.json current.json ' +
+        '[--latency-threshold=0.15] [--alloc-tolerance=0] [--filter=<regex>]'
+    );
+    process.exit(2);
+  }
+  return options;
+}
+
+function median(values) {
+  const sorted = [...values].sort((a, b) => a - b);
+  const mid = sorted.length >> 1;
+  return sorted.length % 2
+    ? sorted[mid]
+    : (sorted[mid - 1] + sorted[mid]) / 2;
+}
+
+// Microseconds per call.
+function latencyOf(entry) {
+  if (entry.p50_us !== undefined) {
+    return entry.p50_us;
+  }
+  return (entry.real_time * TIME_UNITS_NS[entry.time_unit || 'ns']) / 1e3;
+}
+
+// Latency and allocations per benchmark. Prefers the median aggregate of
+// repeated runs, and otherwise takes the median of the iteration entries.
+function load(file) {
+  const { benchmarks } = JSON.parse(fs.readFileSync(file, 'utf8'));
+  const runs = new Map();
+  for (const entry of benchmarks) {
+    if (entry.error_occurred) {
+      continue;
+    }
+    const name = entry.run_name || entry.name;
+    if (!runs.has(name)) {
+      runs.set(name, { medians: [], iterations: [] });
+    }
+    const run = runs.get(name);
+    if (entry.run_type === 'aggregate') {
+      if (entry.aggregate_name === 'median') {
+        run.medians.push(entry);
+      }
+    } else {
+      run.iterations.push(entry);
+    }
+  }
+
+  const results = new Map();
+  for (const [name, run] of runs) {
+    const entries = run.medians.length ? run.medians : run.iterations;
+    if (!entries.length) {
+      continue;
+    }
+    const allocs = entries
+      .map((entry) => entry.allocs)
+      .filter((value) => value !== undefined);
+    results.set(name, {
+      latency: median(entries.map(latencyOf)),
+      allocs: allocs.length ? median(allocs) : undefined,
+    });
+  }
+  return results;
+}
+
+function format(value) {
+  return value === undefined ? '-' : value.toFixed(value < 10 ? 3 : 1);
+}
+
+function main() {
+  const options = parseArgs(process.argv.slice(2));
+  const baseline = load(options.files[0]);
+  const current = load(options.files[1]);
+
+  const regressions = [];
+  const rows = [];
+  for (const [name, now] of current) {
+    if (options.filter && !options.filter.test(name)) {
+      continue;
+    }
+    const before = baseline.get(name);
+    if (!before) {
+      const latency = format(now.latency);
+      rows.push([name, '-', latency, '', '-', format(now.allocs), 'new']);
+      continue;
+    }
+    const change = now.latency / before.latency - 1;
+    const problems = [];
+    if (change > options.latencyThreshold) {
+      problems.push(`latency +${(change * 100).toFixed(1)}%`);
+    }
+    if (
+      before.allocs !== undefined &&
+      now.allocs !== undefined &&
+      now.allocs > before.allocs + options.allocTolerance
+    ) {
+      problems.push(
+        `allocs ${format(before.allocs)} -> ${format(now.allocs)}`
+      );
+    }
+    if (problems.length) {
+      regressions.push(`${name}: ${problems.join(', ')}`);
+    }
+    rows.push([
+      name,
+      format(before.latency),
+      format(now.latency),
+      `${change >= 0 ? '+' : ''}${(change * 100).toFixed(1)}%`,
+      format(before.allocs),
+      format(now.allocs),
+      problems.length ? 'REGRESSED' : '',
+    ]);
+  }
+  for (const [name, before] of baseline) {
+    if (current.has(name) || (options.filter && !options.filter.test(name))) {
+      continue;
+    }
+    rows.push([name, format(before.latency), '-', '', '', '', 'missing']);
+  }
+
+  const header = [
+    'benchmark',
+    'base us',
+    'head us',
+    'change',
+    'base allocs',
+    'head allocs',
+    '',
+  ];
+  const table = [header, ...rows];
+  const widths = header.map((_, i) =>
+    Math.max(...table.map((row) => row[i].length))
+  );
+  for (const row of table) {
+    const cells = row.map((cell, i) => cell.padEnd(widths[i]));
+    console.log(cells.join('  ').trimEnd());
+  }
+
+  if (regressions.length) {
+    const latency = `+${options.latencyThreshold * 100}% latency`;
+    const allocs = `+${options.allocTolerance} allocs per call`;
+    console.error(
+      `\n${regressions.length} regression(s) beyond ${latency} or ${allocs}:`
+    );
+    for (const regression of regressions) {
+      console.error(`  ${regression}`);
+    }
+    process.exit(1);
+  }
+  console.log('\nno regressions');
+}
+
+main();
@@ -0,0 +1,376 @@
+#ifndef CPP_OPAQUE_BINDING_H_
+#define CPP_OPAQUE_BINDING_H_
+
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+#include "./opaque-rust.h"
+
+// The parts of the JS bindings which don't depend on the JS engine, shared
+// by the JSI module (opaque-marshalling.h) and the Node-API addon
+// (node/opaque-node.cpp): the properties of the params and results, the
+// messages of invalid input and the server setup keyring.
+
+// Every property name read or written by the bindings. Used to create the
+// property keys of the same name, see PropNames.
+#define OPAQUE_PROP_NAMES(X) \
+  X(activeKeyId) \
+  X(buffer) \
+  X(byteLength) \
+  X(byteOffset) \
+  X(chunkSize) \
+  X(client) \
+  X(clientLoginState) \
+  X(clientRegistrationState) \
+  X(context) \
+  X(cores) \
+  X(count) \
+  X(error) \
+  X(Error) \
+  X(exportKey) \
+  X(failed) \
+  X(finishLoginRequest) \
+  X(identifiers) \
+  X(iterations) \
+  X(keyId) \
+  X(keyIds) \
+  X(keyring) \
+  X(keyStretching) \
+  X(loginResponse) \
+  X(maxMemoryBytes) \
+  X(maxUs) \
+  X(memoryCost) \
+  X(message) \
+  X(ok) \
+  X(p50Us) \
+  X(p90Us) \
+  X(p99Us) \
+  X(parallelism) \
+  X(password) \
+  X(performanceCores) \
+  X(Promise) \
+  X(processed) \
+  X(records) \
+  X(registrationRecord) \
+  X(registrationRequest) \
+  X(registrationResponse) \
+  X(responses) \
+  X(server) \
+  X(serverLoginState) \
+  X(serverSetup) \
+  X(serverStaticPublicKey) \
+  X(sessionHandle) \
+  X(sessionKey) \
+  X(sessionStore) \
+  X(startLoginRequest) \
+  X(suite) \
+  X(targetDurationMs) \
+  X(total) \
+  X(totalUs) \
+  X(ttlMs) \
+  X(Uint8Array) \
+  X(userIdentifier) \
+  X(value)
+
+namespace NativeOpaque {
+  // The messages of invalid input, the same in both bindings.
+  inline std::string missingPropertyMessage(std::string_view name) {
+    return "missing required property \"" + std::string(name) + "\" in input params";
+  }
+
+  inline std::string invalidTypeMessage(std::string_view name, std::string_view expected, std::string_view kind) {
+    return "property \"" + std::string(name) + "\" has invalid type, expected " + std::string(expected)
+      + " but got " + std::string(kind);
+  }
+
+  inline std::string invalidIdentifierMessage(std::string_view name) {
+    return "identifier \"" + std::string(name) + "\" must be a string";
+  }
+
+  inline std::string invalidUint32Message(std::string_view name) {
+    return "property \"" + std::string(name) + "\" must be an unsigned 32-bit integer";
+  }
+
+  inline std::string unknownServerSetupKeyMessage(std::string_view keyId) {
+    return "unknown server setup key \"" + std::string(keyId) + "\"";
+  }
+
+  inline std::string duplicateServerSetupKeyMessage(std::string_view keyId) {
+    return "server setup key \"" + std::string(keyId) + "\" already exists";
+  }
+
+  constexpr const char* kInvalidIdentifiersMessage = "\"identifiers\" must be an object";
+  constexpr const char* kInvalidKeyStretchingMessage = "\"keyStretching\" must be an object";
+  constexpr const char* kInvalidSuiteMessage = "\"suite\" must be \"ristretto255\" or \"p256\"";
+  constexpr const char* kInvalidServerSetupMessage = "serverSetup must be a string or a server setup handle or keyring";
+  constexpr const char* kInvalidRequestsMessage = "requests must be an array";
+  constexpr const char* kEmptyKeyringMessage = "the server setup keyring has no keys";
+  constexpr const char* kRemoveActiveKeyMessage = "the active server setup key can't be removed";
+  constexpr const char* kInvalidKeyringMessage = "keyring must be a server setup keyring";
+  constexpr const char* kInvalidSessionStoreMessage = "sessionStore must be a login session store";
+  constexpr const char* kMaxMemoryBytesOutOfRangeMessage = "property \"maxMemoryBytes\" is out of range";
+
+  // A failed call of the cxx bridge throws a rust::Error with the message
+  // "<code>:<message>", the number of the OpaqueErrorCode in front of the
+  // message, see `impl Display for Error` in rust/src/lib.rs.
+  struct RustError {
+    OpaqueErrorCode code;
+    std::string message;
+  };
+
+  inline RustError splitRustError(const ::rust::Error& error) {
+    std::string_view what(error.what());
+    if (what.size() >= 2 && what[0] >= '0' && what[0] <= '9' && what[1] == ':') {
+      return {static_cast<OpaqueErrorCode>(what[0] - '0'), std::string(what.substr(2))};
+    }
+    return {OpaqueErrorCode::Input, std::string(what)};
+  }
+
+  // The message of an exception for JS, without the code of a Rust error.
+  inline std::string errorMessage(const std::exception& error) {
+    if (auto rustError = dynamic_cast<const ::rust::Error*>(&error)) {
+      return splitRustError(*rustError).message;
+    }
+    return error.what();
+  }
+
+  // The name of an error code in JS, see ErrorCode in src/index.ts.
+  inline const char* errorCodeName(OpaqueErrorCode code) {
+    switch (code) {
+      case OpaqueErrorCode::None: return "none";
+      case OpaqueErrorCode::Input: return "input";
+      case OpaqueErrorCode::Protocol: return "protocol";
+      case OpaqueErrorCode::Base64: return "base64";
+      case OpaqueErrorCode::InvalidLogin: return "invalidLogin";
+    }
+    return "input";
+  }
+
+  // The defaults of createServerLoginSessionStore.
+  constexpr uint32_t kDefaultLoginSessionTtlMs = 60 * 1000;
+  constexpr double kDefaultLoginSessionMaxMemoryBytes = 64 * 1024 * 1024;
+
+  // The suite of a "suite" string, nullopt for an unknown one.
+  inline std::optional<OpaqueCipherSuite> parseCipherSuite(std::string_view suite) {
+    if (suite == "ristretto255") {
+      return OpaqueCipherSuite::Ristretto255;
+    }
+    if (suite == "p256") {
+      return OpaqueCipherSuite::P256;
+    }
+    return std::nullopt;
+  }
+
+  // The params structs are read through `in`, which wraps one params object
+  // of the binding:
+  //
+  //   in.names                the property keys, see OPAQUE_PROP_NAMES
+  //   in.string(name)         a required string
+  //   in.optional(name)       a string, empty for any other value
+  //   in.identifier(name)     the optional identifier of "identifiers"
+  //   in.keyStretching()      the optional "keyStretching" params
+  //   in.suite()              the optional "suite"
+  //
+  // and thrown exceptions use the messages above.
+  template <typename In>
+  OpaqueStartClientRegistrationParams readStartClientRegistrationParams(In& in) {
+    return {
+        .password = in.string(in.names.password),
+        .suite = in.suite(),
+    };
+  }
+
+  template <typename In>
+  OpaqueFinishClientRegistrationParams readFinishClientRegistrationParams(In& in) {
+    return {
+        .password = in.string(in.names.password),
+        .registration_response = in.string(in.names.registrationResponse),
+        .client_registration_state = in.string(in.names.clientRegistrationState),
+        .client_identifier = in.identifier(in.names.client),
+        .server_identifier = in.identifier(in.names.server),
+        .key_stretching = in.keyStretching(),
+        .suite = in.suite(),
+    };
+  }
+
+  template <typename In>
+  OpaqueStartClientLoginParams readStartClientLoginParams(In& in) {
+    return {
+        .password = in.string(in.names.password),
+        .suite = in.suite(),
+    };
+  }
+
+  template <typename In>
+  OpaqueFinishClientLoginParams readFinishClientLoginParams(In& in) {
+    return {
+        .client_login_state = in.string(in.names.clientLoginState),
+        .login_response = in.string(in.names.loginResponse),
+        .password = in.string(in.names.password),
+        .client_identifier = in.identifier(in.names.client),
+        .server_identifier = in.identifier(in.names.server),
+        .key_stretching = in.keyStretching(),
+        .suite = in.suite(),
+    };
+  }
+
+  template <typename In>
+  OpaqueCreateServerRegistrationResponseParams readCreateServerRegistrationResponseParams(In& in) {
+    return {
+        .user_identifier = in.string(in.names.userIdentifier),
+        .registration_request = in.string(in.names.registrationRequest),
+        .suite = in.suite(),
+    };
+  }
+
+  template <typename In>
+  OpaqueStartServerLoginParams readStartServerLoginParams(In& in) {
+    return {
+        .registration_record = in.optional(in.names.registrationRecord),
+        .start_login_request = in.string(in.names.startLoginRequest),
+        .user_identifier = in.string(in.names.userIdentifier),
+        .client_identifier = in.identifier(in.names.client),
+        .server_identifier = in.identifier(in.names.server),
+        .suite = in.suite(),
+    };
+  }
+
+  template <typename In>
+  OpaqueFinishServerLoginParams readFinishServerLoginParams(In& in) {
+    return {
+        .server_login_state = in.string(in.names.serverLoginState),
+        .finish_login_request = in.string(in.names.finishLoginRequest),
+        .suite = in.suite(),
+    };
+  }
+
+  // The results are written through `out`, which wraps one result object
+  // of the binding and has `out.names` and `out.set(name, value)` for the
+  // Rust strings, ASCII C strings and the key stretching params.
+  template <typename Out>
+  void writeStartClientRegistrationResult(Out& out, const OpaqueStartClientRegistrationResult& result) {
+    out.set(out.names.clientRegistrationState, result.client_registration_state);
+    out.set(out.names.registrationRequest, result.registration_request);
+  }
+
+  template <typename Out>
+  void writeFinishClientRegistrationResult(Out& out, const OpaqueFinishClientRegistrationResult& result) {
+    out.set(out.names.registrationRecord, result.registration_record);
+    out.set(out.names.exportKey, result.export_key);
+    out.set(out.names.serverStaticPublicKey, result.server_static_public_key);
+    out.set(out.names.keyStretching, result.key_stretching);
+  }
+
+  template <typename Out>
+  void writeStartClientLoginResult(Out& out, const OpaqueStartClientLoginResult& result) {
+    out.set(out.names.clientLoginState, result.client_login_state);
+    out.set(out.names.startLoginRequest, result.start_login_request);
+  }
+
+  template <typename Out>
+  void writeFinishClientLoginResult(Out& out, const OpaqueFinishClientLoginResult& result) {
+    out.set(out.names.finishLoginRequest, result.finish_login_request);
+    out.set(out.names.sessionKey, result.session_key);
+    out.set(out.names.exportKey, result.export_key);
+    out.set(out.names.serverStaticPublicKey, result.server_static_public_key);
+  }
+
+  template <typename Out>
+  void writeCreateServerRegistrationResponseResult(Out& out,
+    const OpaqueCreateServerRegistrationResponseResult& result) {
+    out.set(out.names.registrationResponse, result.registration_response);
+  }
+
+  template <typename Out>
+  void writeStartServerLoginResult(Out& out, const OpaqueStartServerLoginResult& result) {
+    out.set(out.names.serverLoginState, result.server_login_state);
+    out.set(out.names.loginResponse, result.login_response);
+  }
+
+  // An entry of the startServerLoginBatch result, the login or the code
+  // and message of its error like in the result mode.
+  template <typename Out>
+  void writeStartServerLoginBatchResult(Out& out, const OpaqueStartServerLoginBatchResult& result) {
+    if (result.error_code == OpaqueErrorCode::None) {
+      out.set(out.names.serverLoginState, result.server_login_state);
+      out.set(out.names.loginResponse, result.login_response);
+    } else {
+      out.set(out.names.error, errorCodeName(result.error_code));
+      out.set(out.names.message, result.error_message);
+    }
+  }
+
+  template <typename Out>
+  void writeFinishServerLoginResult(Out& out, const OpaqueFinishServerLoginResult& result) {
+    out.set(out.names.sessionKey, result.session_key);
+  }
+
+  template <typename Out>
+  void writeStartServerLoginSessionResult(Out& out, const OpaqueStartServerLoginSessionResult& result) {
+    out.set(out.names.sessionHandle, result.session_handle);
+    out.set(out.names.loginResponse, result.login_response);
+  }
+
+  // Server setups by key ID, so a server can rotate its server setup without
+  // a second code path in JS. The server functions take the keyring in place
+  // of the server setup and use the key of the `keyId` param, or the active
+  // key without one. The setups are decoded when they are added, selecting
+  // one is a hash lookup.
+  //
+  // Only used on the JS thread of its runtime, so setting the active key
+  // takes effect atomically between two calls. Logins started with the
+  // previous key finish as usual, finishing a login doesn't use the server
+  // setup. `Setup` is the decoded server setup of the binding.
+  template <typename Setup>
+  class ServerSetupKeyring {
+   public:
+    // Returns false if the key ID is taken. The first key becomes the active
+    // one.
+    bool add(std::string keyId, std::shared_ptr<Setup> setup) {
+      auto [entry, inserted] = keys_.try_emplace(std::move(keyId), std::move(setup));
+      if (inserted && !active_) {
+        activeKeyId_ = entry->first;
+        active_ = entry->second;
+      }
+      return inserted;
+    }
+
+    // Returns nullptr for an unknown key ID.
+    std::shared_ptr<Setup> get(const std::string& keyId) const {
+      auto entry = keys_.find(keyId);
+      return entry == keys_.end() ? nullptr : entry->second;
+    }
+
+    const std::shared_ptr<Setup>& active() const { return active_; }
+    const std::string& activeKeyId() const { return activeKeyId_; }
+
+    // Returns false for an unknown key ID.
+    bool setActive(const std::string& keyId) {
+      auto entry = keys_.find(keyId);
+      if (entry == keys_.end()) {
+        return false;
+      }
+      activeKeyId_ = entry->first;
+      active_ = entry->second;
+      return true;
+    }
+
+    // Returns whether the key existed.
+    bool remove(const std::string& keyId) { return keys_.erase(keyId) > 0; }
+
+    const std::unordered_map<std::string, std::shared_ptr<Setup>>& keys() const { return keys_; }
+
+   private:
+    std::unordered_map<std::string, std::shared_ptr<Setup>> keys_;
+    std::string activeKeyId_;
+    std::shared_ptr<Setup> active_;
+  };
+}  // namespace NativeOpaque
+
+#endif  // CPP_OPAQUE_BINDING_H_
@@ -0,0 +1,282 @@
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <utility>
+#include "jsi/jsi.h"
+#include "./opaque-marshalling.h"
+
+namespace NativeOpaque {
+#define OPAQUE_INIT_PROP_NAME(name) name(jsi::PropNameID::forAscii(rt, #name)),
+  PropNames::PropNames(jsi::Runtime& rt) : OPAQUE_PROP_NAMES(OPAQUE_INIT_PROP_NAME) runtime(rt) {}
+#undef OPAQUE_INIT_PROP_NAME
+
+  std::string kindToString(const jsi::Value& v, jsi::Runtime& rt) {
+    if (v.isUndefined()) {
+      return "undefined";
+    } else if (v.isNull()) {
+      return "null";
+    } else if (v.isBool()) {
+      return v.getBool() ? "true" : "false";
+    } else if (v.isNumber()) {
+      return "a number";
+    } else if (v.isString()) {
+      return "a string";
+    } else if (v.isSymbol()) {
+      return "a symbol";
+    } else if (v.isBigInt()) {
+      return "a bigint";
+    } else {
+      assert(v.isObject() && "Expecting object.");
+      return v.getObject(rt).isFunction(rt) ? "a function"
+        : "an object";
+    }
+  }
+
+  // Only called once the lookup returned undefined, to tell a missing
+  // property from one that is set to undefined.
+  void checkHasProperty(jsi::Runtime& rt, jsi::Object& obj, const jsi::PropNameID& name) {
+    if (!obj.hasProperty(rt, name)) {
+      throw jsi::JSError(rt, missingPropertyMessage(name.utf8(rt)));
+    }
+  }
+
+  jsi::String getProp(jsi::Runtime& rt, jsi::Object& obj, const jsi::PropNameID& name) {
+    return asStringProp(rt, obj, name, obj.getProperty(rt, name));
+  }
+
+  jsi::String asStringProp(jsi::Runtime& rt, jsi::Object& obj, const jsi::PropNameID& name, const jsi::Value& prop) {
+    if (!prop.isString()) {
+      if (prop.isUndefined()) {
+        checkHasProperty(rt, obj, name);
+      }
+      throw jsi::JSError(rt, invalidTypeMessage(name.utf8(rt), "string", kindToString(prop, rt)));
+    }
+    return prop.getString(rt);
+  }
+
+  ::rust::Vec<::rust::String> getOptional(jsi::Runtime& rt, jsi::Object& obj, const jsi::PropNameID& name) {
+    auto result = ::rust::Vec<::rust::String>();
+    auto prop = obj.getProperty(rt, name);
+    if (prop.isString()) {
+      result.push_back(prop.getString(rt).utf8(rt));
+    }
+    return result;
+  }
+
+  ::rust::Vec<::rust::String> getIdentifier(jsi::Runtime& rt, const PropNames& names, jsi::Object& obj,
+    const jsi::PropNameID& name) {
+    auto result = ::rust::Vec<::rust::String>();
+    auto identifier = readIdentifier(rt, names, obj, name);
+    if (identifier) {
+      result.push_back(*identifier);
+    }
+    return result;
+  }
+
+  std::optional<std::string> readIdentifier(jsi::Runtime& rt, const PropNames& names, jsi::Object& obj,
+    const jsi::PropNameID& name) {
+    auto identsProp = obj.getProperty(rt, names.identifiers);
+    if (identsProp.isUndefined() || identsProp.isNull()) {
+      return std::nullopt;
+    }
+    if (!identsProp.isObject()) {
+      throw jsi::JSError(rt, kInvalidIdentifiersMessage);
+    }
+    auto prop = identsProp.getObject(rt).getProperty(rt, name);
+    if (prop.isUndefined()) {
+      return std::nullopt;
+    }
+    if (!prop.isString()) {
+      throw jsi::JSError(rt, invalidIdentifierMessage(name.utf8(rt)));
+    }
+    return prop.getString(rt).utf8(rt);
+  }
+
+  uint32_t getUint32Prop(jsi::Runtime& rt, jsi::Object& obj, const jsi::PropNameID& name) {
+    auto prop = obj.getProperty(rt, name);
+    if (!prop.isNumber()) {
+      throw jsi::JSError(rt, invalidTypeMessage(name.utf8(rt), "number", kindToString(prop, rt)));
+    }
+    auto value = prop.getNumber();
+    if (!(value >= 0 && value <= UINT32_MAX) || std::trunc(value) != value) {
+      throw jsi::JSError(rt, invalidUint32Message(name.utf8(rt)));
+    }
+    return static_cast<uint32_t>(value);
+  }
+
+  ::rust::Vec<OpaqueKeyStretchingParams> getKeyStretching(jsi::Runtime& rt, const PropNames& names,
+    jsi::Object& obj) {
+    auto result = ::rust::Vec<OpaqueKeyStretchingParams>();
+    auto params = readKeyStretching(rt, names, obj);
+    if (params) {
+      result.push_back(*params);
+    }
+    return result;
+  }
+
+  std::optional<OpaqueKeyStretchingParams> readKeyStretching(jsi::Runtime& rt, const PropNames& names,
+    jsi::Object& obj) {
+    auto prop = obj.getProperty(rt, names.keyStretching);
+    if (prop.isUndefined() || prop.isNull()) {
+      return std::nullopt;
+    }
+    if (!prop.isObject()) {
+      throw jsi::JSError(rt, kInvalidKeyStretchingMessage);
+    }
+    auto params = prop.getObject(rt);
+    return OpaqueKeyStretchingParams{
+      .memory_cost = getUint32Prop(rt, params, names.memoryCost),
+      .iterations = getUint32Prop(rt, params, names.iterations),
+      .parallelism = getUint32Prop(rt, params, names.parallelism),
+    };
+  }
+
+  jsi::Object makeKeyStretching(jsi::Runtime& rt, const PropNames& names, const OpaqueKeyStretchingParams& params) {
+    auto result = jsi::Object(rt);
+    result.setProperty(rt, names.memoryCost, static_cast<double>(params.memory_cost));
+    result.setProperty(rt, names.iterations, static_cast<double>(params.iterations));
+    result.setProperty(rt, names.parallelism, static_cast<double>(params.parallelism));
+    return result;
+  }
+
+  OpaqueCipherSuite getCipherSuite(jsi::Runtime& rt, const PropNames& names, jsi::Object& obj) {
+    auto prop = obj.getProperty(rt, names.suite);
+    if (prop.isUndefined() || prop.isNull()) {
+      return OpaqueCipherSuite::Default;
+    }
+    auto suite = prop.isString() ? parseCipherSuite(prop.getString(rt).utf8(rt)) : std::nullopt;
+    if (!suite) {
+      throw jsi::JSError(rt, kInvalidSuiteMessage);
+    }
+    return *suite;
+  }
+
+  OpaqueCipherSuite getCipherSuite(jsi::Runtime& rt, const PropNames& names, const jsi::Value& params) {
+    if (params.isUndefined() || params.isNull()) {
+      return OpaqueCipherSuite::Default;
+    }
+    auto obj = params.asObject(rt);
+    return getCipherSuite(rt, names, obj);
+  }
+
+  jsi::String makeString(jsi::Runtime& rt, const ::rust::String& str) {
+    return jsi::String::createFromUtf8(rt, reinterpret_cast<const uint8_t*>(str.data()), str.size());
+  }
+
+  ::rust::Str borrowOptional(const std::optional<std::string>& value) {
+    return value ? ::rust::Str(value->data(), value->size()) : ::rust::Str();
+  }
+
+  jsi::String OutputBuffer::next(jsi::Runtime& rt, size_t length) {
+    assert(offset_ + length <= data_.size());
+    auto str = jsi::String::createFromAscii(rt, reinterpret_cast<const char*>(data_.data() + offset_), length);
+    offset_ += length;
+    return str;
+  }
+
+  jsi::String OutputBuffer::message(jsi::Runtime& rt, size_t length) {
+    assert(length <= data_.size());
+    return jsi::String::createFromUtf8(rt, data_.data(), length);
+  }
+
+  std::optional<BinaryInput> asBinary(jsi::Runtime& rt, const PropNames& names, const jsi::Value& value) {
+    if (!value.isObject()) {
+      return std::nullopt;
+    }
+    auto obj = value.getObject(rt);
+    if (obj.isArrayBuffer(rt)) {
+      auto buffer = obj.getArrayBuffer(rt);
+      auto size = buffer.size(rt);
+      return BinaryInput(std::move(buffer), 0, size);
+    }
+    auto bufferProp = obj.getProperty(rt, names.buffer);
+    if (!bufferProp.isObject() || !bufferProp.getObject(rt).isArrayBuffer(rt)) {
+      return std::nullopt;
+    }
+    auto buffer = bufferProp.getObject(rt).getArrayBuffer(rt);
+    auto offset = obj.getProperty(rt, names.byteOffset);
+    auto length = obj.getProperty(rt, names.byteLength);
+    if (!offset.isNumber() || !length.isNumber()) {
+      return std::nullopt;
+    }
+    // written so that NaN fails the check, a plain object can pass any number
+    auto byteOffset = offset.getNumber();
+    auto byteLength = length.getNumber();
+    if (!(byteOffset >= 0 && byteLength >= 0 && byteOffset + byteLength <= buffer.size(rt))) {
+      return std::nullopt;
+    }
+    return BinaryInput(std::move(buffer), static_cast<size_t>(byteOffset), static_cast<size_t>(byteLength));
+  }
+
+  BinaryInput getBinaryProp(jsi::Runtime& rt, const PropNames& names, jsi::Object& obj,
+    const jsi::PropNameID& name) {
+    return asBinaryProp(rt, names, obj, name, obj.getProperty(rt, name));
+  }
+
+  BinaryInput asBinaryProp(jsi::Runtime& rt, const PropNames& names, jsi::Object& obj,
+    const jsi::PropNameID& name, const jsi::Value& prop) {
+    auto input = asBinary(rt, names, prop);
+    if (!input) {
+      if (prop.isUndefined()) {
+        checkHasProperty(rt, obj, name);
+      }
+      throw jsi::JSError(rt, invalidTypeMessage(name.utf8(rt), "Uint8Array or ArrayBuffer", kindToString(prop, rt)));
+    }
+    return std::move(*input);
+  }
+
+  jsi::Value makeUint8Array(jsi::Runtime& rt, const PropNames& names, const ::rust::Vec<uint8_t>& bytes) {
+    auto array = rt.global().getProperty(rt, names.Uint8Array).asObject(rt).asFunction(rt)
+      .callAsConstructor(rt, static_cast<double>(bytes.size())).asObject(rt);
+    auto buffer = array.getProperty(rt, names.buffer).asObject(rt).getArrayBuffer(rt);
+    std::memcpy(buffer.data(rt), bytes.data(), bytes.size());
+    return array;
+  }
+
+  OpaqueFinishClientRegistrationParams readFinishClientRegistrationParams(jsi::Runtime& rt, const PropNames& names,
+    jsi::Object& obj) {
+    ParamsReader in{rt, names, obj};
+    return readFinishClientRegistrationParams(in);
+  }
+
+  jsi::Value makeFinishClientRegistrationResult(jsi::Runtime& rt, const PropNames& names,
+    const OpaqueFinishClientRegistrationResult& finish) {
+    ResultWriter out(rt, names);
+    writeFinishClientRegistrationResult(out, finish);
+    return std::move(out.obj);
+  }
+
+  OpaqueFinishClientLoginParams readFinishClientLoginParams(jsi::Runtime& rt, const PropNames& names,
+    jsi::Object& obj) {
+    ParamsReader in{rt, names, obj};
+    return readFinishClientLoginParams(in);
+  }
+
+  jsi::Value makeFinishClientLoginResult(jsi::Runtime& rt, const PropNames& names,
+    const OpaqueFinishClientLoginResult* result) {
+    if (result == nullptr) {
+      return jsi::Value::undefined();
+    }
+    ResultWriter out(rt, names);
+    writeFinishClientLoginResult(out, *result);
+    return std::move(out.obj);
+  }
+
+  jsi::Value makeOkResult(jsi::Runtime& rt, const PropNames& names, jsi::Value value) {
+    auto result = jsi::Object(rt);
+    result.setProperty(rt, names.ok, true);
+    result.setProperty(rt, names.value, std::move(value));
+    return result;
+  }
+
+  jsi::Value makeFailedResult(jsi::Runtime& rt, const PropNames& names, OpaqueErrorCode code, jsi::Value message) {
+    auto result = jsi::Object(rt);
+    result.setProperty(rt, names.ok, false);
+    result.setProperty(rt, names.error, jsi::String::createFromAscii(rt, errorCodeName(code)));
+    result.setProperty(rt, names.message, std::move(message));
+    return result;
+  }
+}  // namespace NativeOpaque
@@ -0,0 +1,167 @@
+#ifndef CPP_OPAQUE_MARSHALLING_H_
+#define CPP_OPAQUE_MARSHALLING_H_
+
+#include <jsi/jsi.h>
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "./opaque-binding.h"
+#include "./opaque-rust.h"
+
+namespace NativeOpaque {
+  namespace jsi = facebook::jsi;
+
+  // The PropNameIDs of a runtime, created once when the module is installed.
+  // Looking up a property by a `const char*` makes the runtime create (and
+  // for Hermes intern) a new PropNameID on every access, a dozen times for
+  // a single finishLogin call.
+  //
+  // PropNameIDs belong to the runtime that created them and must be released
+  // before it is destroyed.
+  struct PropNames {
+    explicit PropNames(jsi::Runtime& rt);
+
+#define OPAQUE_DECLARE_PROP_NAME(name) const jsi::PropNameID name;
+    OPAQUE_PROP_NAMES(OPAQUE_DECLARE_PROP_NAME)
+#undef OPAQUE_DECLARE_PROP_NAME
+
+    jsi::Runtime& runtime;
+  };
+
+  std::string kindToString(const jsi::Value& v, jsi::Runtime& rt);
+
+  // All property accessors do a single lookup, the existence of a property
+  // is only checked to report a missing one.
+  jsi::String getProp(jsi::Runtime& rt, jsi::Object& obj, const jsi::PropNameID& name);
+  // Like getProp for the already looked up value of the property.
+  jsi::String asStringProp(jsi::Runtime& rt, jsi::Object& obj, const jsi::PropNameID& name, const jsi::Value& prop);
+  ::rust::Vec<::rust::String> getOptional(jsi::Runtime& rt, jsi::Object& obj, const jsi::PropNameID& name);
+  ::rust::Vec<::rust::String> getIdentifier(jsi::Runtime& rt, const PropNames& names, jsi::Object& obj,
+    const jsi::PropNameID& name);
+  std::optional<std::string> readIdentifier(jsi::Runtime& rt, const PropNames& names, jsi::Object& obj,
+    const jsi::PropNameID& name);
+  uint32_t getUint32Prop(jsi::Runtime& rt, jsi::Object& obj, const jsi::PropNameID& name);
+
+  // The optional "keyStretching" params, empty to use the default ones.
+  ::rust::Vec<OpaqueKeyStretchingParams> getKeyStretching(jsi::Runtime& rt, const PropNames& names,
+    jsi::Object& obj);
+  std::optional<OpaqueKeyStretchingParams> readKeyStretching(jsi::Runtime& rt, const PropNames& names,
+    jsi::Object& obj);
+  jsi::Object makeKeyStretching(jsi::Runtime& rt, const PropNames& names, const OpaqueKeyStretchingParams& params);
+
+  // The optional "suite", "ristretto255" or "p256", Default if it's missing.
+  OpaqueCipherSuite getCipherSuite(jsi::Runtime& rt, const PropNames& names, jsi::Object& obj);
+  // Like getCipherSuite for an optional params object.
+  OpaqueCipherSuite getCipherSuite(jsi::Runtime& rt, const PropNames& names, const jsi::Value& params);
+
+  // Creates the JS string straight from the buffer of the Rust string
+  // without copying it into a std::string first.
+  jsi::String makeString(jsi::Runtime& rt, const ::rust::String& str);
+
+  // Borrows the string for one of the `*_into` functions, which take an
+  // empty string and a `has_*` flag for a missing optional value. The
+  // optional must outlive the call.
+  ::rust::Str borrowOptional(const std::optional<std::string>& value);
+
+  // The output buffer of the `*_into` functions, which write the base64
+  // encoded fields of their result back to back and return the lengths.
+  // Lives on the stack of the host function, large enough for the results
+  // of the supported cipher suites.
+  class OutputBuffer {
+   public:
+    ::rust::Slice<uint8_t> slice() {
+      return {data_.data(), data_.size()};
+    }
+
+    // Returns the next field of the result.
+    jsi::String next(jsi::Runtime& rt, size_t length);
+
+    // Returns the error message an `opaque_try_*` function wrote to the
+    // start of the buffer.
+    jsi::String message(jsi::Runtime& rt, size_t length);
+
+   private:
+    std::array<uint8_t, 2048> data_;
+    size_t offset_ = 0;
+  };
+
+  // The bytes of an ArrayBuffer or Uint8Array passed in from JS. Keeps the
+  // underlying buffer alive, but the slice must only be taken right before
+  // calling into Rust since running JS code could detach the buffer.
+  class BinaryInput {
+   public:
+    BinaryInput(jsi::ArrayBuffer buffer, size_t offset, size_t length)
+      : buffer_(std::move(buffer)), offset_(offset), length_(length) {}
+
+    ::rust::Slice<const uint8_t> slice(jsi::Runtime& rt) {
+      return {buffer_.data(rt) + offset_, length_};
+    }
+
+   private:
+    jsi::ArrayBuffer buffer_;
+    size_t offset_;
+    size_t length_;
+  };
+
+  std::optional<BinaryInput> asBinary(jsi::Runtime& rt, const PropNames& names, const jsi::Value& value);
+  BinaryInput getBinaryProp(jsi::Runtime& rt, const PropNames& names, jsi::Object& obj,
+    const jsi::PropNameID& name);
+  BinaryInput asBinaryProp(jsi::Runtime& rt, const PropNames& names, jsi::Object& obj,
+    const jsi::PropNameID& name, const jsi::Value& prop);
+  jsi::Value makeUint8Array(jsi::Runtime& rt, const PropNames& names, const ::rust::Vec<uint8_t>& bytes);
+
+  // Reads the params object `obj` for the param readers in opaque-binding.h.
+  struct ParamsReader {
+    jsi::Runtime& rt;
+    const PropNames& names;
+    jsi::Object& obj;
+
+    std::string string(const jsi::PropNameID& name) { return getProp(rt, obj, name).utf8(rt); }
+    ::rust::Vec<::rust::String> optional(const jsi::PropNameID& name) { return getOptional(rt, obj, name); }
+    ::rust::Vec<::rust::String> identifier(const jsi::PropNameID& name) {
+      return getIdentifier(rt, names, obj, name);
+    }
+    ::rust::Vec<OpaqueKeyStretchingParams> keyStretching() { return getKeyStretching(rt, names, obj); }
+    OpaqueCipherSuite suite() { return getCipherSuite(rt, names, obj); }
+  };
+
+  // Writes a new result object for the result writers in opaque-binding.h.
+  struct ResultWriter {
+    ResultWriter(jsi::Runtime& rt, const PropNames& names) : rt(rt), names(names), obj(rt) {}
+
+    void set(const jsi::PropNameID& name, const ::rust::String& value) {
+      obj.setProperty(rt, name, makeString(rt, value));
+    }
+    void set(const jsi::PropNameID& name, const char* value) {
+      obj.setProperty(rt, name, jsi::String::createFromAscii(rt, value));
+    }
+    void set(const jsi::PropNameID& name, const OpaqueKeyStretchingParams& value) {
+      obj.setProperty(rt, name, makeKeyStretching(rt, names, value));
+    }
+
+    jsi::Runtime& rt;
+    const PropNames& names;
+    jsi::Object obj;
+  };
+
+  // Shared by the sync and the async variants.
+  OpaqueFinishClientRegistrationParams readFinishClientRegistrationParams(jsi::Runtime& rt, const PropNames& names,
+    jsi::Object& obj);
+  jsi::Value makeFinishClientRegistrationResult(jsi::Runtime& rt, const PropNames& names,
+    const OpaqueFinishClientRegistrationResult& finish);
+  OpaqueFinishClientLoginParams readFinishClientLoginParams(jsi::Runtime& rt, const PropNames& names,
+    jsi::Object& obj);
+  jsi::Value makeFinishClientLoginResult(jsi::Runtime& rt, const PropNames& names,
+    const OpaqueFinishClientLoginResult* result);
+
+  // The return values of the result mode, `{ ok: true, value }` or
+  // `{ ok: false, error, message }` with the name of the error code.
+  jsi::Value makeOkResult(jsi::Runtime& rt, const PropNames& names, jsi::Value value);
+  jsi::Value makeFailedResult(jsi::Runtime& rt, const PropNames& names, OpaqueErrorCode code, jsi::Value message);
+}  // namespace NativeOpaque
+
+#endif  // CPP_OPAQUE_MARSHALLING_H_
@@ -104,6 +104,53 @@ private:
 };
 #endif // CXXBRIDGE1_RUST_STRING
 
+#ifndef CXXBRIDGE1_RUST_STR
+#define CXXBRIDGE1_RUST_STR
+class Str final {
+public:
+  Str() noexcept;
+  Str(const String &) noexcept;
+  Str(const std::string &);
+  Str(const char *);
+  Str(const char *, std::size_t);
+
+  Str &operator=(const Str &) &noexcept = default;
+
+  explicit operator std::string() const;
+
+  const char *data() const noexcept;
+  std::size_t size() const noexcept;
+  std::size_t length() const noexcept;
+  bool empty() const noexcept;
+
+  Str(const Str &) noexcept = default;
+  ~Str() noexcept = default;
+
+  using iterator = const char *;
+  using const_iterator = const char *;
+  const_iterator begin() const noexcept;
+  const_iterator end() const noexcept;
+  const_iterator cbegin() const noexcept;
+  const_iterator cend() const noexcept;
+
+  bool operator==(const Str &) const noexcept;
+  bool operator!=(const Str &) const noexcept;
+  bool operator<(const Str &) const noexcept;
+  bool operator<=(const Str &) const noexcept;
+  bool operator>(const Str &) const noexcept;
+  bool operator>=(const Str &) const noexcept;
+
+  void swap(Str &) noexcept;
+
+private:
+  class uninit;
+  Str(uninit) noexcept;
+  friend impl<Str>;
+
+  std::array<std::uintptr_t, 2> repr;
+};
+#endif // CXXBRIDGE1_RUST_STR
+
 #ifndef CXXBRIDGE1_RUST_SLICE
 #define CXXBRIDGE1_RUST_SLICE
 namespace detail {
@@ -395,6 +442,162 @@ void Slice<T>::swap(Slice &rhs) noexcept {
 }
 #endif // CXXBRIDGE1_RUST_SLICE
 
+#ifndef CXXBRIDGE1_RUST_BOX
+#define CXXBRIDGE1_RUST_BOX
+template <typename T>
+class Box final {
+public:
+  using element_type = T;
+  using const_pointer =
+      typename std::add_pointer<typename std::add_const<T>::type>::type;
+  using pointer = typename std::add_pointer<T>::type;
+
+  Box() = delete;
+  Box(Box &&) noexcept;
+  ~Box() noexcept;
+
+  explicit Box(const T &);
+  explicit Box(T &&);
+
+  Box &operator=(Box &&) &noexcept;
+
+  const T *operator->() const noexcept;
+  const T &operator*() const noexcept;
+  T *operator->() noexcept;
+  T &operator*() noexcept;
+
+  template <typename... Fields>
+  static Box in_place(Fields &&...);
+
+  void swap(Box &) noexcept;
+
+  static Box from_raw(T *) noexcept;
+
+  T *into_raw() noexcept;
+
+  using value_type = element_type;
+
+private:
+  class uninit;
+  class allocation;
+  Box(uninit) noexcept;
+  void drop() noexcept;
+
+  friend void swap(Box &lhs, Box &rhs) noexcept { lhs.swap(rhs); }
+
+  T *ptr;
+};
+
+template <typename T>
+class Box<T>::uninit {};
+
+template <typename T>
+class Box<T>::allocation {
+  static T *alloc() noexcept;
+  static void dealloc(T *) noexcept;
+
+public:
+  allocation() noexcept : ptr(alloc()) {}
+  ~allocation() noexcept {
+    if (this->ptr) {
+      dealloc(this->ptr);
+    }
+  }
+  T *ptr;
+};
+
+template <typename T>
+Box<T>::Box(Box &&other) noexcept : ptr(other.ptr) {
+  other.ptr = nullptr;
+}
+
+template <typename T>
+Box<T>::Box(const T &val) {
+  allocation alloc;
+  ::new (alloc.ptr) T(val);
+  this->ptr = alloc.ptr;
+  alloc.ptr = nullptr;
+}
+
+template <typename T>
+Box<T>::Box(T &&val) {
+  allocation alloc;
+  ::new (alloc.ptr) T(std::move(val));
+  this->ptr = alloc.ptr;
+  alloc.ptr = nullptr;
+}
+
+template <typename T>
+Box<T>::~Box() noexcept {
+  if (this->ptr) {
+    this->drop();
+  }
+}
+
+template <typename T>
+Box<T> &Box<T>::operator=(Box &&other) &noexcept {
+  if (this->ptr) {
+    this->drop();
+  }
+  this->ptr = other.ptr;
+  other.ptr = nullptr;
+  return *this;
+}
+
+template <typename T>
+const T *Box<T>::operator->() const noexcept {
+  return this->ptr;
+}
+
+template <typename T>
+const T &Box<T>::operator*() const noexcept {
+  return *this->ptr;
+}
+
+template <typename T>
+T *Box<T>::operator->() noexcept {
+  return this->ptr;
+}
+
+template <typename T>
+T &Box<T>::operator*() noexcept {
+  return *this->ptr;
+}
+
+template <typename T>
+template <typename... Fields>
+Box<T> Box<T>::in_place(Fields &&...fields) {
+  allocation alloc;
+  auto ptr = alloc.ptr;
+  ::new (ptr) T{std::forward<Fields>(fields)...};
+  alloc.ptr = nullptr;
+  return from_raw(ptr);
+}
+
+template <typename T>
+void Box<T>::swap(Box &rhs) noexcept {
+  using std::swap;
+  swap(this->ptr, rhs.ptr);
+}
+
+template <typename T>
+Box<T> Box<T>::from_raw(T *raw) noexcept {
+  Box box = uninit{};
+  box.ptr = raw;
+  return box;
+}
+
+template <typename T>
+T *Box<T>::into_raw() noexcept {
+  T *raw = this->ptr;
+  this->ptr = nullptr;
+  return raw;
+}
+
+template <typename T>
+Box<T>::Box(uninit) noexcept {}
+#endif // CXXBRIDGE1_RUST_BOX
+
 #ifndef CXXBRIDGE1_RUST_BITCOPY_T
 #define CXXBRIDGE1_RUST_BITCOPY_T
 struct unsafe_bitcopy_t final {
@@ -661,6 +864,16 @@ private:
 };
 #endif // CXXBRIDGE1_RUST_ERROR
 
+#ifndef CXXBRIDGE1_RUST_OPAQUE
+#define CXXBRIDGE1_RUST_OPAQUE
+class Opaque {
+public:
+  Opaque() = delete;
+  Opaque(const Opaque &) = delete;
+  ~Opaque() = delete;
+};
+#endif // CXXBRIDGE1_RUST_OPAQUE
+
 #ifndef CXXBRIDGE1_IS_COMPLETE
 #define CXXBRIDGE1_IS_COMPLETE
 namespace detail {
@@ -778,6 +991,8 @@ public:
 } // namespace cxxbridge1
 } // namespace rust
 
+struct OpaqueKeyStretchingParams;
+struct OpaqueCpuTopology;
 struct OpaqueStartClientRegistrationParams;
 struct OpaqueStartClientRegistrationResult;
 struct OpaqueFinishClientRegistrationParams;
@@ -792,11 +1007,65 @@ struct OpaqueStartServerLoginParams;
 struct OpaqueStartServerLoginResult;
 struct OpaqueFinishServerLoginParams;
 struct OpaqueFinishServerLoginResult;
+struct OpaqueStartClientRegistrationBinaryResult;
+struct OpaqueFinishClientRegistrationBinaryResult;
+struct OpaqueStartClientLoginBinaryResult;
+struct OpaqueFinishClientLoginBinaryResult;
+struct OpaqueCreateServerRegistrationResponseBinaryResult;
+struct OpaqueStartServerLoginSessionResult;
+struct OpaqueStartServerLoginBatchResult;
+struct OpaqueRegistrationImportChunk;
+struct OpaqueStartServerLoginBinaryResult;
+struct OpaqueFinishServerLoginBinaryResult;
+struct OpaqueFinishClientRegistrationInput;
+struct OpaqueFinishClientLoginInput;
+struct OpaqueStartClientLoginContextInput;
+struct OpaqueCreateServerRegistrationResponseInput;
+struct OpaqueStartServerLoginInput;
+struct OpaqueFinishServerLoginInput;
+struct OpaqueStartClientRegistrationOutput;
+struct OpaqueFinishClientRegistrationOutput;
+struct OpaqueStartClientLoginOutput;
+struct OpaqueFinishClientLoginOutput;
+struct OpaqueStartServerLoginOutput;
+struct OpaqueStatus;
+struct OpaqueMetricsEntry;
+enum class OpaqueCipherSuite : ::std::uint8_t;
+enum class OpaqueMetricsFunction : ::std::uint8_t;
+enum class OpaqueErrorCode : ::std::uint8_t;
+struct ServerSetupHandle;
+struct ClientLoginContext;
+struct ServerLoginSessionStore;
+
+#ifndef CXXBRIDGE1_STRUCT_OpaqueKeyStretchingParams
+#define CXXBRIDGE1_STRUCT_OpaqueKeyStretchingParams
+// Argon2id parameters of the client side key stretching.
+struct OpaqueKeyStretchingParams final {
+  // memory size in KiB
+  ::std::uint32_t memory_cost;
+  ::std::uint32_t iterations;
+  ::std::uint32_t parallelism;
+
+  using IsRelocatable = ::std::true_type;
+};
+#endif // CXXBRIDGE1_STRUCT_OpaqueKeyStretchingParams
+
+#ifndef CXXBRIDGE1_STRUCT_OpaqueCpuTopology
+#define CXXBRIDGE1_STRUCT_OpaqueCpuTopology
+struct OpaqueCpuTopology final {
+  ::std::uint32_t cores;
+  // cores excluding the efficiency cores of big.LITTLE systems
+  ::std::uint32_t performance_cores;
+
+  using IsRelocatable = ::std::true_type;
+};
+#endif // CXXBRIDGE1_STRUCT_OpaqueCpuTopology
 
 #ifndef CXXBRIDGE1_STRUCT_OpaqueStartClientRegistrationParams
 #define CXXBRIDGE1_STRUCT_OpaqueStartClientRegistrationParams
 struct OpaqueStartClientRegistrationParams final {
   ::rust::String password;
+  ::OpaqueCipherSuite suite;
 
   using IsRelocatable = ::std::true_type;
 };
@@ -820,6 +1089,8 @@ struct OpaqueFinishClientRegistrationParams final {
   ::rust::String client_registration_state;
   ::rust::Vec<::rust::String> client_identifier;
   ::rust::Vec<::rust::String> server_identifier;
+  ::rust::Vec<::OpaqueKeyStretchingParams> key_stretching;
+  ::OpaqueCipherSuite suite;
 
   using IsRelocatable = ::std::true_type;
 };
@@ -831,6 +1102,7 @@ struct OpaqueFinishClientRegistrationResult final {
   ::rust::String registration_record;
   ::rust::String export_key;
   ::rust::String server_static_public_key;
+  ::OpaqueKeyStretchingParams key_stretching;
 
   using IsRelocatable = ::std::true_type;
 };
@@ -840,6 +1112,7 @@ struct OpaqueFinishClientRegistrationResult final {
 #define CXXBRIDGE1_STRUCT_OpaqueStartClientLoginParams
 struct OpaqueStartClientLoginParams final {
   ::rust::String password;
+  ::OpaqueCipherSuite suite;
 
   using IsRelocatable = ::std::true_type;
 };
@@ -863,6 +1136,8 @@ struct OpaqueFinishClientLoginParams final {
   ::rust::String password;
   ::rust::Vec<::rust::String> client_identifier;
   ::rust::Vec<::rust::String> server_identifier;
+  ::rust::Vec<::OpaqueKeyStretchingParams> key_stretching;
+  ::OpaqueCipherSuite suite;
 
   using IsRelocatable = ::std::true_type;
 };
@@ -883,9 +1158,9 @@ struct OpaqueFinishClientLoginResult final {
 #ifndef CXXBRIDGE1_STRUCT_OpaqueCreateServerRegistrationResponseParams
 #define CXXBRIDGE1_STRUCT_OpaqueCreateServerRegistrationResponseParams
 struct OpaqueCreateServerRegistrationResponseParams final {
-  ::rust::String server_setup;
   ::rust::String user_identifier;
   ::rust::String registration_request;
+  ::OpaqueCipherSuite suite;
 
   using IsRelocatable = ::std::true_type;
 };
@@ -903,12 +1178,12 @@ struct OpaqueCreateServerRegistrationResponseResult final {
 #ifndef CXXBRIDGE1_STRUCT_OpaqueStartServerLoginParams
 #define CXXBRIDGE1_STRUCT_OpaqueStartServerLoginParams
 struct OpaqueStartServerLoginParams final {
-  ::rust::String server_setup;
   ::rust::Vec<::rust::String> registration_record;
   ::rust::String start_login_request;
   ::rust::String user_identifier;
   ::rust::Vec<::rust::String> client_identifier;
   ::rust::Vec<::rust::String> server_identifier;
+  ::OpaqueCipherSuite suite;
 
   using IsRelocatable = ::std::true_type;
 };
@@ -929,6 +1204,7 @@ struct OpaqueStartServerLoginResult final {
 struct OpaqueFinishServerLoginParams final {
   ::rust::String server_login_state;
   ::rust::String finish_login_request;
+  ::OpaqueCipherSuite suite;
 
   using IsRelocatable = ::std::true_type;
 };
@@ -943,132 +1219,1357 @@ struct OpaqueFinishServerLoginResult final {
 };
 #endif // CXXBRIDGE1_STRUCT_OpaqueFinishServerLoginResult
 
-extern "C" {
-::rust::repr::PtrLen cxxbridge1$opaque_start_client_registration(::OpaqueStartClientRegistrationParams *params, ::OpaqueStartClientRegistrationResult *return$) noexcept;
+#ifndef CXXBRIDGE1_STRUCT_OpaqueStartClientRegistrationBinaryResult
+#define CXXBRIDGE1_STRUCT_OpaqueStartClientRegistrationBinaryResult
+struct OpaqueStartClientRegistrationBinaryResult final {
+  ::rust::Vec<::std::uint8_t> client_registration_state;
+  ::rust::Vec<::std::uint8_t> registration_request;
 
-::rust::repr::PtrLen cxxbridge1$opaque_finish_client_registration(::OpaqueFinishClientRegistrationParams *params, ::OpaqueFinishClientRegistrationResult *return$) noexcept;
+  using IsRelocatable = ::std::true_type;
+};
+#endif // CXXBRIDGE1_STRUCT_OpaqueStartClientRegistrationBinaryResult
 
-::rust::repr::PtrLen cxxbridge1$opaque_start_client_login(::OpaqueStartClientLoginParams *params, ::OpaqueStartClientLoginResult *return$) noexcept;
+#ifndef CXXBRIDGE1_STRUCT_OpaqueFinishClientRegistrationBinaryResult
+#define CXXBRIDGE1_STRUCT_OpaqueFinishClientRegistrationBinaryResult
+struct OpaqueFinishClientRegistrationBinaryResult final {
+  ::rust::Vec<::std::uint8_t> registration_record;
+  ::rust::Vec<::std::uint8_t> export_key;
+  ::rust::Vec<::std::uint8_t> server_static_public_key;
+  ::OpaqueKeyStretchingParams key_stretching;
 
-::rust::repr::PtrLen cxxbridge1$opaque_finish_client_login(::OpaqueFinishClientLoginParams *params, ::std::unique_ptr<::OpaqueFinishClientLoginResult> *return$) noexcept;
+  using IsRelocatable = ::std::true_type;
+};
+#endif // CXXBRIDGE1_STRUCT_OpaqueFinishClientRegistrationBinaryResult
 
-void cxxbridge1$opaque_create_server_setup(::rust::String *return$) noexcept;
+#ifndef CXXBRIDGE1_STRUCT_OpaqueStartClientLoginBinaryResult
+#define CXXBRIDGE1_STRUCT_OpaqueStartClientLoginBinaryResult
+struct OpaqueStartClientLoginBinaryResult final {
+  ::rust::Vec<::std::uint8_t> client_login_state;
+  ::rust::Vec<::std::uint8_t> start_login_request;
 
-::rust::repr::PtrLen cxxbridge1$opaque_get_server_public_key(::rust::String *data, ::rust::String *return$) noexcept;
+  using IsRelocatable = ::std::true_type;
+};
+#endif // CXXBRIDGE1_STRUCT_OpaqueStartClientLoginBinaryResult
 
-::rust::repr::PtrLen cxxbridge1$opaque_create_server_registration_response(::OpaqueCreateServerRegistrationResponseParams *params, ::OpaqueCreateServerRegistrationResponseResult *return$) noexcept;
+#ifndef CXXBRIDGE1_STRUCT_OpaqueFinishClientLoginBinaryResult
+#define CXXBRIDGE1_STRUCT_OpaqueFinishClientLoginBinaryResult
+struct OpaqueFinishClientLoginBinaryResult final {
+  ::rust::Vec<::std::uint8_t> finish_login_request;
+  ::rust::Vec<::std::uint8_t> session_key;
+  ::rust::Vec<::std::uint8_t> export_key;
+  ::rust::Vec<::std::uint8_t> server_static_public_key;
 
-::rust::repr::PtrLen cxxbridge1$opaque_start_server_login(::OpaqueStartServerLoginParams *params, ::OpaqueStartServerLoginResult *return$) noexcept;
+  using IsRelocatable = ::std::true_type;
+};
+#endif // CXXBRIDGE1_STRUCT_OpaqueFinishClientLoginBinaryResult
 
-::rust::repr::PtrLen cxxbridge1$opaque_finish_server_login(::OpaqueFinishServerLoginParams *params, ::OpaqueFinishServerLoginResult *return$) noexcept;
-} // extern "C"
+#ifndef CXXBRIDGE1_STRUCT_OpaqueCreateServerRegistrationResponseBinaryResult
+#define CXXBRIDGE1_STRUCT_OpaqueCreateServerRegistrationResponseBinaryResult
+struct OpaqueCreateServerRegistrationResponseBinaryResult final {
+  ::rust::Vec<::std::uint8_t> registration_response;
 
-::OpaqueStartClientRegistrationResult opaque_start_client_registration(::OpaqueStartClientRegistrationParams params) {
-  ::rust::ManuallyDrop<::OpaqueStartClientRegistrationParams> params$(::std::move(params));
-  ::rust::MaybeUninit<::OpaqueStartClientRegistrationResult> return$;
-  ::rust::repr::PtrLen error$ = cxxbridge1$opaque_start_client_registration(&params$.value, &return$.value);
-  if (error$.ptr) {
-    throw ::rust::impl<::rust::Error>::error(error$);
-  }
-  return ::std::move(return$.value);
-}
+  using IsRelocatable = ::std::true_type;
+};
+#endif // CXXBRIDGE1_STRUCT_OpaqueCreateServerRegistrationResponseBinaryResult
 
-::OpaqueFinishClientRegistrationResult opaque_finish_client_registration(::OpaqueFinishClientRegistrationParams params) {
-  ::rust::ManuallyDrop<::OpaqueFinishClientRegistrationParams> params$(::std::move(params));
-  ::rust::MaybeUninit<::OpaqueFinishClientRegistrationResult> return$;
-  ::rust::repr::PtrLen error$ = cxxbridge1$opaque_finish_client_registration(&params$.value, &return$.value);
-  if (error$.ptr) {
-    throw ::rust::impl<::rust::Error>::error(error$);
-  }
-  return ::std::move(return$.value);
-}
+#ifndef CXXBRIDGE1_STRUCT_OpaqueStartServerLoginSessionResult
+#define CXXBRIDGE1_STRUCT_OpaqueStartServerLoginSessionResult
+struct OpaqueStartServerLoginSessionResult final {
+  // identifies the login session in `opaque_finish_server_login_session`
+  ::rust::String session_handle;
+  ::rust::String login_response;
 
-::OpaqueStartClientLoginResult opaque_start_client_login(::OpaqueStartClientLoginParams params) {
-  ::rust::ManuallyDrop<::OpaqueStartClientLoginParams> params$(::std::move(params));
-  ::rust::MaybeUninit<::OpaqueStartClientLoginResult> return$;
-  ::rust::repr::PtrLen error$ = cxxbridge1$opaque_start_client_login(&params$.value, &return$.value);
-  if (error$.ptr) {
-    throw ::rust::impl<::rust::Error>::error(error$);
-  }
-  return ::std::move(return$.value);
-}
+  using IsRelocatable = ::std::true_type;
+};
+#endif // CXXBRIDGE1_STRUCT_OpaqueStartServerLoginSessionResult
 
-::std::unique_ptr<::OpaqueFinishClientLoginResult> opaque_finish_client_login(::OpaqueFinishClientLoginParams params) {
-  ::rust::ManuallyDrop<::OpaqueFinishClientLoginParams> params$(::std::move(params));
-  ::rust::MaybeUninit<::std::unique_ptr<::OpaqueFinishClientLoginResult>> return$;
-  ::rust::repr::PtrLen error$ = cxxbridge1$opaque_finish_client_login(&params$.value, &return$.value);
-  if (error$.ptr) {
-    throw ::rust::impl<::rust::Error>::error(error$);
-  }
-  return ::std::move(return$.value);
-}
+#ifndef CXXBRIDGE1_STRUCT_OpaqueStartServerLoginBatchResult
+#define CXXBRIDGE1_STRUCT_OpaqueStartServerLoginBatchResult
+struct OpaqueStartServerLoginBatchResult final {
+  ::rust::String server_login_state;
+  ::rust::String login_response;
+  // `None` if the request succeeded.
+  ::OpaqueErrorCode error_code;
+  ::rust::String error_message;
 
-::rust::String opaque_create_server_setup() noexcept {
-  ::rust::MaybeUninit<::rust::String> return$;
-  cxxbridge1$opaque_create_server_setup(&return$.value);
-  return ::std::move(return$.value);
-}
+  using IsRelocatable = ::std::true_type;
+};
+#endif // CXXBRIDGE1_STRUCT_OpaqueStartServerLoginBatchResult
+
+#ifndef CXXBRIDGE1_STRUCT_OpaqueRegistrationImportChunk
+#define CXXBRIDGE1_STRUCT_OpaqueRegistrationImportChunk
+// Result of one chunk of a bulk registration import, see `import.rs`
+// for the framing of `responses`.
+struct OpaqueRegistrationImportChunk final {
+  ::rust::Vec<::std::uint8_t> responses;
+  // bytes of the input taken up by the records of this chunk
+  ::std::size_t consumed;
+  ::std::size_t records;
+  ::std::size_t failed;
 
-::rust::String opaque_get_server_public_key(::rust::String data) {
-  ::rust::MaybeUninit<::rust::String> return$;
-  ::rust::repr::PtrLen error$ = cxxbridge1$opaque_get_server_public_key(&data, &return$.value);
-  if (error$.ptr) {
-    throw ::rust::impl<::rust::Error>::error(error$);
-  }
-  return ::std::move(return$.value);
-}
+  using IsRelocatable = ::std::true_type;
+};
+#endif // CXXBRIDGE1_STRUCT_OpaqueRegistrationImportChunk
 
-::OpaqueCreateServerRegistrationResponseResult opaque_create_server_registration_response(::OpaqueCreateServerRegistrationResponseParams params) {
-  ::rust::ManuallyDrop<::OpaqueCreateServerRegistrationResponseParams> params$(::std::move(params));
-  ::rust::MaybeUninit<::OpaqueCreateServerRegistrationResponseResult> return$;
-  ::rust::repr::PtrLen error$ = cxxbridge1$opaque_create_server_registration_response(&params$.value, &return$.value);
-  if (error$.ptr) {
-    throw ::rust::impl<::rust::Error>::error(error$);
-  }
-  return ::std::move(return$.value);
-}
+#ifndef CXXBRIDGE1_STRUCT_OpaqueStartServerLoginBinaryResult
+#define CXXBRIDGE1_STRUCT_OpaqueStartServerLoginBinaryResult
+struct OpaqueStartServerLoginBinaryResult final {
+  ::rust::Vec<::std::uint8_t> server_login_state;
+  ::rust::Vec<::std::uint8_t> login_response;
 
-::OpaqueStartServerLoginResult opaque_start_server_login(::OpaqueStartServerLoginParams params) {
-  ::rust::ManuallyDrop<::OpaqueStartServerLoginParams> params$(::std::move(params));
-  ::rust::MaybeUninit<::OpaqueStartServerLoginResult> return$;
-  ::rust::repr::PtrLen error$ = cxxbridge1$opaque_start_server_login(&params$.value, &return$.value);
-  if (error$.ptr) {
-    throw ::rust::impl<::rust::Error>::error(error$);
-  }
-  return ::std::move(return$.value);
-}
+  using IsRelocatable = ::std::true_type;
+};
+#endif // CXXBRIDGE1_STRUCT_OpaqueStartServerLoginBinaryResult
 
-::OpaqueFinishServerLoginResult opaque_finish_server_login(::OpaqueFinishServerLoginParams params) {
-  ::rust::ManuallyDrop<::OpaqueFinishServerLoginParams> params$(::std::move(params));
-  ::rust::MaybeUninit<::OpaqueFinishServerLoginResult> return$;
-  ::rust::repr::PtrLen error$ = cxxbridge1$opaque_finish_server_login(&params$.value, &return$.value);
-  if (error$.ptr) {
-    throw ::rust::impl<::rust::Error>::error(error$);
-  }
-  return ::std::move(return$.value);
-}
+#ifndef CXXBRIDGE1_STRUCT_OpaqueFinishServerLoginBinaryResult
+#define CXXBRIDGE1_STRUCT_OpaqueFinishServerLoginBinaryResult
+struct OpaqueFinishServerLoginBinaryResult final {
+  ::rust::Vec<::std::uint8_t> session_key;
 
-extern "C" {
-static_assert(sizeof(::std::unique_ptr<::OpaqueFinishClientLoginResult>) == sizeof(void *), "");
-static_assert(alignof(::std::unique_ptr<::OpaqueFinishClientLoginResult>) == alignof(void *), "");
-void cxxbridge1$unique_ptr$OpaqueFinishClientLoginResult$null(::std::unique_ptr<::OpaqueFinishClientLoginResult> *ptr) noexcept {
-  ::new (ptr) ::std::unique_ptr<::OpaqueFinishClientLoginResult>();
-}
-::OpaqueFinishClientLoginResult *cxxbridge1$unique_ptr$OpaqueFinishClientLoginResult$uninit(::std::unique_ptr<::OpaqueFinishClientLoginResult> *ptr) noexcept {
-  ::OpaqueFinishClientLoginResult *uninit = reinterpret_cast<::OpaqueFinishClientLoginResult *>(new ::rust::MaybeUninit<::OpaqueFinishClientLoginResult>);
-  ::new (ptr) ::std::unique_ptr<::OpaqueFinishClientLoginResult>(uninit);
-  return uninit;
-}
-void cxxbridge1$unique_ptr$OpaqueFinishClientLoginResult$raw(::std::unique_ptr<::OpaqueFinishClientLoginResult> *ptr, ::OpaqueFinishClientLoginResult *raw) noexcept {
-  ::new (ptr) ::std::unique_ptr<::OpaqueFinishClientLoginResult>(raw);
-}
-::OpaqueFinishClientLoginResult const *cxxbridge1$unique_ptr$OpaqueFinishClientLoginResult$get(::std::unique_ptr<::OpaqueFinishClientLoginResult> const &ptr) noexcept {
-  return ptr.get();
-}
-::OpaqueFinishClientLoginResult *cxxbridge1$unique_ptr$OpaqueFinishClientLoginResult$release(::std::unique_ptr<::OpaqueFinishClientLoginResult> &ptr) noexcept {
-  return ptr.release();
-}
-void cxxbridge1$unique_ptr$OpaqueFinishClientLoginResult$drop(::std::unique_ptr<::OpaqueFinishClientLoginResult> *ptr) noexcept {
-  ptr->~unique_ptr();
-}
-} // extern "C"
+  using IsRelocatable = ::std::true_type;
+};
+#endif // CXXBRIDGE1_STRUCT_OpaqueFinishServerLoginBinaryResult
+
+#ifndef CXXBRIDGE1_STRUCT_OpaqueFinishClientRegistrationInput
+#define CXXBRIDGE1_STRUCT_OpaqueFinishClientRegistrationInput
+struct OpaqueFinishClientRegistrationInput final {
+  ::rust::Str password;
+  ::rust::Str registration_response;
+  ::rust::Str client_registration_state;
+  ::rust::Str client_identifier;
+  bool has_client_identifier;
+  ::rust::Str server_identifier;
+  bool has_server_identifier;
+  ::OpaqueKeyStretchingParams key_stretching;
+  bool has_key_stretching;
+  ::OpaqueCipherSuite suite;
+
+  using IsRelocatable = ::std::true_type;
+};
+#endif // CXXBRIDGE1_STRUCT_OpaqueFinishClientRegistrationInput
+
+#ifndef CXXBRIDGE1_STRUCT_OpaqueFinishClientLoginInput
+#define CXXBRIDGE1_STRUCT_OpaqueFinishClientLoginInput
+struct OpaqueFinishClientLoginInput final {
+  ::rust::Str client_login_state;
+  ::rust::Str login_response;
+  ::rust::Str password;
+  ::rust::Str client_identifier;
+  bool has_client_identifier;
+  ::rust::Str server_identifier;
+  bool has_server_identifier;
+  ::OpaqueKeyStretchingParams key_stretching;
+  bool has_key_stretching;
+  ::OpaqueCipherSuite suite;
+
+  using IsRelocatable = ::std::true_type;
+};
+#endif // CXXBRIDGE1_STRUCT_OpaqueFinishClientLoginInput
+
+#ifndef CXXBRIDGE1_STRUCT_OpaqueStartClientLoginContextInput
+#define CXXBRIDGE1_STRUCT_OpaqueStartClientLoginContextInput
+// The password, identifiers and key stretching params are kept in the
+// client login context until the login is finished.
+struct OpaqueStartClientLoginContextInput final {
+  ::rust::Str password;
+  ::rust::Str client_identifier;
+  bool has_client_identifier;
+  ::rust::Str server_identifier;
+  bool has_server_identifier;
+  ::OpaqueKeyStretchingParams key_stretching;
+  bool has_key_stretching;
+  ::OpaqueCipherSuite suite;
+
+  using IsRelocatable = ::std::true_type;
+};
+#endif // CXXBRIDGE1_STRUCT_OpaqueStartClientLoginContextInput
+
+#ifndef CXXBRIDGE1_STRUCT_OpaqueCreateServerRegistrationResponseInput
+#define CXXBRIDGE1_STRUCT_OpaqueCreateServerRegistrationResponseInput
+struct OpaqueCreateServerRegistrationResponseInput final {
+  ::rust::Str user_identifier;
+  ::rust::Str registration_request;
+  ::OpaqueCipherSuite suite;
+
+  using IsRelocatable = ::std::true_type;
+};
+#endif // CXXBRIDGE1_STRUCT_OpaqueCreateServerRegistrationResponseInput
+
+#ifndef CXXBRIDGE1_STRUCT_OpaqueStartServerLoginInput
+#define CXXBRIDGE1_STRUCT_OpaqueStartServerLoginInput
+struct OpaqueStartServerLoginInput final {
+  ::rust::Str registration_record;
+  bool has_registration_record;
+  ::rust::Str start_login_request;
+  ::rust::Str user_identifier;
+  ::rust::Str client_identifier;
+  bool has_client_identifier;
+  ::rust::Str server_identifier;
+  bool has_server_identifier;
+  ::OpaqueCipherSuite suite;
+
+  using IsRelocatable = ::std::true_type;
+};
+#endif // CXXBRIDGE1_STRUCT_OpaqueStartServerLoginInput
+
+#ifndef CXXBRIDGE1_STRUCT_OpaqueFinishServerLoginInput
+#define CXXBRIDGE1_STRUCT_OpaqueFinishServerLoginInput
+struct OpaqueFinishServerLoginInput final {
+  ::rust::Str server_login_state;
+  ::rust::Str finish_login_request;
+  ::OpaqueCipherSuite suite;
+
+  using IsRelocatable = ::std::true_type;
+};
+#endif // CXXBRIDGE1_STRUCT_OpaqueFinishServerLoginInput
+
+#ifndef CXXBRIDGE1_STRUCT_OpaqueStartClientRegistrationOutput
+#define CXXBRIDGE1_STRUCT_OpaqueStartClientRegistrationOutput
+struct OpaqueStartClientRegistrationOutput final {
+  ::std::size_t client_registration_state;
+  ::std::size_t registration_request;
+
+  using IsRelocatable = ::std::true_type;
+};
+#endif // CXXBRIDGE1_STRUCT_OpaqueStartClientRegistrationOutput
+
+#ifndef CXXBRIDGE1_STRUCT_OpaqueFinishClientRegistrationOutput
+#define CXXBRIDGE1_STRUCT_OpaqueFinishClientRegistrationOutput
+struct OpaqueFinishClientRegistrationOutput final {
+  ::std::size_t registration_record;
+  ::std::size_t export_key;
+  ::std::size_t server_static_public_key;
+  ::OpaqueKeyStretchingParams key_stretching;
+
+  using IsRelocatable = ::std::true_type;
+};
+#endif // CXXBRIDGE1_STRUCT_OpaqueFinishClientRegistrationOutput
+
+#ifndef CXXBRIDGE1_STRUCT_OpaqueStartClientLoginOutput
+#define CXXBRIDGE1_STRUCT_OpaqueStartClientLoginOutput
+struct OpaqueStartClientLoginOutput final {
+  ::std::size_t client_login_state;
+  ::std::size_t start_login_request;
+
+  using IsRelocatable = ::std::true_type;
+};
+#endif // CXXBRIDGE1_STRUCT_OpaqueStartClientLoginOutput
+
+#ifndef CXXBRIDGE1_STRUCT_OpaqueFinishClientLoginOutput
+#define CXXBRIDGE1_STRUCT_OpaqueFinishClientLoginOutput
+struct OpaqueFinishClientLoginOutput final {
+  // false if the client detected a login failure, nothing is written
+  // to the output buffer then
+  bool success;
+  ::std::size_t finish_login_request;
+  ::std::size_t session_key;
+  ::std::size_t export_key;
+  ::std::size_t server_static_public_key;
+
+  using IsRelocatable = ::std::true_type;
+};
+#endif // CXXBRIDGE1_STRUCT_OpaqueFinishClientLoginOutput
+
+#ifndef CXXBRIDGE1_STRUCT_OpaqueStartServerLoginOutput
+#define CXXBRIDGE1_STRUCT_OpaqueStartServerLoginOutput
+struct OpaqueStartServerLoginOutput final {
+  ::std::size_t server_login_state;
+  ::std::size_t login_response;
+
+  using IsRelocatable = ::std::true_type;
+};
+#endif // CXXBRIDGE1_STRUCT_OpaqueStartServerLoginOutput
+
+#ifndef CXXBRIDGE1_STRUCT_OpaqueStatus
+#define CXXBRIDGE1_STRUCT_OpaqueStatus
+// Outcome of the `opaque_try_*` functions, which report an error
+// instead of throwing it. Its message is written to the start of the
+// output buffer, `message` is its length.
+struct OpaqueStatus final {
+  ::OpaqueErrorCode code;
+  ::std::size_t message;
+
+  using IsRelocatable = ::std::true_type;
+};
+#endif // CXXBRIDGE1_STRUCT_OpaqueStatus
+
+#ifndef CXXBRIDGE1_STRUCT_OpaqueMetricsEntry
+#define CXXBRIDGE1_STRUCT_OpaqueMetricsEntry
+// Durations of one phase of a function, the percentiles are the upper
+// bound of their power of two histogram bucket.
+struct OpaqueMetricsEntry final {
+  ::rust::String function;
+  ::rust::String phase;
+  ::std::uint64_t count;
+  ::std::uint64_t total_ns;
+  ::std::uint64_t max_ns;
+  ::std::uint64_t p50_ns;
+  ::std::uint64_t p90_ns;
+  ::std::uint64_t p99_ns;
+
+  using IsRelocatable = ::std::true_type;
+};
+#endif // CXXBRIDGE1_STRUCT_OpaqueMetricsEntry
+
+#ifndef CXXBRIDGE1_ENUM_OpaqueCipherSuite
+#define CXXBRIDGE1_ENUM_OpaqueCipherSuite
+// Cipher suite of a call. Messages, states and server setups of one
+// suite can't be used with another, the client and the server must
+// agree on it. `Default` is Ristretto255, or P-256 in builds with the
+// `p256` feature; P-256 is only available with the `p256-suite` feature.
+enum class OpaqueCipherSuite : ::std::uint8_t {
+  Default = 0,
+  Ristretto255 = 1,
+  P256 = 2,
+};
+#endif // CXXBRIDGE1_ENUM_OpaqueCipherSuite
+
+#ifndef CXXBRIDGE1_ENUM_OpaqueMetricsFunction
+#define CXXBRIDGE1_ENUM_OpaqueMetricsFunction
+// The functions with metrics, see `metrics.rs`. The string, binary
+// and server setup handle variants of a function share its metrics.
+enum class OpaqueMetricsFunction : ::std::uint8_t {
+  StartClientRegistration = 0,
+  FinishClientRegistration = 1,
+  StartClientLogin = 2,
+  FinishClientLogin = 3,
+  CreateServerRegistrationResponse = 4,
+  StartServerLogin = 5,
+  FinishServerLogin = 6,
+};
+#endif // CXXBRIDGE1_ENUM_OpaqueMetricsFunction
+
+#ifndef CXXBRIDGE1_ENUM_OpaqueErrorCode
+#define CXXBRIDGE1_ENUM_OpaqueErrorCode
+// Code of an `Error` in the result mode, one per variant and
+// `InvalidLogin` for the protocol error of a wrong password. `None`
+// if there was no error.
+enum class OpaqueErrorCode : ::std::uint8_t {
+  None = 0,
+  Input = 1,
+  Protocol = 2,
+  Base64 = 3,
+  InvalidLogin = 4,
+};
+#endif // CXXBRIDGE1_ENUM_OpaqueErrorCode
+
+#ifndef CXXBRIDGE1_STRUCT_ServerSetupHandle
+#define CXXBRIDGE1_STRUCT_ServerSetupHandle
+struct ServerSetupHandle final : public ::rust::Opaque {
+  ~ServerSetupHandle() = delete;
+
+private:
+  friend ::rust::layout;
+  struct layout {
+    static ::std::size_t size() noexcept;
+    static ::std::size_t align() noexcept;
+  };
+};
+#endif // CXXBRIDGE1_STRUCT_ServerSetupHandle
+
+#ifndef CXXBRIDGE1_STRUCT_ClientLoginContext
+#define CXXBRIDGE1_STRUCT_ClientLoginContext
+struct ClientLoginContext final : public ::rust::Opaque {
+  ~ClientLoginContext() = delete;
+
+private:
+  friend ::rust::layout;
+  struct layout {
+    static ::std::size_t size() noexcept;
+    static ::std::size_t align() noexcept;
+  };
+};
+#endif // CXXBRIDGE1_STRUCT_ClientLoginContext
+
+#ifndef CXXBRIDGE1_STRUCT_ServerLoginSessionStore
+#define CXXBRIDGE1_STRUCT_ServerLoginSessionStore
+struct ServerLoginSessionStore final : public ::rust::Opaque {
+  ~ServerLoginSessionStore() = delete;
+
+private:
+  friend ::rust::layout;
+  struct layout {
+    static ::std::size_t size() noexcept;
+    static ::std::size_t align() noexcept;
+  };
+};
+#endif // CXXBRIDGE1_STRUCT_ServerLoginSessionStore
+
+extern "C" {
+::std::size_t cxxbridge1$ServerSetupHandle$operator$sizeof() noexcept;
+::std::size_t cxxbridge1$ServerSetupHandle$operator$alignof() noexcept;
+
+::std::size_t cxxbridge1$ClientLoginContext$operator$sizeof() noexcept;
+::std::size_t cxxbridge1$ClientLoginContext$operator$alignof() noexcept;
+
+::std::size_t cxxbridge1$ServerLoginSessionStore$operator$sizeof() noexcept;
+::std::size_t cxxbridge1$ServerLoginSessionStore$operator$alignof() noexcept;
+
+::rust::repr::PtrLen cxxbridge1$opaque_start_client_registration(::OpaqueStartClientRegistrationParams *params, ::OpaqueStartClientRegistrationResult *return$) noexcept;
+
+::rust::repr::PtrLen cxxbridge1$opaque_finish_client_registration(::OpaqueFinishClientRegistrationParams *params, ::OpaqueFinishClientRegistrationResult *return$) noexcept;
+
+::rust::repr::PtrLen cxxbridge1$opaque_start_client_login(::OpaqueStartClientLoginParams *params, ::OpaqueStartClientLoginResult *return$) noexcept;
+
+::rust::repr::PtrLen cxxbridge1$opaque_finish_client_login(::OpaqueFinishClientLoginParams *params, ::std::unique_ptr<::OpaqueFinishClientLoginResult> *return$) noexcept;
+
+::rust::repr::PtrLen cxxbridge1$opaque_start_client_login_context(::OpaqueStartClientLoginContextInput *input, ::rust::String &start_login_request, ::rust::Box<::ClientLoginContext> *return$) noexcept;
+
+::rust::repr::PtrLen cxxbridge1$opaque_finish_client_login_context(::ClientLoginContext const &context, ::rust::Str login_response, ::rust::Slice<::std::uint8_t> out, ::OpaqueFinishClientLoginOutput *return$) noexcept;
+
+::rust::repr::PtrLen cxxbridge1$opaque_calibrate_key_stretching(::std::uint32_t target_duration_ms, ::std::uint32_t parallelism, ::OpaqueKeyStretchingParams *return$) noexcept;
+
+::rust::repr::PtrLen cxxbridge1$opaque_check_key_stretching(::rust::Vec<::OpaqueKeyStretchingParams> *key_stretching) noexcept;
+
+::rust::repr::PtrLen cxxbridge1$opaque_prewarm_key_stretching(::rust::Vec<::OpaqueKeyStretchingParams> *key_stretching) noexcept;
+
+::rust::repr::PtrLen cxxbridge1$opaque_prepare_client_login_finish(::rust::Vec<::OpaqueKeyStretchingParams> *key_stretching) noexcept;
+
+void cxxbridge1$opaque_release_key_stretching_memory() noexcept;
+
+void cxxbridge1$opaque_trim_key_stretching_memory() noexcept;
+
+void cxxbridge1$opaque_get_cpu_topology(::OpaqueCpuTopology *return$) noexcept;
+
+::rust::repr::PtrLen cxxbridge1$opaque_create_server_setup(::OpaqueCipherSuite suite, ::rust::String *return$) noexcept;
+
+::rust::repr::PtrLen cxxbridge1$opaque_create_server_setup_handle(::rust::String *data, ::OpaqueCipherSuite suite, ::rust::Box<::ServerSetupHandle> *return$) noexcept;
+
+::rust::repr::PtrLen cxxbridge1$opaque_get_server_public_key(::rust::String *data, ::OpaqueCipherSuite suite, ::rust::String *return$) noexcept;
+
+void cxxbridge1$opaque_get_server_public_key_with_setup(::ServerSetupHandle const &server_setup, ::rust::String *return$) noexcept;
+
+::rust::repr::PtrLen cxxbridge1$opaque_create_server_registration_response(::rust::String *server_setup, ::OpaqueCreateServerRegistrationResponseParams *params, ::OpaqueCreateServerRegistrationResponseResult *return$) noexcept;
+
+::rust::repr::PtrLen cxxbridge1$opaque_create_server_registration_response_with_setup(::ServerSetupHandle const &server_setup, ::OpaqueCreateServerRegistrationResponseParams *params, ::OpaqueCreateServerRegistrationResponseResult *return$) noexcept;
+
+::rust::repr::PtrLen cxxbridge1$opaque_start_server_login(::rust::String *server_setup, ::OpaqueStartServerLoginParams *params, ::OpaqueStartServerLoginResult *return$) noexcept;
+
+::rust::repr::PtrLen cxxbridge1$opaque_start_server_login_with_setup(::ServerSetupHandle const &server_setup, ::OpaqueStartServerLoginParams *params, ::OpaqueStartServerLoginResult *return$) noexcept;
+
+void cxxbridge1$opaque_start_server_login_batch(::ServerSetupHandle const &server_setup, ::rust::Vec<::OpaqueStartServerLoginParams> *requests, ::rust::Vec<::OpaqueStartServerLoginBatchResult> *return$) noexcept;
+
+::rust::repr::PtrLen cxxbridge1$opaque_count_registration_import_records(::rust::Slice<::std::uint8_t const> records, ::std::uint64_t *return$) noexcept;
+
+::rust::repr::PtrLen cxxbridge1$opaque_create_server_registration_responses_chunk(::ServerSetupHandle const &server_setup, ::rust::Slice<::std::uint8_t const> records, ::std::size_t max_records, ::OpaqueRegistrationImportChunk *return$) noexcept;
+
+::rust::repr::PtrLen cxxbridge1$opaque_create_server_login_session_store(::std::uint32_t ttl_ms, ::std::size_t max_memory_bytes, ::rust::Box<::ServerLoginSessionStore> *return$) noexcept;
+
+::std::size_t cxxbridge1$opaque_server_login_session_count(::ServerLoginSessionStore const &store) noexcept;
+
+::rust::repr::PtrLen cxxbridge1$opaque_start_server_login_session(::ServerLoginSessionStore const &store, ::ServerSetupHandle const &server_setup, ::OpaqueStartServerLoginParams *params, ::OpaqueStartServerLoginSessionResult *return$) noexcept;
+
+::rust::repr::PtrLen cxxbridge1$opaque_finish_server_login_session(::ServerLoginSessionStore const &store, ::rust::Str session_handle, ::rust::Str finish_login_request, ::OpaqueFinishServerLoginResult *return$) noexcept;
+
+::rust::repr::PtrLen cxxbridge1$opaque_finish_server_login(::OpaqueFinishServerLoginParams *params, ::OpaqueFinishServerLoginResult *return$) noexcept;
+
+::rust::repr::PtrLen cxxbridge1$opaque_start_client_registration_binary(::rust::Str password, ::OpaqueCipherSuite suite, ::OpaqueStartClientRegistrationBinaryResult *return$) noexcept;
+
+::rust::repr::PtrLen cxxbridge1$opaque_finish_client_registration_binary(::rust::Str password, ::rust::Slice<::std::uint8_t const> registration_response, ::rust::Slice<::std::uint8_t const> client_registration_state, ::rust::Vec<::rust::String> *client_identifier, ::rust::Vec<::rust::String> *server_identifier, ::rust::Vec<::OpaqueKeyStretchingParams> *key_stretching, ::OpaqueCipherSuite suite, ::OpaqueFinishClientRegistrationBinaryResult *return$) noexcept;
+
+::rust::repr::PtrLen cxxbridge1$opaque_start_client_login_binary(::rust::Str password, ::OpaqueCipherSuite suite, ::OpaqueStartClientLoginBinaryResult *return$) noexcept;
+
+::rust::repr::PtrLen cxxbridge1$opaque_finish_client_login_binary(::rust::Slice<::std::uint8_t const> client_login_state, ::rust::Slice<::std::uint8_t const> login_response, ::rust::Str password, ::rust::Vec<::rust::String> *client_identifier, ::rust::Vec<::rust::String> *server_identifier, ::rust::Vec<::OpaqueKeyStretchingParams> *key_stretching, ::OpaqueCipherSuite suite, ::std::unique_ptr<::OpaqueFinishClientLoginBinaryResult> *return$) noexcept;
+
+::rust::repr::PtrLen cxxbridge1$opaque_create_server_setup_binary(::OpaqueCipherSuite suite, ::rust::Vec<::std::uint8_t> *return$) noexcept;
+
+::rust::repr::PtrLen cxxbridge1$opaque_create_server_setup_handle_binary(::rust::Slice<::std::uint8_t const> data, ::OpaqueCipherSuite suite, ::rust::Box<::ServerSetupHandle> *return$) noexcept;
+
+::rust::repr::PtrLen cxxbridge1$opaque_get_server_public_key_binary(::rust::Slice<::std::uint8_t const> data, ::OpaqueCipherSuite suite, ::rust::Vec<::std::uint8_t> *return$) noexcept;
+
+void cxxbridge1$opaque_get_server_public_key_with_setup_binary(::ServerSetupHandle const &server_setup, ::rust::Vec<::std::uint8_t> *return$) noexcept;
+
+::rust::repr::PtrLen cxxbridge1$opaque_check_server_setup_suite(::ServerSetupHandle const &server_setup, ::OpaqueCipherSuite suite) noexcept;
+
+::rust::repr::PtrLen cxxbridge1$opaque_create_server_registration_response_binary(::rust::Slice<::std::uint8_t const> server_setup, ::rust::Str user_identifier, ::rust::Slice<::std::uint8_t const> registration_request, ::OpaqueCipherSuite suite, ::OpaqueCreateServerRegistrationResponseBinaryResult *return$) noexcept;
+
+::rust::repr::PtrLen cxxbridge1$opaque_create_server_registration_response_with_setup_binary(::ServerSetupHandle const &server_setup, ::rust::Str user_identifier, ::rust::Slice<::std::uint8_t const> registration_request, ::OpaqueCreateServerRegistrationResponseBinaryResult *return$) noexcept;
+
+::rust::repr::PtrLen cxxbridge1$opaque_start_server_login_binary(::rust::Slice<::std::uint8_t const> server_setup, ::rust::Slice<::std::uint8_t const> registration_record, bool has_registration_record, ::rust::Slice<::std::uint8_t const> start_login_request, ::rust::Str user_identifier, ::rust::Vec<::rust::String> *client_identifier, ::rust::Vec<::rust::String> *server_identifier, ::OpaqueCipherSuite suite, ::OpaqueStartServerLoginBinaryResult *return$) noexcept;
+
+::rust::repr::PtrLen cxxbridge1$opaque_start_server_login_with_setup_binary(::ServerSetupHandle const &server_setup, ::rust::Slice<::std::uint8_t const> registration_record, bool has_registration_record, ::rust::Slice<::std::uint8_t const> start_login_request, ::rust::Str user_identifier, ::rust::Vec<::rust::String> *client_identifier, ::rust::Vec<::rust::String> *server_identifier, ::OpaqueStartServerLoginBinaryResult *return$) noexcept;
+
+::rust::repr::PtrLen cxxbridge1$opaque_finish_server_login_binary(::rust::Slice<::std::uint8_t const> server_login_state, ::rust::Slice<::std::uint8_t const> finish_login_request, ::OpaqueCipherSuite suite, ::OpaqueFinishServerLoginBinaryResult *return$) noexcept;
+
+::rust::repr::PtrLen cxxbridge1$opaque_start_client_registration_into(::rust::Str password, ::OpaqueCipherSuite suite, ::rust::Slice<::std::uint8_t> out, ::OpaqueStartClientRegistrationOutput *return$) noexcept;
+
+::rust::repr::PtrLen cxxbridge1$opaque_finish_client_registration_into(::OpaqueFinishClientRegistrationInput *input, ::rust::Slice<::std::uint8_t> out, ::OpaqueFinishClientRegistrationOutput *return$) noexcept;
+
+::rust::repr::PtrLen cxxbridge1$opaque_start_client_login_into(::rust::Str password, ::OpaqueCipherSuite suite, ::rust::Slice<::std::uint8_t> out, ::OpaqueStartClientLoginOutput *return$) noexcept;
+
+::rust::repr::PtrLen cxxbridge1$opaque_finish_client_login_into(::OpaqueFinishClientLoginInput *input, ::rust::Slice<::std::uint8_t> out, ::OpaqueFinishClientLoginOutput *return$) noexcept;
+
+::rust::repr::PtrLen cxxbridge1$opaque_create_server_registration_response_into(::rust::Str server_setup, ::OpaqueCreateServerRegistrationResponseInput *input, ::rust::Slice<::std::uint8_t> out, ::std::size_t *return$) noexcept;
+
+::rust::repr::PtrLen cxxbridge1$opaque_create_server_registration_response_with_setup_into(::ServerSetupHandle const &server_setup, ::OpaqueCreateServerRegistrationResponseInput *input, ::rust::Slice<::std::uint8_t> out, ::std::size_t *return$) noexcept;
+
+::rust::repr::PtrLen cxxbridge1$opaque_start_server_login_into(::rust::Str server_setup, ::OpaqueStartServerLoginInput *input, ::rust::Slice<::std::uint8_t> out, ::OpaqueStartServerLoginOutput *return$) noexcept;
+
+::rust::repr::PtrLen cxxbridge1$opaque_start_server_login_with_setup_into(::ServerSetupHandle const &server_setup, ::OpaqueStartServerLoginInput *input, ::rust::Slice<::std::uint8_t> out, ::OpaqueStartServerLoginOutput *return$) noexcept;
+
+::rust::repr::PtrLen cxxbridge1$opaque_finish_server_login_into(::OpaqueFinishServerLoginInput *input, ::rust::Slice<::std::uint8_t> out, ::std::size_t *return$) noexcept;
+
+void cxxbridge1$opaque_try_finish_client_login_into(::OpaqueFinishClientLoginInput *input, ::rust::Slice<::std::uint8_t> out, ::OpaqueFinishClientLoginOutput &output, ::OpaqueStatus *return$) noexcept;
+
+void cxxbridge1$opaque_try_finish_client_login_context(::ClientLoginContext const &context, ::rust::Str login_response, ::rust::Slice<::std::uint8_t> out, ::OpaqueFinishClientLoginOutput &output, ::OpaqueStatus *return$) noexcept;
+
+void cxxbridge1$opaque_try_start_server_login_into(::rust::Str server_setup, ::OpaqueStartServerLoginInput *input, ::rust::Slice<::std::uint8_t> out, ::OpaqueStartServerLoginOutput &output, ::OpaqueStatus *return$) noexcept;
+
+void cxxbridge1$opaque_try_start_server_login_with_setup_into(::ServerSetupHandle const &server_setup, ::OpaqueStartServerLoginInput *input, ::rust::Slice<::std::uint8_t> out, ::OpaqueStartServerLoginOutput &output, ::OpaqueStatus *return$) noexcept;
+
+void cxxbridge1$opaque_try_finish_server_login_into(::OpaqueFinishServerLoginInput *input, ::rust::Slice<::std::uint8_t> out, ::std::size_t &session_key, ::OpaqueStatus *return$) noexcept;
+
+void cxxbridge1$opaque_try_start_server_login_session(::ServerLoginSessionStore const &store, ::ServerSetupHandle const &server_setup, ::OpaqueStartServerLoginParams *params, ::rust::Slice<::std::uint8_t> out, ::OpaqueStartServerLoginSessionResult &result, ::OpaqueStatus *return$) noexcept;
+
+void cxxbridge1$opaque_try_finish_server_login_session(::ServerLoginSessionStore const &store, ::rust::Str session_handle, ::rust::Str finish_login_request, ::rust::Slice<::std::uint8_t> out, ::OpaqueFinishServerLoginResult &result, ::OpaqueStatus *return$) noexcept;
+
+void cxxbridge1$opaque_try_start_server_login_binary(::rust::Slice<::std::uint8_t const> server_setup, ::rust::Slice<::std::uint8_t const> registration_record, bool has_registration_record, ::rust::Slice<::std::uint8_t const> start_login_request, ::rust::Str user_identifier, ::rust::Vec<::rust::String> *client_identifier, ::rust::Vec<::rust::String> *server_identifier, ::OpaqueCipherSuite suite, ::rust::Slice<::std::uint8_t> out, ::OpaqueStartServerLoginBinaryResult &result, ::OpaqueStatus *return$) noexcept;
+
+void cxxbridge1$opaque_try_start_server_login_with_setup_binary(::ServerSetupHandle const &server_setup, ::rust::Slice<::std::uint8_t const> registration_record, bool has_registration_record, ::rust::Slice<::std::uint8_t const> start_login_request, ::rust::Str user_identifier, ::rust::Vec<::rust::String> *client_identifier, ::rust::Vec<::rust::String> *server_identifier, ::rust::Slice<::std::uint8_t> out, ::OpaqueStartServerLoginBinaryResult &result, ::OpaqueStatus *return$) noexcept;
+
+void cxxbridge1$opaque_try_finish_server_login_binary(::rust::Slice<::std::uint8_t const> server_login_state, ::rust::Slice<::std::uint8_t const> finish_login_request, ::OpaqueCipherSuite suite, ::rust::Slice<::std::uint8_t> out, ::OpaqueFinishServerLoginBinaryResult &result, ::OpaqueStatus *return$) noexcept;
+
+void cxxbridge1$opaque_try_finish_client_login_binary(::rust::Slice<::std::uint8_t const> client_login_state, ::rust::Slice<::std::uint8_t const> login_response, ::rust::Str password, ::rust::Vec<::rust::String> *client_identifier, ::rust::Vec<::rust::String> *server_identifier, ::rust::Vec<::OpaqueKeyStretchingParams> *key_stretching, ::OpaqueCipherSuite suite, ::rust::Slice<::std::uint8_t> out, ::OpaqueFinishClientLoginBinaryResult &result, ::OpaqueStatus *return$) noexcept;
+
+void cxxbridge1$opaque_set_metrics_enabled(bool enabled) noexcept;
+
+void cxxbridge1$opaque_get_metrics(::rust::Vec<::OpaqueMetricsEntry> *return$) noexcept;
+
+void cxxbridge1$opaque_reset_metrics() noexcept;
+
+void cxxbridge1$opaque_metrics_begin(::OpaqueMetricsFunction function) noexcept;
+
+void cxxbridge1$opaque_metrics_end() noexcept;
+} // extern "C"
+
+::std::size_t ServerSetupHandle::layout::size() noexcept {
+  return cxxbridge1$ServerSetupHandle$operator$sizeof();
+}
+
+::std::size_t ServerSetupHandle::layout::align() noexcept {
+  return cxxbridge1$ServerSetupHandle$operator$alignof();
+}
+
+::std::size_t ClientLoginContext::layout::size() noexcept {
+  return cxxbridge1$ClientLoginContext$operator$sizeof();
+}
+
+::std::size_t ClientLoginContext::layout::align() noexcept {
+  return cxxbridge1$ClientLoginContext$operator$alignof();
+}
+
+::std::size_t ServerLoginSessionStore::layout::size() noexcept {
+  return cxxbridge1$ServerLoginSessionStore$operator$sizeof();
+}
+
+::std::size_t ServerLoginSessionStore::layout::align() noexcept {
+  return cxxbridge1$ServerLoginSessionStore$operator$alignof();
+}
+
+::OpaqueStartClientRegistrationResult opaque_start_client_registration(::OpaqueStartClientRegistrationParams params) {
+  ::rust::ManuallyDrop<::OpaqueStartClientRegistrationParams> params$(::std::move(params));
+  ::rust::MaybeUninit<::OpaqueStartClientRegistrationResult> return$;
+  ::rust::repr::PtrLen error$ = cxxbridge1$opaque_start_client_registration(&params$.value, &return$.value);
+  if (error$.ptr) {
+    throw ::rust::impl<::rust::Error>::error(error$);
+  }
+  return ::std::move(return$.value);
+}
+
+::OpaqueFinishClientRegistrationResult opaque_finish_client_registration(::OpaqueFinishClientRegistrationParams params) {
+  ::rust::ManuallyDrop<::OpaqueFinishClientRegistrationParams> params$(::std::move(params));
+  ::rust::MaybeUninit<::OpaqueFinishClientRegistrationResult> return$;
+  ::rust::repr::PtrLen error$ = cxxbridge1$opaque_finish_client_registration(&params$.value, &return$.value);
+  if (error$.ptr) {
+    throw ::rust::impl<::rust::Error>::error(error$);
+  }
+  return ::std::move(return$.value);
+}
+
+::OpaqueStartClientLoginResult opaque_start_client_login(::OpaqueStartClientLoginParams params) {
+  ::rust::ManuallyDrop<::OpaqueStartClientLoginParams> params$(::std::move(params));
+  ::rust::MaybeUninit<::OpaqueStartClientLoginResult> return$;
+  ::rust::repr::PtrLen error$ = cxxbridge1$opaque_start_client_login(&params$.value, &return$.value);
+  if (error$.ptr) {
+    throw ::rust::impl<::rust::Error>::error(error$);
+  }
+  return ::std::move(return$.value);
+}
+
+::std::unique_ptr<::OpaqueFinishClientLoginResult> opaque_finish_client_login(::OpaqueFinishClientLoginParams params) {
+  ::rust::ManuallyDrop<::OpaqueFinishClientLoginParams> params$(::std::move(params));
+  ::rust::MaybeUninit<::std::unique_ptr<::OpaqueFinishClientLoginResult>> return$;
+  ::rust::repr::PtrLen error$ = cxxbridge1$opaque_finish_client_login(&params$.value, &return$.value);
+  if (error$.ptr) {
+    throw ::rust::impl<::rust::Error>::error(error$);
+  }
+  return ::std::move(return$.value);
+}
+
+::rust::Box<::ClientLoginContext> opaque_start_client_login_context(::OpaqueStartClientLoginContextInput input, ::rust::String &start_login_request) {
+  ::rust::ManuallyDrop<::OpaqueStartClientLoginContextInput> input$(::std::move(input));
+  ::rust::MaybeUninit<::rust::Box<::ClientLoginContext>> return$;
+  ::rust::repr::PtrLen error$ = cxxbridge1$opaque_start_client_login_context(&input$.value, start_login_request, &return$.value);
+  if (error$.ptr) {
+    throw ::rust::impl<::rust::Error>::error(error$);
+  }
+  return ::std::move(return$.value);
+}
+
+::OpaqueFinishClientLoginOutput opaque_finish_client_login_context(::ClientLoginContext const &context, ::rust::Str login_response, ::rust::Slice<::std::uint8_t> out) {
+  ::rust::MaybeUninit<::OpaqueFinishClientLoginOutput> return$;
+  ::rust::repr::PtrLen error$ = cxxbridge1$opaque_finish_client_login_context(context, login_response, out, &return$.value);
+  if (error$.ptr) {
+    throw ::rust::impl<::rust::Error>::error(error$);
+  }
+  return ::std::move(return$.value);
+}
+
+::OpaqueKeyStretchingParams opaque_calibrate_key_stretching(::std::uint32_t target_duration_ms, ::std::uint32_t parallelism) {
+  ::rust::MaybeUninit<::OpaqueKeyStretchingParams> return$;
+  ::rust::repr::PtrLen error$ = cxxbridge1$opaque_calibrate_key_stretching(target_duration_ms, parallelism, &return$.value);
+  if (error$.ptr) {
+    throw ::rust::impl<::rust::Error>::error(error$);
+  }
+  return ::std::move(return$.value);
+}
+
+void opaque_prewarm_key_stretching(::rust::Vec<::OpaqueKeyStretchingParams> key_stretching) {
+  ::rust::repr::PtrLen error$ = cxxbridge1$opaque_prewarm_key_stretching(&key_stretching);
+  if (error$.ptr) {
+    throw ::rust::impl<::rust::Error>::error(error$);
+  }
+}
+
+void opaque_check_key_stretching(::rust::Vec<::OpaqueKeyStretchingParams> key_stretching) {
+  ::rust::repr::PtrLen error$ = cxxbridge1$opaque_check_key_stretching(&key_stretching);
+  if (error$.ptr) {
+    throw ::rust::impl<::rust::Error>::error(error$);
+  }
+}
+
+void opaque_prepare_client_login_finish(::rust::Vec<::OpaqueKeyStretchingParams> key_stretching) {
+  ::rust::repr::PtrLen error$ = cxxbridge1$opaque_prepare_client_login_finish(&key_stretching);
+  if (error$.ptr) {
+    throw ::rust::impl<::rust::Error>::error(error$);
+  }
+}
+
+void opaque_release_key_stretching_memory() noexcept {
+  cxxbridge1$opaque_release_key_stretching_memory();
+}
+
+void opaque_trim_key_stretching_memory() noexcept {
+  cxxbridge1$opaque_trim_key_stretching_memory();
+}
+
+::OpaqueCpuTopology opaque_get_cpu_topology() noexcept {
+  ::rust::MaybeUninit<::OpaqueCpuTopology> return$;
+  cxxbridge1$opaque_get_cpu_topology(&return$.value);
+  return ::std::move(return$.value);
+}
+
+::rust::String opaque_create_server_setup(::OpaqueCipherSuite suite) {
+  ::rust::MaybeUninit<::rust::String> return$;
+  ::rust::repr::PtrLen error$ = cxxbridge1$opaque_create_server_setup(suite, &return$.value);
+  if (error$.ptr) {
+    throw ::rust::impl<::rust::Error>::error(error$);
+  }
+  return ::std::move(return$.value);
+}
+
+::rust::Box<::ServerSetupHandle> opaque_create_server_setup_handle(::rust::String data, ::OpaqueCipherSuite suite) {
+  ::rust::MaybeUninit<::rust::Box<::ServerSetupHandle>> return$;
+  ::rust::repr::PtrLen error$ = cxxbridge1$opaque_create_server_setup_handle(&data, suite, &return$.value);
+  if (error$.ptr) {
+    throw ::rust::impl<::rust::Error>::error(error$);
+  }
+  return ::std::move(return$.value);
+}
+
+::rust::String opaque_get_server_public_key(::rust::String data, ::OpaqueCipherSuite suite) {
+  ::rust::MaybeUninit<::rust::String> return$;
+  ::rust::repr::PtrLen error$ = cxxbridge1$opaque_get_server_public_key(&data, suite, &return$.value);
+  if (error$.ptr) {
+    throw ::rust::impl<::rust::Error>::error(error$);
+  }
+  return ::std::move(return$.value);
+}
+
+::rust::String opaque_get_server_public_key_with_setup(::ServerSetupHandle const &server_setup) noexcept {
+  ::rust::MaybeUninit<::rust::String> return$;
+  cxxbridge1$opaque_get_server_public_key_with_setup(server_setup, &return$.value);
+  return ::std::move(return$.value);
+}
+
+::OpaqueCreateServerRegistrationResponseResult opaque_create_server_registration_response(::rust::String server_setup, ::OpaqueCreateServerRegistrationResponseParams params) {
+  ::rust::ManuallyDrop<::OpaqueCreateServerRegistrationResponseParams> params$(::std::move(params));
+  ::rust::MaybeUninit<::OpaqueCreateServerRegistrationResponseResult> return$;
+  ::rust::repr::PtrLen error$ = cxxbridge1$opaque_create_server_registration_response(&server_setup, &params$.value, &return$.value);
+  if (error$.ptr) {
+    throw ::rust::impl<::rust::Error>::error(error$);
+  }
+  return ::std::move(return$.value);
+}
+
+::OpaqueCreateServerRegistrationResponseResult opaque_create_server_registration_response_with_setup(::ServerSetupHandle const &server_setup, ::OpaqueCreateServerRegistrationResponseParams params) {
+  ::rust::ManuallyDrop<::OpaqueCreateServerRegistrationResponseParams> params$(::std::move(params));
+  ::rust::MaybeUninit<::OpaqueCreateServerRegistrationResponseResult> return$;
+  ::rust::repr::PtrLen error$ = cxxbridge1$opaque_create_server_registration_response_with_setup(server_setup, &params$.value, &return$.value);
+  if (error$.ptr) {
+    throw ::rust::impl<::rust::Error>::error(error$);
+  }
+  return ::std::move(return$.value);
+}
+
+::OpaqueStartServerLoginResult opaque_start_server_login(::rust::String server_setup, ::OpaqueStartServerLoginParams params) {
+  ::rust::ManuallyDrop<::OpaqueStartServerLoginParams> params$(::std::move(params));
+  ::rust::MaybeUninit<::OpaqueStartServerLoginResult> return$;
+  ::rust::repr::PtrLen error$ = cxxbridge1$opaque_start_server_login(&server_setup, &params$.value, &return$.value);
+  if (error$.ptr) {
+    throw ::rust::impl<::rust::Error>::error(error$);
+  }
+  return ::std::move(return$.value);
+}
+
+::OpaqueStartServerLoginResult opaque_start_server_login_with_setup(::ServerSetupHandle const &server_setup, ::OpaqueStartServerLoginParams params) {
+  ::rust::ManuallyDrop<::OpaqueStartServerLoginParams> params$(::std::move(params));
+  ::rust::MaybeUninit<::OpaqueStartServerLoginResult> return$;
+  ::rust::repr::PtrLen error$ = cxxbridge1$opaque_start_server_login_with_setup(server_setup, &params$.value, &return$.value);
+  if (error$.ptr) {
+    throw ::rust::impl<::rust::Error>::error(error$);
+  }
+  return ::std::move(return$.value);
+}
+
+::rust::Vec<::OpaqueStartServerLoginBatchResult> opaque_start_server_login_batch(::ServerSetupHandle const &server_setup, ::rust::Vec<::OpaqueStartServerLoginParams> requests) noexcept {
+  ::rust::MaybeUninit<::rust::Vec<::OpaqueStartServerLoginBatchResult>> return$;
+  cxxbridge1$opaque_start_server_login_batch(server_setup, &requests, &return$.value);
+  return ::std::move(return$.value);
+}
+
+::std::uint64_t opaque_count_registration_import_records(::rust::Slice<::std::uint8_t const> records) {
+  ::rust::MaybeUninit<::std::uint64_t> return$;
+  ::rust::repr::PtrLen error$ = cxxbridge1$opaque_count_registration_import_records(records, &return$.value);
+  if (error$.ptr) {
+    throw ::rust::impl<::rust::Error>::error(error$);
+  }
+  return ::std::move(return$.value);
+}
+
+::OpaqueRegistrationImportChunk opaque_create_server_registration_responses_chunk(::ServerSetupHandle const &server_setup, ::rust::Slice<::std::uint8_t const> records, ::std::size_t max_records) {
+  ::rust::MaybeUninit<::OpaqueRegistrationImportChunk> return$;
+  ::rust::repr::PtrLen error$ = cxxbridge1$opaque_create_server_registration_responses_chunk(server_setup, records, max_records, &return$.value);
+  if (error$.ptr) {
+    throw ::rust::impl<::rust::Error>::error(error$);
+  }
+  return ::std::move(return$.value);
+}
+
+::rust::Box<::ServerLoginSessionStore> opaque_create_server_login_session_store(::std::uint32_t ttl_ms, ::std::size_t max_memory_bytes) {
+  ::rust::MaybeUninit<::rust::Box<::ServerLoginSessionStore>> return$;
+  ::rust::repr::PtrLen error$ = cxxbridge1$opaque_create_server_login_session_store(ttl_ms, max_memory_bytes, &return$.value);
+  if (error$.ptr) {
+    throw ::rust::impl<::rust::Error>::error(error$);
+  }
+  return ::std::move(return$.value);
+}
+
+::std::size_t opaque_server_login_session_count(::ServerLoginSessionStore const &store) noexcept {
+  return cxxbridge1$opaque_server_login_session_count(store);
+}
+
+::OpaqueStartServerLoginSessionResult opaque_start_server_login_session(::ServerLoginSessionStore const &store, ::ServerSetupHandle const &server_setup, ::OpaqueStartServerLoginParams params) {
+  ::rust::ManuallyDrop<::OpaqueStartServerLoginParams> params$(::std::move(params));
+  ::rust::MaybeUninit<::OpaqueStartServerLoginSessionResult> return$;
+  ::rust::repr::PtrLen error$ = cxxbridge1$opaque_start_server_login_session(store, server_setup, &params$.value, &return$.value);
+  if (error$.ptr) {
+    throw ::rust::impl<::rust::Error>::error(error$);
+  }
+  return ::std::move(return$.value);
+}
+
+::OpaqueFinishServerLoginResult opaque_finish_server_login_session(::ServerLoginSessionStore const &store, ::rust::Str session_handle, ::rust::Str finish_login_request) {
+  ::rust::MaybeUninit<::OpaqueFinishServerLoginResult> return$;
+  ::rust::repr::PtrLen error$ = cxxbridge1$opaque_finish_server_login_session(store, session_handle, finish_login_request, &return$.value);
+  if (error$.ptr) {
+    throw ::rust::impl<::rust::Error>::error(error$);
+  }
+  return ::std::move(return$.value);
+}
+
+::OpaqueFinishServerLoginResult opaque_finish_server_login(::OpaqueFinishServerLoginParams params) {
+  ::rust::ManuallyDrop<::OpaqueFinishServerLoginParams> params$(::std::move(params));
+  ::rust::MaybeUninit<::OpaqueFinishServerLoginResult> return$;
+  ::rust::repr::PtrLen error$ = cxxbridge1$opaque_finish_server_login(&params$.value, &return$.value);
+  if (error$.ptr) {
+    throw ::rust::impl<::rust::Error>::error(error$);
+  }
+  return ::std::move(return$.value);
+}
+
+::OpaqueStartClientRegistrationBinaryResult opaque_start_client_registration_binary(::rust::Str password, ::OpaqueCipherSuite suite) {
+  ::rust::MaybeUninit<::OpaqueStartClientRegistrationBinaryResult> return$;
+  ::rust::repr::PtrLen error$ = cxxbridge1$opaque_start_client_registration_binary(password, suite, &return$.value);
+  if (error$.ptr) {
+    throw ::rust::impl<::rust::Error>::error(error$);
+  }
+  return ::std::move(return$.value);
+}
+
+::OpaqueFinishClientRegistrationBinaryResult opaque_finish_client_registration_binary(::rust::Str password, ::rust::Slice<::std::uint8_t const> registration_response, ::rust::Slice<::std::uint8_t const> client_registration_state, ::rust::Vec<::rust::String> client_identifier, ::rust::Vec<::rust::String> server_identifier, ::rust::Vec<::OpaqueKeyStretchingParams> key_stretching, ::OpaqueCipherSuite suite) {
+  ::rust::MaybeUninit<::OpaqueFinishClientRegistrationBinaryResult> return$;
+  ::rust::repr::PtrLen error$ = cxxbridge1$opaque_finish_client_registration_binary(password, registration_response, client_registration_state, &client_identifier, &server_identifier, &key_stretching, suite, &return$.value);
+  if (error$.ptr) {
+    throw ::rust::impl<::rust::Error>::error(error$);
+  }
+  return ::std::move(return$.value);
+}
+
+::OpaqueStartClientLoginBinaryResult opaque_start_client_login_binary(::rust::Str password, ::OpaqueCipherSuite suite) {
+  ::rust::MaybeUninit<::OpaqueStartClientLoginBinaryResult> return$;
+  ::rust::repr::PtrLen error$ = cxxbridge1$opaque_start_client_login_binary(password, suite, &return$.value);
+  if (error$.ptr) {
+    throw ::rust::impl<::rust::Error>::error(error$);
+  }
+  return ::std::move(return$.value);
+}
+
+::std::unique_ptr<::OpaqueFinishClientLoginBinaryResult> opaque_finish_client_login_binary(::rust::Slice<::std::uint8_t const> client_login_state, ::rust::Slice<::std::uint8_t const> login_response, ::rust::Str password, ::rust::Vec<::rust::String> client_identifier, ::rust::Vec<::rust::String> server_identifier, ::rust::Vec<::OpaqueKeyStretchingParams> key_stretching, ::OpaqueCipherSuite suite) {
+  ::rust::MaybeUninit<::std::unique_ptr<::OpaqueFinishClientLoginBinaryResult>> return$;
+  ::rust::repr::PtrLen error$ = cxxbridge1$opaque_finish_client_login_binary(client_login_state, login_response, password, &client_identifier, &server_identifier, &key_stretching, suite, &return$.value);
+  if (error$.ptr) {
+    throw ::rust::impl<::rust::Error>::error(error$);
+  }
+  return ::std::move(return$.value);
+}
+
+::rust::Vec<::std::uint8_t> opaque_create_server_setup_binary(::OpaqueCipherSuite suite) {
+  ::rust::MaybeUninit<::rust::Vec<::std::uint8_t>> return$;
+  ::rust::repr::PtrLen error$ = cxxbridge1$opaque_create_server_setup_binary(suite, &return$.value);
+  if (error$.ptr) {
+    throw ::rust::impl<::rust::Error>::error(error$);
+  }
+  return ::std::move(return$.value);
+}
+
+::rust::Box<::ServerSetupHandle> opaque_create_server_setup_handle_binary(::rust::Slice<::std::uint8_t const> data, ::OpaqueCipherSuite suite) {
+  ::rust::MaybeUninit<::rust::Box<::ServerSetupHandle>> return$;
+  ::rust::repr::PtrLen error$ = cxxbridge1$opaque_create_server_setup_handle_binary(data, suite, &return$.value);
+  if (error$.ptr) {
+    throw ::rust::impl<::rust::Error>::error(error$);
+  }
+  return ::std::move(return$.value);
+}
+
+::rust::Vec<::std::uint8_t> opaque_get_server_public_key_binary(::rust::Slice<::std::uint8_t const> data, ::OpaqueCipherSuite suite) {
+  ::rust::MaybeUninit<::rust::Vec<::std::uint8_t>> return$;
+  ::rust::repr::PtrLen error$ = cxxbridge1$opaque_get_server_public_key_binary(data, suite, &return$.value);
+  if (error$.ptr) {
+    throw ::rust::impl<::rust::Error>::error(error$);
+  }
+  return ::std::move(return$.value);
+}
+
+::rust::Vec<::std::uint8_t> opaque_get_server_public_key_with_setup_binary(::ServerSetupHandle const &server_setup) noexcept {
+  ::rust::MaybeUninit<::rust::Vec<::std::uint8_t>> return$;
+  cxxbridge1$opaque_get_server_public_key_with_setup_binary(server_setup, &return$.value);
+  return ::std::move(return$.value);
+}
+
+void opaque_check_server_setup_suite(::ServerSetupHandle const &server_setup, ::OpaqueCipherSuite suite) {
+  ::rust::repr::PtrLen error$ = cxxbridge1$opaque_check_server_setup_suite(server_setup, suite);
+  if (error$.ptr) {
+    throw ::rust::impl<::rust::Error>::error(error$);
+  }
+}
+
+::OpaqueCreateServerRegistrationResponseBinaryResult opaque_create_server_registration_response_binary(::rust::Slice<::std::uint8_t const> server_setup, ::rust::Str user_identifier, ::rust::Slice<::std::uint8_t const> registration_request, ::OpaqueCipherSuite suite) {
+  ::rust::MaybeUninit<::OpaqueCreateServerRegistrationResponseBinaryResult> return$;
+  ::rust::repr::PtrLen error$ = cxxbridge1$opaque_create_server_registration_response_binary(server_setup, user_identifier, registration_request, suite, &return$.value);
+  if (error$.ptr) {
+    throw ::rust::impl<::rust::Error>::error(error$);
+  }
+  return ::std::move(return$.value);
+}
+
+::OpaqueCreateServerRegistrationResponseBinaryResult opaque_create_server_registration_response_with_setup_binary(::ServerSetupHandle const &server_setup, ::rust::Str user_identifier, ::rust::Slice<::std::uint8_t const> registration_request) {
+  ::rust::MaybeUninit<::OpaqueCreateServerRegistrationResponseBinaryResult> return$;
+  ::rust::repr::PtrLen error$ = cxxbridge1$opaque_create_server_registration_response_with_setup_binary(server_setup, user_identifier, registration_request, &return$.value);
+  if (error$.ptr) {
+    throw ::rust::impl<::rust::Error>::error(error$);
+  }
+  return ::std::move(return$.value);
+}
+
+::OpaqueStartServerLoginBinaryResult opaque_start_server_login_binary(::rust::Slice<::std::uint8_t const> server_setup, ::rust::Slice<::std::uint8_t const> registration_record, bool has_registration_record, ::rust::Slice<::std::uint8_t const> start_login_request, ::rust::Str user_identifier, ::rust::Vec<::rust::String> client_identifier, ::rust::Vec<::rust::String> server_identifier, ::OpaqueCipherSuite suite) {
+  ::rust::MaybeUninit<::OpaqueStartServerLoginBinaryResult> return$;
+  ::rust::repr::PtrLen error$ = cxxbridge1$opaque_start_server_login_binary(server_setup, registration_record, has_registration_record, start_login_request, user_identifier, &client_identifier, &server_identifier, suite, &return$.value);
+  if (error$.ptr) {
+    throw ::rust::impl<::rust::Error>::error(error$);
+  }
+  return ::std::move(return$.value);
+}
+
+::OpaqueStartServerLoginBinaryResult opaque_start_server_login_with_setup_binary(::ServerSetupHandle const &server_setup, ::rust::Slice<::std::uint8_t const> registration_record, bool has_registration_record, ::rust::Slice<::std::uint8_t const> start_login_request, ::rust::Str user_identifier, ::rust::Vec<::rust::String> client_identifier, ::rust::Vec<::rust::String> server_identifier) {
+  ::rust::MaybeUninit<::OpaqueStartServerLoginBinaryResult> return$;
+  ::rust::repr::PtrLen error$ = cxxbridge1$opaque_start_server_login_with_setup_binary(server_setup, registration_record, has_registration_record, start_login_request, user_identifier, &client_identifier, &server_identifier, &return$.value);
+  if (error$.ptr) {
+    throw ::rust::impl<::rust::Error>::error(error$);
+  }
+  return ::std::move(return$.value);
+}
+
+::OpaqueFinishServerLoginBinaryResult opaque_finish_server_login_binary(::rust::Slice<::std::uint8_t const> server_login_state, ::rust::Slice<::std::uint8_t const> finish_login_request, ::OpaqueCipherSuite suite) {
+  ::rust::MaybeUninit<::OpaqueFinishServerLoginBinaryResult> return$;
+  ::rust::repr::PtrLen error$ = cxxbridge1$opaque_finish_server_login_binary(server_login_state, finish_login_request, suite, &return$.value);
+  if (error$.ptr) {
+    throw ::rust::impl<::rust::Error>::error(error$);
+  }
+  return ::std::move(return$.value);
+}
+
+::OpaqueStartClientRegistrationOutput opaque_start_client_registration_into(::rust::Str password, ::OpaqueCipherSuite suite, ::rust::Slice<::std::uint8_t> out) {
+  ::rust::MaybeUninit<::OpaqueStartClientRegistrationOutput> return$;
+  ::rust::repr::PtrLen error$ = cxxbridge1$opaque_start_client_registration_into(password, suite, out, &return$.value);
+  if (error$.ptr) {
+    throw ::rust::impl<::rust::Error>::error(error$);
+  }
+  return ::std::move(return$.value);
+}
+
+::OpaqueFinishClientRegistrationOutput opaque_finish_client_registration_into(::OpaqueFinishClientRegistrationInput input, ::rust::Slice<::std::uint8_t> out) {
+  ::rust::ManuallyDrop<::OpaqueFinishClientRegistrationInput> input$(::std::move(input));
+  ::rust::MaybeUninit<::OpaqueFinishClientRegistrationOutput> return$;
+  ::rust::repr::PtrLen error$ = cxxbridge1$opaque_finish_client_registration_into(&input$.value, out, &return$.value);
+  if (error$.ptr) {
+    throw ::rust::impl<::rust::Error>::error(error$);
+  }
+  return ::std::move(return$.value);
+}
+
+::OpaqueStartClientLoginOutput opaque_start_client_login_into(::rust::Str password, ::OpaqueCipherSuite suite, ::rust::Slice<::std::uint8_t> out) {
+  ::rust::MaybeUninit<::OpaqueStartClientLoginOutput> return$;
+  ::rust::repr::PtrLen error$ = cxxbridge1$opaque_start_client_login_into(password, suite, out, &return$.value);
+  if (error$.ptr) {
+    throw ::rust::impl<::rust::Error>::error(error$);
+  }
+  return ::std::move(return$.value);
+}
+
+::OpaqueFinishClientLoginOutput opaque_finish_client_login_into(::OpaqueFinishClientLoginInput input, ::rust::Slice<::std::uint8_t> out) {
+  ::rust::ManuallyDrop<::OpaqueFinishClientLoginInput> input$(::std::move(input));
+  ::rust::MaybeUninit<::OpaqueFinishClientLoginOutput> return$;
+  ::rust::repr::PtrLen error$ = cxxbridge1$opaque_finish_client_login_into(&input$.value, out, &return$.value);
+  if (error$.ptr) {
+    throw ::rust::impl<::rust::Error>::error(error$);
+  }
+  return ::std::move(return$.value);
+}
+
+::std::size_t opaque_create_server_registration_response_into(::rust::Str server_setup, ::OpaqueCreateServerRegistrationResponseInput input, ::rust::Slice<::std::uint8_t> out) {
+  ::rust::ManuallyDrop<::OpaqueCreateServerRegistrationResponseInput> input$(::std::move(input));
+  ::rust::MaybeUninit<::std::size_t> return$;
+  ::rust::repr::PtrLen error$ = cxxbridge1$opaque_create_server_registration_response_into(server_setup, &input$.value, out, &return$.value);
+  if (error$.ptr) {
+    throw ::rust::impl<::rust::Error>::error(error$);
+  }
+  return ::std::move(return$.value);
+}
+
+::std::size_t opaque_create_server_registration_response_with_setup_into(::ServerSetupHandle const &server_setup, ::OpaqueCreateServerRegistrationResponseInput input, ::rust::Slice<::std::uint8_t> out) {
+  ::rust::ManuallyDrop<::OpaqueCreateServerRegistrationResponseInput> input$(::std::move(input));
+  ::rust::MaybeUninit<::std::size_t> return$;
+  ::rust::repr::PtrLen error$ = cxxbridge1$opaque_create_server_registration_response_with_setup_into(server_setup, &input$.value, out, &return$.value);
+  if (error$.ptr) {
+    throw ::rust::impl<::rust::Error>::error(error$);
+  }
+  return ::std::move(return$.value);
+}
+
+::OpaqueStartServerLoginOutput opaque_start_server_login_into(::rust::Str server_setup, ::OpaqueStartServerLoginInput input, ::rust::Slice<::std::uint8_t> out) {
+  ::rust::ManuallyDrop<::OpaqueStartServerLoginInput> input$(::std::move(input));
+  ::rust::MaybeUninit<::OpaqueStartServerLoginOutput> return$;
+  ::rust::repr::PtrLen error$ = cxxbridge1$opaque_start_server_login_into(server_setup, &input$.value, out, &return$.value);
+  if (error$.ptr) {
+    throw ::rust::impl<::rust::Error>::error(error$);
+  }
+  return ::std::move(return$.value);
+}
+
+::OpaqueStartServerLoginOutput opaque_start_server_login_with_setup_into(::ServerSetupHandle const &server_setup, ::OpaqueStartServerLoginInput input, ::rust::Slice<::std::uint8_t> out) {
+  ::rust::ManuallyDrop<::OpaqueStartServerLoginInput> input$(::std::move(input));
+  ::rust::MaybeUninit<::OpaqueStartServerLoginOutput> return$;
+  ::rust::repr::PtrLen error$ = cxxbridge1$opaque_start_server_login_with_setup_into(server_setup, &input$.value, out, &return$.value);
+  if (error$.ptr) {
+    throw ::rust::impl<::rust::Error>::error(error$);
+  }
+  return ::std::move(return$.value);
+}
+
+::std::size_t opaque_finish_server_login_into(::OpaqueFinishServerLoginInput input, ::rust::Slice<::std::uint8_t> out) {
+  ::rust::ManuallyDrop<::OpaqueFinishServerLoginInput> input$(::std::move(input));
+  ::rust::MaybeUninit<::std::size_t> return$;
+  ::rust::repr::PtrLen error$ = cxxbridge1$opaque_finish_server_login_into(&input$.value, out, &return$.value);
+  if (error$.ptr) {
+    throw ::rust::impl<::rust::Error>::error(error$);
+  }
+  return ::std::move(return$.value);
+}
+
+::OpaqueStatus opaque_try_finish_client_login_into(::OpaqueFinishClientLoginInput input, ::rust::Slice<::std::uint8_t> out, ::OpaqueFinishClientLoginOutput &output) noexcept {
+  ::rust::ManuallyDrop<::OpaqueFinishClientLoginInput> input$(::std::move(input));
+  ::rust::MaybeUninit<::OpaqueStatus> return$;
+  cxxbridge1$opaque_try_finish_client_login_into(&input$.value, out, output, &return$.value);
+  return ::std::move(return$.value);
+}
+
+::OpaqueStatus opaque_try_finish_client_login_context(::ClientLoginContext const &context, ::rust::Str login_response, ::rust::Slice<::std::uint8_t> out, ::OpaqueFinishClientLoginOutput &output) noexcept {
+  ::rust::MaybeUninit<::OpaqueStatus> return$;
+  cxxbridge1$opaque_try_finish_client_login_context(context, login_response, out, output, &return$.value);
+  return ::std::move(return$.value);
+}
+
+::OpaqueStatus opaque_try_start_server_login_into(::rust::Str server_setup, ::OpaqueStartServerLoginInput input, ::rust::Slice<::std::uint8_t> out, ::OpaqueStartServerLoginOutput &output) noexcept {
+  ::rust::ManuallyDrop<::OpaqueStartServerLoginInput> input$(::std::move(input));
+  ::rust::MaybeUninit<::OpaqueStatus> return$;
+  cxxbridge1$opaque_try_start_server_login_into(server_setup, &input$.value, out, output, &return$.value);
+  return ::std::move(return$.value);
+}
+
+::OpaqueStatus opaque_try_start_server_login_with_setup_into(::ServerSetupHandle const &server_setup, ::OpaqueStartServerLoginInput input, ::rust::Slice<::std::uint8_t> out, ::OpaqueStartServerLoginOutput &output) noexcept {
+  ::rust::ManuallyDrop<::OpaqueStartServerLoginInput> input$(::std::move(input));
+  ::rust::MaybeUninit<::OpaqueStatus> return$;
+  cxxbridge1$opaque_try_start_server_login_with_setup_into(server_setup, &input$.value, out, output, &return$.value);
+  return ::std::move(return$.value);
+}
+
+::OpaqueStatus opaque_try_finish_server_login_into(::OpaqueFinishServerLoginInput input, ::rust::Slice<::std::uint8_t> out, ::std::size_t &session_key) noexcept {
+  ::rust::ManuallyDrop<::OpaqueFinishServerLoginInput> input$(::std::move(input));
+  ::rust::MaybeUninit<::OpaqueStatus> return$;
+  cxxbridge1$opaque_try_finish_server_login_into(&input$.value, out, session_key, &return$.value);
+  return ::std::move(return$.value);
+}
+
+::OpaqueStatus opaque_try_start_server_login_session(::ServerLoginSessionStore const &store, ::ServerSetupHandle const &server_setup, ::OpaqueStartServerLoginParams params, ::rust::Slice<::std::uint8_t> out, ::OpaqueStartServerLoginSessionResult &result) noexcept {
+  ::rust::ManuallyDrop<::OpaqueStartServerLoginParams> params$(::std::move(params));
+  ::rust::MaybeUninit<::OpaqueStatus> return$;
+  cxxbridge1$opaque_try_start_server_login_session(store, server_setup, &params$.value, out, result, &return$.value);
+  return ::std::move(return$.value);
+}
+
+::OpaqueStatus opaque_try_finish_server_login_session(::ServerLoginSessionStore const &store, ::rust::Str session_handle, ::rust::Str finish_login_request, ::rust::Slice<::std::uint8_t> out, ::OpaqueFinishServerLoginResult &result) noexcept {
+  ::rust::MaybeUninit<::OpaqueStatus> return$;
+  cxxbridge1$opaque_try_finish_server_login_session(store, session_handle, finish_login_request, out, result, &return$.value);
+  return ::std::move(return$.value);
+}
+
+::OpaqueStatus opaque_try_start_server_login_binary(::rust::Slice<::std::uint8_t const> server_setup, ::rust::Slice<::std::uint8_t const> registration_record, bool has_registration_record, ::rust::Slice<::std::uint8_t const> start_login_request, ::rust::Str user_identifier, ::rust::Vec<::rust::String> client_identifier, ::rust::Vec<::rust::String> server_identifier, ::OpaqueCipherSuite suite, ::rust::Slice<::std::uint8_t> out, ::OpaqueStartServerLoginBinaryResult &result) noexcept {
+  ::rust::MaybeUninit<::OpaqueStatus> return$;
+  cxxbridge1$opaque_try_start_server_login_binary(server_setup, registration_record, has_registration_record, start_login_request, user_identifier, &client_identifier, &server_identifier, suite, out, result, &return$.value);
+  return ::std::move(return$.value);
+}
+
+::OpaqueStatus opaque_try_start_server_login_with_setup_binary(::ServerSetupHandle const &server_setup, ::rust::Slice<::std::uint8_t const> registration_record, bool has_registration_record, ::rust::Slice<::std::uint8_t const> start_login_request, ::rust::Str user_identifier, ::rust::Vec<::rust::String> client_identifier, ::rust::Vec<::rust::String> server_identifier, ::rust::Slice<::std::uint8_t> out, ::OpaqueStartServerLoginBinaryResult &result) noexcept {
+  ::rust::MaybeUninit<::OpaqueStatus> return$;
+  cxxbridge1$opaque_try_start_server_login_with_setup_binary(server_setup, registration_record, has_registration_record, start_login_request, user_identifier, &client_identifier, &server_identifier, out, result, &return$.value);
+  return ::std::move(return$.value);
+}
+
+::OpaqueStatus opaque_try_finish_server_login_binary(::rust::Slice<::std::uint8_t const> server_login_state, ::rust::Slice<::std::uint8_t const> finish_login_request, ::OpaqueCipherSuite suite, ::rust::Slice<::std::uint8_t> out, ::OpaqueFinishServerLoginBinaryResult &result) noexcept {
+  ::rust::MaybeUninit<::OpaqueStatus> return$;
+  cxxbridge1$opaque_try_finish_server_login_binary(server_login_state, finish_login_request, suite, out, result, &return$.value);
+  return ::std::move(return$.value);
+}
+
+::OpaqueStatus opaque_try_finish_client_login_binary(::rust::Slice<::std::uint8_t const> client_login_state, ::rust::Slice<::std::uint8_t const> login_response, ::rust::Str password, ::rust::Vec<::rust::String> client_identifier, ::rust::Vec<::rust::String> server_identifier, ::rust::Vec<::OpaqueKeyStretchingParams> key_stretching, ::OpaqueCipherSuite suite, ::rust::Slice<::std::uint8_t> out, ::OpaqueFinishClientLoginBinaryResult &result) noexcept {
+  ::rust::MaybeUninit<::OpaqueStatus> return$;
+  cxxbridge1$opaque_try_finish_client_login_binary(client_login_state, login_response, password, &client_identifier, &server_identifier, &key_stretching, suite, out, result, &return$.value);
+  return ::std::move(return$.value);
+}
+
+void opaque_set_metrics_enabled(bool enabled) noexcept {
+  cxxbridge1$opaque_set_metrics_enabled(enabled);
+}
+
+::rust::Vec<::OpaqueMetricsEntry> opaque_get_metrics() noexcept {
+  ::rust::MaybeUninit<::rust::Vec<::OpaqueMetricsEntry>> return$;
+  cxxbridge1$opaque_get_metrics(&return$.value);
+  return ::std::move(return$.value);
+}
+
+void opaque_reset_metrics() noexcept {
+  cxxbridge1$opaque_reset_metrics();
+}
+
+void opaque_metrics_begin(::OpaqueMetricsFunction function) noexcept {
+  cxxbridge1$opaque_metrics_begin(function);
+}
+
+void opaque_metrics_end() noexcept {
+  cxxbridge1$opaque_metrics_end();
+}
+
+extern "C" {
+::ServerSetupHandle *cxxbridge1$box$ServerSetupHandle$alloc() noexcept;
+void cxxbridge1$box$ServerSetupHandle$dealloc(::ServerSetupHandle *) noexcept;
+void cxxbridge1$box$ServerSetupHandle$drop(::rust::Box<::ServerSetupHandle> *ptr) noexcept;
+
+::ClientLoginContext *cxxbridge1$box$ClientLoginContext$alloc() noexcept;
+void cxxbridge1$box$ClientLoginContext$dealloc(::ClientLoginContext *) noexcept;
+void cxxbridge1$box$ClientLoginContext$drop(::rust::Box<::ClientLoginContext> *ptr) noexcept;
+
+::ServerLoginSessionStore *cxxbridge1$box$ServerLoginSessionStore$alloc() noexcept;
+void cxxbridge1$box$ServerLoginSessionStore$dealloc(::ServerLoginSessionStore *) noexcept;
+void cxxbridge1$box$ServerLoginSessionStore$drop(::rust::Box<::ServerLoginSessionStore> *ptr) noexcept;
+
+void cxxbridge1$rust_vec$OpaqueKeyStretchingParams$new(::rust::Vec<::OpaqueKeyStretchingParams> const *ptr) noexcept;
+void cxxbridge1$rust_vec$OpaqueKeyStretchingParams$drop(::rust::Vec<::OpaqueKeyStretchingParams> *ptr) noexcept;
+::std::size_t cxxbridge1$rust_vec$OpaqueKeyStretchingParams$len(::rust::Vec<::OpaqueKeyStretchingParams> const *ptr) noexcept;
+::std::size_t cxxbridge1$rust_vec$OpaqueKeyStretchingParams$capacity(::rust::Vec<::OpaqueKeyStretchingParams> const *ptr) noexcept;
+::OpaqueKeyStretchingParams const *cxxbridge1$rust_vec$OpaqueKeyStretchingParams$data(::rust::Vec<::OpaqueKeyStretchingParams> const *ptr) noexcept;
+void cxxbridge1$rust_vec$OpaqueKeyStretchingParams$reserve_total(::rust::Vec<::OpaqueKeyStretchingParams> *ptr, ::std::size_t new_cap) noexcept;
+void cxxbridge1$rust_vec$OpaqueKeyStretchingParams$set_len(::rust::Vec<::OpaqueKeyStretchingParams> *ptr, ::std::size_t len) noexcept;
+void cxxbridge1$rust_vec$OpaqueKeyStretchingParams$truncate(::rust::Vec<::OpaqueKeyStretchingParams> *ptr, ::std::size_t len) noexcept;
+
+void cxxbridge1$rust_vec$OpaqueStartServerLoginParams$new(::rust::Vec<::OpaqueStartServerLoginParams> const *ptr) noexcept;
+void cxxbridge1$rust_vec$OpaqueStartServerLoginParams$drop(::rust::Vec<::OpaqueStartServerLoginParams> *ptr) noexcept;
+::std::size_t cxxbridge1$rust_vec$OpaqueStartServerLoginParams$len(::rust::Vec<::OpaqueStartServerLoginParams> const *ptr) noexcept;
+::std::size_t cxxbridge1$rust_vec$OpaqueStartServerLoginParams$capacity(::rust::Vec<::OpaqueStartServerLoginParams> const *ptr) noexcept;
+::OpaqueStartServerLoginParams const *cxxbridge1$rust_vec$OpaqueStartServerLoginParams$data(::rust::Vec<::OpaqueStartServerLoginParams> const *ptr) noexcept;
+void cxxbridge1$rust_vec$OpaqueStartServerLoginParams$reserve_total(::rust::Vec<::OpaqueStartServerLoginParams> *ptr, ::std::size_t new_cap) noexcept;
+void cxxbridge1$rust_vec$OpaqueStartServerLoginParams$set_len(::rust::Vec<::OpaqueStartServerLoginParams> *ptr, ::std::size_t len) noexcept;
+void cxxbridge1$rust_vec$OpaqueStartServerLoginParams$truncate(::rust::Vec<::OpaqueStartServerLoginParams> *ptr, ::std::size_t len) noexcept;
+
+void cxxbridge1$rust_vec$OpaqueStartServerLoginBatchResult$new(::rust::Vec<::OpaqueStartServerLoginBatchResult> const *ptr) noexcept;
+void cxxbridge1$rust_vec$OpaqueStartServerLoginBatchResult$drop(::rust::Vec<::OpaqueStartServerLoginBatchResult> *ptr) noexcept;
+::std::size_t cxxbridge1$rust_vec$OpaqueStartServerLoginBatchResult$len(::rust::Vec<::OpaqueStartServerLoginBatchResult> const *ptr) noexcept;
+::std::size_t cxxbridge1$rust_vec$OpaqueStartServerLoginBatchResult$capacity(::rust::Vec<::OpaqueStartServerLoginBatchResult> const *ptr) noexcept;
+::OpaqueStartServerLoginBatchResult const *cxxbridge1$rust_vec$OpaqueStartServerLoginBatchResult$data(::rust::Vec<::OpaqueStartServerLoginBatchResult> const *ptr) noexcept;
+void cxxbridge1$rust_vec$OpaqueStartServerLoginBatchResult$reserve_total(::rust::Vec<::OpaqueStartServerLoginBatchResult> *ptr, ::std::size_t new_cap) noexcept;
+void cxxbridge1$rust_vec$OpaqueStartServerLoginBatchResult$set_len(::rust::Vec<::OpaqueStartServerLoginBatchResult> *ptr, ::std::size_t len) noexcept;
+void cxxbridge1$rust_vec$OpaqueStartServerLoginBatchResult$truncate(::rust::Vec<::OpaqueStartServerLoginBatchResult> *ptr, ::std::size_t len) noexcept;
+
+void cxxbridge1$rust_vec$OpaqueMetricsEntry$new(::rust::Vec<::OpaqueMetricsEntry> const *ptr) noexcept;
+void cxxbridge1$rust_vec$OpaqueMetricsEntry$drop(::rust::Vec<::OpaqueMetricsEntry> *ptr) noexcept;
+::std::size_t cxxbridge1$rust_vec$OpaqueMetricsEntry$len(::rust::Vec<::OpaqueMetricsEntry> const *ptr) noexcept;
+::std::size_t cxxbridge1$rust_vec$OpaqueMetricsEntry$capacity(::rust::Vec<::OpaqueMetricsEntry> const *ptr) noexcept;
+::OpaqueMetricsEntry const *cxxbridge1$rust_vec$OpaqueMetricsEntry$data(::rust::Vec<::OpaqueMetricsEntry> const *ptr) noexcept;
+void cxxbridge1$rust_vec$OpaqueMetricsEntry$reserve_total(::rust::Vec<::OpaqueMetricsEntry> *ptr, ::std::size_t new_cap) noexcept;
+void cxxbridge1$rust_vec$OpaqueMetricsEntry$set_len(::rust::Vec<::OpaqueMetricsEntry> *ptr, ::std::size_t len) noexcept;
+void cxxbridge1$rust_vec$OpaqueMetricsEntry$truncate(::rust::Vec<::OpaqueMetricsEntry> *ptr, ::std::size_t len) noexcept;
+
+static_assert(sizeof(::std::unique_ptr<::OpaqueFinishClientLoginResult>) == sizeof(void *), "");
+static_assert(alignof(::std::unique_ptr<::OpaqueFinishClientLoginResult>) == alignof(void *), "");
+void cxxbridge1$unique_ptr$OpaqueFinishClientLoginResult$null(::std::unique_ptr<::OpaqueFinishClientLoginResult> *ptr) noexcept {
+  ::new (ptr) ::std::unique_ptr<::OpaqueFinishClientLoginResult>();
+}
+::OpaqueFinishClientLoginResult *cxxbridge1$unique_ptr$OpaqueFinishClientLoginResult$uninit(::std::unique_ptr<::OpaqueFinishClientLoginResult> *ptr) noexcept {
+  ::OpaqueFinishClientLoginResult *uninit = reinterpret_cast<::OpaqueFinishClientLoginResult *>(new ::rust::MaybeUninit<::OpaqueFinishClientLoginResult>);
+  ::new (ptr) ::std::unique_ptr<::OpaqueFinishClientLoginResult>(uninit);
+  return uninit;
+}
+void cxxbridge1$unique_ptr$OpaqueFinishClientLoginResult$raw(::std::unique_ptr<::OpaqueFinishClientLoginResult> *ptr, ::OpaqueFinishClientLoginResult *raw) noexcept {
+  ::new (ptr) ::std::unique_ptr<::OpaqueFinishClientLoginResult>(raw);
+}
+::OpaqueFinishClientLoginResult const *cxxbridge1$unique_ptr$OpaqueFinishClientLoginResult$get(::std::unique_ptr<::OpaqueFinishClientLoginResult> const &ptr) noexcept {
+  return ptr.get();
+}
+::OpaqueFinishClientLoginResult *cxxbridge1$unique_ptr$OpaqueFinishClientLoginResult$release(::std::unique_ptr<::OpaqueFinishClientLoginResult> &ptr) noexcept {
+  return ptr.release();
+}
+void cxxbridge1$unique_ptr$OpaqueFinishClientLoginResult$drop(::std::unique_ptr<::OpaqueFinishClientLoginResult> *ptr) noexcept {
+  ptr->~unique_ptr();
+}
+static_assert(sizeof(::std::unique_ptr<::OpaqueFinishClientLoginBinaryResult>) == sizeof(void *), "");
+static_assert(alignof(::std::unique_ptr<::OpaqueFinishClientLoginBinaryResult>) == alignof(void *), "");
+void cxxbridge1$unique_ptr$OpaqueFinishClientLoginBinaryResult$null(::std::unique_ptr<::OpaqueFinishClientLoginBinaryResult> *ptr) noexcept {
+  ::new (ptr) ::std::unique_ptr<::OpaqueFinishClientLoginBinaryResult>();
+}
+::OpaqueFinishClientLoginBinaryResult *cxxbridge1$unique_ptr$OpaqueFinishClientLoginBinaryResult$uninit(::std::unique_ptr<::OpaqueFinishClientLoginBinaryResult> *ptr) noexcept {
+  ::OpaqueFinishClientLoginBinaryResult *uninit = reinterpret_cast<::OpaqueFinishClientLoginBinaryResult *>(new ::rust::MaybeUninit<::OpaqueFinishClientLoginBinaryResult>);
+  ::new (ptr) ::std::unique_ptr<::OpaqueFinishClientLoginBinaryResult>(uninit);
+  return uninit;
+}
+void cxxbridge1$unique_ptr$OpaqueFinishClientLoginBinaryResult$raw(::std::unique_ptr<::OpaqueFinishClientLoginBinaryResult> *ptr, ::OpaqueFinishClientLoginBinaryResult *raw) noexcept {
+  ::new (ptr) ::std::unique_ptr<::OpaqueFinishClientLoginBinaryResult>(raw);
+}
+::OpaqueFinishClientLoginBinaryResult const *cxxbridge1$unique_ptr$OpaqueFinishClientLoginBinaryResult$get(::std::unique_ptr<::OpaqueFinishClientLoginBinaryResult> const &ptr) noexcept {
+  return ptr.get();
+}
+::OpaqueFinishClientLoginBinaryResult *cxxbridge1$unique_ptr$OpaqueFinishClientLoginBinaryResult$release(::std::unique_ptr<::OpaqueFinishClientLoginBinaryResult> &ptr) noexcept {
+  return ptr.release();
+}
+void cxxbridge1$unique_ptr$OpaqueFinishClientLoginBinaryResult$drop(::std::unique_ptr<::OpaqueFinishClientLoginBinaryResult> *ptr) noexcept {
+  ptr->~unique_ptr();
+}
+} // extern "C"
+
+namespace rust {
+inline namespace cxxbridge1 {
+template <>
+::ServerSetupHandle *Box<::ServerSetupHandle>::allocation::alloc() noexcept {
+  return cxxbridge1$box$ServerSetupHandle$alloc();
+}
+template <>
+void Box<::ServerSetupHandle>::allocation::dealloc(::ServerSetupHandle *ptr) noexcept {
+  cxxbridge1$box$ServerSetupHandle$dealloc(ptr);
+}
+template <>
+void Box<::ServerSetupHandle>::drop() noexcept {
+  cxxbridge1$box$ServerSetupHandle$drop(this);
+}
+template <>
+::ClientLoginContext *Box<::ClientLoginContext>::allocation::alloc() noexcept {
+  return cxxbridge1$box$ClientLoginContext$alloc();
+}
+template <>
+void Box<::ClientLoginContext>::allocation::dealloc(::ClientLoginContext *ptr) noexcept {
+  cxxbridge1$box$ClientLoginContext$dealloc(ptr);
+}
+template <>
+void Box<::ClientLoginContext>::drop() noexcept {
+  cxxbridge1$box$ClientLoginContext$drop(this);
+}
+template <>
+::ServerLoginSessionStore *Box<::ServerLoginSessionStore>::allocation::alloc() noexcept {
+  return cxxbridge1$box$ServerLoginSessionStore$alloc();
+}
+template <>
+void Box<::ServerLoginSessionStore>::allocation::dealloc(::ServerLoginSessionStore *ptr) noexcept {
+  cxxbridge1$box$ServerLoginSessionStore$dealloc(ptr);
+}
+template <>
+void Box<::ServerLoginSessionStore>::drop() noexcept {
+  cxxbridge1$box$ServerLoginSessionStore$drop(this);
+}
+template <>
+Vec<::OpaqueKeyStretchingParams>::Vec() noexcept {
+  cxxbridge1$rust_vec$OpaqueKeyStretchingParams$new(this);
+}
+template <>
+void Vec<::OpaqueKeyStretchingParams>::drop() noexcept {
+  return cxxbridge1$rust_vec$OpaqueKeyStretchingParams$drop(this);
+}
+template <>
+::std::size_t Vec<::OpaqueKeyStretchingParams>::size() const noexcept {
+  return cxxbridge1$rust_vec$OpaqueKeyStretchingParams$len(this);
+}
+template <>
+::std::size_t Vec<::OpaqueKeyStretchingParams>::capacity() const noexcept {
+  return cxxbridge1$rust_vec$OpaqueKeyStretchingParams$capacity(this);
+}
+template <>
+::OpaqueKeyStretchingParams const *Vec<::OpaqueKeyStretchingParams>::data() const noexcept {
+  return cxxbridge1$rust_vec$OpaqueKeyStretchingParams$data(this);
+}
+template <>
+void Vec<::OpaqueKeyStretchingParams>::reserve_total(::std::size_t new_cap) noexcept {
+  return cxxbridge1$rust_vec$OpaqueKeyStretchingParams$reserve_total(this, new_cap);
+}
+template <>
+void Vec<::OpaqueKeyStretchingParams>::set_len(::std::size_t len) noexcept {
+  return cxxbridge1$rust_vec$OpaqueKeyStretchingParams$set_len(this, len);
+}
+template <>
+void Vec<::OpaqueKeyStretchingParams>::truncate(::std::size_t len) {
+  return cxxbridge1$rust_vec$OpaqueKeyStretchingParams$truncate(this, len);
+}
+template <>
+Vec<::OpaqueStartServerLoginParams>::Vec() noexcept {
+  cxxbridge1$rust_vec$OpaqueStartServerLoginParams$new(this);
+}
+template <>
+void Vec<::OpaqueStartServerLoginParams>::drop() noexcept {
+  return cxxbridge1$rust_vec$OpaqueStartServerLoginParams$drop(this);
+}
+template <>
+::std::size_t Vec<::OpaqueStartServerLoginParams>::size() const noexcept {
+  return cxxbridge1$rust_vec$OpaqueStartServerLoginParams$len(this);
+}
+template <>
+::std::size_t Vec<::OpaqueStartServerLoginParams>::capacity() const noexcept {
+  return cxxbridge1$rust_vec$OpaqueStartServerLoginParams$capacity(this);
+}
+template <>
+::OpaqueStartServerLoginParams const *Vec<::OpaqueStartServerLoginParams>::data() const noexcept {
+  return cxxbridge1$rust_vec$OpaqueStartServerLoginParams$data(this);
+}
+template <>
+void Vec<::OpaqueStartServerLoginParams>::reserve_total(::std::size_t new_cap) noexcept {
+  return cxxbridge1$rust_vec$OpaqueStartServerLoginParams$reserve_total(this, new_cap);
+}
+template <>
+void Vec<::OpaqueStartServerLoginParams>::set_len(::std::size_t len) noexcept {
+  return cxxbridge1$rust_vec$OpaqueStartServerLoginParams$set_len(this, len);
+}
+template <>
+void Vec<::OpaqueStartServerLoginParams>::truncate(::std::size_t len) {
+  return cxxbridge1$rust_vec$OpaqueStartServerLoginParams$truncate(this, len);
+}
+template <>
+Vec<::OpaqueStartServerLoginBatchResult>::Vec() noexcept {
+  cxxbridge1$rust_vec$OpaqueStartServerLoginBatchResult$new(this);
+}
+template <>
+void Vec<::OpaqueStartServerLoginBatchResult>::drop() noexcept {
+  return cxxbridge1$rust_vec$OpaqueStartServerLoginBatchResult$drop(this);
+}
+template <>
+::std::size_t Vec<::OpaqueStartServerLoginBatchResult>::size() const noexcept {
+  return cxxbridge1$rust_vec$OpaqueStartServerLoginBatchResult$len(this);
+}
+template <>
+::std::size_t Vec<::OpaqueStartServerLoginBatchResult>::capacity() const noexcept {
+  return cxxbridge1$rust_vec$OpaqueStartServerLoginBatchResult$capacity(this);
+}
+template <>
+::OpaqueStartServerLoginBatchResult const *Vec<::OpaqueStartServerLoginBatchResult>::data() const noexcept {
+  return cxxbridge1$rust_vec$OpaqueStartServerLoginBatchResult$data(this);
+}
+template <>
+void Vec<::OpaqueStartServerLoginBatchResult>::reserve_total(::std::size_t new_cap) noexcept {
+  return cxxbridge1$rust_vec$OpaqueStartServerLoginBatchResult$reserve_total(this, new_cap);
+}
+template <>
+void Vec<::OpaqueStartServerLoginBatchResult>::set_len(::std::size_t len) noexcept {
+  return cxxbridge1$rust_vec$OpaqueStartServerLoginBatchResult$set_len(this, len);
+}
+template <>
+void Vec<::OpaqueStartServerLoginBatchResult>::truncate(::std::size_t len) {
+  return cxxbridge1$rust_vec$OpaqueStartServerLoginBatchResult$truncate(this, len);
+}
+template <>
+Vec<::OpaqueMetricsEntry>::Vec() noexcept {
+  cxxbridge1$rust_vec$OpaqueMetricsEntry$new(this);
+}
+template <>
+void Vec<::OpaqueMetricsEntry>::drop() noexcept {
+  return cxxbridge1$rust_vec$OpaqueMetricsEntry$drop(this);
+}
+template <>
+::std::size_t Vec<::OpaqueMetricsEntry>::size() const noexcept {
+  return cxxbridge1$rust_vec$OpaqueMetricsEntry$len(this);
+}
+template <>
+::std::size_t Vec<::OpaqueMetricsEntry>::capacity() const noexcept {
+  return cxxbridge1$rust_vec$OpaqueMetricsEntry$capacity(this);
+}
+template <>
+::OpaqueMetricsEntry const *Vec<::OpaqueMetricsEntry>::data() const noexcept {
+  return cxxbridge1$rust_vec$OpaqueMetricsEntry$data(this);
+}
+template <>
+void Vec<::OpaqueMetricsEntry>::reserve_total(::std::size_t new_cap) noexcept {
+  return cxxbridge1$rust_vec$OpaqueMetricsEntry$reserve_total(this, new_cap);
+}
+template <>
+void Vec<::OpaqueMetricsEntry>::set_len(::std::size_t len) noexcept {
+  return cxxbridge1$rust_vec$OpaqueMetricsEntry$set_len(this, len);
+}
+template <>
+void Vec<::OpaqueMetricsEntry>::truncate(::std::size_t len) {
+  return cxxbridge1$rust_vec$OpaqueMetricsEntry$truncate(this, len);
+}
+} // namespace cxxbridge1
+} // namespace rust
@@ -104,6 +104,53 @@ private:
 };
 #endif // CXXBRIDGE1_RUST_STRING
 
+#ifndef CXXBRIDGE1_RUST_STR
+#define CXXBRIDGE1_RUST_STR
+class Str final {
+public:
+  Str() noexcept;
+  Str(const String &) noexcept;
+  Str(const std::string &);
+  Str(const char *);
+  Str(const char *, std::size_t);
+
+  Str &operator=(const Str &) &noexcept = default;
+
+  explicit operator std::string() const;
+
+  const char *data() const noexcept;
+  std::size_t size() const noexcept;
+  std::size_t length() const noexcept;
+  bool empty() const noexcept;
+
+  Str(const Str &) noexcept = default;
+  ~Str() noexcept = default;
+
+  using iterator = const char *;
+  using const_iterator = const char *;
+  const_iterator begin() const noexcept;
+  const_iterator end() const noexcept;
+  const_iterator cbegin() const noexcept;
+  const_iterator cend() const noexcept;
+
+  bool operator==(const Str &) const noexcept;
+  bool operator!=(const Str &) const noexcept;
+  bool operator<(const Str &) const noexcept;
+  bool operator<=(const Str &) const noexcept;
+  bool operator>(const Str &) const noexcept;
+  bool operator>=(const Str &) const noexcept;
+
+  void swap(Str &) noexcept;
+
+private:
+  class uninit;
+  Str(uninit) noexcept;
+  friend impl<Str>;
+
+  std::array<std::uintptr_t, 2> repr;
+};
+#endif // CXXBRIDGE1_RUST_STR
+
 #ifndef CXXBRIDGE1_RUST_SLICE
 #define CXXBRIDGE1_RUST_SLICE
 namespace detail {
@@ -395,6 +442,162 @@ void Slice<T>::swap(Slice &rhs) noexcept {
 }
 #endif // CXXBRIDGE1_RUST_SLICE
 
+#ifndef CXXBRIDGE1_RUST_BOX
+#define CXXBRIDGE1_RUST_BOX
+template <typename T>
+class Box final {
+public:
+  using element_type = T;
+  using const_pointer =
+      typename std::add_pointer<typename std::add_const<T>::type>::type;
+  using pointer = typename std::add_pointer<T>::type;
+
+  Box() = delete;
+  Box(Box &&) noexcept;
+  ~Box() noexcept;
+
+  explicit Box(const T &);
+  explicit Box(T &&);
+
+  Box &operator=(Box &&) &noexcept;
+
+  const T *operator->() const noexcept;
+  const T &operator*() const noexcept;
+  T *operator->() noexcept;
+  T &operator*() noexcept;
+
+  template <typename... Fields>
+  static Box in_place(Fields &&...);
+
+  void swap(Box &) noexcept;
+
+  static Box from_raw(T *) noexcept;
+
+  T *into_raw() noexcept;
+
+  using value_type = element_type;
+
+private:
+  class uninit;
+  class allocation;
+  Box(uninit) noexcept;
+  void drop() noexcept;
+
+  friend void swap(Box &lhs, Box &rhs) noexcept { lhs.swap(rhs); }
+
+  T *ptr;
+};
+
+template <typename T>
+class Box<T>::uninit {};
+
+template <typename T>
+class Box<T>::allocation {
+  static T *alloc() noexcept;
+  static void dealloc(T *) noexcept;
+
+public:
+  allocation() noexcept : ptr(alloc()) {}
+  ~allocation() noexcept {
+    if (this->ptr) {
+      dealloc(this->ptr);
+    }
+  }
+  T *ptr;
+};
+
+template <typename T>
+Box<T>::Box(Box &&other) noexcept : ptr(other.ptr) {
+  other.ptr = nullptr;
+}
+
+template <typename T>
+Box<T>::Box(const T &val) {
+  allocation alloc;
+  ::new (alloc.ptr) T(val);
+  this->ptr = alloc.ptr;
+  alloc.ptr = nullptr;
+}
+
+template <typename T>
+Box<T>::Box(T &&val) {
+  allocation alloc;
+  ::new (alloc.ptr) T(std::move(val));
+  this->ptr = alloc.ptr;
+  alloc.ptr = nullptr;
+}
+
+template <typename T>
+Box<T>::~Box() noexcept {
+  if (this->ptr) {
+    this->drop();
+  }
+}
+
+template <typename T>
+Box<T> &Box<T>::operator=(Box &&other) &noexcept {
+  if (this->ptr) {
+    this->drop();
+  }
+  this->ptr = other.ptr;
+  other.ptr = nullptr;
+  return *this;
+}
+
+template <typename T>
+const T *Box<T>::operator->() const noexcept {
+  return this->ptr;
+}
+
+template <typename T>
+const T &Box<T>::operator*() const noexcept {
+  return *this->ptr;
+}
+
+template <typename T>
+T *Box<T>::operator->() noexcept {
+  return this->ptr;
+}
+
+template <typename T>
+T &Box<T>::operator*() noexcept {
+  return *this->ptr;
+}
+
+template <typename T>
+template <typename... Fields>
+Box<T> Box<T>::in_place(Fields &&...fields) {
+  allocation alloc;
+  auto ptr = alloc.ptr;
+  ::new (ptr) T{std::forward<Fields>(fields)...};
+  alloc.ptr = nullptr;
+  return from_raw(ptr);
+}
+
+template <typename T>
+void Box<T>::swap(Box &rhs) noexcept {
+  using std::swap;
+  swap(this->ptr, rhs.ptr);
+}
+
+template <typename T>
+Box<T> Box<T>::from_raw(T *raw) noexcept {
+  Box box = uninit{};
+  box.ptr = raw;
+  return box;
+}
+
+template <typename T>
+T *Box<T>::into_raw() noexcept {
+  T *raw = this->ptr;
+  this->ptr = nullptr;
+  return raw;
+}
+
+template <typename T>
+Box<T>::Box(uninit) noexcept {}
+#endif // CXXBRIDGE1_RUST_BOX
+
 #ifndef CXXBRIDGE1_RUST_BITCOPY_T
 #define CXXBRIDGE1_RUST_BITCOPY_T
 struct unsafe_bitcopy_t final {
@@ -640,6 +843,37 @@ template <typename T>
 Vec<T>::Vec(unsafe_bitcopy_t, const Vec &bits) noexcept : repr(bits.repr) {}
 #endif // CXXBRIDGE1_RUST_VEC
 
+#ifndef CXXBRIDGE1_RUST_ERROR
+#define CXXBRIDGE1_RUST_ERROR
+class Error final : public std::exception {
+public:
+  Error(const Error &);
+  Error(Error &&) noexcept;
+  ~Error() noexcept override;
+
+  Error &operator=(const Error &) &;
+  Error &operator=(Error &&) &noexcept;
+
+  const char *what() const noexcept override;
+
+private:
+  Error() noexcept = default;
+  friend impl<Error>;
+  const char *msg;
+  std::size_t len;
+};
+#endif // CXXBRIDGE1_RUST_ERROR
+
+#ifndef CXXBRIDGE1_RUST_OPAQUE
+#define CXXBRIDGE1_RUST_OPAQUE
+class Opaque {
+public:
+  Opaque() = delete;
+  Opaque(const Opaque &) = delete;
+  ~Opaque() = delete;
+};
+#endif // CXXBRIDGE1_RUST_OPAQUE
+
 #ifndef CXXBRIDGE1_IS_COMPLETE
 #define CXXBRIDGE1_IS_COMPLETE
 namespace detail {
@@ -710,6 +944,8 @@ std::size_t align_of() {
 } // namespace cxxbridge1
 } // namespace rust
 
+struct OpaqueKeyStretchingParams;
+struct OpaqueCpuTopology;
 struct OpaqueStartClientRegistrationParams;
 struct OpaqueStartClientRegistrationResult;
 struct OpaqueFinishClientRegistrationParams;
@@ -724,11 +960,65 @@ struct OpaqueStartServerLoginParams;
 struct OpaqueStartServerLoginResult;
 struct OpaqueFinishServerLoginParams;
 struct OpaqueFinishServerLoginResult;
+struct OpaqueStartClientRegistrationBinaryResult;
+struct OpaqueFinishClientRegistrationBinaryResult;
+struct OpaqueStartClientLoginBinaryResult;
+struct OpaqueFinishClientLoginBinaryResult;
+struct OpaqueCreateServerRegistrationResponseBinaryResult;
+struct OpaqueStartServerLoginSessionResult;
+struct OpaqueStartServerLoginBatchResult;
+struct OpaqueRegistrationImportChunk;
+struct OpaqueStartServerLoginBinaryResult;
+struct OpaqueFinishServerLoginBinaryResult;
+struct OpaqueFinishClientRegistrationInput;
+struct OpaqueFinishClientLoginInput;
+struct OpaqueStartClientLoginContextInput;
+struct OpaqueCreateServerRegistrationResponseInput;
+struct OpaqueStartServerLoginInput;
+struct OpaqueFinishServerLoginInput;
+struct OpaqueStartClientRegistrationOutput;
+struct OpaqueFinishClientRegistrationOutput;
+struct OpaqueStartClientLoginOutput;
+struct OpaqueFinishClientLoginOutput;
+struct OpaqueStartServerLoginOutput;
+struct OpaqueStatus;
+struct OpaqueMetricsEntry;
+enum class OpaqueCipherSuite : ::std::uint8_t;
+enum class OpaqueMetricsFunction : ::std::uint8_t;
+enum class OpaqueErrorCode : ::std::uint8_t;
+struct ServerSetupHandle;
+struct ClientLoginContext;
+struct ServerLoginSessionStore;
+
+#ifndef CXXBRIDGE1_STRUCT_OpaqueKeyStretchingParams
+#define CXXBRIDGE1_STRUCT_OpaqueKeyStretchingParams
+// Argon2id parameters of the client side key stretching.
+struct OpaqueKeyStretchingParams final {
+  // memory size in KiB
+  ::std::uint32_t memory_cost;
+  ::std::uint32_t iterations;
+  ::std::uint32_t parallelism;
+
+  using IsRelocatable = ::std::true_type;
+};
+#endif // CXXBRIDGE1_STRUCT_OpaqueKeyStretchingParams
+
+#ifndef CXXBRIDGE1_STRUCT_OpaqueCpuTopology
+#define CXXBRIDGE1_STRUCT_OpaqueCpuTopology
+struct OpaqueCpuTopology final {
+  ::std::uint32_t cores;
+  // cores excluding the efficiency cores of big.LITTLE systems
+  ::std::uint32_t performance_cores;
+
+  using IsRelocatable = ::std::true_type;
+};
+#endif // CXXBRIDGE1_STRUCT_OpaqueCpuTopology
 
 #ifndef CXXBRIDGE1_STRUCT_OpaqueStartClientRegistrationParams
 #define CXXBRIDGE1_STRUCT_OpaqueStartClientRegistrationParams
 struct OpaqueStartClientRegistrationParams final {
   ::rust::String password;
+  ::OpaqueCipherSuite suite;
 
   using IsRelocatable = ::std::true_type;
 };
@@ -752,6 +1042,8 @@ struct OpaqueFinishClientRegistrationParams final {
   ::rust::String client_registration_state;
   ::rust::Vec<::rust::String> client_identifier;
   ::rust::Vec<::rust::String> server_identifier;
+  ::rust::Vec<::OpaqueKeyStretchingParams> key_stretching;
+  ::OpaqueCipherSuite suite;
 
   using IsRelocatable = ::std::true_type;
 };
@@ -763,6 +1055,7 @@ struct OpaqueFinishClientRegistrationResult final {
   ::rust::String registration_record;
   ::rust::String export_key;
   ::rust::String server_static_public_key;
+  ::OpaqueKeyStretchingParams key_stretching;
 
   using IsRelocatable = ::std::true_type;
 };
@@ -772,6 +1065,7 @@ struct OpaqueFinishClientRegistrationResult final {
 #define CXXBRIDGE1_STRUCT_OpaqueStartClientLoginParams
 struct OpaqueStartClientLoginParams final {
   ::rust::String password;
+  ::OpaqueCipherSuite suite;
 
   using IsRelocatable = ::std::true_type;
 };
@@ -795,6 +1089,8 @@ struct OpaqueFinishClientLoginParams final {
   ::rust::String password;
   ::rust::Vec<::rust::String> client_identifier;
   ::rust::Vec<::rust::String> server_identifier;
+  ::rust::Vec<::OpaqueKeyStretchingParams> key_stretching;
+  ::OpaqueCipherSuite suite;
 
   using IsRelocatable = ::std::true_type;
 };
@@ -815,9 +1111,9 @@ struct OpaqueFinishClientLoginResult final {
 #ifndef CXXBRIDGE1_STRUCT_OpaqueCreateServerRegistrationResponseParams
 #define CXXBRIDGE1_STRUCT_OpaqueCreateServerRegistrationResponseParams
 struct OpaqueCreateServerRegistrationResponseParams final {
-  ::rust::String server_setup;
   ::rust::String user_identifier;
   ::rust::String registration_request;
+  ::OpaqueCipherSuite suite;
 
   using IsRelocatable = ::std::true_type;
 };
@@ -835,12 +1131,12 @@ struct OpaqueCreateServerRegistrationResponseResult final {
 #ifndef CXXBRIDGE1_STRUCT_OpaqueStartServerLoginParams
 #define CXXBRIDGE1_STRUCT_OpaqueStartServerLoginParams
 struct OpaqueStartServerLoginParams final {
-  ::rust::String server_setup;
   ::rust::Vec<::rust::String> registration_record;
   ::rust::String start_login_request;
   ::rust::String user_identifier;
   ::rust::Vec<::rust::String> client_identifier;
   ::rust::Vec<::rust::String> server_identifier;
+  ::OpaqueCipherSuite suite;
 
   using IsRelocatable = ::std::true_type;
 };
@@ -861,6 +1157,7 @@ struct OpaqueStartServerLoginResult final {
 struct OpaqueFinishServerLoginParams final {
   ::rust::String server_login_state;
   ::rust::String finish_login_request;
+  ::OpaqueCipherSuite suite;
 
   using IsRelocatable = ::std::true_type;
 };
@@ -875,6 +1172,382 @@ struct OpaqueFinishServerLoginResult final {
 };
 #endif // CXXBRIDGE1_STRUCT_OpaqueFinishServerLoginResult
 
+#ifndef CXXBRIDGE1_STRUCT_OpaqueStartClientRegistrationBinaryResult
+#define CXXBRIDGE1_STRUCT_OpaqueStartClientRegistrationBinaryResult
+struct OpaqueStartClientRegistrationBinaryResult final {
+  ::rust::Vec<::std::uint8_t> client_registration_state;
+  ::rust::Vec<::std::uint8_t> registration_request;
+
+  using IsRelocatable = ::std::true_type;
+};
+#endif // CXXBRIDGE1_STRUCT_OpaqueStartClientRegistrationBinaryResult
+
+#ifndef CXXBRIDGE1_STRUCT_OpaqueFinishClientRegistrationBinaryResult
+#define CXXBRIDGE1_STRUCT_OpaqueFinishClientRegistrationBinaryResult
+struct OpaqueFinishClientRegistrationBinaryResult final {
+  ::rust::Vec<::std::uint8_t> registration_record;
+  ::rust::Vec<::std::uint8_t> export_key;
+  ::rust::Vec<::std::uint8_t> server_static_public_key;
+  ::OpaqueKeyStretchingParams key_stretching;
+
+  using IsRelocatable = ::std::true_type;
+};
+#endif // CXXBRIDGE1_STRUCT_OpaqueFinishClientRegistrationBinaryResult
+
+#ifndef CXXBRIDGE1_STRUCT_OpaqueStartClientLoginBinaryResult
+#define CXXBRIDGE1_STRUCT_OpaqueStartClientLoginBinaryResult
+struct OpaqueStartClientLoginBinaryResult final {
+  ::rust::Vec<::std::uint8_t> client_login_state;
+  ::rust::Vec<::std::uint8_t> start_login_request;
+
+  using IsRelocatable = ::std::true_type;
+};
+#endif // CXXBRIDGE1_STRUCT_OpaqueStartClientLoginBinaryResult
+
+#ifndef CXXBRIDGE1_STRUCT_OpaqueFinishClientLoginBinaryResult
+#define CXXBRIDGE1_STRUCT_OpaqueFinishClientLoginBinaryResult
+struct OpaqueFinishClientLoginBinaryResult final {
+  ::rust::Vec<::std::uint8_t> finish_login_request;
+  ::rust::Vec<::std::uint8_t> session_key;
+  ::rust::Vec<::std::uint8_t> export_key;
+  ::rust::Vec<::std::uint8_t> server_static_public_key;
+
+  using IsRelocatable = ::std::true_type;
+};
+#endif // CXXBRIDGE1_STRUCT_OpaqueFinishClientLoginBinaryResult
+
+#ifndef CXXBRIDGE1_STRUCT_OpaqueCreateServerRegistrationResponseBinaryResult
+#define CXXBRIDGE1_STRUCT_OpaqueCreateServerRegistrationResponseBinaryResult
+struct OpaqueCreateServerRegistrationResponseBinaryResult final {
+  ::rust::Vec<::std::uint8_t> registration_response;
+
+  using IsRelocatable = ::std::true_type;
+};
+#endif // CXXBRIDGE1_STRUCT_OpaqueCreateServerRegistrationResponseBinaryResult
+
+#ifndef CXXBRIDGE1_STRUCT_OpaqueStartServerLoginSessionResult
+#define CXXBRIDGE1_STRUCT_OpaqueStartServerLoginSessionResult
+struct OpaqueStartServerLoginSessionResult final {
+  // identifies the login session in `opaque_finish_server_login_session`
+  ::rust::String session_handle;
+  ::rust::String login_response;
+
+  using IsRelocatable = ::std::true_type;
+};
+#endif // CXXBRIDGE1_STRUCT_OpaqueStartServerLoginSessionResult
+
+#ifndef CXXBRIDGE1_STRUCT_OpaqueStartServerLoginBatchResult
+#define CXXBRIDGE1_STRUCT_OpaqueStartServerLoginBatchResult
+struct OpaqueStartServerLoginBatchResult final {
+  ::rust::String server_login_state;
+  ::rust::String login_response;
+  // `None` if the request succeeded.
+  ::OpaqueErrorCode error_code;
+  ::rust::String error_message;
+
+  using IsRelocatable = ::std::true_type;
+};
+#endif // CXXBRIDGE1_STRUCT_OpaqueStartServerLoginBatchResult
+
+#ifndef CXXBRIDGE1_STRUCT_OpaqueRegistrationImportChunk
+#define CXXBRIDGE1_STRUCT_OpaqueRegistrationImportChunk
+// Result of one chunk of a bulk registration import, see `import.rs`
+// for the framing of `responses`.
+struct OpaqueRegistrationImportChunk final {
+  ::rust::Vec<::std::uint8_t> responses;
+  // bytes of the input taken up by the records of this chunk
+  ::std::size_t consumed;
+  ::std::size_t records;
+  ::std::size_t failed;
+
+  using IsRelocatable = ::std::true_type;
+};
+#endif // CXXBRIDGE1_STRUCT_OpaqueRegistrationImportChunk
+
+#ifndef CXXBRIDGE1_STRUCT_OpaqueStartServerLoginBinaryResult
+#define CXXBRIDGE1_STRUCT_OpaqueStartServerLoginBinaryResult
+struct OpaqueStartServerLoginBinaryResult final {
+  ::rust::Vec<::std::uint8_t> server_login_state;
+  ::rust::Vec<::std::uint8_t> login_response;
+
+  using IsRelocatable = ::std::true_type;
+};
+#endif // CXXBRIDGE1_STRUCT_OpaqueStartServerLoginBinaryResult
+
+#ifndef CXXBRIDGE1_STRUCT_OpaqueFinishServerLoginBinaryResult
+#define CXXBRIDGE1_STRUCT_OpaqueFinishServerLoginBinaryResult
+struct OpaqueFinishServerLoginBinaryResult final {
+  ::rust::Vec<::std::uint8_t> session_key;
+
+  using IsRelocatable = ::std::true_type;
+};
+#endif // CXXBRIDGE1_STRUCT_OpaqueFinishServerLoginBinaryResult
+
+#ifndef CXXBRIDGE1_STRUCT_OpaqueFinishClientRegistrationInput
+#define CXXBRIDGE1_STRUCT_OpaqueFinishClientRegistrationInput
+struct OpaqueFinishClientRegistrationInput final {
+  ::rust::Str password;
+  ::rust::Str registration_response;
+  ::rust::Str client_registration_state;
+  ::rust::Str client_identifier;
+  bool has_client_identifier;
+  ::rust::Str server_identifier;
+  bool has_server_identifier;
+  ::OpaqueKeyStretchingParams key_stretching;
+  bool has_key_stretching;
+  ::OpaqueCipherSuite suite;
+
+  using IsRelocatable = ::std::true_type;
+};
+#endif // CXXBRIDGE1_STRUCT_OpaqueFinishClientRegistrationInput
+
+#ifndef CXXBRIDGE1_STRUCT_OpaqueFinishClientLoginInput
+#define CXXBRIDGE1_STRUCT_OpaqueFinishClientLoginInput
+struct OpaqueFinishClientLoginInput final {
+  ::rust::Str client_login_state;
+  ::rust::Str login_response;
+  ::rust::Str password;
+  ::rust::Str client_identifier;
+  bool has_client_identifier;
+  ::rust::Str server_identifier;
+  bool has_server_identifier;
+  ::OpaqueKeyStretchingParams key_stretching;
+  bool has_key_stretching;
+  ::OpaqueCipherSuite suite;
+
+  using IsRelocatable = ::std::true_type;
+};
+#endif // CXXBRIDGE1_STRUCT_OpaqueFinishClientLoginInput
+
+#ifndef CXXBRIDGE1_STRUCT_OpaqueStartClientLoginContextInput
+#define CXXBRIDGE1_STRUCT_OpaqueStartClientLoginContextInput
+// The password, identifiers and key stretching params are kept in the
+// client login context until the login is finished.
+struct OpaqueStartClientLoginContextInput final {
+  ::rust::Str password;
+  ::rust::Str client_identifier;
+  bool has_client_identifier;
+  ::rust::Str server_identifier;
+  bool has_server_identifier;
+  ::OpaqueKeyStretchingParams key_stretching;
+  bool has_key_stretching;
+  ::OpaqueCipherSuite suite;
+
+  using IsRelocatable = ::std::true_type;
+};
+#endif // CXXBRIDGE1_STRUCT_OpaqueStartClientLoginContextInput
+
+#ifndef CXXBRIDGE1_STRUCT_OpaqueCreateServerRegistrationResponseInput
+#define CXXBRIDGE1_STRUCT_OpaqueCreateServerRegistrationResponseInput
+struct OpaqueCreateServerRegistrationResponseInput final {
+  ::rust::Str user_identifier;
+  ::rust::Str registration_request;
+  ::OpaqueCipherSuite suite;
+
+  using IsRelocatable = ::std::true_type;
+};
+#endif // CXXBRIDGE1_STRUCT_OpaqueCreateServerRegistrationResponseInput
+
+#ifndef CXXBRIDGE1_STRUCT_OpaqueStartServerLoginInput
+#define CXXBRIDGE1_STRUCT_OpaqueStartServerLoginInput
+struct OpaqueStartServerLoginInput final {
+  ::rust::Str registration_record;
+  bool has_registration_record;
+  ::rust::Str start_login_request;
+  ::rust::Str user_identifier;
+  ::rust::Str client_identifier;
+  bool has_client_identifier;
+  ::rust::Str server_identifier;
+  bool has_server_identifier;
+  ::OpaqueCipherSuite suite;
+
+  using IsRelocatable = ::std::true_type;
+};
+#endif // CXXBRIDGE1_STRUCT_OpaqueStartServerLoginInput
+
+#ifndef CXXBRIDGE1_STRUCT_OpaqueFinishServerLoginInput
+#define CXXBRIDGE1_STRUCT_OpaqueFinishServerLoginInput
+struct OpaqueFinishServerLoginInput final {
+  ::rust::Str server_login_state;
+  ::rust::Str finish_login_request;
+  ::OpaqueCipherSuite suite;
+
+  using IsRelocatable = ::std::true_type;
+};
+#endif // CXXBRIDGE1_STRUCT_OpaqueFinishServerLoginInput
+
+#ifndef CXXBRIDGE1_STRUCT_OpaqueStartClientRegistrationOutput
+#define CXXBRIDGE1_STRUCT_OpaqueStartClientRegistrationOutput
+struct OpaqueStartClientRegistrationOutput final {
+  ::std::size_t client_registration_state;
+  ::std::size_t registration_request;
+
+  using IsRelocatable = ::std::true_type;
+};
+#endif // CXXBRIDGE1_STRUCT_OpaqueStartClientRegistrationOutput
+
+#ifndef CXXBRIDGE1_STRUCT_OpaqueFinishClientRegistrationOutput
+#define CXXBRIDGE1_STRUCT_OpaqueFinishClientRegistrationOutput
+struct OpaqueFinishClientRegistrationOutput final {
+  ::std::size_t registration_record;
+  ::std::size_t export_key;
+  ::std::size_t server_static_public_key;
+  ::OpaqueKeyStretchingParams key_stretching;
+
+  using IsRelocatable = ::std::true_type;
+};
+#endif // CXXBRIDGE1_STRUCT_OpaqueFinishClientRegistrationOutput
+
+#ifndef CXXBRIDGE1_STRUCT_OpaqueStartClientLoginOutput
+#define CXXBRIDGE1_STRUCT_OpaqueStartClientLoginOutput
+struct OpaqueStartClientLoginOutput final {
+  ::std::size_t client_login_state;
+  ::std::size_t start_login_request;
+
+  using IsRelocatable = ::std::true_type;
+};
+#endif // CXXBRIDGE1_STRUCT_OpaqueStartClientLoginOutput
+
+#ifndef CXXBRIDGE1_STRUCT_OpaqueFinishClientLoginOutput
+#define CXXBRIDGE1_STRUCT_OpaqueFinishClientLoginOutput
+struct OpaqueFinishClientLoginOutput final {
+  // false if the client detected a login failure, nothing is written
+  // to the output buffer then
+  bool success;
+  ::std::size_t finish_login_request;
+  ::std::size_t session_key;
+  ::std::size_t export_key;
+  ::std::size_t server_static_public_key;
+
+  using IsRelocatable = ::std::true_type;
+};
+#endif // CXXBRIDGE1_STRUCT_OpaqueFinishClientLoginOutput
+
+#ifndef CXXBRIDGE1_STRUCT_OpaqueStartServerLoginOutput
+#define CXXBRIDGE1_STRUCT_OpaqueStartServerLoginOutput
+struct OpaqueStartServerLoginOutput final {
+  ::std::size_t server_login_state;
+  ::std::size_t login_response;
+
+  using IsRelocatable = ::std::true_type;
+};
+#endif // CXXBRIDGE1_STRUCT_OpaqueStartServerLoginOutput
+
+#ifndef CXXBRIDGE1_STRUCT_OpaqueStatus
+#define CXXBRIDGE1_STRUCT_OpaqueStatus
+// Outcome of the `opaque_try_*` functions, which report an error
+// instead of throwing it. Its message is written to the start of the
+// output buffer, `message` is its length.
+struct OpaqueStatus final {
+  ::OpaqueErrorCode code;
+  ::std::size_t message;
+
+  using IsRelocatable = ::std::true_type;
+};
+#endif // CXXBRIDGE1_STRUCT_OpaqueStatus
+
+#ifndef CXXBRIDGE1_STRUCT_OpaqueMetricsEntry
+#define CXXBRIDGE1_STRUCT_OpaqueMetricsEntry
+// Durations of one phase of a function, the percentiles are the upper
+// bound of their power of two histogram bucket.
+struct OpaqueMetricsEntry final {
+  ::rust::String function;
+  ::rust::String phase;
+  ::std::uint64_t count;
+  ::std::uint64_t total_ns;
+  ::std::uint64_t max_ns;
+  ::std::uint64_t p50_ns;
+  ::std::uint64_t p90_ns;
+  ::std::uint64_t p99_ns;
+
+  using IsRelocatable = ::std::true_type;
+};
+#endif // CXXBRIDGE1_STRUCT_OpaqueMetricsEntry
+
+#ifndef CXXBRIDGE1_ENUM_OpaqueCipherSuite
+#define CXXBRIDGE1_ENUM_OpaqueCipherSuite
+// Cipher suite of a call. Messages, states and server setups of one
+// suite can't be used with another, the client and the server must
+// agree on it. `Default` is Ristretto255, or P-256 in builds with the
+// `p256` feature; P-256 is only available with the `p256-suite` feature.
+enum class OpaqueCipherSuite : ::std::uint8_t {
+  Default = 0,
+  Ristretto255 = 1,
+  P256 = 2,
+};
+#endif // CXXBRIDGE1_ENUM_OpaqueCipherSuite
+
+#ifndef CXXBRIDGE1_ENUM_OpaqueMetricsFunction
+#define CXXBRIDGE1_ENUM_OpaqueMetricsFunction
+// The functions with metrics, see `metrics.rs`. The string, binary
+// and server setup handle variants of a function share its metrics.
+enum class OpaqueMetricsFunction : ::std::uint8_t {
+  StartClientRegistration = 0,
+  FinishClientRegistration = 1,
+  StartClientLogin = 2,
+  FinishClientLogin = 3,
+  CreateServerRegistrationResponse = 4,
+  StartServerLogin = 5,
+  FinishServerLogin = 6,
+};
+#endif // CXXBRIDGE1_ENUM_OpaqueMetricsFunction
+
+#ifndef CXXBRIDGE1_ENUM_OpaqueErrorCode
+#define CXXBRIDGE1_ENUM_OpaqueErrorCode
+// Code of an `Error` in the result mode, one per variant and
+// `InvalidLogin` for the protocol error of a wrong password. `None`
+// if there was no error.
+enum class OpaqueErrorCode : ::std::uint8_t {
+  None = 0,
+  Input = 1,
+  Protocol = 2,
+  Base64 = 3,
+  InvalidLogin = 4,
+};
+#endif // CXXBRIDGE1_ENUM_OpaqueErrorCode
+
+#ifndef CXXBRIDGE1_STRUCT_ServerSetupHandle
+#define CXXBRIDGE1_STRUCT_ServerSetupHandle
+struct ServerSetupHandle final : public ::rust::Opaque {
+  ~ServerSetupHandle() = delete;
+
+private:
+  friend ::rust::layout;
+  struct layout {
+    static ::std::size_t size() noexcept;
+    static ::std::size_t align() noexcept;
+  };
+};
+#endif // CXXBRIDGE1_STRUCT_ServerSetupHandle
+
+#ifndef CXXBRIDGE1_STRUCT_ClientLoginContext
+#define CXXBRIDGE1_STRUCT_ClientLoginContext
+struct ClientLoginContext final : public ::rust::Opaque {
+  ~ClientLoginContext() = delete;
+
+private:
+  friend ::rust::layout;
+  struct layout {
+    static ::std::size_t size() noexcept;
+    static ::std::size_t align() noexcept;
+  };
+};
+#endif // CXXBRIDGE1_STRUCT_ClientLoginContext
+
+#ifndef CXXBRIDGE1_STRUCT_ServerLoginSessionStore
+#define CXXBRIDGE1_STRUCT_ServerLoginSessionStore
+struct ServerLoginSessionStore final : public ::rust::Opaque {
+  ~ServerLoginSessionStore() = delete;
+
+private:
+  friend ::rust::layout;
+  struct layout {
+    static ::std::size_t size() noexcept;
+    static ::std::size_t align() noexcept;
+  };
+};
+#endif // CXXBRIDGE1_STRUCT_ServerLoginSessionStore
+
 ::OpaqueStartClientRegistrationResult opaque_start_client_registration(::OpaqueStartClientRegistrationParams params);
 
 ::OpaqueFinishClientRegistrationResult opaque_finish_client_registration(::OpaqueFinishClientRegistrationParams params);
@@ -883,12 +1556,158 @@ struct OpaqueFinishServerLoginResult final {
 
 ::std::unique_ptr<::OpaqueFinishClientLoginResult> opaque_finish_client_login(::OpaqueFinishClientLoginParams params);
 
-::rust::String opaque_create_server_setup() noexcept;
+// Starts a client login and keeps its state in the returned context
+// instead of serializing it. Sets `start_login_request` to the base64
+// encoded request for the server.
+::rust::Box<::ClientLoginContext> opaque_start_client_login_context(::OpaqueStartClientLoginContextInput input, ::rust::String &start_login_request);
+
+// Finishes the login of the context and zeroizes its state, a
+// context can only be finished once. Writes the result like
+// `opaque_finish_client_login_into`.
+::OpaqueFinishClientLoginOutput opaque_finish_client_login_context(::ClientLoginContext const &context, ::rust::Str login_response, ::rust::Slice<::std::uint8_t> out);
+
+::OpaqueKeyStretchingParams opaque_calibrate_key_stretching(::std::uint32_t target_duration_ms, ::std::uint32_t parallelism);
+
+void opaque_check_key_stretching(::rust::Vec<::OpaqueKeyStretchingParams> key_stretching);
+
+void opaque_prewarm_key_stretching(::rust::Vec<::OpaqueKeyStretchingParams> key_stretching);
+
+void opaque_prepare_client_login_finish(::rust::Vec<::OpaqueKeyStretchingParams> key_stretching);
+
+void opaque_release_key_stretching_memory() noexcept;
+
+void opaque_trim_key_stretching_memory() noexcept;
+
+::OpaqueCpuTopology opaque_get_cpu_topology() noexcept;
 
-::rust::String opaque_get_server_public_key(::rust::String data);
+::rust::String opaque_create_server_setup(::OpaqueCipherSuite suite);
 
-::OpaqueCreateServerRegistrationResponseResult opaque_create_server_registration_response(::OpaqueCreateServerRegistrationResponseParams params);
+::rust::Box<::ServerSetupHandle> opaque_create_server_setup_handle(::rust::String data, ::OpaqueCipherSuite suite);
 
-::OpaqueStartServerLoginResult opaque_start_server_login(::OpaqueStartServerLoginParams params);
+::rust::String opaque_get_server_public_key(::rust::String data, ::OpaqueCipherSuite suite);
+
+::rust::String opaque_get_server_public_key_with_setup(::ServerSetupHandle const &server_setup) noexcept;
+
+::OpaqueCreateServerRegistrationResponseResult opaque_create_server_registration_response(::rust::String server_setup, ::OpaqueCreateServerRegistrationResponseParams params);
+
+::OpaqueCreateServerRegistrationResponseResult opaque_create_server_registration_response_with_setup(::ServerSetupHandle const &server_setup, ::OpaqueCreateServerRegistrationResponseParams params);
+
+::OpaqueStartServerLoginResult opaque_start_server_login(::rust::String server_setup, ::OpaqueStartServerLoginParams params);
+
+::OpaqueStartServerLoginResult opaque_start_server_login_with_setup(::ServerSetupHandle const &server_setup, ::OpaqueStartServerLoginParams params);
+
+::rust::Vec<::OpaqueStartServerLoginBatchResult> opaque_start_server_login_batch(::ServerSetupHandle const &server_setup, ::rust::Vec<::OpaqueStartServerLoginParams> requests) noexcept;
+
+// Validates the framing of a bulk registration import and returns
+// its number of records.
+::std::uint64_t opaque_count_registration_import_records(::rust::Slice<::std::uint8_t const> records);
+
+// Creates the registration responses for up to `max_records`
+// records from the front of `records`, spread across the available
+// cores. A failing record doesn't fail the chunk.
+::OpaqueRegistrationImportChunk opaque_create_server_registration_responses_chunk(::ServerSetupHandle const &server_setup, ::rust::Slice<::std::uint8_t const> records, ::std::size_t max_records);
+
+::rust::Box<::ServerLoginSessionStore> opaque_create_server_login_session_store(::std::uint32_t ttl_ms, ::std::size_t max_memory_bytes);
+
+// Number of pending login sessions.
+::std::size_t opaque_server_login_session_count(::ServerLoginSessionStore const &store) noexcept;
+
+// Same as `opaque_start_server_login_with_setup` but keeps the login
+// state in the store and returns a handle to it instead.
+::OpaqueStartServerLoginSessionResult opaque_start_server_login_session(::ServerLoginSessionStore const &store, ::ServerSetupHandle const &server_setup, ::OpaqueStartServerLoginParams params);
+
+// Finishes the login of the session and removes it from the store,
+// a session can only be finished once.
+::OpaqueFinishServerLoginResult opaque_finish_server_login_session(::ServerLoginSessionStore const &store, ::rust::Str session_handle, ::rust::Str finish_login_request);
 
 ::OpaqueFinishServerLoginResult opaque_finish_server_login(::OpaqueFinishServerLoginParams params);
+
+::OpaqueStartClientRegistrationBinaryResult opaque_start_client_registration_binary(::rust::Str password, ::OpaqueCipherSuite suite);
+
+::OpaqueFinishClientRegistrationBinaryResult opaque_finish_client_registration_binary(::rust::Str password, ::rust::Slice<::std::uint8_t const> registration_response, ::rust::Slice<::std::uint8_t const> client_registration_state, ::rust::Vec<::rust::String> client_identifier, ::rust::Vec<::rust::String> server_identifier, ::rust::Vec<::OpaqueKeyStretchingParams> key_stretching, ::OpaqueCipherSuite suite);
+
+::OpaqueStartClientLoginBinaryResult opaque_start_client_login_binary(::rust::Str password, ::OpaqueCipherSuite suite);
+
+::std::unique_ptr<::OpaqueFinishClientLoginBinaryResult> opaque_finish_client_login_binary(::rust::Slice<::std::uint8_t const> client_login_state, ::rust::Slice<::std::uint8_t const> login_response, ::rust::Str password, ::rust::Vec<::rust::String> client_identifier, ::rust::Vec<::rust::String> server_identifier, ::rust::Vec<::OpaqueKeyStretchingParams> key_stretching, ::OpaqueCipherSuite suite);
+
+::rust::Vec<::std::uint8_t> opaque_create_server_setup_binary(::OpaqueCipherSuite suite);
+
+::rust::Box<::ServerSetupHandle> opaque_create_server_setup_handle_binary(::rust::Slice<::std::uint8_t const> data, ::OpaqueCipherSuite suite);
+
+::rust::Vec<::std::uint8_t> opaque_get_server_public_key_binary(::rust::Slice<::std::uint8_t const> data, ::OpaqueCipherSuite suite);
+
+::rust::Vec<::std::uint8_t> opaque_get_server_public_key_with_setup_binary(::ServerSetupHandle const &server_setup) noexcept;
+
+void opaque_check_server_setup_suite(::ServerSetupHandle const &server_setup, ::OpaqueCipherSuite suite);
+
+::OpaqueCreateServerRegistrationResponseBinaryResult opaque_create_server_registration_response_binary(::rust::Slice<::std::uint8_t const> server_setup, ::rust::Str user_identifier, ::rust::Slice<::std::uint8_t const> registration_request, ::OpaqueCipherSuite suite);
+
+::OpaqueCreateServerRegistrationResponseBinaryResult opaque_create_server_registration_response_with_setup_binary(::ServerSetupHandle const &server_setup, ::rust::Str user_identifier, ::rust::Slice<::std::uint8_t const> registration_request);
+
+::OpaqueStartServerLoginBinaryResult opaque_start_server_login_binary(::rust::Slice<::std::uint8_t const> server_setup, ::rust::Slice<::std::uint8_t const> registration_record, bool has_registration_record, ::rust::Slice<::std::uint8_t const> start_login_request, ::rust::Str user_identifier, ::rust::Vec<::rust::String> client_identifier, ::rust::Vec<::rust::String> server_identifier, ::OpaqueCipherSuite suite);
+
+::OpaqueStartServerLoginBinaryResult opaque_start_server_login_with_setup_binary(::ServerSetupHandle const &server_setup, ::rust::Slice<::std::uint8_t const> registration_record, bool has_registration_record, ::rust::Slice<::std::uint8_t const> start_login_request, ::rust::Str user_identifier, ::rust::Vec<::rust::String> client_identifier, ::rust::Vec<::rust::String> server_identifier);
+
+::OpaqueFinishServerLoginBinaryResult opaque_finish_server_login_binary(::rust::Slice<::std::uint8_t const> server_login_state, ::rust::Slice<::std::uint8_t const> finish_login_request, ::OpaqueCipherSuite suite);
+
+::OpaqueStartClientRegistrationOutput opaque_start_client_registration_into(::rust::Str password, ::OpaqueCipherSuite suite, ::rust::Slice<::std::uint8_t> out);
+
+::OpaqueFinishClientRegistrationOutput opaque_finish_client_registration_into(::OpaqueFinishClientRegistrationInput input, ::rust::Slice<::std::uint8_t> out);
+
+::OpaqueStartClientLoginOutput opaque_start_client_login_into(::rust::Str password, ::OpaqueCipherSuite suite, ::rust::Slice<::std::uint8_t> out);
+
+::OpaqueFinishClientLoginOutput opaque_finish_client_login_into(::OpaqueFinishClientLoginInput input, ::rust::Slice<::std::uint8_t> out);
+
+// Returns the length of the registration response.
+::std::size_t opaque_create_server_registration_response_into(::rust::Str server_setup, ::OpaqueCreateServerRegistrationResponseInput input, ::rust::Slice<::std::uint8_t> out);
+
+// Returns the length of the registration response.
+::std::size_t opaque_create_server_registration_response_with_setup_into(::ServerSetupHandle const &server_setup, ::OpaqueCreateServerRegistrationResponseInput input, ::rust::Slice<::std::uint8_t> out);
+
+::OpaqueStartServerLoginOutput opaque_start_server_login_into(::rust::Str server_setup, ::OpaqueStartServerLoginInput input, ::rust::Slice<::std::uint8_t> out);
+
+::OpaqueStartServerLoginOutput opaque_start_server_login_with_setup_into(::ServerSetupHandle const &server_setup, ::OpaqueStartServerLoginInput input, ::rust::Slice<::std::uint8_t> out);
+
+// Returns the length of the session key.
+::std::size_t opaque_finish_server_login_into(::OpaqueFinishServerLoginInput input, ::rust::Slice<::std::uint8_t> out);
+
+// Variants of the login functions which don't throw, for the result
+// mode of the JSI module, see `status.rs`. On success the result is
+// stored in the last argument, otherwise it's left as is.
+
+::OpaqueStatus opaque_try_finish_client_login_into(::OpaqueFinishClientLoginInput input, ::rust::Slice<::std::uint8_t> out, ::OpaqueFinishClientLoginOutput &output) noexcept;
+
+::OpaqueStatus opaque_try_finish_client_login_context(::ClientLoginContext const &context, ::rust::Str login_response, ::rust::Slice<::std::uint8_t> out, ::OpaqueFinishClientLoginOutput &output) noexcept;
+
+::OpaqueStatus opaque_try_start_server_login_into(::rust::Str server_setup, ::OpaqueStartServerLoginInput input, ::rust::Slice<::std::uint8_t> out, ::OpaqueStartServerLoginOutput &output) noexcept;
+
+::OpaqueStatus opaque_try_start_server_login_with_setup_into(::ServerSetupHandle const &server_setup, ::OpaqueStartServerLoginInput input, ::rust::Slice<::std::uint8_t> out, ::OpaqueStartServerLoginOutput &output) noexcept;
+
+::OpaqueStatus opaque_try_finish_server_login_into(::OpaqueFinishServerLoginInput input, ::rust::Slice<::std::uint8_t> out, ::std::size_t &session_key) noexcept;
+
+// `out` only receives the error message.
+::OpaqueStatus opaque_try_start_server_login_session(::ServerLoginSessionStore const &store, ::ServerSetupHandle const &server_setup, ::OpaqueStartServerLoginParams params, ::rust::Slice<::std::uint8_t> out, ::OpaqueStartServerLoginSessionResult &result) noexcept;
+
+// `out` only receives the error message.
+::OpaqueStatus opaque_try_finish_server_login_session(::ServerLoginSessionStore const &store, ::rust::Str session_handle, ::rust::Str finish_login_request, ::rust::Slice<::std::uint8_t> out, ::OpaqueFinishServerLoginResult &result) noexcept;
+
+::OpaqueStatus opaque_try_start_server_login_binary(::rust::Slice<::std::uint8_t const> server_setup, ::rust::Slice<::std::uint8_t const> registration_record, bool has_registration_record, ::rust::Slice<::std::uint8_t const> start_login_request, ::rust::Str user_identifier, ::rust::Vec<::rust::String> client_identifier, ::rust::Vec<::rust::String> server_identifier, ::OpaqueCipherSuite suite, ::rust::Slice<::std::uint8_t> out, ::OpaqueStartServerLoginBinaryResult &result) noexcept;
+
+::OpaqueStatus opaque_try_start_server_login_with_setup_binary(::ServerSetupHandle const &server_setup, ::rust::Slice<::std::uint8_t const> registration_record, bool has_registration_record, ::rust::Slice<::std::uint8_t const> start_login_request, ::rust::Str user_identifier, ::rust::Vec<::rust::String> client_identifier, ::rust::Vec<::rust::String> server_identifier, ::rust::Slice<::std::uint8_t> out, ::OpaqueStartServerLoginBinaryResult &result) noexcept;
+
+::OpaqueStatus opaque_try_finish_server_login_binary(::rust::Slice<::std::uint8_t const> server_login_state, ::rust::Slice<::std::uint8_t const> finish_login_request, ::OpaqueCipherSuite suite, ::rust::Slice<::std::uint8_t> out, ::OpaqueFinishServerLoginBinaryResult &result) noexcept;
+
+// `result` is left empty if the client detected a login failure.
+::OpaqueStatus opaque_try_finish_client_login_binary(::rust::Slice<::std::uint8_t const> client_login_state, ::rust::Slice<::std::uint8_t const> login_response, ::rust::Str password, ::rust::Vec<::rust::String> client_identifier, ::rust::Vec<::rust::String> server_identifier, ::rust::Vec<::OpaqueKeyStretchingParams> key_stretching, ::OpaqueCipherSuite suite, ::rust::Slice<::std::uint8_t> out, ::OpaqueFinishClientLoginBinaryResult &result) noexcept;
+
+void opaque_set_metrics_enabled(bool enabled) noexcept;
+
+::rust::Vec<::OpaqueMetricsEntry> opaque_get_metrics() noexcept;
+
+void opaque_reset_metrics() noexcept;
+
+// Marks the start and end of a call of `function` on the current
+// thread, no-ops while the metrics are disabled.
+void opaque_metrics_begin(::OpaqueMetricsFunction function) noexcept;
+
+void opaque_metrics_end() noexcept;
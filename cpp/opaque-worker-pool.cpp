@@ -0,0 +1,108 @@
+#include "./opaque-worker-pool.h"
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace NativeOpaque {
+
+  WorkerPool::WorkerPool(size_t threadCount, size_t queueCapacity)
+    : queueCapacity_(queueCapacity) {
+    threadCount = std::max<size_t>(threadCount, 1);
+    threads_.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; i++) {
+      threads_.emplace_back([this] { workerLoop(); });
+    }
+  }
+
+  WorkerPool::~WorkerPool() {
+    std::deque<std::pair<JobId, std::shared_ptr<Job>>> dropped;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+      dropped.swap(queue_);
+    }
+    cv_.notify_all();
+    for (auto& thread : threads_) {
+      thread.join();
+    }
+    for (auto& entry : dropped) {
+      entry.second->abandon();
+    }
+  }
+
+  WorkerPool::JobId WorkerPool::submit(std::shared_ptr<Job> job) {
+    JobId id;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (stopping_ || queue_.size() >= queueCapacity_) {
+        return 0;
+      }
+      id = nextId_++;
+      queue_.emplace_back(id, std::move(job));
+    }
+    cv_.notify_one();
+    return id;
+  }
+
+  size_t WorkerPool::queued() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queue_.size();
+  }
+
+  bool WorkerPool::cancel(JobId id) {
+    std::shared_ptr<Job> discarded;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto queued = std::find_if(queue_.begin(), queue_.end(),
+        [id](const std::pair<JobId, std::shared_ptr<Job>>& entry) { return entry.first == id; });
+      if (queued != queue_.end()) {
+        discarded = std::move(queued->second);
+        queue_.erase(queued);
+      } else {
+        auto running = running_.find(id);
+        if (running == running_.end()) {
+          return false;
+        }
+        running->second->cancelled_.store(true, std::memory_order_release);
+        return true;
+      }
+    }
+    discarded->discard();
+    return true;
+  }
+
+  void WorkerPool::workerLoop() {
+    for (;;) {
+      JobId id;
+      std::shared_ptr<Job> job;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+        if (stopping_) {
+          return;
+        }
+        id = queue_.front().first;
+        job = std::move(queue_.front().second);
+        queue_.pop_front();
+        running_.emplace(id, job);
+      }
+      job->run();
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_.erase(id);
+      }
+    }
+  }
+
+  WorkerPool& WorkerPool::shared() {
+    // Key stretching is memory bound, running more than a couple of Argon2
+    // instances at once only increases the memory pressure on the device.
+    static WorkerPool pool(
+      std::min<size_t>(std::max<size_t>(std::thread::hardware_concurrency() / 2, 1), 2),
+      64);
+    return pool;
+  }
+
+}  // namespace NativeOpaque
@@ -0,0 +1,92 @@
+#ifndef CPP_OPAQUE_WORKER_POOL_H_
+#define CPP_OPAQUE_WORKER_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace NativeOpaque {
+
+  // A fixed size pool of native worker threads with a bounded job queue.
+  //
+  // The pool is used to run the expensive parts of the protocol (mostly the
+  // Argon2 key stretching) off the JS thread. It never grows beyond the
+  // configured number of threads since every running KSF invocation holds
+  // its full Argon2 memory matrix.
+  class WorkerPool {
+   public:
+    using JobId = uint64_t;
+
+    class Job {
+     public:
+      virtual ~Job() = default;
+
+      // Executed on a worker thread.
+      virtual void run() = 0;
+
+      // Called instead of run() if the job was cancelled while still queued.
+      virtual void discard() = 0;
+
+      // Called instead of run() if the pool is destroyed before the job was
+      // started, which only happens at process exit. The runtime that
+      // submitted the job may already be gone, so the job must neither
+      // settle nor touch any of its JS values.
+      virtual void abandon() = 0;
+
+      // Set when the job got cancelled while it was already running. The
+      // computation itself can't be interrupted, but its result should be
+      // dropped.
+      bool isCancelled() const {
+        return cancelled_.load(std::memory_order_acquire);
+      }
+
+     private:
+      friend class WorkerPool;
+      std::atomic<bool> cancelled_{false};
+    };
+
+    WorkerPool(size_t threadCount, size_t queueCapacity);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // Queues the job and returns its id, or 0 if the queue is full.
+    JobId submit(std::shared_ptr<Job> job);
+
+    // Cancels a queued or running job. A running job is only marked and
+    // keeps its thread until it returns. Returns false if the job is unknown
+    // or already finished.
+    bool cancel(JobId id);
+
+    size_t threadCount() const { return threads_.size(); }
+
+    // Number of jobs waiting for a thread.
+    size_t queued();
+
+    // Process wide pool shared by all installed runtimes.
+    static WorkerPool& shared();
+
+   private:
+    void workerLoop();
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::pair<JobId, std::shared_ptr<Job>>> queue_;
+    std::unordered_map<JobId, std::shared_ptr<Job>> running_;
+    std::vector<std::thread> threads_;
+    JobId nextId_ = 1;
+    size_t queueCapacity_;
+    bool stopping_ = false;
+  };
+
+}  // namespace NativeOpaque
+
+#endif  // CPP_OPAQUE_WORKER_POOL_H_
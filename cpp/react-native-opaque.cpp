@@ -1,246 +1,1451 @@
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <sstream>
 #include <string>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 #include "jsi/jsilib.h"
 #include "jsi/jsi.h"
 #include "react-native-opaque.h"
+#include "./opaque-marshalling.h"
 #include "./opaque-rust.h"
+#include "./opaque-worker-pool.h"
 
 namespace NativeOpaque {
   namespace jsi = facebook::jsi;
-  using OpaqueFunc1 = std::function<jsi::Value(jsi::Runtime&, jsi::Value&)>;
+  namespace react = facebook::react;
+  using OpaqueFunc1 = std::function<jsi::Value(jsi::Runtime&, const PropNames&, jsi::Value&)>;
 
-  ::rust::Vec<::rust::String>
-    getOptional(jsi::Runtime& rt, jsi::Object& obj, const char* propName) {
-    auto result = ::rust::Vec<::rust::String>();
-    auto prop = obj.getProperty(rt, propName);
-    if (prop.isString()) {
-      result.push_back(std::string(prop.getString(rt).utf8(rt)));
+  // The error of a failed login in the result mode, see installTryFunc1.
+  struct Failure {
+    OpaqueErrorCode code = OpaqueErrorCode::None;
+    jsi::Value message;
+  };
+
+  using OpaqueTryFunc1 = std::function<jsi::Value(jsi::Runtime&, const PropNames&, jsi::Value&, Failure&)>;
+
+  // Attributes the phases measured by Rust during its lifetime to
+  // `function`, and the rest of the time to marshalling. A no-op while the
+  // metrics are disabled, see rust/src/metrics.rs.
+  class MetricsScope {
+   public:
+    explicit MetricsScope(OpaqueMetricsFunction function) { opaque_metrics_begin(function); }
+    ~MetricsScope() { opaque_metrics_end(); }
+    MetricsScope(const MetricsScope&) = delete;
+    MetricsScope& operator=(const MetricsScope&) = delete;
+  };
+
+  // The id of the PrepareLoginFinishJob waiting for a worker thread, or 0.
+  // There's at most one queued since they all prepare the next finish.
+  std::mutex queuedPrepareMutex;
+  WorkerPool::JobId queuedPrepareId = 0;
+
+  // Drops the queued preparation of the login finish, which would otherwise
+  // compete with the finish for the worker threads or run after it.
+  void cancelQueuedPrepare() {
+    WorkerPool::JobId id;
+    {
+      std::lock_guard<std::mutex> lock(queuedPrepareMutex);
+      id = std::exchange(queuedPrepareId, 0);
+    }
+    // cancel() calls discard() of the job, which takes the lock as well
+    if (id != 0) {
+      WorkerPool::shared().cancel(id);
     }
+  }
+
+  // The sync string functions use the `*_into` variants of the bridge: Rust
+  // borrows the strings read from JS and writes the results into a buffer on
+  // the stack, from which the JS strings are created. The async variants
+  // can't borrow and keep using the owned params and results.
+  //
+  // The login functions which fail on a wrong password or a forged message
+  // use the `opaque_try_*` variants and report the error in `failure`
+  // instead of throwing it, so a failed login doesn't unwind.
+
+  // Returns true and fills in `failure` if an `opaque_try_*` call failed.
+  bool failed(jsi::Runtime& rt, const OpaqueStatus& status, OutputBuffer& out, Failure& failure) {
+    if (status.code == OpaqueErrorCode::None) {
+      return false;
+    }
+    failure.code = status.code;
+    failure.message = out.message(rt, status.message);
+    return true;
+  }
+
+  jsi::Value startClientRegistration(jsi::Runtime& rt, const PropNames& names, jsi::Value& input) {
+    MetricsScope metrics(OpaqueMetricsFunction::StartClientRegistration);
+    auto obj = input.asObject(rt);
+    auto password = getProp(rt, obj, names.password).utf8(rt);
+    OutputBuffer out;
+    auto lengths = opaque_start_client_registration_into(password, getCipherSuite(rt, names, obj), out.slice());
+    auto result = jsi::Object(rt);
+    result.setProperty(rt, names.clientRegistrationState, out.next(rt, lengths.client_registration_state));
+    result.setProperty(rt, names.registrationRequest, out.next(rt, lengths.registration_request));
     return result;
   }
 
-  std::string kindToString(const jsi::Value& v, jsi::Runtime& rt) {
-    if (v.isUndefined()) {
-      return "undefined";
-    } else if (v.isNull()) {
-      return "null";
-    } else if (v.isBool()) {
-      return v.getBool() ? "true" : "false";
-    } else if (v.isNumber()) {
-      return "a number";
-    } else if (v.isString()) {
-      return "a string";
-    } else if (v.isSymbol()) {
-      return "a symbol";
-    } else if (v.isBigInt()) {
-      return "a bigint";
-    } else {
-      assert(v.isObject() && "Expecting object.");
-      return v.getObject(rt).isFunction(rt) ? "a function"
-        : "an object";
+  jsi::Value finishClientRegistration(jsi::Runtime& rt, const PropNames& names, jsi::Value& input) {
+    MetricsScope metrics(OpaqueMetricsFunction::FinishClientRegistration);
+    auto obj = input.asObject(rt);
+    auto password = getProp(rt, obj, names.password).utf8(rt);
+    auto registrationResponse = getProp(rt, obj, names.registrationResponse).utf8(rt);
+    auto clientRegistrationState = getProp(rt, obj, names.clientRegistrationState).utf8(rt);
+    auto clientIdentifier = readIdentifier(rt, names, obj, names.client);
+    auto serverIdentifier = readIdentifier(rt, names, obj, names.server);
+    auto keyStretching = readKeyStretching(rt, names, obj);
+    auto suite = getCipherSuite(rt, names, obj);
+    OutputBuffer out;
+    auto lengths = opaque_finish_client_registration_into({
+        .password = password,
+        .registration_response = registrationResponse,
+        .client_registration_state = clientRegistrationState,
+        .client_identifier = borrowOptional(clientIdentifier),
+        .has_client_identifier = clientIdentifier.has_value(),
+        .server_identifier = borrowOptional(serverIdentifier),
+        .has_server_identifier = serverIdentifier.has_value(),
+        .key_stretching = keyStretching.value_or(OpaqueKeyStretchingParams{}),
+        .has_key_stretching = keyStretching.has_value(),
+        .suite = suite,
+    }, out.slice());
+    auto result = jsi::Object(rt);
+    result.setProperty(rt, names.registrationRecord, out.next(rt, lengths.registration_record));
+    result.setProperty(rt, names.exportKey, out.next(rt, lengths.export_key));
+    result.setProperty(rt, names.serverStaticPublicKey, out.next(rt, lengths.server_static_public_key));
+    result.setProperty(rt, names.keyStretching, makeKeyStretching(rt, names, lengths.key_stretching));
+    return result;
+  }
+
+  jsi::Value startClientLogin(jsi::Runtime& rt, const PropNames& names, jsi::Value& input) {
+    MetricsScope metrics(OpaqueMetricsFunction::StartClientLogin);
+    auto obj = input.asObject(rt);
+    auto password = getProp(rt, obj, names.password).utf8(rt);
+    OutputBuffer out;
+    auto lengths = opaque_start_client_login_into(password, getCipherSuite(rt, names, obj), out.slice());
+    auto result = jsi::Object(rt);
+    result.setProperty(rt, names.clientLoginState, out.next(rt, lengths.client_login_state));
+    result.setProperty(rt, names.startLoginRequest, out.next(rt, lengths.start_login_request));
+    return result;
+  }
+
+  jsi::Value makeFinishClientLoginOutput(jsi::Runtime& rt, const PropNames& names, OutputBuffer& out,
+    const OpaqueFinishClientLoginOutput& lengths) {
+    if (!lengths.success) {
+      return jsi::Value::undefined();
+    }
+    auto result = jsi::Object(rt);
+    result.setProperty(rt, names.finishLoginRequest, out.next(rt, lengths.finish_login_request));
+    result.setProperty(rt, names.sessionKey, out.next(rt, lengths.session_key));
+    result.setProperty(rt, names.exportKey, out.next(rt, lengths.export_key));
+    result.setProperty(rt, names.serverStaticPublicKey, out.next(rt, lengths.server_static_public_key));
+    return result;
+  }
+
+  jsi::Value finishClientLogin(jsi::Runtime& rt, const PropNames& names, jsi::Value& input, Failure& failure) {
+    MetricsScope metrics(OpaqueMetricsFunction::FinishClientLogin);
+    cancelQueuedPrepare();
+    auto obj = input.asObject(rt);
+    auto clientLoginState = getProp(rt, obj, names.clientLoginState).utf8(rt);
+    auto loginResponse = getProp(rt, obj, names.loginResponse).utf8(rt);
+    auto password = getProp(rt, obj, names.password).utf8(rt);
+    auto clientIdentifier = readIdentifier(rt, names, obj, names.client);
+    auto serverIdentifier = readIdentifier(rt, names, obj, names.server);
+    auto keyStretching = readKeyStretching(rt, names, obj);
+    auto suite = getCipherSuite(rt, names, obj);
+    OutputBuffer out;
+    OpaqueFinishClientLoginOutput lengths;
+    auto status = opaque_try_finish_client_login_into({
+        .client_login_state = clientLoginState,
+        .login_response = loginResponse,
+        .password = password,
+        .client_identifier = borrowOptional(clientIdentifier),
+        .has_client_identifier = clientIdentifier.has_value(),
+        .server_identifier = borrowOptional(serverIdentifier),
+        .has_server_identifier = serverIdentifier.has_value(),
+        .key_stretching = keyStretching.value_or(OpaqueKeyStretchingParams{}),
+        .has_key_stretching = keyStretching.has_value(),
+        .suite = suite,
+    }, out.slice(), lengths);
+    if (failed(rt, status, out, failure)) {
+      return jsi::Value::undefined();
+    }
+    return makeFinishClientLoginOutput(rt, names, out, lengths);
+  }
+
+  // Keeps a started client login in native memory until it's finished, so
+  // the state isn't serialized and the password only passed in once. The
+  // Rust side zeroizes the state once it's finished or the context collected.
+  class ClientLoginContextHostObject : public jsi::HostObject {
+   public:
+    explicit ClientLoginContextHostObject(::rust::Box<ClientLoginContext> context) : context_(std::move(context)) {}
+
+    const ClientLoginContext& context() const { return *context_; }
+
+   private:
+    ::rust::Box<ClientLoginContext> context_;
+  };
+
+  jsi::Value startClientLoginContext(jsi::Runtime& rt, const PropNames& names, jsi::Value& input) {
+    MetricsScope metrics(OpaqueMetricsFunction::StartClientLogin);
+    auto obj = input.asObject(rt);
+    auto password = getProp(rt, obj, names.password).utf8(rt);
+    auto clientIdentifier = readIdentifier(rt, names, obj, names.client);
+    auto serverIdentifier = readIdentifier(rt, names, obj, names.server);
+    auto keyStretching = readKeyStretching(rt, names, obj);
+    ::rust::String startLoginRequest;
+    auto context = opaque_start_client_login_context({
+        .password = password,
+        .client_identifier = borrowOptional(clientIdentifier),
+        .has_client_identifier = clientIdentifier.has_value(),
+        .server_identifier = borrowOptional(serverIdentifier),
+        .has_server_identifier = serverIdentifier.has_value(),
+        .key_stretching = keyStretching.value_or(OpaqueKeyStretchingParams{}),
+        .has_key_stretching = keyStretching.has_value(),
+        .suite = getCipherSuite(rt, names, obj),
+    }, startLoginRequest);
+    auto result = jsi::Object(rt);
+    result.setProperty(rt, names.startLoginRequest, makeString(rt, startLoginRequest));
+    result.setProperty(rt, names.context,
+      jsi::Object::createFromHostObject(rt, std::make_shared<ClientLoginContextHostObject>(std::move(context))));
+    return result;
+  }
+
+  std::shared_ptr<ClientLoginContextHostObject> getClientLoginContext(jsi::Runtime& rt, const jsi::Value& value) {
+    if (!value.isObject() || !value.getObject(rt).isHostObject<ClientLoginContextHostObject>(rt)) {
+      throw jsi::JSError(rt, "context must be a client login context");
     }
+    return value.getObject(rt).getHostObject<ClientLoginContextHostObject>(rt);
   }
 
-  jsi::String getProp(jsi::Runtime& rt, jsi::Object& obj, const char* propName) {
-    if (!obj.hasProperty(rt, propName)) {
-      throw jsi::JSError(rt, "missing required property \""
-        + std::string(propName) + "\" in input params");
+  jsi::Value finishClientLoginContext(jsi::Runtime& rt, const PropNames& names, jsi::Value& input,
+    Failure& failure) {
+    MetricsScope metrics(OpaqueMetricsFunction::FinishClientLogin);
+    cancelQueuedPrepare();
+    auto obj = input.asObject(rt);
+    auto context = getClientLoginContext(rt, obj.getProperty(rt, names.context));
+    auto loginResponse = getProp(rt, obj, names.loginResponse).utf8(rt);
+    OutputBuffer out;
+    OpaqueFinishClientLoginOutput lengths;
+    auto status = opaque_try_finish_client_login_context(context->context(), loginResponse, out.slice(), lengths);
+    if (failed(rt, status, out, failure)) {
+      return jsi::Value::undefined();
     }
-    auto prop = obj.getProperty(rt, propName);
-    if (!prop.isString()) {
-      throw jsi::JSError(rt, "property \"" + std::string(propName)
-        + "\" has invalid type, expected string but got " + kindToString(prop, rt));
+    return makeFinishClientLoginOutput(rt, names, out, lengths);
+  }
+
+  jsi::Value calibrateKeyStretching(jsi::Runtime& rt, const PropNames& names, jsi::Value& input) {
+    auto obj = input.asObject(rt);
+    uint32_t parallelism = 1;
+    if (!obj.getProperty(rt, names.parallelism).isUndefined()) {
+      parallelism = getUint32Prop(rt, obj, names.parallelism);
     }
-    return prop.getString(rt);
+    auto params = opaque_calibrate_key_stretching(getUint32Prop(rt, obj, names.targetDurationMs), parallelism);
+    return makeKeyStretching(rt, names, params);
   }
 
-  jsi::Value startClientRegistration(jsi::Runtime& rt, jsi::Value& input) {
+  jsi::Value prewarmKeyStretching(jsi::Runtime& rt, const PropNames& names, jsi::Value& input) {
     auto obj = input.asObject(rt);
-    struct OpaqueStartClientRegistrationParams params = {
-        .password = getProp(rt, obj, "password").utf8(rt),
-    };
-    auto clientStartResult = opaque_start_client_registration(params);
+    opaque_prewarm_key_stretching(getKeyStretching(rt, names, obj));
+    return jsi::Value::undefined();
+  }
+
+  jsi::Value releaseKeyStretchingMemory(jsi::Runtime& rt, const PropNames& names, const jsi::Value* args) {
+    opaque_release_key_stretching_memory();
+    return jsi::Value::undefined();
+  }
+
+  void trimMemory() {
+    opaque_trim_key_stretching_memory();
+  }
+
+  jsi::Value getCpuTopology(jsi::Runtime& rt, const PropNames& names, const jsi::Value* args) {
+    auto topology = opaque_get_cpu_topology();
     auto result = jsi::Object(rt);
-    result.setProperty(rt, "clientRegistrationState",
-      std::string(clientStartResult.client_registration_state));
-    result.setProperty(rt, "registrationRequest",
-      std::string(clientStartResult.registration_request));
+    result.setProperty(rt, names.cores, static_cast<double>(topology.cores));
+    result.setProperty(rt, names.performanceCores, static_cast<double>(topology.performance_cores));
     return result;
   }
 
-  ::rust::Vec<::rust::String> getIdentifier(jsi::Runtime& rt, jsi::Object& obj, const char* name) {
-    auto result = ::rust::Vec<::rust::String>();
-    if (!obj.hasProperty(rt, "identifiers"))
-      return result;
-    auto identsProp = obj.getProperty(rt, "identifiers");
-    if (identsProp.isUndefined() || identsProp.isNull()) {
-      return result;
+  jsi::Value createServerSetup(jsi::Runtime& rt, const PropNames& names, jsi::Value& input) {
+    auto setup = opaque_create_server_setup(getCipherSuite(rt, names, input));
+    return makeString(rt, setup);
+  }
+
+  // Keeps a decoded server setup in native memory so the server functions
+  // don't have to decode and validate the base64 string on every call.
+  class ServerSetupHostObject : public jsi::HostObject {
+   public:
+    explicit ServerSetupHostObject(::rust::Box<ServerSetupHandle> setup) : setup_(std::move(setup)) {}
+
+    const ServerSetupHandle& setup() const { return *setup_; }
+
+   private:
+    ::rust::Box<ServerSetupHandle> setup_;
+  };
+
+  jsi::Value createServerSetupHandle(jsi::Runtime& rt, const PropNames& names, const jsi::Value* args) {
+    const auto& input = args[0];
+    auto suite = getCipherSuite(rt, names, args[1]);
+    if (input.isString()) {
+      auto setup = opaque_create_server_setup_handle(input.getString(rt).utf8(rt), suite);
+      return jsi::Object::createFromHostObject(rt, std::make_shared<ServerSetupHostObject>(std::move(setup)));
     }
-    if (!identsProp.isObject()) {
-      throw jsi::JSError(rt, "\"identifiers\" must be an object");
+    auto bytes = asBinary(rt, names, input);
+    if (!bytes) {
+      throw jsi::JSError(rt, "serverSetup has invalid type, expected string, Uint8Array or ArrayBuffer but got "
+        + kindToString(input, rt));
     }
-    auto identsObj = identsProp.asObject(rt);
-    if (identsObj.hasProperty(rt, name)) {
-      auto prop = identsObj.getProperty(rt, name);
-      if (!prop.isString()) {
-        throw jsi::JSError(rt, "identifier \"" + std::string(name) + "\" must be a string");
+    auto setup = opaque_create_server_setup_handle_binary(bytes->slice(rt), suite);
+    return jsi::Object::createFromHostObject(rt, std::make_shared<ServerSetupHostObject>(std::move(setup)));
+  }
+
+  // See ServerSetupKeyring.
+  class ServerSetupKeyringHostObject : public jsi::HostObject, public ServerSetupKeyring<ServerSetupHostObject> {
+   public:
+    // not HostObject::get
+    using ServerSetupKeyring<ServerSetupHostObject>::get;
+  };
+
+  // The key selected by the optional `keyId` of `params`, which can be
+  // nullptr for the active key.
+  std::shared_ptr<ServerSetupHostObject> selectServerSetupKey(jsi::Runtime& rt, const PropNames& names,
+    const ServerSetupKeyringHostObject& keyring, jsi::Object* params) {
+    auto keyIdProp = params ? params->getProperty(rt, names.keyId) : jsi::Value::undefined();
+    if (keyIdProp.isUndefined()) {
+      if (!keyring.active()) {
+        throw jsi::JSError(rt, kEmptyKeyringMessage);
       }
-      result.push_back(std::string(prop.asString(rt).utf8(rt)));
+      return keyring.active();
     }
-    return result;
+    auto keyId = asStringProp(rt, *params, names.keyId, keyIdProp).utf8(rt);
+    auto setup = keyring.get(keyId);
+    if (!setup) {
+      throw jsi::JSError(rt, unknownServerSetupKeyMessage(keyId));
+    }
+    return setup;
   }
 
-  jsi::Value finishClientRegistration(jsi::Runtime& rt, jsi::Value& input) {
+  // Returns nullptr if the value is neither a server setup handle nor a
+  // keyring. Of a keyring the key selected by `params` is returned, see
+  // selectServerSetupKey.
+  std::shared_ptr<ServerSetupHostObject> asServerSetupHandle(jsi::Runtime& rt, const PropNames& names,
+    const jsi::Value& value, jsi::Object* params) {
+    if (!value.isObject()) {
+      return nullptr;
+    }
+    auto obj = value.getObject(rt);
+    if (obj.isHostObject<ServerSetupHostObject>(rt)) {
+      return obj.getHostObject<ServerSetupHostObject>(rt);
+    }
+    if (obj.isHostObject<ServerSetupKeyringHostObject>(rt)) {
+      return selectServerSetupKey(rt, names, *obj.getHostObject<ServerSetupKeyringHostObject>(rt), params);
+    }
+    return nullptr;
+  }
+
+  // The server functions accept either the base64 encoded server setup, a
+  // handle created by opaque_createServerSetupHandle or a keyring. Returns
+  // nullptr if the value is a string.
+  std::shared_ptr<ServerSetupHostObject> getServerSetupHandle(jsi::Runtime& rt, const PropNames& names,
+    const jsi::Value& value, jsi::Object* params) {
+    auto handle = asServerSetupHandle(rt, names, value, params);
+    if (!handle && value.isObject()) {
+      throw jsi::JSError(rt, kInvalidServerSetupMessage);
+    }
+    return handle;
+  }
+
+  // The params of the functions taking them as a separate argument, which
+  // can be undefined.
+  std::optional<jsi::Object> getParams(jsi::Runtime& rt, const jsi::Value& params) {
+    if (params.isUndefined() || params.isNull()) {
+      return std::nullopt;
+    }
+    return params.asObject(rt);
+  }
+
+  jsi::Value createServerSetupKeyring(jsi::Runtime& rt, const PropNames& names, const jsi::Value* args) {
+    return jsi::Object::createFromHostObject(rt, std::make_shared<ServerSetupKeyringHostObject>());
+  }
+
+  std::shared_ptr<ServerSetupKeyringHostObject> getServerSetupKeyring(jsi::Runtime& rt, const jsi::Value& value) {
+    if (!value.isObject() || !value.getObject(rt).isHostObject<ServerSetupKeyringHostObject>(rt)) {
+      throw jsi::JSError(rt, kInvalidKeyringMessage);
+    }
+    return value.getObject(rt).getHostObject<ServerSetupKeyringHostObject>(rt);
+  }
+
+  // Adds the server setup (base64 string, bytes or handle) under `keyId`. A
+  // key ID can't be reused while the key is in the keyring, so the records
+  // stored with it can't silently switch to another key.
+  jsi::Value addServerSetupKey(jsi::Runtime& rt, const PropNames& names, jsi::Value& input) {
     auto obj = input.asObject(rt);
+    auto keyring = getServerSetupKeyring(rt, obj.getProperty(rt, names.keyring));
+    auto keyId = getProp(rt, obj, names.keyId).utf8(rt);
+    auto suite = getCipherSuite(rt, names, obj);
+    auto serverSetupProp = obj.getProperty(rt, names.serverSetup);
+    std::shared_ptr<ServerSetupHostObject> setup;
+    if (serverSetupProp.isString()) {
+      setup = std::make_shared<ServerSetupHostObject>(
+        opaque_create_server_setup_handle(serverSetupProp.getString(rt).utf8(rt), suite));
+    } else if (serverSetupProp.isObject() && serverSetupProp.getObject(rt).isHostObject<ServerSetupHostObject>(rt)) {
+      setup = serverSetupProp.getObject(rt).getHostObject<ServerSetupHostObject>(rt);
+      opaque_check_server_setup_suite(setup->setup(), suite);
+    } else {
+      auto bytes = asBinaryProp(rt, names, obj, names.serverSetup, serverSetupProp);
+      setup = std::make_shared<ServerSetupHostObject>(opaque_create_server_setup_handle_binary(bytes.slice(rt), suite));
+    }
+    if (!keyring->add(keyId, std::move(setup))) {
+      throw jsi::JSError(rt, duplicateServerSetupKeyMessage(keyId));
+    }
+    return jsi::Value::undefined();
+  }
 
-    struct OpaqueFinishClientRegistrationParams params = {
-        .password = getProp(rt, obj, "password").utf8(rt),
-        .registration_response = getProp(rt, obj, "registrationResponse").utf8(rt),
-        .client_registration_state = getProp(rt, obj, "clientRegistrationState").utf8(rt),
-        .client_identifier = getIdentifier(rt, obj, "client"),
-        .server_identifier = getIdentifier(rt, obj, "server"),
-    };
+  jsi::Value setActiveServerSetupKey(jsi::Runtime& rt, const PropNames& names, jsi::Value& input) {
+    auto obj = input.asObject(rt);
+    auto keyring = getServerSetupKeyring(rt, obj.getProperty(rt, names.keyring));
+    auto keyId = getProp(rt, obj, names.keyId).utf8(rt);
+    if (!keyring->setActive(keyId)) {
+      throw jsi::JSError(rt, unknownServerSetupKeyMessage(keyId));
+    }
+    return jsi::Value::undefined();
+  }
+
+  // Returns whether the key was in the keyring. Handles and registration
+  // imports already taken from the keyring keep the server setup alive.
+  jsi::Value removeServerSetupKey(jsi::Runtime& rt, const PropNames& names, jsi::Value& input) {
+    auto obj = input.asObject(rt);
+    auto keyring = getServerSetupKeyring(rt, obj.getProperty(rt, names.keyring));
+    auto keyId = getProp(rt, obj, names.keyId).utf8(rt);
+    if (keyring->active() && keyId == keyring->activeKeyId()) {
+      throw jsi::JSError(rt, kRemoveActiveKeyMessage);
+    }
+    return keyring->remove(keyId);
+  }
 
-    auto finish = opaque_finish_client_registration(params);
+  jsi::Value getServerSetupKeys(jsi::Runtime& rt, const PropNames& names, jsi::Value& input) {
+    auto keyring = getServerSetupKeyring(rt, input);
+    auto keyIds = jsi::Array(rt, keyring->keys().size());
+    size_t i = 0;
+    for (const auto& [keyId, setup] : keyring->keys()) {
+      keyIds.setValueAtIndex(rt, i++, jsi::String::createFromUtf8(rt, keyId));
+    }
     auto result = jsi::Object(rt);
-    result.setProperty(rt, "exportKey", std::string(finish.export_key));
-    result.setProperty(rt, "registrationRecord", std::string(finish.registration_record));
-    result.setProperty(rt, "serverStaticPublicKey", std::string(finish.server_static_public_key));
+    if (keyring->active()) {
+      result.setProperty(rt, names.activeKeyId, jsi::String::createFromUtf8(rt, keyring->activeKeyId()));
+    }
+    result.setProperty(rt, names.keyIds, std::move(keyIds));
     return result;
   }
 
-  jsi::Value startClientLogin(jsi::Runtime& rt, jsi::Value& input) {
-    auto jsParams = input.asObject(rt);
-    struct OpaqueStartClientLoginParams params = {
-        .password = getProp(rt, jsParams, "password").utf8(rt),
+  jsi::Value getServerPublicKey(jsi::Runtime& rt, const PropNames& names, const jsi::Value* args) {
+    const auto& input = args[0];
+    auto suite = getCipherSuite(rt, names, args[1]);
+    auto params = getParams(rt, args[1]);
+    auto handle = getServerSetupHandle(rt, names, input, params ? &*params : nullptr);
+    if (handle) {
+      opaque_check_server_setup_suite(handle->setup(), suite);
+      auto pubkey = opaque_get_server_public_key_with_setup(handle->setup());
+      return makeString(rt, pubkey);
+    }
+    auto str = input.asString(rt);
+    auto pubkey = opaque_get_server_public_key(str.utf8(rt), suite);
+    return makeString(rt, pubkey);
+  }
+
+  jsi::Value createServerRegistrationResponse(jsi::Runtime& rt, const PropNames& names, jsi::Value& input) {
+    MetricsScope metrics(OpaqueMetricsFunction::CreateServerRegistrationResponse);
+    auto obj = input.asObject(rt);
+    auto serverSetupProp = obj.getProperty(rt, names.serverSetup);
+    auto handle = getServerSetupHandle(rt, names, serverSetupProp, &obj);
+    auto serverSetup = handle ? std::string() : asStringProp(rt, obj, names.serverSetup, serverSetupProp).utf8(rt);
+    auto userIdentifier = getProp(rt, obj, names.userIdentifier).utf8(rt);
+    auto registrationRequest = getProp(rt, obj, names.registrationRequest).utf8(rt);
+    OpaqueCreateServerRegistrationResponseInput params = {
+        .user_identifier = userIdentifier,
+        .registration_request = registrationRequest,
+        .suite = getCipherSuite(rt, names, obj),
     };
-    auto result = opaque_start_client_login(params);
-    auto jsResult = jsi::Object(rt);
-    jsResult.setProperty(rt, "clientLoginState", std::string(result.client_login_state));
-    jsResult.setProperty(rt, "startLoginRequest", std::string(result.start_login_request));
-    return jsResult;
+    OutputBuffer out;
+    auto length = handle
+      ? opaque_create_server_registration_response_with_setup_into(handle->setup(), params, out.slice())
+      : opaque_create_server_registration_response_into(serverSetup, params, out.slice());
+    auto ret = jsi::Object(rt);
+    ret.setProperty(rt, names.registrationResponse, out.next(rt, length));
+    return ret;
   }
 
-  jsi::Value finishClientLogin(jsi::Runtime& rt, jsi::Value& input) {
+  jsi::Value startServerLogin(jsi::Runtime& rt, const PropNames& names, jsi::Value& input, Failure& failure) {
+    MetricsScope metrics(OpaqueMetricsFunction::StartServerLogin);
     auto obj = input.asObject(rt);
-    struct OpaqueFinishClientLoginParams params = {
-        .client_login_state = getProp(rt, obj, "clientLoginState").utf8(rt),
-        .login_response = getProp(rt, obj, "loginResponse").utf8(rt),
-        .password = getProp(rt, obj, "password").utf8(rt),
-        .client_identifier = getIdentifier(rt, obj, "client"),
-        .server_identifier = getIdentifier(rt, obj, "server"),
+    auto serverSetupProp = obj.getProperty(rt, names.serverSetup);
+    auto handle = getServerSetupHandle(rt, names, serverSetupProp, &obj);
+    auto serverSetup = handle ? std::string() : asStringProp(rt, obj, names.serverSetup, serverSetupProp).utf8(rt);
+    auto registrationRecordProp = obj.getProperty(rt, names.registrationRecord);
+    auto registrationRecord = registrationRecordProp.isString()
+      ? std::optional(registrationRecordProp.getString(rt).utf8(rt)) : std::nullopt;
+    auto startLoginRequest = getProp(rt, obj, names.startLoginRequest).utf8(rt);
+    auto userIdentifier = getProp(rt, obj, names.userIdentifier).utf8(rt);
+    auto clientIdentifier = readIdentifier(rt, names, obj, names.client);
+    auto serverIdentifier = readIdentifier(rt, names, obj, names.server);
+    OpaqueStartServerLoginInput params = {
+        .registration_record = borrowOptional(registrationRecord),
+        .has_registration_record = registrationRecord.has_value(),
+        .start_login_request = startLoginRequest,
+        .user_identifier = userIdentifier,
+        .client_identifier = borrowOptional(clientIdentifier),
+        .has_client_identifier = clientIdentifier.has_value(),
+        .server_identifier = borrowOptional(serverIdentifier),
+        .has_server_identifier = serverIdentifier.has_value(),
+        .suite = getCipherSuite(rt, names, obj),
     };
-    auto result = opaque_finish_client_login(params);
-    if (result == nullptr) {
+
+    OutputBuffer out;
+    OpaqueStartServerLoginOutput lengths;
+    auto status = handle
+      ? opaque_try_start_server_login_with_setup_into(handle->setup(), params, out.slice(), lengths)
+      : opaque_try_start_server_login_into(serverSetup, params, out.slice(), lengths);
+    if (failed(rt, status, out, failure)) {
       return jsi::Value::undefined();
     }
+
     auto ret = jsi::Object(rt);
-    ret.setProperty(rt, "finishLoginRequest", std::string(result->finish_login_request));
-    ret.setProperty(rt, "sessionKey", std::string(result->session_key));
-    ret.setProperty(rt, "exportKey", std::string(result->export_key));
-    ret.setProperty(rt, "serverStaticPublicKey", std::string(result->server_static_public_key));
+    ret.setProperty(rt, names.serverLoginState, out.next(rt, lengths.server_login_state));
+    ret.setProperty(rt, names.loginResponse, out.next(rt, lengths.login_response));
     return ret;
   }
 
-  jsi::Value createServerSetup(jsi::Runtime& rt, const jsi::Value* args) {
-    auto setup = opaque_create_server_setup();
-    return jsi::String::createFromUtf8(rt, std::string(setup));
+  // Starts the logins for all requests at once, the server setup is only
+  // decoded once and the requests are spread across the available cores.
+  // Invalid requests don't fail the whole batch, instead their entry in the
+  // returned array holds the error code and message. The third argument holds the suite
+  // of a server setup string or the key ID of a keyring.
+  jsi::Value startServerLoginBatch(jsi::Runtime& rt, const PropNames& names, const jsi::Value* args) {
+    auto suite = getCipherSuite(rt, names, args[2]);
+    auto options = getParams(rt, args[2]);
+    auto handle = getServerSetupHandle(rt, names, args[0], options ? &*options : nullptr);
+    if (handle) {
+      opaque_check_server_setup_suite(handle->setup(), suite);
+    } else {
+      if (!args[0].isString()) {
+        throw jsi::JSError(rt, kInvalidServerSetupMessage);
+      }
+      handle = std::make_shared<ServerSetupHostObject>(
+        opaque_create_server_setup_handle(args[0].getString(rt).utf8(rt), suite));
+    }
+    if (!args[1].isObject() || !args[1].getObject(rt).isArray(rt)) {
+      throw jsi::JSError(rt, kInvalidRequestsMessage);
+    }
+    auto requests = args[1].getObject(rt).getArray(rt);
+    auto count = requests.size(rt);
+
+    auto ret = jsi::Array(rt, count);
+    ::rust::Vec<OpaqueStartServerLoginParams> params;
+    params.reserve(count);
+    std::vector<size_t> paramIndices;
+    paramIndices.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+      try {
+        auto obj = requests.getValueAtIndex(rt, i).asObject(rt);
+        ParamsReader in{rt, names, obj};
+        params.push_back(readStartServerLoginParams(in));
+        paramIndices.push_back(i);
+      } catch (jsi::JSError& e) {
+        auto entry = jsi::Object(rt);
+        entry.setProperty(rt, names.error,
+          jsi::String::createFromAscii(rt, errorCodeName(OpaqueErrorCode::Input)));
+        entry.setProperty(rt, names.message, jsi::String::createFromUtf8(rt, e.getMessage()));
+        ret.setValueAtIndex(rt, i, std::move(entry));
+      }
+    }
+
+    auto results = opaque_start_server_login_batch(handle->setup(), std::move(params));
+    for (size_t j = 0; j < results.size(); j++) {
+      ResultWriter entry(rt, names);
+      writeStartServerLoginBatchResult(entry, results[j]);
+      ret.setValueAtIndex(rt, paramIndices[j], std::move(entry.obj));
+    }
+    return ret;
   }
 
-  jsi::Value getServerPublicKey(jsi::Runtime& rt, const jsi::Value& input) {
-    auto str = input.asString(rt);
-    auto pubkey = opaque_get_server_public_key(str.utf8(rt));
-    return jsi::String::createFromUtf8(rt, std::string(pubkey));
+  jsi::Value finishServerLogin(jsi::Runtime& rt, const PropNames& names, jsi::Value& input, Failure& failure) {
+    MetricsScope metrics(OpaqueMetricsFunction::FinishServerLogin);
+    auto obj = input.asObject(rt);
+    auto serverLoginState = getProp(rt, obj, names.serverLoginState).utf8(rt);
+    auto finishLoginRequest = getProp(rt, obj, names.finishLoginRequest).utf8(rt);
+    OutputBuffer out;
+    size_t length = 0;
+    auto status = opaque_try_finish_server_login_into({
+        .server_login_state = serverLoginState,
+        .finish_login_request = finishLoginRequest,
+        .suite = getCipherSuite(rt, names, obj),
+    }, out.slice(), length);
+    if (failed(rt, status, out, failure)) {
+      return jsi::Value::undefined();
+    }
+    auto ret = jsi::Object(rt);
+    ret.setProperty(rt, names.sessionKey, out.next(rt, length));
+    return ret;
+  }
+
+  // Keeps the server login states between startServerLoginSession and
+  // finishServerLoginSession in native memory, see rust/src/sessions.rs.
+  class LoginSessionStoreHostObject : public jsi::HostObject {
+   public:
+    explicit LoginSessionStoreHostObject(::rust::Box<ServerLoginSessionStore> store) : store_(std::move(store)) {}
+
+    const ServerLoginSessionStore& store() const { return *store_; }
+
+   private:
+    ::rust::Box<ServerLoginSessionStore> store_;
+  };
+
+  jsi::Value createServerLoginSessionStore(jsi::Runtime& rt, const PropNames& names, jsi::Value& input) {
+    auto obj = input.asObject(rt);
+    auto ttlMs = obj.getProperty(rt, names.ttlMs).isUndefined()
+      ? kDefaultLoginSessionTtlMs : getUint32Prop(rt, obj, names.ttlMs);
+    auto maxMemoryBytesProp = obj.getProperty(rt, names.maxMemoryBytes);
+    auto maxMemoryBytes = maxMemoryBytesProp.isUndefined()
+      ? kDefaultLoginSessionMaxMemoryBytes : maxMemoryBytesProp.asNumber();
+    if (!(maxMemoryBytes >= 0 && maxMemoryBytes <= static_cast<double>(SIZE_MAX))) {
+      throw jsi::JSError(rt, kMaxMemoryBytesOutOfRangeMessage);
+    }
+    auto store = opaque_create_server_login_session_store(ttlMs, static_cast<size_t>(maxMemoryBytes));
+    return jsi::Object::createFromHostObject(rt, std::make_shared<LoginSessionStoreHostObject>(std::move(store)));
+  }
+
+  std::shared_ptr<LoginSessionStoreHostObject> getLoginSessionStore(jsi::Runtime& rt, const jsi::Value& value) {
+    if (!value.isObject() || !value.getObject(rt).isHostObject<LoginSessionStoreHostObject>(rt)) {
+      throw jsi::JSError(rt, kInvalidSessionStoreMessage);
+    }
+    return value.getObject(rt).getHostObject<LoginSessionStoreHostObject>(rt);
+  }
+
+  jsi::Value getServerLoginSessionCount(jsi::Runtime& rt, const PropNames& names, jsi::Value& input) {
+    auto store = getLoginSessionStore(rt, input);
+    return static_cast<double>(opaque_server_login_session_count(store->store()));
+  }
+
+  jsi::Value startServerLoginSession(jsi::Runtime& rt, const PropNames& names, jsi::Value& input,
+    Failure& failure) {
+    MetricsScope metrics(OpaqueMetricsFunction::StartServerLogin);
+    auto obj = input.asObject(rt);
+    auto store = getLoginSessionStore(rt, obj.getProperty(rt, names.sessionStore));
+    auto serverSetupProp = obj.getProperty(rt, names.serverSetup);
+    auto handle = getServerSetupHandle(rt, names, serverSetupProp, &obj);
+    if (!handle) {
+      handle = std::make_shared<ServerSetupHostObject>(opaque_create_server_setup_handle(
+        asStringProp(rt, obj, names.serverSetup, serverSetupProp).utf8(rt), getCipherSuite(rt, names, obj)));
+    }
+    ParamsReader in{rt, names, obj};
+    OutputBuffer out;
+    OpaqueStartServerLoginSessionResult result;
+    auto status = opaque_try_start_server_login_session(store->store(), handle->setup(),
+      readStartServerLoginParams(in), out.slice(), result);
+    if (failed(rt, status, out, failure)) {
+      return jsi::Value::undefined();
+    }
+    ResultWriter ret(rt, names);
+    writeStartServerLoginSessionResult(ret, result);
+    return std::move(ret.obj);
   }
 
-  jsi::Value createServerRegistrationResponse(jsi::Runtime& rt, jsi::Value& input) {
+  jsi::Value finishServerLoginSession(jsi::Runtime& rt, const PropNames& names, jsi::Value& input,
+    Failure& failure) {
+    MetricsScope metrics(OpaqueMetricsFunction::FinishServerLogin);
     auto obj = input.asObject(rt);
-    struct OpaqueCreateServerRegistrationResponseParams params = {
-        .server_setup = getProp(rt, obj, "serverSetup").utf8(rt),
-        .user_identifier = getProp(rt, obj, "userIdentifier").utf8(rt),
-        .registration_request = getProp(rt, obj, "registrationRequest").utf8(rt),
+    auto store = getLoginSessionStore(rt, obj.getProperty(rt, names.sessionStore));
+    auto sessionHandle = getProp(rt, obj, names.sessionHandle).utf8(rt);
+    auto finishLoginRequest = getProp(rt, obj, names.finishLoginRequest).utf8(rt);
+    OutputBuffer out;
+    OpaqueFinishServerLoginResult result;
+    auto status = opaque_try_finish_server_login_session(store->store(), sessionHandle, finishLoginRequest,
+      out.slice(), result);
+    if (failed(rt, status, out, failure)) {
+      return jsi::Value::undefined();
+    }
+    ResultWriter ret(rt, names);
+    writeFinishServerLoginResult(ret, result);
+    return std::move(ret.obj);
+  }
+
+  // A bulk registration import, see rust/src/import.rs for the framing of the
+  // records. They are copied out of the JS heap since the chunks are created
+  // on the worker pool, one at a time.
+  class RegistrationImportHostObject : public jsi::HostObject {
+   public:
+    struct Chunk {
+      OpaqueRegistrationImportChunk result;
+      uint64_t processed;
+      uint64_t total;
     };
-    auto result = opaque_create_server_registration_response(params);
+
+    RegistrationImportHostObject(std::shared_ptr<ServerSetupHostObject> setup, std::vector<uint8_t> records,
+      size_t chunkSize)
+      : setup_(std::move(setup)), records_(std::move(records)), chunkSize_(chunkSize),
+        total_(opaque_count_registration_import_records({records_.data(), records_.size()})) {}
+
+    // Creates the responses of the next chunk on the calling worker thread.
+    // Returns an empty chunk once all records are processed.
+    Chunk next() {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto result = opaque_create_server_registration_responses_chunk(
+        setup_->setup(), {records_.data() + offset_, records_.size() - offset_}, chunkSize_);
+      offset_ += result.consumed;
+      processed_ += result.records;
+      if (offset_ == records_.size()) {
+        // free the input right away instead of when JS collects the import
+        std::vector<uint8_t>().swap(records_);
+        offset_ = 0;
+      }
+      return {.result = std::move(result), .processed = processed_, .total = total_};
+    }
+
+   private:
+    std::shared_ptr<ServerSetupHostObject> setup_;
+    std::mutex mutex_;
+    std::vector<uint8_t> records_;
+    size_t chunkSize_;
+    uint64_t total_;
+    size_t offset_ = 0;
+    uint64_t processed_ = 0;
+  };
+
+  const uint32_t kDefaultRegistrationImportChunkSize = 1024;
+
+  jsi::Value createRegistrationImport(jsi::Runtime& rt, const PropNames& names, jsi::Value& input) {
+    auto obj = input.asObject(rt);
+    auto suite = getCipherSuite(rt, names, obj);
+    auto serverSetupProp = obj.getProperty(rt, names.serverSetup);
+    auto handle = getServerSetupHandle(rt, names, serverSetupProp, &obj);
+    if (handle) {
+      opaque_check_server_setup_suite(handle->setup(), suite);
+    } else {
+      handle = std::make_shared<ServerSetupHostObject>(opaque_create_server_setup_handle(
+        asStringProp(rt, obj, names.serverSetup, serverSetupProp).utf8(rt), suite));
+    }
+    auto chunkSize = obj.getProperty(rt, names.chunkSize).isUndefined()
+      ? kDefaultRegistrationImportChunkSize : getUint32Prop(rt, obj, names.chunkSize);
+    if (chunkSize == 0) {
+      throw jsi::JSError(rt, "property \"chunkSize\" must be positive");
+    }
+    auto recordsInput = getBinaryProp(rt, names, obj, names.records);
+    auto records = recordsInput.slice(rt);
+    return jsi::Object::createFromHostObject(rt, std::make_shared<RegistrationImportHostObject>(
+      std::move(handle), std::vector<uint8_t>(records.data(), records.data() + records.size()), chunkSize));
+  }
+
+  std::shared_ptr<RegistrationImportHostObject> getRegistrationImport(jsi::Runtime& rt, const jsi::Value& value) {
+    if (!value.isObject() || !value.getObject(rt).isHostObject<RegistrationImportHostObject>(rt)) {
+      throw jsi::JSError(rt, "registrationImport must be a registration import");
+    }
+    return value.getObject(rt).getHostObject<RegistrationImportHostObject>(rt);
+  }
+
+  jsi::Value startClientRegistrationBinary(jsi::Runtime& rt, const PropNames& names, jsi::Value& input) {
+    MetricsScope metrics(OpaqueMetricsFunction::StartClientRegistration);
+    auto obj = input.asObject(rt);
+    auto result = opaque_start_client_registration_binary(getProp(rt, obj, names.password).utf8(rt),
+      getCipherSuite(rt, names, obj));
     auto ret = jsi::Object(rt);
-    ret.setProperty(rt, "registrationResponse", std::string(result.registration_response));
+    ret.setProperty(rt, names.clientRegistrationState, makeUint8Array(rt, names, result.client_registration_state));
+    ret.setProperty(rt, names.registrationRequest, makeUint8Array(rt, names, result.registration_request));
     return ret;
   }
 
-  jsi::Value startServerLogin(jsi::Runtime& rt, jsi::Value& input) {
+  jsi::Value finishClientRegistrationBinary(jsi::Runtime& rt, const PropNames& names, jsi::Value& input) {
+    MetricsScope metrics(OpaqueMetricsFunction::FinishClientRegistration);
     auto obj = input.asObject(rt);
-    struct OpaqueStartServerLoginParams params {
-      .server_setup = getProp(rt, obj, "serverSetup").utf8(rt),
-        .registration_record = getOptional(rt, obj, "registrationRecord"),
-        .start_login_request = getProp(rt, obj, "startLoginRequest").utf8(rt),
-        .user_identifier = getProp(rt, obj, "userIdentifier").utf8(rt),
-        .client_identifier = getIdentifier(rt, obj, "client"),
-        .server_identifier = getIdentifier(rt, obj, "server"),
-    };
+    auto password = getProp(rt, obj, names.password).utf8(rt);
+    auto registrationResponse = getBinaryProp(rt, names, obj, names.registrationResponse);
+    auto clientRegistrationState = getBinaryProp(rt, names, obj, names.clientRegistrationState);
+    auto clientIdentifier = getIdentifier(rt, names, obj, names.client);
+    auto serverIdentifier = getIdentifier(rt, names, obj, names.server);
+    auto keyStretching = getKeyStretching(rt, names, obj);
+    auto suite = getCipherSuite(rt, names, obj);
+    auto result = opaque_finish_client_registration_binary(
+      password,
+      registrationResponse.slice(rt),
+      clientRegistrationState.slice(rt),
+      std::move(clientIdentifier),
+      std::move(serverIdentifier),
+      std::move(keyStretching),
+      suite);
+    auto ret = jsi::Object(rt);
+    ret.setProperty(rt, names.exportKey, makeUint8Array(rt, names, result.export_key));
+    ret.setProperty(rt, names.registrationRecord, makeUint8Array(rt, names, result.registration_record));
+    ret.setProperty(rt, names.serverStaticPublicKey, makeUint8Array(rt, names, result.server_static_public_key));
+    ret.setProperty(rt, names.keyStretching, makeKeyStretching(rt, names, result.key_stretching));
+    return ret;
+  }
 
-    auto result = opaque_start_server_login(params);
+  jsi::Value startClientLoginBinary(jsi::Runtime& rt, const PropNames& names, jsi::Value& input) {
+    MetricsScope metrics(OpaqueMetricsFunction::StartClientLogin);
+    auto obj = input.asObject(rt);
+    auto result = opaque_start_client_login_binary(getProp(rt, obj, names.password).utf8(rt),
+      getCipherSuite(rt, names, obj));
+    auto ret = jsi::Object(rt);
+    ret.setProperty(rt, names.clientLoginState, makeUint8Array(rt, names, result.client_login_state));
+    ret.setProperty(rt, names.startLoginRequest, makeUint8Array(rt, names, result.start_login_request));
+    return ret;
+  }
 
+  jsi::Value finishClientLoginBinary(jsi::Runtime& rt, const PropNames& names, jsi::Value& input, Failure& failure) {
+    MetricsScope metrics(OpaqueMetricsFunction::FinishClientLogin);
+    cancelQueuedPrepare();
+    auto obj = input.asObject(rt);
+    auto clientLoginState = getBinaryProp(rt, names, obj, names.clientLoginState);
+    auto loginResponse = getBinaryProp(rt, names, obj, names.loginResponse);
+    auto password = getProp(rt, obj, names.password).utf8(rt);
+    auto clientIdentifier = getIdentifier(rt, names, obj, names.client);
+    auto serverIdentifier = getIdentifier(rt, names, obj, names.server);
+    auto keyStretching = getKeyStretching(rt, names, obj);
+    auto suite = getCipherSuite(rt, names, obj);
+    OutputBuffer out;
+    OpaqueFinishClientLoginBinaryResult result;
+    auto status = opaque_try_finish_client_login_binary(
+      clientLoginState.slice(rt),
+      loginResponse.slice(rt),
+      password,
+      std::move(clientIdentifier),
+      std::move(serverIdentifier),
+      std::move(keyStretching),
+      suite,
+      out.slice(),
+      result);
+    if (failed(rt, status, out, failure) || result.session_key.empty()) {
+      return jsi::Value::undefined();
+    }
     auto ret = jsi::Object(rt);
-    ret.setProperty(rt, "serverLoginState", std::string(result.server_login_state));
-    ret.setProperty(rt, "loginResponse", std::string(result.login_response));
+    ret.setProperty(rt, names.finishLoginRequest, makeUint8Array(rt, names, result.finish_login_request));
+    ret.setProperty(rt, names.sessionKey, makeUint8Array(rt, names, result.session_key));
+    ret.setProperty(rt, names.exportKey, makeUint8Array(rt, names, result.export_key));
+    ret.setProperty(rt, names.serverStaticPublicKey, makeUint8Array(rt, names, result.server_static_public_key));
     return ret;
   }
 
-  jsi::Value finishServerLogin(jsi::Runtime& rt, jsi::Value& input) {
+  jsi::Value createServerSetupBinary(jsi::Runtime& rt, const PropNames& names, jsi::Value& input) {
+    return makeUint8Array(rt, names, opaque_create_server_setup_binary(getCipherSuite(rt, names, input)));
+  }
+
+  // Like getServerSetupHandle but for the binary API, where the server setup
+  // is either a handle, a keyring or the serialized bytes.
+  // A handle is checked against `suite` here, only the bytes are passed on
+  // together with it.
+  std::shared_ptr<ServerSetupHostObject> getBinaryServerSetup(jsi::Runtime& rt, const PropNames& names,
+    jsi::Object& obj, OpaqueCipherSuite suite, std::optional<BinaryInput>& bytes) {
+    auto prop = obj.getProperty(rt, names.serverSetup);
+    auto handle = asServerSetupHandle(rt, names, prop, &obj);
+    if (handle) {
+      opaque_check_server_setup_suite(handle->setup(), suite);
+    } else {
+      bytes.emplace(asBinaryProp(rt, names, obj, names.serverSetup, prop));
+    }
+    return handle;
+  }
+
+  jsi::Value getServerPublicKeyBinary(jsi::Runtime& rt, const PropNames& names, const jsi::Value* args) {
+    const auto& input = args[0];
+    auto suite = getCipherSuite(rt, names, args[1]);
+    auto params = getParams(rt, args[1]);
+    auto handle = asServerSetupHandle(rt, names, input, params ? &*params : nullptr);
+    if (handle) {
+      opaque_check_server_setup_suite(handle->setup(), suite);
+      return makeUint8Array(rt, names, opaque_get_server_public_key_with_setup_binary(handle->setup()));
+    }
+    auto bytes = asBinary(rt, names, input);
+    if (!bytes) {
+      throw jsi::JSError(rt, "serverSetup must be a Uint8Array, an ArrayBuffer or a server setup handle or keyring");
+    }
+    return makeUint8Array(rt, names, opaque_get_server_public_key_binary(bytes->slice(rt), suite));
+  }
+
+  jsi::Value createServerRegistrationResponseBinary(jsi::Runtime& rt, const PropNames& names, jsi::Value& input) {
+    MetricsScope metrics(OpaqueMetricsFunction::CreateServerRegistrationResponse);
     auto obj = input.asObject(rt);
-    struct OpaqueFinishServerLoginParams params = {
-        .server_login_state = getProp(rt, obj, "serverLoginState").utf8(rt),
-        .finish_login_request = getProp(rt, obj, "finishLoginRequest").utf8(rt),
-    };
-    auto result = opaque_finish_server_login(params);
+    auto suite = getCipherSuite(rt, names, obj);
+    std::optional<BinaryInput> serverSetup;
+    auto handle = getBinaryServerSetup(rt, names, obj, suite, serverSetup);
+    auto userIdentifier = getProp(rt, obj, names.userIdentifier).utf8(rt);
+    auto registrationRequest = getBinaryProp(rt, names, obj, names.registrationRequest);
+    auto result = handle
+      ? opaque_create_server_registration_response_with_setup_binary(
+        handle->setup(), userIdentifier, registrationRequest.slice(rt))
+      : opaque_create_server_registration_response_binary(
+        serverSetup->slice(rt), userIdentifier, registrationRequest.slice(rt), suite);
     auto ret = jsi::Object(rt);
-    ret.setProperty(rt, "sessionKey", std::string(result.session_key));
+    ret.setProperty(rt, names.registrationResponse, makeUint8Array(rt, names, result.registration_response));
     return ret;
   }
 
-  using OpaqueFuncN = std::function<jsi::Value(jsi::Runtime&, const jsi::Value* args)>;
+  jsi::Value startServerLoginBinary(jsi::Runtime& rt, const PropNames& names, jsi::Value& input, Failure& failure) {
+    MetricsScope metrics(OpaqueMetricsFunction::StartServerLogin);
+    auto obj = input.asObject(rt);
+    auto suite = getCipherSuite(rt, names, obj);
+    std::optional<BinaryInput> serverSetup;
+    auto handle = getBinaryServerSetup(rt, names, obj, suite, serverSetup);
+    std::optional<BinaryInput> registrationRecord;
+    auto registrationRecordProp = obj.getProperty(rt, names.registrationRecord);
+    if (!registrationRecordProp.isUndefined() && !registrationRecordProp.isNull()) {
+      registrationRecord.emplace(asBinaryProp(rt, names, obj, names.registrationRecord, registrationRecordProp));
+    }
+    auto startLoginRequest = getBinaryProp(rt, names, obj, names.startLoginRequest);
+    auto userIdentifier = getProp(rt, obj, names.userIdentifier).utf8(rt);
+    auto clientIdentifier = getIdentifier(rt, names, obj, names.client);
+    auto serverIdentifier = getIdentifier(rt, names, obj, names.server);
 
-  void installFunc(jsi::Runtime& rt, const std::string name, unsigned int paramCount, OpaqueFuncN func) {
-    auto propName = jsi::PropNameID::forAscii(rt, name);
-    auto jsiFunc = jsi::Function::createFromHostFunction(
+    auto record = registrationRecord ? registrationRecord->slice(rt) : ::rust::Slice<const uint8_t>();
+    OutputBuffer out;
+    OpaqueStartServerLoginBinaryResult result;
+    auto status = handle
+      ? opaque_try_start_server_login_with_setup_binary(
+        handle->setup(), record, registrationRecord.has_value(), startLoginRequest.slice(rt), userIdentifier,
+        std::move(clientIdentifier), std::move(serverIdentifier), out.slice(), result)
+      : opaque_try_start_server_login_binary(
+        serverSetup->slice(rt), record, registrationRecord.has_value(), startLoginRequest.slice(rt), userIdentifier,
+        std::move(clientIdentifier), std::move(serverIdentifier), suite, out.slice(), result);
+    if (failed(rt, status, out, failure)) {
+      return jsi::Value::undefined();
+    }
+
+    auto ret = jsi::Object(rt);
+    ret.setProperty(rt, names.serverLoginState, makeUint8Array(rt, names, result.server_login_state));
+    ret.setProperty(rt, names.loginResponse, makeUint8Array(rt, names, result.login_response));
+    return ret;
+  }
+
+  jsi::Value finishServerLoginBinary(jsi::Runtime& rt, const PropNames& names, jsi::Value& input, Failure& failure) {
+    MetricsScope metrics(OpaqueMetricsFunction::FinishServerLogin);
+    auto obj = input.asObject(rt);
+    auto serverLoginState = getBinaryProp(rt, names, obj, names.serverLoginState);
+    auto finishLoginRequest = getBinaryProp(rt, names, obj, names.finishLoginRequest);
+    auto suite = getCipherSuite(rt, names, obj);
+    OutputBuffer out;
+    OpaqueFinishServerLoginBinaryResult result;
+    auto status = opaque_try_finish_server_login_binary(
+      serverLoginState.slice(rt), finishLoginRequest.slice(rt), suite, out.slice(), result);
+    if (failed(rt, status, out, failure)) {
+      return jsi::Value::undefined();
+    }
+    auto ret = jsi::Object(rt);
+    ret.setProperty(rt, names.sessionKey, makeUint8Array(rt, names, result.session_key));
+    return ret;
+  }
+
+  jsi::Value setMetricsEnabled(jsi::Runtime& rt, const PropNames& names, jsi::Value& input) {
+    if (!input.isBool()) {
+      throw jsi::JSError(rt, "enabled must be a boolean");
+    }
+    opaque_set_metrics_enabled(input.getBool());
+    return jsi::Value::undefined();
+  }
+
+  // Returns `{ [function]: { [phase]: { count, totalUs, maxUs, p50Us, ... } } }`
+  // with the phases recorded at least once.
+  jsi::Value getMetrics(jsi::Runtime& rt, const PropNames& names, const jsi::Value* args) {
+    auto ret = jsi::Object(rt);
+    for (const auto& entry : opaque_get_metrics()) {
+      auto functionName = jsi::PropNameID::forAscii(rt, entry.function.data(), entry.function.size());
+      auto functionProp = ret.getProperty(rt, functionName);
+      auto function = functionProp.isObject() ? functionProp.getObject(rt) : jsi::Object(rt);
+      auto phase = jsi::Object(rt);
+      phase.setProperty(rt, names.count, static_cast<double>(entry.count));
+      phase.setProperty(rt, names.totalUs, entry.total_ns / 1000.0);
+      phase.setProperty(rt, names.maxUs, entry.max_ns / 1000.0);
+      phase.setProperty(rt, names.p50Us, entry.p50_ns / 1000.0);
+      phase.setProperty(rt, names.p90Us, entry.p90_ns / 1000.0);
+      phase.setProperty(rt, names.p99Us, entry.p99_ns / 1000.0);
+      function.setProperty(rt, jsi::PropNameID::forAscii(rt, entry.phase.data(), entry.phase.size()), phase);
+      ret.setProperty(rt, functionName, function);
+    }
+    return ret;
+  }
+
+  jsi::Value resetMetrics(jsi::Runtime& rt, const PropNames& names, const jsi::Value* args) {
+    opaque_reset_metrics();
+    return jsi::Value::undefined();
+  }
+
+  // State of an installed runtime which has to outlive the host functions,
+  // e.g. because async jobs settle their promises after the call returned.
+  // Every runtime has its own context, apart from `alive` it's only
+  // accessed on the thread of its runtime.
+  struct ModuleContext {
+    ModuleContext(jsi::Runtime& rt, std::shared_ptr<react::CallInvoker> callInvoker)
+      : runtime(rt), callInvoker(std::move(callInvoker)), propNames(std::make_unique<PropNames>(rt)) {}
+
+    jsi::Runtime& runtime;
+    // nullptr for runtimes without async support
+    std::shared_ptr<react::CallInvoker> callInvoker;
+    // Released together with the runtime by the ModuleContextHolder, only
+    // use it while the context is alive.
+    std::unique_ptr<PropNames> propNames;
+    // Cleared once the runtime is torn down, after that no JSI value must
+    // be touched anymore.
+    std::atomic<bool> alive{true};
+    // Maps the job ids handed in from JS to the worker pool ids.
+    std::unordered_map<uint64_t, WorkerPool::JobId> pendingJobs;
+  };
+
+  // Lives in the runtime's global object and marks the context as dead when
+  // the runtime releases it during teardown.
+  class ModuleContextHolder : public jsi::HostObject {
+   public:
+    explicit ModuleContextHolder(std::shared_ptr<ModuleContext> context) : context_(std::move(context)) {}
+    ~ModuleContextHolder() override {
+      context_->alive.store(false, std::memory_order_release);
+      context_->propNames.reset();
+    }
+
+   private:
+    std::shared_ptr<ModuleContext> context_;
+  };
+
+  jsi::Value makeError(jsi::Runtime& rt, const PropNames& names, const std::string& message) {
+    return rt.global().getProperty(rt, names.Error).asObject(rt).asFunction(rt)
+      .callAsConstructor(rt, jsi::String::createFromUtf8(rt, message));
+  }
+
+  // Builds the JS result on the JS thread from the output of the native work.
+  using ResultBuilder = std::function<jsi::Value(jsi::Runtime&, const PropNames&)>;
+  using AsyncWork = std::function<ResultBuilder()>;
+
+  class AsyncJob : public WorkerPool::Job, public std::enable_shared_from_this<AsyncJob> {
+   public:
+    AsyncJob(std::shared_ptr<ModuleContext> context, uint64_t jsJobId, AsyncWork work)
+      : context_(std::move(context)), jsJobId_(jsJobId), work_(std::move(work)) {}
+
+    void setPromise(jsi::Function resolve, jsi::Function reject) {
+      resolve_ = std::make_unique<jsi::Function>(std::move(resolve));
+      reject_ = std::make_unique<jsi::Function>(std::move(reject));
+    }
+
+    void run() override {
+      if (isCancelled()) {
+        settle(nullptr, "opaque job was cancelled");
+        return;
+      }
+      ResultBuilder builder;
+      std::string error;
+      try {
+        builder = work_();
+      } catch (const std::exception& e) {
+        error = errorMessage(e);
+      }
+      // drop the inputs (e.g. the password) as soon as possible
+      work_ = nullptr;
+      if (isCancelled()) {
+        settle(nullptr, "opaque job was cancelled");
+        return;
+      }
+      settle(std::move(builder), std::move(error));
+    }
+
+    void discard() override {
+      work_ = nullptr;
+      settle(nullptr, "opaque job was cancelled");
+    }
+
+    void abandon() override {
+      work_ = nullptr;
+      // like complete() for a dead runtime
+      resolve_.release();
+      reject_.release();
+    }
+
+    // Rejects right away, must be called on the JS thread.
+    void reject(jsi::Runtime& rt, const std::string& message) {
+      context_->pendingJobs.erase(jsJobId_);
+      auto rejectFn = std::move(reject_);
+      resolve_.reset();
+      rejectFn->call(rt, makeError(rt, *context_->propNames, message));
+    }
+
+   private:
+    void settle(ResultBuilder builder, std::string error) {
+      auto self = shared_from_this();
+      context_->callInvoker->invokeAsync([self, builder = std::move(builder), error = std::move(error)]() {
+        self->complete(builder, error);
+      });
+    }
+
+    void complete(const ResultBuilder& builder, const std::string& error) {
+      if (!context_->alive.load(std::memory_order_acquire)) {
+        // The runtime is gone and with it the memory backing the JSI values.
+        resolve_.release();
+        reject_.release();
+        return;
+      }
+      auto& rt = context_->runtime;
+      const auto& names = *context_->propNames;
+      context_->pendingJobs.erase(jsJobId_);
+      auto resolveFn = std::move(resolve_);
+      auto rejectFn = std::move(reject_);
+      if (!error.empty()) {
+        rejectFn->call(rt, makeError(rt, names, error));
+        return;
+      }
+      try {
+        resolveFn->call(rt, builder(rt, names));
+      } catch (jsi::JSError& e) {
+        rejectFn->call(rt, jsi::Value(rt, e.value()));
+      } catch (const std::exception& e) {
+        rejectFn->call(rt, makeError(rt, names, errorMessage(e)));
+      }
+    }
+
+    std::shared_ptr<ModuleContext> context_;
+    uint64_t jsJobId_;
+    AsyncWork work_;
+    std::unique_ptr<jsi::Function> resolve_;
+    std::unique_ptr<jsi::Function> reject_;
+  };
+
+  // Runs the work on the shared worker pool and returns a promise which is
+  // settled on the JS thread through the CallInvoker.
+  jsi::Value runAsync(jsi::Runtime& rt, const std::shared_ptr<ModuleContext>& context,
+    const jsi::Value& jobIdArg, AsyncWork work) {
+    if (!context->callInvoker) {
+      throw jsi::JSError(rt, "async functions are not available in this runtime");
+    }
+    auto jsJobId = static_cast<uint64_t>(jobIdArg.asNumber());
+    auto job = std::make_shared<AsyncJob>(context, jsJobId, std::move(work));
+    auto executor = jsi::Function::createFromHostFunction(
       rt,
-      propName,
-      paramCount,
-      [func, paramCount](
+      jsi::PropNameID::forAscii(rt, "executor"),
+      2,
+      [context, job, jsJobId](
         jsi::Runtime& rt,
         const jsi::Value& self,
         const jsi::Value* args,
         size_t count) -> jsi::Value {
-          if (count != paramCount) {
-            throw std::runtime_error("invalid number of arguments");
+          job->setPromise(args[0].asObject(rt).asFunction(rt), args[1].asObject(rt).asFunction(rt));
+          auto poolJobId = WorkerPool::shared().submit(job);
+          if (poolJobId == 0) {
+            job->reject(rt, "too many pending opaque jobs");
+          } else {
+            context->pendingJobs[jsJobId] = poolJobId;
           }
-          return func(rt, args);
+          return jsi::Value::undefined();
       });
+    return rt.global().getProperty(rt, context->propNames->Promise).asObject(rt).asFunction(rt)
+      .callAsConstructor(rt, executor);
+  }
+
+  jsi::Value finishClientRegistrationAsync(jsi::Runtime& rt, const std::shared_ptr<ModuleContext>& context,
+    const jsi::Value* args) {
+    auto obj = args[0].asObject(rt);
+    auto params = std::make_shared<OpaqueFinishClientRegistrationParams>(
+      readFinishClientRegistrationParams(rt, *context->propNames, obj));
+    return runAsync(rt, context, args[1], [params]() -> ResultBuilder {
+      MetricsScope metrics(OpaqueMetricsFunction::FinishClientRegistration);
+      auto finish = std::make_shared<OpaqueFinishClientRegistrationResult>(
+        opaque_finish_client_registration(std::move(*params)));
+      return [finish](jsi::Runtime& rt, const PropNames& names) {
+        return makeFinishClientRegistrationResult(rt, names, *finish);
+      };
+    });
+  }
+
+  jsi::Value finishClientLoginAsync(jsi::Runtime& rt, const std::shared_ptr<ModuleContext>& context,
+    const jsi::Value* args) {
+    auto obj = args[0].asObject(rt);
+    auto params = std::make_shared<OpaqueFinishClientLoginParams>(
+      readFinishClientLoginParams(rt, *context->propNames, obj));
+    cancelQueuedPrepare();
+    return runAsync(rt, context, args[1], [params]() -> ResultBuilder {
+      MetricsScope metrics(OpaqueMetricsFunction::FinishClientLogin);
+      std::shared_ptr<OpaqueFinishClientLoginResult> result = opaque_finish_client_login(std::move(*params));
+      return [result](jsi::Runtime& rt, const PropNames& names) {
+        return makeFinishClientLoginResult(rt, names, result.get());
+      };
+    });
+  }
+
+  jsi::Value finishClientLoginContextAsync(jsi::Runtime& rt, const std::shared_ptr<ModuleContext>& context,
+    const jsi::Value* args) {
+    const auto& names = *context->propNames;
+    auto obj = args[0].asObject(rt);
+    auto loginContext = getClientLoginContext(rt, obj.getProperty(rt, names.context));
+    auto loginResponse = getProp(rt, obj, names.loginResponse).utf8(rt);
+    cancelQueuedPrepare();
+    return runAsync(rt, context, args[1], [loginContext, loginResponse]() -> ResultBuilder {
+      MetricsScope metrics(OpaqueMetricsFunction::FinishClientLogin);
+      auto out = std::make_shared<OutputBuffer>();
+      auto lengths = opaque_finish_client_login_context(loginContext->context(), loginResponse, out->slice());
+      return [out, lengths](jsi::Runtime& rt, const PropNames& names) {
+        return makeFinishClientLoginOutput(rt, names, *out, lengths);
+      };
+    });
+  }
+
+  jsi::Value nextRegistrationImportChunk(jsi::Runtime& rt, const std::shared_ptr<ModuleContext>& context,
+    const jsi::Value* args) {
+    auto registrationImport = getRegistrationImport(rt, args[0]);
+    return runAsync(rt, context, args[1], [registrationImport]() -> ResultBuilder {
+      auto chunk = std::make_shared<RegistrationImportHostObject::Chunk>(registrationImport->next());
+      return [chunk](jsi::Runtime& rt, const PropNames& names) -> jsi::Value {
+        auto ret = jsi::Object(rt);
+        ret.setProperty(rt, names.responses, makeUint8Array(rt, names, chunk->result.responses));
+        ret.setProperty(rt, names.count, static_cast<double>(chunk->result.records));
+        ret.setProperty(rt, names.failed, static_cast<double>(chunk->result.failed));
+        ret.setProperty(rt, names.processed, static_cast<double>(chunk->processed));
+        ret.setProperty(rt, names.total, static_cast<double>(chunk->total));
+        return ret;
+      };
+    });
+  }
+
+  // Prepares the key stretching of the next finishClientLogin on the worker
+  // pool. The params are checked before the job is submitted, so it can't
+  // fail on them.
+  class PrepareLoginFinishJob : public WorkerPool::Job {
+   public:
+    explicit PrepareLoginFinishJob(::rust::Vec<OpaqueKeyStretchingParams> keyStretching)
+      : keyStretching_(std::move(keyStretching)) {}
+
+    void setId(WorkerPool::JobId id) { id_ = id; }
+
+    void run() override {
+      dequeued();
+      try {
+        opaque_prepare_client_login_finish(std::move(keyStretching_));
+      } catch (const std::exception&) {
+        // only the allocation is left to fail, the finish reports it then
+      }
+    }
+
+    void discard() override { dequeued(); }
+    void abandon() override {}
+
+   private:
+    void dequeued() {
+      std::lock_guard<std::mutex> lock(queuedPrepareMutex);
+      if (queuedPrepareId == id_) {
+        queuedPrepareId = 0;
+      }
+    }
 
+    ::rust::Vec<OpaqueKeyStretchingParams> keyStretching_;
+    // only accessed with queuedPrepareMutex held
+    WorkerPool::JobId id_ = 0;
+  };
+
+  // Same as startClientLogin, and prepares the key stretching of the
+  // following finishClientLogin in the background while the client waits
+  // for the server.
+  jsi::Value startClientLoginPipelined(jsi::Runtime& rt, const PropNames& names, jsi::Value& input) {
+    auto obj = input.asObject(rt);
+    auto keyStretching = getKeyStretching(rt, names, obj);
+    opaque_check_key_stretching(keyStretching);
+    {
+      std::lock_guard<std::mutex> lock(queuedPrepareMutex);
+      // a queued job prepares the same finish already, and with a full queue
+      // the key stretching just isn't prepared
+      if (queuedPrepareId == 0) {
+        auto job = std::make_shared<PrepareLoginFinishJob>(std::move(keyStretching));
+        queuedPrepareId = WorkerPool::shared().submit(job);
+        job->setId(queuedPrepareId);
+      }
+    }
+    return startClientLogin(rt, names, input);
+  }
+
+  jsi::Value cancelAsync(jsi::Runtime& rt, const std::shared_ptr<ModuleContext>& context,
+    const jsi::Value* args) {
+    auto jsJobId = static_cast<uint64_t>(args[0].asNumber());
+    auto entry = context->pendingJobs.find(jsJobId);
+    if (entry == context->pendingJobs.end()) {
+      return false;
+    }
+    return WorkerPool::shared().cancel(entry->second);
+  }
+
+  using OpaqueFuncN = std::function<jsi::Value(jsi::Runtime&, const PropNames&, const jsi::Value* args)>;
+
+  void defineFunc(jsi::Runtime& rt, const std::string& name, unsigned int paramCount,
+    jsi::HostFunctionType func) {
+    auto propName = jsi::PropNameID::forAscii(rt, name);
+    auto jsiFunc = jsi::Function::createFromHostFunction(rt, propName, paramCount, std::move(func));
     rt.global().setProperty(rt, propName, std::move(jsiFunc));
   }
 
-  void installFunc1(jsi::Runtime& rt, const std::string name, OpaqueFunc1 func) {
+  // Turns the Rust errors of a host function into JS errors with their
+  // message, without the code in front of it.
+  template <typename Call>
+  jsi::Value rethrowRustErrors(jsi::Runtime& rt, Call call) {
+    try {
+      return call();
+    } catch (const ::rust::Error& e) {
+      throw jsi::JSError(rt, splitRustError(e).message);
+    }
+  }
+
+  // Turns the exceptions of a host function into a failed result. Errors
+  // of the input params are JSErrors, a Rust error carries its code in
+  // the message, see splitRustError.
+  template <typename Call>
+  jsi::Value catchFailure(jsi::Runtime& rt, const PropNames& names, Call call) {
+    try {
+      return call();
+    } catch (const jsi::JSError& e) {
+      return makeFailedResult(rt, names, OpaqueErrorCode::Input, jsi::String::createFromUtf8(rt, e.getMessage()));
+    } catch (const ::rust::Error& e) {
+      auto error = splitRustError(e);
+      return makeFailedResult(rt, names, error.code, jsi::String::createFromUtf8(rt, error.message));
+    } catch (const std::exception& e) {
+      return makeFailedResult(rt, names, OpaqueErrorCode::Input, jsi::String::createFromUtf8(rt, e.what()));
+    }
+  }
+
+  // Result mode: every sync function `name` has a twin `<name>Result`
+  // which doesn't throw but returns `{ ok: true, value }` with the return
+  // value of `name`, or `{ ok: false, error, message }` with the name of
+  // the OpaqueErrorCode in `error`. The twins of the login functions
+  // (installTryFunc1) don't unwind on a failed login, the others catch
+  // the exception of the failed call.
+  void installFunc(jsi::Runtime& rt, const std::shared_ptr<ModuleContext>& context, const std::string name,
+    unsigned int paramCount, OpaqueFuncN func) {
+    defineFunc(rt, name, paramCount, [context, func, paramCount](
+      jsi::Runtime& rt, const jsi::Value& self, const jsi::Value* args, size_t count) -> jsi::Value {
+        if (count != paramCount) {
+          throw std::runtime_error("invalid number of arguments");
+        }
+        return rethrowRustErrors(rt, [&] { return func(rt, *context->propNames, args); });
+      });
+    defineFunc(rt, name + "Result", paramCount, [context, func, paramCount](
+      jsi::Runtime& rt, const jsi::Value& self, const jsi::Value* args, size_t count) -> jsi::Value {
+        const auto& names = *context->propNames;
+        if (count != paramCount) {
+          return makeFailedResult(rt, names, OpaqueErrorCode::Input,
+            jsi::String::createFromAscii(rt, "invalid number of arguments"));
+        }
+        return catchFailure(rt, names, [&] { return makeOkResult(rt, names, func(rt, names, args)); });
+      });
+  }
+
+  void installFunc1(jsi::Runtime& rt, const std::shared_ptr<ModuleContext>& context, const std::string name,
+    OpaqueFunc1 func) {
     installFunc(
       rt,
+      context,
       name,
       1,
-      [func](jsi::Runtime& rt, const jsi::Value* args) -> jsi::Value {
+      [func](jsi::Runtime& rt, const PropNames& names, const jsi::Value* args) -> jsi::Value {
         auto input = jsi::Value(rt, args[0]);
-        return func(rt, input);
+        return func(rt, names, input);
+      });
+  }
+
+  void installTryFunc1(jsi::Runtime& rt, const std::shared_ptr<ModuleContext>& context, const std::string name,
+    OpaqueTryFunc1 func) {
+    defineFunc(rt, name, 1, [context, func](
+      jsi::Runtime& rt, const jsi::Value& self, const jsi::Value* args, size_t count) -> jsi::Value {
+        if (count != 1) {
+          throw std::runtime_error("invalid number of arguments");
+        }
+        auto input = jsi::Value(rt, args[0]);
+        Failure failure;
+        auto value = rethrowRustErrors(rt, [&] { return func(rt, *context->propNames, input, failure); });
+        if (failure.code != OpaqueErrorCode::None) {
+          throw jsi::JSError(rt, failure.message.getString(rt).utf8(rt));
+        }
+        return value;
+      });
+    defineFunc(rt, name + "Result", 1, [context, func](
+      jsi::Runtime& rt, const jsi::Value& self, const jsi::Value* args, size_t count) -> jsi::Value {
+        const auto& names = *context->propNames;
+        if (count != 1) {
+          return makeFailedResult(rt, names, OpaqueErrorCode::Input,
+            jsi::String::createFromAscii(rt, "invalid number of arguments"));
+        }
+        return catchFailure(rt, names, [&] {
+          auto input = jsi::Value(rt, args[0]);
+          Failure failure;
+          auto value = func(rt, names, input, failure);
+          if (failure.code != OpaqueErrorCode::None) {
+            return makeFailedResult(rt, names, failure.code, std::move(failure.message));
+          }
+          return makeOkResult(rt, names, std::move(value));
+        });
       });
   }
 
-  void installOpaque(jsi::Runtime& rt) {
-    installFunc1(rt, "opaque_startClientRegistration", startClientRegistration);
-    installFunc1(rt, "opaque_finishClientRegistration", finishClientRegistration);
-    installFunc1(rt, "opaque_startClientLogin", startClientLogin);
-    installFunc1(rt, "opaque_finishClientLogin", finishClientLogin);
+  using OpaqueAsyncFunc = std::function<jsi::Value(jsi::Runtime&, const std::shared_ptr<ModuleContext>&,
+    const jsi::Value* args)>;
+
+  // The async functions report their errors through the promise and have
+  // no result mode twin.
+  void installAsyncFunc(jsi::Runtime& rt, const std::shared_ptr<ModuleContext>& context,
+    const std::string name, unsigned int paramCount, OpaqueAsyncFunc func) {
+    defineFunc(rt, name, paramCount, [context, func, paramCount](
+      jsi::Runtime& rt, const jsi::Value& self, const jsi::Value* args, size_t count) -> jsi::Value {
+        if (count != paramCount) {
+          throw std::runtime_error("invalid number of arguments");
+        }
+        return rethrowRustErrors(rt, [&] { return func(rt, context, args); });
+      });
+  }
+
+  void installOpaque(jsi::Runtime& rt, std::shared_ptr<react::CallInvoker> callInvoker) {
+    auto context = std::make_shared<ModuleContext>(rt, std::move(callInvoker));
+    rt.global().setProperty(rt, "__opaqueModuleContext",
+      jsi::Object::createFromHostObject(rt, std::make_shared<ModuleContextHolder>(context)));
+
+    installFunc1(rt, context, "opaque_startClientRegistration", startClientRegistration);
+    installFunc1(rt, context, "opaque_finishClientRegistration", finishClientRegistration);
+    installFunc1(rt, context, "opaque_startClientLogin", startClientLogin);
+    installFunc1(rt, context, "opaque_startClientLoginPipelined", startClientLoginPipelined);
+    installTryFunc1(rt, context, "opaque_finishClientLogin", finishClientLogin);
+    installFunc1(rt, context, "opaque_startClientLoginContext", startClientLoginContext);
+    installTryFunc1(rt, context, "opaque_finishClientLoginContext", finishClientLoginContext);
+    installFunc1(rt, context, "opaque_calibrateKeyStretching", calibrateKeyStretching);
+    installFunc1(rt, context, "opaque_prewarmKeyStretching", prewarmKeyStretching);
+    installFunc(rt, context, "opaque_releaseKeyStretchingMemory", 0, releaseKeyStretchingMemory);
+    installFunc(rt, context, "opaque_getCpuTopology", 0, getCpuTopology);
+
+    installFunc1(rt, context, "opaque_createServerSetup", createServerSetup);
+    installFunc(rt, context, "opaque_createServerSetupHandle", 2, createServerSetupHandle);
+    installFunc(rt, context, "opaque_getServerPublicKey", 2, getServerPublicKey);
+    installFunc1(rt, context, "opaque_createServerRegistrationResponse", createServerRegistrationResponse);
+    installTryFunc1(rt, context, "opaque_startServerLogin", startServerLogin);
+    installFunc(rt, context, "opaque_startServerLoginBatch", 3, startServerLoginBatch);
+    installTryFunc1(rt, context, "opaque_finishServerLogin", finishServerLogin);
+    installFunc1(rt, context, "opaque_createServerLoginSessionStore", createServerLoginSessionStore);
+    installFunc1(rt, context, "opaque_getServerLoginSessionCount", getServerLoginSessionCount);
+    installTryFunc1(rt, context, "opaque_startServerLoginSession", startServerLoginSession);
+    installTryFunc1(rt, context, "opaque_finishServerLoginSession", finishServerLoginSession);
+    installFunc1(rt, context, "opaque_createRegistrationImport", createRegistrationImport);
+    installFunc(rt, context, "opaque_createServerSetupKeyring", 0, createServerSetupKeyring);
+    installFunc1(rt, context, "opaque_addServerSetupKey", addServerSetupKey);
+    installFunc1(rt, context, "opaque_setActiveServerSetupKey", setActiveServerSetupKey);
+    installFunc1(rt, context, "opaque_removeServerSetupKey", removeServerSetupKey);
+    installFunc1(rt, context, "opaque_getServerSetupKeys", getServerSetupKeys);
+
+    installFunc1(rt, context, "opaque_startClientRegistrationBinary", startClientRegistrationBinary);
+    installFunc1(rt, context, "opaque_finishClientRegistrationBinary", finishClientRegistrationBinary);
+    installFunc1(rt, context, "opaque_startClientLoginBinary", startClientLoginBinary);
+    installTryFunc1(rt, context, "opaque_finishClientLoginBinary", finishClientLoginBinary);
+
+    installFunc1(rt, context, "opaque_createServerSetupBinary", createServerSetupBinary);
+    installFunc(rt, context, "opaque_getServerPublicKeyBinary", 2, getServerPublicKeyBinary);
+    installFunc1(rt, context, "opaque_createServerRegistrationResponseBinary", createServerRegistrationResponseBinary);
+    installTryFunc1(rt, context, "opaque_startServerLoginBinary", startServerLoginBinary);
+    installTryFunc1(rt, context, "opaque_finishServerLoginBinary", finishServerLoginBinary);
+
+    installFunc1(rt, context, "opaque_setMetricsEnabled", setMetricsEnabled);
+    installFunc(rt, context, "opaque_getMetrics", 0, getMetrics);
+    installFunc(rt, context, "opaque_resetMetrics", 0, resetMetrics);
 
-    installFunc(rt, "opaque_createServerSetup", 0, createServerSetup);
-    installFunc1(rt, "opaque_getServerPublicKey", getServerPublicKey);
-    installFunc1(rt, "opaque_createServerRegistrationResponse", createServerRegistrationResponse);
-    installFunc1(rt, "opaque_startServerLogin", startServerLogin);
-    installFunc1(rt, "opaque_finishServerLogin", finishServerLogin);
+    installAsyncFunc(rt, context, "opaque_finishClientRegistrationAsync", 2, finishClientRegistrationAsync);
+    installAsyncFunc(rt, context, "opaque_finishClientLoginAsync", 2, finishClientLoginAsync);
+    installAsyncFunc(rt, context, "opaque_finishClientLoginContextAsync", 2, finishClientLoginContextAsync);
+    installAsyncFunc(rt, context, "opaque_nextRegistrationImportChunk", 2, nextRegistrationImportChunk);
+    installAsyncFunc(rt, context, "opaque_cancelAsync", 1, cancelAsync);
   }
 }  // namespace NativeOpaque
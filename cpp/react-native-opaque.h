@@ -1,11 +1,30 @@
 #include <jsi/jsilib.h>
 #include <jsi/jsi.h>
+#include <ReactCommon/CallInvoker.h>
 
 #ifndef CPP_REACT_NATIVE_OPAQUE_H_
 #define CPP_REACT_NATIVE_OPAQUE_H_
 
+#include <memory>
+
 namespace NativeOpaque {
-    void installOpaque(facebook::jsi::Runtime& jsiRuntime);
+    // Installs the module into a runtime. It can be installed into any
+    // number of runtimes (e.g. a worklet or background runtime next to the
+    // main one), which can call it concurrently from their own threads. Each
+    // runtime gets its own prop names and pending jobs, and the handles,
+    // keyrings and session stores it creates are only used on its JS thread.
+    // The runtimes share the worker pool and the global state of the Rust
+    // library (key stretching memory, metrics), which are behind locks and
+    // atomics.
+    //
+    // The call invoker is used to settle the promises of the async functions
+    // on the JS thread. Without one (nullptr) the async functions throw.
+    void installOpaque(facebook::jsi::Runtime& jsiRuntime,
+        std::shared_ptr<facebook::react::CallInvoker> callInvoker);
+
+    // Frees the memory kept for the key stretching, called by the platform
+    // modules on memory pressure. Safe to call from any thread.
+    void trimMemory();
 }
 
 #endif  // CPP_REACT_NATIVE_OPAQUE_H_
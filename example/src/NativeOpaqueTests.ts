@@ -0,0 +1,1274 @@
+import * as opaque from 'react-native-opaque';
+import { describe, expect, test } from './Test';
+
+// Tests for the APIs which are only available in the native (JSI) module.
+
+function setupRegistration(userIdentifier: string, password: string) {
+  const serverSetup = opaque.server.createSetup();
+  const { clientRegistrationState, registrationRequest } =
+    opaque.client.startRegistration({ password });
+  const { registrationResponse } = opaque.server.createRegistrationResponse({
+    serverSetup,
+    userIdentifier,
+    registrationRequest,
+  });
+  return { serverSetup, clientRegistrationState, registrationResponse };
+}
+
+async function expectReject(promise: Promise<unknown>, msg: string) {
+  try {
+    await promise;
+  } catch (err) {
+    if (!(err instanceof Error) || !err.message.includes(msg)) {
+      throw new Error(`unexpected rejection: ${err}`);
+    }
+    return;
+  }
+  throw new Error('expected promise to reject');
+}
+
+describe('async', () => {
+  test('full registration & login flow', async () => {
+    const userIdentifier = 'user123';
+    const password = 'hunter42';
+
+    const { serverSetup, clientRegistrationState, registrationResponse } =
+      setupRegistration(userIdentifier, password);
+
+    const { registrationRecord, exportKey } =
+      await opaque.client.finishRegistrationAsync({
+        clientRegistrationState,
+        registrationResponse,
+        password,
+      });
+
+    const { clientLoginState, startLoginRequest } = opaque.client.startLogin({
+      password,
+    });
+    const { serverLoginState, loginResponse } = opaque.server.startLogin({
+      serverSetup,
+      userIdentifier,
+      registrationRecord,
+      startLoginRequest,
+    });
+
+    const loginResult = await opaque.client.finishLoginAsync({
+      clientLoginState,
+      loginResponse,
+      password,
+    });
+    if (!loginResult) throw new Error('login failed');
+
+    expect(loginResult.exportKey).toEqual(exportKey);
+
+    const { sessionKey } = opaque.server.finishLogin({
+      serverLoginState,
+      finishLoginRequest: loginResult.finishLoginRequest,
+    });
+    expect(sessionKey).toEqual(loginResult.sessionKey);
+  });
+
+  test('finishLoginAsync with bad password resolves undefined', async () => {
+    const userIdentifier = 'user123';
+    const { serverSetup, clientRegistrationState, registrationResponse } =
+      setupRegistration(userIdentifier, 'hunter42');
+    const { registrationRecord } = opaque.client.finishRegistration({
+      clientRegistrationState,
+      registrationResponse,
+      password: 'hunter42',
+    });
+    const { clientLoginState, startLoginRequest } = opaque.client.startLogin({
+      password: 'hunter42',
+    });
+    const { loginResponse } = opaque.server.startLogin({
+      serverSetup,
+      userIdentifier,
+      registrationRecord,
+      startLoginRequest,
+    });
+    const loginResult = await opaque.client.finishLoginAsync({
+      clientLoginState,
+      loginResponse,
+      password: 'hunter23',
+    });
+    expect(loginResult).toBeUndefined();
+  });
+
+  test('finishRegistrationAsync rejects invalid input', async () => {
+    const { clientRegistrationState } = opaque.client.startRegistration({
+      password: 'hunter2',
+    });
+    await expectReject(
+      opaque.client.finishRegistrationAsync({
+        password: 'hunter2',
+        registrationResponse: 'a',
+        clientRegistrationState,
+      }),
+      'base64 decoding failed at "registrationResponse"'
+    );
+  });
+
+  test('already aborted signal', async () => {
+    const { clientRegistrationState, registrationResponse } =
+      setupRegistration('user123', 'hunter2');
+    await expectReject(
+      opaque.client.finishRegistrationAsync(
+        { clientRegistrationState, registrationResponse, password: 'hunter2' },
+        {
+          signal: {
+            aborted: true,
+            addEventListener() {},
+            removeEventListener() {},
+          },
+        }
+      ),
+      'cancelled'
+    );
+  });
+});
+
+describe('server.createSetupHandle', () => {
+  test('full registration & login flow', () => {
+    const userIdentifier = 'user123';
+    const password = 'hunter42';
+    const serverSetup = opaque.server.createSetupHandle(
+      opaque.server.createSetup()
+    );
+
+    const { clientRegistrationState, registrationRequest } =
+      opaque.client.startRegistration({ password });
+    const { registrationResponse } = opaque.server.createRegistrationResponse({
+      serverSetup,
+      userIdentifier,
+      registrationRequest,
+    });
+    const { registrationRecord, serverStaticPublicKey } =
+      opaque.client.finishRegistration({
+        clientRegistrationState,
+        registrationResponse,
+        password,
+      });
+    expect(opaque.server.getPublicKey(serverSetup)).toEqual(
+      serverStaticPublicKey
+    );
+
+    const { clientLoginState, startLoginRequest } = opaque.client.startLogin({
+      password,
+    });
+    const { serverLoginState, loginResponse } = opaque.server.startLogin({
+      serverSetup,
+      userIdentifier,
+      registrationRecord,
+      startLoginRequest,
+    });
+    const loginResult = opaque.client.finishLogin({
+      clientLoginState,
+      loginResponse,
+      password,
+    });
+    if (!loginResult) throw new Error('login failed');
+
+    const { sessionKey } = opaque.server.finishLogin({
+      serverLoginState,
+      finishLoginRequest: loginResult.finishLoginRequest,
+    });
+    expect(sessionKey).toEqual(loginResult.sessionKey);
+  });
+
+  test('handle and string are interchangeable', () => {
+    const serverSetup = opaque.server.createSetup();
+    const serverSetupHandle = opaque.server.createSetupHandle(serverSetup);
+    expect(opaque.server.getPublicKey(serverSetupHandle)).toEqual(
+      opaque.server.getPublicKey(serverSetup)
+    );
+  });
+
+  test('invalid server setup', () => {
+    expect(() => opaque.server.createSetupHandle('a')).toThrow(
+      'base64 decoding failed at "serverSetup"'
+    );
+    expect(() =>
+      // @ts-expect-error intentional test of invalid input
+      opaque.server.createSetupHandle(123)
+    ).toThrow();
+  });
+
+  test('invalid handle object', () => {
+    const { registrationRequest } = opaque.client.startRegistration({
+      password: 'hunter2',
+    });
+    expect(() =>
+      opaque.server.createRegistrationResponse({
+        // @ts-expect-error intentional test of invalid input
+        serverSetup: {},
+        userIdentifier: 'user123',
+        registrationRequest,
+      })
+    ).toThrow('serverSetup must be a string or a server setup handle');
+  });
+});
+
+describe('cipher suites', () => {
+  test('explicit default suite', () => {
+    const userIdentifier = 'user123';
+    const password = 'hunter42';
+    const suite = 'ristretto255';
+    const serverSetup = opaque.server.createSetupHandle(
+      opaque.server.createSetup({ suite }),
+      { suite }
+    );
+
+    const { clientRegistrationState, registrationRequest } =
+      opaque.client.startRegistration({ password, suite });
+    const { registrationResponse } = opaque.server.createRegistrationResponse({
+      serverSetup,
+      userIdentifier,
+      registrationRequest,
+      suite,
+    });
+    const { registrationRecord } = opaque.client.finishRegistration({
+      clientRegistrationState,
+      registrationResponse,
+      password,
+      suite,
+    });
+
+    // the suite can be omitted, it defaults to the one of the handle
+    const { clientLoginState, startLoginRequest } = opaque.client.startLogin({
+      password,
+    });
+    const { serverLoginState, loginResponse } = opaque.server.startLogin({
+      serverSetup,
+      userIdentifier,
+      registrationRecord,
+      startLoginRequest,
+    });
+    const loginResult = opaque.client.finishLogin({
+      clientLoginState,
+      loginResponse,
+      password,
+      suite,
+    });
+    if (!loginResult) throw new Error('login failed');
+
+    const { sessionKey } = opaque.server.finishLogin({
+      serverLoginState,
+      finishLoginRequest: loginResult.finishLoginRequest,
+      suite,
+    });
+    expect(sessionKey).toEqual(loginResult.sessionKey);
+  });
+
+  test('suite not compiled in', () => {
+    const serverSetup = opaque.server.createSetup();
+    expect(() => opaque.server.createSetup({ suite: 'p256' })).toThrow(
+      'the P-256 cipher suite is not enabled in this build'
+    );
+    expect(() =>
+      opaque.client.startRegistration({ password: 'hunter2', suite: 'p256' })
+    ).toThrow('the P-256 cipher suite is not enabled in this build');
+    expect(() =>
+      opaque.server.getPublicKey(opaque.server.createSetupHandle(serverSetup), {
+        suite: 'p256',
+      })
+    ).toThrow('the P-256 cipher suite is not enabled in this build');
+  });
+
+  test('invalid suite', () => {
+    expect(() =>
+      opaque.client.startLogin({
+        password: 'hunter2',
+        // @ts-expect-error intentional test of invalid input
+        suite: 'curve25519',
+      })
+    ).toThrow('"suite" must be "ristretto255" or "p256"');
+    expect(() =>
+      // @ts-expect-error intentional test of invalid input
+      opaque.binary.server.createSetup({ suite: 1 })
+    ).toThrow('"suite" must be "ristretto255" or "p256"');
+  });
+});
+
+function bytesEqual(a: Uint8Array, b: Uint8Array) {
+  return a.length === b.length && a.every((value, i) => value === b[i]);
+}
+
+describe('binary', () => {
+  test('full registration & login flow', () => {
+    const userIdentifier = 'user123';
+    const password = 'hunter42';
+    const serverSetup = opaque.binary.server.createSetup();
+    expect(serverSetup instanceof Uint8Array).toBe(true);
+
+    const { clientRegistrationState, registrationRequest } =
+      opaque.binary.client.startRegistration({ password });
+    const { registrationResponse } =
+      opaque.binary.server.createRegistrationResponse({
+        serverSetup,
+        userIdentifier,
+        registrationRequest,
+      });
+    const { registrationRecord, exportKey, serverStaticPublicKey } =
+      opaque.binary.client.finishRegistration({
+        clientRegistrationState,
+        registrationResponse,
+        password,
+      });
+    expect(
+      bytesEqual(
+        opaque.binary.server.getPublicKey(serverSetup),
+        serverStaticPublicKey
+      )
+    ).toBe(true);
+
+    const { clientLoginState, startLoginRequest } =
+      opaque.binary.client.startLogin({ password });
+    const { serverLoginState, loginResponse } =
+      opaque.binary.server.startLogin({
+        serverSetup,
+        userIdentifier,
+        registrationRecord,
+        startLoginRequest,
+      });
+    const loginResult = opaque.binary.client.finishLogin({
+      clientLoginState,
+      loginResponse,
+      password,
+    });
+    if (!loginResult) throw new Error('login failed');
+    expect(bytesEqual(loginResult.exportKey, exportKey)).toBe(true);
+
+    const { sessionKey } = opaque.binary.server.finishLogin({
+      serverLoginState,
+      finishLoginRequest: loginResult.finishLoginRequest,
+    });
+    expect(bytesEqual(sessionKey, loginResult.sessionKey)).toBe(true);
+  });
+
+  test('server setup handle and ArrayBuffer views', () => {
+    const userIdentifier = 'user123';
+    const password = 'hunter42';
+    const setupBytes = opaque.binary.server.createSetup();
+    const serverSetup = opaque.server.createSetupHandle(setupBytes);
+
+    const { clientRegistrationState, registrationRequest } =
+      opaque.binary.client.startRegistration({ password });
+    // pass a view with an offset into a larger buffer
+    const padded = new Uint8Array(registrationRequest.length + 8);
+    padded.set(registrationRequest, 4);
+    const { registrationResponse } =
+      opaque.binary.server.createRegistrationResponse({
+        serverSetup,
+        userIdentifier,
+        registrationRequest: padded.subarray(4, 4 + registrationRequest.length),
+      });
+    const { registrationRecord } = opaque.binary.client.finishRegistration({
+      clientRegistrationState: clientRegistrationState.slice().buffer,
+      registrationResponse,
+      password,
+    });
+
+    const { clientLoginState, startLoginRequest } =
+      opaque.binary.client.startLogin({ password });
+    const { loginResponse } = opaque.binary.server.startLogin({
+      serverSetup,
+      userIdentifier,
+      registrationRecord,
+      startLoginRequest,
+    });
+    const loginResult = opaque.binary.client.finishLogin({
+      clientLoginState,
+      loginResponse,
+      password: 'hunter23',
+    });
+    expect(loginResult).toBeUndefined();
+  });
+
+  test('missing registration record', () => {
+    const { startLoginRequest } = opaque.binary.client.startLogin({
+      password: 'hunter2',
+    });
+    const { loginResponse } = opaque.binary.server.startLogin({
+      serverSetup: opaque.binary.server.createSetup(),
+      userIdentifier: 'user123',
+      registrationRecord: null,
+      startLoginRequest,
+    });
+    expect(loginResponse.length > 0).toBe(true);
+  });
+
+  test('invalid input', () => {
+    const { clientRegistrationState } = opaque.binary.client.startRegistration(
+      { password: 'hunter2' }
+    );
+    expect(() =>
+      opaque.binary.client.finishRegistration({
+        password: 'hunter2',
+        // @ts-expect-error intentional test of invalid input
+        registrationResponse: 'abc',
+        clientRegistrationState,
+      })
+    ).toThrow(
+      'property "registrationResponse" has invalid type, expected Uint8Array or ArrayBuffer but got a string'
+    );
+    expect(() =>
+      opaque.binary.client.finishRegistration({
+        password: 'hunter2',
+        registrationResponse: new Uint8Array(0),
+        clientRegistrationState,
+      })
+    ).toThrow(
+      'opaque protocol error at "deserialize registrationResponse"; Internal error encountered'
+    );
+  });
+});
+
+describe('server.startLoginBatch', () => {
+  test('mixed valid and invalid requests', () => {
+    const password = 'hunter42';
+    const serverSetup = opaque.server.createSetup();
+    const users = ['alice', 'bob', 'carol', 'dave', 'eve', 'frank'];
+    const records = users.map((userIdentifier) => {
+      const { clientRegistrationState, registrationRequest } =
+        opaque.client.startRegistration({ password });
+      const { registrationResponse } = opaque.server.createRegistrationResponse(
+        { serverSetup, userIdentifier, registrationRequest }
+      );
+      return opaque.client.finishRegistration({
+        clientRegistrationState,
+        registrationResponse,
+        password,
+      }).registrationRecord;
+    });
+    const logins = users.map(() => opaque.client.startLogin({ password }));
+
+    const results = opaque.server.startLoginBatch(serverSetup, [
+      ...users.map((userIdentifier, i) => ({
+        userIdentifier,
+        registrationRecord: records[i],
+        startLoginRequest: logins[i]!.startLoginRequest,
+      })),
+      {
+        userIdentifier: 'mallory',
+        registrationRecord: null,
+        startLoginRequest: 'a',
+      },
+      // @ts-expect-error intentional test of invalid input
+      { userIdentifier: 'mallory' },
+    ]);
+    expect(results.length).toBe(users.length + 2);
+    expect(results[users.length]).toEqual({
+      error: 'base64',
+      message:
+        'base64 decoding failed at "startLoginRequest"; Encoded text cannot have a 6-bit remainder.',
+    });
+    expect(results[users.length + 1]).toEqual({
+      error: 'input',
+      message: 'missing required property "startLoginRequest" in input params',
+    });
+
+    users.forEach((userIdentifier, i) => {
+      const result = results[i]!;
+      if (result.error !== undefined) throw new Error(result.message);
+      const loginResult = opaque.client.finishLogin({
+        clientLoginState: logins[i]!.clientLoginState,
+        loginResponse: result.loginResponse,
+        password,
+      });
+      if (!loginResult) throw new Error(`login failed for ${userIdentifier}`);
+      const { sessionKey } = opaque.server.finishLogin({
+        serverLoginState: result.serverLoginState,
+        finishLoginRequest: loginResult.finishLoginRequest,
+      });
+      expect(sessionKey).toEqual(loginResult.sessionKey);
+    });
+  });
+
+  test('invalid arguments', () => {
+    expect(() =>
+      // @ts-expect-error intentional test of invalid input
+      opaque.server.startLoginBatch(opaque.server.createSetup(), {})
+    ).toThrow('requests must be an array');
+    expect(() => opaque.server.startLoginBatch('a', [])).toThrow(
+      'base64 decoding failed at "serverSetup"'
+    );
+  });
+});
+
+describe('key stretching', () => {
+  const keyStretching = { memoryCost: 1024, iterations: 1, parallelism: 1 };
+
+  test('login reproduces the registration params', () => {
+    const userIdentifier = 'user123';
+    const password = 'hunter42';
+    const { serverSetup, clientRegistrationState, registrationResponse } =
+      setupRegistration(userIdentifier, password);
+    const registration = opaque.client.finishRegistration({
+      clientRegistrationState,
+      registrationResponse,
+      password,
+      keyStretching,
+    });
+    expect(registration.keyStretching).toEqual(keyStretching);
+
+    const login = (params?: opaque.KeyStretchingParams) => {
+      const { clientLoginState, startLoginRequest } = opaque.client.startLogin(
+        { password }
+      );
+      const { loginResponse } = opaque.server.startLogin({
+        serverSetup,
+        userIdentifier,
+        registrationRecord: registration.registrationRecord,
+        startLoginRequest,
+      });
+      return opaque.client.finishLogin({
+        clientLoginState,
+        loginResponse,
+        password,
+        keyStretching: params,
+      });
+    };
+
+    expect(login(registration.keyStretching)?.exportKey).toEqual(
+      registration.exportKey
+    );
+    expect(login()).toBeUndefined();
+  });
+
+  test('defaults', () => {
+    const { clientRegistrationState, registrationResponse } =
+      setupRegistration('user123', 'hunter42');
+    const registration = opaque.client.finishRegistration({
+      clientRegistrationState,
+      registrationResponse,
+      password: 'hunter42',
+    });
+    expect(registration.keyStretching).toEqual({
+      memoryCost: 19456,
+      iterations: 2,
+      parallelism: 1,
+    });
+  });
+
+  test('invalid params', () => {
+    const { clientRegistrationState, registrationResponse } =
+      setupRegistration('user123', 'hunter42');
+    const finish = (params: opaque.KeyStretchingParams) =>
+      opaque.client.finishRegistration({
+        clientRegistrationState,
+        registrationResponse,
+        password: 'hunter42',
+        keyStretching: params,
+      });
+    expect(() => finish({ ...keyStretching, memoryCost: 1 })).toThrow(
+      'invalid key stretching params'
+    );
+    expect(() => finish({ ...keyStretching, iterations: -1 })).toThrow(
+      'property "iterations" must be an unsigned 32-bit integer'
+    );
+    expect(() =>
+      // @ts-expect-error intentional test of invalid input
+      finish({ memoryCost: 1024, iterations: 1 })
+    ).toThrow(
+      'property "parallelism" has invalid type, expected number but got undefined'
+    );
+  });
+
+  test('calibrateKeyStretching', () => {
+    const params = opaque.client.calibrateKeyStretching({
+      targetDurationMs: 100,
+    });
+    expect(params.parallelism).toBe(1);
+    expect(params.memoryCost >= 8 * 1024).toBe(true);
+    expect(params.iterations >= 1).toBe(true);
+    expect(() =>
+      opaque.client.calibrateKeyStretching({ targetDurationMs: 0 })
+    ).toThrow('targetDurationMs must be greater than 0');
+  });
+
+  test('startLoginPipelined', async () => {
+    const userIdentifier = 'user123';
+    const password = 'hunter42';
+    const keyStretching = { memoryCost: 4096, iterations: 1, parallelism: 1 };
+    const { serverSetup, clientRegistrationState, registrationResponse } =
+      setupRegistration(userIdentifier, password);
+    const { registrationRecord, exportKey } = opaque.client.finishRegistration({
+      clientRegistrationState,
+      registrationResponse,
+      password,
+      keyStretching,
+    });
+    for (const finish of [
+      opaque.client.finishLogin,
+      opaque.client.finishLoginAsync,
+    ]) {
+      const { clientLoginState, startLoginRequest } =
+        opaque.client.startLoginPipelined({ password, keyStretching });
+      const { loginResponse } = opaque.server.startLogin({
+        serverSetup,
+        userIdentifier,
+        registrationRecord,
+        startLoginRequest,
+      });
+      const loginResult = await finish({
+        clientLoginState,
+        loginResponse,
+        password,
+        keyStretching,
+      });
+      expect(loginResult?.exportKey).toEqual(exportKey);
+    }
+    expect(() =>
+      opaque.client.startLoginPipelined({
+        password,
+        // @ts-expect-error intentional test of invalid input
+        keyStretching: { memoryCost: 4096, iterations: 1 },
+      })
+    ).toThrow(
+      'property "parallelism" has invalid type, expected number but got undefined'
+    );
+  });
+
+  test('prewarmKeyStretching', () => {
+    const userIdentifier = 'user123';
+    const password = 'hunter42';
+    const keyStretching = { memoryCost: 4096, iterations: 1, parallelism: 1 };
+    opaque.client.prewarmKeyStretching({ keyStretching });
+    const { serverSetup, clientRegistrationState, registrationResponse } =
+      setupRegistration(userIdentifier, password);
+    const { registrationRecord, exportKey } = opaque.client.finishRegistration({
+      clientRegistrationState,
+      registrationResponse,
+      password,
+      keyStretching,
+    });
+    opaque.client.releaseKeyStretchingMemory();
+    const { clientLoginState, startLoginRequest } = opaque.client.startLogin({
+      password,
+    });
+    const { loginResponse } = opaque.server.startLogin({
+      serverSetup,
+      userIdentifier,
+      registrationRecord,
+      startLoginRequest,
+    });
+    const loginResult = opaque.client.finishLogin({
+      clientLoginState,
+      loginResponse,
+      password,
+      keyStretching,
+    });
+    expect(loginResult?.exportKey).toEqual(exportKey);
+
+    opaque.client.prewarmKeyStretching();
+    opaque.client.releaseKeyStretchingMemory();
+    expect(() =>
+      opaque.client.prewarmKeyStretching({
+        keyStretching: { memoryCost: 1, iterations: 1, parallelism: 1 },
+      })
+    ).toThrow('invalid key stretching params');
+  });
+});
+
+describe('parallel key stretching', () => {
+  test('getCpuTopology', () => {
+    const { cores, performanceCores } = opaque.client.getCpuTopology();
+    expect(cores >= 1).toBe(true);
+    expect(performanceCores >= 1 && performanceCores <= cores).toBe(true);
+  });
+
+  test('multiple lanes', () => {
+    const userIdentifier = 'user123';
+    const password = 'hunter42';
+    const keyStretching = { memoryCost: 4096, iterations: 2, parallelism: 4 };
+    const { serverSetup, clientRegistrationState, registrationResponse } =
+      setupRegistration(userIdentifier, password);
+    const { registrationRecord, exportKey } = opaque.client.finishRegistration({
+      clientRegistrationState,
+      registrationResponse,
+      password,
+      keyStretching,
+    });
+    const { clientLoginState, startLoginRequest } = opaque.client.startLogin({
+      password,
+    });
+    const { loginResponse } = opaque.server.startLogin({
+      serverSetup,
+      userIdentifier,
+      registrationRecord,
+      startLoginRequest,
+    });
+    const loginResult = opaque.client.finishLogin({
+      clientLoginState,
+      loginResponse,
+      password,
+      keyStretching,
+    });
+    expect(loginResult?.exportKey).toEqual(exportKey);
+  });
+});
+
+describe('input marshalling', () => {
+  test('missing and undefined properties', () => {
+    expect(() =>
+      // @ts-expect-error intentional test of invalid input
+      opaque.client.startLogin({})
+    ).toThrow('missing required property "password" in input params');
+    expect(() =>
+      // @ts-expect-error intentional test of invalid input
+      opaque.client.startLogin({ password: undefined })
+    ).toThrow(
+      'property "password" has invalid type, expected string but got undefined'
+    );
+  });
+
+  test('undefined identifiers', () => {
+    const userIdentifier = 'user123';
+    const password = 'hunter42';
+    const { clientRegistrationState, registrationResponse } =
+      setupRegistration(userIdentifier, password);
+    const { registrationRecord } = opaque.client.finishRegistration({
+      clientRegistrationState,
+      registrationResponse,
+      password,
+      identifiers: { client: undefined, server: undefined },
+    });
+    expect(typeof registrationRecord).toBe('string');
+  });
+});
+
+describe('server login sessions', () => {
+  function startSession(sessionStore: opaque.server.LoginSessionStore) {
+    const userIdentifier = 'user123';
+    const password = 'hunter42';
+    const { serverSetup, clientRegistrationState, registrationResponse } =
+      setupRegistration(userIdentifier, password);
+    const { registrationRecord } = opaque.client.finishRegistration({
+      clientRegistrationState,
+      registrationResponse,
+      password,
+    });
+    const { clientLoginState, startLoginRequest } = opaque.client.startLogin({
+      password,
+    });
+    const { sessionHandle, loginResponse } = opaque.server.startLoginSession({
+      sessionStore,
+      serverSetup,
+      userIdentifier,
+      registrationRecord,
+      startLoginRequest,
+    });
+    const loginResult = opaque.client.finishLogin({
+      clientLoginState,
+      loginResponse,
+      password,
+    });
+    if (!loginResult) throw new Error('login failed');
+    return { sessionHandle, loginResult };
+  }
+
+  test('finish a login once', () => {
+    const sessionStore = opaque.server.createLoginSessionStore();
+    const { sessionHandle, loginResult } = startSession(sessionStore);
+    expect(opaque.server.getLoginSessionCount(sessionStore)).toBe(1);
+
+    const finishParams = {
+      sessionStore,
+      sessionHandle,
+      finishLoginRequest: loginResult.finishLoginRequest,
+    };
+    const { sessionKey } = opaque.server.finishLoginSession(finishParams);
+    expect(sessionKey).toEqual(loginResult.sessionKey);
+    expect(opaque.server.getLoginSessionCount(sessionStore)).toBe(0);
+    expect(() => opaque.server.finishLoginSession(finishParams)).toThrow(
+      'unknown login session, it expired or was already finished'
+    );
+  });
+
+  test('sessions belong to their store', () => {
+    const { sessionHandle, loginResult } = startSession(
+      opaque.server.createLoginSessionStore()
+    );
+    expect(() =>
+      opaque.server.finishLoginSession({
+        sessionStore: opaque.server.createLoginSessionStore(),
+        sessionHandle,
+        finishLoginRequest: loginResult.finishLoginRequest,
+      })
+    ).toThrow('unknown login session');
+  });
+
+  test('invalid params', () => {
+    expect(() =>
+      opaque.server.createLoginSessionStore({ maxMemoryBytes: 1 })
+    ).toThrow('the memory limit of the login sessions must be at least');
+    expect(() => opaque.server.createLoginSessionStore({ ttlMs: 0 })).toThrow(
+      'the TTL of the login sessions must be positive'
+    );
+    expect(() =>
+      opaque.server.finishLoginSession({
+        // @ts-expect-error intentional test of invalid input
+        sessionStore: {},
+        sessionHandle: 'a',
+        finishLoginRequest: 'a',
+      })
+    ).toThrow('sessionStore must be a login session store');
+  });
+});
+
+describe('server setup keyring', () => {
+  const userIdentifier = 'user123';
+  const password = 'hunter42';
+
+  function register(keyring: opaque.server.ServerSetupKeyring) {
+    const { clientRegistrationState, registrationRequest } =
+      opaque.client.startRegistration({ password });
+    const keyId = opaque.server.getSetupKeys(keyring).activeKeyId;
+    const { registrationResponse } = opaque.server.createRegistrationResponse({
+      serverSetup: keyring,
+      keyId,
+      userIdentifier,
+      registrationRequest,
+    });
+    const { registrationRecord } = opaque.client.finishRegistration({
+      clientRegistrationState,
+      registrationResponse,
+      password,
+    });
+    return { registrationRecord, keyId };
+  }
+
+  function login(
+    keyring: opaque.server.ServerSetupKeyring,
+    registrationRecord: string,
+    keyId?: string
+  ) {
+    const { clientLoginState, startLoginRequest } = opaque.client.startLogin({
+      password,
+    });
+    const { loginResponse } = opaque.server.startLogin({
+      serverSetup: keyring,
+      keyId,
+      userIdentifier,
+      registrationRecord,
+      startLoginRequest,
+    });
+    return opaque.client.finishLogin({
+      clientLoginState,
+      loginResponse,
+      password,
+    });
+  }
+
+  test('rotate the active key', () => {
+    const keyring = opaque.server.createSetupKeyring();
+    opaque.server.addSetupKey({
+      keyring,
+      keyId: '2024',
+      serverSetup: opaque.server.createSetup(),
+    });
+    const oldUser = register(keyring);
+    opaque.server.addSetupKey({
+      keyring,
+      keyId: '2025',
+      serverSetup: opaque.server.createSetupHandle(opaque.server.createSetup()),
+    });
+    opaque.server.setActiveSetupKey({ keyring, keyId: '2025' });
+    const newUser = register(keyring);
+
+    expect(oldUser.keyId).toBe('2024');
+    expect(newUser.keyId).toBe('2025');
+    expect(
+      login(keyring, oldUser.registrationRecord, oldUser.keyId) !== undefined
+    ).toBe(true);
+    expect(login(keyring, newUser.registrationRecord) !== undefined).toBe(
+      true
+    );
+    expect(login(keyring, oldUser.registrationRecord)).toBeUndefined();
+
+    expect(opaque.server.removeSetupKey({ keyring, keyId: '2024' })).toBe(
+      true
+    );
+    expect(opaque.server.getSetupKeys(keyring).keyIds).toEqual(['2025']);
+    expect(() =>
+      login(keyring, oldUser.registrationRecord, oldUser.keyId)
+    ).toThrow('unknown server setup key "2024"');
+  });
+
+  test('invalid params', () => {
+    const keyring = opaque.server.createSetupKeyring();
+    expect(opaque.server.getSetupKeys(keyring)).toEqual({ keyIds: [] });
+    expect(() => opaque.server.getPublicKey(keyring)).toThrow(
+      'the server setup keyring has no keys'
+    );
+    const serverSetup = opaque.server.createSetup();
+    opaque.server.addSetupKey({ keyring, keyId: 'a', serverSetup });
+    expect(opaque.server.getPublicKey(keyring, { keyId: 'a' })).toEqual(
+      opaque.server.getPublicKey(serverSetup)
+    );
+    expect(() =>
+      opaque.server.addSetupKey({ keyring, keyId: 'a', serverSetup })
+    ).toThrow('server setup key "a" already exists');
+    expect(() =>
+      opaque.server.setActiveSetupKey({ keyring, keyId: 'b' })
+    ).toThrow('unknown server setup key "b"');
+    expect(() =>
+      opaque.server.removeSetupKey({ keyring, keyId: 'a' })
+    ).toThrow("the active server setup key can't be removed");
+  });
+});
+
+describe('client.startLoginContext', () => {
+  function register(password: string) {
+    const userIdentifier = 'user123';
+    const { serverSetup, clientRegistrationState, registrationResponse } =
+      setupRegistration(userIdentifier, 'hunter42');
+    const { registrationRecord, exportKey } =
+      opaque.client.finishRegistration({
+        clientRegistrationState,
+        registrationResponse,
+        password: 'hunter42',
+        identifiers: { server: 'server.example' },
+      });
+    const context = opaque.client.startLoginContext({
+      password,
+      identifiers: { server: 'server.example' },
+    });
+    const { serverLoginState, loginResponse } = opaque.server.startLogin({
+      serverSetup,
+      userIdentifier,
+      registrationRecord,
+      startLoginRequest: context.startLoginRequest,
+      identifiers: { server: 'server.example' },
+    });
+    return { context, serverLoginState, loginResponse, exportKey };
+  }
+
+  test('finish a login once', () => {
+    const { context, serverLoginState, loginResponse, exportKey } =
+      register('hunter42');
+    const loginResult = context.finish(loginResponse);
+    if (!loginResult) throw new Error('login failed');
+    expect(loginResult.exportKey).toEqual(exportKey);
+    const { sessionKey } = opaque.server.finishLogin({
+      serverLoginState,
+      finishLoginRequest: loginResult.finishLoginRequest,
+    });
+    expect(sessionKey).toEqual(loginResult.sessionKey);
+    expect(() => context.finish(loginResponse)).toThrow(
+      'the client login context was already finished'
+    );
+  });
+
+  test('bad password', () => {
+    const { context, loginResponse } = register('hunter43');
+    expect(context.finish(loginResponse)).toBeUndefined();
+    expect(() => context.finish(loginResponse)).toThrow('already finished');
+  });
+
+  test('finishAsync', async () => {
+    const { context, loginResponse, exportKey } = register('hunter42');
+    const loginResult = await context.finishAsync(loginResponse);
+    if (!loginResult) throw new Error('login failed');
+    expect(loginResult.exportKey).toEqual(exportKey);
+    await expectReject(context.finishAsync(loginResponse), 'already finished');
+  });
+
+  test('invalid params', () => {
+    const { context } = register('hunter42');
+    expect(() => context.finish('a')).toThrow('base64 decoding failed');
+    expect(() =>
+      opaque.client.startLoginContext({
+        password: 'hunter42',
+        // @ts-expect-error intentional test of invalid input
+        identifiers: { client: 42 },
+      })
+    ).toThrow('identifier "client" must be a string');
+  });
+});
+
+describe('result mode', () => {
+  function startLogin(password: string) {
+    const userIdentifier = 'user123';
+    const { serverSetup, clientRegistrationState, registrationResponse } =
+      setupRegistration(userIdentifier, 'hunter42');
+    const { registrationRecord } = opaque.client.finishRegistration({
+      clientRegistrationState,
+      registrationResponse,
+      password: 'hunter42',
+    });
+    const { clientLoginState, startLoginRequest } = opaque.client.startLogin({
+      password,
+    });
+    const started = opaque.server.tryStartLogin({
+      serverSetup,
+      userIdentifier,
+      registrationRecord,
+      startLoginRequest,
+    });
+    if (!started.ok) throw new Error(started.message);
+    const { serverLoginState, loginResponse } = started.value;
+    return { clientLoginState, serverLoginState, loginResponse, password };
+  }
+
+  function expectError(
+    result: opaque.Result<unknown>,
+    error: opaque.ErrorCode,
+    msg: string
+  ) {
+    if (result.ok) throw new Error('expected the call to fail');
+    expect(result.error).toBe(error);
+    expect(result.message.includes(msg)).toBe(true);
+  }
+
+  test('successful login', () => {
+    const { clientLoginState, serverLoginState, loginResponse, password } =
+      startLogin('hunter42');
+    const finished = opaque.client.tryFinishLogin({
+      clientLoginState,
+      loginResponse,
+      password,
+    });
+    if (!finished.ok || !finished.value) throw new Error('login failed');
+    const result = opaque.server.tryFinishLogin({
+      serverLoginState,
+      finishLoginRequest: finished.value.finishLoginRequest,
+    });
+    if (!result.ok) throw new Error(result.message);
+    expect(result.value.sessionKey).toEqual(finished.value.sessionKey);
+  });
+
+  test('bad password', () => {
+    const { clientLoginState, loginResponse } = startLogin('hunter43');
+    const finished = opaque.client.tryFinishLogin({
+      clientLoginState,
+      loginResponse,
+      password: 'hunter43',
+    });
+    // the client detects the wrong password, like finishLogin
+    expect(finished.ok).toBe(true);
+    expect(finished.ok && finished.value).toBeUndefined();
+  });
+
+  test('forged finish request', () => {
+    const first = startLogin('hunter42');
+    const second = startLogin('hunter42');
+    const finished = opaque.client.finishLogin({
+      clientLoginState: second.clientLoginState,
+      loginResponse: second.loginResponse,
+      password: second.password,
+    });
+    if (!finished) throw new Error('login failed');
+    const result = opaque.server.tryFinishLogin({
+      serverLoginState: first.serverLoginState,
+      finishLoginRequest: finished.finishLoginRequest,
+    });
+    expectError(result, 'invalidLogin', 'opaque protocol error at');
+    expect(() =>
+      opaque.server.finishLogin({
+        serverLoginState: first.serverLoginState,
+        finishLoginRequest: finished.finishLoginRequest,
+      })
+    ).toThrow('opaque protocol error at');
+  });
+
+  test('invalid params', () => {
+    const { serverLoginState } = startLogin('hunter42');
+    expectError(
+      opaque.server.tryFinishLogin({
+        serverLoginState,
+        finishLoginRequest: 'a',
+      }),
+      'base64',
+      'base64 decoding failed'
+    );
+    expectError(
+      opaque.server.tryFinishLogin({
+        serverLoginState,
+        finishLoginRequest: '',
+      }),
+      'protocol',
+      'deserialize finishLoginRequest'
+    );
+    expectError(
+      // @ts-expect-error intentional test of invalid input
+      opaque.server.tryFinishLogin({ serverLoginState }),
+      'input',
+      'missing required property "finishLoginRequest"'
+    );
+    const sessionStore = opaque.server.createLoginSessionStore();
+    expectError(
+      opaque.server.tryFinishLoginSession({
+        sessionStore,
+        sessionHandle: 'a',
+        finishLoginRequest: 'a',
+      }),
+      'input',
+      'unknown login session'
+    );
+  });
+});
+
+describe('server.importRegistrations', () => {
+  // only ASCII user identifiers, which are their own UTF-8 encoding
+  function encodeRecords(records: [string, Uint8Array][]) {
+    const size = records.reduce(
+      (sum, [userIdentifier, request]) =>
+        sum + 8 + userIdentifier.length + request.length,
+      0
+    );
+    const out = new Uint8Array(size);
+    const view = new DataView(out.buffer);
+    let offset = 0;
+    for (const [userIdentifier, request] of records) {
+      view.setUint32(offset, userIdentifier.length, true);
+      for (let i = 0; i < userIdentifier.length; i++) {
+        out[offset + 4 + i] = userIdentifier.charCodeAt(i);
+      }
+      offset += 4 + userIdentifier.length;
+      view.setUint32(offset, request.length, true);
+      out.set(request, offset + 4);
+      offset += 4 + request.length;
+    }
+    return out;
+  }
+
+  function decodeResponses(responses: Uint8Array) {
+    const view = new DataView(
+      responses.buffer,
+      responses.byteOffset,
+      responses.byteLength
+    );
+    const entries = [];
+    let offset = 0;
+    while (offset < responses.length) {
+      const length = view.getUint32(offset + 1, true);
+      entries.push({
+        status: responses[offset],
+        payload: responses.slice(offset + 5, offset + 5 + length),
+      });
+      offset += 5 + length;
+    }
+    return entries;
+  }
+
+  test('streams the responses in chunks', async () => {
+    const password = 'hunter42';
+    const serverSetup = opaque.server.createSetupHandle(
+      opaque.server.createSetup()
+    );
+    const starts = Array.from({ length: 7 }, () =>
+      opaque.binary.client.startRegistration({ password })
+    );
+    const records = encodeRecords(
+      starts.map(({ registrationRequest }, i): [string, Uint8Array] => [
+        `user${i}`,
+        i === 3 ? new Uint8Array(2) : registrationRequest,
+      ])
+    );
+
+    const chunks: opaque.server.RegistrationImportChunk[] = [];
+    const result = await opaque.server.importRegistrations({
+      serverSetup,
+      records,
+      chunkSize: 3,
+      onChunk: (chunk) => {
+        chunks.push(chunk);
+      },
+    });
+    expect(result.total).toBe(7);
+    expect(result.failed).toBe(1);
+    expect(chunks.map((chunk) => chunk.count).join()).toBe('3,3,1');
+    expect(chunks.map((chunk) => chunk.processed).join()).toBe('3,6,7');
+
+    const entries = chunks.flatMap((chunk) => decodeResponses(chunk.responses));
+    expect(entries.map((entry) => entry.status).join()).toBe('0,0,0,1,0,0,0');
+    // the responses are the same as the ones of createRegistrationResponse
+    const { registrationRecord } = opaque.binary.client.finishRegistration({
+      clientRegistrationState: starts[4]!.clientRegistrationState,
+      registrationResponse: entries[4]!.payload,
+      password,
+    });
+    expect(registrationRecord.length > 0).toBe(true);
+  });
+
+  test('empty import', async () => {
+    const result = await opaque.server.importRegistrations({
+      serverSetup: opaque.server.createSetup(),
+      records: new Uint8Array(0),
+      onChunk: () => {
+        throw new Error('unexpected chunk');
+      },
+    });
+    expect(result.total).toBe(0);
+  });
+
+  test('invalid params', async () => {
+    const serverSetup = opaque.server.createSetup();
+    await expectReject(
+      opaque.server.importRegistrations({
+        serverSetup,
+        records: new Uint8Array([1, 0, 0, 0, 97, 2, 0, 0, 0]),
+        onChunk: () => {},
+      }),
+      'invalid registration import record at byte 0'
+    );
+    await expectReject(
+      opaque.server.importRegistrations({
+        serverSetup,
+        records: new Uint8Array(0),
+        chunkSize: 0,
+        onChunk: () => {},
+      }),
+      'property "chunkSize" must be positive'
+    );
+  });
+});
+
+describe('metrics', () => {
+  function register() {
+    const password = 'hunter42';
+    const { clientRegistrationState, registrationResponse } =
+      setupRegistration('user@example.com', password);
+    opaque.client.finishRegistration({
+      clientRegistrationState,
+      registrationResponse,
+      password,
+    });
+  }
+
+  test('records the phases while enabled', () => {
+    opaque.metrics.resetMetrics();
+    opaque.metrics.setEnabled(true);
+    try {
+      register();
+    } finally {
+      opaque.metrics.setEnabled(false);
+    }
+    const metrics = opaque.metrics.getMetrics();
+    const finish = metrics.finishClientRegistration;
+    expect(finish?.total?.count).toBe(1);
+    expect(finish?.ksf?.count).toBe(1);
+    expect(finish?.group?.count).toBe(1);
+    expect(finish?.deserialize?.count).toBe(2);
+    expect((finish?.ksf?.totalUs ?? 0) > 0).toBe(true);
+    expect((finish?.total?.maxUs ?? 0) >= (finish?.ksf?.maxUs ?? 0)).toBe(
+      true
+    );
+    expect(metrics.createServerRegistrationResponse?.total?.count).toBe(1);
+    expect(metrics.startClientRegistration?.marshalling?.count).toBe(1);
+
+    opaque.metrics.resetMetrics();
+    expect(opaque.metrics.getMetrics().finishClientRegistration).toBeUndefined();
+  });
+
+  test('records nothing while disabled', () => {
+    opaque.metrics.resetMetrics();
+    register();
+    expect(Object.keys(opaque.metrics.getMetrics()).length).toBe(0);
+    expect(() =>
+      // @ts-expect-error intentional test of invalid input
+      opaque.metrics.setEnabled('yes')
+    ).toThrow('enabled must be a boolean');
+  });
+});
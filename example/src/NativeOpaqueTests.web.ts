@@ -0,0 +1,2 @@
+// The native only APIs are not available in the web (WASM) build.
+export {};
@@ -1,6 +1,7 @@
 import React, { useEffect, useState } from 'react';
 import { Text, View } from 'react-native';
 import './OpaqueTests';
+import './NativeOpaqueTests';
 import { TestResult, runTests } from './Test';
 
 export const Tests: React.FC = () => {
@@ -2,6 +2,7 @@
 #import <React/RCTBridge+Private.h>
 #import <React/RCTUtils.h>
 #import <React/RCTLog.h>
+#import <ReactCommon/RCTTurboModule.h>
 #import "react-native-opaque.h"
 
 @implementation Opaque
@@ -10,6 +11,29 @@
 
 RCT_EXPORT_MODULE()
 
+- (instancetype)init
+{
+  if (self = [super init]) {
+    // Frees the memory kept for the key stretching when the system runs low
+    // on memory.
+    [[NSNotificationCenter defaultCenter] addObserver:self
+                                             selector:@selector(didReceiveMemoryWarning)
+                                                 name:UIApplicationDidReceiveMemoryWarningNotification
+                                               object:nil];
+  }
+  return self;
+}
+
+- (void)dealloc
+{
+  [[NSNotificationCenter defaultCenter] removeObserver:self];
+}
+
+- (void)didReceiveMemoryWarning
+{
+  NativeOpaque::trimMemory();
+}
+
 RCT_EXPORT_BLOCKING_SYNCHRONOUS_METHOD(install) {
 
   RCTLogInfo(@"installing opaque");
@@ -20,7 +44,7 @@ RCT_EXPORT_BLOCKING_SYNCHRONOUS_METHOD(install) {
   }
 
   RCTLogInfo(@"calling installOpaque with cxx bridge runtime");
-  NativeOpaque::installOpaque(*(facebook::jsi::Runtime *)cxxBridge.runtime);
+  NativeOpaque::installOpaque(*(facebook::jsi::Runtime *)cxxBridge.runtime, cxxBridge.jsCallInvoker);
   return nil;
 }
 
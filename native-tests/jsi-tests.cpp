@@ -0,0 +1,893 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <latch>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "./test-runtime.h"
+#include "opaque-worker-pool.h"
+
+// Tests of the JSI module on a host build of Hermes: the flows through the
+// string and binary API, and the validation of the params. Values of the
+// wrong kind, missing props and arbitrary strings and bytes must only ever
+// surface as JS errors. Several runtimes on their own threads must be able to
+// use the module at the same time.
+namespace NativeOpaque {
+  namespace {
+    using ::testing::HasSubstr;
+    using ::testing::StartsWith;
+
+    class JsiTest : public ::testing::Test {
+     protected:
+      std::string str(const jsi::Value& value) { return value.asString(rt).utf8(rt); }
+
+      jsi::Value prop(const jsi::Value& obj, const char* name) { return obj.asObject(rt).getProperty(rt, name); }
+
+      // Runs `code`, a JS expression, and returns the message of the error
+      // it throws.
+      std::string errorOf(const std::string& code) {
+        try {
+          runtime.eval(code);
+        } catch (const jsi::JSError& e) {
+          return e.getMessage();
+        }
+        ADD_FAILURE() << code << " did not throw";
+        return "";
+      }
+
+      TestRuntime runtime;
+      jsi::Runtime& rt = runtime.rt();
+    };
+
+    TEST_F(JsiTest, LoginWithServerSetupString) {
+      auto login = runtime.eval("testLogin(opaque_createServerSetup({}))");
+      EXPECT_EQ(str(prop(login, "clientSessionKey")), str(prop(login, "serverSessionKey")));
+      EXPECT_EQ(str(prop(login, "exportKey")), str(prop(login, "registrationExportKey")));
+    }
+
+    TEST_F(JsiTest, LoginWithServerSetupHandle) {
+      auto login = runtime.eval("testLogin(opaque_createServerSetupHandle(opaque_createServerSetup({}), undefined))");
+      EXPECT_EQ(str(prop(login, "clientSessionKey")), str(prop(login, "serverSessionKey")));
+    }
+
+    TEST_F(JsiTest, LoginWithP256) {
+      auto login = runtime.eval("testLogin(opaque_createServerSetup({ suite: 'p256' }), 'p256')");
+      EXPECT_EQ(str(prop(login, "clientSessionKey")), str(prop(login, "serverSessionKey")));
+    }
+
+    TEST_F(JsiTest, LoginThroughBinaryApi) {
+      EXPECT_TRUE(runtime.eval(R"JS(
+        (function () {
+          var setup = opaque_createServerSetupBinary({});
+          var keys = [
+            testLoginBinary(setup),
+            testLoginBinary(setup.buffer),
+            testLoginBinary(opaque_createServerSetupHandle(setup, undefined)),
+          ];
+          return keys.every(function (login) {
+            return login.clientSessionKey.length === 64
+              && login.clientSessionKey.every(function (byte, i) { return byte === login.serverSessionKey[i]; });
+          });
+        })()
+      )JS").getBool());
+    }
+
+    TEST_F(JsiTest, LoginThroughSessionStore) {
+      EXPECT_TRUE(runtime.eval(R"JS(
+        (function () {
+          var serverSetup = opaque_createServerSetupHandle(opaque_createServerSetup({}), undefined);
+          var sessionStore = opaque_createServerLoginSessionStore({});
+          var login = testLogin(serverSetup);
+          var clientLogin = opaque_startClientLogin({ password: 'hunter42' });
+          var started = opaque_startServerLoginSession({
+            sessionStore: sessionStore,
+            serverSetup: serverSetup,
+            registrationRecord: login.registrationRecord,
+            startLoginRequest: clientLogin.startLoginRequest,
+            userIdentifier: 'user@example.com',
+          });
+          var clientFinish = opaque_finishClientLogin({
+            clientLoginState: clientLogin.clientLoginState,
+            loginResponse: started.loginResponse,
+            password: 'hunter42',
+            keyStretching: testKeyStretching,
+          });
+          var pending = opaque_getServerLoginSessionCount(sessionStore);
+          var serverFinish = opaque_finishServerLoginSession({
+            sessionStore: sessionStore,
+            sessionHandle: started.sessionHandle,
+            finishLoginRequest: clientFinish.finishLoginRequest,
+          });
+          return pending === 1 && opaque_getServerLoginSessionCount(sessionStore) === 0
+            && clientFinish.sessionKey === serverFinish.sessionKey;
+        })()
+      )JS").getBool());
+    }
+
+    TEST_F(JsiTest, LoginWithServerSetupKeyring) {
+      EXPECT_TRUE(runtime.eval(R"JS(
+        (function () {
+          var keyring = opaque_createServerSetupKeyring();
+          opaque_addServerSetupKey({ keyring: keyring, keyId: 'old', serverSetup: opaque_createServerSetup({}) });
+          var login = testLogin(keyring);
+          opaque_addServerSetupKey({ keyring: keyring, keyId: 'new', serverSetup: opaque_createServerSetupBinary({}) });
+          opaque_setActiveServerSetupKey({ keyring: keyring, keyId: 'new' });
+          var keys = opaque_getServerSetupKeys(keyring);
+
+          function finish(keyId) {
+            var clientLogin = opaque_startClientLogin({ password: 'hunter42' });
+            var serverLogin = opaque_startServerLogin({
+              serverSetup: keyring,
+              keyId: keyId,
+              registrationRecord: login.registrationRecord,
+              startLoginRequest: clientLogin.startLoginRequest,
+              userIdentifier: 'user@example.com',
+            });
+            return opaque_finishClientLogin({
+              clientLoginState: clientLogin.clientLoginState,
+              loginResponse: serverLogin.loginResponse,
+              password: 'hunter42',
+              keyStretching: testKeyStretching,
+            });
+          }
+          return login.clientSessionKey === login.serverSessionKey
+            && keys.activeKeyId === 'new' && keys.keyIds.length === 2
+            && finish('old') !== undefined && finish(undefined) === undefined
+            && opaque_getServerPublicKey(keyring, { keyId: 'old' }) !== opaque_getServerPublicKey(keyring, undefined)
+            && opaque_removeServerSetupKey({ keyring: keyring, keyId: 'old' })
+            && opaque_getServerSetupKeys(keyring).keyIds.length === 1;
+        })()
+      )JS").getBool());
+    }
+
+    TEST_F(JsiTest, RejectsInvalidKeyringCalls) {
+      runtime.eval("var keyring = opaque_createServerSetupKeyring()");
+      EXPECT_THAT(errorOf("opaque_startServerLogin({ serverSetup: keyring, startLoginRequest: 'AA',"
+        " userIdentifier: 'u' })"), HasSubstr("the server setup keyring has no keys"));
+      runtime.eval("opaque_addServerSetupKey({ keyring: keyring, keyId: 'a',"
+        " serverSetup: opaque_createServerSetup({}) })");
+      EXPECT_THAT(errorOf("opaque_addServerSetupKey({ keyring: keyring, keyId: 'a',"
+        " serverSetup: opaque_createServerSetup({}) })"), HasSubstr("server setup key \"a\" already exists"));
+      EXPECT_THAT(errorOf("opaque_addServerSetupKey({ keyring: keyring, keyId: 'b', serverSetup: 'AA' })"),
+        HasSubstr("serverSetup"));
+      EXPECT_THAT(errorOf("opaque_addServerSetupKey({ keyring: {}, keyId: 'b', serverSetup: 'AA' })"),
+        HasSubstr("keyring must be a server setup keyring"));
+      EXPECT_THAT(errorOf("opaque_startServerLogin({ serverSetup: keyring, keyId: 'b', startLoginRequest: 'AA',"
+        " userIdentifier: 'u' })"), HasSubstr("unknown server setup key \"b\""));
+      EXPECT_THAT(errorOf("opaque_startServerLogin({ serverSetup: keyring, keyId: 1, startLoginRequest: 'AA',"
+        " userIdentifier: 'u' })"), HasSubstr("property \"keyId\" has invalid type"));
+      EXPECT_THAT(errorOf("opaque_setActiveServerSetupKey({ keyring: keyring, keyId: 'b' })"),
+        HasSubstr("unknown server setup key \"b\""));
+      EXPECT_THAT(errorOf("opaque_removeServerSetupKey({ keyring: keyring, keyId: 'a' })"),
+        HasSubstr("the active server setup key can't be removed"));
+      EXPECT_THAT(errorOf("opaque_startServerLogin({ serverSetup: keyring, startLoginRequest: 'AA',"
+        " userIdentifier: 'u', suite: 'p256' })"),
+        HasSubstr("the cipher suite doesn't match the one of the serverSetup"));
+    }
+
+    TEST_F(JsiTest, LoginThroughClientLoginContext) {
+      EXPECT_TRUE(runtime.eval(R"JS(
+        (function () {
+          var serverSetup = opaque_createServerSetupHandle(opaque_createServerSetup({}), undefined);
+          var login = testLogin(serverSetup);
+          var started = opaque_startClientLoginContext({ password: 'hunter42', keyStretching: testKeyStretching });
+          var serverLogin = opaque_startServerLogin({
+            serverSetup: serverSetup,
+            registrationRecord: login.registrationRecord,
+            startLoginRequest: started.startLoginRequest,
+            userIdentifier: 'user@example.com',
+          });
+          var params = { context: started.context, loginResponse: serverLogin.loginResponse };
+          var clientFinish = opaque_finishClientLoginContext(params);
+          var serverFinish = opaque_finishServerLogin({
+            serverLoginState: serverLogin.serverLoginState,
+            finishLoginRequest: clientFinish.finishLoginRequest,
+          });
+          try {
+            opaque_finishClientLoginContext(params);
+            return false;
+          } catch (e) {
+            return clientFinish.sessionKey === serverFinish.sessionKey
+              && e.message.indexOf('already finished') !== -1;
+          }
+        })()
+      )JS").getBool());
+    }
+
+    TEST_F(JsiTest, WrongPasswordFinishesWithUndefined) {
+      EXPECT_TRUE(runtime.eval(R"JS(
+        (function () {
+          var serverSetup = opaque_createServerSetup({});
+          var login = testLogin(serverSetup);
+          var clientLogin = opaque_startClientLogin({ password: 'wrong' });
+          var serverLogin = opaque_startServerLogin({
+            serverSetup: serverSetup,
+            registrationRecord: login.registrationRecord,
+            startLoginRequest: clientLogin.startLoginRequest,
+            userIdentifier: 'user@example.com',
+          });
+          return opaque_finishClientLogin({
+            clientLoginState: clientLogin.clientLoginState,
+            loginResponse: serverLogin.loginResponse,
+            password: 'wrong',
+            keyStretching: testKeyStretching,
+          }) === undefined;
+        })()
+      )JS").getBool());
+    }
+
+    // A function with valid params of the right kinds, and its required
+    // string and binary props.
+    struct RequiredProps {
+      const char* function;
+      const char* params;
+      std::vector<const char*> strings;
+      std::vector<const char*> binaries;
+    };
+
+    const std::vector<RequiredProps> kRequiredProps = {
+      {"opaque_startClientRegistration", "{ password: 'p' }", {"password"}, {}},
+      {"opaque_finishClientRegistration",
+        "{ password: 'p', registrationResponse: 'AA', clientRegistrationState: 'AA' }",
+        {"password", "registrationResponse", "clientRegistrationState"}, {}},
+      {"opaque_startClientLogin", "{ password: 'p' }", {"password"}, {}},
+      {"opaque_finishClientLogin", "{ clientLoginState: 'AA', loginResponse: 'AA', password: 'p' }",
+        {"clientLoginState", "loginResponse", "password"}, {}},
+      {"opaque_startClientLoginContext", "{ password: 'p' }", {"password"}, {}},
+      {"opaque_createServerRegistrationResponse",
+        "{ serverSetup: 'AA', userIdentifier: 'u', registrationRequest: 'AA' }",
+        {"serverSetup", "userIdentifier", "registrationRequest"}, {}},
+      {"opaque_startServerLogin", "{ serverSetup: 'AA', startLoginRequest: 'AA', userIdentifier: 'u' }",
+        {"serverSetup", "startLoginRequest", "userIdentifier"}, {}},
+      {"opaque_finishServerLogin", "{ serverLoginState: 'AA', finishLoginRequest: 'AA' }",
+        {"serverLoginState", "finishLoginRequest"}, {}},
+      {"opaque_finishClientRegistrationBinary",
+        "{ password: 'p', registrationResponse: new Uint8Array(1), clientRegistrationState: new Uint8Array(1) }",
+        {"password"}, {"registrationResponse", "clientRegistrationState"}},
+      {"opaque_finishClientLoginBinary",
+        "{ clientLoginState: new Uint8Array(1), loginResponse: new Uint8Array(1), password: 'p' }",
+        {"password"}, {"clientLoginState", "loginResponse"}},
+      {"opaque_createServerRegistrationResponseBinary",
+        "{ serverSetup: new Uint8Array(1), userIdentifier: 'u', registrationRequest: new Uint8Array(1) }",
+        {"userIdentifier"}, {"registrationRequest"}},
+      {"opaque_startServerLoginBinary",
+        "{ serverSetup: new Uint8Array(1), startLoginRequest: new Uint8Array(1), userIdentifier: 'u' }",
+        {"userIdentifier"}, {"startLoginRequest"}},
+      {"opaque_finishServerLoginBinary",
+        "{ serverLoginState: new Uint8Array(1), finishLoginRequest: new Uint8Array(1) }",
+        {}, {"serverLoginState", "finishLoginRequest"}},
+    };
+
+    // The JS values of every kind, and how the errors name them.
+    const std::vector<std::pair<const char*, const char*>> kKinds = {
+      {"undefined", "undefined"},
+      {"null", "null"},
+      {"true", "true"},
+      {"42", "a number"},
+      {"Symbol('s')", "a symbol"},
+      {"10n", "a bigint"},
+      {"({})", "an object"},
+      {"[]", "an object"},
+      {"(function () {})", "a function"},
+    };
+
+    bool isObjectKind(const std::string& kind) {
+      return kind == "an object" || kind == "a function";
+    }
+
+    std::string withProp(const RequiredProps& props, const char* name, const char* value) {
+      return std::string("(function () { var params = ") + props.params + "; params." + name + " = " + value
+        + "; return " + props.function + "(params); })()";
+    }
+
+    std::string withoutProp(const RequiredProps& props, const char* name) {
+      return std::string("(function () { var params = ") + props.params + "; delete params." + name
+        + "; return " + props.function + "(params); })()";
+    }
+
+    TEST_F(JsiTest, RejectsMissingProps) {
+      for (const auto& props : kRequiredProps) {
+        for (auto names : {&props.strings, &props.binaries}) {
+          for (auto name : *names) {
+            EXPECT_THAT(errorOf(withoutProp(props, name)),
+              HasSubstr(std::string("missing required property \"") + name + "\""))
+              << props.function;
+          }
+        }
+      }
+    }
+
+    TEST_F(JsiTest, RejectsStringPropsOfOtherKinds) {
+      for (const auto& props : kRequiredProps) {
+        for (auto name : props.strings) {
+          for (const auto& [value, kind] : kKinds) {
+            auto message = errorOf(withProp(props, name, value));
+            if (std::string(name) == "serverSetup" && isObjectKind(kind)) {
+              EXPECT_THAT(message, HasSubstr("serverSetup must be a string or a server setup handle"));
+            } else {
+              EXPECT_THAT(message, HasSubstr(std::string("property \"") + name
+                + "\" has invalid type, expected string but got " + kind))
+                << props.function << " " << value;
+            }
+          }
+        }
+      }
+    }
+
+    TEST_F(JsiTest, RejectsBinaryPropsOfOtherKinds) {
+      for (const auto& props : kRequiredProps) {
+        for (auto name : props.binaries) {
+          for (const auto& [value, kind] : kKinds) {
+            EXPECT_THAT(errorOf(withProp(props, name, value)), HasSubstr(std::string("property \"") + name
+              + "\" has invalid type, expected Uint8Array or ArrayBuffer but got " + kind))
+              << props.function << " " << value;
+          }
+          EXPECT_THAT(errorOf(withProp(props, name, "'AA'")), HasSubstr("but got a string")) << props.function;
+        }
+      }
+    }
+
+    TEST_F(JsiTest, RejectsForgedTypedArrays) {
+      for (auto forged : {
+        "{ buffer: new ArrayBuffer(8), byteOffset: NaN, byteLength: 4 }",
+        "{ buffer: new ArrayBuffer(8), byteOffset: 0, byteLength: NaN }",
+        "{ buffer: new ArrayBuffer(8), byteOffset: -1, byteLength: 4 }",
+        "{ buffer: new ArrayBuffer(8), byteOffset: 4, byteLength: 5 }",
+        "{ buffer: new ArrayBuffer(8), byteOffset: 0, byteLength: Infinity }",
+        "{ buffer: new ArrayBuffer(8), byteOffset: '0', byteLength: 4 }",
+        "{ buffer: {}, byteOffset: 0, byteLength: 0 }",
+      }) {
+        EXPECT_THAT(errorOf(std::string("opaque_finishServerLoginBinary({ serverLoginState: ") + forged
+          + ", finishLoginRequest: new Uint8Array(1) })"),
+          HasSubstr("\"serverLoginState\" has invalid type")) << forged;
+      }
+    }
+
+    TEST_F(JsiTest, RejectsInvalidOptionalParams) {
+      EXPECT_THAT(errorOf("opaque_startClientLogin({ password: 'p', suite: 'p384' })"),
+        HasSubstr("\"suite\" must be \"ristretto255\" or \"p256\""));
+      EXPECT_THAT(errorOf("opaque_finishClientLogin({ clientLoginState: 'AA', loginResponse: 'AA', password: 'p',"
+        " identifiers: 5 })"), HasSubstr("\"identifiers\" must be an object"));
+      EXPECT_THAT(errorOf("opaque_finishClientLogin({ clientLoginState: 'AA', loginResponse: 'AA', password: 'p',"
+        " identifiers: { client: 5 } })"), HasSubstr("identifier \"client\" must be a string"));
+      EXPECT_THAT(errorOf("opaque_finishClientLogin({ clientLoginState: 'AA', loginResponse: 'AA', password: 'p',"
+        " keyStretching: 5 })"), HasSubstr("\"keyStretching\" must be an object"));
+      for (auto value : {"-1", "0.5", "NaN", "Infinity", "4294967296"}) {
+        EXPECT_THAT(errorOf(std::string("opaque_finishClientLogin({ clientLoginState: 'AA', loginResponse: 'AA',"
+          " password: 'p', keyStretching: { memoryCost: ") + value + ", iterations: 1, parallelism: 1 } })"),
+          HasSubstr("\"memoryCost\" must be an unsigned 32-bit integer")) << value;
+      }
+      // checked right away instead of on the worker thread of the preparation
+      EXPECT_THAT(errorOf("opaque_startClientLoginPipelined({ password: 'p',"
+        " keyStretching: { memoryCost: 0, iterations: 1, parallelism: 1 } })"),
+        HasSubstr("invalid key stretching params"));
+      EXPECT_THAT(errorOf("opaque_createServerLoginSessionStore({ maxMemoryBytes: NaN })"),
+        HasSubstr("\"maxMemoryBytes\" is out of range"));
+    }
+
+    TEST_F(JsiTest, RejectsParamsThatAreNoObject) {
+      for (auto function : {"opaque_startClientLogin", "opaque_finishServerLogin", "opaque_startServerLoginBinary"}) {
+        for (const auto& [value, kind] : kKinds) {
+          if (!isObjectKind(kind)) {
+            EXPECT_THAT(errorOf(std::string(function) + "(" + value + ")"), HasSubstr("expected an Object"));
+          }
+        }
+      }
+    }
+
+    TEST_F(JsiTest, RejectsInvalidHandles) {
+      EXPECT_THAT(errorOf("opaque_finishClientLoginContext({ context: opaque_createServerLoginSessionStore({}),"
+        " loginResponse: 'AA' })"), HasSubstr("context must be a client login context"));
+      EXPECT_THAT(errorOf("opaque_getServerLoginSessionCount({})"),
+        HasSubstr("sessionStore must be a login session store"));
+      EXPECT_THAT(errorOf("opaque_startServerLogin({ serverSetup: opaque_createServerLoginSessionStore({}),"
+        " startLoginRequest: 'AA', userIdentifier: 'u' })"),
+        HasSubstr("serverSetup must be a string or a server setup handle"));
+      EXPECT_THAT(errorOf("opaque_startServerLoginBatch(opaque_createServerSetup({}), {}, undefined)"),
+        HasSubstr("requests must be an array"));
+      EXPECT_THAT(errorOf("opaque_startServerLogin({ serverSetup: opaque_createServerSetupHandle("
+        "opaque_createServerSetup({}), undefined), startLoginRequest: 'AA', userIdentifier: 'u', suite: 'p256' })"),
+        HasSubstr("the cipher suite doesn't match the one of the serverSetup"));
+    }
+
+    TEST_F(JsiTest, RejectsWrongNumberOfArguments) {
+      EXPECT_THAT(errorOf("opaque_startClientLogin()"), HasSubstr("invalid number of arguments"));
+      EXPECT_THAT(errorOf("opaque_startClientLogin({ password: 'p' }, 1)"), HasSubstr("invalid number of arguments"));
+      EXPECT_THAT(errorOf("opaque_createServerSetupHandle(opaque_createServerSetup({}))"),
+        HasSubstr("invalid number of arguments"));
+      EXPECT_THAT(errorOf("opaque_getMetrics(1)"), HasSubstr("invalid number of arguments"));
+    }
+
+    TEST_F(JsiTest, AsyncFunctionsNeedCallInvoker) {
+      EXPECT_THAT(errorOf("opaque_finishClientLoginAsync({ clientLoginState: 'AA', loginResponse: 'AA',"
+        " password: 'p' }, 1)"), HasSubstr("async functions are not available in this runtime"));
+      EXPECT_THAT(errorOf("opaque_finishClientRegistrationAsync({ password: 'p', registrationResponse: 'AA',"
+        " clientRegistrationState: 'AA' }, 1)"), HasSubstr("async functions are not available in this runtime"));
+      EXPECT_THAT(errorOf("opaque_finishClientLoginContextAsync({ context: opaque_startClientLoginContext("
+        "{ password: 'p' }).context, loginResponse: 'AA' }, 1)"),
+        HasSubstr("async functions are not available in this runtime"));
+    }
+
+    TEST_F(JsiTest, ResultModeReturnsErrors) {
+      // "ok" or the error code of the result
+      auto codeOf = [&](const std::string& code) -> std::string {
+        auto result = runtime.eval(code);
+        return prop(result, "ok").getBool() ? "ok" : str(prop(result, "error"));
+      };
+      runtime.eval("globalThis.serverSetup = opaque_createServerSetup({})");
+      runtime.eval("globalThis.first = testLogin(serverSetup)");
+      runtime.eval("globalThis.second = testLogin(serverSetup)");
+
+      auto finished = runtime.eval("opaque_finishServerLoginResult({ serverLoginState: first.serverLoginState,"
+        " finishLoginRequest: first.finishLoginRequest })");
+      EXPECT_TRUE(prop(finished, "ok").getBool());
+      EXPECT_EQ(str(prop(prop(finished, "value"), "sessionKey")), str(runtime.eval("first.serverSessionKey")));
+
+      // the finish request of another login
+      auto forged = runtime.eval("opaque_finishServerLoginResult({ serverLoginState: first.serverLoginState,"
+        " finishLoginRequest: second.finishLoginRequest })");
+      EXPECT_EQ(str(prop(forged, "error")), "invalidLogin");
+      EXPECT_THAT(str(prop(forged, "message")), HasSubstr("opaque protocol error at \"finish server login\""));
+      EXPECT_THAT(errorOf("opaque_finishServerLogin({ serverLoginState: first.serverLoginState,"
+        " finishLoginRequest: second.finishLoginRequest })"), HasSubstr("opaque protocol error at"));
+
+      EXPECT_EQ(codeOf("opaque_finishServerLoginResult({ serverLoginState: first.serverLoginState,"
+        " finishLoginRequest: 'a' })"), "base64");
+      EXPECT_EQ(codeOf("opaque_finishServerLoginResult({ serverLoginState: first.serverLoginState,"
+        " finishLoginRequest: '' })"), "protocol");
+      EXPECT_EQ(codeOf("opaque_finishServerLoginResult({ serverLoginState: first.serverLoginState })"), "input");
+      EXPECT_EQ(codeOf("opaque_finishServerLoginResult(1)"), "input");
+      EXPECT_EQ(codeOf("opaque_finishServerLoginResult()"), "input");
+      EXPECT_EQ(codeOf("opaque_startServerLoginResult({ serverSetup: serverSetup, startLoginRequest: 'AA',"
+        " userIdentifier: 'u' })"), "protocol");
+      EXPECT_EQ(codeOf("opaque_finishClientLoginContextResult({ context: {}, loginResponse: 'AA' })"), "input");
+      EXPECT_EQ(codeOf("opaque_finishServerLoginBinaryResult({ serverLoginState: new Uint8Array(1),"
+        " finishLoginRequest: new Uint8Array(1) })"), "protocol");
+      EXPECT_EQ(codeOf("opaque_startServerLoginBinaryResult({ serverSetup: opaque_createServerSetupBinary({}),"
+        " startLoginRequest: new Uint8Array(2), userIdentifier: 'u' })"), "protocol");
+      EXPECT_EQ(codeOf("opaque_finishClientLoginBinaryResult({ clientLoginState: new Uint8Array(1),"
+        " loginResponse: new Uint8Array(1), password: 'p' })"), "protocol");
+
+      // the entries of a batch carry the code of their error as well
+      auto batch = runtime.eval("opaque_startServerLoginBatch(serverSetup, [{ startLoginRequest: 'a',"
+        " userIdentifier: 'u' }, { userIdentifier: 'u' }], undefined)").asObject(rt).asArray(rt);
+      EXPECT_EQ(str(prop(batch.getValueAtIndex(rt, 0), "error")), "base64");
+      EXPECT_THAT(str(prop(batch.getValueAtIndex(rt, 0), "message")), HasSubstr("base64 decoding failed at"));
+      EXPECT_EQ(str(prop(batch.getValueAtIndex(rt, 1), "error")), "input");
+      EXPECT_THAT(str(prop(batch.getValueAtIndex(rt, 1), "message")),
+        HasSubstr("missing required property \"startLoginRequest\""));
+
+      // the twins of the other functions catch the exception
+      EXPECT_EQ(codeOf("opaque_getServerPublicKeyResult(serverSetup, undefined)"), "ok");
+      EXPECT_EQ(codeOf("opaque_createServerSetupHandleResult('a', undefined)"), "base64");
+      // the code crosses the bridge in front of the message, but isn't part of it
+      EXPECT_THAT(str(prop(runtime.eval("opaque_createServerSetupHandleResult('a', undefined)"), "message")),
+        StartsWith("base64 decoding failed at"));
+      EXPECT_THAT(errorOf("opaque_createServerSetupHandle('a', undefined)"), StartsWith("base64 decoding failed at"));
+      EXPECT_EQ(codeOf("opaque_getServerPublicKeyBinaryResult(new Uint8Array(3), undefined)"), "protocol");
+      EXPECT_EQ(codeOf("opaque_createServerSetupHandleResult(serverSetup)"), "input");
+      EXPECT_EQ(codeOf("opaque_startClientRegistrationResult({})"), "input");
+      EXPECT_TRUE(runtime.eval("typeof opaque_finishClientLoginAsyncResult === 'undefined'").getBool());
+    }
+
+    // Random strings in and around the base64 alphabet, and random bytes, in
+    // place of each message. The functions must return or throw a JS error,
+    // the sanitizer builds catch anything else.
+    TEST_F(JsiTest, ArbitraryMessages) {
+      std::mt19937 rng(42);
+      const std::string alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_+/= ";
+      auto randomString = [&]() {
+        std::string value(std::uniform_int_distribution<size_t>(0, 600)(rng), 'A');
+        for (auto& c : value) {
+          c = alphabet[std::uniform_int_distribution<size_t>(0, alphabet.size() - 1)(rng)];
+        }
+        return value;
+      };
+      auto randomBytes = [&]() {
+        auto length = std::uniform_int_distribution<size_t>(0, 600)(rng);
+        auto array = rt.global().getPropertyAsFunction(rt, "Uint8Array")
+          .callAsConstructor(rt, static_cast<double>(length)).asObject(rt);
+        auto buffer = array.getPropertyAsObject(rt, "buffer").getArrayBuffer(rt);
+        for (size_t i = 0; i < length; i++) {
+          buffer.data(rt)[i] = static_cast<uint8_t>(rng());
+        }
+        return array;
+      };
+
+      auto serverSetup = runtime.eval("opaque_createServerSetup({})");
+      for (const auto& props : kRequiredProps) {
+        auto function = runtime.function(props.function);
+        for (int i = 0; i < 50; i++) {
+          auto params = runtime.eval(props.params).asObject(rt);
+          for (auto name : props.strings) {
+            params.setProperty(rt, name, jsi::String::createFromUtf8(rt, randomString()));
+          }
+          for (auto name : props.binaries) {
+            params.setProperty(rt, name, randomBytes());
+          }
+          if (i % 2 == 0 && params.hasProperty(rt, "serverSetup")
+            && params.getProperty(rt, "serverSetup").isString()) {
+            params.setProperty(rt, "serverSetup", serverSetup);
+          }
+          try {
+            function.call(rt, params);
+          } catch (const jsi::JSError&) {
+          }
+        }
+      }
+    }
+
+    // Records every opaque_ function called through the global, and
+    // exerciseEveryFunction(runtime, round) which calls each one, and the
+    // result mode twins of the sync ones. Returns the promises of the async
+    // calls which must be fulfilled, the promise of the cancelled call which
+    // may settle either way, and the failed checks.
+    const char* const kExerciseEveryFunction = R"JS(
+      var called = {};
+      Object.getOwnPropertyNames(globalThis).forEach(function (name) {
+        if (name.indexOf('opaque_') === 0) {
+          var func = globalThis[name];
+          globalThis[name] = function () {
+            called[name] = true;
+            return func.apply(undefined, arguments);
+          };
+        }
+      });
+
+      function uncalledFunctions() {
+        return Object.getOwnPropertyNames(globalThis).filter(function (name) {
+          return name.indexOf('opaque_') === 0 && !called[name];
+        });
+      }
+
+      // Calls opaque_<name> and then its twin with the same arguments and
+      // returns the value of the first call. The twin of a call which can
+      // only succeed once fails, but must not throw.
+      function callBoth(name) {
+        var args = Array.prototype.slice.call(arguments, 1);
+        var value = globalThis['opaque_' + name].apply(undefined, args);
+        var result = globalThis['opaque_' + name + 'Result'].apply(undefined, args);
+        if (typeof result.ok !== 'boolean') {
+          throw new Error('opaque_' + name + 'Result returned no result');
+        }
+        return value;
+      }
+
+      // A record of createRegistrationImport.
+      function importRecord(userIdentifier, registrationRequest) {
+        var offset = 8 + userIdentifier.length;
+        var bytes = new Uint8Array(offset + registrationRequest.length);
+        var view = new DataView(bytes.buffer);
+        view.setUint32(0, userIdentifier.length, true);
+        for (var i = 0; i < userIdentifier.length; i++) {
+          bytes[4 + i] = userIdentifier.charCodeAt(i);
+        }
+        view.setUint32(offset - 4, registrationRequest.length, true);
+        bytes.set(registrationRequest, offset);
+        return bytes;
+      }
+
+      function exerciseEveryFunction(runtime, round) {
+        var failures = [];
+        function check(ok, what) {
+          if (!ok) {
+            failures.push(what);
+          }
+        }
+        var password = 'hunter42';
+        var user = 'user' + runtime + '.' + round + '@example.com';
+        var nextJobId = round * 100;
+
+        callBoth('setMetricsEnabled', true);
+        check(callBoth('getCpuTopology').cores >= 1, 'getCpuTopology');
+        if (round === 0) {
+          check(callBoth('calibrateKeyStretching', { targetDurationMs: 1 }).iterations >= 1,
+            'calibrateKeyStretching');
+        }
+        callBoth('prewarmKeyStretching', { keyStretching: testKeyStretching });
+
+        var serverSetupString = callBoth('createServerSetup', {});
+        var serverSetup = callBoth('createServerSetupHandle', serverSetupString, undefined);
+        check(callBoth('getServerPublicKey', serverSetup, undefined)
+          === opaque_getServerPublicKey(serverSetupString, undefined), 'getServerPublicKey');
+        var keyring = callBoth('createServerSetupKeyring');
+        callBoth('addServerSetupKey', { keyring: keyring, keyId: 'a', serverSetup: serverSetupString });
+        callBoth('addServerSetupKey', { keyring: keyring, keyId: 'b', serverSetup: opaque_createServerSetup({}) });
+        callBoth('setActiveServerSetupKey', { keyring: keyring, keyId: 'a' });
+        check(callBoth('removeServerSetupKey', { keyring: keyring, keyId: 'b' }), 'removeServerSetupKey');
+        check(callBoth('getServerSetupKeys', keyring).keyIds.length === 1, 'getServerSetupKeys');
+
+        var registration = callBoth('startClientRegistration', { password: password });
+        var response = callBoth('createServerRegistrationResponse', {
+          serverSetup: keyring,
+          userIdentifier: user,
+          registrationRequest: registration.registrationRequest,
+        });
+        var finishRegistrationParams = {
+          password: password,
+          registrationResponse: response.registrationResponse,
+          clientRegistrationState: registration.clientRegistrationState,
+          keyStretching: testKeyStretching,
+        };
+        var record = callBoth('finishClientRegistration', finishRegistrationParams);
+
+        callBoth('startClientLogin', { password: password });
+        var login = callBoth('startClientLoginPipelined', { password: password, keyStretching: testKeyStretching });
+        var serverLogin = callBoth('startServerLogin', {
+          serverSetup: serverSetup,
+          registrationRecord: record.registrationRecord,
+          startLoginRequest: login.startLoginRequest,
+          userIdentifier: user,
+        });
+        var finishLoginParams = {
+          clientLoginState: login.clientLoginState,
+          loginResponse: serverLogin.loginResponse,
+          password: password,
+          keyStretching: testKeyStretching,
+        };
+        var clientFinish = callBoth('finishClientLogin', finishLoginParams);
+        var serverFinish = callBoth('finishServerLogin', {
+          serverLoginState: serverLogin.serverLoginState,
+          finishLoginRequest: clientFinish.finishLoginRequest,
+        });
+        check(clientFinish.sessionKey === serverFinish.sessionKey, 'login');
+
+        var batch = callBoth('startServerLoginBatch', serverSetup, [
+          { registrationRecord: record.registrationRecord, startLoginRequest: login.startLoginRequest, userIdentifier: user },
+          { startLoginRequest: 'AA', userIdentifier: user },
+        ], undefined);
+        check(batch.length === 2 && batch[0].error === undefined && batch[1].error === 'base64',
+          'startServerLoginBatch');
+
+        var sessionStore = callBoth('createServerLoginSessionStore', {});
+        var started = callBoth('startClientLoginContext', { password: password, keyStretching: testKeyStretching });
+        var session = callBoth('startServerLoginSession', {
+          sessionStore: sessionStore,
+          serverSetup: serverSetup,
+          registrationRecord: record.registrationRecord,
+          startLoginRequest: started.startLoginRequest,
+          userIdentifier: user,
+        });
+        var contextFinish = callBoth('finishClientLoginContext',
+          { context: started.context, loginResponse: session.loginResponse });
+        check(callBoth('getServerLoginSessionCount', sessionStore) === 2, 'getServerLoginSessionCount');
+        var sessionFinish = callBoth('finishServerLoginSession', {
+          sessionStore: sessionStore,
+          sessionHandle: session.sessionHandle,
+          finishLoginRequest: contextFinish.finishLoginRequest,
+        });
+        check(contextFinish.sessionKey === sessionFinish.sessionKey, 'login session');
+
+        var binarySetup = callBoth('createServerSetupBinary', {});
+        check(callBoth('getServerPublicKeyBinary', binarySetup, undefined).length > 0, 'getServerPublicKeyBinary');
+        var binaryRegistration = callBoth('startClientRegistrationBinary', { password: password });
+        var binaryResponse = callBoth('createServerRegistrationResponseBinary', {
+          serverSetup: binarySetup,
+          userIdentifier: user,
+          registrationRequest: binaryRegistration.registrationRequest,
+        });
+        var binaryRecord = callBoth('finishClientRegistrationBinary', {
+          password: password,
+          registrationResponse: binaryResponse.registrationResponse,
+          clientRegistrationState: binaryRegistration.clientRegistrationState,
+          keyStretching: testKeyStretching,
+        });
+        var binaryLogin = callBoth('startClientLoginBinary', { password: password });
+        var binaryServerLogin = callBoth('startServerLoginBinary', {
+          serverSetup: binarySetup,
+          registrationRecord: binaryRecord.registrationRecord,
+          startLoginRequest: binaryLogin.startLoginRequest,
+          userIdentifier: user,
+        });
+        var binaryClientFinish = callBoth('finishClientLoginBinary', {
+          clientLoginState: binaryLogin.clientLoginState,
+          loginResponse: binaryServerLogin.loginResponse,
+          password: password,
+          keyStretching: testKeyStretching,
+        });
+        var binaryServerFinish = callBoth('finishServerLoginBinary', {
+          serverLoginState: binaryServerLogin.serverLoginState,
+          finishLoginRequest: binaryClientFinish.finishLoginRequest,
+        });
+        check(binaryClientFinish.sessionKey.every(function (byte, i) {
+          return byte === binaryServerFinish.sessionKey[i];
+        }), 'binary login');
+
+        var registrationImport = callBoth('createRegistrationImport', {
+          serverSetup: serverSetupString,
+          records: importRecord(user, binaryRegistration.registrationRequest),
+          chunkSize: 1,
+        });
+        var asyncStarted = opaque_startClientLoginContext({ password: password, keyStretching: testKeyStretching });
+        var asyncServerLogin = opaque_startServerLogin({
+          serverSetup: serverSetup,
+          registrationRecord: record.registrationRecord,
+          startLoginRequest: asyncStarted.startLoginRequest,
+          userIdentifier: user,
+        });
+        var promises = [
+          opaque_nextRegistrationImportChunk(registrationImport, nextJobId++),
+          opaque_finishClientRegistrationAsync(finishRegistrationParams, nextJobId++),
+          opaque_finishClientLoginAsync(finishLoginParams, nextJobId++),
+          opaque_finishClientLoginContextAsync(
+            { context: asyncStarted.context, loginResponse: asyncServerLogin.loginResponse }, nextJobId++),
+        ];
+        var cancelled = opaque_finishClientLoginAsync(finishLoginParams, nextJobId);
+        opaque_cancelAsync(nextJobId);
+
+        // the other runtimes reset the shared metrics at any time
+        check(typeof callBoth('getMetrics') === 'object', 'getMetrics');
+        callBoth('resetMetrics');
+        callBoth('releaseKeyStretchingMemory');
+        return { promises: promises, cancelled: cancelled, failures: failures };
+      }
+    )JS";
+
+    // Runtimes on their own threads, like the JS threads of separate React
+    // Native instances in one app, call every function at the same time.
+    // Each runtime has its own module state (handles, keyrings, pending
+    // jobs), they only share the worker pool and the state of the Rust
+    // library, the sanitizer builds catch races there.
+    TEST(MultipleRuntimesTest, CallEveryFunctionConcurrently) {
+      constexpr int kRuntimes = 4;
+      constexpr int kRounds = 3;
+      std::latch start(kRuntimes);
+      std::vector<std::vector<std::string>> failures(kRuntimes);
+      std::vector<std::thread> threads;
+      for (int i = 0; i < kRuntimes; i++) {
+        threads.emplace_back([&, i]() {
+          auto& failed = failures[i];
+          try {
+            TestRuntime runtime(std::make_shared<TestCallInvoker>());
+            auto& rt = runtime.rt();
+            runtime.eval(kExerciseEveryFunction);
+            auto exercise = runtime.function("exerciseEveryFunction");
+            start.arrive_and_wait();
+            for (int round = 0; round < kRounds; round++) {
+              auto calls = exercise.call(rt, i, round).asObject(rt);
+              auto checks = calls.getPropertyAsObject(rt, "failures").asArray(rt);
+              for (size_t j = 0; j < checks.size(rt); j++) {
+                failed.push_back(checks.getValueAtIndex(rt, j).asString(rt).utf8(rt));
+              }
+              auto promises = calls.getPropertyAsObject(rt, "promises").asArray(rt);
+              for (size_t j = 0; j < promises.size(rt); j++) {
+                auto promise = runtime.settle(promises.getValueAtIndex(rt, j));
+                if (promise.getProperty(rt, "state").asString(rt).utf8(rt) != "fulfilled") {
+                  failed.push_back("async call " + std::to_string(j) + " was rejected: "
+                    + promise.getPropertyAsObject(rt, "value").getProperty(rt, "message").toString(rt).utf8(rt));
+                }
+              }
+              runtime.settle(calls.getProperty(rt, "cancelled"));
+            }
+            auto uncalled = runtime.eval("uncalledFunctions()").asObject(rt).asArray(rt);
+            for (size_t j = 0; j < uncalled.size(rt); j++) {
+              failed.push_back("not called: " + uncalled.getValueAtIndex(rt, j).asString(rt).utf8(rt));
+            }
+          } catch (const std::exception& e) {
+            failed.push_back(e.what());
+          }
+        });
+      }
+      for (auto& thread : threads) {
+        thread.join();
+      }
+      for (int i = 0; i < kRuntimes; i++) {
+        EXPECT_THAT(failures[i], ::testing::IsEmpty()) << "runtime " << i;
+      }
+    }
+
+    // Keeps a thread of the worker pool busy until it's released.
+    class BlockingJob : public WorkerPool::Job {
+     public:
+      BlockingJob(std::latch& started, std::shared_future<void> released)
+        : started_(started), released_(std::move(released)) {}
+
+      void run() override {
+        started_.count_down();
+        released_.wait();
+      }
+
+      void discard() override {}
+      void abandon() override {}
+
+     private:
+      std::latch& started_;
+      std::shared_future<void> released_;
+    };
+
+    // The preparation of startClientLoginPipelined waits for a thread while
+    // all of them are busy. Another pipelined start doesn't queue a second
+    // one, and the finish drops it instead of queuing behind it.
+    TEST(PipelinedLoginTest, PendingPrepareDoesntDelayFinish) {
+      TestRuntime runtime(std::make_shared<TestCallInvoker>());
+      auto& rt = runtime.rt();
+      runtime.eval(R"JS(
+        (function () {
+          var serverSetup = opaque_createServerSetup({});
+          var record = testLogin(serverSetup).registrationRecord;
+          login = opaque_startClientLoginPipelined({ password: 'hunter42', keyStretching: testKeyStretching });
+          serverLogin = opaque_startServerLogin({
+            serverSetup: serverSetup,
+            registrationRecord: record,
+            startLoginRequest: login.startLoginRequest,
+            userIdentifier: 'user@example.com',
+          });
+        })()
+      )JS");
+
+      auto& pool = WorkerPool::shared();
+      std::latch started(static_cast<std::ptrdiff_t>(pool.threadCount()));
+      std::promise<void> release;
+      std::shared_future<void> released = release.get_future().share();
+      for (size_t i = 0; i < pool.threadCount(); i++) {
+        ASSERT_NE(pool.submit(std::make_shared<BlockingJob>(started, released)), 0u);
+      }
+      started.wait();
+
+      runtime.eval("opaque_startClientLoginPipelined({ password: 'hunter42', keyStretching: testKeyStretching })");
+      runtime.eval("opaque_startClientLoginPipelined({ password: 'hunter42', keyStretching: testKeyStretching })");
+      EXPECT_EQ(pool.queued(), 1u);
+      auto promise = runtime.eval(R"JS(
+        opaque_finishClientLoginAsync({
+          clientLoginState: login.clientLoginState,
+          loginResponse: serverLogin.loginResponse,
+          password: 'hunter42',
+          keyStretching: testKeyStretching,
+        }, 1)
+      )JS");
+      // only the finish is left waiting
+      EXPECT_EQ(pool.queued(), 1u);
+      release.set_value();
+
+      auto finished = runtime.settle(promise);
+      EXPECT_EQ(finished.getProperty(rt, "state").asString(rt).utf8(rt), "fulfilled");
+      EXPECT_TRUE(finished.getPropertyAsObject(rt, "value").getProperty(rt, "sessionKey").isString());
+    }
+
+    // Reports whether it was run or discarded.
+    class SignalingJob : public WorkerPool::Job {
+     public:
+      std::future<bool> ran() { return ran_.get_future(); }
+
+      void run() override { ran_.set_value(true); }
+      void discard() override { ran_.set_value(false); }
+      void abandon() override {}
+
+     private:
+      std::promise<bool> ran_;
+    };
+
+    // Cancelling a running job can't interrupt it, the job only gets marked.
+    // The queued jobs still run once its thread is free again.
+    TEST(WorkerPoolTest, CancelledRunningJobKeepsItsThread) {
+      WorkerPool pool(1, 4);
+      std::latch started(1);
+      std::promise<void> release;
+      auto blocking = std::make_shared<BlockingJob>(started, release.get_future().share());
+      auto blockingId = pool.submit(blocking);
+      ASSERT_NE(blockingId, 0u);
+      started.wait();
+      auto queued = std::make_shared<SignalingJob>();
+      auto ran = queued->ran();
+      ASSERT_NE(pool.submit(queued), 0u);
+
+      EXPECT_TRUE(pool.cancel(blockingId));
+      EXPECT_TRUE(blocking->isCancelled());
+      EXPECT_EQ(pool.queued(), 1u);
+      release.set_value();
+
+      ASSERT_EQ(ran.wait_for(std::chrono::seconds(30)), std::future_status::ready);
+      EXPECT_TRUE(ran.get());
+      EXPECT_FALSE(pool.cancel(blockingId));
+    }
+  }  // namespace
+}  // namespace NativeOpaque
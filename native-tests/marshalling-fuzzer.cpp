@@ -0,0 +1,257 @@
+#include <fuzzer/FuzzedDataProvider.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "./test-runtime.h"
+#include "opaque-marshalling.h"
+
+// libFuzzer harness of the JSI marshalling layer: calls a module function
+// with arguments built from the input, JS values of every kind down to
+// objects made of the prop names the module reads, forged typed arrays,
+// handles and the messages of a real login. Build with OPAQUE_FUZZ, see the
+// "Native tests" section in CONTRIBUTING.md.
+//
+// Every invalid input has to surface as a JS error, which also covers the
+// Rust errors and std exceptions a host function turns into one. The result
+// mode functions (`*Result`) must not even throw. Anything else, like a
+// crash or a sanitizer report, is a finding.
+namespace NativeOpaque {
+  namespace {
+    struct Function {
+      const char* name;
+      size_t paramCount;
+      // a result mode function, which returns its errors
+      bool returnsErrors = false;
+    };
+
+    // Every function of the module except calibrateKeyStretching, which
+    // runs the key stretching until a target duration, and the result mode
+    // twins of the login functions and of one throwing function.
+    const Function kFunctions[] = {
+      {"opaque_startClientRegistration", 1},
+      {"opaque_finishClientRegistration", 1},
+      {"opaque_startClientLogin", 1},
+      {"opaque_startClientLoginPipelined", 1},
+      {"opaque_finishClientLogin", 1},
+      {"opaque_startClientLoginContext", 1},
+      {"opaque_finishClientLoginContext", 1},
+      {"opaque_prewarmKeyStretching", 1},
+      {"opaque_releaseKeyStretchingMemory", 0},
+      {"opaque_getCpuTopology", 0},
+      {"opaque_createServerSetup", 1},
+      {"opaque_createServerSetupHandle", 2},
+      {"opaque_getServerPublicKey", 2},
+      {"opaque_createServerRegistrationResponse", 1},
+      {"opaque_startServerLogin", 1},
+      {"opaque_startServerLoginBatch", 3},
+      {"opaque_finishServerLogin", 1},
+      {"opaque_createServerLoginSessionStore", 1},
+      {"opaque_getServerLoginSessionCount", 1},
+      {"opaque_startServerLoginSession", 1},
+      {"opaque_finishServerLoginSession", 1},
+      {"opaque_createRegistrationImport", 1},
+      {"opaque_createServerSetupKeyring", 0},
+      {"opaque_addServerSetupKey", 1},
+      {"opaque_setActiveServerSetupKey", 1},
+      {"opaque_removeServerSetupKey", 1},
+      {"opaque_getServerSetupKeys", 1},
+      {"opaque_startClientRegistrationBinary", 1},
+      {"opaque_finishClientRegistrationBinary", 1},
+      {"opaque_startClientLoginBinary", 1},
+      {"opaque_finishClientLoginBinary", 1},
+      {"opaque_createServerSetupBinary", 1},
+      {"opaque_getServerPublicKeyBinary", 2},
+      {"opaque_createServerRegistrationResponseBinary", 1},
+      {"opaque_startServerLoginBinary", 1},
+      {"opaque_finishServerLoginBinary", 1},
+      {"opaque_setMetricsEnabled", 1},
+      {"opaque_getMetrics", 0},
+      {"opaque_resetMetrics", 0},
+      {"opaque_finishClientRegistrationAsync", 2},
+      {"opaque_finishClientLoginAsync", 2},
+      {"opaque_finishClientLoginContextAsync", 2},
+      {"opaque_nextRegistrationImportChunk", 2},
+      {"opaque_cancelAsync", 1},
+      {"opaque_finishClientLoginResult", 1, true},
+      {"opaque_finishClientLoginContextResult", 1, true},
+      {"opaque_startServerLoginResult", 1, true},
+      {"opaque_finishServerLoginResult", 1, true},
+      {"opaque_startServerLoginSessionResult", 1, true},
+      {"opaque_finishServerLoginSessionResult", 1, true},
+      {"opaque_createServerSetupHandleResult", 2, true},
+    };
+
+#define OPAQUE_PROP_NAME_STRING(name) #name,
+    const char* const kPropNames[] = {OPAQUE_PROP_NAMES(OPAQUE_PROP_NAME_STRING)};
+#undef OPAQUE_PROP_NAME_STRING
+
+    const char* const kSuites[] = {"ristretto255", "p256", "p384", ""};
+
+    const int kMaxDepth = 3;
+
+    // The runtime and the values of a real login, created once. The
+    // values are released before the runtime.
+    struct Fixture {
+      Fixture() {
+        auto& rt = runtime.rt();
+        auto serverSetup = runtime.eval("opaque_createServerSetup({})");
+        auto login = runtime.function("testLogin").call(rt, serverSetup).asObject(rt);
+        auto names = login.getPropertyNames(rt);
+        for (size_t i = 0; i < names.size(rt); i++) {
+          auto name = names.getValueAtIndex(rt, i).asString(rt);
+          messages.push_back(login.getProperty(rt, name).asString(rt).utf8(rt));
+        }
+        messages.push_back(serverSetup.asString(rt).utf8(rt));
+        values.push_back(std::move(serverSetup));
+        values.push_back(runtime.eval("opaque_createServerSetupHandle(opaque_createServerSetup({}), undefined)"));
+        values.push_back(runtime.eval("opaque_createServerSetupBinary({})"));
+        values.push_back(runtime.eval("opaque_createServerLoginSessionStore({})"));
+        values.push_back(runtime.eval(R"JS(
+          (function () {
+            var keyring = opaque_createServerSetupKeyring();
+            opaque_addServerSetupKey({ keyring: keyring, keyId: 'a', serverSetup: opaque_createServerSetup({}) });
+            return keyring;
+          })()
+        )JS"));
+        values.push_back(runtime.eval("opaque_startClientLoginContext({ password: 'hunter42' }).context"));
+        values.push_back(runtime.eval("testKeyStretching"));
+        values.push_back(runtime.eval("new ArrayBuffer(16)"));
+      }
+
+      TestRuntime runtime;
+      std::vector<std::string> messages;
+      std::vector<jsi::Value> values;
+    };
+
+    Fixture& fixture() {
+      static Fixture f;
+      return f;
+    }
+
+    // Mostly small integers, so key stretching params and sizes stay cheap,
+    // and the numbers the validation has to reject.
+    double makeNumber(FuzzedDataProvider& data) {
+      switch (data.ConsumeIntegralInRange(0, 7)) {
+        case 0: return -1;
+        case 1: return 0.5;
+        case 2: return std::numeric_limits<double>::quiet_NaN();
+        case 3: return std::numeric_limits<double>::infinity();
+        case 4: return 4294967296.0;
+        default: return data.ConsumeIntegralInRange(0, 64);
+      }
+    }
+
+    std::string makeString(FuzzedDataProvider& data) {
+      const auto& messages = fixture().messages;
+      switch (data.ConsumeIntegralInRange(0, 3)) {
+        case 0:
+          return messages[data.ConsumeIntegralInRange<size_t>(0, messages.size() - 1)];
+        case 1: {
+          // a message with one character replaced
+          auto message = messages[data.ConsumeIntegralInRange<size_t>(0, messages.size() - 1)];
+          if (!message.empty()) {
+            message[data.ConsumeIntegralInRange<size_t>(0, message.size() - 1)] = data.ConsumeIntegral<char>();
+          }
+          return message;
+        }
+        case 2:
+          return kSuites[data.ConsumeIntegralInRange<size_t>(0, std::size(kSuites) - 1)];
+        default:
+          return data.ConsumeRandomLengthString(1024);
+      }
+    }
+
+    jsi::Value makeUint8Array(jsi::Runtime& rt, FuzzedDataProvider& data) {
+      auto bytes = data.ConsumeBytes<uint8_t>(data.ConsumeIntegralInRange<size_t>(0, 1024));
+      auto array = rt.global().getPropertyAsFunction(rt, "Uint8Array")
+        .callAsConstructor(rt, static_cast<double>(bytes.size())).asObject(rt);
+      auto buffer = array.getPropertyAsObject(rt, "buffer").getArrayBuffer(rt);
+      if (!bytes.empty()) {
+        std::memcpy(buffer.data(rt), bytes.data(), bytes.size());
+      }
+      return array;
+    }
+
+    jsi::Value makeValue(jsi::Runtime& rt, FuzzedDataProvider& data, int depth);
+
+    jsi::Value makeObject(jsi::Runtime& rt, FuzzedDataProvider& data, int depth) {
+      auto obj = jsi::Object(rt);
+      auto count = data.ConsumeIntegralInRange(0, 8);
+      for (int i = 0; i < count; i++) {
+        auto name = kPropNames[data.ConsumeIntegralInRange<size_t>(0, std::size(kPropNames) - 1)];
+        obj.setProperty(rt, name, makeValue(rt, data, depth + 1));
+      }
+      return obj;
+    }
+
+    jsi::Value makeValue(jsi::Runtime& rt, FuzzedDataProvider& data, int depth) {
+      switch (data.ConsumeIntegralInRange(0, depth < kMaxDepth ? 10 : 6)) {
+        case 0: return jsi::Value::undefined();
+        case 1: return jsi::Value::null();
+        case 2: return jsi::Value(data.ConsumeBool());
+        case 3: return jsi::Value(makeNumber(data));
+        case 4: return jsi::String::createFromUtf8(rt, makeString(data));
+        case 5: return makeUint8Array(rt, data);
+        case 6: {
+          const auto& values = fixture().values;
+          return jsi::Value(rt, values[data.ConsumeIntegralInRange<size_t>(0, values.size() - 1)]);
+        }
+        case 7: {
+          auto array = jsi::Array(rt, data.ConsumeIntegralInRange(0, 4));
+          for (size_t i = 0; i < array.size(rt); i++) {
+            array.setValueAtIndex(rt, i, makeValue(rt, data, depth + 1));
+          }
+          return array;
+        }
+        case 8: {
+          // forged typed array
+          auto obj = jsi::Object(rt);
+          obj.setProperty(rt, "buffer", rt.global().getPropertyAsFunction(rt, "ArrayBuffer")
+            .callAsConstructor(rt, static_cast<double>(data.ConsumeIntegralInRange(0, 64))));
+          obj.setProperty(rt, "byteOffset", makeNumber(data));
+          obj.setProperty(rt, "byteLength", makeNumber(data));
+          return obj;
+        }
+        default: return makeObject(rt, data, depth);
+      }
+    }
+  }  // namespace
+}  // namespace NativeOpaque
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* bytes, size_t size) {
+  using NativeOpaque::jsi::JSError;
+  auto& fixture = NativeOpaque::fixture();
+  auto& rt = fixture.runtime.rt();
+  FuzzedDataProvider data(bytes, size);
+
+  const auto& function = NativeOpaque::kFunctions[
+    data.ConsumeIntegralInRange<size_t>(0, std::size(NativeOpaque::kFunctions) - 1)];
+  // now and then one argument too few or too many
+  auto count = function.paramCount;
+  switch (data.ConsumeIntegralInRange(0, 15)) {
+    case 0: count = count > 0 ? count - 1 : 0; break;
+    case 1: count++; break;
+    default: break;
+  }
+
+  try {
+    std::vector<NativeOpaque::jsi::Value> args;
+    for (size_t i = 0; i < count; i++) {
+      args.push_back(NativeOpaque::makeValue(rt, data, 0));
+    }
+    auto func = fixture.runtime.function(function.name);
+    func.call(rt, static_cast<const NativeOpaque::jsi::Value*>(args.data()), args.size());
+  } catch (const JSError&) {
+    if (function.returnsErrors) {
+      std::abort();
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,179 @@
+#include "./test-runtime.h"
+
+#include <hermes/hermes.h>
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "react-native-opaque.h"
+
+namespace NativeOpaque {
+  const char* const kTestHelpers = R"JS(
+    var testKeyStretching = { memoryCost: 8, iterations: 1, parallelism: 1 };
+
+    function testLogin(serverSetup, suite) {
+      var password = 'hunter42';
+      var userIdentifier = 'user@example.com';
+      var registration = opaque_startClientRegistration({ password: password, suite: suite });
+      var response = opaque_createServerRegistrationResponse({
+        serverSetup: serverSetup,
+        userIdentifier: userIdentifier,
+        registrationRequest: registration.registrationRequest,
+        suite: suite,
+      });
+      var record = opaque_finishClientRegistration({
+        password: password,
+        registrationResponse: response.registrationResponse,
+        clientRegistrationState: registration.clientRegistrationState,
+        keyStretching: testKeyStretching,
+        suite: suite,
+      });
+      var login = opaque_startClientLogin({ password: password, suite: suite });
+      var serverLogin = opaque_startServerLogin({
+        serverSetup: serverSetup,
+        registrationRecord: record.registrationRecord,
+        startLoginRequest: login.startLoginRequest,
+        userIdentifier: userIdentifier,
+        suite: suite,
+      });
+      var clientFinish = opaque_finishClientLogin({
+        clientLoginState: login.clientLoginState,
+        loginResponse: serverLogin.loginResponse,
+        password: password,
+        keyStretching: testKeyStretching,
+        suite: suite,
+      });
+      var serverFinish = opaque_finishServerLogin({
+        serverLoginState: serverLogin.serverLoginState,
+        finishLoginRequest: clientFinish.finishLoginRequest,
+        suite: suite,
+      });
+      return {
+        clientRegistrationState: registration.clientRegistrationState,
+        registrationRequest: registration.registrationRequest,
+        registrationResponse: response.registrationResponse,
+        registrationRecord: record.registrationRecord,
+        clientLoginState: login.clientLoginState,
+        startLoginRequest: login.startLoginRequest,
+        serverLoginState: serverLogin.serverLoginState,
+        loginResponse: serverLogin.loginResponse,
+        finishLoginRequest: clientFinish.finishLoginRequest,
+        clientSessionKey: clientFinish.sessionKey,
+        serverSessionKey: serverFinish.sessionKey,
+        exportKey: clientFinish.exportKey,
+        registrationExportKey: record.exportKey,
+      };
+    }
+
+    function testLoginBinary(serverSetup, suite) {
+      var password = 'hunter42';
+      var userIdentifier = 'user@example.com';
+      var registration = opaque_startClientRegistrationBinary({ password: password, suite: suite });
+      var response = opaque_createServerRegistrationResponseBinary({
+        serverSetup: serverSetup,
+        userIdentifier: userIdentifier,
+        registrationRequest: registration.registrationRequest,
+        suite: suite,
+      });
+      var record = opaque_finishClientRegistrationBinary({
+        password: password,
+        registrationResponse: response.registrationResponse,
+        clientRegistrationState: registration.clientRegistrationState,
+        keyStretching: testKeyStretching,
+        suite: suite,
+      });
+      var login = opaque_startClientLoginBinary({ password: password, suite: suite });
+      var serverLogin = opaque_startServerLoginBinary({
+        serverSetup: serverSetup,
+        registrationRecord: record.registrationRecord,
+        startLoginRequest: login.startLoginRequest,
+        userIdentifier: userIdentifier,
+        suite: suite,
+      });
+      var clientFinish = opaque_finishClientLoginBinary({
+        clientLoginState: login.clientLoginState,
+        loginResponse: serverLogin.loginResponse,
+        password: password,
+        keyStretching: testKeyStretching,
+        suite: suite,
+      });
+      var serverFinish = opaque_finishServerLoginBinary({
+        serverLoginState: serverLogin.serverLoginState,
+        finishLoginRequest: clientFinish.finishLoginRequest,
+        suite: suite,
+      });
+      return {
+        clientSessionKey: clientFinish.sessionKey,
+        serverSessionKey: serverFinish.sessionKey,
+      };
+    }
+  )JS";
+
+  // Stands in for Promise in the runtimes with a CallInvoker, see
+  // TestRuntime::settle.
+  const char* const kTestPromise = R"JS(
+    globalThis.Promise = function TestPromise(executor) {
+      var self = this;
+      self.state = 'pending';
+      executor(function (value) {
+        self.state = 'fulfilled';
+        self.value = value;
+      }, function (error) {
+        self.state = 'rejected';
+        self.value = error;
+      });
+    };
+  )JS";
+
+  void TestCallInvoker::invokeAsync(std::function<void()>&& func) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      callbacks_.push_back(std::move(func));
+    }
+    cv_.notify_one();
+  }
+
+  bool TestCallInvoker::runCallbacks(std::chrono::milliseconds timeout) {
+    std::deque<std::function<void()>> callbacks;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      if (!cv_.wait_for(lock, timeout, [this] { return !callbacks_.empty(); })) {
+        return false;
+      }
+      callbacks.swap(callbacks_);
+    }
+    for (auto& callback : callbacks) {
+      callback();
+    }
+    return true;
+  }
+
+  TestRuntime::TestRuntime(std::shared_ptr<TestCallInvoker> callInvoker)
+    : callInvoker_(std::move(callInvoker)), runtime_(facebook::hermes::makeHermesRuntime()) {
+    installOpaque(*runtime_, callInvoker_);
+    runtime_->evaluateJavaScript(std::make_shared<jsi::StringBuffer>(kTestHelpers), "test-helpers.js");
+    if (callInvoker_) {
+      runtime_->evaluateJavaScript(std::make_shared<jsi::StringBuffer>(kTestPromise), "test-promise.js");
+    }
+  }
+
+  jsi::Value TestRuntime::eval(const std::string& code) {
+    return runtime_->evaluateJavaScript(std::make_shared<jsi::StringBuffer>("(" + code + ")"), "test.js");
+  }
+
+  jsi::Function TestRuntime::function(const std::string& name) {
+    return runtime_->global().getPropertyAsFunction(*runtime_, name.c_str());
+  }
+
+  jsi::Object TestRuntime::settle(const jsi::Value& promise) {
+    auto obj = promise.asObject(*runtime_);
+    while (obj.getProperty(*runtime_, "state").asString(*runtime_).utf8(*runtime_) == "pending") {
+      if (!callInvoker_ || !callInvoker_->runCallbacks(std::chrono::seconds(30))) {
+        throw std::runtime_error("the promise didn't settle");
+      }
+    }
+    return obj;
+  }
+}  // namespace NativeOpaque
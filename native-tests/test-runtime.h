@@ -0,0 +1,68 @@
+#ifndef NATIVE_TESTS_TEST_RUNTIME_H_
+#define NATIVE_TESTS_TEST_RUNTIME_H_
+
+#include <jsi/jsi.h>
+#include <ReactCommon/CallInvoker.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace NativeOpaque {
+  namespace jsi = facebook::jsi;
+
+  // Queues the callbacks of the async functions until the thread of the
+  // runtime runs them, like the JS thread of the app.
+  class TestCallInvoker : public facebook::react::CallInvoker {
+   public:
+    void invokeAsync(std::function<void()>&& func) override;
+    void invokeSync(std::function<void()>&& func) override { func(); }
+
+    // Waits up to `timeout` for callbacks and runs them. Returns false if
+    // there were none.
+    bool runCallbacks(std::chrono::milliseconds timeout);
+
+   private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::function<void()>> callbacks_;
+  };
+
+  // A host build of Hermes with the module installed, the way the app
+  // installs it. Without a CallInvoker the async functions throw. It also
+  // defines the JS helpers of kTestHelpers.
+  class TestRuntime {
+   public:
+    explicit TestRuntime(std::shared_ptr<TestCallInvoker> callInvoker = nullptr);
+
+    jsi::Runtime& rt() { return *runtime_; }
+
+    // Evaluates a JS expression.
+    jsi::Value eval(const std::string& code);
+
+    // The global function `name`, e.g. "opaque_startClientLogin".
+    jsi::Function function(const std::string& name);
+
+    // Runs the callbacks of the CallInvoker until the promise returned by
+    // an async function settled and returns it. The host runtime has no
+    // microtask queue, so with a CallInvoker `Promise` is replaced by one
+    // which settles synchronously and keeps its `state` and `value`.
+    jsi::Object settle(const jsi::Value& promise);
+
+   private:
+    std::shared_ptr<TestCallInvoker> callInvoker_;
+    std::unique_ptr<jsi::Runtime> runtime_;
+  };
+
+  // Defines `testLogin(serverSetup, suite)`, which registers a user and logs
+  // in through the string API and returns all messages and keys, and
+  // `testLoginBinary(serverSetup, suite)`, the same through the binary API.
+  // Both use cheap key stretching params.
+  extern const char* const kTestHelpers;
+}  // namespace NativeOpaque
+
+#endif  // NATIVE_TESTS_TEST_RUNTIME_H_
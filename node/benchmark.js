@@ -0,0 +1,140 @@
+'use strict';
+
+// Throughput of the server functions of the native addon compared to the
+// WASM build of @serenity-kit/opaque. The native functions run once on the
+// main thread and once with CONCURRENCY calls in flight on the libuv
+// threadpool (UV_THREADPOOL_SIZE, default 4).
+//
+//   node node/benchmark.js [durationMs]
+
+const { performance } = require('perf_hooks');
+const native = require('./index');
+
+const DURATION_MS = Number(process.argv[2] || 2000);
+const CONCURRENCY = 64;
+const USER_IDENTIFIER = 'user@example.com';
+const PASSWORD = 'hunter42';
+
+function measureSync(fn) {
+  const end = performance.now() + DURATION_MS;
+  let ops = 0;
+  while (performance.now() < end) {
+    fn();
+    ops++;
+  }
+  return (ops * 1000) / DURATION_MS;
+}
+
+async function measureAsync(fn) {
+  const start = performance.now();
+  const end = start + DURATION_MS;
+  let ops = 0;
+  const worker = async () => {
+    while (performance.now() < end) {
+      await fn();
+      ops++;
+    }
+  };
+  await Promise.all(Array.from({ length: CONCURRENCY }, worker));
+  return (ops * 1000) / (performance.now() - start);
+}
+
+// Registers a user and prepares a login with the given client.
+function prepare(opaque, serverSetup) {
+  const registration = opaque.client.startRegistration({ password: PASSWORD });
+  const { registrationResponse } = opaque.server.createRegistrationResponse({
+    serverSetup,
+    userIdentifier: USER_IDENTIFIER,
+    registrationRequest: registration.registrationRequest,
+  });
+  const { registrationRecord } = opaque.client.finishRegistration({
+    password: PASSWORD,
+    registrationResponse,
+    clientRegistrationState: registration.clientRegistrationState,
+  });
+  const login = opaque.client.startLogin({ password: PASSWORD });
+  const startLoginParams = {
+    serverSetup,
+    registrationRecord,
+    startLoginRequest: login.startLoginRequest,
+    userIdentifier: USER_IDENTIFIER,
+  };
+  const { serverLoginState, loginResponse } =
+    opaque.server.startLogin(startLoginParams);
+  const { finishLoginRequest } = opaque.client.finishLogin({
+    clientLoginState: login.clientLoginState,
+    loginResponse,
+    password: PASSWORD,
+  });
+  return {
+    registrationRequest: registration.registrationRequest,
+    startLoginParams,
+    finishLoginParams: { serverLoginState, finishLoginRequest },
+  };
+}
+
+function report(rows) {
+  console.table(
+    rows.map(([name, wasm, nativeSync, nativeAsync]) => ({
+      function: name,
+      'wasm ops/s': Math.round(wasm),
+      'native ops/s': Math.round(nativeSync),
+      'native async ops/s': Math.round(nativeAsync),
+      'async / wasm': (nativeAsync / wasm).toFixed(1) + 'x',
+    }))
+  );
+}
+
+async function main() {
+  const wasm = await import('@serenity-kit/opaque');
+  await wasm.ready;
+
+  const wasmSetup = wasm.server.createSetup();
+  const wasmInput = prepare(wasm, wasmSetup);
+  const nativeSetup = native.server.createSetupHandle(
+    native.server.createSetup()
+  );
+  const nativeInput = prepare(native, nativeSetup);
+
+  const registrationParams = (serverSetup, input) => ({
+    serverSetup,
+    userIdentifier: USER_IDENTIFIER,
+    registrationRequest: input.registrationRequest,
+  });
+  const wasmRegistration = registrationParams(wasmSetup, wasmInput);
+  const nativeRegistration = registrationParams(nativeSetup, nativeInput);
+
+  const rows = [];
+  rows.push([
+    'createRegistrationResponse',
+    measureSync(() => wasm.server.createRegistrationResponse(wasmRegistration)),
+    measureSync(() =>
+      native.server.createRegistrationResponse(nativeRegistration)
+    ),
+    await measureAsync(() =>
+      native.server.createRegistrationResponseAsync(nativeRegistration)
+    ),
+  ]);
+  rows.push([
+    'startLogin',
+    measureSync(() => wasm.server.startLogin(wasmInput.startLoginParams)),
+    measureSync(() => native.server.startLogin(nativeInput.startLoginParams)),
+    await measureAsync(() =>
+      native.server.startLoginAsync(nativeInput.startLoginParams)
+    ),
+  ]);
+  rows.push([
+    'finishLogin',
+    measureSync(() => wasm.server.finishLogin(wasmInput.finishLoginParams)),
+    measureSync(() => native.server.finishLogin(nativeInput.finishLoginParams)),
+    await measureAsync(() =>
+      native.server.finishLoginAsync(nativeInput.finishLoginParams)
+    ),
+  ]);
+  report(rows);
+}
+
+main().catch((error) => {
+  console.error(error);
+  process.exit(1);
+});
@@ -0,0 +1,124 @@
+import type {
+  CipherSuiteParams,
+  client as nativeClient,
+  server as nativeServer,
+} from '../src/index';
+
+export type {
+  CipherSuiteParams,
+  CustomIdentifiers,
+  KeyStretchingParams,
+} from '../src/index';
+
+/** Decoded server setup kept in native memory, freed by the garbage collector. */
+export type ServerSetupHandle = { readonly __opaqueServerSetupHandle: true };
+
+/** Decoded server setups by key ID, see `server.createSetupKeyring`. */
+export type ServerSetupKeyring = { readonly __opaqueServerSetupKeyring: true };
+
+/** Login states kept in native memory, see `server.createLoginSessionStore`. */
+export type LoginSessionStore = { readonly __opaqueLoginSessionStore: true };
+
+export type ServerSetup = string | ServerSetupHandle | ServerSetupKeyring;
+
+type WithSetup<P> = Omit<P, 'serverSetup'> & {
+  serverSetup: ServerSetup;
+};
+
+type WithSessionStore<P> = Omit<P, 'sessionStore'> & {
+  sessionStore: LoginSessionStore;
+};
+
+export namespace client {
+  export function startRegistration(
+    params: nativeClient.StartRegistrationParams
+  ): nativeClient.StartRegistrationResult;
+  export function finishRegistration(
+    params: nativeClient.FinishRegistrationParams
+  ): nativeClient.FinishRegistrationResult;
+  export function finishRegistrationAsync(
+    params: nativeClient.FinishRegistrationParams
+  ): Promise<nativeClient.FinishRegistrationResult>;
+  export function startLogin(
+    params: nativeClient.StartLoginParams
+  ): nativeClient.StartLoginResult;
+  /** undefined if the login failed */
+  export function finishLogin(
+    params: nativeClient.FinishLoginParams
+  ): nativeClient.FinishLoginResult | undefined;
+  export function finishLoginAsync(
+    params: nativeClient.FinishLoginParams
+  ): Promise<nativeClient.FinishLoginResult | undefined>;
+}
+
+export namespace server {
+  export function createSetup(params?: CipherSuiteParams): string;
+  export function createSetupHandle(
+    serverSetup: string,
+    params?: CipherSuiteParams
+  ): ServerSetupHandle;
+  export function getPublicKey(
+    serverSetup: ServerSetup,
+    params?: nativeServer.ServerSetupParams
+  ): string;
+  export function createRegistrationResponse(
+    params: WithSetup<nativeServer.CreateRegistrationResponseParams>
+  ): nativeServer.CreateRegistrationResponseResult;
+  export function createRegistrationResponseAsync(
+    params: WithSetup<nativeServer.CreateRegistrationResponseParams>
+  ): Promise<nativeServer.CreateRegistrationResponseResult>;
+  export function startLogin(
+    params: WithSetup<nativeServer.StartLoginParams>
+  ): nativeServer.StartLoginResult;
+  export function startLoginAsync(
+    params: WithSetup<nativeServer.StartLoginParams>
+  ): Promise<nativeServer.StartLoginResult>;
+  export function startLoginBatch(
+    serverSetup: ServerSetup,
+    requests: nativeServer.StartLoginBatchRequest[],
+    params?: nativeServer.ServerSetupParams
+  ): nativeServer.StartLoginBatchResult[];
+  export function startLoginBatchAsync(
+    serverSetup: ServerSetup,
+    requests: nativeServer.StartLoginBatchRequest[],
+    params?: nativeServer.ServerSetupParams
+  ): Promise<nativeServer.StartLoginBatchResult[]>;
+  export function finishLogin(
+    params: nativeServer.FinishLoginParams
+  ): nativeServer.FinishLoginResult;
+  export function finishLoginAsync(
+    params: nativeServer.FinishLoginParams
+  ): Promise<nativeServer.FinishLoginResult>;
+  export function createLoginSessionStore(
+    params?: nativeServer.CreateLoginSessionStoreParams
+  ): LoginSessionStore;
+  export function getLoginSessionCount(sessionStore: LoginSessionStore): number;
+  export function startLoginSession(
+    params: WithSessionStore<WithSetup<nativeServer.StartLoginSessionParams>>
+  ): nativeServer.StartLoginSessionResult;
+  export function startLoginSessionAsync(
+    params: WithSessionStore<WithSetup<nativeServer.StartLoginSessionParams>>
+  ): Promise<nativeServer.StartLoginSessionResult>;
+  export function finishLoginSession(
+    params: WithSessionStore<nativeServer.FinishLoginSessionParams>
+  ): nativeServer.FinishLoginResult;
+  export function createSetupKeyring(): ServerSetupKeyring;
+  export function addSetupKey(
+    params: CipherSuiteParams & {
+      keyring: ServerSetupKeyring;
+      keyId: string;
+      serverSetup: string | ServerSetupHandle;
+    }
+  ): void;
+  export function setActiveSetupKey(params: {
+    keyring: ServerSetupKeyring;
+    keyId: string;
+  }): void;
+  export function removeSetupKey(params: {
+    keyring: ServerSetupKeyring;
+    keyId: string;
+  }): boolean;
+  export function getSetupKeys(
+    keyring: ServerSetupKeyring
+  ): nativeServer.SetupKeys;
+}
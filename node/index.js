@@ -0,0 +1,46 @@
+'use strict';
+
+// Same `client` and `server` API as react-native-opaque and
+// @serenity-kit/opaque, backed by the native addon. The `*Async` functions
+// run on the libuv threadpool, its size is set with UV_THREADPOOL_SIZE.
+
+const path = require('path');
+
+const addon = require(
+  process.env.OPAQUE_NODE_ADDON || path.join(__dirname, 'build', 'opaque.node')
+);
+
+const client = {
+  startRegistration: addon.startClientRegistration,
+  finishRegistration: addon.finishClientRegistration,
+  finishRegistrationAsync: addon.finishClientRegistrationAsync,
+  startLogin: addon.startClientLogin,
+  finishLogin: addon.finishClientLogin,
+  finishLoginAsync: addon.finishClientLoginAsync,
+};
+
+const server = {
+  createSetup: addon.createServerSetup,
+  createSetupHandle: addon.createServerSetupHandle,
+  getPublicKey: addon.getServerPublicKey,
+  createRegistrationResponse: addon.createServerRegistrationResponse,
+  createRegistrationResponseAsync: addon.createServerRegistrationResponseAsync,
+  startLogin: addon.startServerLogin,
+  startLoginAsync: addon.startServerLoginAsync,
+  startLoginBatch: addon.startServerLoginBatch,
+  startLoginBatchAsync: addon.startServerLoginBatchAsync,
+  finishLogin: addon.finishServerLogin,
+  finishLoginAsync: addon.finishServerLoginAsync,
+  createLoginSessionStore: addon.createServerLoginSessionStore,
+  getLoginSessionCount: addon.getServerLoginSessionCount,
+  startLoginSession: addon.startServerLoginSession,
+  startLoginSessionAsync: addon.startServerLoginSessionAsync,
+  finishLoginSession: addon.finishServerLoginSession,
+  createSetupKeyring: addon.createServerSetupKeyring,
+  addSetupKey: addon.addServerSetupKey,
+  setActiveSetupKey: addon.setActiveServerSetupKey,
+  removeSetupKey: addon.removeServerSetupKey,
+  getSetupKeys: addon.getServerSetupKeys,
+};
+
+module.exports = { client, server };
@@ -0,0 +1,844 @@
+#define NAPI_VERSION 8
+#include <node_api.h>
+
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "opaque-binding.h"
+#include "opaque-rust.h"
+
+// Node-API binding of the cxx bridge for servers running on Node.js. It
+// offers the same functions with the same params and results as the JSI
+// module in cpp/react-native-opaque.cpp, which can't run without a JSI
+// runtime, and additionally `*Async` variants running on the libuv
+// threadpool. The params and results are read and written by the shared
+// functions of opaque-binding.h.
+namespace NativeOpaque::Node {
+  // Thrown for invalid input and failed Node-API calls, turned into a JS
+  // exception at the boundary of every function.
+  class Error : public std::runtime_error {
+   public:
+    using std::runtime_error::runtime_error;
+  };
+
+  void check(napi_env env, napi_status status) {
+    if (status == napi_ok) {
+      return;
+    }
+    const napi_extended_error_info* info = nullptr;
+    napi_get_last_error_info(env, &info);
+    throw Error(info != nullptr && info->error_message != nullptr ? info->error_message : "Node-API call failed");
+  }
+
+  // The property names of OPAQUE_PROP_NAMES, Node-API looks them up by
+  // their C string.
+  struct PropNames {
+#define OPAQUE_DECLARE_PROP_NAME(name) const char* const name = #name;
+    OPAQUE_PROP_NAMES(OPAQUE_DECLARE_PROP_NAME)
+#undef OPAQUE_DECLARE_PROP_NAME
+  };
+
+  const PropNames kNames;
+
+  napi_valuetype typeOf(napi_env env, napi_value value) {
+    napi_valuetype type;
+    check(env, napi_typeof(env, value, &type));
+    return type;
+  }
+
+  std::string kindToString(napi_env env, napi_value value) {
+    switch (typeOf(env, value)) {
+      case napi_undefined:
+        return "undefined";
+      case napi_null:
+        return "null";
+      case napi_boolean: {
+        bool result;
+        check(env, napi_get_value_bool(env, value, &result));
+        return result ? "true" : "false";
+      }
+      case napi_number:
+        return "a number";
+      case napi_string:
+        return "a string";
+      case napi_symbol:
+        return "a symbol";
+      case napi_bigint:
+        return "a bigint";
+      case napi_function:
+        return "a function";
+      default:
+        return "an object";
+    }
+  }
+
+  std::string toString(napi_env env, napi_value value) {
+    size_t length;
+    check(env, napi_get_value_string_utf8(env, value, nullptr, 0, &length));
+    std::string result(length, '\0');
+    check(env, napi_get_value_string_utf8(env, value, result.data(), length + 1, &length));
+    return result;
+  }
+
+  napi_value makeString(napi_env env, const std::string& str) {
+    napi_value result;
+    check(env, napi_create_string_utf8(env, str.data(), str.size(), &result));
+    return result;
+  }
+
+  napi_value makeString(napi_env env, const ::rust::String& str) {
+    napi_value result;
+    check(env, napi_create_string_utf8(env, str.data(), str.size(), &result));
+    return result;
+  }
+
+  napi_value makeNumber(napi_env env, double value) {
+    napi_value result;
+    check(env, napi_create_double(env, value, &result));
+    return result;
+  }
+
+  napi_value makeBoolean(napi_env env, bool value) {
+    napi_value result;
+    check(env, napi_get_boolean(env, value, &result));
+    return result;
+  }
+
+  napi_value makeObject(napi_env env) {
+    napi_value result;
+    check(env, napi_create_object(env, &result));
+    return result;
+  }
+
+  napi_value undefined(napi_env env) {
+    napi_value result;
+    check(env, napi_get_undefined(env, &result));
+    return result;
+  }
+
+  napi_value asObject(napi_env env, napi_value value) {
+    if (typeOf(env, value) != napi_object) {
+      throw Error("expected params object but got " + kindToString(env, value));
+    }
+    return value;
+  }
+
+  napi_value getProperty(napi_env env, napi_value obj, const char* name) {
+    napi_value result;
+    check(env, napi_get_named_property(env, obj, name, &result));
+    return result;
+  }
+
+  void setProperty(napi_env env, napi_value obj, const char* name, napi_value value) {
+    check(env, napi_set_named_property(env, obj, name, value));
+  }
+
+  bool isNullish(napi_env env, napi_value value) {
+    auto type = typeOf(env, value);
+    return type == napi_undefined || type == napi_null;
+  }
+
+  // The params of the functions taking them as a separate argument, which
+  // can be undefined. Returns nullptr then.
+  napi_value getParams(napi_env env, napi_value params) {
+    return isNullish(env, params) ? nullptr : asObject(env, params);
+  }
+
+  std::string asStringProp(napi_env env, napi_value obj, const char* name, napi_value value) {
+    if (typeOf(env, value) != napi_string) {
+      bool hasProperty = true;
+      if (typeOf(env, value) == napi_undefined) {
+        check(env, napi_has_named_property(env, obj, name, &hasProperty));
+      }
+      if (!hasProperty) {
+        throw Error(missingPropertyMessage(name));
+      }
+      throw Error(invalidTypeMessage(name, "string", kindToString(env, value)));
+    }
+    return toString(env, value);
+  }
+
+  std::string getStringProp(napi_env env, napi_value obj, const char* name) {
+    return asStringProp(env, obj, name, getProperty(env, obj, name));
+  }
+
+  ::rust::Vec<::rust::String> getOptionalStringProp(napi_env env, napi_value obj, const char* name) {
+    ::rust::Vec<::rust::String> result;
+    auto value = getProperty(env, obj, name);
+    if (typeOf(env, value) == napi_string) {
+      result.push_back(toString(env, value));
+    }
+    return result;
+  }
+
+  ::rust::Vec<::rust::String> getIdentifier(napi_env env, napi_value obj, const char* name) {
+    ::rust::Vec<::rust::String> result;
+    auto identifiers = getProperty(env, obj, kNames.identifiers);
+    if (isNullish(env, identifiers)) {
+      return result;
+    }
+    if (typeOf(env, identifiers) != napi_object) {
+      throw Error(kInvalidIdentifiersMessage);
+    }
+    auto value = getProperty(env, identifiers, name);
+    if (typeOf(env, value) == napi_undefined) {
+      return result;
+    }
+    if (typeOf(env, value) != napi_string) {
+      throw Error(invalidIdentifierMessage(name));
+    }
+    result.push_back(toString(env, value));
+    return result;
+  }
+
+  double getNumberProp(napi_env env, napi_value obj, const char* name) {
+    auto prop = getProperty(env, obj, name);
+    if (typeOf(env, prop) != napi_number) {
+      throw Error(invalidTypeMessage(name, "number", kindToString(env, prop)));
+    }
+    double value;
+    check(env, napi_get_value_double(env, prop, &value));
+    return value;
+  }
+
+  uint32_t getUint32Prop(napi_env env, napi_value obj, const char* name) {
+    auto value = getNumberProp(env, obj, name);
+    if (!(value >= 0 && value <= UINT32_MAX) || std::trunc(value) != value) {
+      throw Error(invalidUint32Message(name));
+    }
+    return static_cast<uint32_t>(value);
+  }
+
+  ::rust::Vec<OpaqueKeyStretchingParams> getKeyStretching(napi_env env, napi_value obj) {
+    ::rust::Vec<OpaqueKeyStretchingParams> result;
+    auto params = getProperty(env, obj, kNames.keyStretching);
+    if (isNullish(env, params)) {
+      return result;
+    }
+    if (typeOf(env, params) != napi_object) {
+      throw Error(kInvalidKeyStretchingMessage);
+    }
+    result.push_back({
+      .memory_cost = getUint32Prop(env, params, kNames.memoryCost),
+      .iterations = getUint32Prop(env, params, kNames.iterations),
+      .parallelism = getUint32Prop(env, params, kNames.parallelism),
+    });
+    return result;
+  }
+
+  napi_value makeKeyStretching(napi_env env, const OpaqueKeyStretchingParams& params) {
+    auto result = makeObject(env);
+    setProperty(env, result, kNames.memoryCost, makeNumber(env, params.memory_cost));
+    setProperty(env, result, kNames.iterations, makeNumber(env, params.iterations));
+    setProperty(env, result, kNames.parallelism, makeNumber(env, params.parallelism));
+    return result;
+  }
+
+  // The optional "suite" of `obj`, which can be nullptr for the default one.
+  OpaqueCipherSuite getCipherSuite(napi_env env, napi_value obj) {
+    auto prop = obj ? getProperty(env, obj, kNames.suite) : undefined(env);
+    if (isNullish(env, prop)) {
+      return OpaqueCipherSuite::Default;
+    }
+    auto suite = typeOf(env, prop) == napi_string ? parseCipherSuite(toString(env, prop)) : std::nullopt;
+    if (!suite) {
+      throw Error(kInvalidSuiteMessage);
+    }
+    return *suite;
+  }
+
+  // Reads the params object `obj` for the param readers in opaque-binding.h.
+  struct ParamsReader {
+    napi_env env;
+    napi_value obj;
+    const PropNames& names = kNames;
+
+    std::string string(const char* name) { return getStringProp(env, obj, name); }
+    ::rust::Vec<::rust::String> optional(const char* name) { return getOptionalStringProp(env, obj, name); }
+    ::rust::Vec<::rust::String> identifier(const char* name) { return getIdentifier(env, obj, name); }
+    ::rust::Vec<OpaqueKeyStretchingParams> keyStretching() { return getKeyStretching(env, obj); }
+    OpaqueCipherSuite suite() { return getCipherSuite(env, obj); }
+  };
+
+  // Writes a new result object for the result writers in opaque-binding.h.
+  struct ResultWriter {
+    explicit ResultWriter(napi_env env) : env(env), obj(makeObject(env)) {}
+
+    void set(const char* name, const ::rust::String& value) { setProperty(env, obj, name, makeString(env, value)); }
+    void set(const char* name, const char* value) { setProperty(env, obj, name, makeString(env, std::string(value))); }
+    void set(const char* name, const OpaqueKeyStretchingParams& value) {
+      setProperty(env, obj, name, makeKeyStretching(env, value));
+    }
+
+    napi_env env;
+    napi_value obj;
+    const PropNames& names = kNames;
+  };
+
+  // Creates the result object with one of the writers of opaque-binding.h.
+  template <typename Result>
+  napi_value makeResult(napi_env env, const Result& result, void (*write)(ResultWriter&, const Result&)) {
+    ResultWriter out(env);
+    write(out, result);
+    return out.obj;
+  }
+
+  // Native objects are passed to JS as externals tagged with their type.
+  // They are owned through a shared_ptr, so async calls keep them alive
+  // while the external gets garbage collected.
+  template <typename T>
+  napi_value makeExternal(napi_env env, std::shared_ptr<T> value, const napi_type_tag& tag) {
+    auto data = std::make_unique<std::shared_ptr<T>>(std::move(value));
+    napi_value result;
+    check(env, napi_create_external(env, data.get(), [](napi_env env, void* data, void* hint) {
+      delete static_cast<std::shared_ptr<T>*>(data);
+    }, nullptr, &result));
+    data.release();
+    check(env, napi_type_tag_object(env, result, &tag));
+    return result;
+  }
+
+  // Returns nullptr if the value isn't an external of the tag.
+  template <typename T>
+  std::shared_ptr<T> asExternal(napi_env env, napi_value value, const napi_type_tag& tag) {
+    if (typeOf(env, value) != napi_external) {
+      return nullptr;
+    }
+    bool isTagged;
+    check(env, napi_check_object_type_tag(env, value, &tag, &isTagged));
+    if (!isTagged) {
+      return nullptr;
+    }
+    void* data;
+    check(env, napi_get_value_external(env, value, &data));
+    return *static_cast<std::shared_ptr<T>*>(data);
+  }
+
+  using ServerSetup = ::rust::Box<ServerSetupHandle>;
+  using Keyring = ServerSetupKeyring<ServerSetup>;
+  using LoginSessionStore = ::rust::Box<ServerLoginSessionStore>;
+
+  const napi_type_tag kServerSetupHandleTag = {0x8d1f5c2e6a4b4f07, 0xb3a9e0c1d2f47586};
+  const napi_type_tag kKeyringTag = {0x5e0b7a3c9d214e68, 0xa41f2c8e6b9d0735};
+  const napi_type_tag kLoginSessionStoreTag = {0x2c6e9f1a4b7d4083, 0x9f3a5d0e7c1b6248};
+
+  // The key selected by the optional `keyId` of `params`, which can be
+  // nullptr for the active key.
+  std::shared_ptr<ServerSetup> selectServerSetupKey(napi_env env, const Keyring& keyring, napi_value params) {
+    auto keyIdProp = params ? getProperty(env, params, kNames.keyId) : undefined(env);
+    if (typeOf(env, keyIdProp) == napi_undefined) {
+      if (!keyring.active()) {
+        throw Error(kEmptyKeyringMessage);
+      }
+      return keyring.active();
+    }
+    auto keyId = asStringProp(env, params, kNames.keyId, keyIdProp);
+    auto setup = keyring.get(keyId);
+    if (!setup) {
+      throw Error(unknownServerSetupKeyMessage(keyId));
+    }
+    return setup;
+  }
+
+  // Accepts the base64 encoded server setup of `suite`, a handle created by
+  // createServerSetupHandle or a keyring, of which the key selected by
+  // `params` is used. The suite of a handle is checked by the Rust function
+  // it's passed to.
+  std::shared_ptr<ServerSetup> getServerSetup(napi_env env, napi_value value, napi_value params,
+    OpaqueCipherSuite suite) {
+    if (typeOf(env, value) == napi_string) {
+      return std::make_shared<ServerSetup>(opaque_create_server_setup_handle(toString(env, value), suite));
+    }
+    if (auto setup = asExternal<ServerSetup>(env, value, kServerSetupHandleTag)) {
+      return setup;
+    }
+    if (auto keyring = asExternal<Keyring>(env, value, kKeyringTag)) {
+      return selectServerSetupKey(env, *keyring, params);
+    }
+    throw Error(kInvalidServerSetupMessage);
+  }
+
+  std::shared_ptr<Keyring> getKeyring(napi_env env, napi_value value) {
+    auto keyring = asExternal<Keyring>(env, value, kKeyringTag);
+    if (!keyring) {
+      throw Error(kInvalidKeyringMessage);
+    }
+    return keyring;
+  }
+
+  std::shared_ptr<LoginSessionStore> getLoginSessionStore(napi_env env, napi_value value) {
+    auto store = asExternal<LoginSessionStore>(env, value, kLoginSessionStoreTag);
+    if (!store) {
+      throw Error(kInvalidSessionStoreMessage);
+    }
+    return store;
+  }
+
+  void rejectWithError(napi_env env, napi_deferred deferred, const std::string& message) {
+    napi_value messageValue;
+    napi_value error;
+    if (napi_create_string_utf8(env, message.data(), message.size(), &messageValue) == napi_ok
+      && napi_create_error(env, nullptr, messageValue, &error) == napi_ok) {
+      napi_reject_deferred(env, deferred, error);
+    }
+  }
+
+  // Runs `work` on the libuv threadpool and settles the returned promise on
+  // the JS thread, with `makeResult` or with the error thrown by `work`. The
+  // params have to be read into owned values beforehand, `work` must not
+  // touch any JS value.
+  template <typename Result>
+  napi_value runAsync(napi_env env, const char* name, std::function<Result()> work,
+    std::function<napi_value(napi_env, Result&)> makeResult) {
+    struct Call {
+      std::function<Result()> work;
+      std::function<napi_value(napi_env, Result&)> makeResult;
+      std::optional<Result> result;
+      std::string error;
+      napi_deferred deferred = nullptr;
+      napi_async_work asyncWork = nullptr;
+    };
+    auto call = std::make_unique<Call>();
+    call->work = std::move(work);
+    call->makeResult = std::move(makeResult);
+
+    napi_value promise;
+    check(env, napi_create_promise(env, &call->deferred, &promise));
+    napi_value resourceName;
+    check(env, napi_create_string_utf8(env, name, NAPI_AUTO_LENGTH, &resourceName));
+    check(env, napi_create_async_work(env, nullptr, resourceName,
+      [](napi_env env, void* data) {
+        auto call = static_cast<Call*>(data);
+        try {
+          call->result.emplace(call->work());
+        } catch (const std::exception& e) {
+          call->error = errorMessage(e);
+        }
+      },
+      [](napi_env env, napi_status status, void* data) {
+        std::unique_ptr<Call> call(static_cast<Call*>(data));
+        napi_delete_async_work(env, call->asyncWork);
+        if (status != napi_ok) {
+          rejectWithError(env, call->deferred, "opaque job was cancelled");
+        } else if (!call->result) {
+          rejectWithError(env, call->deferred, call->error);
+        } else {
+          try {
+            napi_resolve_deferred(env, call->deferred, call->makeResult(env, *call->result));
+          } catch (const std::exception& e) {
+            rejectWithError(env, call->deferred, errorMessage(e));
+          }
+        }
+      },
+      call.get(), &call->asyncWork));
+    check(env, napi_queue_async_work(env, call->asyncWork));
+    call.release();
+    return promise;
+  }
+
+  napi_value createServerSetup(napi_env env, napi_value* args) {
+    return makeString(env, opaque_create_server_setup(getCipherSuite(env, getParams(env, args[0]))));
+  }
+
+  napi_value createServerSetupHandle(napi_env env, napi_value* args) {
+    if (typeOf(env, args[0]) != napi_string) {
+      throw Error("serverSetup has invalid type, expected string but got " + kindToString(env, args[0]));
+    }
+    auto suite = getCipherSuite(env, getParams(env, args[1]));
+    return makeExternal(env, std::make_shared<ServerSetup>(
+      opaque_create_server_setup_handle(toString(env, args[0]), suite)), kServerSetupHandleTag);
+  }
+
+  napi_value getServerPublicKey(napi_env env, napi_value* args) {
+    auto params = getParams(env, args[1]);
+    auto suite = getCipherSuite(env, params);
+    auto setup = getServerSetup(env, args[0], params, suite);
+    opaque_check_server_setup_suite(**setup, suite);
+    return makeString(env, opaque_get_server_public_key_with_setup(**setup));
+  }
+
+  napi_value createServerRegistrationResponse(napi_env env, napi_value* args) {
+    ParamsReader in{env, asObject(env, args[0])};
+    auto params = readCreateServerRegistrationResponseParams(in);
+    auto setup = getServerSetup(env, getProperty(env, in.obj, kNames.serverSetup), in.obj, params.suite);
+    auto result = opaque_create_server_registration_response_with_setup(**setup, std::move(params));
+    return makeResult(env, result, writeCreateServerRegistrationResponseResult<ResultWriter>);
+  }
+
+  napi_value createServerRegistrationResponseAsync(napi_env env, napi_value* args) {
+    ParamsReader in{env, asObject(env, args[0])};
+    auto params = std::make_shared<OpaqueCreateServerRegistrationResponseParams>(
+      readCreateServerRegistrationResponseParams(in));
+    auto setup = getServerSetup(env, getProperty(env, in.obj, kNames.serverSetup), in.obj, params->suite);
+    return runAsync<OpaqueCreateServerRegistrationResponseResult>(env, "createServerRegistrationResponse",
+      [setup, params] { return opaque_create_server_registration_response_with_setup(**setup, std::move(*params)); },
+      [](napi_env env, OpaqueCreateServerRegistrationResponseResult& result) {
+        return makeResult(env, result, writeCreateServerRegistrationResponseResult<ResultWriter>);
+      });
+  }
+
+  napi_value startServerLogin(napi_env env, napi_value* args) {
+    ParamsReader in{env, asObject(env, args[0])};
+    auto params = readStartServerLoginParams(in);
+    auto setup = getServerSetup(env, getProperty(env, in.obj, kNames.serverSetup), in.obj, params.suite);
+    auto result = opaque_start_server_login_with_setup(**setup, std::move(params));
+    return makeResult(env, result, writeStartServerLoginResult<ResultWriter>);
+  }
+
+  napi_value startServerLoginAsync(napi_env env, napi_value* args) {
+    ParamsReader in{env, asObject(env, args[0])};
+    auto params = std::make_shared<OpaqueStartServerLoginParams>(readStartServerLoginParams(in));
+    auto setup = getServerSetup(env, getProperty(env, in.obj, kNames.serverSetup), in.obj, params->suite);
+    return runAsync<OpaqueStartServerLoginResult>(env, "startServerLogin",
+      [setup, params] { return opaque_start_server_login_with_setup(**setup, std::move(*params)); },
+      [](napi_env env, OpaqueStartServerLoginResult& result) {
+        return makeResult(env, result, writeStartServerLoginResult<ResultWriter>);
+      });
+  }
+
+  // The requests of startServerLoginBatch, read on the JS thread. Invalid
+  // ones don't fail the batch, their entry holds the error code and message.
+  struct LoginBatch {
+    std::shared_ptr<ServerSetup> setup;
+    uint32_t count = 0;
+    ::rust::Vec<OpaqueStartServerLoginParams> params;
+    std::vector<uint32_t> paramIndices;
+    std::vector<std::pair<uint32_t, std::string>> errors;
+  };
+
+  LoginBatch readLoginBatch(napi_env env, napi_value* args) {
+    LoginBatch batch;
+    auto params = getParams(env, args[2]);
+    auto suite = getCipherSuite(env, params);
+    batch.setup = getServerSetup(env, args[0], params, suite);
+    opaque_check_server_setup_suite(**batch.setup, suite);
+    bool isArray;
+    check(env, napi_is_array(env, args[1], &isArray));
+    if (!isArray) {
+      throw Error(kInvalidRequestsMessage);
+    }
+    check(env, napi_get_array_length(env, args[1], &batch.count));
+    batch.params.reserve(batch.count);
+    batch.paramIndices.reserve(batch.count);
+    for (uint32_t i = 0; i < batch.count; i++) {
+      try {
+        napi_value request;
+        check(env, napi_get_element(env, args[1], i, &request));
+        ParamsReader in{env, asObject(env, request)};
+        batch.params.push_back(readStartServerLoginParams(in));
+        batch.paramIndices.push_back(i);
+      } catch (const Error& e) {
+        batch.errors.emplace_back(i, e.what());
+      }
+    }
+    return batch;
+  }
+
+  napi_value makeLoginBatchResult(napi_env env, const LoginBatch& batch,
+    const ::rust::Vec<OpaqueStartServerLoginBatchResult>& results) {
+    napi_value ret;
+    check(env, napi_create_array_with_length(env, batch.count, &ret));
+    for (const auto& [i, message] : batch.errors) {
+      auto entry = makeObject(env);
+      setProperty(env, entry, kNames.error, makeString(env, std::string(errorCodeName(OpaqueErrorCode::Input))));
+      setProperty(env, entry, kNames.message, makeString(env, message));
+      check(env, napi_set_element(env, ret, i, entry));
+    }
+    for (size_t j = 0; j < results.size(); j++) {
+      check(env, napi_set_element(env, ret, batch.paramIndices[j],
+        makeResult(env, results[j], writeStartServerLoginBatchResult<ResultWriter>)));
+    }
+    return ret;
+  }
+
+  // Starts the logins for all requests at once, spread across the available
+  // cores. The third argument holds the suite of a server setup string or
+  // the key ID of a keyring.
+  napi_value startServerLoginBatch(napi_env env, napi_value* args) {
+    auto batch = readLoginBatch(env, args);
+    auto results = opaque_start_server_login_batch(**batch.setup, std::move(batch.params));
+    return makeLoginBatchResult(env, batch, results);
+  }
+
+  napi_value startServerLoginBatchAsync(napi_env env, napi_value* args) {
+    auto batch = std::make_shared<LoginBatch>(readLoginBatch(env, args));
+    return runAsync<::rust::Vec<OpaqueStartServerLoginBatchResult>>(env, "startServerLoginBatch",
+      [batch] { return opaque_start_server_login_batch(**batch->setup, std::move(batch->params)); },
+      [batch](napi_env env, ::rust::Vec<OpaqueStartServerLoginBatchResult>& results) {
+        return makeLoginBatchResult(env, *batch, results);
+      });
+  }
+
+  napi_value finishServerLogin(napi_env env, napi_value* args) {
+    ParamsReader in{env, asObject(env, args[0])};
+    auto result = opaque_finish_server_login(readFinishServerLoginParams(in));
+    return makeResult(env, result, writeFinishServerLoginResult<ResultWriter>);
+  }
+
+  napi_value finishServerLoginAsync(napi_env env, napi_value* args) {
+    ParamsReader in{env, asObject(env, args[0])};
+    auto params = std::make_shared<OpaqueFinishServerLoginParams>(readFinishServerLoginParams(in));
+    return runAsync<OpaqueFinishServerLoginResult>(env, "finishServerLogin",
+      [params] { return opaque_finish_server_login(std::move(*params)); },
+      [](napi_env env, OpaqueFinishServerLoginResult& result) {
+        return makeResult(env, result, writeFinishServerLoginResult<ResultWriter>);
+      });
+  }
+
+  // Keeps the server login states between startServerLoginSession and
+  // finishServerLoginSession in native memory, see rust/src/sessions.rs.
+  napi_value createServerLoginSessionStore(napi_env env, napi_value* args) {
+    auto params = getParams(env, args[0]);
+    auto ttlMs = params && typeOf(env, getProperty(env, params, kNames.ttlMs)) != napi_undefined
+      ? getUint32Prop(env, params, kNames.ttlMs) : kDefaultLoginSessionTtlMs;
+    auto maxMemoryBytes = params && typeOf(env, getProperty(env, params, kNames.maxMemoryBytes)) != napi_undefined
+      ? getNumberProp(env, params, kNames.maxMemoryBytes) : kDefaultLoginSessionMaxMemoryBytes;
+    if (!(maxMemoryBytes >= 0 && maxMemoryBytes <= static_cast<double>(SIZE_MAX))) {
+      throw Error(kMaxMemoryBytesOutOfRangeMessage);
+    }
+    auto store = opaque_create_server_login_session_store(ttlMs, static_cast<size_t>(maxMemoryBytes));
+    return makeExternal(env, std::make_shared<LoginSessionStore>(std::move(store)), kLoginSessionStoreTag);
+  }
+
+  napi_value getServerLoginSessionCount(napi_env env, napi_value* args) {
+    return makeNumber(env, static_cast<double>(opaque_server_login_session_count(**getLoginSessionStore(env, args[0]))));
+  }
+
+  // The params of startServerLoginSession, read on the JS thread.
+  struct LoginSessionStart {
+    std::shared_ptr<LoginSessionStore> store;
+    std::shared_ptr<ServerSetup> setup;
+    OpaqueStartServerLoginParams params;
+  };
+
+  LoginSessionStart readLoginSessionStart(napi_env env, napi_value* args) {
+    ParamsReader in{env, asObject(env, args[0])};
+    auto store = getLoginSessionStore(env, getProperty(env, in.obj, kNames.sessionStore));
+    auto params = readStartServerLoginParams(in);
+    auto setup = getServerSetup(env, getProperty(env, in.obj, kNames.serverSetup), in.obj, params.suite);
+    return {std::move(store), std::move(setup), std::move(params)};
+  }
+
+  napi_value startServerLoginSession(napi_env env, napi_value* args) {
+    auto start = readLoginSessionStart(env, args);
+    auto result = opaque_start_server_login_session(**start.store, **start.setup, std::move(start.params));
+    return makeResult(env, result, writeStartServerLoginSessionResult<ResultWriter>);
+  }
+
+  napi_value startServerLoginSessionAsync(napi_env env, napi_value* args) {
+    auto start = std::make_shared<LoginSessionStart>(readLoginSessionStart(env, args));
+    return runAsync<OpaqueStartServerLoginSessionResult>(env, "startServerLoginSession",
+      [start] { return opaque_start_server_login_session(**start->store, **start->setup, std::move(start->params)); },
+      [](napi_env env, OpaqueStartServerLoginSessionResult& result) {
+        return makeResult(env, result, writeStartServerLoginSessionResult<ResultWriter>);
+      });
+  }
+
+  napi_value finishServerLoginSession(napi_env env, napi_value* args) {
+    auto obj = asObject(env, args[0]);
+    auto store = getLoginSessionStore(env, getProperty(env, obj, kNames.sessionStore));
+    auto sessionHandle = getStringProp(env, obj, kNames.sessionHandle);
+    auto finishLoginRequest = getStringProp(env, obj, kNames.finishLoginRequest);
+    auto result = opaque_finish_server_login_session(**store, sessionHandle, finishLoginRequest);
+    return makeResult(env, result, writeFinishServerLoginResult<ResultWriter>);
+  }
+
+  napi_value createServerSetupKeyring(napi_env env, napi_value* args) {
+    return makeExternal(env, std::make_shared<Keyring>(), kKeyringTag);
+  }
+
+  // Adds the server setup (base64 string or handle) under `keyId`, see
+  // ServerSetupKeyring.
+  napi_value addServerSetupKey(napi_env env, napi_value* args) {
+    auto obj = asObject(env, args[0]);
+    auto keyring = getKeyring(env, getProperty(env, obj, kNames.keyring));
+    auto keyId = getStringProp(env, obj, kNames.keyId);
+    auto suite = getCipherSuite(env, obj);
+    auto serverSetupProp = getProperty(env, obj, kNames.serverSetup);
+    std::shared_ptr<ServerSetup> setup;
+    if (typeOf(env, serverSetupProp) == napi_string) {
+      setup = std::make_shared<ServerSetup>(opaque_create_server_setup_handle(toString(env, serverSetupProp), suite));
+    } else {
+      setup = asExternal<ServerSetup>(env, serverSetupProp, kServerSetupHandleTag);
+      if (!setup) {
+        throw Error(invalidTypeMessage(kNames.serverSetup, "string or server setup handle",
+          kindToString(env, serverSetupProp)));
+      }
+      opaque_check_server_setup_suite(**setup, suite);
+    }
+    if (!keyring->add(keyId, std::move(setup))) {
+      throw Error(duplicateServerSetupKeyMessage(keyId));
+    }
+    return undefined(env);
+  }
+
+  napi_value setActiveServerSetupKey(napi_env env, napi_value* args) {
+    auto obj = asObject(env, args[0]);
+    auto keyring = getKeyring(env, getProperty(env, obj, kNames.keyring));
+    auto keyId = getStringProp(env, obj, kNames.keyId);
+    if (!keyring->setActive(keyId)) {
+      throw Error(unknownServerSetupKeyMessage(keyId));
+    }
+    return undefined(env);
+  }
+
+  napi_value removeServerSetupKey(napi_env env, napi_value* args) {
+    auto obj = asObject(env, args[0]);
+    auto keyring = getKeyring(env, getProperty(env, obj, kNames.keyring));
+    auto keyId = getStringProp(env, obj, kNames.keyId);
+    if (keyring->active() && keyId == keyring->activeKeyId()) {
+      throw Error(kRemoveActiveKeyMessage);
+    }
+    return makeBoolean(env, keyring->remove(keyId));
+  }
+
+  napi_value getServerSetupKeys(napi_env env, napi_value* args) {
+    auto keyring = getKeyring(env, args[0]);
+    napi_value keyIds;
+    check(env, napi_create_array_with_length(env, keyring->keys().size(), &keyIds));
+    uint32_t i = 0;
+    for (const auto& [keyId, setup] : keyring->keys()) {
+      check(env, napi_set_element(env, keyIds, i++, makeString(env, keyId)));
+    }
+    auto result = makeObject(env);
+    if (keyring->active()) {
+      setProperty(env, result, kNames.activeKeyId, makeString(env, keyring->activeKeyId()));
+    }
+    setProperty(env, result, kNames.keyIds, keyIds);
+    return result;
+  }
+
+  napi_value startClientRegistration(napi_env env, napi_value* args) {
+    ParamsReader in{env, asObject(env, args[0])};
+    auto result = opaque_start_client_registration(readStartClientRegistrationParams(in));
+    return makeResult(env, result, writeStartClientRegistrationResult<ResultWriter>);
+  }
+
+  napi_value finishClientRegistration(napi_env env, napi_value* args) {
+    ParamsReader in{env, asObject(env, args[0])};
+    auto result = opaque_finish_client_registration(readFinishClientRegistrationParams(in));
+    return makeResult(env, result, writeFinishClientRegistrationResult<ResultWriter>);
+  }
+
+  napi_value finishClientRegistrationAsync(napi_env env, napi_value* args) {
+    ParamsReader in{env, asObject(env, args[0])};
+    auto params = std::make_shared<OpaqueFinishClientRegistrationParams>(readFinishClientRegistrationParams(in));
+    return runAsync<OpaqueFinishClientRegistrationResult>(env, "finishClientRegistration",
+      [params] { return opaque_finish_client_registration(std::move(*params)); },
+      [](napi_env env, OpaqueFinishClientRegistrationResult& result) {
+        return makeResult(env, result, writeFinishClientRegistrationResult<ResultWriter>);
+      });
+  }
+
+  napi_value startClientLogin(napi_env env, napi_value* args) {
+    ParamsReader in{env, asObject(env, args[0])};
+    auto result = opaque_start_client_login(readStartClientLoginParams(in));
+    return makeResult(env, result, writeStartClientLoginResult<ResultWriter>);
+  }
+
+  // Undefined if the login failed, like the JSI module.
+  napi_value makeFinishClientLoginResult(napi_env env, std::unique_ptr<OpaqueFinishClientLoginResult>& result) {
+    if (!result) {
+      return undefined(env);
+    }
+    return makeResult(env, *result, writeFinishClientLoginResult<ResultWriter>);
+  }
+
+  napi_value finishClientLogin(napi_env env, napi_value* args) {
+    ParamsReader in{env, asObject(env, args[0])};
+    auto result = opaque_finish_client_login(readFinishClientLoginParams(in));
+    return makeFinishClientLoginResult(env, result);
+  }
+
+  napi_value finishClientLoginAsync(napi_env env, napi_value* args) {
+    ParamsReader in{env, asObject(env, args[0])};
+    auto params = std::make_shared<OpaqueFinishClientLoginParams>(readFinishClientLoginParams(in));
+    return runAsync<std::unique_ptr<OpaqueFinishClientLoginResult>>(env, "finishClientLogin",
+      [params] { return opaque_finish_client_login(std::move(*params)); },
+      makeFinishClientLoginResult);
+  }
+
+  using Func = napi_value (*)(napi_env, napi_value*);
+
+  // Checks the number of arguments and turns the C++ exceptions, including
+  // the errors returned from Rust, into JS exceptions. The last
+  // `OptionalCount` arguments can be left out and are undefined then.
+  template <size_t ParamCount, Func func, size_t OptionalCount = 0>
+  napi_value wrap(napi_env env, napi_callback_info info) {
+    size_t argc = ParamCount;
+    napi_value args[ParamCount > 0 ? ParamCount : 1];
+    try {
+      check(env, napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+      if (argc > ParamCount || argc + OptionalCount < ParamCount) {
+        throw Error("invalid number of arguments");
+      }
+      return func(env, args);
+    } catch (const std::exception& e) {
+      bool pending = false;
+      napi_is_exception_pending(env, &pending);
+      if (!pending) {
+        napi_throw_error(env, nullptr, errorMessage(e).c_str());
+      }
+      return nullptr;
+    }
+  }
+
+  template <size_t ParamCount, Func func, size_t OptionalCount = 0>
+  napi_property_descriptor method(const char* name) {
+    return {
+      name, nullptr, wrap<ParamCount, func, OptionalCount>, nullptr, nullptr, nullptr, napi_enumerable, nullptr,
+    };
+  }
+
+  napi_value init(napi_env env, napi_value exports) {
+    const napi_property_descriptor methods[] = {
+      method<1, createServerSetup, 1>("createServerSetup"),
+      method<2, createServerSetupHandle, 1>("createServerSetupHandle"),
+      method<2, getServerPublicKey, 1>("getServerPublicKey"),
+      method<1, createServerRegistrationResponse>("createServerRegistrationResponse"),
+      method<1, createServerRegistrationResponseAsync>("createServerRegistrationResponseAsync"),
+      method<1, startServerLogin>("startServerLogin"),
+      method<1, startServerLoginAsync>("startServerLoginAsync"),
+      method<3, startServerLoginBatch, 1>("startServerLoginBatch"),
+      method<3, startServerLoginBatchAsync, 1>("startServerLoginBatchAsync"),
+      method<1, finishServerLogin>("finishServerLogin"),
+      method<1, finishServerLoginAsync>("finishServerLoginAsync"),
+      method<1, createServerLoginSessionStore, 1>("createServerLoginSessionStore"),
+      method<1, getServerLoginSessionCount>("getServerLoginSessionCount"),
+      method<1, startServerLoginSession>("startServerLoginSession"),
+      method<1, startServerLoginSessionAsync>("startServerLoginSessionAsync"),
+      method<1, finishServerLoginSession>("finishServerLoginSession"),
+      method<0, createServerSetupKeyring>("createServerSetupKeyring"),
+      method<1, addServerSetupKey>("addServerSetupKey"),
+      method<1, setActiveServerSetupKey>("setActiveServerSetupKey"),
+      method<1, removeServerSetupKey>("removeServerSetupKey"),
+      method<1, getServerSetupKeys>("getServerSetupKeys"),
+
+      method<1, startClientRegistration>("startClientRegistration"),
+      method<1, finishClientRegistration>("finishClientRegistration"),
+      method<1, finishClientRegistrationAsync>("finishClientRegistrationAsync"),
+      method<1, startClientLogin>("startClientLogin"),
+      method<1, finishClientLogin>("finishClientLogin"),
+      method<1, finishClientLoginAsync>("finishClientLoginAsync"),
+    };
+    check(env, napi_define_properties(env, exports, sizeof(methods) / sizeof(methods[0]), methods));
+    return exports;
+  }
+}  // namespace NativeOpaque::Node
+
+// Context aware, the addon can be loaded by several worker threads.
+NAPI_MODULE_INIT() {
+  try {
+    return NativeOpaque::Node::init(env, exports);
+  } catch (const std::exception& e) {
+    napi_throw_error(env, nullptr, e.what());
+    return nullptr;
+  }
+}
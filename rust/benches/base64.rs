@@ -0,0 +1,49 @@
+//! Compares the constant-time codec of `src/codec.rs` with the
+//! `URL_SAFE_NO_PAD` engine of the `base64` crate used before, at the sizes
+//! of the messages of the default cipher suite: registration request, keys,
+//! start login request, registration record and login response.
+//!
+//! Run with `cargo bench --bench base64`.
+
+use base64::{engine::general_purpose::URL_SAFE_NO_PAD, Engine as _};
+use criterion::{black_box, criterion_group, criterion_main, BenchmarkId, Criterion, Throughput};
+use opaque_rust::codec;
+
+const SIZES: [usize; 5] = [32, 64, 96, 192, 320];
+
+fn message(len: usize) -> Vec<u8> {
+    (0..len).map(|i| (i * 151 + 7) as u8).collect()
+}
+
+fn bench_encode(c: &mut Criterion) {
+    let mut group = c.benchmark_group("base64/encode");
+    for len in SIZES {
+        let bytes = message(len);
+        group.throughput(Throughput::Bytes(len as u64));
+        group.bench_with_input(BenchmarkId::new("codec", len), &bytes, |b, bytes| {
+            b.iter(|| codec::encode(black_box(bytes)))
+        });
+        group.bench_with_input(BenchmarkId::new("base64", len), &bytes, |b, bytes| {
+            b.iter(|| URL_SAFE_NO_PAD.encode(black_box(bytes)))
+        });
+    }
+    group.finish();
+}
+
+fn bench_decode(c: &mut Criterion) {
+    let mut group = c.benchmark_group("base64/decode");
+    for len in SIZES {
+        let encoded = codec::encode(message(len));
+        group.throughput(Throughput::Bytes(len as u64));
+        group.bench_with_input(BenchmarkId::new("codec", len), &encoded, |b, encoded| {
+            b.iter(|| codec::decode(black_box(encoded)).unwrap())
+        });
+        group.bench_with_input(BenchmarkId::new("base64", len), &encoded, |b, encoded| {
+            b.iter(|| URL_SAFE_NO_PAD.decode(black_box(encoded)).unwrap())
+        });
+    }
+    group.finish();
+}
+
+criterion_group!(benches, bench_encode, bench_decode);
+criterion_main!(benches);
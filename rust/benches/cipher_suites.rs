@@ -0,0 +1,169 @@
+//! Compares the server login throughput of the cipher suites compiled into
+//! the build. Both suites are only compiled in with the `p256-suite` feature:
+//!
+//! ```bash
+//! cargo bench --bench cipher_suites --features p256-suite
+//! ```
+
+use criterion::{criterion_group, criterion_main, BatchSize, BenchmarkId, Criterion, Throughput};
+use opaque_rust::opaque_ffi::{
+    OpaqueCipherSuite, OpaqueCreateServerRegistrationResponseParams, OpaqueFinishClientLoginParams,
+    OpaqueFinishClientRegistrationParams, OpaqueFinishServerLoginParams, OpaqueKeyStretchingParams,
+    OpaqueStartClientLoginParams, OpaqueStartClientRegistrationParams,
+    OpaqueStartServerLoginParams,
+};
+use opaque_rust::*;
+
+const USER_IDENTIFIER: &str = "user123";
+const PASSWORD: &str = "hunter42";
+
+// The key stretching only runs on the client, keep its setup cheap.
+const KEY_STRETCHING: OpaqueKeyStretchingParams = OpaqueKeyStretchingParams {
+    memory_cost: 8,
+    iterations: 1,
+    parallelism: 1,
+};
+
+fn suites() -> Vec<(&'static str, OpaqueCipherSuite)> {
+    let mut suites = vec![("ristretto255", OpaqueCipherSuite::Ristretto255)];
+    if cfg!(feature = "p256-suite") {
+        suites.push(("p256", OpaqueCipherSuite::P256));
+    }
+    suites
+}
+
+fn register(server_setup: &ServerSetupHandle, suite: OpaqueCipherSuite) -> String {
+    let start = opaque_start_client_registration(OpaqueStartClientRegistrationParams {
+        password: PASSWORD.to_string(),
+        suite,
+    })
+    .unwrap();
+    let response = opaque_create_server_registration_response_with_setup(
+        server_setup,
+        OpaqueCreateServerRegistrationResponseParams {
+            user_identifier: USER_IDENTIFIER.to_string(),
+            registration_request: start.registration_request,
+            suite,
+        },
+    )
+    .unwrap();
+    opaque_finish_client_registration(OpaqueFinishClientRegistrationParams {
+        password: PASSWORD.to_string(),
+        registration_response: response.registration_response,
+        client_registration_state: start.client_registration_state,
+        client_identifier: vec![],
+        server_identifier: vec![],
+        key_stretching: vec![KEY_STRETCHING],
+        suite,
+    })
+    .unwrap()
+    .registration_record
+}
+
+/// A registered user and the messages of one login, per suite.
+struct Login {
+    name: &'static str,
+    suite: OpaqueCipherSuite,
+    handle: Box<ServerSetupHandle>,
+    start_params: OpaqueStartServerLoginParams,
+    finish_params: OpaqueFinishServerLoginParams,
+}
+
+fn login(name: &'static str, suite: OpaqueCipherSuite) -> Login {
+    let server_setup = opaque_create_server_setup(suite).unwrap();
+    let handle = opaque_create_server_setup_handle(server_setup, suite).unwrap();
+    let registration_record = register(&handle, suite);
+    let client_start = opaque_start_client_login(OpaqueStartClientLoginParams {
+        password: PASSWORD.to_string(),
+        suite,
+    })
+    .unwrap();
+    let start_params = OpaqueStartServerLoginParams {
+        registration_record: vec![registration_record],
+        start_login_request: client_start.start_login_request,
+        user_identifier: USER_IDENTIFIER.to_string(),
+        client_identifier: vec![],
+        server_identifier: vec![],
+        suite,
+    };
+    let server_start =
+        opaque_start_server_login_with_setup(&handle, clone_params(&start_params)).unwrap();
+    let client_finish = opaque_finish_client_login(OpaqueFinishClientLoginParams {
+        client_login_state: client_start.client_login_state,
+        login_response: server_start.login_response,
+        password: PASSWORD.to_string(),
+        client_identifier: vec![],
+        server_identifier: vec![],
+        key_stretching: vec![KEY_STRETCHING],
+        suite,
+    })
+    .unwrap();
+    let finish_params = OpaqueFinishServerLoginParams {
+        server_login_state: server_start.server_login_state,
+        finish_login_request: client_finish
+            .as_ref()
+            .expect("login failed")
+            .finish_login_request
+            .clone(),
+        suite,
+    };
+    Login {
+        name,
+        suite,
+        handle,
+        start_params,
+        finish_params,
+    }
+}
+
+fn clone_params(params: &OpaqueStartServerLoginParams) -> OpaqueStartServerLoginParams {
+    OpaqueStartServerLoginParams {
+        registration_record: params.registration_record.clone(),
+        start_login_request: params.start_login_request.clone(),
+        user_identifier: params.user_identifier.clone(),
+        client_identifier: vec![],
+        server_identifier: vec![],
+        suite: params.suite,
+    }
+}
+
+fn bench_server_login(c: &mut Criterion) {
+    let logins: Vec<_> = suites()
+        .into_iter()
+        .map(|(name, suite)| login(name, suite))
+        .collect();
+
+    let mut group = c.benchmark_group("startServerLogin");
+    group.throughput(Throughput::Elements(1));
+    for login in &logins {
+        group.bench_function(BenchmarkId::from_parameter(login.name), |b| {
+            b.iter_batched(
+                || clone_params(&login.start_params),
+                |params| opaque_start_server_login_with_setup(&login.handle, params).unwrap(),
+                BatchSize::SmallInput,
+            )
+        });
+    }
+    group.finish();
+
+    // the serialized server login state can be finished any number of times
+    let mut group = c.benchmark_group("finishServerLogin");
+    group.throughput(Throughput::Elements(1));
+    for login in &logins {
+        group.bench_function(BenchmarkId::from_parameter(login.name), |b| {
+            b.iter_batched(
+                || OpaqueFinishServerLoginParams {
+                    server_login_state: login.finish_params.server_login_state.clone(),
+                    finish_login_request: login.finish_params.finish_login_request.clone(),
+                    suite: login.suite,
+                },
+                |params| opaque_finish_server_login(params).unwrap(),
+                BatchSize::SmallInput,
+            )
+        });
+    }
+    group.finish();
+}
+
+criterion_group!(benches, bench_server_login);
+criterion_main!(benches);
@@ -0,0 +1,38 @@
+//! Compares multiplying the Ristretto255 base point using the precomputed
+//! table of the `precomputed-tables` feature with the variable base
+//! multiplication used without it. Every server login multiplies the base
+//! point once for its ephemeral key, every client login twice.
+//!
+//! For the per login cost compare
+//! `cargo bench --bench server_setup -- startServerLogin` with the same
+//! command and `--no-default-features`.
+//!
+//! Run with `cargo bench --bench fixed_base`.
+
+use criterion::{black_box, criterion_group, criterion_main, Criterion};
+use curve25519_dalek::constants::RISTRETTO_BASEPOINT_POINT;
+use curve25519_dalek::ristretto::RistrettoPoint;
+use curve25519_dalek::scalar::Scalar;
+use rand::rngs::OsRng;
+use rand::RngCore;
+
+fn random_scalar() -> Scalar {
+    let mut bytes = [0; 32];
+    OsRng.fill_bytes(&mut bytes);
+    Scalar::from_bytes_mod_order(bytes)
+}
+
+fn bench_base_mul(c: &mut Criterion) {
+    let scalar = random_scalar();
+    let mut group = c.benchmark_group("ristretto255BaseMul");
+    group.bench_function("table", |b| {
+        b.iter(|| RistrettoPoint::mul_base(black_box(&scalar)))
+    });
+    group.bench_function("variable", |b| {
+        b.iter(|| black_box(RISTRETTO_BASEPOINT_POINT) * black_box(scalar))
+    });
+    group.finish();
+}
+
+criterion_group!(benches, bench_base_mul);
+criterion_main!(benches);
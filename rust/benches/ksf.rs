@@ -0,0 +1,107 @@
+//! Compares the wall-clock latency of `finishClientLogin` with the key
+//! stretching split into several lanes, which are computed in parallel, with
+//! the single lane default. All variants use the same memory and iterations.
+//!
+//! Run with `cargo bench --bench ksf`.
+
+use criterion::{criterion_group, criterion_main, BenchmarkId, Criterion};
+use opaque_rust::opaque_ffi::{
+    OpaqueCipherSuite, OpaqueCreateServerRegistrationResponseParams, OpaqueFinishClientLoginParams,
+    OpaqueFinishClientRegistrationParams, OpaqueKeyStretchingParams, OpaqueStartClientLoginParams,
+    OpaqueStartClientRegistrationParams, OpaqueStartServerLoginParams,
+};
+use opaque_rust::*;
+
+const USER_IDENTIFIER: &str = "user123";
+const PASSWORD: &str = "hunter42";
+
+fn register(server_setup: &str, key_stretching: OpaqueKeyStretchingParams) -> String {
+    let start = opaque_start_client_registration(OpaqueStartClientRegistrationParams {
+        password: PASSWORD.to_string(),
+        suite: OpaqueCipherSuite::Default,
+    })
+    .unwrap();
+    let response = opaque_create_server_registration_response(
+        server_setup.to_string(),
+        OpaqueCreateServerRegistrationResponseParams {
+            user_identifier: USER_IDENTIFIER.to_string(),
+            registration_request: start.registration_request,
+            suite: OpaqueCipherSuite::Default,
+        },
+    )
+    .unwrap();
+    opaque_finish_client_registration(OpaqueFinishClientRegistrationParams {
+        password: PASSWORD.to_string(),
+        registration_response: response.registration_response,
+        client_registration_state: start.client_registration_state,
+        client_identifier: vec![],
+        server_identifier: vec![],
+        key_stretching: vec![key_stretching],
+        suite: OpaqueCipherSuite::Default,
+    })
+    .unwrap()
+    .registration_record
+}
+
+fn bench_ksf(c: &mut Criterion) {
+    let topology = opaque_get_cpu_topology();
+    println!(
+        "{} cores, {} performance cores",
+        topology.cores, topology.performance_cores
+    );
+
+    let server_setup = opaque_create_server_setup(OpaqueCipherSuite::Default).unwrap();
+    let mut lanes = vec![1, 2, 4, topology.performance_cores];
+    lanes.sort_unstable();
+    lanes.dedup();
+
+    let mut group = c.benchmark_group("finishClientLogin");
+    group.sample_size(20);
+    for parallelism in lanes {
+        let key_stretching = OpaqueKeyStretchingParams {
+            memory_cost: 19 * 1024,
+            iterations: 2,
+            parallelism,
+        };
+        let registration_record = register(&server_setup, key_stretching);
+        let start = opaque_start_client_login(OpaqueStartClientLoginParams {
+            password: PASSWORD.to_string(),
+            suite: OpaqueCipherSuite::Default,
+        })
+        .unwrap();
+        let login_response = opaque_start_server_login(
+            server_setup.clone(),
+            OpaqueStartServerLoginParams {
+                registration_record: vec![registration_record],
+                start_login_request: start.start_login_request,
+                user_identifier: USER_IDENTIFIER.to_string(),
+                client_identifier: vec![],
+                server_identifier: vec![],
+                suite: OpaqueCipherSuite::Default,
+            },
+        )
+        .unwrap()
+        .login_response;
+
+        group.bench_function(BenchmarkId::new("lanes", parallelism), |b| {
+            b.iter(|| {
+                let result = opaque_finish_client_login(OpaqueFinishClientLoginParams {
+                    client_login_state: start.client_login_state.clone(),
+                    login_response: login_response.clone(),
+                    password: PASSWORD.to_string(),
+                    client_identifier: vec![],
+                    server_identifier: vec![],
+                    key_stretching: vec![key_stretching],
+                    suite: OpaqueCipherSuite::Default,
+                })
+                .unwrap();
+                assert!(!result.is_null(), "login failed");
+                result
+            })
+        });
+    }
+    group.finish();
+}
+
+criterion_group!(benches, bench_ksf);
+criterion_main!(benches);
@@ -0,0 +1,115 @@
+//! Compares the thread-local ChaCha20 generator of the `chacha-rng` feature
+//! with drawing from the OS on every call.
+//!
+//! The `rng` group draws from both generators directly. The server login
+//! benchmarks run with the generator selected at build time, compare the two
+//! builds with a criterion baseline:
+//!
+//! ```bash
+//! cargo bench --bench rng -- --save-baseline os-rng
+//! cargo bench --bench rng --features chacha-rng -- --baseline os-rng
+//! ```
+
+use criterion::{black_box, criterion_group, criterion_main, BatchSize, Criterion, Throughput};
+use opaque_ke::rand::rngs::OsRng;
+use opaque_ke::rand::RngCore;
+use opaque_rust::opaque_ffi::{
+    OpaqueCipherSuite, OpaqueCreateServerRegistrationResponseParams,
+    OpaqueFinishClientRegistrationParams, OpaqueStartClientLoginParams,
+    OpaqueStartClientRegistrationParams, OpaqueStartServerLoginParams,
+};
+use opaque_rust::*;
+
+const USER_IDENTIFIER: &str = "user123";
+const PASSWORD: &str = "hunter42";
+
+fn register(server_setup: &str) -> String {
+    let start = opaque_start_client_registration(OpaqueStartClientRegistrationParams {
+        password: PASSWORD.to_string(),
+        suite: OpaqueCipherSuite::Default,
+    })
+    .unwrap();
+    let response = opaque_create_server_registration_response(
+        server_setup.to_string(),
+        OpaqueCreateServerRegistrationResponseParams {
+            user_identifier: USER_IDENTIFIER.to_string(),
+            registration_request: start.registration_request,
+            suite: OpaqueCipherSuite::Default,
+        },
+    )
+    .unwrap();
+    opaque_finish_client_registration(OpaqueFinishClientRegistrationParams {
+        password: PASSWORD.to_string(),
+        registration_response: response.registration_response,
+        client_registration_state: start.client_registration_state,
+        client_identifier: vec![],
+        server_identifier: vec![],
+        key_stretching: vec![],
+        suite: OpaqueCipherSuite::Default,
+    })
+    .unwrap()
+    .registration_record
+}
+
+fn bench_draws(c: &mut Criterion) {
+    // a scalar and a nonce, the size of the draws made by the protocol
+    let mut group = c.benchmark_group("rng");
+    group.throughput(Throughput::Bytes(32));
+    group.bench_function("os", |b| {
+        let mut bytes = [0; 32];
+        b.iter(|| OsRng.fill_bytes(black_box(&mut bytes)))
+    });
+    #[cfg(feature = "chacha-rng")]
+    group.bench_function("chacha", |b| {
+        let mut bytes = [0; 32];
+        let mut rng = rng::ThreadChaChaRng::default();
+        b.iter(|| rng.fill_bytes(black_box(&mut bytes)))
+    });
+    group.finish();
+}
+
+fn bench_server_login(c: &mut Criterion) {
+    let server_setup = opaque_create_server_setup(OpaqueCipherSuite::Default).unwrap();
+    let handle =
+        opaque_create_server_setup_handle(server_setup.clone(), OpaqueCipherSuite::Default)
+            .unwrap();
+    let registration_record = register(&server_setup);
+    let start_login_request = opaque_start_client_login(OpaqueStartClientLoginParams {
+        password: PASSWORD.to_string(),
+        suite: OpaqueCipherSuite::Default,
+    })
+    .unwrap()
+    .start_login_request;
+    let params = || OpaqueStartServerLoginParams {
+        registration_record: vec![registration_record.clone()],
+        start_login_request: start_login_request.clone(),
+        user_identifier: USER_IDENTIFIER.to_string(),
+        client_identifier: vec![],
+        server_identifier: vec![],
+        suite: OpaqueCipherSuite::Default,
+    };
+
+    c.bench_function("startServerLogin", |b| {
+        b.iter_batched(
+            params,
+            |params| opaque_start_server_login_with_setup(&handle, params).unwrap(),
+            BatchSize::SmallInput,
+        )
+    });
+
+    // every worker thread of the batch draws from a generator of its own
+    const BATCH_SIZE: usize = 64;
+    let mut group = c.benchmark_group("startServerLoginBatch");
+    group.throughput(Throughput::Elements(BATCH_SIZE as u64));
+    group.bench_function("batch", |b| {
+        b.iter_batched(
+            || (0..BATCH_SIZE).map(|_| params()).collect::<Vec<_>>(),
+            |requests| opaque_start_server_login_batch(&handle, requests),
+            BatchSize::SmallInput,
+        )
+    });
+    group.finish();
+}
+
+criterion_group!(benches, bench_draws, bench_server_login);
+criterion_main!(benches);
@@ -0,0 +1,176 @@
+//! Compares the server functions taking the base64 encoded server setup with
+//! the ones using a pre-decoded `ServerSetupHandle`, and the batched server
+//! login with starting the logins one by one.
+//!
+//! Run with `cargo bench --bench server_setup`.
+
+use criterion::{black_box, criterion_group, criterion_main, Criterion};
+use opaque_rust::opaque_ffi::{
+    OpaqueCipherSuite, OpaqueCreateServerRegistrationResponseParams,
+    OpaqueFinishClientRegistrationParams, OpaqueStartClientLoginParams,
+    OpaqueStartClientRegistrationParams, OpaqueStartServerLoginParams,
+};
+use opaque_rust::*;
+
+const USER_IDENTIFIER: &str = "user123";
+const PASSWORD: &str = "hunter42";
+
+fn registration_request_params() -> OpaqueCreateServerRegistrationResponseParams {
+    let start = opaque_start_client_registration(OpaqueStartClientRegistrationParams {
+        password: PASSWORD.to_string(),
+        suite: OpaqueCipherSuite::Default,
+    })
+    .unwrap();
+    OpaqueCreateServerRegistrationResponseParams {
+        user_identifier: USER_IDENTIFIER.to_string(),
+        registration_request: start.registration_request,
+        suite: OpaqueCipherSuite::Default,
+    }
+}
+
+fn register(server_setup: &str) -> String {
+    let start = opaque_start_client_registration(OpaqueStartClientRegistrationParams {
+        password: PASSWORD.to_string(),
+        suite: OpaqueCipherSuite::Default,
+    })
+    .unwrap();
+    let response = opaque_create_server_registration_response(
+        server_setup.to_string(),
+        OpaqueCreateServerRegistrationResponseParams {
+            user_identifier: USER_IDENTIFIER.to_string(),
+            registration_request: start.registration_request,
+            suite: OpaqueCipherSuite::Default,
+        },
+    )
+    .unwrap();
+    opaque_finish_client_registration(OpaqueFinishClientRegistrationParams {
+        password: PASSWORD.to_string(),
+        registration_response: response.registration_response,
+        client_registration_state: start.client_registration_state,
+        client_identifier: vec![],
+        server_identifier: vec![],
+        key_stretching: vec![],
+        suite: OpaqueCipherSuite::Default,
+    })
+    .unwrap()
+    .registration_record
+}
+
+fn start_login_params(
+    registration_record: &str,
+    start_login_request: &str,
+) -> OpaqueStartServerLoginParams {
+    OpaqueStartServerLoginParams {
+        registration_record: vec![registration_record.to_string()],
+        start_login_request: start_login_request.to_string(),
+        user_identifier: USER_IDENTIFIER.to_string(),
+        client_identifier: vec![],
+        server_identifier: vec![],
+        suite: OpaqueCipherSuite::Default,
+    }
+}
+
+fn bench_server_setup(c: &mut Criterion) {
+    let server_setup = opaque_create_server_setup(OpaqueCipherSuite::Default).unwrap();
+    let handle =
+        opaque_create_server_setup_handle(server_setup.clone(), OpaqueCipherSuite::Default)
+            .unwrap();
+    let registration_record = register(&server_setup);
+    let start_login_request = opaque_start_client_login(OpaqueStartClientLoginParams {
+        password: PASSWORD.to_string(),
+        suite: OpaqueCipherSuite::Default,
+    })
+    .unwrap()
+    .start_login_request;
+
+    let mut group = c.benchmark_group("startServerLogin");
+    group.bench_function("string", |b| {
+        b.iter(|| {
+            opaque_start_server_login(
+                black_box(server_setup.clone()),
+                start_login_params(&registration_record, &start_login_request),
+            )
+            .unwrap()
+        })
+    });
+    group.bench_function("handle", |b| {
+        b.iter(|| {
+            opaque_start_server_login_with_setup(
+                black_box(&handle),
+                start_login_params(&registration_record, &start_login_request),
+            )
+            .unwrap()
+        })
+    });
+    group.finish();
+
+    const BATCH_SIZE: usize = 64;
+    let batch = || {
+        (0..BATCH_SIZE)
+            .map(|_| start_login_params(&registration_record, &start_login_request))
+            .collect::<Vec<_>>()
+    };
+    let mut group = c.benchmark_group("startServerLoginBatch");
+    group.throughput(criterion::Throughput::Elements(BATCH_SIZE as u64));
+    group.bench_function("sequential", |b| {
+        b.iter_batched(
+            batch,
+            |requests| {
+                requests
+                    .into_iter()
+                    .map(|params| opaque_start_server_login_with_setup(&handle, params).unwrap())
+                    .collect::<Vec<_>>()
+            },
+            criterion::BatchSize::SmallInput,
+        )
+    });
+    group.bench_function("batch", |b| {
+        b.iter_batched(
+            batch,
+            |requests| opaque_start_server_login_batch(&handle, requests),
+            criterion::BatchSize::SmallInput,
+        )
+    });
+    group.finish();
+
+    let mut group = c.benchmark_group("createServerRegistrationResponse");
+    group.bench_function("string", |b| {
+        b.iter_batched(
+            registration_request_params,
+            |params| {
+                opaque_create_server_registration_response(black_box(server_setup.clone()), params)
+                    .unwrap()
+            },
+            criterion::BatchSize::SmallInput,
+        )
+    });
+    group.bench_function("handle", |b| {
+        b.iter_batched(
+            registration_request_params,
+            |params| {
+                opaque_create_server_registration_response_with_setup(black_box(&handle), params)
+                    .unwrap()
+            },
+            criterion::BatchSize::SmallInput,
+        )
+    });
+    group.finish();
+
+    let mut group = c.benchmark_group("getServerPublicKey");
+    group.bench_function("string", |b| {
+        b.iter(|| {
+            opaque_get_server_public_key(
+                black_box(server_setup.clone()),
+                OpaqueCipherSuite::Default,
+            )
+            .unwrap()
+        })
+    });
+    group.bench_function("handle", |b| {
+        b.iter(|| opaque_get_server_public_key_with_setup(black_box(&handle)))
+    });
+    group.finish();
+}
+
+criterion_group!(benches, bench_server_setup);
+criterion_main!(benches);
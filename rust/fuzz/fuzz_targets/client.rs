@@ -0,0 +1,280 @@
+//! The client functions of the bridge, each through the string, binary and
+//! `*_into` API. Successful results must be well formed.
+
+#![no_main]
+
+use libfuzzer_sys::arbitrary::{self, Arbitrary};
+use libfuzzer_sys::fuzz_target;
+use opaque_rust::codec;
+use opaque_rust::opaque_ffi::*;
+use opaque_rust::*;
+use opaque_rust_fuzz::*;
+
+#[derive(Arbitrary, Debug)]
+enum Api {
+    String,
+    Binary,
+    Into(u16),
+}
+
+#[derive(Arbitrary, Debug)]
+enum Call {
+    StartRegistration {
+        password: String,
+    },
+    FinishRegistration {
+        password: String,
+        registration_response: Field,
+        client_registration_state: Field,
+        client_identifier: Option<String>,
+        server_identifier: Option<String>,
+        key_stretching: Option<KeyStretching>,
+    },
+    StartLogin {
+        password: String,
+    },
+    FinishLogin {
+        client_login_state: Field,
+        login_response: Field,
+        password: String,
+        client_identifier: Option<String>,
+        server_identifier: Option<String>,
+        key_stretching: Option<KeyStretching>,
+    },
+    PrewarmKeyStretching(Option<KeyStretching>),
+    PrepareClientLoginFinish(Option<KeyStretching>),
+    ReleaseKeyStretchingMemory,
+    TrimKeyStretchingMemory,
+}
+
+#[derive(Arbitrary, Debug)]
+struct Input {
+    api: Api,
+    suite: u8,
+    call: Call,
+}
+
+fn assert_base64(value: &str) {
+    assert!(codec::decode(value).is_ok(), "{value:?}");
+}
+
+/// Checks the fields an `*_into` function wrote back to back into `out`.
+fn assert_into(out: &[u8], lens: &[usize]) {
+    let mut rest = out;
+    for &len in lens {
+        let (field, tail) = rest.split_at(len);
+        assert_base64(std::str::from_utf8(field).unwrap());
+        rest = tail;
+    }
+}
+
+fn borrowed(value: &Option<String>) -> (&str, bool) {
+    value.as_deref().map_or(("", false), |value| (value, true))
+}
+
+fn run(input: Input) {
+    let suite = suite(input.suite);
+    match input.call {
+        Call::StartRegistration { password } => match input.api {
+            Api::String => {
+                let params = OpaqueStartClientRegistrationParams { password, suite };
+                if let Ok(result) = opaque_start_client_registration(params) {
+                    assert_base64(&result.client_registration_state);
+                    assert_base64(&result.registration_request);
+                }
+            }
+            Api::Binary => {
+                let _ = opaque_start_client_registration_binary(&password, suite);
+            }
+            Api::Into(len) => {
+                let mut out = out_buffer(len);
+                if let Ok(result) =
+                    opaque_start_client_registration_into(&password, suite, &mut out)
+                {
+                    assert_into(
+                        &out,
+                        &[
+                            result.client_registration_state,
+                            result.registration_request,
+                        ],
+                    );
+                }
+            }
+        },
+        Call::FinishRegistration {
+            password,
+            registration_response,
+            client_registration_state,
+            client_identifier,
+            server_identifier,
+            key_stretching,
+        } => match input.api {
+            Api::String => {
+                let params = OpaqueFinishClientRegistrationParams {
+                    password,
+                    registration_response: registration_response.string(),
+                    client_registration_state: client_registration_state.string(),
+                    client_identifier: optional(&client_identifier),
+                    server_identifier: optional(&server_identifier),
+                    key_stretching: optional_params(key_stretching),
+                    suite,
+                };
+                if let Ok(result) = opaque_finish_client_registration(params) {
+                    assert_base64(&result.registration_record);
+                    assert_base64(&result.export_key);
+                    assert_base64(&result.server_static_public_key);
+                }
+            }
+            Api::Binary => {
+                let _ = opaque_finish_client_registration_binary(
+                    &password,
+                    &registration_response.bytes(),
+                    &client_registration_state.bytes(),
+                    optional(&client_identifier),
+                    optional(&server_identifier),
+                    optional_params(key_stretching),
+                    suite,
+                );
+            }
+            Api::Into(len) => {
+                let registration_response = registration_response.string();
+                let client_registration_state = client_registration_state.string();
+                let (client_identifier, has_client_identifier) = borrowed(&client_identifier);
+                let (server_identifier, has_server_identifier) = borrowed(&server_identifier);
+                let mut out = out_buffer(len);
+                let result = opaque_finish_client_registration_into(
+                    OpaqueFinishClientRegistrationInput {
+                        password: &password,
+                        registration_response: &registration_response,
+                        client_registration_state: &client_registration_state,
+                        client_identifier,
+                        has_client_identifier,
+                        server_identifier,
+                        has_server_identifier,
+                        key_stretching: key_stretching
+                            .map_or(KEY_STRETCHING, KeyStretching::params),
+                        has_key_stretching: key_stretching.is_some(),
+                        suite,
+                    },
+                    &mut out,
+                );
+                if let Ok(result) = result {
+                    assert_into(
+                        &out,
+                        &[
+                            result.registration_record,
+                            result.export_key,
+                            result.server_static_public_key,
+                        ],
+                    );
+                }
+            }
+        },
+        Call::StartLogin { password } => match input.api {
+            Api::String => {
+                let params = OpaqueStartClientLoginParams { password, suite };
+                if let Ok(result) = opaque_start_client_login(params) {
+                    assert_base64(&result.client_login_state);
+                    assert_base64(&result.start_login_request);
+                }
+            }
+            Api::Binary => {
+                let _ = opaque_start_client_login_binary(&password, suite);
+            }
+            Api::Into(len) => {
+                let mut out = out_buffer(len);
+                if let Ok(result) = opaque_start_client_login_into(&password, suite, &mut out) {
+                    assert_into(
+                        &out,
+                        &[result.client_login_state, result.start_login_request],
+                    );
+                }
+            }
+        },
+        Call::FinishLogin {
+            client_login_state,
+            login_response,
+            password,
+            client_identifier,
+            server_identifier,
+            key_stretching,
+        } => match input.api {
+            Api::String => {
+                let params = OpaqueFinishClientLoginParams {
+                    client_login_state: client_login_state.string(),
+                    login_response: login_response.string(),
+                    password,
+                    client_identifier: optional(&client_identifier),
+                    server_identifier: optional(&server_identifier),
+                    key_stretching: optional_params(key_stretching),
+                    suite,
+                };
+                if let Ok(result) = opaque_finish_client_login(params) {
+                    if let Some(result) = result.as_ref() {
+                        assert_base64(&result.finish_login_request);
+                        assert_base64(&result.session_key);
+                        assert_base64(&result.export_key);
+                        assert_base64(&result.server_static_public_key);
+                    }
+                }
+            }
+            Api::Binary => {
+                let _ = opaque_finish_client_login_binary(
+                    &client_login_state.bytes(),
+                    &login_response.bytes(),
+                    &password,
+                    optional(&client_identifier),
+                    optional(&server_identifier),
+                    optional_params(key_stretching),
+                    suite,
+                );
+            }
+            Api::Into(len) => {
+                let client_login_state = client_login_state.string();
+                let login_response = login_response.string();
+                let (client_identifier, has_client_identifier) = borrowed(&client_identifier);
+                let (server_identifier, has_server_identifier) = borrowed(&server_identifier);
+                let mut out = out_buffer(len);
+                let result = opaque_finish_client_login_into(
+                    OpaqueFinishClientLoginInput {
+                        client_login_state: &client_login_state,
+                        login_response: &login_response,
+                        password: &password,
+                        client_identifier,
+                        has_client_identifier,
+                        server_identifier,
+                        has_server_identifier,
+                        key_stretching: key_stretching
+                            .map_or(KEY_STRETCHING, KeyStretching::params),
+                        has_key_stretching: key_stretching.is_some(),
+                        suite,
+                    },
+                    &mut out,
+                );
+                if let Ok(result) = result {
+                    if result.success {
+                        assert_into(
+                            &out,
+                            &[
+                                result.finish_login_request,
+                                result.session_key,
+                                result.export_key,
+                                result.server_static_public_key,
+                            ],
+                        );
+                    }
+                }
+            }
+        },
+        Call::PrewarmKeyStretching(key_stretching) => {
+            let _ = opaque_prewarm_key_stretching(optional_params(key_stretching));
+        }
+        Call::PrepareClientLoginFinish(key_stretching) => {
+            let _ = opaque_prepare_client_login_finish(optional_params(key_stretching));
+        }
+        Call::ReleaseKeyStretchingMemory => opaque_release_key_stretching_memory(),
+        Call::TrimKeyStretchingMemory => opaque_trim_key_stretching_memory(),
+    }
+}
+
+fuzz_target!(|input: Input| run(input));
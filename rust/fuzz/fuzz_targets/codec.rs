@@ -0,0 +1,38 @@
+//! Round trip of the base64 codec, and its decoder against the
+//! `URL_SAFE_NO_PAD` engine of the `base64` crate.
+
+#![no_main]
+
+use base64::{engine::general_purpose::URL_SAFE_NO_PAD, Engine as _};
+use libfuzzer_sys::fuzz_target;
+use opaque_rust::codec;
+
+fuzz_target!(|data: &[u8]| {
+    let encoded = codec::encode(data);
+    assert_eq!(encoded.len(), codec::encoded_len(data.len()));
+    assert_eq!(codec::decode(&encoded).unwrap(), data);
+
+    let mut out = vec![0; codec::encoded_len(data.len())];
+    assert_eq!(codec::encode_slice(data, &mut out), Some(out.len()));
+    assert!(out.is_empty() || codec::encode_slice(data, &mut out[1..]).is_none());
+
+    // the input as encoded text
+    let decoded = codec::decode(data);
+    let expected = URL_SAFE_NO_PAD.decode(data);
+    assert_eq!(decoded.is_ok(), expected.is_ok(), "{:?}", decoded);
+    if let (Ok(decoded), Ok(expected)) = (decoded, expected) {
+        assert_eq!(decoded, expected);
+        // only canonical encodings decode
+        assert_eq!(codec::encode(&decoded).as_bytes(), data);
+
+        let len = codec::decoded_len(data.len()).unwrap();
+        let mut out = vec![0; len];
+        assert_eq!(codec::decode_slice(data, &mut out), Ok(len));
+        if len > 0 {
+            assert_eq!(
+                codec::decode_slice(data, &mut out[1..]),
+                Err(codec::DecodeError::OutputTooSmall)
+            );
+        }
+    }
+});
@@ -0,0 +1,469 @@
+//! The server functions of the bridge: setups and handles, the string,
+//! binary and `*_into` API, batches, the session store and bulk imports.
+//! Successful results must be well formed.
+
+#![no_main]
+
+use libfuzzer_sys::arbitrary::{self, Arbitrary};
+use libfuzzer_sys::fuzz_target;
+use opaque_rust::codec;
+use opaque_rust::opaque_ffi::*;
+use opaque_rust::*;
+use opaque_rust_fuzz::*;
+
+/// How a function with a server setup gets it.
+#[derive(Arbitrary, Debug)]
+enum Setup {
+    /// The serialized setup of the fixture.
+    Fixture,
+    /// The handle of the fixture.
+    Handle,
+    /// Arbitrary serialized setup.
+    Field(Field),
+}
+
+#[derive(Arbitrary, Debug)]
+enum Api {
+    String,
+    Binary,
+    Into(u16),
+}
+
+#[derive(Arbitrary, Debug)]
+struct StartLogin {
+    registration_record: Option<Field>,
+    start_login_request: Field,
+    user_identifier: String,
+    client_identifier: Option<String>,
+    server_identifier: Option<String>,
+}
+
+impl StartLogin {
+    fn params(&self, suite: OpaqueCipherSuite) -> OpaqueStartServerLoginParams {
+        OpaqueStartServerLoginParams {
+            registration_record: self.registration_record.iter().map(Field::string).collect(),
+            start_login_request: self.start_login_request.string(),
+            user_identifier: self.user_identifier.clone(),
+            client_identifier: optional(&self.client_identifier),
+            server_identifier: optional(&self.server_identifier),
+            suite,
+        }
+    }
+}
+
+#[derive(Arbitrary, Debug)]
+enum Call {
+    CreateServerSetup,
+    CreateServerSetupHandle(Field),
+    GetServerPublicKey(Setup),
+    CheckServerSetupSuite,
+    CreateRegistrationResponse {
+        setup: Setup,
+        user_identifier: String,
+        registration_request: Field,
+    },
+    StartLogin(Setup, StartLogin),
+    StartLoginBatch(Vec<StartLogin>),
+    FinishLogin {
+        server_login_state: Field,
+        finish_login_request: Field,
+    },
+    Session {
+        ttl_ms: u32,
+        max_memory_bytes: u16,
+        start: StartLogin,
+        /// Finishes the started session instead of this handle if unset.
+        session_handle: Option<Field>,
+        finish_login_request: Field,
+    },
+    Import {
+        records: Vec<u8>,
+        max_records: u8,
+    },
+    Metrics {
+        enabled: bool,
+        start: StartLogin,
+    },
+}
+
+#[derive(Arbitrary, Debug)]
+struct Input {
+    api: Api,
+    suite: u8,
+    call: Call,
+}
+
+fn assert_base64(value: &str) {
+    assert!(codec::decode(value).is_ok(), "{value:?}");
+}
+
+fn assert_into(out: &[u8], lens: &[usize]) {
+    let mut rest = out;
+    for &len in lens {
+        let (field, tail) = rest.split_at(len);
+        assert_base64(std::str::from_utf8(field).unwrap());
+        rest = tail;
+    }
+}
+
+fn borrowed(value: &Option<String>) -> (&str, bool) {
+    value.as_deref().map_or(("", false), |value| (value, true))
+}
+
+fn create_registration_response(
+    api: Api,
+    suite: OpaqueCipherSuite,
+    setup: Setup,
+    user_identifier: String,
+    registration_request: Field,
+) {
+    let fixture = fixture();
+    let handle = &fixture.server_setup_handle;
+    match (api, setup) {
+        (Api::String, Setup::Handle) => {
+            let params = OpaqueCreateServerRegistrationResponseParams {
+                user_identifier,
+                registration_request: registration_request.string(),
+                suite,
+            };
+            if let Ok(result) =
+                opaque_create_server_registration_response_with_setup(handle, params)
+            {
+                assert_base64(&result.registration_response);
+            }
+        }
+        (Api::String, setup) => {
+            let server_setup = match setup {
+                Setup::Field(field) => field.string(),
+                _ => fixture.server_setup.clone(),
+            };
+            let params = OpaqueCreateServerRegistrationResponseParams {
+                user_identifier,
+                registration_request: registration_request.string(),
+                suite,
+            };
+            if let Ok(result) = opaque_create_server_registration_response(server_setup, params) {
+                assert_base64(&result.registration_response);
+            }
+        }
+        (Api::Binary, Setup::Handle) => {
+            if opaque_check_server_setup_suite(handle, suite).is_ok() {
+                let _ = opaque_create_server_registration_response_with_setup_binary(
+                    handle,
+                    &user_identifier,
+                    &registration_request.bytes(),
+                );
+            }
+        }
+        (Api::Binary, setup) => {
+            let server_setup = match setup {
+                Setup::Field(field) => field.bytes(),
+                _ => fixture.message(0),
+            };
+            let _ = opaque_create_server_registration_response_binary(
+                &server_setup,
+                &user_identifier,
+                &registration_request.bytes(),
+                suite,
+            );
+        }
+        (Api::Into(len), setup) => {
+            let registration_request = registration_request.string();
+            let input = OpaqueCreateServerRegistrationResponseInput {
+                user_identifier: &user_identifier,
+                registration_request: &registration_request,
+                suite,
+            };
+            let mut out = out_buffer(len);
+            let result = match setup {
+                Setup::Handle => opaque_create_server_registration_response_with_setup_into(
+                    handle, input, &mut out,
+                ),
+                Setup::Fixture => opaque_create_server_registration_response_into(
+                    &fixture.server_setup,
+                    input,
+                    &mut out,
+                ),
+                Setup::Field(field) => opaque_create_server_registration_response_into(
+                    &field.string(),
+                    input,
+                    &mut out,
+                ),
+            };
+            if let Ok(len) = result {
+                assert_into(&out, &[len]);
+            }
+        }
+    }
+}
+
+fn start_login(api: Api, suite: OpaqueCipherSuite, setup: Setup, start: StartLogin) {
+    let fixture = fixture();
+    let handle = &fixture.server_setup_handle;
+    match (api, setup) {
+        (Api::String, Setup::Handle) => {
+            if let Ok(result) = opaque_start_server_login_with_setup(handle, start.params(suite)) {
+                assert_base64(&result.server_login_state);
+                assert_base64(&result.login_response);
+            }
+        }
+        (Api::String, setup) => {
+            let server_setup = match setup {
+                Setup::Field(field) => field.string(),
+                _ => fixture.server_setup.clone(),
+            };
+            if let Ok(result) = opaque_start_server_login(server_setup, start.params(suite)) {
+                assert_base64(&result.server_login_state);
+                assert_base64(&result.login_response);
+            }
+        }
+        (Api::Binary, setup) => {
+            let registration_record = start.registration_record.as_ref().map(Field::bytes);
+            let start_login_request = start.start_login_request.bytes();
+            let client_identifier = optional(&start.client_identifier);
+            let server_identifier = optional(&start.server_identifier);
+            match setup {
+                Setup::Handle => {
+                    if opaque_check_server_setup_suite(handle, suite).is_ok() {
+                        let _ = opaque_start_server_login_with_setup_binary(
+                            handle,
+                            registration_record.as_deref().unwrap_or_default(),
+                            registration_record.is_some(),
+                            &start_login_request,
+                            &start.user_identifier,
+                            client_identifier,
+                            server_identifier,
+                        );
+                    }
+                }
+                setup => {
+                    let server_setup = match setup {
+                        Setup::Field(field) => field.bytes(),
+                        _ => fixture.message(0),
+                    };
+                    let _ = opaque_start_server_login_binary(
+                        &server_setup,
+                        registration_record.as_deref().unwrap_or_default(),
+                        registration_record.is_some(),
+                        &start_login_request,
+                        &start.user_identifier,
+                        client_identifier,
+                        server_identifier,
+                        suite,
+                    );
+                }
+            }
+        }
+        (Api::Into(len), setup) => {
+            let registration_record = start.registration_record.as_ref().map(Field::string);
+            let start_login_request = start.start_login_request.string();
+            let (client_identifier, has_client_identifier) = borrowed(&start.client_identifier);
+            let (server_identifier, has_server_identifier) = borrowed(&start.server_identifier);
+            let input = OpaqueStartServerLoginInput {
+                registration_record: registration_record.as_deref().unwrap_or_default(),
+                has_registration_record: registration_record.is_some(),
+                start_login_request: &start_login_request,
+                user_identifier: &start.user_identifier,
+                client_identifier,
+                has_client_identifier,
+                server_identifier,
+                has_server_identifier,
+                suite,
+            };
+            let mut out = out_buffer(len);
+            let result = match setup {
+                Setup::Handle => opaque_start_server_login_with_setup_into(handle, input, &mut out),
+                Setup::Fixture => {
+                    opaque_start_server_login_into(&fixture.server_setup, input, &mut out)
+                }
+                Setup::Field(field) => {
+                    opaque_start_server_login_into(&field.string(), input, &mut out)
+                }
+            };
+            if let Ok(result) = result {
+                assert_into(&out, &[result.server_login_state, result.login_response]);
+            }
+        }
+    }
+}
+
+fn finish_login(
+    api: Api,
+    suite: OpaqueCipherSuite,
+    server_login_state: Field,
+    finish_login_request: Field,
+) {
+    match api {
+        Api::String => {
+            let params = OpaqueFinishServerLoginParams {
+                server_login_state: server_login_state.string(),
+                finish_login_request: finish_login_request.string(),
+                suite,
+            };
+            if let Ok(result) = opaque_finish_server_login(params) {
+                assert_base64(&result.session_key);
+            }
+        }
+        Api::Binary => {
+            let _ = opaque_finish_server_login_binary(
+                &server_login_state.bytes(),
+                &finish_login_request.bytes(),
+                suite,
+            );
+        }
+        Api::Into(len) => {
+            let server_login_state = server_login_state.string();
+            let finish_login_request = finish_login_request.string();
+            let mut out = out_buffer(len);
+            let input = OpaqueFinishServerLoginInput {
+                server_login_state: &server_login_state,
+                finish_login_request: &finish_login_request,
+                suite,
+            };
+            if let Ok(len) = opaque_finish_server_login_into(input, &mut out) {
+                assert_into(&out, &[len]);
+            }
+        }
+    }
+}
+
+fn run(input: Input) {
+    let suite = suite(input.suite);
+    let fixture = fixture();
+    let handle = &fixture.server_setup_handle;
+    match input.call {
+        Call::CreateServerSetup => match input.api {
+            Api::Binary => {
+                if let Ok(setup) = opaque_create_server_setup_binary(suite) {
+                    opaque_create_server_setup_handle_binary(&setup, suite).unwrap();
+                }
+            }
+            _ => {
+                if let Ok(setup) = opaque_create_server_setup(suite) {
+                    opaque_create_server_setup_handle(setup, suite).unwrap();
+                }
+            }
+        },
+        Call::CreateServerSetupHandle(field) => match input.api {
+            Api::Binary => {
+                let _ = opaque_create_server_setup_handle_binary(&field.bytes(), suite);
+            }
+            _ => {
+                let _ = opaque_create_server_setup_handle(field.string(), suite);
+            }
+        },
+        Call::GetServerPublicKey(setup) => match (input.api, setup) {
+            (Api::Binary, Setup::Handle) => {
+                opaque_get_server_public_key_with_setup_binary(handle);
+            }
+            (Api::Binary, Setup::Fixture) => {
+                let _ = opaque_get_server_public_key_binary(&fixture.message(0), suite);
+            }
+            (Api::Binary, Setup::Field(field)) => {
+                let _ = opaque_get_server_public_key_binary(&field.bytes(), suite);
+            }
+            (_, Setup::Handle) => {
+                assert_base64(&opaque_get_server_public_key_with_setup(handle));
+            }
+            (_, Setup::Fixture) => {
+                if let Ok(key) = opaque_get_server_public_key(fixture.server_setup.clone(), suite) {
+                    assert_eq!(key, opaque_get_server_public_key_with_setup(handle));
+                }
+            }
+            (_, Setup::Field(field)) => {
+                if let Ok(key) = opaque_get_server_public_key(field.string(), suite) {
+                    assert_base64(&key);
+                }
+            }
+        },
+        Call::CheckServerSetupSuite => {
+            let _ = opaque_check_server_setup_suite(handle, suite);
+        }
+        Call::CreateRegistrationResponse {
+            setup,
+            user_identifier,
+            registration_request,
+        } => create_registration_response(
+            input.api,
+            suite,
+            setup,
+            user_identifier,
+            registration_request,
+        ),
+        Call::StartLogin(setup, start) => start_login(input.api, suite, setup, start),
+        Call::StartLoginBatch(requests) => {
+            let requests: Vec<_> = requests.iter().map(|start| start.params(suite)).collect();
+            let len = requests.len();
+            let results = opaque_start_server_login_batch(handle, requests);
+            assert_eq!(results.len(), len);
+            for result in results
+                .iter()
+                .filter(|result| result.error_code == OpaqueErrorCode::None)
+            {
+                assert_base64(&result.server_login_state);
+                assert_base64(&result.login_response);
+            }
+        }
+        Call::FinishLogin {
+            server_login_state,
+            finish_login_request,
+        } => finish_login(input.api, suite, server_login_state, finish_login_request),
+        Call::Session {
+            ttl_ms,
+            max_memory_bytes,
+            start,
+            session_handle,
+            finish_login_request,
+        } => {
+            let Ok(store) =
+                opaque_create_server_login_session_store(ttl_ms, max_memory_bytes.into())
+            else {
+                return;
+            };
+            let started = opaque_start_server_login_session(&store, handle, start.params(suite));
+            let session_handle = match (session_handle, &started) {
+                (Some(field), _) => field.string(),
+                (None, Ok(result)) => result.session_handle.clone(),
+                (None, Err(_)) => return,
+            };
+            let count = opaque_server_login_session_count(&store);
+            let finished = opaque_finish_server_login_session(
+                &store,
+                &session_handle,
+                &finish_login_request.string(),
+            );
+            if let Ok(result) = finished {
+                assert_base64(&result.session_key);
+                assert_eq!(opaque_server_login_session_count(&store), count - 1);
+            }
+        }
+        Call::Import {
+            records,
+            max_records,
+        } => {
+            let count = opaque_count_registration_import_records(&records);
+            if let Ok(chunk) = opaque_create_server_registration_responses_chunk(
+                handle,
+                &records,
+                max_records.into(),
+            ) {
+                assert!(chunk.consumed <= records.len());
+                assert!(chunk.failed <= chunk.records);
+                if let Ok(count) = count {
+                    assert!(chunk.records as u64 <= count);
+                }
+            }
+        }
+        Call::Metrics { enabled, start } => {
+            opaque_set_metrics_enabled(enabled);
+            opaque_metrics_begin(OpaqueMetricsFunction::StartServerLogin);
+            let _ = opaque_start_server_login_with_setup(handle, start.params(suite));
+            opaque_metrics_end();
+            opaque_get_metrics();
+            opaque_reset_metrics();
+            opaque_set_metrics_enabled(false);
+        }
+    }
+}
+
+fuzz_target!(|input: Input| run(input));
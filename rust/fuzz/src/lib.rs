@@ -0,0 +1,179 @@
+//! Inputs shared by the fuzz targets in `fuzz_targets/`.
+//!
+//! The message fields are either arbitrary strings, to fuzz the base64
+//! decoding, or arbitrary bytes encoded by the codec, to get past it and fuzz
+//! the deserialization of the protocol messages. `Fixture` holds the messages
+//! of a real login, which the targets mix in so mutations start close to
+//! valid input.
+
+use std::sync::OnceLock;
+
+use libfuzzer_sys::arbitrary::{self, Arbitrary};
+use opaque_rust::codec;
+use opaque_rust::opaque_ffi::*;
+use opaque_rust::*;
+
+#[derive(Arbitrary, Debug)]
+pub enum Field {
+    Raw(String),
+    Encoded(Vec<u8>),
+    /// A message of the fixture, see `Fixture::message`.
+    Fixture(u8),
+    /// A message of the fixture with one byte flipped.
+    Flipped(u8, u16, u8),
+}
+
+impl Field {
+    pub fn string(&self) -> String {
+        match self {
+            Field::Raw(value) => value.clone(),
+            Field::Encoded(bytes) => codec::encode(bytes),
+            Field::Fixture(_) | Field::Flipped(..) => codec::encode(self.bytes()),
+        }
+    }
+
+    pub fn bytes(&self) -> Vec<u8> {
+        match self {
+            Field::Raw(value) => value.as_bytes().to_vec(),
+            Field::Encoded(bytes) => bytes.clone(),
+            Field::Fixture(index) => fixture().message(*index),
+            Field::Flipped(index, position, mask) => {
+                let mut bytes = fixture().message(*index);
+                if !bytes.is_empty() {
+                    let position = usize::from(*position) % bytes.len();
+                    bytes[position] ^= mask | 1;
+                }
+                bytes
+            }
+        }
+    }
+}
+
+/// Key stretching params small enough to keep an iteration fast, zero
+/// values are kept to fuzz their validation.
+#[derive(Arbitrary, Debug, Clone, Copy)]
+pub struct KeyStretching {
+    memory_cost: u8,
+    iterations: u8,
+    parallelism: u8,
+}
+
+impl KeyStretching {
+    pub fn params(self) -> OpaqueKeyStretchingParams {
+        OpaqueKeyStretchingParams {
+            memory_cost: u32::from(self.memory_cost % 64),
+            iterations: u32::from(self.iterations % 3),
+            parallelism: u32::from(self.parallelism % 3),
+        }
+    }
+}
+
+/// Maps to the three suites most of the time, and otherwise to an unknown
+/// one.
+pub fn suite(tag: u8) -> OpaqueCipherSuite {
+    match tag % 8 {
+        0 | 1 => OpaqueCipherSuite::Default,
+        2 | 3 => OpaqueCipherSuite::Ristretto255,
+        4 | 5 => OpaqueCipherSuite::P256,
+        _ => OpaqueCipherSuite { repr: tag.into() },
+    }
+}
+
+pub fn optional(value: &Option<String>) -> Vec<String> {
+    value.iter().cloned().collect()
+}
+
+pub fn optional_params(value: Option<KeyStretching>) -> Vec<OpaqueKeyStretchingParams> {
+    value.map(KeyStretching::params).into_iter().collect()
+}
+
+/// Output buffers of the `*_into` functions, mostly large enough.
+pub fn out_buffer(len: u16) -> Vec<u8> {
+    vec![0; usize::from(len) % 4096]
+}
+
+pub const PASSWORD: &str = "hunter42";
+pub const USER_IDENTIFIER: &str = "user@example.com";
+
+pub const KEY_STRETCHING: OpaqueKeyStretchingParams = OpaqueKeyStretchingParams {
+    memory_cost: 8,
+    iterations: 1,
+    parallelism: 1,
+};
+
+/// The messages of a registration and login with the default suite.
+pub struct Fixture {
+    pub server_setup: String,
+    pub server_setup_handle: Box<ServerSetupHandle>,
+    messages: Vec<Vec<u8>>,
+}
+
+impl Fixture {
+    pub fn message(&self, index: u8) -> Vec<u8> {
+        self.messages[usize::from(index) % self.messages.len()].clone()
+    }
+}
+
+pub fn fixture() -> &'static Fixture {
+    static FIXTURE: OnceLock<Fixture> = OnceLock::new();
+    FIXTURE.get_or_init(|| {
+        let suite = OpaqueCipherSuite::Default;
+        let server_setup = opaque_create_server_setup_binary(suite).unwrap();
+        let handle = opaque_create_server_setup_handle_binary(&server_setup, suite).unwrap();
+        let registration = opaque_start_client_registration_binary(PASSWORD, suite).unwrap();
+        let response = opaque_create_server_registration_response_with_setup_binary(
+            &handle,
+            USER_IDENTIFIER,
+            &registration.registration_request,
+        )
+        .unwrap();
+        let record = opaque_finish_client_registration_binary(
+            PASSWORD,
+            &response.registration_response,
+            &registration.client_registration_state,
+            vec![],
+            vec![],
+            vec![KEY_STRETCHING],
+            suite,
+        )
+        .unwrap();
+        let login = opaque_start_client_login_binary(PASSWORD, suite).unwrap();
+        let server_login = opaque_start_server_login_with_setup_binary(
+            &handle,
+            &record.registration_record,
+            true,
+            &login.start_login_request,
+            USER_IDENTIFIER,
+            vec![],
+            vec![],
+        )
+        .unwrap();
+        let finish = opaque_finish_client_login_binary(
+            &login.client_login_state,
+            &server_login.login_response,
+            PASSWORD,
+            vec![],
+            vec![],
+            vec![KEY_STRETCHING],
+            suite,
+        )
+        .unwrap();
+        let finish_login_request = finish.finish_login_request.clone();
+        Fixture {
+            server_setup: codec::encode(&server_setup),
+            server_setup_handle: handle,
+            messages: vec![
+                server_setup,
+                registration.client_registration_state,
+                registration.registration_request,
+                response.registration_response,
+                record.registration_record,
+                login.client_login_state,
+                login.start_login_request,
+                server_login.server_login_state,
+                server_login.login_response,
+                finish_login_request,
+            ],
+        }
+    })
+}
@@ -0,0 +1,336 @@
+//! Memory of the Argon2 key stretching kept between calls.
+//!
+//! Argon2 needs `memory_cost` KiB (19 MiB by default) for every call, and a
+//! fresh allocation of that size comes straight from `mmap`, so the first
+//! write to every page faults. Once `prewarm` was called, the KSF reuses a
+//! single page-aligned arena instead, whose pages were all touched up front.
+//! It grows to the largest memory cost used and is kept until `release` (or
+//! `trim` on memory pressure) frees it. The blocks are zeroized after every
+//! call, so the kept arena never holds the Argon2 matrix of a password. `prewarm_next` instead
+//! prepares the arena for the next call only, which frees it afterwards.
+//!
+//! A call takes the arena out of the shared state while the key stretching
+//! runs, so `trim` and `release` never wait for it. If either ran in the
+//! meantime the arena is freed when the call returns instead of being put
+//! back. Concurrent calls allocate their own memory.
+
+use std::alloc::{alloc, dealloc, handle_alloc_error, Layout};
+use std::mem::{align_of, size_of};
+use std::ptr::NonNull;
+use std::sync::{Mutex, MutexGuard, PoisonError};
+
+/// Covers the 4 KiB and 16 KiB pages of Android and iOS devices.
+const PAGE_SIZE: usize = 16 * 1024;
+
+/// Argon2 always works on blocks of 1 KiB.
+pub const BLOCK_SIZE: usize = 1024;
+
+struct Arena {
+    ptr: NonNull<u8>,
+    layout: Layout,
+    /// Bytes at the start of the arena written since it was last zeroized.
+    used: usize,
+}
+
+// SAFETY: the arena owns its memory, which is only accessed through `&mut`.
+unsafe impl Send for Arena {}
+
+impl Arena {
+    fn new(blocks: usize) -> Arena {
+        let size = (blocks * BLOCK_SIZE).next_multiple_of(PAGE_SIZE);
+        let layout = Layout::from_size_align(size, PAGE_SIZE).expect("invalid Argon2 arena size");
+        // SAFETY: the size is at least one page
+        let ptr =
+            NonNull::new(unsafe { alloc(layout) }).unwrap_or_else(|| handle_alloc_error(layout));
+        // Zeroing writes every page, which faults them in now instead of
+        // during the key stretching.
+        unsafe { ptr.as_ptr().write_bytes(0, size) };
+        Arena {
+            ptr,
+            layout,
+            used: 0,
+        }
+    }
+
+    fn blocks(&self) -> usize {
+        self.layout.size() / BLOCK_SIZE
+    }
+
+    /// The first `count` blocks of the arena.
+    fn as_blocks<T: Copy>(&mut self, count: usize) -> &mut [T] {
+        assert!(size_of::<T>() == BLOCK_SIZE && align_of::<T>() <= PAGE_SIZE);
+        assert!(count <= self.blocks());
+        self.used = self.used.max(count * BLOCK_SIZE);
+        // SAFETY: the memory is initialized, suitably aligned, big enough and
+        // borrowed mutably. The block types are arrays of integers, every
+        // bit pattern is a valid block.
+        unsafe { std::slice::from_raw_parts_mut(self.ptr.as_ptr().cast::<T>(), count) }
+    }
+
+    /// Zeroizes the blocks written since the last call. Volatile writes, so
+    /// the zeroing isn't optimized away when the memory isn't read again.
+    fn zeroize(&mut self) {
+        let words = self.ptr.as_ptr().cast::<u64>();
+        for i in 0..self.used / size_of::<u64>() {
+            // SAFETY: `used` never exceeds the size of the arena
+            unsafe { words.add(i).write_volatile(0) };
+        }
+        self.used = 0;
+    }
+}
+
+impl Drop for Arena {
+    fn drop(&mut self) {
+        self.zeroize();
+        unsafe { dealloc(self.ptr.as_ptr(), self.layout) };
+    }
+}
+
+struct State {
+    /// Whether the arena is kept between calls, set by `prewarm`.
+    keep: bool,
+    arena: Option<Arena>,
+    /// Incremented by `trim` and `release`, an arena taken out before is
+    /// freed instead of put back.
+    generation: u64,
+}
+
+static STATE: Mutex<State> = Mutex::new(State {
+    keep: false,
+    arena: None,
+    generation: 0,
+});
+
+fn lock() -> MutexGuard<'static, State> {
+    STATE.lock().unwrap_or_else(PoisonError::into_inner)
+}
+
+/// Puts `arena` back unless the arena was trimmed or released since
+/// `generation` or a bigger one took its place. Returns the arena that isn't
+/// needed anymore, for the caller to free after unlocking the state.
+fn store(state: &mut State, arena: Arena, generation: u64) -> Option<Arena> {
+    if state.generation != generation {
+        return Some(arena);
+    }
+    match &state.arena {
+        Some(current) if current.blocks() >= arena.blocks() => Some(arena),
+        _ => state.arena.replace(arena),
+    }
+}
+
+/// Allocates an arena for `blocks` blocks unless there is one that big. The
+/// pages are faulted in without holding the lock.
+fn allocate(blocks: usize) {
+    let (old, generation) = {
+        let mut state = lock();
+        if state.arena.as_ref().map_or(0, Arena::blocks) >= blocks {
+            return;
+        }
+        (state.arena.take(), state.generation)
+    };
+    // free the old arena first so the memory use doesn't peak at both
+    drop(old);
+    let arena = Arena::new(blocks);
+    let unused = store(&mut lock(), arena, generation);
+    drop(unused);
+}
+
+/// Allocates the arena for `blocks` blocks, faults in its pages and keeps it
+/// for the following calls.
+pub fn prewarm(blocks: usize) {
+    lock().keep = true;
+    allocate(blocks);
+}
+
+/// Allocates the arena for `blocks` blocks and faults in its pages for the
+/// next call, which frees it again unless it's kept.
+pub fn prewarm_next(blocks: usize) {
+    allocate(blocks);
+}
+
+/// Zeroizes and frees the arena, and stops keeping it between calls.
+pub fn release() {
+    let arena = {
+        let mut state = lock();
+        state.keep = false;
+        state.generation += 1;
+        state.arena.take()
+    };
+    drop(arena);
+}
+
+/// Zeroizes and frees the arena, it's allocated again by the next call.
+pub fn trim() {
+    let arena = {
+        let mut state = lock();
+        state.generation += 1;
+        state.arena.take()
+    };
+    drop(arena);
+}
+
+/// Runs `f` with `count` blocks of memory, from the arena if it's kept or
+/// prepared for this call and not in use, otherwise from a fresh allocation.
+/// The content of the blocks is unspecified, Argon2 overwrites every block
+/// in its first pass.
+pub fn with_blocks<T: Copy + Default, R>(count: usize, f: impl FnOnce(&mut [T]) -> R) -> R {
+    let (arena, keep, generation) = {
+        let mut state = lock();
+        (state.arena.take(), state.keep, state.generation)
+    };
+    if arena.is_none() && !keep {
+        return f(&mut vec![T::default(); count]);
+    }
+    let mut arena = match arena {
+        Some(arena) if arena.blocks() >= count => arena,
+        smaller => {
+            drop(smaller);
+            Arena::new(count)
+        }
+    };
+    // the lock isn't held while the key stretching runs, `trim` and
+    // `release` only bump the generation and the arena is freed below
+    let result = f(arena.as_blocks(count));
+    // the blocks hold the whole matrix the password key is computed from
+    arena.zeroize();
+    let unused = {
+        let mut state = lock();
+        if state.keep {
+            store(&mut state, arena, generation)
+        } else {
+            Some(arena)
+        }
+    };
+    drop(unused);
+    result
+}
+
+/// Size of the arena in bytes, 0 if there is none.
+#[cfg(test)]
+fn size() -> usize {
+    lock().arena.as_ref().map_or(0, |arena| arena.layout.size())
+}
+
+/// Whether every byte of the arena is zero, true if there is none.
+#[cfg(test)]
+fn is_zeroed() -> bool {
+    lock().arena.as_ref().map_or(true, |arena| {
+        // SAFETY: the arena is initialized and not in use while the state
+        // is locked
+        let bytes = unsafe { std::slice::from_raw_parts(arena.ptr.as_ptr(), arena.layout.size()) };
+        bytes.iter().all(|&byte| byte == 0)
+    })
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[derive(Clone, Copy)]
+    #[repr(align(64))]
+    struct Block([u64; BLOCK_SIZE / 8]);
+
+    impl Default for Block {
+        fn default() -> Self {
+            Block([0; BLOCK_SIZE / 8])
+        }
+    }
+
+    // the arena is global, the tests must not run concurrently
+    static LOCK: Mutex<()> = Mutex::new(());
+
+    fn address(blocks: &mut [Block]) -> usize {
+        blocks.as_ptr() as usize
+    }
+
+    #[test]
+    fn reuses_the_prewarmed_arena() {
+        let _lock = LOCK.lock().unwrap();
+        prewarm(64);
+        assert_eq!(size(), 64 * BLOCK_SIZE);
+        let first = with_blocks(32, address);
+        assert_eq!(first % PAGE_SIZE, 0);
+        assert_eq!(with_blocks(64, address), first);
+
+        // grows for bigger calls and keeps the bigger arena
+        let bigger = with_blocks(100, |blocks: &mut [Block]| {
+            blocks[99].0[0] = 1;
+            address(blocks)
+        });
+        assert_eq!(size(), (100 * BLOCK_SIZE).next_multiple_of(PAGE_SIZE));
+        assert_eq!(with_blocks(100, address), bigger);
+
+        trim();
+        assert_eq!(size(), 0);
+        with_blocks(8, address);
+        assert_eq!(size(), PAGE_SIZE);
+
+        release();
+        assert_eq!(size(), 0);
+        with_blocks(8, address);
+        assert_eq!(size(), 0);
+    }
+
+    #[test]
+    fn prepares_the_arena_for_the_next_call() {
+        let _lock = LOCK.lock().unwrap();
+        prewarm_next(16);
+        assert_eq!(size(), 16 * BLOCK_SIZE);
+        with_blocks(16, address);
+        assert_eq!(size(), 0);
+
+        // doesn't shrink or drop a kept arena
+        prewarm(64);
+        prewarm_next(16);
+        with_blocks(16, address);
+        assert_eq!(size(), 64 * BLOCK_SIZE);
+        release();
+    }
+
+    #[test]
+    fn zeroizes_the_kept_arena() {
+        let _lock = LOCK.lock().unwrap();
+        prewarm(16);
+        with_blocks(16, |blocks: &mut [Block]| {
+            for (i, block) in blocks.iter_mut().enumerate() {
+                block.0.fill(i as u64 + 1);
+            }
+        });
+        assert_eq!(size(), 16 * BLOCK_SIZE);
+        assert!(is_zeroed());
+
+        // also after a bigger call replaced the arena
+        with_blocks(40, |blocks: &mut [Block]| blocks[39].0.fill(u64::MAX));
+        assert_eq!(size(), (40 * BLOCK_SIZE).next_multiple_of(PAGE_SIZE));
+        assert!(is_zeroed());
+        release();
+    }
+
+    #[test]
+    fn concurrent_calls_get_their_own_memory() {
+        let _lock = LOCK.lock().unwrap();
+        prewarm(16);
+        let (outer, inner) = with_blocks(16, |outer: &mut [Block]| {
+            (address(outer), with_blocks(16, address))
+        });
+        assert_ne!(outer, inner);
+        release();
+    }
+
+    #[test]
+    fn trim_doesnt_wait_for_a_running_call() {
+        let _lock = LOCK.lock().unwrap();
+        prewarm(16);
+        with_blocks(16, |_: &mut [Block]| {
+            trim();
+            prewarm_next(16);
+            assert_eq!(size(), 16 * BLOCK_SIZE);
+            trim();
+        });
+        // trimmed while in use, so it isn't put back
+        assert_eq!(size(), 0);
+        with_blocks(16, address);
+        assert_eq!(size(), 16 * BLOCK_SIZE);
+        release();
+    }
+}
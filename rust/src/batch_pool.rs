@@ -0,0 +1,211 @@
+//! Threads for the batch functions (`startServerLoginBatch` and the bulk
+//! registration import). They are started on the first batch and kept, so
+//! a burst of batches doesn't spawn and join a thread per core every time.
+//!
+//! The calling thread takes part in every batch, the chunks go to whichever
+//! thread is free first. A batch therefore never waits for a pool thread
+//! that is still busy with the batch of another runtime.
+
+use std::panic::{self, AssertUnwindSafe};
+use std::sync::atomic::{AtomicBool, AtomicUsize, Ordering};
+use std::sync::mpsc::{self, Sender};
+use std::sync::{Arc, Condvar, Mutex, OnceLock, PoisonError};
+use std::thread;
+
+/// Items are only spread across threads if each thread gets at least this
+/// many, otherwise handing them over costs more than it saves.
+const MIN_ITEMS_PER_THREAD: usize = 4;
+
+type Job = Box<dyn FnOnce() + Send + 'static>;
+
+struct Pool {
+    sender: Mutex<Sender<Job>>,
+    /// the threads that could be started
+    threads: usize,
+}
+
+fn pool() -> &'static Pool {
+    static POOL: OnceLock<Pool> = OnceLock::new();
+    POOL.get_or_init(|| {
+        let (sender, receiver) = mpsc::channel::<Job>();
+        let receiver = Arc::new(Mutex::new(receiver));
+        // the calling thread is the last one
+        let wanted = thread::available_parallelism().map_or(1, |n| n.get()) - 1;
+        let threads = (0..wanted)
+            .filter(|i| {
+                let receiver = Arc::clone(&receiver);
+                thread::Builder::new()
+                    .name(format!("opaque-batch-{i}"))
+                    .spawn(move || loop {
+                        let job = receiver
+                            .lock()
+                            .unwrap_or_else(PoisonError::into_inner)
+                            .recv();
+                        match job {
+                            Ok(job) => job(),
+                            Err(_) => return,
+                        }
+                    })
+                    .is_ok()
+            })
+            .count();
+        Pool {
+            sender: Mutex::new(sender),
+            threads,
+        }
+    })
+}
+
+/// The progress of one batch, shared with the pool threads working on it.
+struct Batch {
+    next: AtomicUsize,
+    count: usize,
+    /// pool threads which haven't finished their job yet
+    running: Mutex<usize>,
+    finished: Condvar,
+    panicked: AtomicBool,
+}
+
+impl Batch {
+    /// Calls `work` for the chunks no other thread took yet.
+    fn work(&self, work: &(dyn Fn(usize) + Sync)) {
+        loop {
+            let i = self.next.fetch_add(1, Ordering::Relaxed);
+            if i >= self.count {
+                return;
+            }
+            work(i);
+        }
+    }
+
+    fn finish(&self) {
+        let mut running = self.running.lock().unwrap_or_else(PoisonError::into_inner);
+        *running -= 1;
+        if *running == 0 {
+            self.finished.notify_all();
+        }
+    }
+}
+
+/// Blocks until the pool threads finished their jobs, also while the
+/// calling thread unwinds, since the jobs borrow its stack.
+struct WaitForJobs<'b>(&'b Batch);
+
+impl Drop for WaitForJobs<'_> {
+    fn drop(&mut self) {
+        let running = self
+            .0
+            .running
+            .lock()
+            .unwrap_or_else(PoisonError::into_inner);
+        drop(
+            self.0
+                .finished
+                .wait_while(running, |running| *running > 0)
+                .unwrap_or_else(PoisonError::into_inner),
+        );
+    }
+}
+
+/// Calls `work(i)` for every `i` in `0..count` on the calling thread and up
+/// to `count - 1` pool threads, and returns once all calls returned.
+fn run(count: usize, work: &(dyn Fn(usize) + Sync)) {
+    let pool = pool();
+    let helpers = pool.threads.min(count - 1);
+    let batch = Arc::new(Batch {
+        next: AtomicUsize::new(0),
+        count,
+        running: Mutex::new(helpers),
+        finished: Condvar::new(),
+        panicked: AtomicBool::new(false),
+    });
+    {
+        let _wait = WaitForJobs(&batch);
+        for _ in 0..helpers {
+            let shared = Arc::clone(&batch);
+            let job: Box<dyn FnOnce() + Send + '_> = Box::new(move || {
+                let batch = &*shared;
+                if panic::catch_unwind(AssertUnwindSafe(|| batch.work(work))).is_err() {
+                    batch.panicked.store(true, Ordering::Relaxed);
+                }
+                batch.finish();
+            });
+            // SAFETY: only the lifetime of `work` is extended. `_wait` blocks
+            // until every job called `finish`, the last use of `work`.
+            let job: Job = unsafe { std::mem::transmute(job) };
+            let sent = pool
+                .sender
+                .lock()
+                .unwrap_or_else(PoisonError::into_inner)
+                .send(job);
+            if sent.is_err() {
+                // the job was dropped unrun
+                batch.finish();
+            }
+        }
+        batch.work(work);
+    }
+    assert!(
+        !batch.panicked.load(Ordering::Relaxed),
+        "batch worker panicked"
+    );
+}
+
+/// Maps the items in order, spread across the available cores in contiguous
+/// chunks.
+pub fn map_parallel<T: Send, R: Send>(items: Vec<T>, f: impl Fn(T) -> R + Sync) -> Vec<R> {
+    let chunks = (pool().threads + 1).min(items.len() / MIN_ITEMS_PER_THREAD);
+    if chunks <= 1 {
+        return items.into_iter().map(f).collect();
+    }
+
+    let chunk_size = items.len().div_ceil(chunks);
+    let mut items = items.into_iter();
+    let inputs: Vec<Mutex<Vec<T>>> = (0..chunks)
+        .map(|_| Mutex::new(items.by_ref().take(chunk_size).collect()))
+        .collect();
+    let outputs: Vec<Mutex<Vec<R>>> = (0..chunks).map(|_| Mutex::new(Vec::new())).collect();
+    run(chunks, &|i| {
+        let chunk = std::mem::take(&mut *inputs[i].lock().unwrap_or_else(PoisonError::into_inner));
+        let results = chunk.into_iter().map(&f).collect();
+        *outputs[i].lock().unwrap_or_else(PoisonError::into_inner) = results;
+    });
+    outputs
+        .into_iter()
+        .flat_map(|output| output.into_inner().unwrap_or_else(PoisonError::into_inner))
+        .collect()
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn keeps_the_order() {
+        for len in [0, 1, 7, 100, 1000] {
+            let items: Vec<usize> = (0..len).collect();
+            let doubled: Vec<usize> = items.iter().map(|i| i * 2).collect();
+            assert_eq!(map_parallel(items, |i| i * 2), doubled);
+        }
+    }
+
+    #[test]
+    fn runs_on_the_pool_threads() {
+        let caller = thread::current().name().map(str::to_string);
+        for _ in 0..3 {
+            let names = map_parallel((0..1000).collect(), |_: usize| {
+                thread::current().name().map(str::to_string)
+            });
+            assert!(names.iter().all(|name| *name == caller
+                || name
+                    .as_deref()
+                    .is_some_and(|name| name.starts_with("opaque-batch-"))));
+        }
+    }
+
+    #[test]
+    #[should_panic]
+    fn propagates_panics() {
+        map_parallel((0..1000).collect(), |i: usize| assert!(i < 999));
+    }
+}
@@ -0,0 +1,138 @@
+//! Entry points for the native benchmark harness in `benchmarks/` which time
+//! the individual phases of the protocol in isolation. They are plain C
+//! symbols, only built with the `bench` feature, so the cxx bridge used by
+//! the app stays untouched.
+
+use std::hint::black_box;
+use std::sync::OnceLock;
+
+use argon2::Argon2;
+use opaque_ke::rand::rngs::OsRng;
+use opaque_ke::{ciphersuite::CipherSuite, ksf::Identity};
+use opaque_ke::{
+    ClientLogin, ClientLoginFinishParameters, ClientRegistration,
+    ClientRegistrationFinishParameters, ServerLogin, ServerLoginStartParameters,
+    ServerRegistration, ServerSetup,
+};
+
+use crate::codec;
+
+/// Same as the default cipher suite but without key stretching, so running
+/// the protocol only measures the curve operations (and hashing).
+struct CurveOnlyCipherSuite;
+
+#[cfg(not(feature = "p256"))]
+impl CipherSuite for CurveOnlyCipherSuite {
+    type OprfCs = opaque_ke::Ristretto255;
+    type KeGroup = opaque_ke::Ristretto255;
+    type KeyExchange = opaque_ke::key_exchange::tripledh::TripleDh;
+    type Ksf = Identity;
+}
+
+#[cfg(feature = "p256")]
+impl CipherSuite for CurveOnlyCipherSuite {
+    type OprfCs = p256::NistP256;
+    type KeGroup = p256::NistP256;
+    type KeyExchange = opaque_ke::key_exchange::tripledh::TripleDh;
+    type Ksf = Identity;
+}
+
+const PASSWORD: &[u8] = b"hunter42";
+const USER_IDENTIFIER: &[u8] = b"user123";
+
+/// Runs the key stretching the way opaque-ke invokes the Argon2 KSF: the
+/// 64 byte OPRF output is hashed with a zero salt into a 64 byte key.
+#[no_mangle]
+pub extern "C" fn opaque_bench_argon2() {
+    let input = [0u8; 64];
+    let mut output = [0u8; 64];
+    Argon2::default()
+        .hash_password_into(
+            black_box(&input),
+            &[0u8; argon2::RECOMMENDED_SALT_LEN],
+            &mut output,
+        )
+        .expect("argon2 failed");
+    black_box(output);
+}
+
+/// Encodes `len` bytes to base64 and decodes them again, like the string
+/// API does for every message passed across the bridge.
+#[no_mangle]
+pub extern "C" fn opaque_bench_base64(len: usize) {
+    let bytes = vec![0x5au8; len];
+    let encoded = codec::encode(black_box(&bytes));
+    let decoded = codec::decode(black_box(encoded)).expect("base64 failed");
+    black_box(decoded);
+}
+
+/// Full registration without key stretching and encoding.
+#[no_mangle]
+pub extern "C" fn opaque_bench_curve_registration() {
+    let (setup, _) = curve_only_setup();
+    black_box(register(setup));
+}
+
+/// Full login without key stretching and encoding.
+#[no_mangle]
+pub extern "C" fn opaque_bench_curve_login() {
+    let (setup, record) = curve_only_setup();
+    let mut rng = crate::rng::protocol_rng();
+    let client_start = ClientLogin::<CurveOnlyCipherSuite>::start(&mut rng, PASSWORD)
+        .expect("client login start failed");
+    let server_start = ServerLogin::start(
+        &mut rng,
+        setup,
+        Some(record.clone()),
+        client_start.message,
+        USER_IDENTIFIER,
+        ServerLoginStartParameters::default(),
+    )
+    .expect("server login start failed");
+    let client_finish = client_start
+        .state
+        .finish(
+            PASSWORD,
+            server_start.message,
+            ClientLoginFinishParameters::default(),
+        )
+        .expect("client login finish failed");
+    let server_finish = server_start
+        .state
+        .finish(client_finish.message)
+        .expect("server login finish failed");
+    black_box(server_finish.session_key);
+}
+
+fn curve_only_setup() -> &'static (
+    ServerSetup<CurveOnlyCipherSuite>,
+    ServerRegistration<CurveOnlyCipherSuite>,
+) {
+    static SETUP: OnceLock<(
+        ServerSetup<CurveOnlyCipherSuite>,
+        ServerRegistration<CurveOnlyCipherSuite>,
+    )> = OnceLock::new();
+    SETUP.get_or_init(|| {
+        let setup = ServerSetup::<CurveOnlyCipherSuite>::new(&mut OsRng);
+        let record = register(&setup);
+        (setup, record)
+    })
+}
+
+fn register(setup: &ServerSetup<CurveOnlyCipherSuite>) -> ServerRegistration<CurveOnlyCipherSuite> {
+    let mut rng = crate::rng::protocol_rng();
+    let client_start = ClientRegistration::<CurveOnlyCipherSuite>::start(&mut rng, PASSWORD)
+        .expect("client registration start failed");
+    let server_start = ServerRegistration::start(setup, client_start.message, USER_IDENTIFIER)
+        .expect("server registration start failed");
+    let client_finish = client_start
+        .state
+        .finish(
+            &mut rng,
+            PASSWORD,
+            server_start.message,
+            ClientRegistrationFinishParameters::default(),
+        )
+        .expect("client registration finish failed");
+    ServerRegistration::finish(client_finish.message)
+}
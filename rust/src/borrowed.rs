@@ -0,0 +1,216 @@
+//! The `*_into` variants of the string API. They borrow their inputs from
+//! the caller and decode them on the stack, and they write the base64
+//! encoded outputs back to back into a buffer provided by the caller. Apart
+//! from the protocol itself (mostly the Argon2 memory) they don't allocate.
+
+use crate::codec;
+use crate::metrics::{self, Phase};
+use crate::opaque_ffi::{
+    OpaqueCipherSuite, OpaqueCreateServerRegistrationResponseInput, OpaqueFinishClientLoginInput,
+    OpaqueFinishClientLoginOutput, OpaqueFinishClientRegistrationInput,
+    OpaqueFinishClientRegistrationOutput, OpaqueFinishServerLoginInput,
+    OpaqueStartClientLoginOutput, OpaqueStartClientRegistrationOutput, OpaqueStartServerLoginInput,
+    OpaqueStartServerLoginOutput,
+};
+use crate::{
+    from_base64_error, ksf, with_setup, with_suite, Error, OpaqueResult, ServerSetupHandle,
+};
+
+/// Upper bound for the serialized size of every message, state and server
+/// setup of the supported cipher suites.
+pub(crate) const MAX_MESSAGE_LEN: usize = 1024;
+
+type MessageBuffer = [u8; MAX_MESSAGE_LEN];
+
+pub(crate) fn decode<'b>(
+    context: &'static str,
+    input: &str,
+    buf: &'b mut MessageBuffer,
+) -> OpaqueResult<&'b [u8]> {
+    if codec::decoded_len(input.len()).unwrap_or(0) > buf.len() {
+        return Err(Error::Input {
+            message: format!("\"{}\" is too long", context),
+        });
+    }
+    let len = metrics::time(Phase::Base64, || codec::decode_slice(input, &mut buf[..]))
+        .map_err(from_base64_error(context))?;
+    Ok(&buf[..len])
+}
+
+pub(crate) fn optional(value: &str, is_set: bool) -> Option<&str> {
+    is_set.then_some(value)
+}
+
+/// Appends the base64 encoded fields to the output buffer.
+pub(crate) struct Writer<'b> {
+    out: &'b mut [u8],
+    len: usize,
+}
+
+impl<'b> Writer<'b> {
+    pub(crate) fn new(out: &'b mut [u8]) -> Self {
+        Writer { out, len: 0 }
+    }
+
+    /// Returns the length of the encoded field.
+    pub(crate) fn write(&mut self, field: &[u8]) -> OpaqueResult<usize> {
+        let out = &mut self.out[self.len..];
+        let len =
+            metrics::time(Phase::Base64, || codec::encode_slice(field, out)).ok_or_else(|| {
+                Error::Input {
+                    message: "output buffer is too small".to_string(),
+                }
+            })?;
+        self.len += len;
+        Ok(len)
+    }
+}
+
+fn decode_server_setup(
+    server_setup: &str,
+    suite: OpaqueCipherSuite,
+) -> OpaqueResult<ServerSetupHandle> {
+    let mut buf = [0; MAX_MESSAGE_LEN];
+    ServerSetupHandle::deserialize(decode("serverSetup", server_setup, &mut buf)?, suite)
+}
+
+pub fn opaque_start_client_registration_into(
+    password: &str,
+    suite: OpaqueCipherSuite,
+    out: &mut [u8],
+) -> Result<OpaqueStartClientRegistrationOutput, Error> {
+    with_suite!(suite, engine => {
+        let result = engine::start_client_registration(password)?;
+        let mut writer = Writer::new(out);
+        Ok(OpaqueStartClientRegistrationOutput {
+            client_registration_state: writer.write(&result.state.serialize())?,
+            registration_request: writer.write(&result.message.serialize())?,
+        })
+    })
+}
+
+pub fn opaque_finish_client_registration_into(
+    input: OpaqueFinishClientRegistrationInput,
+    out: &mut [u8],
+) -> Result<OpaqueFinishClientRegistrationOutput, Error> {
+    let mut response_buf = [0; MAX_MESSAGE_LEN];
+    let mut state_buf = [0; MAX_MESSAGE_LEN];
+    let key_stretching = input.has_key_stretching.then_some(input.key_stretching);
+    with_suite!(input.suite, engine => {
+        let result = engine::finish_client_registration(
+            input.password,
+            decode(
+                "registrationResponse",
+                input.registration_response,
+                &mut response_buf,
+            )?,
+            decode(
+                "clientRegistrationState",
+                input.client_registration_state,
+                &mut state_buf,
+            )?,
+            optional(input.client_identifier, input.has_client_identifier),
+            optional(input.server_identifier, input.has_server_identifier),
+            key_stretching.as_ref(),
+        )?;
+        let mut writer = Writer::new(out);
+        Ok(OpaqueFinishClientRegistrationOutput {
+            registration_record: writer.write(&result.message.serialize())?,
+            export_key: writer.write(&result.export_key)?,
+            server_static_public_key: writer.write(&result.server_s_pk.serialize())?,
+            key_stretching: key_stretching.unwrap_or_else(ksf::default_params),
+        })
+    })
+}
+
+pub fn opaque_start_client_login_into(
+    password: &str,
+    suite: OpaqueCipherSuite,
+    out: &mut [u8],
+) -> Result<OpaqueStartClientLoginOutput, Error> {
+    with_suite!(suite, engine => {
+        let result = engine::start_client_login(password)?;
+        let mut writer = Writer::new(out);
+        Ok(OpaqueStartClientLoginOutput {
+            client_login_state: writer.write(&result.state.serialize())?,
+            start_login_request: writer.write(&result.message.serialize())?,
+        })
+    })
+}
+
+pub fn opaque_finish_client_login_into(
+    input: OpaqueFinishClientLoginInput,
+    out: &mut [u8],
+) -> Result<OpaqueFinishClientLoginOutput, Error> {
+    let mut state_buf = [0; MAX_MESSAGE_LEN];
+    let mut response_buf = [0; MAX_MESSAGE_LEN];
+    let key_stretching = input.has_key_stretching.then_some(input.key_stretching);
+    with_suite!(input.suite, engine => {
+        let result = engine::finish_client_login(
+            decode("clientLoginState", input.client_login_state, &mut state_buf)?,
+            decode("loginResponse", input.login_response, &mut response_buf)?,
+            input.password,
+            optional(input.client_identifier, input.has_client_identifier),
+            optional(input.server_identifier, input.has_server_identifier),
+            key_stretching.as_ref(),
+        )?;
+        engine::write_finish_client_login(result, out)
+    })
+}
+
+pub fn opaque_create_server_registration_response_into(
+    server_setup: &str,
+    input: OpaqueCreateServerRegistrationResponseInput,
+    out: &mut [u8],
+) -> Result<usize, Error> {
+    let server_setup = decode_server_setup(server_setup, input.suite)?;
+    opaque_create_server_registration_response_with_setup_into(&server_setup, input, out)
+}
+
+pub fn opaque_create_server_registration_response_with_setup_into(
+    server_setup: &ServerSetupHandle,
+    input: OpaqueCreateServerRegistrationResponseInput,
+    out: &mut [u8],
+) -> Result<usize, Error> {
+    with_setup!(server_setup, input.suite, setup, engine => {
+        engine::create_server_registration_response_into(setup, input, out)
+    })
+}
+
+pub fn opaque_start_server_login_into(
+    server_setup: &str,
+    input: OpaqueStartServerLoginInput,
+    out: &mut [u8],
+) -> Result<OpaqueStartServerLoginOutput, Error> {
+    let server_setup = decode_server_setup(server_setup, input.suite)?;
+    opaque_start_server_login_with_setup_into(&server_setup, input, out)
+}
+
+pub fn opaque_start_server_login_with_setup_into(
+    server_setup: &ServerSetupHandle,
+    input: OpaqueStartServerLoginInput,
+    out: &mut [u8],
+) -> Result<OpaqueStartServerLoginOutput, Error> {
+    with_setup!(server_setup, input.suite, setup, engine => {
+        engine::start_server_login_into(setup, input, out)
+    })
+}
+
+pub fn opaque_finish_server_login_into(
+    input: OpaqueFinishServerLoginInput,
+    out: &mut [u8],
+) -> Result<usize, Error> {
+    let mut state_buf = [0; MAX_MESSAGE_LEN];
+    let mut request_buf = [0; MAX_MESSAGE_LEN];
+    with_suite!(input.suite, engine => {
+        let result = engine::finish_server_login(
+            decode("serverLoginState", input.server_login_state, &mut state_buf)?,
+            decode(
+                "finishLoginRequest",
+                input.finish_login_request,
+                &mut request_buf,
+            )?,
+        )?;
+        Writer::new(out).write(&result.session_key)
+    })
+}
@@ -0,0 +1,660 @@
+//! The URL-safe base64 codec without padding of the string API.
+//!
+//! Messages, states and keys pass through it on every call, and many of
+//! them are secret (`session_key`, `export_key`, the login states). Unlike a
+//! table based codec it doesn't index memory with the data: the scalar code
+//! maps between 6 bit values and characters with arithmetic only, and the
+//! vector code uses byte shuffles within a register. The running time only
+//! depends on the length of the input. An invalid input is only detected
+//! after the whole input is decoded.
+//!
+//! Blocks of 12 bytes are encoded with SSSE3 on x86 (detected at runtime)
+//! and blocks of 48 bytes with NEON on aarch64. The input left over after
+//! the last whole block is copied into a padded block on the stack, so the
+//! vector code handles every byte. Other targets use the scalar code. There
+//! is no AVX2 variant: the messages are 32 to 320 bytes long, which leaves
+//! too few 24 byte blocks for the wider registers to pay off.
+//!
+//! Like the `URL_SAFE_NO_PAD` engine of the `base64` crate used before,
+//! decoding rejects padding and non-zero trailing bits.
+
+use std::fmt;
+
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum DecodeError {
+    /// The length leaves a single character in the last block.
+    InvalidLength,
+    /// A character outside of the URL-safe alphabet, including padding.
+    InvalidSymbol,
+    /// The unused bits of the last character are not zero.
+    InvalidLastSymbol,
+    /// The decoded bytes don't fit into the output buffer.
+    OutputTooSmall,
+}
+
+impl fmt::Display for DecodeError {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        match self {
+            // same message as the `base64` crate, which the web build uses
+            DecodeError::InvalidLength => write!(f, "Encoded text cannot have a 6-bit remainder."),
+            DecodeError::InvalidSymbol => write!(f, "invalid symbol"),
+            DecodeError::InvalidLastSymbol => write!(f, "invalid last symbol"),
+            DecodeError::OutputTooSmall => write!(f, "output buffer is too small"),
+        }
+    }
+}
+
+impl std::error::Error for DecodeError {}
+
+/// Length of the encoding of `len` bytes.
+pub const fn encoded_len(len: usize) -> usize {
+    len / 3 * 4 + (len % 3 * 4).div_ceil(3)
+}
+
+/// Length of the bytes encoded by `len` characters, `None` if no encoding
+/// has this length.
+pub const fn decoded_len(len: usize) -> Option<usize> {
+    match len % 4 {
+        1 => None,
+        rem => Some(len / 4 * 3 + rem * 3 / 4),
+    }
+}
+
+pub fn encode<T: AsRef<[u8]>>(input: T) -> String {
+    let input = input.as_ref();
+    let mut out = vec![0; encoded_len(input.len())];
+    let len = encode_slice(input, &mut out).expect("encoded length");
+    debug_assert_eq!(len, out.len());
+    // the alphabet is ASCII
+    String::from_utf8(out).expect("base64 is ASCII")
+}
+
+/// Encodes `input` into the front of `out` and returns the length of the
+/// encoding, `None` if `out` is too small.
+pub fn encode_slice(input: &[u8], out: &mut [u8]) -> Option<usize> {
+    let len = encoded_len(input.len());
+    let out = out.get_mut(..len)?;
+    if !simd::encode(input, out) {
+        scalar::encode(input, out);
+    }
+    Some(len)
+}
+
+pub fn decode<T: AsRef<[u8]>>(input: T) -> Result<Vec<u8>, DecodeError> {
+    let input = input.as_ref();
+    let len = decoded_len(input.len()).ok_or(DecodeError::InvalidLength)?;
+    let mut out = vec![0; len];
+    decode_slice(input, &mut out)?;
+    Ok(out)
+}
+
+/// Decodes `input` into the front of `out` and returns the decoded length.
+/// On error the front of `out` may hold partially decoded bytes.
+pub fn decode_slice<T: AsRef<[u8]>>(input: T, out: &mut [u8]) -> Result<usize, DecodeError> {
+    let input = input.as_ref();
+    let len = decoded_len(input.len()).ok_or(DecodeError::InvalidLength)?;
+    let out = out.get_mut(..len).ok_or(DecodeError::OutputTooSmall)?;
+    let valid = simd::decode(input, out).unwrap_or_else(|| scalar::decode(input, out));
+    if !valid {
+        Err(DecodeError::InvalidSymbol)
+    } else if scalar::has_trailing_bits(input) {
+        Err(DecodeError::InvalidLastSymbol)
+    } else {
+        Ok(len)
+    }
+}
+
+mod scalar {
+    /// Maps a 6 bit value to its character. Each step adds the distance
+    /// between two ranges of the alphabet if `src` is past the first one.
+    #[inline(always)]
+    fn encode_6bits(src: u8) -> u8 {
+        let src = i16::from(src);
+        let mut diff = i16::from(b'A');
+        // 'a' - 26 - 'A'
+        diff += ((25 - src) >> 8) & 6;
+        // '0' - 52 - ('a' - 26)
+        diff -= ((51 - src) >> 8) & 75;
+        // '-' - 62 - ('0' - 52)
+        diff -= ((61 - src) >> 8) & 13;
+        // '_' - 63 - ('-' - 62)
+        diff += ((62 - src) >> 8) & 49;
+        (src + diff) as u8
+    }
+
+    /// Maps a character to its 6 bit value, or -1 if it isn't in the
+    /// alphabet. `((lo - 1 - src) & (src - (hi + 1))) >> 8` is -1 if `src`
+    /// is in `lo..=hi` and 0 otherwise.
+    #[inline(always)]
+    fn decode_6bits(src: u8) -> i16 {
+        let src = i16::from(src);
+        let mut ret: i16 = -1;
+        // 'A'..='Z' => 0..=25
+        ret += (((0x40 - src) & (src - 0x5b)) >> 8) & (src - 64);
+        // 'a'..='z' => 26..=51
+        ret += (((0x60 - src) & (src - 0x7b)) >> 8) & (src - 70);
+        // '0'..='9' => 52..=61
+        ret += (((0x2f - src) & (src - 0x3a)) >> 8) & (src + 5);
+        // '-' => 62
+        ret += (((0x2c - src) & (src - 0x2e)) >> 8) & 63;
+        // '_' => 63
+        ret += (((0x5e - src) & (src - 0x60)) >> 8) & 64;
+        ret
+    }
+
+    /// `out` must have the encoded length of `input`.
+    pub(super) fn encode(input: &[u8], out: &mut [u8]) {
+        let mut chunks = input.chunks_exact(3);
+        let mut out_chunks = out.chunks_mut(4);
+        for (chunk, out) in chunks.by_ref().zip(out_chunks.by_ref()) {
+            let (b0, b1, b2) = (chunk[0], chunk[1], chunk[2]);
+            out[0] = encode_6bits(b0 >> 2);
+            out[1] = encode_6bits(((b0 << 4) | (b1 >> 4)) & 0x3f);
+            out[2] = encode_6bits(((b1 << 2) | (b2 >> 6)) & 0x3f);
+            out[3] = encode_6bits(b2 & 0x3f);
+        }
+        match (chunks.remainder(), out_chunks.next()) {
+            ([b0], Some(out)) => {
+                out[0] = encode_6bits(b0 >> 2);
+                out[1] = encode_6bits((b0 << 4) & 0x3f);
+            }
+            ([b0, b1], Some(out)) => {
+                out[0] = encode_6bits(b0 >> 2);
+                out[1] = encode_6bits(((b0 << 4) | (b1 >> 4)) & 0x3f);
+                out[2] = encode_6bits((b1 << 2) & 0x3f);
+            }
+            _ => {}
+        }
+    }
+
+    /// `out` must have the decoded length of `input`. Returns whether all
+    /// characters were valid.
+    pub(super) fn decode(input: &[u8], out: &mut [u8]) -> bool {
+        // negative once any character was invalid
+        let mut invalid: i16 = 0;
+        let mut chunks = input.chunks_exact(4);
+        let mut out_chunks = out.chunks_mut(3);
+        for (chunk, out) in chunks.by_ref().zip(out_chunks.by_ref()) {
+            let c0 = decode_6bits(chunk[0]);
+            let c1 = decode_6bits(chunk[1]);
+            let c2 = decode_6bits(chunk[2]);
+            let c3 = decode_6bits(chunk[3]);
+            invalid |= c0 | c1 | c2 | c3;
+            out[0] = ((c0 << 2) | (c1 >> 4)) as u8;
+            out[1] = ((c1 << 4) | (c2 >> 2)) as u8;
+            out[2] = ((c2 << 6) | c3) as u8;
+        }
+        match (chunks.remainder(), out_chunks.next()) {
+            ([s0, s1], Some(out)) => {
+                let c0 = decode_6bits(*s0);
+                let c1 = decode_6bits(*s1);
+                invalid |= c0 | c1;
+                out[0] = ((c0 << 2) | (c1 >> 4)) as u8;
+            }
+            ([s0, s1, s2], Some(out)) => {
+                let c0 = decode_6bits(*s0);
+                let c1 = decode_6bits(*s1);
+                let c2 = decode_6bits(*s2);
+                invalid |= c0 | c1 | c2;
+                out[0] = ((c0 << 2) | (c1 >> 4)) as u8;
+                out[1] = ((c1 << 4) | (c2 >> 2)) as u8;
+            }
+            _ => {}
+        }
+        invalid >= 0
+    }
+
+    /// Whether the unused bits of the last character of a valid input are
+    /// set.
+    pub(super) fn has_trailing_bits(input: &[u8]) -> bool {
+        let unused = match (input.len() % 4, input.last()) {
+            (2, Some(last)) => decode_6bits(*last) & 0x0f,
+            (3, Some(last)) => decode_6bits(*last) & 0x03,
+            _ => 0,
+        };
+        unused != 0
+    }
+}
+
+#[cfg(any(target_arch = "x86", target_arch = "x86_64"))]
+mod simd {
+    #[cfg(target_arch = "x86")]
+    use std::arch::x86::*;
+    #[cfg(target_arch = "x86_64")]
+    use std::arch::x86_64::*;
+
+    /// SSSE3 is part of the baseline of the Android x86_64 target, the
+    /// others detect it at runtime.
+    #[inline(always)]
+    fn has_ssse3() -> bool {
+        cfg!(target_feature = "ssse3") || is_x86_feature_detected!("ssse3")
+    }
+
+    /// Returns false if SSSE3 isn't available.
+    pub(super) fn encode(input: &[u8], out: &mut [u8]) -> bool {
+        if !has_ssse3() {
+            return false;
+        }
+        // SAFETY: SSSE3 is available
+        unsafe {
+            let (read, written) = encode_ssse3(input, out);
+            // less than 16 bytes are left, two zero padded blocks hold them
+            let rest = &input[read..];
+            let mut block = [0; 32];
+            block[..rest.len()].copy_from_slice(rest);
+            let mut chars = [0; 32];
+            encode_ssse3(&block, &mut chars);
+            let out = &mut out[written..];
+            out.copy_from_slice(&chars[..out.len()]);
+        }
+        true
+    }
+
+    /// Returns whether all characters were valid, `None` if SSSE3 isn't
+    /// available.
+    pub(super) fn decode(input: &[u8], out: &mut [u8]) -> Option<bool> {
+        if !has_ssse3() {
+            return None;
+        }
+        // SAFETY: SSSE3 is available
+        unsafe {
+            let (read, written, valid) = decode_ssse3(input, out);
+            // less than 22 characters are left, two blocks padded with 'A'
+            // (zero bits) hold them
+            let rest = &input[read..];
+            let mut block = [b'A'; 32];
+            block[..rest.len()].copy_from_slice(rest);
+            let mut bytes = [0; 32];
+            let (_, _, rest_valid) = decode_ssse3(&block, &mut bytes);
+            let out = &mut out[written..];
+            out.copy_from_slice(&bytes[..out.len()]);
+            Some(valid & rest_valid)
+        }
+    }
+
+    /// Reads 16 bytes and encodes the first 12 of them into 16 characters
+    /// per step. The bit shuffling follows Wojciech Muła's SSE base64
+    /// encoder.
+    #[target_feature(enable = "ssse3")]
+    unsafe fn encode_ssse3(input: &[u8], out: &mut [u8]) -> (usize, usize) {
+        // offset of a character from its 6 bit value, indexed by the range
+        // of the value
+        let lut = _mm_setr_epi8(
+            65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -17, 32, 0, 0,
+        );
+        let shuffle = _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+
+        let (mut read, mut written) = (0, 0);
+        while read + 16 <= input.len() && written + 16 <= out.len() {
+            let block = _mm_loadu_si128(input.as_ptr().add(read).cast());
+            let block = _mm_shuffle_epi8(block, shuffle);
+            // the four 6 bit values of every 3 bytes, one per byte
+            let t0 = _mm_and_si128(block, _mm_set1_epi32(0x0fc0fc00));
+            let t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+            let t2 = _mm_and_si128(block, _mm_set1_epi32(0x003f03f0));
+            let t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+            let values = _mm_or_si128(t1, t3);
+
+            // range index: 0 for 'A'..='Z', 1 for 'a'..='z', 2..=11 for the
+            // digits, 12 for '-' and 13 for '_'
+            let range = _mm_subs_epu8(values, _mm_set1_epi8(51));
+            let is_lower = _mm_cmpgt_epi8(values, _mm_set1_epi8(25));
+            let range = _mm_sub_epi8(range, is_lower);
+            let chars = _mm_add_epi8(values, _mm_shuffle_epi8(lut, range));
+
+            _mm_storeu_si128(out.as_mut_ptr().add(written).cast(), chars);
+            read += 12;
+            written += 16;
+        }
+        (read, written)
+    }
+
+    /// Decodes 16 characters into 12 bytes per step, writing 16. The
+    /// characters are validated with range comparisons of the whole
+    /// register, invalid ones are only reported at the end.
+    #[target_feature(enable = "ssse3")]
+    unsafe fn decode_ssse3(input: &[u8], out: &mut [u8]) -> (usize, usize, bool) {
+        let (mut read, mut written) = (0, 0);
+        let mut invalid = _mm_setzero_si128();
+        while read + 16 <= input.len() && written + 16 <= out.len() {
+            let chars = _mm_loadu_si128(input.as_ptr().add(read).cast());
+            // characters >= 0x80 are negative and in none of the ranges
+            let in_range = |lo: u8, hi: u8| {
+                _mm_and_si128(
+                    _mm_cmpgt_epi8(chars, _mm_set1_epi8(lo as i8 - 1)),
+                    _mm_cmpgt_epi8(_mm_set1_epi8(hi as i8 + 1), chars),
+                )
+            };
+            let upper = in_range(b'A', b'Z');
+            let lower = in_range(b'a', b'z');
+            let digit = in_range(b'0', b'9');
+            let dash = _mm_cmpeq_epi8(chars, _mm_set1_epi8(b'-' as i8));
+            let underscore = _mm_cmpeq_epi8(chars, _mm_set1_epi8(b'_' as i8));
+
+            let offset = _mm_or_si128(
+                _mm_or_si128(
+                    _mm_and_si128(upper, _mm_set1_epi8(-65)),
+                    _mm_and_si128(lower, _mm_set1_epi8(-71)),
+                ),
+                _mm_or_si128(
+                    _mm_and_si128(digit, _mm_set1_epi8(4)),
+                    _mm_or_si128(
+                        _mm_and_si128(dash, _mm_set1_epi8(17)),
+                        _mm_and_si128(underscore, _mm_set1_epi8(-32)),
+                    ),
+                ),
+            );
+            let valid = _mm_or_si128(
+                _mm_or_si128(upper, lower),
+                _mm_or_si128(digit, _mm_or_si128(dash, underscore)),
+            );
+            invalid = _mm_or_si128(invalid, _mm_cmpeq_epi8(valid, _mm_setzero_si128()));
+            let values = _mm_add_epi8(chars, offset);
+
+            // pack the 6 bit values into 3 bytes per 4 values
+            let pairs = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+            let words = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+            let bytes = _mm_shuffle_epi8(
+                words,
+                _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1),
+            );
+
+            _mm_storeu_si128(out.as_mut_ptr().add(written).cast(), bytes);
+            read += 16;
+            written += 12;
+        }
+        (read, written, _mm_movemask_epi8(invalid) == 0)
+    }
+}
+
+#[cfg(target_arch = "aarch64")]
+mod simd {
+    use std::arch::aarch64::*;
+
+    pub(super) fn encode(input: &[u8], out: &mut [u8]) -> bool {
+        // SAFETY: NEON is part of the aarch64 baseline
+        unsafe {
+            let (read, written) = encode_neon(input, out);
+            // less than 48 bytes are left, a zero padded block holds them
+            let rest = &input[read..];
+            let mut block = [0; 48];
+            block[..rest.len()].copy_from_slice(rest);
+            let mut chars = [0; 64];
+            encode_neon(&block, &mut chars);
+            let out = &mut out[written..];
+            out.copy_from_slice(&chars[..out.len()]);
+        }
+        true
+    }
+
+    /// Returns whether all characters were valid.
+    pub(super) fn decode(input: &[u8], out: &mut [u8]) -> Option<bool> {
+        // SAFETY: NEON is part of the aarch64 baseline
+        unsafe {
+            let (read, written, valid) = decode_neon(input, out);
+            // less than 64 characters are left, a block padded with 'A'
+            // (zero bits) holds them
+            let rest = &input[read..];
+            let mut block = [b'A'; 64];
+            block[..rest.len()].copy_from_slice(rest);
+            let mut bytes = [0; 48];
+            let (_, _, rest_valid) = decode_neon(&block, &mut bytes);
+            let out = &mut out[written..];
+            out.copy_from_slice(&bytes[..out.len()]);
+            Some(valid & rest_valid)
+        }
+    }
+
+    /// Maps 6 bit values to their characters, see `encode_ssse3` for the
+    /// offset table.
+    #[inline(always)]
+    unsafe fn translate(values: uint8x16_t, lut: uint8x16_t) -> uint8x16_t {
+        let range = vqsubq_u8(values, vdupq_n_u8(51));
+        let range = vsubq_u8(range, vcgtq_u8(values, vdupq_n_u8(25)));
+        vaddq_u8(values, vqtbl1q_u8(lut, range))
+    }
+
+    /// Encodes 48 bytes into 64 characters per step, deinterleaved into
+    /// one register per byte of a 3 byte group.
+    #[target_feature(enable = "neon")]
+    unsafe fn encode_neon(input: &[u8], out: &mut [u8]) -> (usize, usize) {
+        const LUT: [u8; 16] = [
+            65, 71, 252, 252, 252, 252, 252, 252, 252, 252, 252, 252, 239, 32, 0, 0,
+        ];
+        let lut = vld1q_u8(LUT.as_ptr());
+        let mask = vdupq_n_u8(0x3f);
+
+        let (mut read, mut written) = (0, 0);
+        while read + 48 <= input.len() && written + 64 <= out.len() {
+            let uint8x16x3_t(b0, b1, b2) = vld3q_u8(input.as_ptr().add(read));
+            let v0 = vshrq_n_u8::<2>(b0);
+            let v1 = vandq_u8(vorrq_u8(vshlq_n_u8::<4>(b0), vshrq_n_u8::<4>(b1)), mask);
+            let v2 = vandq_u8(vorrq_u8(vshlq_n_u8::<2>(b1), vshrq_n_u8::<6>(b2)), mask);
+            let v3 = vandq_u8(b2, mask);
+            vst4q_u8(
+                out.as_mut_ptr().add(written),
+                uint8x16x4_t(
+                    translate(v0, lut),
+                    translate(v1, lut),
+                    translate(v2, lut),
+                    translate(v3, lut),
+                ),
+            );
+            read += 48;
+            written += 64;
+        }
+        (read, written)
+    }
+
+    /// Maps characters to their 6 bit values and sets the lanes of
+    /// `invalid` of the characters outside of the alphabet.
+    #[inline(always)]
+    unsafe fn values(chars: uint8x16_t, invalid: &mut uint8x16_t) -> uint8x16_t {
+        let in_range = |lo: u8, hi: u8| {
+            vandq_u8(
+                vcgeq_u8(chars, vdupq_n_u8(lo)),
+                vcleq_u8(chars, vdupq_n_u8(hi)),
+            )
+        };
+        let upper = in_range(b'A', b'Z');
+        let lower = in_range(b'a', b'z');
+        let digit = in_range(b'0', b'9');
+        let dash = vceqq_u8(chars, vdupq_n_u8(b'-'));
+        let underscore = vceqq_u8(chars, vdupq_n_u8(b'_'));
+
+        let offset = vorrq_u8(
+            vorrq_u8(
+                vandq_u8(upper, vdupq_n_u8(65u8.wrapping_neg())),
+                vandq_u8(lower, vdupq_n_u8(71u8.wrapping_neg())),
+            ),
+            vorrq_u8(
+                vandq_u8(digit, vdupq_n_u8(4)),
+                vorrq_u8(
+                    vandq_u8(dash, vdupq_n_u8(17)),
+                    vandq_u8(underscore, vdupq_n_u8(32u8.wrapping_neg())),
+                ),
+            ),
+        );
+        let valid = vorrq_u8(
+            vorrq_u8(upper, lower),
+            vorrq_u8(digit, vorrq_u8(dash, underscore)),
+        );
+        *invalid = vorrq_u8(*invalid, vmvnq_u8(valid));
+        vaddq_u8(chars, offset)
+    }
+
+    /// Decodes 64 characters into 48 bytes per step, the inverse of
+    /// `encode_neon`.
+    #[target_feature(enable = "neon")]
+    unsafe fn decode_neon(input: &[u8], out: &mut [u8]) -> (usize, usize, bool) {
+        let (mut read, mut written) = (0, 0);
+        let mut invalid = vdupq_n_u8(0);
+        while read + 64 <= input.len() && written + 48 <= out.len() {
+            let uint8x16x4_t(c0, c1, c2, c3) = vld4q_u8(input.as_ptr().add(read));
+            let v0 = values(c0, &mut invalid);
+            let v1 = values(c1, &mut invalid);
+            let v2 = values(c2, &mut invalid);
+            let v3 = values(c3, &mut invalid);
+            vst3q_u8(
+                out.as_mut_ptr().add(written),
+                uint8x16x3_t(
+                    vorrq_u8(vshlq_n_u8::<2>(v0), vshrq_n_u8::<4>(v1)),
+                    vorrq_u8(vshlq_n_u8::<4>(v1), vshrq_n_u8::<2>(v2)),
+                    vorrq_u8(vshlq_n_u8::<6>(v2), v3),
+                ),
+            );
+            read += 64;
+            written += 48;
+        }
+        (read, written, vmaxvq_u8(invalid) == 0)
+    }
+}
+
+#[cfg(not(any(target_arch = "x86", target_arch = "x86_64", target_arch = "aarch64")))]
+mod simd {
+    pub(super) fn encode(_input: &[u8], _out: &mut [u8]) -> bool {
+        false
+    }
+
+    pub(super) fn decode(_input: &[u8], _out: &mut [u8]) -> Option<bool> {
+        None
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    const ALPHABET: &[u8] = b"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+    /// Straightforward table based reference codec.
+    fn reference_encode(input: &[u8]) -> String {
+        let mut out = String::new();
+        for chunk in input.chunks(3) {
+            let bits = chunk
+                .iter()
+                .enumerate()
+                .fold(0u32, |bits, (i, b)| bits | u32::from(*b) << (16 - 8 * i));
+            for i in 0..=chunk.len() {
+                out.push(ALPHABET[(bits >> (18 - 6 * i) & 0x3f) as usize] as char);
+            }
+        }
+        out
+    }
+
+    fn bytes(len: usize, seed: u32) -> Vec<u8> {
+        let mut state = seed.wrapping_mul(0x9e37_79b9) | 1;
+        (0..len)
+            .map(|_| {
+                state ^= state << 13;
+                state ^= state >> 17;
+                state ^= state << 5;
+                state as u8
+            })
+            .collect()
+    }
+
+    #[test]
+    fn round_trips_all_lengths() {
+        for len in 0..400 {
+            let input = bytes(len, len as u32);
+            let encoded = encode(&input);
+            assert_eq!(encoded, reference_encode(&input), "length {}", len);
+            assert_eq!(encoded.len(), encoded_len(len));
+            assert_eq!(decode(&encoded).unwrap(), input, "length {}", len);
+        }
+    }
+
+    #[test]
+    fn scalar_code_round_trips() {
+        for len in 0..100 {
+            let input = bytes(len, len as u32 + 1);
+            let mut encoded = vec![0; encoded_len(len)];
+            scalar::encode(&input, &mut encoded);
+            assert_eq!(encoded, reference_encode(&input).into_bytes());
+            let mut decoded = vec![0; len];
+            assert!(scalar::decode(&encoded, &mut decoded));
+            assert_eq!(decoded, input);
+            if let Some(last) = encoded.last_mut() {
+                *last = b'=';
+                assert!(!scalar::decode(&encoded, &mut decoded));
+            }
+        }
+    }
+
+    #[test]
+    fn covers_the_whole_alphabet() {
+        // every 6 bit value in every position of a block
+        let input: Vec<u8> = (0..=255).chain((0..=255).rev()).collect();
+        let encoded = encode(&input);
+        assert_eq!(encoded, reference_encode(&input));
+        assert_eq!(decode(&encoded).unwrap(), input);
+        let all = encode(
+            ALPHABET
+                .chunks(4)
+                .flat_map(|chunk| {
+                    let v: Vec<u32> = chunk
+                        .iter()
+                        .map(|c| ALPHABET.iter().position(|a| a == c).unwrap() as u32)
+                        .collect();
+                    let bits = v[0] << 18 | v[1] << 12 | v[2] << 6 | v[3];
+                    [(bits >> 16) as u8, (bits >> 8) as u8, bits as u8]
+                })
+                .collect::<Vec<_>>(),
+        );
+        assert_eq!(all.as_bytes(), ALPHABET);
+    }
+
+    #[test]
+    fn rejects_every_invalid_symbol() {
+        let valid = encode(bytes(96, 7));
+        for position in [0, 5, 17, 63, 64, 100, valid.len() - 1] {
+            for symbol in 0..=255u8 {
+                if ALPHABET.contains(&symbol) {
+                    continue;
+                }
+                let mut input = valid.clone().into_bytes();
+                input[position] = symbol;
+                assert_eq!(
+                    decode(&input),
+                    Err(DecodeError::InvalidSymbol),
+                    "symbol {} at {}",
+                    symbol,
+                    position
+                );
+            }
+        }
+    }
+
+    #[test]
+    fn rejects_padding_and_invalid_lengths() {
+        assert_eq!(decode("QQ=="), Err(DecodeError::InvalidSymbol));
+        assert_eq!(decode("QUI="), Err(DecodeError::InvalidSymbol));
+        assert_eq!(decode("Q"), Err(DecodeError::InvalidLength));
+        assert_eq!(decode("QUJDR"), Err(DecodeError::InvalidLength));
+        assert_eq!(decode("").unwrap(), Vec::<u8>::new());
+    }
+
+    #[test]
+    fn rejects_non_zero_trailing_bits() {
+        assert_eq!(decode("QQ").unwrap(), b"A");
+        assert_eq!(decode("QR"), Err(DecodeError::InvalidLastSymbol));
+        assert_eq!(decode("QUI").unwrap(), b"AB");
+        assert_eq!(decode("QUJ"), Err(DecodeError::InvalidLastSymbol));
+    }
+
+    #[test]
+    fn checks_the_output_size() {
+        let encoded = encode(bytes(64, 1));
+        let mut out = [0; 63];
+        assert_eq!(
+            decode_slice(&encoded, &mut out),
+            Err(DecodeError::OutputTooSmall)
+        );
+        let mut out = [0; 85];
+        assert_eq!(encode_slice(&bytes(64, 1), &mut out), None);
+        let mut out = [0; 100];
+        assert_eq!(encode_slice(&bytes(64, 1), &mut out), Some(86));
+        assert_eq!(&out[..86], encoded.as_bytes());
+    }
+}
@@ -0,0 +1,151 @@
+//! Detection of the CPU cores the key stretching lanes can run on.
+
+#[cfg(not(target_vendor = "apple"))]
+use std::fs;
+use std::sync::OnceLock;
+use std::thread;
+
+use crate::opaque_ffi::OpaqueCpuTopology;
+
+/// The detected topology, cached since it doesn't change while the app runs.
+pub fn topology() -> OpaqueCpuTopology {
+    static TOPOLOGY: OnceLock<OpaqueCpuTopology> = OnceLock::new();
+    *TOPOLOGY.get_or_init(detect)
+}
+
+fn detect() -> OpaqueCpuTopology {
+    let cores = thread::available_parallelism().map_or(1, |n| n.get() as u32);
+    // all cores count where the clusters can't be told apart
+    let performance_cores = performance_cores().unwrap_or(cores);
+    OpaqueCpuTopology {
+        cores,
+        performance_cores: performance_cores.clamp(1, cores),
+    }
+}
+
+/// The logical cores of the fastest cluster, `hw.perflevel0` is missing
+/// before iOS 15 and on Intel Macs.
+#[cfg(target_vendor = "apple")]
+fn performance_cores() -> Option<u32> {
+    const NAME: &[u8] = b"hw.perflevel0.logicalcpu\0";
+    let mut value: libc::c_int = 0;
+    let mut size = std::mem::size_of::<libc::c_int>();
+    // SAFETY: NAME is nul-terminated and `value` is a writable buffer of
+    // `size` bytes.
+    let result = unsafe {
+        libc::sysctlbyname(
+            NAME.as_ptr().cast(),
+            (&mut value as *mut libc::c_int).cast(),
+            &mut size,
+            std::ptr::null_mut(),
+            0,
+        )
+    };
+    (result == 0 && value > 0).then_some(value as u32)
+}
+
+#[cfg(not(target_vendor = "apple"))]
+fn performance_cores() -> Option<u32> {
+    max_frequencies().map(|frequencies| count_performance_cores(&frequencies))
+}
+
+/// A cluster only counts as efficiency cores if the fastest cores run at
+/// least this much faster. The favored cores of x86 CPUs (Turbo Boost Max)
+/// only boost a few percent higher than the other cores of the same kind.
+#[cfg(not(target_vendor = "apple"))]
+const MIN_EFFICIENCY_GAP_PERCENT: u64 = 20;
+
+/// The cores clearly faster than the slowest ones, or all cores if there
+/// are no such cores.
+#[cfg(not(target_vendor = "apple"))]
+fn count_performance_cores(frequencies: &[u64]) -> u32 {
+    let lowest = frequencies.iter().min().copied().unwrap_or_default();
+    let threshold = lowest.saturating_mul(100 + MIN_EFFICIENCY_GAP_PERCENT);
+    match frequencies
+        .iter()
+        .filter(|&&f| f.saturating_mul(100) >= threshold)
+        .count()
+    {
+        0 => frequencies.len() as u32,
+        n => n as u32,
+    }
+}
+
+/// The maximum frequency of every online core from the Linux (Android)
+/// cpufreq sysfs interface.
+#[cfg(not(target_vendor = "apple"))]
+fn max_frequencies() -> Option<Vec<u64>> {
+    let online = fs::read_to_string("/sys/devices/system/cpu/online")
+        .ok()
+        .and_then(|list| parse_cpu_list(&list));
+    let frequencies: Vec<u64> = fs::read_dir("/sys/devices/system/cpu")
+        .ok()?
+        .filter_map(|entry| {
+            let entry = entry.ok()?;
+            let name = entry.file_name();
+            let id: u32 = name.to_str()?.strip_prefix("cpu")?.parse().ok()?;
+            // the cpufreq directory of an offline core can remain
+            if online.as_ref().is_some_and(|online| !online.contains(&id)) {
+                return None;
+            }
+            fs::read_to_string(entry.path().join("cpufreq/cpuinfo_max_freq"))
+                .ok()?
+                .trim()
+                .parse()
+                .ok()
+        })
+        .collect();
+    (!frequencies.is_empty()).then_some(frequencies)
+}
+
+/// Parses a sysfs CPU list like "0-3,6".
+#[cfg(not(target_vendor = "apple"))]
+fn parse_cpu_list(list: &str) -> Option<Vec<u32>> {
+    let mut cpus = Vec::new();
+    for range in list.trim().split(',') {
+        let (first, last): (u32, u32) = match range.split_once('-') {
+            Some((first, last)) => (first.parse().ok()?, last.parse().ok()?),
+            None => {
+                let cpu = range.parse().ok()?;
+                (cpu, cpu)
+            }
+        };
+        if first > last {
+            return None;
+        }
+        cpus.extend(first..=last);
+    }
+    Some(cpus)
+}
+
+#[cfg(all(test, not(target_vendor = "apple")))]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn counts_the_faster_clusters() {
+        // little, big and prime cluster
+        let frequencies = [
+            1_800_000, 1_800_000, 1_800_000, 1_800_000, 2_400_000, 2_400_000, 3_000_000,
+        ];
+        assert_eq!(count_performance_cores(&frequencies), 3);
+    }
+
+    #[test]
+    fn counts_all_cores_of_one_kind() {
+        assert_eq!(count_performance_cores(&[2_000_000; 4]), 4);
+        // two favored cores boosting a little higher
+        let frequencies = [
+            5_000_000, 5_000_000, 4_900_000, 4_900_000, 4_900_000, 4_900_000,
+        ];
+        assert_eq!(count_performance_cores(&frequencies), 6);
+    }
+
+    #[test]
+    fn parses_cpu_lists() {
+        assert_eq!(parse_cpu_list("0-3,6\n"), Some(vec![0, 1, 2, 3, 6]));
+        assert_eq!(parse_cpu_list("0"), Some(vec![0]));
+        assert_eq!(parse_cpu_list("3-1"), None);
+        assert_eq!(parse_cpu_list(""), None);
+    }
+}
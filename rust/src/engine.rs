@@ -0,0 +1,412 @@
+// The protocol functions of one cipher suite. This file is included once per
+// suite by lib.rs, inside a module which defines `CS` as the suite, so every
+// supported suite gets its own monomorphized copy. The public functions in
+// lib.rs and borrowed.rs pick the copy matching the suite tag of a call.
+
+use opaque_ke::rand::rngs::OsRng;
+use opaque_ke::{
+    ClientLogin, ClientLoginFinishParameters, ClientLoginFinishResult, ClientLoginStartResult,
+    ClientRegistration, ClientRegistrationFinishParameters, ClientRegistrationFinishResult,
+    ClientRegistrationStartResult, CredentialFinalization, CredentialRequest, CredentialResponse,
+    Identifiers, RegistrationRequest, RegistrationResponse, ServerLogin, ServerLoginFinishResult,
+    ServerLoginStartParameters, ServerLoginStartResult, ServerRegistration,
+    ServerRegistrationStartResult, ServerSetup,
+};
+
+use crate::borrowed::{decode, optional, Writer, MAX_MESSAGE_LEN};
+use crate::metrics::{self, Phase};
+use crate::opaque_ffi::{
+    OpaqueCreateServerRegistrationResponseBinaryResult,
+    OpaqueCreateServerRegistrationResponseInput, OpaqueCreateServerRegistrationResponseParams,
+    OpaqueCreateServerRegistrationResponseResult, OpaqueFinishClientLoginOutput,
+    OpaqueKeyStretchingParams, OpaqueStartServerLoginBinaryResult, OpaqueStartServerLoginInput,
+    OpaqueStartServerLoginOutput, OpaqueStartServerLoginParams, OpaqueStartServerLoginResult,
+};
+use crate::{
+    base64_decode, base64_encode, from_protocol_error, get_optional_string, ksf, rng, Error,
+    OpaqueResult,
+};
+
+pub(crate) fn create_server_setup() -> Vec<u8> {
+    // long-term keys, always drawn from the OS regardless of the `chacha-rng` feature
+    let mut rng = OsRng;
+    let setup = ServerSetup::<CS>::new(&mut rng);
+    setup.serialize().to_vec()
+}
+
+pub(crate) fn deserialize_server_setup(data: &[u8]) -> Result<ServerSetup<CS>, Error> {
+    metrics::time(Phase::Deserialize, || ServerSetup::<CS>::deserialize(data))
+        .map_err(from_protocol_error("deserialize serverSetup"))
+}
+
+pub(crate) fn get_server_public_key(server_setup: &ServerSetup<CS>) -> Vec<u8> {
+    server_setup.keypair().public().serialize().to_vec()
+}
+
+pub(crate) fn create_server_registration_response_base64(
+    server_setup: &ServerSetup<CS>,
+    params: OpaqueCreateServerRegistrationResponseParams,
+) -> Result<OpaqueCreateServerRegistrationResponseResult, Error> {
+    let registration_request_bytes =
+        base64_decode("registrationRequest", params.registration_request)?;
+    let result = create_server_registration_response(
+        server_setup,
+        params.user_identifier.as_bytes(),
+        &registration_request_bytes,
+    )?;
+    Ok(OpaqueCreateServerRegistrationResponseResult {
+        registration_response: base64_encode(result.registration_response),
+    })
+}
+
+pub(crate) fn create_server_registration_response(
+    server_setup: &ServerSetup<CS>,
+    user_identifier: &[u8],
+    registration_request: &[u8],
+) -> Result<OpaqueCreateServerRegistrationResponseBinaryResult, Error> {
+    let server_registration_start_result =
+        start_server_registration(server_setup, user_identifier, registration_request)?;
+    Ok(OpaqueCreateServerRegistrationResponseBinaryResult {
+        registration_response: server_registration_start_result
+            .message
+            .serialize()
+            .to_vec(),
+    })
+}
+
+pub(crate) fn create_server_registration_response_into(
+    server_setup: &ServerSetup<CS>,
+    input: OpaqueCreateServerRegistrationResponseInput,
+    out: &mut [u8],
+) -> Result<usize, Error> {
+    let mut request_buf = [0; MAX_MESSAGE_LEN];
+    let result = start_server_registration(
+        server_setup,
+        input.user_identifier.as_bytes(),
+        decode(
+            "registrationRequest",
+            input.registration_request,
+            &mut request_buf,
+        )?,
+    )?;
+    Writer::new(out).write(&result.message.serialize())
+}
+
+fn start_server_registration(
+    server_setup: &ServerSetup<CS>,
+    user_identifier: &[u8],
+    registration_request: &[u8],
+) -> Result<ServerRegistrationStartResult<CS>, Error> {
+    let registration_request = metrics::time(Phase::Deserialize, || {
+        RegistrationRequest::deserialize(registration_request)
+    })
+    .map_err(from_protocol_error("deserialize registrationRequest"))?;
+    metrics::time(Phase::Group, || {
+        ServerRegistration::<CS>::start(server_setup, registration_request, user_identifier)
+    })
+    .map_err(from_protocol_error("start serverRegistration"))
+}
+
+pub(crate) fn start_server_login_base64(
+    server_setup: &ServerSetup<CS>,
+    params: OpaqueStartServerLoginParams,
+) -> Result<OpaqueStartServerLoginResult, Error> {
+    let result = start_server_login_params(server_setup, params)?;
+    Ok(OpaqueStartServerLoginResult {
+        server_login_state: base64_encode(result.state.serialize()),
+        login_response: base64_encode(result.message.serialize()),
+    })
+}
+
+pub(crate) fn start_server_login_params(
+    server_setup: &ServerSetup<CS>,
+    params: OpaqueStartServerLoginParams,
+) -> Result<ServerLoginStartResult<CS>, Error> {
+    let registration_record_param = get_optional_string(params.registration_record)?;
+    let registration_record_bytes = match registration_record_param {
+        Some(pw) => base64_decode("registrationRecord", pw).map(Some),
+        None => Ok(None),
+    }?;
+    let credential_request_bytes = base64_decode("startLoginRequest", params.start_login_request)?;
+
+    let client_identifier = get_optional_string(params.client_identifier)?;
+    let server_identifier = get_optional_string(params.server_identifier)?;
+
+    start_server_login(
+        server_setup,
+        registration_record_bytes.as_deref(),
+        &credential_request_bytes,
+        params.user_identifier.as_bytes(),
+        client_identifier.as_deref(),
+        server_identifier.as_deref(),
+    )
+}
+
+pub(crate) fn start_server_login_binary(
+    server_setup: &ServerSetup<CS>,
+    registration_record: Option<&[u8]>,
+    start_login_request: &[u8],
+    user_identifier: &[u8],
+    client_identifier: Vec<String>,
+    server_identifier: Vec<String>,
+) -> Result<OpaqueStartServerLoginBinaryResult, Error> {
+    let client_identifier = get_optional_string(client_identifier)?;
+    let server_identifier = get_optional_string(server_identifier)?;
+    let result = start_server_login(
+        server_setup,
+        registration_record,
+        start_login_request,
+        user_identifier,
+        client_identifier.as_deref(),
+        server_identifier.as_deref(),
+    )?;
+    Ok(OpaqueStartServerLoginBinaryResult {
+        server_login_state: result.state.serialize().to_vec(),
+        login_response: result.message.serialize().to_vec(),
+    })
+}
+
+pub(crate) fn start_server_login_into(
+    server_setup: &ServerSetup<CS>,
+    input: OpaqueStartServerLoginInput,
+    out: &mut [u8],
+) -> Result<OpaqueStartServerLoginOutput, Error> {
+    let mut record_buf = [0; MAX_MESSAGE_LEN];
+    let mut request_buf = [0; MAX_MESSAGE_LEN];
+    let registration_record = if input.has_registration_record {
+        Some(decode(
+            "registrationRecord",
+            input.registration_record,
+            &mut record_buf,
+        )?)
+    } else {
+        None
+    };
+    let result = start_server_login(
+        server_setup,
+        registration_record,
+        decode(
+            "startLoginRequest",
+            input.start_login_request,
+            &mut request_buf,
+        )?,
+        input.user_identifier.as_bytes(),
+        optional(input.client_identifier, input.has_client_identifier),
+        optional(input.server_identifier, input.has_server_identifier),
+    )?;
+    let mut writer = Writer::new(out);
+    Ok(OpaqueStartServerLoginOutput {
+        server_login_state: writer.write(&result.state.serialize())?,
+        login_response: writer.write(&result.message.serialize())?,
+    })
+}
+
+fn start_server_login(
+    server_setup: &ServerSetup<CS>,
+    registration_record: Option<&[u8]>,
+    start_login_request: &[u8],
+    user_identifier: &[u8],
+    client_identifier: Option<&str>,
+    server_identifier: Option<&str>,
+) -> Result<ServerLoginStartResult<CS>, Error> {
+    let mut rng = rng::protocol_rng();
+
+    let registration_record = match registration_record {
+        Some(bytes) => Some(
+            metrics::time(Phase::Deserialize, || {
+                ServerRegistration::<CS>::deserialize(bytes)
+            })
+            .map_err(from_protocol_error("deserialize registrationRecord"))?,
+        ),
+        None => None,
+    };
+
+    let start_params = ServerLoginStartParameters {
+        identifiers: Identifiers {
+            client: client_identifier.map(str::as_bytes),
+            server: server_identifier.map(str::as_bytes),
+        },
+        context: None,
+    };
+
+    let credential_request = metrics::time(Phase::Deserialize, || {
+        CredentialRequest::deserialize(start_login_request)
+    })
+    .map_err(from_protocol_error("deserialize startLoginRequest"))?;
+
+    metrics::time(Phase::Group, || {
+        ServerLogin::start(
+            &mut rng,
+            server_setup,
+            registration_record,
+            credential_request,
+            user_identifier,
+            start_params,
+        )
+    })
+    .map_err(from_protocol_error("start server login"))
+}
+
+pub(crate) fn finish_server_login(
+    server_login_state: &[u8],
+    finish_login_request: &[u8],
+) -> Result<ServerLoginFinishResult<CS>, Error> {
+    let state = metrics::time(Phase::Deserialize, || {
+        ServerLogin::<CS>::deserialize(server_login_state)
+    })
+    .map_err(from_protocol_error("deserialize serverLoginState"))?;
+    finish_server_login_state(state, finish_login_request)
+}
+
+pub(crate) fn finish_server_login_state(
+    state: ServerLogin<CS>,
+    finish_login_request: &[u8],
+) -> Result<ServerLoginFinishResult<CS>, Error> {
+    let credential_finalization = metrics::time(Phase::Deserialize, || {
+        CredentialFinalization::deserialize(finish_login_request)
+    })
+    .map_err(from_protocol_error("deserialize finishLoginRequest"))?;
+    metrics::time(Phase::Group, || state.finish(credential_finalization))
+        .map_err(from_protocol_error("finish server login"))
+}
+
+pub(crate) fn start_client_registration(
+    password: &str,
+) -> Result<ClientRegistrationStartResult<CS>, Error> {
+    let mut client_rng = rng::protocol_rng();
+    metrics::time(Phase::Group, || {
+        ClientRegistration::<CS>::start(&mut client_rng, password.as_bytes())
+    })
+    .map_err(from_protocol_error("start client registration"))
+}
+
+pub(crate) fn finish_client_registration(
+    password: &str,
+    registration_response: &[u8],
+    client_registration_state: &[u8],
+    client_identifier: Option<&str>,
+    server_identifier: Option<&str>,
+    key_stretching: Option<&OpaqueKeyStretchingParams>,
+) -> Result<ClientRegistrationFinishResult<CS>, Error> {
+    let mut rng = rng::protocol_rng();
+    let state = metrics::time(Phase::Deserialize, || {
+        ClientRegistration::<CS>::deserialize(client_registration_state)
+    })
+    .map_err(from_protocol_error("deserialize clientRegistrationState"))?;
+
+    let argon2 = key_stretching.map(ksf::argon2).transpose()?;
+
+    let finish_params = ClientRegistrationFinishParameters::new(
+        Identifiers {
+            client: client_identifier.map(str::as_bytes),
+            server: server_identifier.map(str::as_bytes),
+        },
+        argon2.as_ref(),
+    );
+
+    let registration_response = metrics::time(Phase::Deserialize, || {
+        RegistrationResponse::deserialize(registration_response)
+    })
+    .map_err(from_protocol_error("deserialize registrationResponse"))?;
+
+    metrics::time(Phase::Group, || {
+        state.finish(
+            &mut rng,
+            password.as_bytes(),
+            registration_response,
+            finish_params,
+        )
+    })
+    .map_err(from_protocol_error("finish client registration"))
+}
+
+pub(crate) fn start_client_login(password: &str) -> Result<ClientLoginStartResult<CS>, Error> {
+    let mut client_rng = rng::protocol_rng();
+    metrics::time(Phase::Group, || {
+        ClientLogin::<CS>::start(&mut client_rng, password.as_bytes())
+    })
+    .map_err(from_protocol_error("start clientLogin"))
+}
+
+/// Returns `None` if the client detected a login failure, e.g. because of a
+/// wrong password.
+pub(crate) fn finish_client_login(
+    client_login_state: &[u8],
+    login_response: &[u8],
+    password: &str,
+    client_identifier: Option<&str>,
+    server_identifier: Option<&str>,
+    key_stretching: Option<&OpaqueKeyStretchingParams>,
+) -> Result<Option<ClientLoginFinishResult<CS>>, Error> {
+    let state = metrics::time(Phase::Deserialize, || {
+        ClientLogin::<CS>::deserialize(client_login_state)
+    })
+    .map_err(from_protocol_error("deserialize clientLoginState"))?;
+    finish_client_login_state(
+        state,
+        login_response,
+        password,
+        client_identifier,
+        server_identifier,
+        key_stretching,
+    )
+}
+
+/// Same as `finish_client_login` for a state that was kept instead of
+/// serialized, see `ClientLoginContext`.
+pub(crate) fn finish_client_login_state(
+    state: ClientLogin<CS>,
+    login_response: &[u8],
+    password: &str,
+    client_identifier: Option<&str>,
+    server_identifier: Option<&str>,
+    key_stretching: Option<&OpaqueKeyStretchingParams>,
+) -> Result<Option<ClientLoginFinishResult<CS>>, Error> {
+    let argon2 = key_stretching.map(ksf::argon2).transpose()?;
+
+    let finish_params = ClientLoginFinishParameters::new(
+        None,
+        Identifiers {
+            client: client_identifier.map(str::as_bytes),
+            server: server_identifier.map(str::as_bytes),
+        },
+        argon2.as_ref(),
+    );
+
+    let credential_response = metrics::time(Phase::Deserialize, || {
+        CredentialResponse::deserialize(login_response)
+    })
+    .map_err(from_protocol_error("deserialize loginResponse"))?;
+
+    let result = metrics::time(Phase::Group, || {
+        state.finish(password.as_bytes(), credential_response, finish_params)
+    });
+
+    // an error is a client-detected login failure
+    Ok(result.ok())
+}
+
+/// Writes the result of `finish_client_login` to the output buffer of the
+/// `*_into` functions, nothing for a login failure.
+pub(crate) fn write_finish_client_login(
+    result: Option<ClientLoginFinishResult<CS>>,
+    out: &mut [u8],
+) -> Result<OpaqueFinishClientLoginOutput, Error> {
+    let Some(result) = result else {
+        return Ok(OpaqueFinishClientLoginOutput {
+            success: false,
+            finish_login_request: 0,
+            session_key: 0,
+            export_key: 0,
+            server_static_public_key: 0,
+        });
+    };
+    let mut writer = Writer::new(out);
+    Ok(OpaqueFinishClientLoginOutput {
+        success: true,
+        finish_login_request: writer.write(&result.message.serialize())?,
+        session_key: writer.write(&result.session_key)?,
+        export_key: writer.write(&result.export_key)?,
+        server_static_public_key: writer.write(&result.server_s_pk.serialize())?,
+    })
+}
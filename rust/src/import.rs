@@ -0,0 +1,141 @@
+//! Framing of the bulk registration import, which creates the registration
+//! responses for many users without a JS object per user.
+//!
+//! The input is a sequence of records, each a `u32` little endian length
+//! followed by the UTF-8 user identifier, then a `u32` little endian length
+//! followed by the registration request. The output has one entry per record
+//! in the same order: a status byte ([`STATUS_OK`] or [`STATUS_ERROR`]), a
+//! `u32` little endian length and the registration response or the error
+//! message.
+
+use crate::{Error, OpaqueResult};
+
+pub const STATUS_OK: u8 = 0;
+pub const STATUS_ERROR: u8 = 1;
+
+pub struct Record<'a> {
+    pub user_identifier: &'a str,
+    pub registration_request: &'a [u8],
+}
+
+fn invalid_record(offset: usize) -> Error {
+    Error::Input {
+        message: format!("invalid registration import record at byte {offset}"),
+    }
+}
+
+fn read_field(input: &[u8], offset: &mut usize, record_start: usize) -> OpaqueResult<&[u8]> {
+    let len_end = offset
+        .checked_add(4)
+        .filter(|&end| end <= input.len())
+        .ok_or_else(|| invalid_record(record_start))?;
+    let len = u32::from_le_bytes(input[*offset..len_end].try_into().unwrap()) as usize;
+    let end = len_end
+        .checked_add(len)
+        .filter(|&end| end <= input.len())
+        .ok_or_else(|| invalid_record(record_start))?;
+    *offset = end;
+    Ok(&input[len_end..end])
+}
+
+/// Reads up to `max_records` records from the front of `input`. Returns the
+/// records and the number of bytes they take up.
+pub fn read_records(input: &[u8], max_records: usize) -> OpaqueResult<(Vec<Record<'_>>, usize)> {
+    let mut records = Vec::with_capacity(max_records.min(input.len() / 8));
+    let mut offset = 0;
+    while offset < input.len() && records.len() < max_records {
+        let record_start = offset;
+        let user_identifier = read_field(input, &mut offset, record_start)?;
+        let registration_request = read_field(input, &mut offset, record_start)?;
+        records.push(Record {
+            user_identifier: std::str::from_utf8(user_identifier)
+                .map_err(|_| invalid_record(record_start))?,
+            registration_request,
+        });
+    }
+    Ok((records, offset))
+}
+
+/// Validates the framing of the whole input and counts its records, so a
+/// malformed import fails before any response is created.
+pub fn count_records(input: &[u8]) -> OpaqueResult<u64> {
+    let mut count = 0;
+    let mut rest = input;
+    while !rest.is_empty() {
+        let (records, consumed) = read_records(rest, 4096)?;
+        count += records.len() as u64;
+        rest = &rest[consumed..];
+    }
+    Ok(count)
+}
+
+pub fn write_result(out: &mut Vec<u8>, result: Result<&[u8], &str>) {
+    let (status, payload) = match result {
+        Ok(response) => (STATUS_OK, response),
+        Err(message) => (STATUS_ERROR, message.as_bytes()),
+    };
+    out.push(status);
+    out.extend_from_slice(&(payload.len() as u32).to_le_bytes());
+    out.extend_from_slice(payload);
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn record(user_identifier: &str, registration_request: &[u8]) -> Vec<u8> {
+        let mut out = Vec::new();
+        out.extend_from_slice(&(user_identifier.len() as u32).to_le_bytes());
+        out.extend_from_slice(user_identifier.as_bytes());
+        out.extend_from_slice(&(registration_request.len() as u32).to_le_bytes());
+        out.extend_from_slice(registration_request);
+        out
+    }
+
+    #[test]
+    fn reads_records_in_chunks() {
+        let input = [record("a", &[1, 2]), record("bc", &[]), record("", &[3])].concat();
+        assert_eq!(count_records(&input).unwrap(), 3);
+
+        let (records, consumed) = read_records(&input, 2).unwrap();
+        assert_eq!(records.len(), 2);
+        assert_eq!(records[0].user_identifier, "a");
+        assert_eq!(records[0].registration_request, &[1, 2]);
+        assert_eq!(records[1].user_identifier, "bc");
+        assert!(records[1].registration_request.is_empty());
+
+        let (records, rest) = read_records(&input[consumed..], 2).unwrap();
+        assert_eq!(records.len(), 1);
+        assert_eq!(records[0].registration_request, &[3]);
+        assert_eq!(consumed + rest, input.len());
+    }
+
+    #[test]
+    fn rejects_malformed_records() {
+        let valid = record("a", &[1]);
+        assert_eq!(count_records(&[]).unwrap(), 0);
+        for len in 1..valid.len() {
+            let input = [valid.as_slice(), &valid[..len]].concat();
+            let error = count_records(&input).unwrap_err().to_string();
+            assert!(error.contains("at byte 10"), "{error}");
+        }
+        assert!(count_records(&record("\u{0}\u{ff}", &[])[..]).is_ok());
+        assert!(count_records(&[1, 0, 0, 0, 0xff, 0, 0, 0, 0]).is_err());
+    }
+
+    #[test]
+    fn writes_results() {
+        let mut out = Vec::new();
+        write_result(&mut out, Ok(&[7, 8][..]));
+        write_result(&mut out, Err("bad"));
+        assert_eq!(
+            out,
+            [
+                &[STATUS_OK, 2, 0, 0, 0, 7, 8][..],
+                &[STATUS_ERROR, 3, 0, 0, 0],
+                b"bad"
+            ]
+            .concat()
+        );
+    }
+}
@@ -0,0 +1,163 @@
+//! Key stretching configuration. The client runs Argon2id on the OPRF output
+//! during `finishClientRegistration` and `finishClientLogin`; both have to
+//! use the same parameters for the derived keys to match.
+
+use std::time::{Duration, Instant};
+
+use argon2::{Algorithm, Argon2, Block, Params, Version};
+use generic_array::{typenum::U64, ArrayLength, GenericArray};
+use opaque_ke::{errors::InternalError, ksf::Ksf};
+
+use crate::metrics::{self, Phase};
+use crate::opaque_ffi::OpaqueKeyStretchingParams;
+use crate::{argon2_arena, cpu, parallel_argon2, Error};
+
+/// Lowest memory cost (in KiB) suggested by the calibration.
+pub const MIN_CALIBRATED_MEMORY_COST: u32 = 8 * 1024;
+
+/// Highest memory cost (in KiB) suggested by the calibration, bigger values
+/// risk getting the app killed on low-memory devices.
+pub const MAX_CALIBRATED_MEMORY_COST: u32 = 64 * 1024;
+
+/// Highest number of iterations suggested by the calibration.
+pub const MAX_CALIBRATED_ITERATIONS: u32 = 16;
+
+/// The parameters used when none are passed, same as `Argon2::default()`.
+pub fn default_params() -> OpaqueKeyStretchingParams {
+    to_ffi(&Params::default())
+}
+
+fn to_ffi(params: &Params) -> OpaqueKeyStretchingParams {
+    OpaqueKeyStretchingParams {
+        memory_cost: params.m_cost(),
+        iterations: params.t_cost(),
+        parallelism: params.p_cost(),
+    }
+}
+
+/// Argon2id KSF of the default cipher suite. With more than one lane the
+/// lanes are computed in parallel on up to one thread per performance core,
+/// a single lane runs the `argon2` crate. Both produce the same output.
+#[derive(Clone, Debug, Default)]
+pub struct Argon2Ksf {
+    params: Params,
+}
+
+impl Argon2Ksf {
+    fn threads(&self) -> usize {
+        cpu::topology().performance_cores.min(self.params.p_cost()) as usize
+    }
+}
+
+impl Ksf for Argon2Ksf {
+    fn hash<L: ArrayLength<u8>>(
+        &self,
+        input: GenericArray<u8, L>,
+    ) -> Result<GenericArray<u8, L>, InternalError> {
+        // same salt as the Argon2 KSF of opaque-ke
+        let salt = [0u8; argon2::RECOMMENDED_SALT_LEN];
+        let mut output = GenericArray::default();
+        let threads = self.threads();
+        metrics::time(Phase::Ksf, || {
+            if threads > 1 {
+                parallel_argon2::hash_password_into(
+                    &self.params,
+                    threads,
+                    &input,
+                    &salt,
+                    &mut output,
+                );
+                Ok(())
+            } else {
+                let argon2 = Argon2::new(Algorithm::Argon2id, Version::V0x13, self.params.clone());
+                argon2_arena::with_blocks(self.params.block_count(), |blocks: &mut [Block]| {
+                    argon2.hash_password_into_with_memory(&input, &salt, &mut output, blocks)
+                })
+                .map_err(|_| InternalError::KsfError)
+            }
+        })?;
+        Ok(output)
+    }
+}
+
+/// Builds the KSF for the given parameters.
+pub fn argon2(params: &OpaqueKeyStretchingParams) -> Result<Argon2Ksf, Error> {
+    let params = Params::new(
+        params.memory_cost,
+        params.iterations,
+        params.parallelism,
+        None,
+    )
+    .map_err(|error| Error::Input {
+        message: format!("invalid key stretching params; {}", error),
+    })?;
+    Ok(Argon2Ksf { params })
+}
+
+/// Allocates and faults in the memory of the key stretching with `params`
+/// and keeps it for the following calls, see `argon2_arena`.
+pub fn prewarm(params: &OpaqueKeyStretchingParams) -> Result<(), Error> {
+    let ksf = argon2(params)?;
+    argon2_arena::prewarm(ksf.params.block_count());
+    Ok(())
+}
+
+/// Prepares the key stretching with `params` of the next call: allocates
+/// and faults in its memory and detects the CPU topology used to spread the
+/// lanes. Meant to run on a background thread while the client waits for
+/// the server.
+pub fn prepare(params: &OpaqueKeyStretchingParams) -> Result<(), Error> {
+    let ksf = argon2(params)?;
+    cpu::topology();
+    argon2_arena::prewarm_next(ksf.params.block_count());
+    Ok(())
+}
+
+fn measure(ksf: &Argon2Ksf) -> Duration {
+    // same input and output size as the KSF invocation of opaque-ke
+    let input = GenericArray::<u8, U64>::default();
+    let start = Instant::now();
+    ksf.hash(input).expect("argon2 with valid params failed");
+    start.elapsed()
+}
+
+/// Suggests parameters for which the key stretching takes about
+/// `target_duration_ms` on the current device.
+///
+/// The cost of Argon2 grows linearly with `memory_cost * iterations`, so the
+/// default parameters are timed once and scaled to the target. Memory is
+/// preferred over iterations up to `MAX_CALIBRATED_MEMORY_COST`; on slow
+/// devices the memory cost is lowered down to `MIN_CALIBRATED_MEMORY_COST`
+/// with a single iteration, which can undercut the default security level.
+pub fn calibrate(
+    target_duration_ms: u32,
+    parallelism: u32,
+) -> Result<OpaqueKeyStretchingParams, Error> {
+    if target_duration_ms == 0 {
+        return Err(Error::Input {
+            message: "targetDurationMs must be greater than 0".to_string(),
+        });
+    }
+    let mut probe = default_params();
+    probe.parallelism = parallelism;
+    let ksf = argon2(&probe)?;
+    // the first run also pays for the page faults of the fresh allocation
+    measure(&ksf);
+    let elapsed = measure(&ksf).max(Duration::from_micros(1));
+
+    let probe_cost = u64::from(probe.memory_cost) * u64::from(probe.iterations);
+    let target = Duration::from_millis(u64::from(target_duration_ms));
+    let budget = (probe_cost as f64 * target.as_secs_f64() / elapsed.as_secs_f64()) as u64;
+
+    // Argon2 needs at least 8 KiB per lane
+    let min_memory_cost = u64::from(MIN_CALIBRATED_MEMORY_COST.max(8 * parallelism));
+    let max_memory_cost = u64::from(MAX_CALIBRATED_MEMORY_COST).max(min_memory_cost);
+    let memory_cost = budget.clamp(min_memory_cost, max_memory_cost) as u32;
+    let iterations =
+        (budget / u64::from(memory_cost)).clamp(1, u64::from(MAX_CALIBRATED_ITERATIONS)) as u32;
+    Ok(OpaqueKeyStretchingParams {
+        memory_cost,
+        iterations,
+        parallelism,
+    })
+}
@@ -1,35 +1,138 @@
 use std::fmt;
+use std::sync::{Mutex, PoisonError};
+use std::time::Duration;
 
-use argon2::Argon2;
-use base64::{engine::general_purpose as b64, Engine as _};
-use opaque_ke::rand::rngs::OsRng;
 use opaque_ke::{ciphersuite::CipherSuite, errors::ProtocolError};
-use opaque_ke::{
-    ClientLogin, ClientLoginFinishParameters, ClientRegistration,
-    ClientRegistrationFinishParameters, CredentialFinalization, CredentialRequest,
-    CredentialResponse, Identifiers, RegistrationRequest, RegistrationResponse, ServerLogin,
-    ServerLoginStartParameters, ServerRegistration, ServerSetup,
-};
-
-struct DefaultCipherSuite;
-
-#[cfg(not(feature = "p256"))]
-impl CipherSuite for DefaultCipherSuite {
+use opaque_ke::{ClientLogin, ServerLogin, ServerSetup};
+
+mod argon2_arena;
+mod batch_pool;
+#[cfg(feature = "bench")]
+mod bench;
+mod borrowed;
+pub mod codec;
+mod cpu;
+mod import;
+mod ksf;
+mod metrics;
+mod parallel_argon2;
+pub mod rng;
+mod sessions;
+mod status;
+
+pub struct Ristretto255Suite;
+
+impl CipherSuite for Ristretto255Suite {
     type OprfCs = opaque_ke::Ristretto255;
     type KeGroup = opaque_ke::Ristretto255;
     type KeyExchange = opaque_ke::key_exchange::tripledh::TripleDh;
-    type Ksf = Argon2<'static>;
+    type Ksf = ksf::Argon2Ksf;
 }
 
-#[cfg(feature = "p256")]
-impl CipherSuite for DefaultCipherSuite {
+#[cfg(feature = "p256-suite")]
+pub struct P256Suite;
+
+#[cfg(feature = "p256-suite")]
+impl CipherSuite for P256Suite {
     type OprfCs = p256::NistP256;
     type KeGroup = p256::NistP256;
     type KeyExchange = opaque_ke::key_exchange::tripledh::TripleDh;
-    type Ksf = Argon2<'static>;
+    type Ksf = ksf::Argon2Ksf;
+}
+
+// Every suite compiled in gets its own copy of the protocol functions, see
+// `engine.rs`. `OpaqueCipherSuite::Default` selects the Ristretto255 engine,
+// or the P-256 one with the `p256` feature.
+
+mod ristretto255 {
+    type CS = super::Ristretto255Suite;
+    include!("engine.rs");
+}
+
+#[cfg(feature = "p256-suite")]
+mod nist_p256 {
+    type CS = super::P256Suite;
+    include!("engine.rs");
+}
+
+/// The cipher suites compiled into this build, `OpaqueCipherSuite` with the
+/// default resolved.
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+enum Suite {
+    Ristretto255,
+    #[cfg(feature = "p256-suite")]
+    P256,
+}
+
+impl Suite {
+    #[cfg(not(feature = "p256"))]
+    const DEFAULT: Suite = Suite::Ristretto255;
+    #[cfg(feature = "p256")]
+    const DEFAULT: Suite = Suite::P256;
+}
+
+fn resolve_suite(suite: OpaqueCipherSuite) -> OpaqueResult<Suite> {
+    match suite {
+        OpaqueCipherSuite::Default => Ok(Suite::DEFAULT),
+        OpaqueCipherSuite::Ristretto255 => Ok(Suite::Ristretto255),
+        #[cfg(feature = "p256-suite")]
+        OpaqueCipherSuite::P256 => Ok(Suite::P256),
+        #[cfg(not(feature = "p256-suite"))]
+        OpaqueCipherSuite::P256 => Err(Error::Input {
+            message: "the P-256 cipher suite is not enabled in this build".to_string(),
+        }),
+        _ => Err(Error::Input {
+            message: format!("unknown cipher suite {}", suite.repr),
+        }),
+    }
+}
+
+/// Evaluates `$body` with `$engine` bound to the engine module of `$suite`.
+/// Returns from the enclosing function if the suite isn't available.
+macro_rules! with_suite {
+    ($suite:expr, $engine:ident => $body:expr) => {
+        match crate::resolve_suite($suite)? {
+            crate::Suite::Ristretto255 => {
+                use crate::ristretto255 as $engine;
+                $body
+            }
+            #[cfg(feature = "p256-suite")]
+            crate::Suite::P256 => {
+                use crate::nist_p256 as $engine;
+                $body
+            }
+        }
+    };
 }
 
-enum Error {
+/// Evaluates `$body` with `$setup` bound to the server setup of the handle
+/// and `$engine` to the engine module of its suite. With a `$suite`, returns
+/// from the enclosing function if it doesn't match the suite of the handle.
+macro_rules! with_setup {
+    ($handle:expr, $setup:ident, $engine:ident => $body:expr) => {
+        match $handle {
+            crate::ServerSetupHandle::Ristretto255($setup) => {
+                use crate::ristretto255 as $engine;
+                $body
+            }
+            #[cfg(feature = "p256-suite")]
+            crate::ServerSetupHandle::P256($setup) => {
+                use crate::nist_p256 as $engine;
+                $body
+            }
+        }
+    };
+    ($handle:expr, $suite:expr, $setup:ident, $engine:ident => $body:expr) => {{
+        let handle: &crate::ServerSetupHandle = $handle;
+        handle.check_suite($suite)?;
+        $crate::with_setup!(handle, $setup, $engine => $body)
+    }};
+}
+
+pub(crate) use {with_setup, with_suite};
+
+#[derive(Debug)]
+pub enum Error {
     Input {
         message: String,
     },
@@ -39,13 +142,36 @@ enum Error {
     },
     Base64 {
         context: &'static str,
-        error: base64::DecodeError,
+        error: codec::DecodeError,
     },
 }
 
-impl fmt::Display for Error {
-    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+impl Error {
+    /// The code of the error in the result mode, see `status.rs`.
+    pub fn code(&self) -> OpaqueErrorCode {
         match self {
+            Error::Input { .. } => OpaqueErrorCode::Input,
+            Error::Protocol {
+                error: ProtocolError::InvalidLoginError,
+                ..
+            } => OpaqueErrorCode::InvalidLogin,
+            Error::Protocol { .. } => OpaqueErrorCode::Protocol,
+            Error::Base64 { .. } => OpaqueErrorCode::Base64,
+        }
+    }
+
+    /// The message of the error, without the code in front of it.
+    pub fn message(&self) -> ErrorMessage<'_> {
+        ErrorMessage(self)
+    }
+}
+
+/// The message of an `Error`, see `Error::message`.
+pub struct ErrorMessage<'e>(&'e Error);
+
+impl fmt::Display for ErrorMessage<'_> {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        match self.0 {
             Error::Input { message } => {
                 write!(f, "{}", message)
             }
@@ -59,7 +185,17 @@ impl fmt::Display for Error {
     }
 }
 
-fn from_base64_error(context: &'static str) -> impl Fn(base64::DecodeError) -> Error {
+// cxx throws the error of a failed bridge call as a `rust::Error`, which
+// only carries the formatted error. The code goes in front of the message
+// as "<code>:<message>", with the number of the `OpaqueErrorCode`, and
+// `splitRustError` in cpp/opaque-binding.h takes it apart again.
+impl fmt::Display for Error {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        write!(f, "{}:{}", self.code().repr, self.message())
+    }
+}
+
+fn from_base64_error(context: &'static str) -> impl Fn(codec::DecodeError) -> Error {
     move |error| Error::Base64 { context, error }
 }
 
@@ -67,19 +203,48 @@ fn from_protocol_error(context: &'static str) -> impl Fn(ProtocolError) -> Error
     move |error| Error::Protocol { context, error }
 }
 
-const BASE64: b64::GeneralPurpose = b64::URL_SAFE_NO_PAD;
-
 type OpaqueResult<T> = Result<T, Error>;
 
 fn base64_decode<T: AsRef<[u8]>>(context: &'static str, input: T) -> OpaqueResult<Vec<u8>> {
-    BASE64.decode(input).map_err(from_base64_error(context))
+    metrics::time(Phase::Base64, || codec::decode(input)).map_err(from_base64_error(context))
+}
+
+fn base64_encode<T: AsRef<[u8]>>(input: T) -> String {
+    metrics::time(Phase::Base64, || codec::encode(input))
 }
 
 #[cxx::bridge]
-mod opaque_ffi {
+pub mod opaque_ffi {
+
+    /// Argon2id parameters of the client side key stretching.
+    #[derive(Clone, Copy, Debug)]
+    struct OpaqueKeyStretchingParams {
+        /// memory size in KiB
+        memory_cost: u32,
+        iterations: u32,
+        parallelism: u32,
+    }
+
+    #[derive(Clone, Copy, Debug)]
+    struct OpaqueCpuTopology {
+        cores: u32,
+        /// cores excluding the efficiency cores of big.LITTLE systems
+        performance_cores: u32,
+    }
+
+    /// Cipher suite of a call. Messages, states and server setups of one
+    /// suite can't be used with another, the client and the server must
+    /// agree on it. `Default` is Ristretto255, or P-256 in builds with the
+    /// `p256` feature; P-256 is only available with the `p256-suite` feature.
+    enum OpaqueCipherSuite {
+        Default,
+        Ristretto255,
+        P256,
+    }
 
     struct OpaqueStartClientRegistrationParams {
         password: String,
+        suite: OpaqueCipherSuite,
     }
 
     struct OpaqueStartClientRegistrationResult {
@@ -93,16 +258,20 @@ mod opaque_ffi {
         client_registration_state: String,
         client_identifier: Vec<String>,
         server_identifier: Vec<String>,
+        key_stretching: Vec<OpaqueKeyStretchingParams>,
+        suite: OpaqueCipherSuite,
     }
 
     struct OpaqueFinishClientRegistrationResult {
         registration_record: String,
         export_key: String,
         server_static_public_key: String,
+        key_stretching: OpaqueKeyStretchingParams,
     }
 
     struct OpaqueStartClientLoginParams {
         password: String,
+        suite: OpaqueCipherSuite,
     }
 
     struct OpaqueStartClientLoginResult {
@@ -116,6 +285,8 @@ mod opaque_ffi {
         password: String,
         client_identifier: Vec<String>,
         server_identifier: Vec<String>,
+        key_stretching: Vec<OpaqueKeyStretchingParams>,
+        suite: OpaqueCipherSuite,
     }
 
     struct OpaqueFinishClientLoginResult {
@@ -126,9 +297,9 @@ mod opaque_ffi {
     }
 
     struct OpaqueCreateServerRegistrationResponseParams {
-        server_setup: String,
         user_identifier: String,
         registration_request: String,
+        suite: OpaqueCipherSuite,
     }
 
     struct OpaqueCreateServerRegistrationResponseResult {
@@ -136,12 +307,12 @@ mod opaque_ffi {
     }
 
     struct OpaqueStartServerLoginParams {
-        server_setup: String,
         registration_record: Vec<String>,
         start_login_request: String,
         user_identifier: String,
         client_identifier: Vec<String>,
         server_identifier: Vec<String>,
+        suite: OpaqueCipherSuite,
     }
 
     struct OpaqueStartServerLoginResult {
@@ -152,13 +323,224 @@ mod opaque_ffi {
     struct OpaqueFinishServerLoginParams {
         server_login_state: String,
         finish_login_request: String,
+        suite: OpaqueCipherSuite,
     }
 
     struct OpaqueFinishServerLoginResult {
         session_key: String,
     }
 
+    struct OpaqueStartClientRegistrationBinaryResult {
+        client_registration_state: Vec<u8>,
+        registration_request: Vec<u8>,
+    }
+
+    struct OpaqueFinishClientRegistrationBinaryResult {
+        registration_record: Vec<u8>,
+        export_key: Vec<u8>,
+        server_static_public_key: Vec<u8>,
+        key_stretching: OpaqueKeyStretchingParams,
+    }
+
+    struct OpaqueStartClientLoginBinaryResult {
+        client_login_state: Vec<u8>,
+        start_login_request: Vec<u8>,
+    }
+
+    struct OpaqueFinishClientLoginBinaryResult {
+        finish_login_request: Vec<u8>,
+        session_key: Vec<u8>,
+        export_key: Vec<u8>,
+        server_static_public_key: Vec<u8>,
+    }
+
+    struct OpaqueCreateServerRegistrationResponseBinaryResult {
+        registration_response: Vec<u8>,
+    }
+
+    struct OpaqueStartServerLoginSessionResult {
+        /// identifies the login session in `opaque_finish_server_login_session`
+        session_handle: String,
+        login_response: String,
+    }
+
+    struct OpaqueStartServerLoginBatchResult {
+        server_login_state: String,
+        login_response: String,
+        /// `None` if the request succeeded.
+        error_code: OpaqueErrorCode,
+        error_message: String,
+    }
+
+    /// Result of one chunk of a bulk registration import, see `import.rs`
+    /// for the framing of `responses`.
+    struct OpaqueRegistrationImportChunk {
+        responses: Vec<u8>,
+        /// bytes of the input taken up by the records of this chunk
+        consumed: usize,
+        records: usize,
+        failed: usize,
+    }
+
+    struct OpaqueStartServerLoginBinaryResult {
+        server_login_state: Vec<u8>,
+        login_response: Vec<u8>,
+    }
+
+    struct OpaqueFinishServerLoginBinaryResult {
+        session_key: Vec<u8>,
+    }
+
+    // Params of the `*_into` functions. The strings are borrowed from the
+    // caller and only have to stay alive for the duration of the call. cxx
+    // has no optional values, the `has_*` flags tell whether one is set.
+
+    struct OpaqueFinishClientRegistrationInput<'a> {
+        password: &'a str,
+        registration_response: &'a str,
+        client_registration_state: &'a str,
+        client_identifier: &'a str,
+        has_client_identifier: bool,
+        server_identifier: &'a str,
+        has_server_identifier: bool,
+        key_stretching: OpaqueKeyStretchingParams,
+        has_key_stretching: bool,
+        suite: OpaqueCipherSuite,
+    }
+
+    struct OpaqueFinishClientLoginInput<'a> {
+        client_login_state: &'a str,
+        login_response: &'a str,
+        password: &'a str,
+        client_identifier: &'a str,
+        has_client_identifier: bool,
+        server_identifier: &'a str,
+        has_server_identifier: bool,
+        key_stretching: OpaqueKeyStretchingParams,
+        has_key_stretching: bool,
+        suite: OpaqueCipherSuite,
+    }
+
+    /// The password, identifiers and key stretching params are kept in the
+    /// client login context until the login is finished.
+    struct OpaqueStartClientLoginContextInput<'a> {
+        password: &'a str,
+        client_identifier: &'a str,
+        has_client_identifier: bool,
+        server_identifier: &'a str,
+        has_server_identifier: bool,
+        key_stretching: OpaqueKeyStretchingParams,
+        has_key_stretching: bool,
+        suite: OpaqueCipherSuite,
+    }
+
+    struct OpaqueCreateServerRegistrationResponseInput<'a> {
+        user_identifier: &'a str,
+        registration_request: &'a str,
+        suite: OpaqueCipherSuite,
+    }
+
+    struct OpaqueStartServerLoginInput<'a> {
+        registration_record: &'a str,
+        has_registration_record: bool,
+        start_login_request: &'a str,
+        user_identifier: &'a str,
+        client_identifier: &'a str,
+        has_client_identifier: bool,
+        server_identifier: &'a str,
+        has_server_identifier: bool,
+        suite: OpaqueCipherSuite,
+    }
+
+    struct OpaqueFinishServerLoginInput<'a> {
+        server_login_state: &'a str,
+        finish_login_request: &'a str,
+        suite: OpaqueCipherSuite,
+    }
+
+    // Results of the `*_into` functions. The fields are written base64
+    // encoded and back to back into the output buffer, in the order of the
+    // struct members, which hold their lengths.
+
+    struct OpaqueStartClientRegistrationOutput {
+        client_registration_state: usize,
+        registration_request: usize,
+    }
+
+    struct OpaqueFinishClientRegistrationOutput {
+        registration_record: usize,
+        export_key: usize,
+        server_static_public_key: usize,
+        key_stretching: OpaqueKeyStretchingParams,
+    }
+
+    struct OpaqueStartClientLoginOutput {
+        client_login_state: usize,
+        start_login_request: usize,
+    }
+
+    struct OpaqueFinishClientLoginOutput {
+        /// false if the client detected a login failure, nothing is written
+        /// to the output buffer then
+        success: bool,
+        finish_login_request: usize,
+        session_key: usize,
+        export_key: usize,
+        server_static_public_key: usize,
+    }
+
+    struct OpaqueStartServerLoginOutput {
+        server_login_state: usize,
+        login_response: usize,
+    }
+
+    /// The functions with metrics, see `metrics.rs`. The string, binary
+    /// and server setup handle variants of a function share its metrics.
+    enum OpaqueMetricsFunction {
+        StartClientRegistration,
+        FinishClientRegistration,
+        StartClientLogin,
+        FinishClientLogin,
+        CreateServerRegistrationResponse,
+        StartServerLogin,
+        FinishServerLogin,
+    }
+
+    /// Code of an `Error` in the result mode, one per variant and
+    /// `InvalidLogin` for the protocol error of a wrong password. `None`
+    /// if there was no error.
+    enum OpaqueErrorCode {
+        None,
+        Input,
+        Protocol,
+        Base64,
+        InvalidLogin,
+    }
+
+    /// Outcome of the `opaque_try_*` functions, which report an error
+    /// instead of throwing it. Its message is written to the start of the
+    /// output buffer, `message` is its length.
+    struct OpaqueStatus {
+        code: OpaqueErrorCode,
+        message: usize,
+    }
+
+    /// Durations of one phase of a function, the percentiles are the upper
+    /// bound of their power of two histogram bucket.
+    struct OpaqueMetricsEntry {
+        function: String,
+        phase: String,
+        count: u64,
+        total_ns: u64,
+        max_ns: u64,
+        p50_ns: u64,
+        p90_ns: u64,
+        p99_ns: u64,
+    }
+
     extern "Rust" {
+        type ServerSetupHandle;
+
         fn opaque_start_client_registration(
             params: OpaqueStartClientRegistrationParams,
         ) -> Result<OpaqueStartClientRegistrationResult>;
@@ -175,167 +557,988 @@ mod opaque_ffi {
             params: OpaqueFinishClientLoginParams,
         ) -> Result<UniquePtr<OpaqueFinishClientLoginResult>>;
 
-        fn opaque_create_server_setup() -> String;
+        type ClientLoginContext;
+
+        /// Starts a client login and keeps its state in the returned context
+        /// instead of serializing it. Sets `start_login_request` to the base64
+        /// encoded request for the server.
+        fn opaque_start_client_login_context<'a>(
+            input: OpaqueStartClientLoginContextInput<'a>,
+            start_login_request: &mut String,
+        ) -> Result<Box<ClientLoginContext>>;
+
+        /// Finishes the login of the context and zeroizes its state, a
+        /// context can only be finished once. Writes the result like
+        /// `opaque_finish_client_login_into`.
+        fn opaque_finish_client_login_context(
+            context: &ClientLoginContext,
+            login_response: &str,
+            out: &mut [u8],
+        ) -> Result<OpaqueFinishClientLoginOutput>;
 
-        fn opaque_get_server_public_key(data: String) -> Result<String>;
+        fn opaque_calibrate_key_stretching(
+            target_duration_ms: u32,
+            parallelism: u32,
+        ) -> Result<OpaqueKeyStretchingParams>;
+
+        fn opaque_check_key_stretching(
+            key_stretching: Vec<OpaqueKeyStretchingParams>,
+        ) -> Result<()>;
+
+        fn opaque_prewarm_key_stretching(
+            key_stretching: Vec<OpaqueKeyStretchingParams>,
+        ) -> Result<()>;
+
+        fn opaque_prepare_client_login_finish(
+            key_stretching: Vec<OpaqueKeyStretchingParams>,
+        ) -> Result<()>;
+
+        fn opaque_release_key_stretching_memory();
+
+        fn opaque_trim_key_stretching_memory();
+
+        fn opaque_get_cpu_topology() -> OpaqueCpuTopology;
+
+        fn opaque_create_server_setup(suite: OpaqueCipherSuite) -> Result<String>;
+
+        fn opaque_create_server_setup_handle(
+            data: String,
+            suite: OpaqueCipherSuite,
+        ) -> Result<Box<ServerSetupHandle>>;
+
+        fn opaque_get_server_public_key(data: String, suite: OpaqueCipherSuite) -> Result<String>;
+
+        fn opaque_get_server_public_key_with_setup(server_setup: &ServerSetupHandle) -> String;
 
         fn opaque_create_server_registration_response(
+            server_setup: String,
+            params: OpaqueCreateServerRegistrationResponseParams,
+        ) -> Result<OpaqueCreateServerRegistrationResponseResult>;
+
+        fn opaque_create_server_registration_response_with_setup(
+            server_setup: &ServerSetupHandle,
             params: OpaqueCreateServerRegistrationResponseParams,
         ) -> Result<OpaqueCreateServerRegistrationResponseResult>;
 
         fn opaque_start_server_login(
+            server_setup: String,
             params: OpaqueStartServerLoginParams,
         ) -> Result<OpaqueStartServerLoginResult>;
 
+        fn opaque_start_server_login_with_setup(
+            server_setup: &ServerSetupHandle,
+            params: OpaqueStartServerLoginParams,
+        ) -> Result<OpaqueStartServerLoginResult>;
+
+        fn opaque_start_server_login_batch(
+            server_setup: &ServerSetupHandle,
+            requests: Vec<OpaqueStartServerLoginParams>,
+        ) -> Vec<OpaqueStartServerLoginBatchResult>;
+
+        /// Validates the framing of a bulk registration import and returns
+        /// its number of records.
+        fn opaque_count_registration_import_records(records: &[u8]) -> Result<u64>;
+
+        /// Creates the registration responses for up to `max_records`
+        /// records from the front of `records`, spread across the available
+        /// cores. A failing record doesn't fail the chunk.
+        fn opaque_create_server_registration_responses_chunk(
+            server_setup: &ServerSetupHandle,
+            records: &[u8],
+            max_records: usize,
+        ) -> Result<OpaqueRegistrationImportChunk>;
+
+        type ServerLoginSessionStore;
+
+        fn opaque_create_server_login_session_store(
+            ttl_ms: u32,
+            max_memory_bytes: usize,
+        ) -> Result<Box<ServerLoginSessionStore>>;
+
+        /// Number of pending login sessions.
+        fn opaque_server_login_session_count(store: &ServerLoginSessionStore) -> usize;
+
+        /// Same as `opaque_start_server_login_with_setup` but keeps the login
+        /// state in the store and returns a handle to it instead.
+        fn opaque_start_server_login_session(
+            store: &ServerLoginSessionStore,
+            server_setup: &ServerSetupHandle,
+            params: OpaqueStartServerLoginParams,
+        ) -> Result<OpaqueStartServerLoginSessionResult>;
+
+        /// Finishes the login of the session and removes it from the store,
+        /// a session can only be finished once.
+        fn opaque_finish_server_login_session(
+            store: &ServerLoginSessionStore,
+            session_handle: &str,
+            finish_login_request: &str,
+        ) -> Result<OpaqueFinishServerLoginResult>;
+
         fn opaque_finish_server_login(
             params: OpaqueFinishServerLoginParams,
         ) -> Result<OpaqueFinishServerLoginResult>;
+
+        // The binary functions without a server setup handle take the
+        // cipher suite as their last argument.
+
+        fn opaque_start_client_registration_binary(
+            password: &str,
+            suite: OpaqueCipherSuite,
+        ) -> Result<OpaqueStartClientRegistrationBinaryResult>;
+
+        fn opaque_finish_client_registration_binary(
+            password: &str,
+            registration_response: &[u8],
+            client_registration_state: &[u8],
+            client_identifier: Vec<String>,
+            server_identifier: Vec<String>,
+            key_stretching: Vec<OpaqueKeyStretchingParams>,
+            suite: OpaqueCipherSuite,
+        ) -> Result<OpaqueFinishClientRegistrationBinaryResult>;
+
+        fn opaque_start_client_login_binary(
+            password: &str,
+            suite: OpaqueCipherSuite,
+        ) -> Result<OpaqueStartClientLoginBinaryResult>;
+
+        fn opaque_finish_client_login_binary(
+            client_login_state: &[u8],
+            login_response: &[u8],
+            password: &str,
+            client_identifier: Vec<String>,
+            server_identifier: Vec<String>,
+            key_stretching: Vec<OpaqueKeyStretchingParams>,
+            suite: OpaqueCipherSuite,
+        ) -> Result<UniquePtr<OpaqueFinishClientLoginBinaryResult>>;
+
+        fn opaque_create_server_setup_binary(suite: OpaqueCipherSuite) -> Result<Vec<u8>>;
+
+        fn opaque_create_server_setup_handle_binary(
+            data: &[u8],
+            suite: OpaqueCipherSuite,
+        ) -> Result<Box<ServerSetupHandle>>;
+
+        fn opaque_get_server_public_key_binary(
+            data: &[u8],
+            suite: OpaqueCipherSuite,
+        ) -> Result<Vec<u8>>;
+
+        fn opaque_get_server_public_key_with_setup_binary(
+            server_setup: &ServerSetupHandle,
+        ) -> Vec<u8>;
+
+        // The binary functions with a server setup handle take no suite, the
+        // caller checks the one of the params against the handle up front.
+        fn opaque_check_server_setup_suite(
+            server_setup: &ServerSetupHandle,
+            suite: OpaqueCipherSuite,
+        ) -> Result<()>;
+
+        fn opaque_create_server_registration_response_binary(
+            server_setup: &[u8],
+            user_identifier: &str,
+            registration_request: &[u8],
+            suite: OpaqueCipherSuite,
+        ) -> Result<OpaqueCreateServerRegistrationResponseBinaryResult>;
+
+        fn opaque_create_server_registration_response_with_setup_binary(
+            server_setup: &ServerSetupHandle,
+            user_identifier: &str,
+            registration_request: &[u8],
+        ) -> Result<OpaqueCreateServerRegistrationResponseBinaryResult>;
+
+        // cxx has no optional slices, `has_registration_record` tells
+        // whether `registration_record` is set.
+        fn opaque_start_server_login_binary(
+            server_setup: &[u8],
+            registration_record: &[u8],
+            has_registration_record: bool,
+            start_login_request: &[u8],
+            user_identifier: &str,
+            client_identifier: Vec<String>,
+            server_identifier: Vec<String>,
+            suite: OpaqueCipherSuite,
+        ) -> Result<OpaqueStartServerLoginBinaryResult>;
+
+        fn opaque_start_server_login_with_setup_binary(
+            server_setup: &ServerSetupHandle,
+            registration_record: &[u8],
+            has_registration_record: bool,
+            start_login_request: &[u8],
+            user_identifier: &str,
+            client_identifier: Vec<String>,
+            server_identifier: Vec<String>,
+        ) -> Result<OpaqueStartServerLoginBinaryResult>;
+
+        fn opaque_finish_server_login_binary(
+            server_login_state: &[u8],
+            finish_login_request: &[u8],
+            suite: OpaqueCipherSuite,
+        ) -> Result<OpaqueFinishServerLoginBinaryResult>;
+
+        // Zero-copy variants of the string API, see the `*Input` and
+        // `*Output` structs. They fail if `out` is too small for the result.
+
+        fn opaque_start_client_registration_into(
+            password: &str,
+            suite: OpaqueCipherSuite,
+            out: &mut [u8],
+        ) -> Result<OpaqueStartClientRegistrationOutput>;
+
+        fn opaque_finish_client_registration_into<'a>(
+            input: OpaqueFinishClientRegistrationInput<'a>,
+            out: &mut [u8],
+        ) -> Result<OpaqueFinishClientRegistrationOutput>;
+
+        fn opaque_start_client_login_into(
+            password: &str,
+            suite: OpaqueCipherSuite,
+            out: &mut [u8],
+        ) -> Result<OpaqueStartClientLoginOutput>;
+
+        fn opaque_finish_client_login_into<'a>(
+            input: OpaqueFinishClientLoginInput<'a>,
+            out: &mut [u8],
+        ) -> Result<OpaqueFinishClientLoginOutput>;
+
+        /// Returns the length of the registration response.
+        fn opaque_create_server_registration_response_into<'a>(
+            server_setup: &str,
+            input: OpaqueCreateServerRegistrationResponseInput<'a>,
+            out: &mut [u8],
+        ) -> Result<usize>;
+
+        /// Returns the length of the registration response.
+        fn opaque_create_server_registration_response_with_setup_into<'a>(
+            server_setup: &ServerSetupHandle,
+            input: OpaqueCreateServerRegistrationResponseInput<'a>,
+            out: &mut [u8],
+        ) -> Result<usize>;
+
+        fn opaque_start_server_login_into<'a>(
+            server_setup: &str,
+            input: OpaqueStartServerLoginInput<'a>,
+            out: &mut [u8],
+        ) -> Result<OpaqueStartServerLoginOutput>;
+
+        fn opaque_start_server_login_with_setup_into<'a>(
+            server_setup: &ServerSetupHandle,
+            input: OpaqueStartServerLoginInput<'a>,
+            out: &mut [u8],
+        ) -> Result<OpaqueStartServerLoginOutput>;
+
+        /// Returns the length of the session key.
+        fn opaque_finish_server_login_into<'a>(
+            input: OpaqueFinishServerLoginInput<'a>,
+            out: &mut [u8],
+        ) -> Result<usize>;
+
+        // Variants of the login functions which don't throw, for the result
+        // mode of the JSI module, see `status.rs`. On success the result is
+        // stored in the last argument, otherwise it's left as is.
+
+        fn opaque_try_finish_client_login_into<'a>(
+            input: OpaqueFinishClientLoginInput<'a>,
+            out: &mut [u8],
+            output: &mut OpaqueFinishClientLoginOutput,
+        ) -> OpaqueStatus;
+
+        fn opaque_try_finish_client_login_context(
+            context: &ClientLoginContext,
+            login_response: &str,
+            out: &mut [u8],
+            output: &mut OpaqueFinishClientLoginOutput,
+        ) -> OpaqueStatus;
+
+        fn opaque_try_start_server_login_into<'a>(
+            server_setup: &str,
+            input: OpaqueStartServerLoginInput<'a>,
+            out: &mut [u8],
+            output: &mut OpaqueStartServerLoginOutput,
+        ) -> OpaqueStatus;
+
+        fn opaque_try_start_server_login_with_setup_into<'a>(
+            server_setup: &ServerSetupHandle,
+            input: OpaqueStartServerLoginInput<'a>,
+            out: &mut [u8],
+            output: &mut OpaqueStartServerLoginOutput,
+        ) -> OpaqueStatus;
+
+        fn opaque_try_finish_server_login_into<'a>(
+            input: OpaqueFinishServerLoginInput<'a>,
+            out: &mut [u8],
+            session_key: &mut usize,
+        ) -> OpaqueStatus;
+
+        /// `out` only receives the error message.
+        fn opaque_try_start_server_login_session(
+            store: &ServerLoginSessionStore,
+            server_setup: &ServerSetupHandle,
+            params: OpaqueStartServerLoginParams,
+            out: &mut [u8],
+            result: &mut OpaqueStartServerLoginSessionResult,
+        ) -> OpaqueStatus;
+
+        /// `out` only receives the error message.
+        fn opaque_try_finish_server_login_session(
+            store: &ServerLoginSessionStore,
+            session_handle: &str,
+            finish_login_request: &str,
+            out: &mut [u8],
+            result: &mut OpaqueFinishServerLoginResult,
+        ) -> OpaqueStatus;
+
+        // The binary login functions, see `*_binary` above.
+
+        fn opaque_try_start_server_login_binary(
+            server_setup: &[u8],
+            registration_record: &[u8],
+            has_registration_record: bool,
+            start_login_request: &[u8],
+            user_identifier: &str,
+            client_identifier: Vec<String>,
+            server_identifier: Vec<String>,
+            suite: OpaqueCipherSuite,
+            out: &mut [u8],
+            result: &mut OpaqueStartServerLoginBinaryResult,
+        ) -> OpaqueStatus;
+
+        fn opaque_try_start_server_login_with_setup_binary(
+            server_setup: &ServerSetupHandle,
+            registration_record: &[u8],
+            has_registration_record: bool,
+            start_login_request: &[u8],
+            user_identifier: &str,
+            client_identifier: Vec<String>,
+            server_identifier: Vec<String>,
+            out: &mut [u8],
+            result: &mut OpaqueStartServerLoginBinaryResult,
+        ) -> OpaqueStatus;
+
+        fn opaque_try_finish_server_login_binary(
+            server_login_state: &[u8],
+            finish_login_request: &[u8],
+            suite: OpaqueCipherSuite,
+            out: &mut [u8],
+            result: &mut OpaqueFinishServerLoginBinaryResult,
+        ) -> OpaqueStatus;
+
+        /// `result` is left empty if the client detected a login failure.
+        fn opaque_try_finish_client_login_binary(
+            client_login_state: &[u8],
+            login_response: &[u8],
+            password: &str,
+            client_identifier: Vec<String>,
+            server_identifier: Vec<String>,
+            key_stretching: Vec<OpaqueKeyStretchingParams>,
+            suite: OpaqueCipherSuite,
+            out: &mut [u8],
+            result: &mut OpaqueFinishClientLoginBinaryResult,
+        ) -> OpaqueStatus;
+
+        fn opaque_set_metrics_enabled(enabled: bool);
+
+        fn opaque_get_metrics() -> Vec<OpaqueMetricsEntry>;
+
+        fn opaque_reset_metrics();
+
+        /// Marks the start and end of a call of `function` on the current
+        /// thread, no-ops while the metrics are disabled.
+        fn opaque_metrics_begin(function: OpaqueMetricsFunction);
+
+        fn opaque_metrics_end();
     }
 }
 
 use opaque_ffi::{
+    OpaqueCipherSuite, OpaqueCpuTopology, OpaqueCreateServerRegistrationResponseBinaryResult,
     OpaqueCreateServerRegistrationResponseParams, OpaqueCreateServerRegistrationResponseResult,
+    OpaqueErrorCode, OpaqueFinishClientLoginBinaryResult, OpaqueFinishClientLoginOutput,
     OpaqueFinishClientLoginParams, OpaqueFinishClientLoginResult,
-    OpaqueFinishClientRegistrationParams, OpaqueFinishClientRegistrationResult,
-    OpaqueFinishServerLoginParams, OpaqueFinishServerLoginResult, OpaqueStartClientLoginParams,
-    OpaqueStartClientLoginResult, OpaqueStartClientRegistrationParams,
-    OpaqueStartClientRegistrationResult, OpaqueStartServerLoginParams,
-    OpaqueStartServerLoginResult,
+    OpaqueFinishClientRegistrationBinaryResult, OpaqueFinishClientRegistrationParams,
+    OpaqueFinishClientRegistrationResult, OpaqueFinishServerLoginBinaryResult,
+    OpaqueFinishServerLoginParams, OpaqueFinishServerLoginResult, OpaqueKeyStretchingParams,
+    OpaqueMetricsEntry, OpaqueMetricsFunction, OpaqueRegistrationImportChunk,
+    OpaqueStartClientLoginBinaryResult, OpaqueStartClientLoginContextInput,
+    OpaqueStartClientLoginParams, OpaqueStartClientLoginResult,
+    OpaqueStartClientRegistrationBinaryResult, OpaqueStartClientRegistrationParams,
+    OpaqueStartClientRegistrationResult, OpaqueStartServerLoginBatchResult,
+    OpaqueStartServerLoginBinaryResult, OpaqueStartServerLoginParams, OpaqueStartServerLoginResult,
 };
 
-fn opaque_create_server_setup() -> String {
-    let mut rng: OsRng = OsRng;
-    let setup = ServerSetup::<DefaultCipherSuite>::new(&mut rng);
-    BASE64.encode(setup.serialize())
+pub use borrowed::*;
+use borrowed::{decode, optional, MAX_MESSAGE_LEN};
+use metrics::Phase;
+pub use status::*;
+
+// The protocol functions operate on raw bytes. The string API wraps them
+// with base64 encoding, the binary API passes the bytes through as is.
+
+/// Suggests key stretching parameters for which `finishClientRegistration`
+/// and `finishClientLogin` take about `target_duration_ms` on this device.
+pub fn opaque_calibrate_key_stretching(
+    target_duration_ms: u32,
+    parallelism: u32,
+) -> Result<OpaqueKeyStretchingParams, Error> {
+    ksf::calibrate(target_duration_ms, parallelism)
+}
+
+/// Fails like the key stretching would with the given params, without
+/// running it.
+pub fn opaque_check_key_stretching(
+    key_stretching: Vec<OpaqueKeyStretchingParams>,
+) -> Result<(), Error> {
+    match get_optional(key_stretching)? {
+        Some(params) => ksf::argon2(&params).map(|_| ()),
+        None => Ok(()),
+    }
+}
+
+/// Allocates the memory of the key stretching with the given (or default)
+/// parameters up front and reuses it for the following calls.
+pub fn opaque_prewarm_key_stretching(
+    key_stretching: Vec<OpaqueKeyStretchingParams>,
+) -> Result<(), Error> {
+    let params = get_optional(key_stretching)?.unwrap_or_else(ksf::default_params);
+    ksf::prewarm(&params)
+}
+
+/// Prepares the key stretching of the next `finishClientLogin` with the
+/// given (or default) parameters, run in the background between
+/// `startClientLogin` and the server response. The key stretching itself
+/// can't start early since its input is the OPRF output of the response.
+pub fn opaque_prepare_client_login_finish(
+    key_stretching: Vec<OpaqueKeyStretchingParams>,
+) -> Result<(), Error> {
+    let params = get_optional(key_stretching)?.unwrap_or_else(ksf::default_params);
+    ksf::prepare(&params)
 }
 
-fn opaque_get_server_public_key(data: String) -> Result<String, Error> {
-    let server_setup = decode_server_setup(data)?;
-    let pub_key = server_setup.keypair().public().serialize();
-    Ok(BASE64.encode(pub_key))
+/// Zeroizes and frees the memory kept by `opaque_prewarm_key_stretching`,
+/// the following calls allocate their memory again.
+pub fn opaque_release_key_stretching_memory() {
+    argon2_arena::release();
 }
 
-fn opaque_create_server_registration_response(
+/// Zeroizes and frees the memory kept by `opaque_prewarm_key_stretching`,
+/// the next call allocates it again and keeps it. Called on memory pressure.
+pub fn opaque_trim_key_stretching_memory() {
+    argon2_arena::trim();
+}
+
+pub fn opaque_get_cpu_topology() -> OpaqueCpuTopology {
+    cpu::topology()
+}
+
+pub fn opaque_create_server_setup(suite: OpaqueCipherSuite) -> Result<String, Error> {
+    opaque_create_server_setup_binary(suite).map(base64_encode)
+}
+
+pub fn opaque_create_server_setup_binary(suite: OpaqueCipherSuite) -> Result<Vec<u8>, Error> {
+    Ok(with_suite!(suite, engine => engine::create_server_setup()))
+}
+
+/// A decoded and validated server setup which is kept in native memory so
+/// the server functions don't have to decode it again on every call. The
+/// functions taking a handle use its cipher suite.
+pub enum ServerSetupHandle {
+    Ristretto255(ServerSetup<Ristretto255Suite>),
+    #[cfg(feature = "p256-suite")]
+    P256(ServerSetup<P256Suite>),
+}
+
+/// Implements `From` for the variants of an enum with one variant per suite.
+macro_rules! impl_from_suites {
+    ($enum:ident, $inner:ident) => {
+        impl From<$inner<Ristretto255Suite>> for $enum {
+            fn from(value: $inner<Ristretto255Suite>) -> Self {
+                $enum::Ristretto255(value)
+            }
+        }
+
+        #[cfg(feature = "p256-suite")]
+        impl From<$inner<P256Suite>> for $enum {
+            fn from(value: $inner<P256Suite>) -> Self {
+                $enum::P256(value)
+            }
+        }
+    };
+}
+
+impl_from_suites!(ServerSetupHandle, ServerSetup);
+
+impl ServerSetupHandle {
+    fn decode(data: String, suite: OpaqueCipherSuite) -> OpaqueResult<ServerSetupHandle> {
+        base64_decode("serverSetup", data).and_then(|bytes| Self::deserialize(&bytes, suite))
+    }
+
+    fn deserialize(data: &[u8], suite: OpaqueCipherSuite) -> OpaqueResult<ServerSetupHandle> {
+        with_suite!(suite, engine => engine::deserialize_server_setup(data).map(Into::into))
+    }
+
+    fn suite(&self) -> Suite {
+        match self {
+            ServerSetupHandle::Ristretto255(_) => Suite::Ristretto255,
+            #[cfg(feature = "p256-suite")]
+            ServerSetupHandle::P256(_) => Suite::P256,
+        }
+    }
+
+    /// Fails unless `suite` is the default or the suite of the handle,
+    /// `Default` doesn't override the suite of a handle.
+    fn check_suite(&self, suite: OpaqueCipherSuite) -> OpaqueResult<()> {
+        if suite == OpaqueCipherSuite::Default || resolve_suite(suite)? == self.suite() {
+            Ok(())
+        } else {
+            Err(Error::Input {
+                message: "the cipher suite doesn't match the one of the serverSetup".to_string(),
+            })
+        }
+    }
+}
+
+pub fn opaque_create_server_setup_handle(
+    data: String,
+    suite: OpaqueCipherSuite,
+) -> Result<Box<ServerSetupHandle>, Error> {
+    ServerSetupHandle::decode(data, suite).map(Box::new)
+}
+
+pub fn opaque_create_server_setup_handle_binary(
+    data: &[u8],
+    suite: OpaqueCipherSuite,
+) -> Result<Box<ServerSetupHandle>, Error> {
+    ServerSetupHandle::deserialize(data, suite).map(Box::new)
+}
+
+pub fn opaque_get_server_public_key(
+    data: String,
+    suite: OpaqueCipherSuite,
+) -> Result<String, Error> {
+    let server_setup = ServerSetupHandle::decode(data, suite)?;
+    Ok(opaque_get_server_public_key_with_setup(&server_setup))
+}
+
+pub fn opaque_get_server_public_key_with_setup(server_setup: &ServerSetupHandle) -> String {
+    base64_encode(opaque_get_server_public_key_with_setup_binary(server_setup))
+}
+
+pub fn opaque_get_server_public_key_binary(
+    data: &[u8],
+    suite: OpaqueCipherSuite,
+) -> Result<Vec<u8>, Error> {
+    let server_setup = ServerSetupHandle::deserialize(data, suite)?;
+    Ok(opaque_get_server_public_key_with_setup_binary(
+        &server_setup,
+    ))
+}
+
+pub fn opaque_get_server_public_key_with_setup_binary(server_setup: &ServerSetupHandle) -> Vec<u8> {
+    with_setup!(server_setup, setup, engine => engine::get_server_public_key(setup))
+}
+
+pub fn opaque_check_server_setup_suite(
+    server_setup: &ServerSetupHandle,
+    suite: OpaqueCipherSuite,
+) -> Result<(), Error> {
+    Ok(server_setup.check_suite(suite)?)
+}
+
+pub fn opaque_create_server_registration_response(
+    server_setup: String,
     params: OpaqueCreateServerRegistrationResponseParams,
 ) -> Result<OpaqueCreateServerRegistrationResponseResult, Error> {
-    let server_setup = decode_server_setup(params.server_setup)?;
-    let registration_request_bytes =
-        base64_decode("registrationRequest", params.registration_request)?;
-    let server_registration_start_result = ServerRegistration::<DefaultCipherSuite>::start(
+    let server_setup = ServerSetupHandle::decode(server_setup, params.suite)?;
+    opaque_create_server_registration_response_with_setup(&server_setup, params)
+}
+
+pub fn opaque_create_server_registration_response_with_setup(
+    server_setup: &ServerSetupHandle,
+    params: OpaqueCreateServerRegistrationResponseParams,
+) -> Result<OpaqueCreateServerRegistrationResponseResult, Error> {
+    with_setup!(server_setup, params.suite, setup, engine => {
+        engine::create_server_registration_response_base64(setup, params)
+    })
+}
+
+pub fn opaque_create_server_registration_response_binary(
+    server_setup: &[u8],
+    user_identifier: &str,
+    registration_request: &[u8],
+    suite: OpaqueCipherSuite,
+) -> Result<OpaqueCreateServerRegistrationResponseBinaryResult, Error> {
+    let server_setup = ServerSetupHandle::deserialize(server_setup, suite)?;
+    opaque_create_server_registration_response_with_setup_binary(
         &server_setup,
-        RegistrationRequest::deserialize(&registration_request_bytes)
-            .map_err(from_protocol_error("deserialize registrationRequest"))?,
-        params.user_identifier.as_bytes(),
+        user_identifier,
+        registration_request,
     )
-    .map_err(from_protocol_error("start serverRegistration"))?;
-    let registration_response_bytes = server_registration_start_result.message.serialize();
-    Ok(OpaqueCreateServerRegistrationResponseResult {
-        registration_response: BASE64.encode(registration_response_bytes),
+}
+
+pub fn opaque_create_server_registration_response_with_setup_binary(
+    server_setup: &ServerSetupHandle,
+    user_identifier: &str,
+    registration_request: &[u8],
+) -> Result<OpaqueCreateServerRegistrationResponseBinaryResult, Error> {
+    with_setup!(server_setup, setup, engine => {
+        engine::create_server_registration_response(
+            setup,
+            user_identifier.as_bytes(),
+            registration_request,
+        )
     })
 }
 
-fn opaque_start_server_login(
+pub fn opaque_start_server_login(
+    server_setup: String,
     params: OpaqueStartServerLoginParams,
 ) -> Result<OpaqueStartServerLoginResult, Error> {
-    let server_setup = decode_server_setup(params.server_setup)?;
-    let registration_record_param = get_optional_string(params.registration_record)?;
-    let registration_record_bytes = match registration_record_param {
-        Some(pw) => base64_decode("registrationRecord", pw).map(Some),
-        None => Ok(None),
-    }?;
-    let credential_request_bytes = base64_decode("startLoginRequest", params.start_login_request)?;
-
-    let mut rng: OsRng = OsRng;
-
-    let registration_record = match registration_record_bytes.as_ref() {
-        Some(bytes) => Some(
-            ServerRegistration::<DefaultCipherSuite>::deserialize(bytes)
-                .map_err(from_protocol_error("deserialize registrationRecord"))?,
-        ),
-        None => None,
-    };
+    let server_setup = ServerSetupHandle::decode(server_setup, params.suite)?;
+    opaque_start_server_login_with_setup(&server_setup, params)
+}
 
-    let server_ident = get_optional_string(params.server_identifier)?;
-    let client_ident = get_optional_string(params.client_identifier)?;
+pub fn opaque_start_server_login_with_setup(
+    server_setup: &ServerSetupHandle,
+    params: OpaqueStartServerLoginParams,
+) -> Result<OpaqueStartServerLoginResult, Error> {
+    with_setup!(server_setup, params.suite, setup, engine => {
+        engine::start_server_login_base64(setup, params)
+    })
+}
 
-    let start_params = ServerLoginStartParameters {
-        identifiers: Identifiers {
-            client: client_ident.as_ref().map(|val| val.as_bytes()),
-            server: server_ident.as_ref().map(|val| val.as_bytes()),
+pub fn opaque_start_server_login_batch(
+    server_setup: &ServerSetupHandle,
+    requests: Vec<OpaqueStartServerLoginParams>,
+) -> Vec<OpaqueStartServerLoginBatchResult> {
+    let start = |params| match opaque_start_server_login_with_setup(server_setup, params) {
+        Ok(result) => OpaqueStartServerLoginBatchResult {
+            server_login_state: result.server_login_state,
+            login_response: result.login_response,
+            error_code: OpaqueErrorCode::None,
+            error_message: String::new(),
+        },
+        Err(error) => OpaqueStartServerLoginBatchResult {
+            server_login_state: String::new(),
+            login_response: String::new(),
+            error_code: error.code(),
+            error_message: error.message().to_string(),
         },
-        context: None,
     };
+    batch_pool::map_parallel(requests, start)
+}
 
-    let server_login_start_result = ServerLogin::start(
-        &mut rng,
+pub fn opaque_count_registration_import_records(records: &[u8]) -> Result<u64, Error> {
+    import::count_records(records)
+}
+
+pub fn opaque_create_server_registration_responses_chunk(
+    server_setup: &ServerSetupHandle,
+    records: &[u8],
+    max_records: usize,
+) -> Result<OpaqueRegistrationImportChunk, Error> {
+    let (records, consumed) = import::read_records(records, max_records)?;
+    let count = records.len();
+    let results = batch_pool::map_parallel(records, |record| {
+        opaque_create_server_registration_response_with_setup_binary(
+            server_setup,
+            record.user_identifier,
+            record.registration_request,
+        )
+    });
+
+    let mut responses = Vec::new();
+    let mut failed = 0;
+    for result in &results {
+        match result {
+            Ok(result) => {
+                import::write_result(&mut responses, Ok(result.registration_response.as_slice()))
+            }
+            Err(error) => {
+                failed += 1;
+                import::write_result(&mut responses, Err(error.message().to_string().as_str()));
+            }
+        }
+    }
+    Ok(OpaqueRegistrationImportChunk {
+        responses,
+        consumed,
+        records: count,
+        failed,
+    })
+}
+
+#[allow(clippy::too_many_arguments)]
+pub fn opaque_start_server_login_binary(
+    server_setup: &[u8],
+    registration_record: &[u8],
+    has_registration_record: bool,
+    start_login_request: &[u8],
+    user_identifier: &str,
+    client_identifier: Vec<String>,
+    server_identifier: Vec<String>,
+    suite: OpaqueCipherSuite,
+) -> Result<OpaqueStartServerLoginBinaryResult, Error> {
+    let server_setup = ServerSetupHandle::deserialize(server_setup, suite)?;
+    opaque_start_server_login_with_setup_binary(
         &server_setup,
         registration_record,
-        CredentialRequest::deserialize(&credential_request_bytes)
-            .map_err(from_protocol_error("deserialize startLoginRequest"))?,
-        params.user_identifier.as_bytes(),
-        start_params,
+        has_registration_record,
+        start_login_request,
+        user_identifier,
+        client_identifier,
+        server_identifier,
     )
-    .map_err(from_protocol_error("start server login"))?;
-
-    let login_response = BASE64.encode(server_login_start_result.message.serialize());
-    let server_login_state = BASE64.encode(server_login_start_result.state.serialize());
+}
 
-    let result = OpaqueStartServerLoginResult {
-        server_login_state,
-        login_response,
-    };
-    Ok(result)
+pub fn opaque_start_server_login_with_setup_binary(
+    server_setup: &ServerSetupHandle,
+    registration_record: &[u8],
+    has_registration_record: bool,
+    start_login_request: &[u8],
+    user_identifier: &str,
+    client_identifier: Vec<String>,
+    server_identifier: Vec<String>,
+) -> Result<OpaqueStartServerLoginBinaryResult, Error> {
+    with_setup!(server_setup, setup, engine => {
+        engine::start_server_login_binary(
+            setup,
+            has_registration_record.then_some(registration_record),
+            start_login_request,
+            user_identifier.as_bytes(),
+            client_identifier,
+            server_identifier,
+        )
+    })
 }
 
-fn opaque_finish_server_login(
+pub fn opaque_finish_server_login(
     params: OpaqueFinishServerLoginParams,
 ) -> Result<OpaqueFinishServerLoginResult, Error> {
     let credential_finalization_bytes =
         base64_decode("finishLoginRequest", params.finish_login_request)?;
     let state_bytes = base64_decode("serverLoginState", params.server_login_state)?;
-    let state = ServerLogin::<DefaultCipherSuite>::deserialize(&state_bytes)
-        .map_err(from_protocol_error("deserialize serverLoginState"))?;
-    let server_login_finish_result = state
-        .finish(
-            CredentialFinalization::deserialize(&credential_finalization_bytes)
-                .map_err(from_protocol_error("deserialize finishLoginRequest"))?,
-        )
-        .map_err(from_protocol_error("finish server login"))?;
+    let result = opaque_finish_server_login_binary(
+        &state_bytes,
+        &credential_finalization_bytes,
+        params.suite,
+    )?;
     Ok(OpaqueFinishServerLoginResult {
-        session_key: BASE64.encode(server_login_finish_result.session_key),
+        session_key: base64_encode(result.session_key),
     })
 }
 
-fn decode_server_setup(data: String) -> Result<ServerSetup<DefaultCipherSuite>, Error> {
-    base64_decode("serverSetup", data).and_then(|bytes| {
-        ServerSetup::<DefaultCipherSuite>::deserialize(&bytes)
-            .map_err(from_protocol_error("deserialize serverSetup"))
+pub fn opaque_finish_server_login_binary(
+    server_login_state: &[u8],
+    finish_login_request: &[u8],
+    suite: OpaqueCipherSuite,
+) -> Result<OpaqueFinishServerLoginBinaryResult, Error> {
+    with_suite!(suite, engine => {
+        let server_login_finish_result =
+            engine::finish_server_login(server_login_state, finish_login_request)?;
+        Ok(OpaqueFinishServerLoginBinaryResult {
+            session_key: server_login_finish_result.session_key.to_vec(),
+        })
     })
 }
 
-fn opaque_start_client_registration(
-    params: OpaqueStartClientRegistrationParams,
-) -> Result<OpaqueStartClientRegistrationResult, Error> {
-    let mut client_rng = OsRng;
+/// A client login state of any suite, kept in a `ClientLoginContext`.
+enum ClientLoginState {
+    Ristretto255(ClientLogin<Ristretto255Suite>),
+    #[cfg(feature = "p256-suite")]
+    P256(ClientLogin<P256Suite>),
+}
 
-    let client_registration_start_result = ClientRegistration::<DefaultCipherSuite>::start(
-        &mut client_rng,
-        params.password.as_bytes(),
-    )
-    .map_err(from_protocol_error("start client registration"))?;
+impl_from_suites!(ClientLoginState, ClientLogin);
+
+/// A copy of the password which is zeroized when it's dropped.
+struct Password(String);
+
+impl Drop for Password {
+    fn drop(&mut self) {
+        for byte in unsafe { self.0.as_bytes_mut() } {
+            // volatile so the zeroing isn't optimized away before the free
+            unsafe { (byte as *mut u8).write_volatile(0) };
+        }
+    }
+}
+
+/// What finishing a client login needs besides the login response.
+struct PendingClientLogin {
+    /// zeroized by opaque-ke when it's dropped
+    state: ClientLoginState,
+    password: Password,
+    client_identifier: Option<String>,
+    server_identifier: Option<String>,
+    key_stretching: Option<OpaqueKeyStretchingParams>,
+}
 
-    let result = opaque_ffi::OpaqueStartClientRegistrationResult {
-        client_registration_state: BASE64
-            .encode(client_registration_start_result.state.serialize()),
-        registration_request: BASE64.encode(client_registration_start_result.message.serialize()),
+/// A started client login kept in native memory until it's finished, so
+/// neither its state nor the password have to be passed back in from JS.
+/// The pending login is taken (and zeroized) by the first finish, or
+/// dropped together with the context.
+pub struct ClientLoginContext(Mutex<Option<PendingClientLogin>>);
+
+pub fn opaque_start_client_login_context(
+    input: OpaqueStartClientLoginContextInput,
+    start_login_request: &mut String,
+) -> Result<Box<ClientLoginContext>, Error> {
+    let state = with_suite!(input.suite, engine => {
+        let result = engine::start_client_login(input.password)?;
+        *start_login_request = base64_encode(result.message.serialize());
+        ClientLoginState::from(result.state)
+    });
+    let pending = PendingClientLogin {
+        state,
+        password: Password(input.password.to_string()),
+        client_identifier: optional(input.client_identifier, input.has_client_identifier)
+            .map(str::to_string),
+        server_identifier: optional(input.server_identifier, input.has_server_identifier)
+            .map(str::to_string),
+        key_stretching: input.has_key_stretching.then_some(input.key_stretching),
     };
-    Ok(result)
+    Ok(Box::new(ClientLoginContext(Mutex::new(Some(pending)))))
+}
+
+pub fn opaque_finish_client_login_context(
+    context: &ClientLoginContext,
+    login_response: &str,
+    out: &mut [u8],
+) -> Result<OpaqueFinishClientLoginOutput, Error> {
+    let mut response_buf = [0; MAX_MESSAGE_LEN];
+    let login_response = decode("loginResponse", login_response, &mut response_buf)?;
+    let pending = context
+        .0
+        .lock()
+        .unwrap_or_else(PoisonError::into_inner)
+        .take()
+        .ok_or_else(|| Error::Input {
+            message: "the client login context was already finished".to_string(),
+        })?;
+    let PendingClientLogin {
+        state,
+        password,
+        client_identifier,
+        server_identifier,
+        key_stretching,
+    } = pending;
+    macro_rules! finish {
+        ($engine:ident, $state:expr) => {{
+            let result = $engine::finish_client_login_state(
+                $state,
+                login_response,
+                &password.0,
+                client_identifier.as_deref(),
+                server_identifier.as_deref(),
+                key_stretching.as_ref(),
+            )?;
+            $engine::write_finish_client_login(result, out)
+        }};
+    }
+    match state {
+        ClientLoginState::Ristretto255(state) => finish!(ristretto255, state),
+        #[cfg(feature = "p256-suite")]
+        ClientLoginState::P256(state) => finish!(nist_p256, state),
+    }
+}
+
+/// A server login state of any suite, kept in the session store.
+enum ServerLoginState {
+    Ristretto255(ServerLogin<Ristretto255Suite>),
+    #[cfg(feature = "p256-suite")]
+    P256(ServerLogin<P256Suite>),
+}
+
+impl_from_suites!(ServerLoginState, ServerLogin);
+
+/// Server login states kept in native memory between starting and finishing
+/// a login, see `sessions.rs`.
+pub struct ServerLoginSessionStore(sessions::SessionStore<ServerLoginState>);
+
+pub fn opaque_create_server_login_session_store(
+    ttl_ms: u32,
+    max_memory_bytes: usize,
+) -> Result<Box<ServerLoginSessionStore>, Error> {
+    sessions::SessionStore::new(Duration::from_millis(ttl_ms.into()), max_memory_bytes)
+        .map(|store| Box::new(ServerLoginSessionStore(store)))
+}
+
+pub fn opaque_server_login_session_count(store: &ServerLoginSessionStore) -> usize {
+    store.0.session_count()
+}
+
+pub fn opaque_start_server_login_session(
+    store: &ServerLoginSessionStore,
+    server_setup: &ServerSetupHandle,
+    params: OpaqueStartServerLoginParams,
+) -> Result<OpaqueStartServerLoginSessionResult, Error> {
+    let (login_response, state) = with_setup!(server_setup, params.suite, setup, engine => {
+        let result = engine::start_server_login_params(setup, params)?;
+        (base64_encode(result.message.serialize()), ServerLoginState::from(result.state))
+    });
+    let handle = store.0.insert(state)?;
+    Ok(OpaqueStartServerLoginSessionResult {
+        session_handle: base64_encode(handle),
+        login_response,
+    })
+}
+
+pub fn opaque_finish_server_login_session(
+    store: &ServerLoginSessionStore,
+    session_handle: &str,
+    finish_login_request: &str,
+) -> Result<OpaqueFinishServerLoginResult, Error> {
+    let handle: sessions::SessionHandle = base64_decode("sessionHandle", session_handle)?
+        .try_into()
+        .map_err(|_| Error::Input {
+            message: "invalid sessionHandle".to_string(),
+        })?;
+    let finish_login_request = base64_decode("finishLoginRequest", finish_login_request)?;
+    let session_key = match store.0.take(&handle)? {
+        ServerLoginState::Ristretto255(state) => base64_encode(
+            ristretto255::finish_server_login_state(state, &finish_login_request)?.session_key,
+        ),
+        #[cfg(feature = "p256-suite")]
+        ServerLoginState::P256(state) => base64_encode(
+            nist_p256::finish_server_login_state(state, &finish_login_request)?.session_key,
+        ),
+    };
+    Ok(OpaqueFinishServerLoginResult { session_key })
+}
+
+pub fn opaque_start_client_registration(
+    params: OpaqueStartClientRegistrationParams,
+) -> Result<OpaqueStartClientRegistrationResult, Error> {
+    let result = opaque_start_client_registration_binary(&params.password, params.suite)?;
+    Ok(OpaqueStartClientRegistrationResult {
+        client_registration_state: base64_encode(result.client_registration_state),
+        registration_request: base64_encode(result.registration_request),
+    })
+}
+
+pub fn opaque_start_client_registration_binary(
+    password: &str,
+    suite: OpaqueCipherSuite,
+) -> Result<OpaqueStartClientRegistrationBinaryResult, Error> {
+    with_suite!(suite, engine => {
+        let client_registration_start_result = engine::start_client_registration(password)?;
+        Ok(OpaqueStartClientRegistrationBinaryResult {
+            client_registration_state: client_registration_start_result.state.serialize().to_vec(),
+            registration_request: client_registration_start_result
+                .message
+                .serialize()
+                .to_vec(),
+        })
+    })
 }
 
 fn get_optional_string(ident: Vec<String>) -> Result<Option<String>, Error> {
-    match ident.len() {
+    get_optional(ident)
+}
+
+fn get_optional<T: Clone>(values: Vec<T>) -> Result<Option<T>, Error> {
+    match values.len() {
         0 => Ok(None),
-        1 => ident.first().map_or_else(
+        1 => values.first().map_or_else(
             || {
                 Err(Error::Input {
                     message: "error getting value at index 0".to_string(),
@@ -352,102 +1555,189 @@ fn get_optional_string(ident: Vec<String>) -> Result<Option<String>, Error> {
     }
 }
 
-fn opaque_finish_client_registration(
+pub fn opaque_finish_client_registration(
     params: OpaqueFinishClientRegistrationParams,
 ) -> Result<OpaqueFinishClientRegistrationResult, Error> {
     let registration_response_bytes =
         base64_decode("registrationResponse", params.registration_response)?;
-    let mut rng: OsRng = OsRng;
     let client_registration =
         base64_decode("clientRegistrationState", params.client_registration_state)?;
-    let state = ClientRegistration::<DefaultCipherSuite>::deserialize(&client_registration)
-        .map_err(from_protocol_error("deserialize clientRegistrationState"))?;
-
-    let server_ident = get_optional_string(params.server_identifier)?;
-    let client_ident = get_optional_string(params.client_identifier)?;
+    let result = opaque_finish_client_registration_binary(
+        &params.password,
+        &registration_response_bytes,
+        &client_registration,
+        params.client_identifier,
+        params.server_identifier,
+        params.key_stretching,
+        params.suite,
+    )?;
+    Ok(OpaqueFinishClientRegistrationResult {
+        registration_record: base64_encode(result.registration_record),
+        export_key: base64_encode(result.export_key),
+        server_static_public_key: base64_encode(result.server_static_public_key),
+        key_stretching: result.key_stretching,
+    })
+}
 
-    let finish_params = ClientRegistrationFinishParameters::new(
-        Identifiers {
-            client: client_ident.as_ref().map(|val| val.as_bytes()),
-            server: server_ident.as_ref().map(|val| val.as_bytes()),
-        },
-        None,
-    );
-
-    let client_finish_registration_result = state
-        .finish(
-            &mut rng,
-            params.password.as_bytes(),
-            RegistrationResponse::deserialize(&registration_response_bytes)
-                .map_err(from_protocol_error("deserialize registrationResponse"))?,
-            finish_params,
-        )
-        .map_err(from_protocol_error("finish client registration"))?;
-
-    let message_bytes = client_finish_registration_result.message.serialize();
-    let result = OpaqueFinishClientRegistrationResult {
-        registration_record: BASE64.encode(message_bytes),
-        export_key: BASE64.encode(client_finish_registration_result.export_key),
-        server_static_public_key: BASE64
-            .encode(client_finish_registration_result.server_s_pk.serialize()),
-    };
-    Ok(result)
+pub fn opaque_finish_client_registration_binary(
+    password: &str,
+    registration_response: &[u8],
+    client_registration_state: &[u8],
+    client_identifier: Vec<String>,
+    server_identifier: Vec<String>,
+    key_stretching: Vec<OpaqueKeyStretchingParams>,
+    suite: OpaqueCipherSuite,
+) -> Result<OpaqueFinishClientRegistrationBinaryResult, Error> {
+    let client_identifier = get_optional_string(client_identifier)?;
+    let server_identifier = get_optional_string(server_identifier)?;
+    let key_stretching = get_optional(key_stretching)?;
+    with_suite!(suite, engine => {
+        let client_finish_registration_result = engine::finish_client_registration(
+            password,
+            registration_response,
+            client_registration_state,
+            client_identifier.as_deref(),
+            server_identifier.as_deref(),
+            key_stretching.as_ref(),
+        )?;
+
+        Ok(OpaqueFinishClientRegistrationBinaryResult {
+            registration_record: client_finish_registration_result
+                .message
+                .serialize()
+                .to_vec(),
+            export_key: client_finish_registration_result.export_key.to_vec(),
+            server_static_public_key: client_finish_registration_result
+                .server_s_pk
+                .serialize()
+                .to_vec(),
+            key_stretching: key_stretching.unwrap_or_else(ksf::default_params),
+        })
+    })
 }
 
-fn opaque_start_client_login(
+pub fn opaque_start_client_login(
     params: OpaqueStartClientLoginParams,
 ) -> Result<OpaqueStartClientLoginResult, Error> {
-    let mut client_rng = OsRng;
-    let client_login_start_result =
-        ClientLogin::<DefaultCipherSuite>::start(&mut client_rng, params.password.as_bytes())
-            .map_err(from_protocol_error("start clientLogin"))?;
-
-    let result = OpaqueStartClientLoginResult {
-        client_login_state: BASE64.encode(client_login_start_result.state.serialize()),
-        start_login_request: BASE64.encode(client_login_start_result.message.serialize()),
-    };
-    Ok(result)
+    let result = opaque_start_client_login_binary(&params.password, params.suite)?;
+    Ok(OpaqueStartClientLoginResult {
+        client_login_state: base64_encode(result.client_login_state),
+        start_login_request: base64_encode(result.start_login_request),
+    })
+}
+
+pub fn opaque_start_client_login_binary(
+    password: &str,
+    suite: OpaqueCipherSuite,
+) -> Result<OpaqueStartClientLoginBinaryResult, Error> {
+    with_suite!(suite, engine => {
+        let client_login_start_result = engine::start_client_login(password)?;
+        Ok(OpaqueStartClientLoginBinaryResult {
+            client_login_state: client_login_start_result.state.serialize().to_vec(),
+            start_login_request: client_login_start_result.message.serialize().to_vec(),
+        })
+    })
 }
 
-fn opaque_finish_client_login(
+pub fn opaque_finish_client_login(
     params: OpaqueFinishClientLoginParams,
 ) -> Result<cxx::UniquePtr<OpaqueFinishClientLoginResult>, Error> {
     let credential_response_bytes = base64_decode("loginResponse", params.login_response)?;
     let state_bytes = base64_decode("clientLoginState", params.client_login_state)?;
-    let state = ClientLogin::<DefaultCipherSuite>::deserialize(&state_bytes)
-        .map_err(from_protocol_error("deserialize clientLoginState"))?;
+    let client_identifier = get_optional_string(params.client_identifier)?;
+    let server_identifier = get_optional_string(params.server_identifier)?;
+    let key_stretching = get_optional(params.key_stretching)?;
+    with_suite!(params.suite, engine => {
+        let result = engine::finish_client_login(
+            &state_bytes,
+            &credential_response_bytes,
+            &params.password,
+            client_identifier.as_deref(),
+            server_identifier.as_deref(),
+            key_stretching.as_ref(),
+        )?;
+        Ok(match result {
+            Some(result) => cxx::UniquePtr::new(OpaqueFinishClientLoginResult {
+                finish_login_request: base64_encode(result.message.serialize()),
+                session_key: base64_encode(result.session_key),
+                export_key: base64_encode(result.export_key),
+                server_static_public_key: base64_encode(result.server_s_pk.serialize()),
+            }),
+            None => cxx::UniquePtr::null(),
+        })
+    })
+}
 
-    let server_ident = get_optional_string(params.server_identifier)?;
-    let client_ident = get_optional_string(params.client_identifier)?;
+#[allow(clippy::too_many_arguments)]
+pub fn opaque_finish_client_login_binary(
+    client_login_state: &[u8],
+    login_response: &[u8],
+    password: &str,
+    client_identifier: Vec<String>,
+    server_identifier: Vec<String>,
+    key_stretching: Vec<OpaqueKeyStretchingParams>,
+    suite: OpaqueCipherSuite,
+) -> Result<cxx::UniquePtr<OpaqueFinishClientLoginBinaryResult>, Error> {
+    let result = finish_client_login_binary(
+        client_login_state,
+        login_response,
+        password,
+        client_identifier,
+        server_identifier,
+        key_stretching,
+        suite,
+    )?;
+    Ok(result.map_or_else(cxx::UniquePtr::null, cxx::UniquePtr::new))
+}
 
-    let finish_params = ClientLoginFinishParameters::new(
-        None,
-        Identifiers {
-            client: client_ident.as_ref().map(|val| val.as_bytes()),
-            server: server_ident.as_ref().map(|val| val.as_bytes()),
-        },
-        None,
-    );
-
-    let result = state.finish(
-        params.password.as_bytes(),
-        CredentialResponse::deserialize(&credential_response_bytes)
-            .map_err(from_protocol_error("deserialize loginResponse"))?,
-        finish_params,
-    );
-
-    if result.is_err() {
-        // Client-detected login failure
-        return Ok(cxx::UniquePtr::null());
-    }
-    let client_login_finish_result = result.unwrap();
-
-    let result = OpaqueFinishClientLoginResult {
-        finish_login_request: BASE64.encode(client_login_finish_result.message.serialize()),
-        session_key: BASE64.encode(client_login_finish_result.session_key),
-        export_key: BASE64.encode(client_login_finish_result.export_key),
-        server_static_public_key: BASE64.encode(client_login_finish_result.server_s_pk.serialize()),
-    };
+/// `None` if the client detected a login failure.
+#[allow(clippy::too_many_arguments)]
+pub(crate) fn finish_client_login_binary(
+    client_login_state: &[u8],
+    login_response: &[u8],
+    password: &str,
+    client_identifier: Vec<String>,
+    server_identifier: Vec<String>,
+    key_stretching: Vec<OpaqueKeyStretchingParams>,
+    suite: OpaqueCipherSuite,
+) -> Result<Option<OpaqueFinishClientLoginBinaryResult>, Error> {
+    let client_identifier = get_optional_string(client_identifier)?;
+    let server_identifier = get_optional_string(server_identifier)?;
+    let key_stretching = get_optional(key_stretching)?;
+    with_suite!(suite, engine => {
+        let result = engine::finish_client_login(
+            client_login_state,
+            login_response,
+            password,
+            client_identifier.as_deref(),
+            server_identifier.as_deref(),
+            key_stretching.as_ref(),
+        )?;
+        Ok(result.map(|result| OpaqueFinishClientLoginBinaryResult {
+            finish_login_request: result.message.serialize().to_vec(),
+            session_key: result.session_key.to_vec(),
+            export_key: result.export_key.to_vec(),
+            server_static_public_key: result.server_s_pk.serialize().to_vec(),
+        }))
+    })
+}
+
+pub fn opaque_set_metrics_enabled(enabled: bool) {
+    metrics::set_enabled(enabled);
+}
+
+pub fn opaque_get_metrics() -> Vec<OpaqueMetricsEntry> {
+    metrics::snapshot()
+}
+
+pub fn opaque_reset_metrics() {
+    metrics::reset();
+}
+
+pub fn opaque_metrics_begin(function: OpaqueMetricsFunction) {
+    metrics::begin(function);
+}
 
-    Ok(cxx::UniquePtr::new(result))
+pub fn opaque_metrics_end() {
+    metrics::end();
 }
@@ -0,0 +1,274 @@
+//! Opt-in timing of the protocol functions, split into the phases of a call.
+//!
+//! Metrics are disabled by default, every measuring point then costs a
+//! relaxed atomic load. Once enabled, the JSI module wraps every call of an
+//! instrumented function in `begin`/`end`, and the phases measured on the
+//! same thread in between are attributed to that function. The time of a
+//! phase excludes the phases nested in it, e.g. `group` doesn't include the
+//! KSF run by `ClientLogin::finish`. The rest of the call, mostly reading
+//! the params from JS and creating the results, is recorded as
+//! `marshalling`.
+//!
+//! Recording only touches atomics, there are no locks. A reset racing with
+//! a recording call can leave that call partially counted.
+
+use std::cell::Cell;
+use std::sync::atomic::{AtomicBool, AtomicU64, Ordering::Relaxed};
+use std::time::Instant;
+
+use crate::opaque_ffi::{OpaqueMetricsEntry, OpaqueMetricsFunction};
+
+static ENABLED: AtomicBool = AtomicBool::new(false);
+
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum Phase {
+    Marshalling,
+    Base64,
+    Deserialize,
+    Ksf,
+    /// the protocol computations of opaque-ke, mostly group operations
+    Group,
+    /// the whole call
+    Total,
+}
+
+const PHASES: usize = 6;
+const PHASE_NAMES: [&str; PHASES] = [
+    "marshalling",
+    "base64",
+    "deserialize",
+    "ksf",
+    "group",
+    "total",
+];
+
+const FUNCTIONS: usize = 7;
+const FUNCTION_NAMES: [&str; FUNCTIONS] = [
+    "startClientRegistration",
+    "finishClientRegistration",
+    "startClientLogin",
+    "finishClientLogin",
+    "createServerRegistrationResponse",
+    "startServerLogin",
+    "finishServerLogin",
+];
+
+/// Bucket `i` counts the durations in `[2^i, 2^(i + 1))` ns, the last one
+/// everything from about 9 minutes on.
+const BUCKETS: usize = 40;
+
+struct Histogram {
+    total_ns: AtomicU64,
+    max_ns: AtomicU64,
+    buckets: [AtomicU64; BUCKETS],
+}
+
+#[allow(clippy::declare_interior_mutable_const)]
+const ZERO: AtomicU64 = AtomicU64::new(0);
+
+#[allow(clippy::declare_interior_mutable_const)]
+const EMPTY: Histogram = Histogram {
+    total_ns: ZERO,
+    max_ns: ZERO,
+    buckets: [ZERO; BUCKETS],
+};
+
+#[allow(clippy::declare_interior_mutable_const)]
+const EMPTY_FUNCTION: [Histogram; PHASES] = [EMPTY; PHASES];
+
+static HISTOGRAMS: [[Histogram; PHASES]; FUNCTIONS] = [EMPTY_FUNCTION; FUNCTIONS];
+
+impl Histogram {
+    fn record(&self, ns: u64) {
+        let bucket = ((u64::BITS - ns.leading_zeros()).saturating_sub(1) as usize).min(BUCKETS - 1);
+        self.total_ns.fetch_add(ns, Relaxed);
+        self.max_ns.fetch_max(ns, Relaxed);
+        self.buckets[bucket].fetch_add(1, Relaxed);
+    }
+
+    fn reset(&self) {
+        self.total_ns.store(0, Relaxed);
+        self.max_ns.store(0, Relaxed);
+        for bucket in &self.buckets {
+            bucket.store(0, Relaxed);
+        }
+    }
+
+    /// Upper bound of the bucket containing the quantile, capped at the
+    /// maximum.
+    fn quantile_ns(&self, buckets: &[u64; BUCKETS], count: u64, quantile: f64) -> u64 {
+        let rank = ((count as f64 * quantile).ceil() as u64).max(1);
+        let mut seen = 0;
+        for (i, &n) in buckets.iter().enumerate() {
+            seen += n;
+            if seen >= rank {
+                return (1u64 << (i + 1)).min(self.max_ns.load(Relaxed));
+            }
+        }
+        self.max_ns.load(Relaxed)
+    }
+}
+
+/// The function and start of the current call.
+#[derive(Clone, Copy)]
+struct Scope {
+    function: usize,
+    start: Instant,
+}
+
+thread_local! {
+    static SCOPE: Cell<Option<Scope>> = const { Cell::new(None) };
+    /// Time of the phases measured within the innermost running phase, or
+    /// within the call if no phase is running.
+    static NESTED_NS: Cell<u64> = const { Cell::new(0) };
+}
+
+fn elapsed_ns(start: Instant) -> u64 {
+    start.elapsed().as_nanos().try_into().unwrap_or(u64::MAX)
+}
+
+pub fn set_enabled(enabled: bool) {
+    ENABLED.store(enabled, Relaxed);
+}
+
+/// Starts a call of `function` on the current thread.
+pub fn begin(function: OpaqueMetricsFunction) {
+    let function = function.repr as usize;
+    if !ENABLED.load(Relaxed) || function >= FUNCTIONS {
+        return;
+    }
+    NESTED_NS.with(|nested| nested.set(0));
+    SCOPE.with(|scope| {
+        scope.set(Some(Scope {
+            function,
+            start: Instant::now(),
+        }))
+    });
+}
+
+/// Ends the call started by `begin` and records its total and marshalling
+/// time.
+pub fn end() {
+    let Some(scope) = SCOPE.with(|scope| scope.take()) else {
+        return;
+    };
+    let total = elapsed_ns(scope.start);
+    let phases = NESTED_NS.with(Cell::get);
+    let histograms = &HISTOGRAMS[scope.function];
+    histograms[Phase::Total as usize].record(total);
+    histograms[Phase::Marshalling as usize].record(total.saturating_sub(phases));
+}
+
+/// Runs `f` and records its duration as `phase` of the current call.
+#[inline]
+pub fn time<T>(phase: Phase, f: impl FnOnce() -> T) -> T {
+    if !ENABLED.load(Relaxed) {
+        return f();
+    }
+    time_enabled(phase, f)
+}
+
+fn time_enabled<T>(phase: Phase, f: impl FnOnce() -> T) -> T {
+    let Some(scope) = SCOPE.with(Cell::get) else {
+        return f();
+    };
+    let outer = NESTED_NS.with(|nested| nested.replace(0));
+    let start = Instant::now();
+    let result = f();
+    let elapsed = elapsed_ns(start);
+    let nested = NESTED_NS.with(|nested| nested.replace(outer.saturating_add(elapsed)));
+    HISTOGRAMS[scope.function][phase as usize].record(elapsed.saturating_sub(nested));
+    result
+}
+
+/// One entry per function and phase that was recorded at least once.
+pub fn snapshot() -> Vec<OpaqueMetricsEntry> {
+    let mut entries = Vec::new();
+    for (function, histograms) in HISTOGRAMS.iter().enumerate() {
+        for (phase, histogram) in histograms.iter().enumerate() {
+            let buckets = std::array::from_fn(|i| histogram.buckets[i].load(Relaxed));
+            let count: u64 = buckets.iter().sum();
+            if count == 0 {
+                continue;
+            }
+            entries.push(OpaqueMetricsEntry {
+                function: FUNCTION_NAMES[function].to_string(),
+                phase: PHASE_NAMES[phase].to_string(),
+                count,
+                total_ns: histogram.total_ns.load(Relaxed),
+                max_ns: histogram.max_ns.load(Relaxed),
+                p50_ns: histogram.quantile_ns(&buckets, count, 0.5),
+                p90_ns: histogram.quantile_ns(&buckets, count, 0.9),
+                p99_ns: histogram.quantile_ns(&buckets, count, 0.99),
+            });
+        }
+    }
+    entries
+}
+
+pub fn reset() {
+    for histogram in HISTOGRAMS.iter().flatten() {
+        histogram.reset();
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::sync::Mutex;
+    use std::time::Duration;
+
+    // the metrics are global, the tests must not run concurrently
+    static LOCK: Mutex<()> = Mutex::new(());
+
+    fn entry(function: &str, phase: &str) -> Option<OpaqueMetricsEntry> {
+        snapshot()
+            .into_iter()
+            .find(|entry| entry.function == function && entry.phase == phase)
+    }
+
+    #[test]
+    fn nothing_is_recorded_while_disabled() {
+        let _lock = LOCK.lock().unwrap();
+        reset();
+        set_enabled(false);
+        begin(OpaqueMetricsFunction::StartServerLogin);
+        time(Phase::Base64, || ());
+        end();
+        assert!(snapshot().is_empty());
+    }
+
+    #[test]
+    fn phases_exclude_nested_phases() {
+        let _lock = LOCK.lock().unwrap();
+        reset();
+        set_enabled(true);
+        begin(OpaqueMetricsFunction::FinishClientLogin);
+        time(Phase::Group, || {
+            std::thread::sleep(Duration::from_millis(2));
+            time(Phase::Ksf, || std::thread::sleep(Duration::from_millis(20)));
+        });
+        end();
+        // phases outside of a call are ignored
+        time(Phase::Base64, || ());
+        set_enabled(false);
+
+        let total = entry("finishClientLogin", "total").unwrap();
+        let group = entry("finishClientLogin", "group").unwrap();
+        let ksf = entry("finishClientLogin", "ksf").unwrap();
+        let marshalling = entry("finishClientLogin", "marshalling").unwrap();
+        assert_eq!(total.count, 1);
+        assert!(ksf.total_ns >= 20_000_000);
+        assert!(group.total_ns >= 2_000_000 && group.total_ns < ksf.total_ns);
+        assert!(marshalling.total_ns < group.total_ns);
+        assert_eq!(
+            total.total_ns,
+            marshalling.total_ns + group.total_ns + ksf.total_ns
+        );
+        assert!(entry("finishClientLogin", "base64").is_none());
+        assert!(ksf.p50_ns <= ksf.max_ns && ksf.p50_ns >= ksf.max_ns / 2);
+
+        reset();
+        assert!(snapshot().is_empty());
+    }
+}
@@ -0,0 +1,445 @@
+//! Argon2id (version 0x13, RFC 9106) which computes the lanes of every slice
+//! concurrently. The `argon2` crate fills the lanes one after another, so
+//! parameters with more than one lane only change the result but don't use
+//! more cores. The output is the same as the one of the `argon2` crate.
+
+use std::sync::Barrier;
+use std::thread;
+
+use argon2::Params;
+use blake2::digest::{Update, VariableOutput};
+use blake2::Blake2bVar;
+
+use crate::argon2_arena;
+
+use argon2_arena::BLOCK_SIZE;
+const BLOCK_WORDS: usize = BLOCK_SIZE / 8;
+const SYNC_POINTS: usize = 4;
+const VERSION: u32 = 0x13;
+const ARGON2ID: u32 = 2;
+
+#[derive(Clone, Copy)]
+#[repr(align(64))]
+struct Block([u64; BLOCK_WORDS]);
+
+impl Default for Block {
+    fn default() -> Self {
+        Block::ZERO
+    }
+}
+
+impl Block {
+    const ZERO: Block = Block([0; BLOCK_WORDS]);
+
+    fn from_bytes(bytes: &[u8]) -> Block {
+        let mut block = Block::ZERO;
+        for (word, chunk) in block.0.iter_mut().zip(bytes.chunks_exact(8)) {
+            *word = u64::from_le_bytes(chunk.try_into().unwrap());
+        }
+        block
+    }
+
+    fn to_bytes(&self) -> [u8; BLOCK_SIZE] {
+        let mut bytes = [0u8; BLOCK_SIZE];
+        for (chunk, word) in bytes.chunks_exact_mut(8).zip(self.0.iter()) {
+            chunk.copy_from_slice(&word.to_le_bytes());
+        }
+        bytes
+    }
+
+    fn xor_assign(&mut self, other: &Block) {
+        for (a, b) in self.0.iter_mut().zip(other.0.iter()) {
+            *a ^= b;
+        }
+    }
+}
+
+fn blake2b(out: &mut [u8], inputs: &[&[u8]]) {
+    let mut hasher = Blake2bVar::new(out.len()).expect("invalid blake2b output size");
+    for input in inputs {
+        hasher.update(input);
+    }
+    hasher
+        .finalize_variable(out)
+        .expect("invalid blake2b output size");
+}
+
+/// The variable length hash function H' of the RFC.
+fn blake2b_long(out: &mut [u8], inputs: &[&[u8]]) {
+    let out_len = (out.len() as u32).to_le_bytes();
+    let mut prefixed = Vec::with_capacity(inputs.len() + 1);
+    prefixed.push(&out_len[..]);
+    prefixed.extend_from_slice(inputs);
+    if out.len() <= 64 {
+        blake2b(out, &prefixed);
+        return;
+    }
+    let mut v = [0u8; 64];
+    blake2b(&mut v, &prefixed);
+    out[..32].copy_from_slice(&v[..32]);
+    let mut pos = 32;
+    while out.len() - pos > 64 {
+        let previous = v;
+        blake2b(&mut v, &[&previous]);
+        out[pos..pos + 32].copy_from_slice(&v[..32]);
+        pos += 32;
+    }
+    let previous = v;
+    blake2b(&mut out[pos..], &[&previous]);
+}
+
+#[inline(always)]
+fn blamka(x: u64, y: u64) -> u64 {
+    x.wrapping_add(y).wrapping_add(
+        2u64.wrapping_mul(x & 0xffff_ffff)
+            .wrapping_mul(y & 0xffff_ffff),
+    )
+}
+
+#[inline(always)]
+fn round(v: &mut [u64; BLOCK_WORDS], i: [usize; 16]) {
+    #[inline(always)]
+    fn g(v: &mut [u64; BLOCK_WORDS], a: usize, b: usize, c: usize, d: usize) {
+        v[a] = blamka(v[a], v[b]);
+        v[d] = (v[d] ^ v[a]).rotate_right(32);
+        v[c] = blamka(v[c], v[d]);
+        v[b] = (v[b] ^ v[c]).rotate_right(24);
+        v[a] = blamka(v[a], v[b]);
+        v[d] = (v[d] ^ v[a]).rotate_right(16);
+        v[c] = blamka(v[c], v[d]);
+        v[b] = (v[b] ^ v[c]).rotate_right(63);
+    }
+    g(v, i[0], i[4], i[8], i[12]);
+    g(v, i[1], i[5], i[9], i[13]);
+    g(v, i[2], i[6], i[10], i[14]);
+    g(v, i[3], i[7], i[11], i[15]);
+    g(v, i[0], i[5], i[10], i[15]);
+    g(v, i[1], i[6], i[11], i[12]);
+    g(v, i[2], i[7], i[8], i[13]);
+    g(v, i[3], i[4], i[9], i[14]);
+}
+
+/// Computes the next block of pseudo-random reference indices for the data
+/// independent addressing.
+fn next_addresses(input_block: &mut Block, address_block: &mut Block) {
+    input_block.0[6] += 1;
+    compress(&Block::ZERO, input_block, address_block, false);
+    let addresses = *address_block;
+    compress(&Block::ZERO, &addresses, address_block, false);
+}
+
+/// The compression function G, xored into `next` instead of overwriting it
+/// from the second pass on.
+fn compress(prev: &Block, reference: &Block, next: &mut Block, with_xor: bool) {
+    let mut r = *reference;
+    r.xor_assign(prev);
+    let mut tmp = r;
+    if with_xor {
+        tmp.xor_assign(next);
+    }
+    for row in 0..8 {
+        let b = row * 16;
+        round(&mut r.0, std::array::from_fn(|k| b + k));
+    }
+    for column in 0..8 {
+        let b = column * 2;
+        round(&mut r.0, std::array::from_fn(|k| b + (k / 2) * 16 + k % 2));
+    }
+    tmp.xor_assign(&r);
+    *next = tmp;
+}
+
+/// The memory shared by the threads. Each thread only writes the segments of
+/// its own lanes and only reads blocks which were completed before the last
+/// synchronization point or belong to its own lanes, see `fill_segment`.
+struct Memory {
+    blocks: *mut Block,
+    len: usize,
+}
+
+unsafe impl Send for Memory {}
+unsafe impl Sync for Memory {}
+
+impl Memory {
+    /// # Safety
+    /// No other thread may write the block at the same time.
+    unsafe fn get(&self, index: usize) -> &Block {
+        debug_assert!(index < self.len);
+        &*self.blocks.add(index)
+    }
+
+    /// # Safety
+    /// No other thread may access the block at the same time.
+    #[allow(clippy::mut_from_ref)]
+    unsafe fn get_mut(&self, index: usize) -> &mut Block {
+        debug_assert!(index < self.len);
+        &mut *self.blocks.add(index)
+    }
+}
+
+struct Instance {
+    passes: usize,
+    lanes: usize,
+    lane_length: usize,
+    segment_length: usize,
+}
+
+impl Instance {
+    fn block_count(&self) -> usize {
+        self.lane_length * self.lanes
+    }
+
+    /// The position of the reference block within its lane, section 3.4.2 of
+    /// the RFC.
+    fn reference_index(
+        &self,
+        pass: usize,
+        slice: usize,
+        index: usize,
+        pseudo_rand: u32,
+        same_lane: bool,
+    ) -> usize {
+        let finished = if pass == 0 {
+            slice * self.segment_length
+        } else {
+            self.lane_length - self.segment_length
+        };
+        let reference_area_size = if same_lane {
+            finished + index - 1
+        } else if index == 0 {
+            finished - 1
+        } else {
+            finished
+        } as u64;
+        let x = (u64::from(pseudo_rand) * u64::from(pseudo_rand)) >> 32;
+        let relative_position = reference_area_size - 1 - ((reference_area_size * x) >> 32);
+        let start_position = if pass == 0 || slice == SYNC_POINTS - 1 {
+            0
+        } else {
+            (slice + 1) * self.segment_length
+        };
+        (start_position + relative_position as usize) % self.lane_length
+    }
+
+    fn fill_segment(&self, memory: &Memory, pass: usize, lane: usize, slice: usize) {
+        let data_independent = pass == 0 && slice < SYNC_POINTS / 2;
+        let mut address_block = Block::ZERO;
+        let mut input_block = Block::ZERO;
+        if data_independent {
+            input_block.0[..6].copy_from_slice(&[
+                pass as u64,
+                lane as u64,
+                slice as u64,
+                self.block_count() as u64,
+                self.passes as u64,
+                u64::from(ARGON2ID),
+            ]);
+        }
+
+        let mut first = 0;
+        if pass == 0 && slice == 0 {
+            // the first two blocks of every lane are set up by `hash_password_into`
+            first = 2;
+            if data_independent {
+                next_addresses(&mut input_block, &mut address_block);
+            }
+        }
+
+        let lane_start = lane * self.lane_length;
+        for index in first..self.segment_length {
+            let column = slice * self.segment_length + index;
+            let prev_column = if column == 0 {
+                self.lane_length - 1
+            } else {
+                column - 1
+            };
+            // SAFETY: the previous block is in the lane owned by this thread
+            let prev = unsafe { memory.get(lane_start + prev_column) };
+            let pseudo_rand = if data_independent {
+                if index % BLOCK_WORDS == 0 {
+                    next_addresses(&mut input_block, &mut address_block);
+                }
+                address_block.0[index % BLOCK_WORDS]
+            } else {
+                prev.0[0]
+            };
+            let reference_lane = if pass == 0 && slice == 0 {
+                lane
+            } else {
+                (pseudo_rand >> 32) as usize % self.lanes
+            };
+            let reference_index = self.reference_index(
+                pass,
+                slice,
+                index,
+                pseudo_rand as u32,
+                reference_lane == lane,
+            );
+            // SAFETY: the reference block is either in a lane owned by this
+            // thread or outside of the current slice, which no thread writes
+            // before the next synchronization point. It's never the current
+            // block.
+            let reference =
+                unsafe { memory.get(reference_lane * self.lane_length + reference_index) };
+            let mut next = Block::ZERO;
+            let current = unsafe { memory.get_mut(lane_start + column) };
+            if pass > 0 {
+                next = *current;
+            }
+            compress(prev, reference, &mut next, pass > 0);
+            *current = next;
+        }
+    }
+}
+
+/// Same as `argon2::Argon2::hash_password_into` for Argon2id with the given
+/// parameters, computing the lanes on up to `threads` threads.
+pub fn hash_password_into(
+    params: &Params,
+    threads: usize,
+    password: &[u8],
+    salt: &[u8],
+    out: &mut [u8],
+) {
+    hash_into(params, threads, password, salt, &[], &[], out);
+}
+
+/// Argon2id with the optional secret and associated data of the RFC, which
+/// the KSF doesn't use.
+fn hash_into(
+    params: &Params,
+    threads: usize,
+    password: &[u8],
+    salt: &[u8],
+    secret: &[u8],
+    associated_data: &[u8],
+    out: &mut [u8],
+) {
+    let lanes = params.p_cost() as usize;
+    let requested_blocks = (params.m_cost() as usize).max(2 * SYNC_POINTS * lanes);
+    let segment_length = requested_blocks / (lanes * SYNC_POINTS);
+    let instance = Instance {
+        passes: params.t_cost() as usize,
+        lanes,
+        lane_length: segment_length * SYNC_POINTS,
+        segment_length,
+    };
+
+    let mut h0 = [0u8; 64];
+    blake2b(
+        &mut h0,
+        &[
+            &params.p_cost().to_le_bytes(),
+            &(out.len() as u32).to_le_bytes(),
+            &params.m_cost().to_le_bytes(),
+            &params.t_cost().to_le_bytes(),
+            &VERSION.to_le_bytes(),
+            &ARGON2ID.to_le_bytes(),
+            &(password.len() as u32).to_le_bytes(),
+            password,
+            &(salt.len() as u32).to_le_bytes(),
+            salt,
+            &(secret.len() as u32).to_le_bytes(),
+            secret,
+            &(associated_data.len() as u32).to_le_bytes(),
+            associated_data,
+        ],
+    );
+
+    // every block is overwritten in the first pass, the arena doesn't need
+    // to be cleared
+    argon2_arena::with_blocks(instance.block_count(), |blocks: &mut [Block]| {
+        let mut block_bytes = [0u8; BLOCK_SIZE];
+        for lane in 0..lanes {
+            for column in 0..2u32 {
+                blake2b_long(
+                    &mut block_bytes,
+                    &[&h0, &column.to_le_bytes(), &(lane as u32).to_le_bytes()],
+                );
+                blocks[lane * instance.lane_length + column as usize] =
+                    Block::from_bytes(&block_bytes);
+            }
+        }
+
+        let threads = threads.clamp(1, lanes);
+        let memory = Memory {
+            blocks: blocks.as_mut_ptr(),
+            len: blocks.len(),
+        };
+        let barrier = Barrier::new(threads);
+        // Scoped threads per hash instead of a persistent pool: spawning
+        // them costs microseconds against a hash of tens of milliseconds,
+        // and they can borrow the blocks of this call without extending
+        // their lifetime.
+        let fill_lanes = |first_lane: usize| {
+            for pass in 0..instance.passes {
+                for slice in 0..SYNC_POINTS {
+                    for lane in (first_lane..lanes).step_by(threads) {
+                        instance.fill_segment(&memory, pass, lane, slice);
+                    }
+                    barrier.wait();
+                }
+            }
+        };
+        thread::scope(|scope| {
+            for first_lane in 1..threads {
+                scope.spawn(move || fill_lanes(first_lane));
+            }
+            fill_lanes(0);
+        });
+
+        let mut final_block = blocks[instance.lane_length - 1];
+        for lane in 1..lanes {
+            final_block.xor_assign(&blocks[lane * instance.lane_length + instance.lane_length - 1]);
+        }
+        blake2b_long(out, &[&final_block.to_bytes()]);
+    })
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use argon2::{Algorithm, Argon2, Version};
+
+    /// The Argon2id test vector of RFC 9106, section 5.3.
+    #[test]
+    fn matches_rfc_9106_test_vector() {
+        let params = Params::new(32, 3, 4, Some(32)).unwrap();
+        let expected = [
+            0x0d, 0x64, 0x0d, 0xf5, 0x8d, 0x78, 0x76, 0x6c, 0x08, 0xc0, 0x37, 0xa3, 0x4a, 0x8b,
+            0x53, 0xc9, 0xd0, 0x1e, 0xf0, 0x45, 0x2d, 0x75, 0xb6, 0x5e, 0xb5, 0x25, 0x20, 0xe9,
+            0x6b, 0x01, 0xe6, 0x59,
+        ];
+        for threads in 1..=4 {
+            let mut output = [0u8; 32];
+            hash_into(
+                &params,
+                threads,
+                &[0x01; 32],
+                &[0x02; 16],
+                &[0x03; 8],
+                &[0x04; 12],
+                &mut output,
+            );
+            assert_eq!(output, expected, "on {} threads", threads);
+        }
+    }
+
+    #[test]
+    fn matches_argon2_crate() {
+        let password = b"hunter42";
+        let salt = [0u8; argon2::RECOMMENDED_SALT_LEN];
+        for (m_cost, t_cost, p_cost) in [(64, 1, 1), (64, 3, 2), (256, 2, 4), (1024, 1, 3)] {
+            let params = Params::new(m_cost, t_cost, p_cost, None).unwrap();
+            let mut expected = [0u8; 64];
+            Argon2::new(Algorithm::Argon2id, Version::V0x13, params.clone())
+                .hash_password_into(password, &salt, &mut expected)
+                .unwrap();
+            for threads in 1..=p_cost as usize {
+                let mut output = [0u8; 64];
+                hash_password_into(&params, threads, password, &salt, &mut output);
+                assert_eq!(output, expected, "{:?} on {} threads", params, threads);
+            }
+        }
+    }
+}
@@ -0,0 +1,109 @@
+//! The random number generator of the protocol functions.
+//!
+//! By default every draw reads from the OS with a `getrandom` syscall, and
+//! starting a login or registration takes several draws. With the
+//! `chacha-rng` feature the draws come from a ChaCha20 generator per thread
+//! instead, which is seeded from the OS and buffers its output.
+//!
+//! Like `rand::thread_rng` (which uses ChaCha12) the generator reseeds from
+//! the OS after every 64 KiB of output and on first use after a `fork`, so
+//! a forked child never repeats the output of its parent.
+
+#[cfg(not(feature = "chacha-rng"))]
+pub use opaque_ke::rand::rngs::OsRng as ProtocolRng;
+
+#[cfg(feature = "chacha-rng")]
+pub use thread_chacha::ThreadChaChaRng as ProtocolRng;
+
+#[cfg(feature = "chacha-rng")]
+pub use thread_chacha::ThreadChaChaRng;
+
+/// The generator selected at build time, see the module docs.
+pub fn protocol_rng() -> ProtocolRng {
+    ProtocolRng::default()
+}
+
+#[cfg(feature = "chacha-rng")]
+mod thread_chacha {
+    use std::cell::RefCell;
+    use std::marker::PhantomData;
+
+    use rand::rngs::adapter::ReseedingRng;
+    use rand::rngs::OsRng;
+    use rand::{CryptoRng, Error, RngCore, SeedableRng};
+    use rand_chacha::ChaCha20Core;
+
+    /// Bytes of output after which the generator reseeds from the OS.
+    const RESEED_THRESHOLD: u64 = 64 * 1024;
+
+    thread_local! {
+        static THREAD_RNG: RefCell<ReseedingRng<ChaCha20Core, OsRng>> = {
+            let core = ChaCha20Core::from_rng(OsRng)
+                .unwrap_or_else(|error| panic!("could not seed the ChaCha20 RNG: {}", error));
+            RefCell::new(ReseedingRng::new(core, RESEED_THRESHOLD, OsRng))
+        };
+    }
+
+    /// Handle to the ChaCha20 generator of the current thread. It can't be
+    /// sent to other threads, each thread gets a generator of its own.
+    #[derive(Clone, Copy, Debug, Default)]
+    pub struct ThreadChaChaRng {
+        not_send: PhantomData<*const ()>,
+    }
+
+    fn with_rng<T>(f: impl FnOnce(&mut ReseedingRng<ChaCha20Core, OsRng>) -> T) -> T {
+        THREAD_RNG.with(|rng| f(&mut rng.borrow_mut()))
+    }
+
+    impl RngCore for ThreadChaChaRng {
+        fn next_u32(&mut self) -> u32 {
+            with_rng(|rng| rng.next_u32())
+        }
+
+        fn next_u64(&mut self) -> u64 {
+            with_rng(|rng| rng.next_u64())
+        }
+
+        fn fill_bytes(&mut self, dest: &mut [u8]) {
+            with_rng(|rng| rng.fill_bytes(dest))
+        }
+
+        fn try_fill_bytes(&mut self, dest: &mut [u8]) -> Result<(), Error> {
+            with_rng(|rng| rng.try_fill_bytes(dest))
+        }
+    }
+
+    impl CryptoRng for ThreadChaChaRng {}
+
+    #[cfg(test)]
+    mod tests {
+        use super::*;
+
+        fn draw() -> [u8; 32] {
+            let mut bytes = [0; 32];
+            ThreadChaChaRng::default().fill_bytes(&mut bytes);
+            bytes
+        }
+
+        #[test]
+        fn threads_have_their_own_generator() {
+            let main = draw();
+            let other = std::thread::spawn(draw).join().unwrap();
+            assert_ne!(main, other);
+            assert_ne!(main, draw());
+        }
+
+        #[test]
+        fn keeps_generating_past_the_reseed_threshold() {
+            let mut rng = ThreadChaChaRng::default();
+            let mut previous = [0; 1024];
+            rng.fill_bytes(&mut previous);
+            for _ in 0..2 * RESEED_THRESHOLD / 1024 {
+                let mut bytes = [0; 1024];
+                rng.fill_bytes(&mut bytes);
+                assert_ne!(bytes, previous);
+                previous = bytes;
+            }
+        }
+    }
+}
@@ -0,0 +1,217 @@
+//! In-process store of the server login states between `startServerLogin`
+//! and `finishServerLogin`. Instead of the serialized state, JS only gets a
+//! short random handle for the session, and finishing the login consumes
+//! it, so a finish request can't be replayed.
+//!
+//! The store is split into shards with a lock each, concurrent logins only
+//! contend if their handles fall into the same shard.
+
+use std::collections::{HashMap, VecDeque};
+use std::mem::size_of;
+use std::sync::{Mutex, MutexGuard, PoisonError};
+use std::time::{Duration, Instant};
+
+use opaque_ke::rand::RngCore;
+
+use crate::{rng, Error, OpaqueResult};
+
+pub type SessionHandle = [u8; 16];
+
+const SHARDS: usize = 16;
+
+struct Session<T> {
+    state: T,
+    expires_at: Instant,
+}
+
+struct Shard<T> {
+    sessions: HashMap<SessionHandle, Session<T>>,
+    /// Handles in the order they expire, which is the order they were
+    /// inserted since all sessions have the same TTL. Finished sessions
+    /// stay in here until they would have expired.
+    expiry: VecDeque<(Instant, SessionHandle)>,
+}
+
+impl<T> Shard<T> {
+    fn evict_expired(&mut self, now: Instant) {
+        while let Some(&(expires_at, handle)) = self.expiry.front() {
+            if expires_at > now {
+                break;
+            }
+            self.expiry.pop_front();
+            self.sessions.remove(&handle);
+        }
+    }
+
+    /// Drops the entries of finished sessions from the expiry queue once
+    /// they outnumber the pending ones, so a high rate of logins doesn't
+    /// grow the queue beyond the capacity of the shard.
+    fn compact(&mut self, capacity: usize) {
+        if self.expiry.len() > 2 * capacity {
+            let sessions = &self.sessions;
+            self.expiry
+                .retain(|(_, handle)| sessions.contains_key(handle));
+        }
+    }
+}
+
+/// Approximate memory used per session: the map entry and its entry in the
+/// expiry queue, not counting the spare capacity of either.
+pub const fn session_size<T>() -> usize {
+    size_of::<(SessionHandle, Session<T>)>() + size_of::<(Instant, SessionHandle)>()
+}
+
+pub struct SessionStore<T> {
+    shards: Box<[Mutex<Shard<T>>]>,
+    ttl: Duration,
+    shard_capacity: usize,
+}
+
+impl<T> SessionStore<T> {
+    pub fn new(ttl: Duration, max_memory_bytes: usize) -> OpaqueResult<Self> {
+        if ttl.is_zero() {
+            return Err(Error::Input {
+                message: "the TTL of the login sessions must be positive".to_string(),
+            });
+        }
+        let shard_capacity = max_memory_bytes / session_size::<T>() / SHARDS;
+        if shard_capacity == 0 {
+            return Err(Error::Input {
+                message: format!(
+                    "the memory limit of the login sessions must be at least {} bytes",
+                    session_size::<T>() * SHARDS
+                ),
+            });
+        }
+        let shards = (0..SHARDS)
+            .map(|_| {
+                Mutex::new(Shard {
+                    sessions: HashMap::new(),
+                    expiry: VecDeque::new(),
+                })
+            })
+            .collect();
+        Ok(SessionStore {
+            shards,
+            ttl,
+            shard_capacity,
+        })
+    }
+
+    fn shard(&self, handle: &SessionHandle) -> MutexGuard<'_, Shard<T>> {
+        // the handles are random, any byte spreads them evenly
+        self.shards[handle[0] as usize % SHARDS]
+            .lock()
+            .unwrap_or_else(PoisonError::into_inner)
+    }
+
+    /// Stores the state and returns the handle of the new session. Fails if
+    /// the shard of the handle is full.
+    pub fn insert(&self, state: T) -> OpaqueResult<SessionHandle> {
+        let mut handle = SessionHandle::default();
+        rng::protocol_rng().fill_bytes(&mut handle);
+        let now = Instant::now();
+        let expires_at = now + self.ttl;
+        let mut shard = self.shard(&handle);
+        shard.evict_expired(now);
+        if shard.sessions.len() >= self.shard_capacity {
+            return Err(Error::Input {
+                message: "too many pending logins, the login session store is full".to_string(),
+            });
+        }
+        shard.sessions.insert(handle, Session { state, expires_at });
+        shard.expiry.push_back((expires_at, handle));
+        shard.compact(self.shard_capacity);
+        Ok(handle)
+    }
+
+    /// Removes the session and returns its state. Every session can only be
+    /// taken once.
+    pub fn take(&self, handle: &SessionHandle) -> OpaqueResult<T> {
+        let session = self.shard(handle).sessions.remove(handle);
+        match session {
+            Some(session) if session.expires_at > Instant::now() => Ok(session.state),
+            _ => Err(Error::Input {
+                message: "unknown login session, it expired or was already finished".to_string(),
+            }),
+        }
+    }
+
+    /// Number of pending sessions, including expired ones that weren't
+    /// evicted yet.
+    pub fn session_count(&self) -> usize {
+        self.shards
+            .iter()
+            .map(|shard| {
+                shard
+                    .lock()
+                    .unwrap_or_else(PoisonError::into_inner)
+                    .sessions
+                    .len()
+            })
+            .sum()
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn store(ttl: Duration, max_sessions: usize) -> SessionStore<u64> {
+        SessionStore::new(ttl, max_sessions * session_size::<u64>()).unwrap()
+    }
+
+    #[test]
+    fn sessions_can_only_be_taken_once() {
+        let store = store(Duration::from_secs(60), 1024);
+        let first = store.insert(1).unwrap();
+        let second = store.insert(2).unwrap();
+        assert_ne!(first, second);
+        assert_eq!(store.session_count(), 2);
+        assert_eq!(store.take(&second).unwrap(), 2);
+        assert!(store.take(&second).is_err());
+        assert_eq!(store.take(&first).unwrap(), 1);
+        assert_eq!(store.session_count(), 0);
+        assert!(store.take(&SessionHandle::default()).is_err());
+    }
+
+    #[test]
+    fn expired_sessions_are_rejected_and_evicted() {
+        let store = store(Duration::from_millis(10), 1024);
+        let handle = store.insert(1).unwrap();
+        std::thread::sleep(Duration::from_millis(20));
+        assert!(store.take(&handle).is_err());
+
+        let expired = (0..64).map(|i| store.insert(i).unwrap()).count();
+        std::thread::sleep(Duration::from_millis(20));
+        // every insert evicts the expired sessions of its shard
+        for _ in 0..SHARDS * 8 {
+            store.insert(0).unwrap();
+        }
+        assert!(store.session_count() < expired + SHARDS * 8);
+    }
+
+    #[test]
+    fn rejects_sessions_beyond_the_memory_limit() {
+        let store = store(Duration::from_secs(60), SHARDS * 4);
+        let inserted = (0..SHARDS * 8)
+            .filter(|&i| store.insert(i as u64).is_ok())
+            .count();
+        assert!(inserted <= SHARDS * 4);
+        assert_eq!(store.session_count(), inserted);
+        assert!(SessionStore::<u64>::new(Duration::from_secs(60), 0).is_err());
+        assert!(SessionStore::<u64>::new(Duration::ZERO, 1 << 20).is_err());
+    }
+
+    #[test]
+    fn finished_sessions_dont_grow_the_expiry_queue() {
+        let store = store(Duration::from_secs(60), SHARDS * 4);
+        for i in 0..10_000 {
+            let handle = store.insert(i).unwrap();
+            store.take(&handle).unwrap();
+        }
+        for shard in store.shards.iter() {
+            assert!(shard.lock().unwrap().expiry.len() <= 2 * store.shard_capacity + 1);
+        }
+    }
+}
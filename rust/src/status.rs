@@ -0,0 +1,338 @@
+//! The `opaque_try_*` variants of the login functions for the result mode
+//! of the JSI module. Failed logins are common (wrong passwords, credential
+//! stuffing), so they return their error as an `OpaqueStatus` instead of a
+//! `Result`, which cxx would turn into a C++ exception. The error message
+//! is written into the output buffer, so reporting it doesn't allocate
+//! either.
+//!
+//! The other functions throw, the code of their error is part of the
+//! message of the exception, see `impl Display for Error`.
+
+use std::fmt::{self, Write};
+
+use crate::opaque_ffi::{
+    OpaqueCipherSuite, OpaqueErrorCode, OpaqueFinishClientLoginBinaryResult,
+    OpaqueFinishClientLoginInput, OpaqueFinishClientLoginOutput,
+    OpaqueFinishServerLoginBinaryResult, OpaqueFinishServerLoginInput,
+    OpaqueFinishServerLoginResult, OpaqueKeyStretchingParams, OpaqueStartServerLoginBinaryResult,
+    OpaqueStartServerLoginInput, OpaqueStartServerLoginOutput, OpaqueStartServerLoginParams,
+    OpaqueStartServerLoginSessionResult, OpaqueStatus,
+};
+use crate::{
+    finish_client_login_binary, opaque_finish_client_login_context,
+    opaque_finish_client_login_into, opaque_finish_server_login_binary,
+    opaque_finish_server_login_into, opaque_finish_server_login_session,
+    opaque_start_server_login_binary, opaque_start_server_login_into,
+    opaque_start_server_login_session, opaque_start_server_login_with_setup_binary,
+    opaque_start_server_login_with_setup_into, ClientLoginContext, OpaqueResult,
+    ServerLoginSessionStore, ServerSetupHandle,
+};
+
+/// Writes as much of the message as fits into the buffer, cut at a char
+/// boundary.
+struct MessageWriter<'b> {
+    out: &'b mut [u8],
+    len: usize,
+}
+
+impl Write for MessageWriter<'_> {
+    fn write_str(&mut self, s: &str) -> fmt::Result {
+        let mut len = s.len().min(self.out.len() - self.len);
+        while !s.is_char_boundary(len) {
+            len -= 1;
+        }
+        self.out[self.len..self.len + len].copy_from_slice(&s.as_bytes()[..len]);
+        self.len += len;
+        Ok(())
+    }
+}
+
+/// Stores the value of a successful call in `output`, or writes the error
+/// message to `out`.
+fn report<T>(result: OpaqueResult<T>, out: &mut [u8], output: &mut T) -> OpaqueStatus {
+    match result {
+        Ok(value) => {
+            *output = value;
+            OpaqueStatus {
+                code: OpaqueErrorCode::None,
+                message: 0,
+            }
+        }
+        Err(error) => {
+            let mut writer = MessageWriter { out, len: 0 };
+            // the writer truncates instead of failing
+            let _ = write!(writer, "{}", error.message());
+            OpaqueStatus {
+                code: error.code(),
+                message: writer.len,
+            }
+        }
+    }
+}
+
+pub fn opaque_try_finish_client_login_into(
+    input: OpaqueFinishClientLoginInput,
+    out: &mut [u8],
+    output: &mut OpaqueFinishClientLoginOutput,
+) -> OpaqueStatus {
+    let result = opaque_finish_client_login_into(input, out);
+    report(result, out, output)
+}
+
+pub fn opaque_try_finish_client_login_context(
+    context: &ClientLoginContext,
+    login_response: &str,
+    out: &mut [u8],
+    output: &mut OpaqueFinishClientLoginOutput,
+) -> OpaqueStatus {
+    let result = opaque_finish_client_login_context(context, login_response, out);
+    report(result, out, output)
+}
+
+pub fn opaque_try_start_server_login_into(
+    server_setup: &str,
+    input: OpaqueStartServerLoginInput,
+    out: &mut [u8],
+    output: &mut OpaqueStartServerLoginOutput,
+) -> OpaqueStatus {
+    let result = opaque_start_server_login_into(server_setup, input, out);
+    report(result, out, output)
+}
+
+pub fn opaque_try_start_server_login_with_setup_into(
+    server_setup: &ServerSetupHandle,
+    input: OpaqueStartServerLoginInput,
+    out: &mut [u8],
+    output: &mut OpaqueStartServerLoginOutput,
+) -> OpaqueStatus {
+    let result = opaque_start_server_login_with_setup_into(server_setup, input, out);
+    report(result, out, output)
+}
+
+pub fn opaque_try_finish_server_login_into(
+    input: OpaqueFinishServerLoginInput,
+    out: &mut [u8],
+    session_key: &mut usize,
+) -> OpaqueStatus {
+    let result = opaque_finish_server_login_into(input, out);
+    report(result, out, session_key)
+}
+
+pub fn opaque_try_start_server_login_session(
+    store: &ServerLoginSessionStore,
+    server_setup: &ServerSetupHandle,
+    params: OpaqueStartServerLoginParams,
+    out: &mut [u8],
+    result: &mut OpaqueStartServerLoginSessionResult,
+) -> OpaqueStatus {
+    report(
+        opaque_start_server_login_session(store, server_setup, params),
+        out,
+        result,
+    )
+}
+
+pub fn opaque_try_finish_server_login_session(
+    store: &ServerLoginSessionStore,
+    session_handle: &str,
+    finish_login_request: &str,
+    out: &mut [u8],
+    result: &mut OpaqueFinishServerLoginResult,
+) -> OpaqueStatus {
+    report(
+        opaque_finish_server_login_session(store, session_handle, finish_login_request),
+        out,
+        result,
+    )
+}
+
+#[allow(clippy::too_many_arguments)]
+pub fn opaque_try_start_server_login_binary(
+    server_setup: &[u8],
+    registration_record: &[u8],
+    has_registration_record: bool,
+    start_login_request: &[u8],
+    user_identifier: &str,
+    client_identifier: Vec<String>,
+    server_identifier: Vec<String>,
+    suite: OpaqueCipherSuite,
+    out: &mut [u8],
+    result: &mut OpaqueStartServerLoginBinaryResult,
+) -> OpaqueStatus {
+    report(
+        opaque_start_server_login_binary(
+            server_setup,
+            registration_record,
+            has_registration_record,
+            start_login_request,
+            user_identifier,
+            client_identifier,
+            server_identifier,
+            suite,
+        ),
+        out,
+        result,
+    )
+}
+
+#[allow(clippy::too_many_arguments)]
+pub fn opaque_try_start_server_login_with_setup_binary(
+    server_setup: &ServerSetupHandle,
+    registration_record: &[u8],
+    has_registration_record: bool,
+    start_login_request: &[u8],
+    user_identifier: &str,
+    client_identifier: Vec<String>,
+    server_identifier: Vec<String>,
+    out: &mut [u8],
+    result: &mut OpaqueStartServerLoginBinaryResult,
+) -> OpaqueStatus {
+    report(
+        opaque_start_server_login_with_setup_binary(
+            server_setup,
+            registration_record,
+            has_registration_record,
+            start_login_request,
+            user_identifier,
+            client_identifier,
+            server_identifier,
+        ),
+        out,
+        result,
+    )
+}
+
+pub fn opaque_try_finish_server_login_binary(
+    server_login_state: &[u8],
+    finish_login_request: &[u8],
+    suite: OpaqueCipherSuite,
+    out: &mut [u8],
+    result: &mut OpaqueFinishServerLoginBinaryResult,
+) -> OpaqueStatus {
+    report(
+        opaque_finish_server_login_binary(server_login_state, finish_login_request, suite),
+        out,
+        result,
+    )
+}
+
+#[allow(clippy::too_many_arguments)]
+pub fn opaque_try_finish_client_login_binary(
+    client_login_state: &[u8],
+    login_response: &[u8],
+    password: &str,
+    client_identifier: Vec<String>,
+    server_identifier: Vec<String>,
+    key_stretching: Vec<OpaqueKeyStretchingParams>,
+    suite: OpaqueCipherSuite,
+    out: &mut [u8],
+    result: &mut OpaqueFinishClientLoginBinaryResult,
+) -> OpaqueStatus {
+    let mut finished = None;
+    let status = report(
+        finish_client_login_binary(
+            client_login_state,
+            login_response,
+            password,
+            client_identifier,
+            server_identifier,
+            key_stretching,
+            suite,
+        ),
+        out,
+        &mut finished,
+    );
+    if let Some(finished) = finished {
+        *result = finished;
+    }
+    status
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::Error;
+    use opaque_ke::errors::ProtocolError;
+
+    #[test]
+    fn codes_match_the_variants() {
+        let input = Error::Input {
+            message: "bad".to_string(),
+        };
+        let protocol = Error::Protocol {
+            context: "finish server login",
+            error: ProtocolError::SerializationError,
+        };
+        let invalid_login = Error::Protocol {
+            context: "finish server login",
+            error: ProtocolError::InvalidLoginError,
+        };
+        for (error, code) in [
+            (input, OpaqueErrorCode::Input),
+            (protocol, OpaqueErrorCode::Protocol),
+            (invalid_login, OpaqueErrorCode::InvalidLogin),
+        ] {
+            assert!(error.code() == code);
+            let thrown = error.to_string();
+            assert_eq!(thrown, format!("{}:{}", code.repr, error.message()));
+        }
+    }
+
+    #[test]
+    fn reports_the_error_without_panicking_on_a_small_buffer() {
+        let mut out = [0; 8];
+        let mut output = 0;
+        let status = report::<usize>(
+            Err(Error::Input {
+                message: "ünïcödé message".to_string(),
+            }),
+            &mut out,
+            &mut output,
+        );
+        assert!(status.code == OpaqueErrorCode::Input);
+        assert!(std::str::from_utf8(&out[..status.message]).is_ok());
+        assert_eq!(output, 0);
+
+        let status = report(Ok(42), &mut out, &mut output);
+        assert!(status.code == OpaqueErrorCode::None);
+        assert_eq!(output, 42);
+    }
+
+    #[test]
+    fn reports_invalid_inputs() {
+        let mut out = [0; 2048];
+        let mut session_key = 0;
+        let status = opaque_try_finish_server_login_into(
+            OpaqueFinishServerLoginInput {
+                server_login_state: "AA",
+                finish_login_request: "not base64!",
+                suite: OpaqueCipherSuite::Default,
+            },
+            &mut out,
+            &mut session_key,
+        );
+        assert!(status.code == OpaqueErrorCode::Base64);
+        assert!(status.message > 0);
+        assert_eq!(session_key, 0);
+    }
+
+    #[test]
+    fn reports_invalid_binary_inputs() {
+        let mut out = [0; 2048];
+        let mut result = OpaqueFinishServerLoginBinaryResult {
+            session_key: Vec::new(),
+        };
+        let status = opaque_try_finish_server_login_binary(
+            &[0],
+            &[0],
+            OpaqueCipherSuite::Default,
+            &mut out,
+            &mut result,
+        );
+        assert!(status.code == OpaqueErrorCode::Protocol);
+        assert!(std::str::from_utf8(&out[..status.message])
+            .unwrap()
+            .starts_with("opaque protocol error at"));
+        assert!(result.session_key.is_empty());
+    }
+}
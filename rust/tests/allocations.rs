@@ -0,0 +1,324 @@
+//! Counts the heap allocations of a full login through the `*_into`
+//! functions and compares them with the owned string API, and those of a
+//! failed login reported by an `opaque_try_*` function.
+
+use std::alloc::{GlobalAlloc, Layout, System};
+use std::cell::Cell;
+
+use opaque_rust::opaque_ffi::{
+    OpaqueCipherSuite, OpaqueCreateServerRegistrationResponseInput, OpaqueErrorCode,
+    OpaqueFinishClientLoginInput, OpaqueFinishClientLoginOutput, OpaqueFinishClientLoginParams,
+    OpaqueFinishClientRegistrationInput, OpaqueFinishServerLoginInput,
+    OpaqueFinishServerLoginParams, OpaqueKeyStretchingParams, OpaqueStartClientLoginParams,
+    OpaqueStartServerLoginInput, OpaqueStartServerLoginParams,
+};
+use opaque_rust::*;
+
+/// Counts the allocations of the current thread, the test harness runs
+/// other tests on threads of their own.
+struct CountingAllocator;
+
+thread_local! {
+    static ALLOCATIONS: Cell<usize> = const { Cell::new(0) };
+}
+
+unsafe impl GlobalAlloc for CountingAllocator {
+    unsafe fn alloc(&self, layout: Layout) -> *mut u8 {
+        // try_with fails while the thread local is being destroyed
+        let _ = ALLOCATIONS.try_with(|count| count.set(count.get() + 1));
+        System.alloc(layout)
+    }
+
+    unsafe fn dealloc(&self, ptr: *mut u8, layout: Layout) {
+        System.dealloc(ptr, layout)
+    }
+}
+
+#[global_allocator]
+static ALLOCATOR: CountingAllocator = CountingAllocator;
+
+fn count_allocations(f: impl FnOnce()) -> usize {
+    let before = ALLOCATIONS.with(Cell::get);
+    f();
+    ALLOCATIONS.with(Cell::get) - before
+}
+
+// A single lane, the parallel Argon2 allocates on other threads.
+const KEY_STRETCHING: OpaqueKeyStretchingParams = OpaqueKeyStretchingParams {
+    memory_cost: 8,
+    iterations: 1,
+    parallelism: 1,
+};
+
+const USER_IDENTIFIER: &str = "user@example.com";
+const PASSWORD: &str = "hunter42";
+
+fn field(out: &[u8], offset: &mut usize, len: usize) -> String {
+    let field = std::str::from_utf8(&out[*offset..*offset + len]).unwrap();
+    *offset += len;
+    field.to_string()
+}
+
+fn register(server_setup: &str) -> String {
+    let mut out = [0; 2048];
+    let start =
+        opaque_start_client_registration_into(PASSWORD, OpaqueCipherSuite::Default, &mut out)
+            .unwrap();
+    let mut offset = 0;
+    let state = field(&out, &mut offset, start.client_registration_state);
+    let request = field(&out, &mut offset, start.registration_request);
+
+    let len = opaque_create_server_registration_response_into(
+        server_setup,
+        OpaqueCreateServerRegistrationResponseInput {
+            user_identifier: USER_IDENTIFIER,
+            registration_request: &request,
+            suite: OpaqueCipherSuite::Default,
+        },
+        &mut out,
+    )
+    .unwrap();
+    let response = field(&out, &mut 0, len);
+
+    let finish = opaque_finish_client_registration_into(
+        OpaqueFinishClientRegistrationInput {
+            password: PASSWORD,
+            registration_response: &response,
+            client_registration_state: &state,
+            client_identifier: "",
+            has_client_identifier: false,
+            server_identifier: "",
+            has_server_identifier: false,
+            key_stretching: KEY_STRETCHING,
+            has_key_stretching: true,
+            suite: OpaqueCipherSuite::Default,
+        },
+        &mut out,
+    )
+    .unwrap();
+    field(&out, &mut 0, finish.registration_record)
+}
+
+/// Runs a login with the `*_into` functions and returns the number of
+/// allocations it made.
+fn login_into(server_setup: &ServerSetupHandle, registration_record: &str) -> usize {
+    // Inputs and outputs live on the stack, which the messages are copied
+    // between as the app would send them over the network.
+    let mut client_out = [0; 2048];
+    let mut server_out = [0; 2048];
+    let mut session_key = [0; 128];
+    let mut success = false;
+    let count = count_allocations(|| {
+        let start =
+            opaque_start_client_login_into(PASSWORD, OpaqueCipherSuite::Default, &mut client_out)
+                .unwrap();
+        let (client_state, request) = client_out.split_at(start.client_login_state);
+        let client_state = std::str::from_utf8(client_state).unwrap();
+        let request = std::str::from_utf8(&request[..start.start_login_request]).unwrap();
+
+        let server_start = opaque_start_server_login_with_setup_into(
+            server_setup,
+            OpaqueStartServerLoginInput {
+                registration_record,
+                has_registration_record: true,
+                start_login_request: request,
+                user_identifier: USER_IDENTIFIER,
+                client_identifier: "",
+                has_client_identifier: false,
+                server_identifier: "",
+                has_server_identifier: false,
+                suite: OpaqueCipherSuite::Default,
+            },
+            &mut server_out,
+        )
+        .unwrap();
+        let (server_state, response) = server_out.split_at(server_start.server_login_state);
+        let server_state = std::str::from_utf8(server_state).unwrap();
+        let response = std::str::from_utf8(&response[..server_start.login_response]).unwrap();
+
+        let mut finish_out = [0; 2048];
+        let finish = opaque_finish_client_login_into(
+            OpaqueFinishClientLoginInput {
+                client_login_state: client_state,
+                login_response: response,
+                password: PASSWORD,
+                client_identifier: "",
+                has_client_identifier: false,
+                server_identifier: "",
+                has_server_identifier: false,
+                key_stretching: KEY_STRETCHING,
+                has_key_stretching: true,
+                suite: OpaqueCipherSuite::Default,
+            },
+            &mut finish_out,
+        )
+        .unwrap();
+        success = finish.success;
+        let finish_request =
+            std::str::from_utf8(&finish_out[..finish.finish_login_request]).unwrap();
+
+        opaque_finish_server_login_into(
+            OpaqueFinishServerLoginInput {
+                server_login_state: server_state,
+                finish_login_request: finish_request,
+                suite: OpaqueCipherSuite::Default,
+            },
+            &mut session_key,
+        )
+        .unwrap();
+    });
+    assert!(success);
+    count
+}
+
+/// Same login with the owned string API.
+fn login_owned(server_setup: &ServerSetupHandle, registration_record: &str) -> usize {
+    let mut success = false;
+    let count = count_allocations(|| {
+        let start = opaque_start_client_login(OpaqueStartClientLoginParams {
+            password: PASSWORD.to_string(),
+            suite: OpaqueCipherSuite::Default,
+        })
+        .unwrap();
+        let server_start = opaque_start_server_login_with_setup(
+            server_setup,
+            OpaqueStartServerLoginParams {
+                registration_record: vec![registration_record.to_string()],
+                start_login_request: start.start_login_request,
+                user_identifier: USER_IDENTIFIER.to_string(),
+                client_identifier: vec![],
+                server_identifier: vec![],
+                suite: OpaqueCipherSuite::Default,
+            },
+        )
+        .unwrap();
+        let finish = opaque_finish_client_login(OpaqueFinishClientLoginParams {
+            client_login_state: start.client_login_state,
+            login_response: server_start.login_response,
+            password: PASSWORD.to_string(),
+            client_identifier: vec![],
+            server_identifier: vec![],
+            key_stretching: vec![KEY_STRETCHING],
+            suite: OpaqueCipherSuite::Default,
+        })
+        .unwrap();
+        success = !finish.is_null();
+        if let Some(finish) = finish.as_ref() {
+            opaque_finish_server_login(OpaqueFinishServerLoginParams {
+                server_login_state: server_start.server_login_state,
+                finish_login_request: finish.finish_login_request.clone(),
+                suite: OpaqueCipherSuite::Default,
+            })
+            .unwrap();
+        }
+    });
+    assert!(success);
+    count
+}
+
+#[test]
+fn login_into_makes_a_fixed_number_of_allocations() {
+    let server_setup = opaque_create_server_setup(OpaqueCipherSuite::Default).unwrap();
+    let handle =
+        opaque_create_server_setup_handle(server_setup.clone(), OpaqueCipherSuite::Default)
+            .unwrap();
+    let registration_record = register(&server_setup);
+
+    // the first login initializes the CPU topology and the RNG
+    login_into(&handle, &registration_record);
+    let allocations = login_into(&handle, &registration_record);
+    for _ in 0..3 {
+        assert_eq!(login_into(&handle, &registration_record), allocations);
+    }
+
+    let owned = login_owned(&handle, &registration_record);
+    assert!(
+        allocations < owned,
+        "{} allocations with the `*_into` functions, {} with the owned API",
+        allocations,
+        owned
+    );
+}
+
+/// Runs a login up to the server's finish and returns the server login
+/// state and the finish request of the client.
+fn start_login(server_setup: &ServerSetupHandle, registration_record: &str) -> (String, String) {
+    let start = opaque_start_client_login(OpaqueStartClientLoginParams {
+        password: PASSWORD.to_string(),
+        suite: OpaqueCipherSuite::Default,
+    })
+    .unwrap();
+    let server_start = opaque_start_server_login_with_setup(
+        server_setup,
+        OpaqueStartServerLoginParams {
+            registration_record: vec![registration_record.to_string()],
+            start_login_request: start.start_login_request,
+            user_identifier: USER_IDENTIFIER.to_string(),
+            client_identifier: vec![],
+            server_identifier: vec![],
+            suite: OpaqueCipherSuite::Default,
+        },
+    )
+    .unwrap();
+    let mut out = [0; 2048];
+    let mut finish = OpaqueFinishClientLoginOutput {
+        success: false,
+        finish_login_request: 0,
+        session_key: 0,
+        export_key: 0,
+        server_static_public_key: 0,
+    };
+    let status = opaque_try_finish_client_login_into(
+        OpaqueFinishClientLoginInput {
+            client_login_state: &start.client_login_state,
+            login_response: &server_start.login_response,
+            password: PASSWORD,
+            client_identifier: "",
+            has_client_identifier: false,
+            server_identifier: "",
+            has_server_identifier: false,
+            key_stretching: KEY_STRETCHING,
+            has_key_stretching: true,
+            suite: OpaqueCipherSuite::Default,
+        },
+        &mut out,
+        &mut finish,
+    );
+    assert!(status.code == OpaqueErrorCode::None && finish.success);
+    (
+        server_start.server_login_state,
+        field(&out, &mut 0, finish.finish_login_request),
+    )
+}
+
+#[test]
+fn failed_login_status_does_not_allocate() {
+    let server_setup = opaque_create_server_setup(OpaqueCipherSuite::Default).unwrap();
+    let handle =
+        opaque_create_server_setup_handle(server_setup.clone(), OpaqueCipherSuite::Default)
+            .unwrap();
+    let registration_record = register(&server_setup);
+    // the finish request of another login fails like a wrong password
+    let (server_state, _) = start_login(&handle, &registration_record);
+    let (_, finish_request) = start_login(&handle, &registration_record);
+
+    let mut out = [0; 2048];
+    let mut session_key = 0;
+    let mut finish = || {
+        opaque_try_finish_server_login_into(
+            OpaqueFinishServerLoginInput {
+                server_login_state: &server_state,
+                finish_login_request: &finish_request,
+                suite: OpaqueCipherSuite::Default,
+            },
+            &mut out,
+            &mut session_key,
+        )
+    };
+    let mut status = finish();
+    assert!(status.code == OpaqueErrorCode::InvalidLogin);
+    assert_eq!(count_allocations(|| status = finish()), 0);
+    assert!(status.code == OpaqueErrorCode::InvalidLogin);
+    let message = std::str::from_utf8(&out[..status.message]).unwrap();
+    assert!(message.starts_with("opaque protocol error at \"finish server login\""));
+}
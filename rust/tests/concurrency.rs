@@ -0,0 +1,243 @@
+//! Stress test for the concurrent use of the module from several runtimes,
+//! which share the native state: logins of many users run on threads of
+//! their own while another thread keeps reconfiguring the metrics and the
+//! key stretching memory.
+
+use std::sync::atomic::{AtomicBool, Ordering};
+use std::sync::Barrier;
+use std::thread;
+
+use opaque_rust::opaque_ffi::{
+    OpaqueCipherSuite, OpaqueCreateServerRegistrationResponseParams, OpaqueErrorCode,
+    OpaqueFinishClientLoginParams, OpaqueFinishClientRegistrationParams,
+    OpaqueFinishServerLoginParams, OpaqueKeyStretchingParams, OpaqueStartClientLoginParams,
+    OpaqueStartClientRegistrationParams, OpaqueStartServerLoginParams,
+};
+use opaque_rust::*;
+
+const KEY_STRETCHING: OpaqueKeyStretchingParams = OpaqueKeyStretchingParams {
+    memory_cost: 8,
+    iterations: 1,
+    parallelism: 1,
+};
+
+const THREADS: usize = 8;
+const LOGINS_PER_THREAD: usize = 20;
+const PASSWORD: &str = "hunter42";
+
+fn register(server_setup: &ServerSetupHandle, user_identifier: &str) -> String {
+    let start = opaque_start_client_registration(OpaqueStartClientRegistrationParams {
+        password: PASSWORD.to_string(),
+        suite: OpaqueCipherSuite::Default,
+    })
+    .unwrap();
+    let response = opaque_create_server_registration_response_with_setup(
+        server_setup,
+        OpaqueCreateServerRegistrationResponseParams {
+            user_identifier: user_identifier.to_string(),
+            registration_request: start.registration_request,
+            suite: OpaqueCipherSuite::Default,
+        },
+    )
+    .unwrap();
+    opaque_finish_client_registration(OpaqueFinishClientRegistrationParams {
+        password: PASSWORD.to_string(),
+        registration_response: response.registration_response,
+        client_registration_state: start.client_registration_state,
+        client_identifier: vec![],
+        server_identifier: vec![],
+        key_stretching: vec![KEY_STRETCHING],
+        suite: OpaqueCipherSuite::Default,
+    })
+    .unwrap()
+    .registration_record
+}
+
+fn start_params(
+    user_identifier: &str,
+    registration_record: &str,
+    start_login_request: String,
+) -> OpaqueStartServerLoginParams {
+    OpaqueStartServerLoginParams {
+        registration_record: vec![registration_record.to_string()],
+        start_login_request,
+        user_identifier: user_identifier.to_string(),
+        client_identifier: vec![],
+        server_identifier: vec![],
+        suite: OpaqueCipherSuite::Default,
+    }
+}
+
+/// Finishes the client side of a login and returns the finish request and
+/// the session key.
+fn finish_client(
+    client_login_state: String,
+    login_response: String,
+    password: &str,
+) -> Option<(String, String)> {
+    let result = opaque_finish_client_login(OpaqueFinishClientLoginParams {
+        client_login_state,
+        login_response,
+        password: password.to_string(),
+        client_identifier: vec![],
+        server_identifier: vec![],
+        key_stretching: vec![KEY_STRETCHING],
+        suite: OpaqueCipherSuite::Default,
+    })
+    .unwrap();
+    result.as_ref().map(|result| {
+        (
+            result.finish_login_request.clone(),
+            result.session_key.clone(),
+        )
+    })
+}
+
+/// A login through the shared session store, a login with a wrong
+/// password, a batch and a finish with mismatched messages.
+fn login_round(
+    server_setup: &ServerSetupHandle,
+    sessions: &ServerLoginSessionStore,
+    user_identifier: &str,
+    registration_record: &str,
+) {
+    let client = opaque_start_client_login(OpaqueStartClientLoginParams {
+        password: PASSWORD.to_string(),
+        suite: OpaqueCipherSuite::Default,
+    })
+    .unwrap();
+    let server = opaque_start_server_login_session(
+        sessions,
+        server_setup,
+        start_params(
+            user_identifier,
+            registration_record,
+            client.start_login_request,
+        ),
+    )
+    .unwrap();
+    let (finish_request, session_key) =
+        finish_client(client.client_login_state, server.login_response, PASSWORD)
+            .expect("login failed");
+    let server_finish =
+        opaque_finish_server_login_session(sessions, &server.session_handle, &finish_request)
+            .unwrap();
+    assert_eq!(server_finish.session_key, session_key);
+
+    // a wrong password must fail even while the record is cached
+    let client = opaque_start_client_login(OpaqueStartClientLoginParams {
+        password: "wrong".to_string(),
+        suite: OpaqueCipherSuite::Default,
+    })
+    .unwrap();
+    let server = opaque_start_server_login_with_setup(
+        server_setup,
+        start_params(
+            user_identifier,
+            registration_record,
+            client.start_login_request.clone(),
+        ),
+    )
+    .unwrap();
+    assert!(finish_client(client.client_login_state, server.login_response, "wrong").is_none());
+
+    let batch = opaque_start_server_login_batch(
+        server_setup,
+        (0..4)
+            .map(|_| {
+                start_params(
+                    user_identifier,
+                    registration_record,
+                    client.start_login_request.clone(),
+                )
+            })
+            .collect(),
+    );
+    assert!(batch
+        .iter()
+        .all(|result| result.error_code == OpaqueErrorCode::None));
+
+    // finishing with the state and request of different logins fails, but
+    // must not affect the other threads
+    let server = opaque_start_server_login_with_setup(
+        server_setup,
+        start_params(
+            user_identifier,
+            registration_record,
+            client.start_login_request,
+        ),
+    )
+    .unwrap();
+    let _ = opaque_finish_server_login(OpaqueFinishServerLoginParams {
+        server_login_state: server.server_login_state,
+        finish_login_request: finish_request,
+        suite: OpaqueCipherSuite::Default,
+    });
+}
+
+/// Keeps changing the shared state until `stop` is set.
+fn reconfigure(stop: &AtomicBool) {
+    let mut round = 0usize;
+    while !stop.load(Ordering::Relaxed) {
+        opaque_set_metrics_enabled(round % 2 == 0);
+        opaque_get_metrics();
+        if round % 5 == 0 {
+            opaque_reset_metrics();
+        }
+        match round % 3 {
+            0 => opaque_prewarm_key_stretching(vec![KEY_STRETCHING]).unwrap(),
+            1 => opaque_trim_key_stretching_memory(),
+            _ => opaque_release_key_stretching_memory(),
+        }
+        opaque_get_cpu_topology();
+        round += 1;
+        thread::yield_now();
+    }
+}
+
+#[test]
+fn concurrent_logins_with_shared_state() {
+    let server_setup = opaque_create_server_setup_handle(
+        opaque_create_server_setup(OpaqueCipherSuite::Default).unwrap(),
+        OpaqueCipherSuite::Default,
+    )
+    .unwrap();
+    let sessions = opaque_create_server_login_session_store(60_000, 16 * 1024 * 1024).unwrap();
+    let users: Vec<_> = (0..THREADS)
+        .map(|i| {
+            let user_identifier = format!("user{i}@example.com");
+            let registration_record = register(&server_setup, &user_identifier);
+            (user_identifier, registration_record)
+        })
+        .collect();
+
+    let stop = AtomicBool::new(false);
+    let start = Barrier::new(THREADS + 1);
+    thread::scope(|scope| {
+        let reconfiguring = scope.spawn(|| {
+            start.wait();
+            reconfigure(&stop);
+        });
+        let logins: Vec<_> = users
+            .iter()
+            .map(|(user_identifier, registration_record)| {
+                let (server_setup, sessions, start) = (&server_setup, &sessions, &start);
+                scope.spawn(move || {
+                    start.wait();
+                    for _ in 0..LOGINS_PER_THREAD {
+                        login_round(server_setup, sessions, user_identifier, registration_record);
+                    }
+                })
+            })
+            .collect();
+        for login in logins {
+            login.join().unwrap();
+        }
+        stop.store(true, Ordering::Relaxed);
+        reconfiguring.join().unwrap();
+    });
+
+    assert_eq!(opaque_server_login_session_count(&sessions), 0);
+    opaque_set_metrics_enabled(false);
+    opaque_release_key_stretching_memory();
+}
@@ -16,6 +16,53 @@ export type CustomIdentifiers = {
   server?: string;
 };
 
+/**
+ * Cipher suite of the protocol. Defaults to `ristretto255`, the suite of
+ * `@serenity-kit/opaque`, unless the native module is built with the `p256`
+ * feature. `p256` is only available in native builds with the `p256-suite`
+ * feature of the Rust crate. Client and server must use the same suite, and
+ * registration records only work with the suite they were created with.
+ */
+export type CipherSuite = 'ristretto255' | 'p256';
+
+export type CipherSuiteParams = {
+  suite?: CipherSuite;
+};
+
+/**
+ * Argon2id parameters of the key stretching run by `finishRegistration` and
+ * `finishLogin`. Login must use the same parameters as the registration, so
+ * they have to be stored together with the registration record.
+ */
+export type KeyStretchingParams = {
+  /** memory size in KiB */
+  memoryCost: number;
+  iterations: number;
+  parallelism: number;
+};
+
+/**
+ * Error of a failed call in the result mode, see `Result`. `input` for
+ * invalid params, `base64` and `protocol` for malformed messages and states,
+ * `invalidLogin` for a wrong password or a tampered login message.
+ */
+export type ErrorCode = 'input' | 'protocol' | 'base64' | 'invalidLogin';
+
+/**
+ * Return value of the `try*` functions, which return their error instead of
+ * throwing it. On the native side a failed login is reported without
+ * unwinding either, which keeps rejecting wrong passwords cheap. Only
+ * available on iOS and Android.
+ *
+ * Every native sync function has such a `...Result` twin, but only the
+ * twins of the login functions avoid the unwinding. The twins of the other
+ * functions catch the C++ exception of the failed call, so they only spare
+ * the JS exception.
+ */
+export type Result<T> =
+  | { ok: true; value: T }
+  | { ok: false; error: ErrorCode; message: string };
+
 declare function opaque_startClientRegistration(
   params: client.StartRegistrationParams
 ): client.StartRegistrationResult;
@@ -28,12 +75,116 @@ declare function opaque_startClientLogin(
   params: client.StartLoginParams
 ): client.StartLoginResult;
 
+declare function opaque_startClientLoginPipelined(
+  params: client.StartLoginPipelinedParams
+): client.StartLoginResult;
+
 declare function opaque_finishClientLogin(
   params: client.FinishLoginParams
 ): client.FinishLoginResult | null;
 
+declare function opaque_finishClientLoginResult(
+  params: client.FinishLoginParams
+): Result<client.FinishLoginResult | undefined>;
+
+declare const clientLoginContextBrand: unique symbol;
+
+/** The native part of `client.ClientLoginContext`. */
+type ClientLoginContextHandle = {
+  readonly [clientLoginContextBrand]: true;
+};
+
+type FinishClientLoginContextParams = {
+  context: ClientLoginContextHandle;
+  loginResponse: string;
+};
+
+declare function opaque_startClientLoginContext(
+  params: client.StartLoginContextParams
+): { startLoginRequest: string; context: ClientLoginContextHandle };
+
+declare function opaque_finishClientLoginContext(
+  params: FinishClientLoginContextParams
+): client.FinishLoginResult | undefined;
+
+declare function opaque_finishClientLoginContextResult(
+  params: FinishClientLoginContextParams
+): Result<client.FinishLoginResult | undefined>;
+
+declare function opaque_finishClientLoginContextAsync(
+  params: FinishClientLoginContextParams,
+  jobId: number
+): Promise<client.FinishLoginResult | undefined>;
+
+declare function opaque_calibrateKeyStretching(
+  params: client.CalibrateKeyStretchingParams
+): KeyStretchingParams;
+
+declare function opaque_prewarmKeyStretching(
+  params: client.PrewarmKeyStretchingParams
+): void;
+
+declare function opaque_releaseKeyStretchingMemory(): void;
+
+declare function opaque_getCpuTopology(): client.CpuTopology;
+
+declare function opaque_finishClientRegistrationAsync(
+  finishParams: client.FinishRegistrationParams,
+  jobId: number
+): Promise<client.FinishRegistrationResult>;
+
+declare function opaque_finishClientLoginAsync(
+  params: client.FinishLoginParams,
+  jobId: number
+): Promise<client.FinishLoginResult | undefined>;
+
+declare function opaque_cancelAsync(jobId: number): boolean;
+
+/**
+ * Minimal subset of the AbortSignal interface used to cancel async calls.
+ */
+export type AbortSignalLike = {
+  readonly aborted: boolean;
+  addEventListener(type: 'abort', listener: () => void): void;
+  removeEventListener(type: 'abort', listener: () => void): void;
+};
+
+export type AsyncOptions = {
+  /**
+   * Cancels the call when aborted. A call that is still queued will not be
+   * executed at all. A running call can't be interrupted: it keeps its
+   * worker thread and memory until the native computation completed and
+   * only rejects then, so aborting it saves no work.
+   */
+  signal?: AbortSignalLike;
+};
+
+let nextAsyncJobId = 1;
+
+function runAsync<P, R>(
+  func: (params: P, jobId: number) => Promise<R>,
+  params: P,
+  options?: AsyncOptions
+): Promise<R> {
+  const jobId = nextAsyncJobId++;
+  const signal = options?.signal;
+  if (!signal) {
+    return func(params, jobId);
+  }
+  if (signal.aborted) {
+    return Promise.reject(new Error('opaque job was cancelled'));
+  }
+  const onAbort = () => {
+    opaque_cancelAsync(jobId);
+  };
+  signal.addEventListener('abort', onAbort);
+  return func(params, jobId).finally(() => {
+    signal.removeEventListener('abort', onAbort);
+  });
+}
+
 export namespace client {
-  export type StartRegistrationParams = {
+  export type StartRegistrationParams = CipherSuiteParams & {
     password: string;
   };
 
@@ -42,20 +193,24 @@ export namespace client {
     registrationRequest: string;
   };
 
-  export type FinishRegistrationParams = {
+  export type FinishRegistrationParams = CipherSuiteParams & {
     password: string;
     registrationResponse: string;
     clientRegistrationState: string;
     identifiers?: CustomIdentifiers;
+    /** defaults to the parameters of `Argon2::default()` */
+    keyStretching?: KeyStretchingParams;
   };
 
   export type FinishRegistrationResult = {
     registrationRecord: string;
     exportKey: string;
     serverStaticPublicKey: string;
+    /** the parameters used, required for `finishLogin` */
+    keyStretching: KeyStretchingParams;
   };
 
-  export type StartLoginParams = {
+  export type StartLoginParams = CipherSuiteParams & {
     password: string;
   };
 
@@ -64,11 +219,13 @@ export namespace client {
     startLoginRequest: string;
   };
 
-  export type FinishLoginParams = {
+  export type FinishLoginParams = CipherSuiteParams & {
     clientLoginState: string;
     loginResponse: string;
     password: string;
     identifiers?: CustomIdentifiers;
+    /** must match the parameters used for the registration */
+    keyStretching?: KeyStretchingParams;
   };
 
   export type FinishLoginResult = {
@@ -81,12 +238,177 @@ export namespace client {
   export const startRegistration = opaque_startClientRegistration;
   export const finishRegistration = opaque_finishClientRegistration;
   export const startLogin = opaque_startClientLogin;
+
+  export type StartLoginPipelinedParams = StartLoginParams & {
+    /** the parameters later passed to `finishLogin`, defaults to the defaults */
+    keyStretching?: KeyStretchingParams;
+  };
+
+  /**
+   * Same as `startLogin`, but prepares the key stretching of the following
+   * `finishLogin` (or `finishLoginAsync`) on a native worker thread while
+   * the client waits for the server. Its memory is allocated and faulted in
+   * ahead, and freed again after the key stretching. Invalid `keyStretching`
+   * params throw right away. A preparation still waiting for a thread when
+   * the login is finished is dropped, so it never delays the finish. Only
+   * available on iOS and Android.
+   */
+  export const startLoginPipelined = opaque_startClientLoginPipelined;
   export const finishLogin = opaque_finishClientLogin;
+  /**
+   * Same as `finishLogin` but returns the error instead of throwing it. A
+   * login the client detects as failed is `ok` with an `undefined` value,
+   * like the `undefined` returned by `finishLogin`.
+   */
+  export const tryFinishLogin = opaque_finishClientLoginResult;
+
+  export type StartLoginContextParams = CipherSuiteParams & {
+    password: string;
+    identifiers?: CustomIdentifiers;
+    /** must match the parameters used for the registration */
+    keyStretching?: KeyStretchingParams;
+  };
+
+  /**
+   * A started login, see `startLoginContext`.
+   */
+  export type ClientLoginContext = {
+    startLoginRequest: string;
+    /**
+     * Same as `finishLogin` with the params passed to `startLoginContext`.
+     * A context can only be finished once.
+     */
+    finish(loginResponse: string): FinishLoginResult | undefined;
+    /** Same as `finish` but returns the error, see `tryFinishLogin`. */
+    tryFinish(loginResponse: string): Result<FinishLoginResult | undefined>;
+    /** Same as `finishLoginAsync`, see `finish`. */
+    finishAsync(
+      loginResponse: string,
+      options?: AsyncOptions
+    ): Promise<FinishLoginResult | undefined>;
+  };
+
+  /**
+   * Same as `startLogin`, but keeps the login state together with the
+   * password and the other params of the following `finish` in native memory
+   * instead of returning the serialized state. Neither the password nor the
+   * state have to be passed back in, and the state is zeroized once the login
+   * is finished or the context is garbage collected. Only available on iOS
+   * and Android.
+   */
+  export function startLoginContext(
+    params: StartLoginContextParams
+  ): ClientLoginContext {
+    const { startLoginRequest, context } =
+      opaque_startClientLoginContext(params);
+    return {
+      startLoginRequest,
+      finish(loginResponse) {
+        return opaque_finishClientLoginContext({ context, loginResponse });
+      },
+      tryFinish(loginResponse) {
+        return opaque_finishClientLoginContextResult({
+          context,
+          loginResponse,
+        });
+      },
+      finishAsync(loginResponse, options) {
+        return runAsync(
+          opaque_finishClientLoginContextAsync,
+          { context, loginResponse },
+          options
+        );
+      },
+    };
+  }
+
+  export type CalibrateKeyStretchingParams = {
+    /** how long the key stretching should take on this device */
+    targetDurationMs: number;
+    /** defaults to 1 */
+    parallelism?: number;
+  };
+
+  /**
+   * Times the key stretching on the current device and suggests parameters
+   * for which it takes about `targetDurationMs`. Blocks the JS thread for
+   * a few runs of the default key stretching. Only available on iOS and
+   * Android.
+   */
+  export const calibrateKeyStretching = opaque_calibrateKeyStretching;
+
+  export type PrewarmKeyStretchingParams = {
+    /** defaults to the default key stretching parameters */
+    keyStretching?: KeyStretchingParams;
+  };
+
+  /**
+   * Allocates and faults in the memory of the key stretching up front and
+   * keeps it for the following calls, e.g. when the login screen appears.
+   * Only the zeroized memory is kept between logins, every call zeroizes
+   * it before the next one can use it. The memory is freed by
+   * `releaseKeyStretchingMemory` and when the system runs low on memory.
+   * Only available on iOS and Android.
+   */
+  export function prewarmKeyStretching(params?: PrewarmKeyStretchingParams) {
+    opaque_prewarmKeyStretching(params ?? {});
+  }
+
+  /**
+   * Zeroizes and frees the memory kept by `prewarmKeyStretching`, the
+   * following calls allocate their memory again.
+   */
+  export const releaseKeyStretchingMemory = opaque_releaseKeyStretchingMemory;
+
+  export type CpuTopology = {
+    cores: number;
+    /** cores excluding the efficiency cores of big.LITTLE systems */
+    performanceCores: number;
+  };
+
+  /**
+   * The cores of the device. Key stretching with a `parallelism` above 1
+   * computes the lanes concurrently on up to `performanceCores` threads. Only
+   * available on iOS and Android.
+   */
+  export const getCpuTopology = opaque_getCpuTopology;
+
+  /**
+   * Same as `finishRegistration` but runs the key stretching on a native
+   * worker thread instead of blocking the JS thread.
+   */
+  export function finishRegistrationAsync(
+    params: FinishRegistrationParams,
+    options?: AsyncOptions
+  ) {
+    return runAsync(opaque_finishClientRegistrationAsync, params, options);
+  }
+
+  /**
+   * Same as `finishLogin` but runs the key stretching on a native worker
+   * thread instead of blocking the JS thread.
+   */
+  export function finishLoginAsync(
+    params: FinishLoginParams,
+    options?: AsyncOptions
+  ) {
+    return runAsync(opaque_finishClientLoginAsync, params, options);
+  }
 }
 
-declare function opaque_createServerSetup(): string;
+declare function opaque_createServerSetup(params: CipherSuiteParams): string;
+
+declare const serverSetupHandleBrand: unique symbol;
+
+declare function opaque_createServerSetupHandle(
+  serverSetup: string | binary.BinaryInput,
+  params: CipherSuiteParams
+): server.ServerSetupHandle;
 
-declare function opaque_getServerPublicKey(serverSetup: string): string;
+declare function opaque_getServerPublicKey(
+  serverSetup: string | server.ServerSetupHandle | server.ServerSetupKeyring,
+  params: server.ServerSetupParams
+): string;
 
 declare function opaque_createServerRegistrationResponse(
   params: server.CreateRegistrationResponseParams
@@ -96,13 +418,114 @@ declare function opaque_startServerLogin(
   params: server.StartLoginParams
 ): server.StartLoginResult;
 
+declare function opaque_startServerLoginResult(
+  params: server.StartLoginParams
+): Result<server.StartLoginResult>;
+
+declare function opaque_startServerLoginBatch(
+  serverSetup: string | server.ServerSetupHandle | server.ServerSetupKeyring,
+  requests: server.StartLoginBatchRequest[],
+  params: server.ServerSetupParams
+): server.StartLoginBatchResult[];
+
 declare function opaque_finishServerLogin(
   params: server.FinishLoginParams
 ): server.FinishLoginResult;
 
+declare function opaque_finishServerLoginResult(
+  params: server.FinishLoginParams
+): Result<server.FinishLoginResult>;
+
+declare const loginSessionStoreBrand: unique symbol;
+
+declare function opaque_createServerLoginSessionStore(
+  params: server.CreateLoginSessionStoreParams
+): server.LoginSessionStore;
+
+declare function opaque_getServerLoginSessionCount(
+  sessionStore: server.LoginSessionStore
+): number;
+
+declare function opaque_startServerLoginSession(
+  params: server.StartLoginSessionParams
+): server.StartLoginSessionResult;
+
+declare function opaque_finishServerLoginSession(
+  params: server.FinishLoginSessionParams
+): server.FinishLoginResult;
+
+declare function opaque_startServerLoginSessionResult(
+  params: server.StartLoginSessionParams
+): Result<server.StartLoginSessionResult>;
+
+declare function opaque_finishServerLoginSessionResult(
+  params: server.FinishLoginSessionParams
+): Result<server.FinishLoginResult>;
+
+declare const registrationImportBrand: unique symbol;
+
+declare function opaque_createRegistrationImport(
+  params: Omit<server.ImportRegistrationsParams, 'onChunk'>
+): server.RegistrationImport;
+
+declare function opaque_nextRegistrationImportChunk(
+  registrationImport: server.RegistrationImport,
+  jobId: number
+): Promise<server.RegistrationImportChunk>;
+
+declare const serverSetupKeyringBrand: unique symbol;
+
+declare function opaque_createServerSetupKeyring(): server.ServerSetupKeyring;
+
+declare function opaque_addServerSetupKey(
+  params: server.AddSetupKeyParams
+): void;
+
+declare function opaque_setActiveServerSetupKey(
+  params: server.SetupKeyParams
+): void;
+
+declare function opaque_removeServerSetupKey(
+  params: server.SetupKeyParams
+): boolean;
+
+declare function opaque_getServerSetupKeys(
+  keyring: server.ServerSetupKeyring
+): server.SetupKeys;
+
 export namespace server {
-  export type CreateRegistrationResponseParams = {
-    serverSetup: string;
+  /**
+   * Decoded server setup kept in native memory, see `createSetupHandle`.
+   */
+  export type ServerSetupHandle = {
+    readonly [serverSetupHandleBrand]: true;
+  };
+
+  /**
+   * Decoded server setups by key ID kept in native memory, see
+   * `createSetupKeyring`.
+   */
+  export type ServerSetupKeyring = {
+    readonly [serverSetupKeyringBrand]: true;
+  };
+
+  export type ServerSetup = string | ServerSetupHandle | ServerSetupKeyring;
+
+  /**
+   * `keyId` selects the key of a keyring passed as `serverSetup`, without it
+   * the active key is used. It's ignored for the other server setups.
+   */
+  export type ServerSetupParams = CipherSuiteParams & {
+    keyId?: string;
+  };
+
+  /**
+   * A handle keeps the suite it was created with, the `suite` of the params
+   * only has to be passed together with a base64 string and otherwise must
+   * match the one of the handle.
+   */
+  export type CreateRegistrationResponseParams = ServerSetupParams & {
+    serverSetup: ServerSetup;
     userIdentifier: string;
     registrationRequest: string;
   };
@@ -111,8 +534,8 @@ export namespace server {
     registrationResponse: string;
   };
 
-  export type StartLoginParams = {
-    serverSetup: string;
+  export type StartLoginParams = ServerSetupParams & {
+    serverSetup: ServerSetup;
     registrationRecord: string | null | undefined;
     startLoginRequest: string;
     userIdentifier: string;
@@ -124,7 +547,20 @@ export namespace server {
     loginResponse: string;
   };
 
-  export type FinishLoginParams = {
+  export type StartLoginBatchRequest = Omit<
+    StartLoginParams,
+    'serverSetup' | 'suite' | 'keyId'
+  >;
+
+  /**
+   * Either the result of the login or the code and message of its error,
+   * like a failed `Result`.
+   */
+  export type StartLoginBatchResult =
+    | (StartLoginResult & { error?: undefined })
+    | { error: ErrorCode; message: string };
+
+  export type FinishLoginParams = CipherSuiteParams & {
     serverLoginState: string;
     finishLoginRequest: string;
   };
@@ -133,13 +569,444 @@ export namespace server {
     sessionKey: string;
   };
 
-  export const createSetup = opaque_createServerSetup;
-  export const getPublicKey = opaque_getServerPublicKey;
+  /**
+   * Keeps the server login states in native memory between `startLoginSession`
+   * and `finishLoginSession`, see `createLoginSessionStore`.
+   */
+  export type LoginSessionStore = {
+    readonly [loginSessionStoreBrand]: true;
+  };
+
+  export type CreateLoginSessionStoreParams = {
+    /** time to finish a login after starting it, defaults to 60 seconds */
+    ttlMs?: number;
+    /** approximate memory limit of the pending logins, defaults to 64 MiB */
+    maxMemoryBytes?: number;
+  };
+
+  export type StartLoginSessionParams = StartLoginParams & {
+    sessionStore: LoginSessionStore;
+  };
+
+  export type StartLoginSessionResult = {
+    /** pass to `finishLoginSession`, only valid within this process */
+    sessionHandle: string;
+    loginResponse: string;
+  };
+
+  export type FinishLoginSessionParams = {
+    sessionStore: LoginSessionStore;
+    sessionHandle: string;
+    finishLoginRequest: string;
+  };
+
+  /**
+   * Native state of a running `importRegistrations`.
+   */
+  export type RegistrationImport = {
+    readonly [registrationImportBrand]: true;
+  };
+
+  export type ImportRegistrationsParams = ServerSetupParams & {
+    serverSetup: ServerSetup;
+    /**
+     * The records to import back to back, each the UTF-8 user identifier and
+     * the registration request, both prefixed with their length as 32-bit
+     * unsigned little endian integer.
+     */
+    records: binary.BinaryInput;
+    /** records per chunk, defaults to 1024 */
+    chunkSize?: number;
+    /**
+     * Receives the responses chunk by chunk, in the order of the records.
+     * Only the next chunk is created while the returned promise is pending,
+     * so a slow consumer holds back the import.
+     */
+    onChunk: (chunk: RegistrationImportChunk) => void | Promise<void>;
+  };
+
+  export type RegistrationImportChunk = {
+    /**
+     * One entry per record: a status byte (0 for success, 1 for failure),
+     * the length as 32-bit unsigned little endian integer and the
+     * registration response or the UTF-8 error message.
+     */
+    responses: Uint8Array;
+    /** number of records in this chunk */
+    count: number;
+    /** number of failed records in this chunk */
+    failed: number;
+    /** number of records processed so far, including this chunk */
+    processed: number;
+    total: number;
+  };
+
+  export type ImportRegistrationsResult = {
+    total: number;
+    failed: number;
+  };
+
+  export type AddSetupKeyParams = CipherSuiteParams & {
+    keyring: ServerSetupKeyring;
+    keyId: string;
+    serverSetup: string | binary.BinaryInput | ServerSetupHandle;
+  };
+
+  export type SetupKeyParams = {
+    keyring: ServerSetupKeyring;
+    keyId: string;
+  };
+
+  export type SetupKeys = {
+    /** undefined while the keyring is empty */
+    activeKeyId?: string;
+    keyIds: string[];
+  };
+
+  export function createSetup(params: CipherSuiteParams = {}) {
+    return opaque_createServerSetup(params);
+  }
+  /**
+   * Decodes and validates the server setup (base64 string or bytes) once so
+   * it can be passed to the other server functions instead.
+   */
+  export function createSetupHandle(
+    serverSetup: string | binary.BinaryInput,
+    params: CipherSuiteParams = {}
+  ) {
+    return opaque_createServerSetupHandle(serverSetup, params);
+  }
+  export function getPublicKey(
+    serverSetup: ServerSetup,
+    params: ServerSetupParams = {}
+  ) {
+    return opaque_getServerPublicKey(serverSetup, params);
+  }
   export const createRegistrationResponse =
     opaque_createServerRegistrationResponse;
   export const startLogin = opaque_startServerLogin;
+  /**
+   * Starts the logins for many requests at once, spread across the available
+   * cores. A failing request doesn't throw, instead its entry in the result
+   * contains an `error` message.
+   */
+  export function startLoginBatch(
+    serverSetup: ServerSetup,
+    requests: StartLoginBatchRequest[],
+    params: ServerSetupParams = {}
+  ) {
+    return opaque_startServerLoginBatch(serverSetup, requests, params);
+  }
   export const finishLogin = opaque_finishServerLogin;
+  /**
+   * Same as `startLogin` and `finishLogin` but return the error instead of
+   * throwing it, e.g. `invalidLogin` for a wrong password.
+   */
+  export const tryStartLogin = opaque_startServerLoginResult;
+  export const tryFinishLogin = opaque_finishServerLoginResult;
+
+  /**
+   * Creates an in-process store for the login states. With it the server
+   * state doesn't have to be kept by the caller between `startLoginSession`
+   * and `finishLoginSession`, only a short handle. A session can only be
+   * finished once and expires after `ttlMs`. Starting a login fails while
+   * the store is full. Only available on iOS and Android.
+   */
+  export function createLoginSessionStore(
+    params: CreateLoginSessionStoreParams = {}
+  ) {
+    return opaque_createServerLoginSessionStore(params);
+  }
+  /** Number of pending logins, including expired ones not yet evicted. */
+  export const getLoginSessionCount = opaque_getServerLoginSessionCount;
+  /** Same as `startLogin` but keeps the login state in the session store. */
+  export const startLoginSession = opaque_startServerLoginSession;
+  /** Finishes the login and removes the session from the store. */
+  export const finishLoginSession = opaque_finishServerLoginSession;
+  /** Same as `startLoginSession` but returns the error, see `tryStartLogin`. */
+  export const tryStartLoginSession = opaque_startServerLoginSessionResult;
+  /** Same as `finishLoginSession` but returns the error. */
+  export const tryFinishLoginSession = opaque_finishServerLoginSessionResult;
+
+  /**
+   * Creates an empty keyring for rotating the server setup. The server
+   * functions accept it as `serverSetup` and use the key of the `keyId`
+   * param, or the active key without one, so the key ID stored with a
+   * registration record selects the key of its login. Only available on iOS
+   * and Android.
+   */
+  export const createSetupKeyring = opaque_createServerSetupKeyring;
+  /**
+   * Decodes the server setup once and adds it under `keyId`, which must not
+   * be taken. The first key of a keyring becomes its active key.
+   */
+  export const addSetupKey = opaque_addServerSetupKey;
+  /**
+   * Makes the key the one used by the calls without a `keyId`, e.g. the new
+   * registrations. Logins already started with the previous key finish as
+   * usual.
+   */
+  export const setActiveSetupKey = opaque_setActiveServerSetupKey;
+  /**
+   * Removes a key once no record uses it anymore, the active key can't be
+   * removed. Returns whether the key was in the keyring.
+   */
+  export const removeSetupKey = opaque_removeServerSetupKey;
+  export const getSetupKeys = opaque_getServerSetupKeys;
+
+  /**
+   * Creates the registration responses for many users at once, e.g. when
+   * migrating a tenant. The records are processed in chunks on a native
+   * worker thread, each chunk spread across the available cores, and the
+   * responses are passed to `onChunk` as they are ready. A failing record
+   * doesn't fail the import, instead its entry in the chunk holds the error.
+   * Malformed records make the call throw before any response is created.
+   * With a keyring the key is selected once, re-registering users with a new
+   * key doesn't switch keys midway if the active key changes.
+   * Only available on iOS and Android.
+   */
+  export async function importRegistrations(
+    params: ImportRegistrationsParams,
+    options?: AsyncOptions
+  ): Promise<ImportRegistrationsResult> {
+    const { onChunk, ...importParams } = params;
+    const registrationImport = opaque_createRegistrationImport(importParams);
+    const nextChunk = () =>
+      runAsync(opaque_nextRegistrationImportChunk, registrationImport, options);
+    let total = 0;
+    let failed = 0;
+    let next = nextChunk();
+    try {
+      for (;;) {
+        const chunk = await next;
+        total = chunk.total;
+        if (chunk.count === 0) {
+          break;
+        }
+        failed += chunk.failed;
+        // create the next chunk while the caller handles this one
+        next = nextChunk();
+        await onChunk(chunk);
+      }
+    } finally {
+      // the prefetched chunk is dropped if onChunk throws
+      next.catch(() => {});
+    }
+    return { total, failed };
+  }
+}
+
+declare function opaque_startClientRegistrationBinary(
+  params: binary.client.StartRegistrationParams
+): binary.client.StartRegistrationResult;
+
+declare function opaque_finishClientRegistrationBinary(
+  params: binary.client.FinishRegistrationParams
+): binary.client.FinishRegistrationResult;
+
+declare function opaque_startClientLoginBinary(
+  params: binary.client.StartLoginParams
+): binary.client.StartLoginResult;
+
+declare function opaque_finishClientLoginBinary(
+  params: binary.client.FinishLoginParams
+): binary.client.FinishLoginResult | undefined;
+
+declare function opaque_createServerSetupBinary(
+  params: CipherSuiteParams
+): Uint8Array;
+
+declare function opaque_getServerPublicKeyBinary(
+  serverSetup:
+    | binary.BinaryInput
+    | server.ServerSetupHandle
+    | server.ServerSetupKeyring,
+  params: server.ServerSetupParams
+): Uint8Array;
+
+declare function opaque_createServerRegistrationResponseBinary(
+  params: binary.server.CreateRegistrationResponseParams
+): binary.server.CreateRegistrationResponseResult;
+
+declare function opaque_startServerLoginBinary(
+  params: binary.server.StartLoginParams
+): binary.server.StartLoginResult;
+
+declare function opaque_finishServerLoginBinary(
+  params: binary.server.FinishLoginParams
+): binary.server.FinishLoginResult;
+
+type ServerSetupHandle = server.ServerSetupHandle;
+type ServerSetupKeyring = server.ServerSetupKeyring;
+type ServerSetupParams = server.ServerSetupParams;
+
+/**
+ * Same API as `client` and `server`, but the protocol messages, states and
+ * keys are passed as raw bytes instead of base64 encoded strings. This avoids
+ * the encoding overhead and the larger payloads when the messages are sent
+ * over a binary transport anyway. Only available on iOS and Android.
+ */
+export namespace binary {
+  export type BinaryInput = Uint8Array | ArrayBuffer;
+
+  export namespace client {
+    export type StartRegistrationParams = CipherSuiteParams & {
+      password: string;
+    };
+
+    export type StartRegistrationResult = {
+      clientRegistrationState: Uint8Array;
+      registrationRequest: Uint8Array;
+    };
+
+    export type FinishRegistrationParams = CipherSuiteParams & {
+      password: string;
+      registrationResponse: BinaryInput;
+      clientRegistrationState: BinaryInput;
+      identifiers?: CustomIdentifiers;
+      keyStretching?: KeyStretchingParams;
+    };
+
+    export type FinishRegistrationResult = {
+      registrationRecord: Uint8Array;
+      exportKey: Uint8Array;
+      serverStaticPublicKey: Uint8Array;
+      keyStretching: KeyStretchingParams;
+    };
+
+    export type StartLoginParams = CipherSuiteParams & {
+      password: string;
+    };
+
+    export type StartLoginResult = {
+      clientLoginState: Uint8Array;
+      startLoginRequest: Uint8Array;
+    };
+
+    export type FinishLoginParams = CipherSuiteParams & {
+      clientLoginState: BinaryInput;
+      loginResponse: BinaryInput;
+      password: string;
+      identifiers?: CustomIdentifiers;
+      keyStretching?: KeyStretchingParams;
+    };
+
+    export type FinishLoginResult = {
+      finishLoginRequest: Uint8Array;
+      sessionKey: Uint8Array;
+      exportKey: Uint8Array;
+      serverStaticPublicKey: Uint8Array;
+    };
+
+    export const startRegistration = opaque_startClientRegistrationBinary;
+    export const finishRegistration = opaque_finishClientRegistrationBinary;
+    export const startLogin = opaque_startClientLoginBinary;
+    export const finishLogin = opaque_finishClientLoginBinary;
+  }
+
+  export namespace server {
+    export type CreateRegistrationResponseParams = ServerSetupParams & {
+      serverSetup: BinaryInput | ServerSetupHandle | ServerSetupKeyring;
+      userIdentifier: string;
+      registrationRequest: BinaryInput;
+    };
+
+    export type CreateRegistrationResponseResult = {
+      registrationResponse: Uint8Array;
+    };
+
+    export type StartLoginParams = ServerSetupParams & {
+      serverSetup: BinaryInput | ServerSetupHandle | ServerSetupKeyring;
+      registrationRecord: BinaryInput | null | undefined;
+      startLoginRequest: BinaryInput;
+      userIdentifier: string;
+      identifiers?: CustomIdentifiers;
+    };
+
+    export type StartLoginResult = {
+      serverLoginState: Uint8Array;
+      loginResponse: Uint8Array;
+    };
+
+    export type FinishLoginParams = CipherSuiteParams & {
+      serverLoginState: BinaryInput;
+      finishLoginRequest: BinaryInput;
+    };
+
+    export type FinishLoginResult = {
+      sessionKey: Uint8Array;
+    };
+
+    export function createSetup(params: CipherSuiteParams = {}) {
+      return opaque_createServerSetupBinary(params);
+    }
+    export function getPublicKey(
+      serverSetup: BinaryInput | ServerSetupHandle | ServerSetupKeyring,
+      params: ServerSetupParams = {}
+    ) {
+      return opaque_getServerPublicKeyBinary(serverSetup, params);
+    }
+    export const createRegistrationResponse =
+      opaque_createServerRegistrationResponseBinary;
+    export const startLogin = opaque_startServerLoginBinary;
+    export const finishLogin = opaque_finishServerLoginBinary;
+  }
 }
 
 // needed for web version to indicate when the module has been loaded since WASM is async
 export const ready = Promise.resolve();
+
+declare function opaque_setMetricsEnabled(enabled: boolean): void;
+
+declare function opaque_getMetrics(): metrics.Metrics;
+
+declare function opaque_resetMetrics(): void;
+
+/**
+ * Opt-in timing of the protocol functions on the device. Only available on
+ * iOS and Android.
+ */
+export namespace metrics {
+  export type Phase =
+    /** reading the params from JS and creating the result */
+    | 'marshalling'
+    | 'base64'
+    | 'deserialize'
+    /** the Argon2 key stretching */
+    | 'ksf'
+    /** the protocol computations, mostly group operations */
+    | 'group'
+    /** the whole call */
+    | 'total';
+
+  /**
+   * Durations in microseconds. A phase doesn't include the phases nested
+   * in it. The percentiles are rounded up to the next power of two (in
+   * nanoseconds).
+   */
+  export type PhaseMetrics = {
+    count: number;
+    totalUs: number;
+    maxUs: number;
+    p50Us: number;
+    p90Us: number;
+    p99Us: number;
+  };
+
+  /**
+   * By function name, e.g. `startServerLogin`. The string, binary and async
+   * variants of a function are counted together, the batch functions aren't
+   * recorded.
+   */
+  export type Metrics = Partial<
+    Record<string, Partial<Record<Phase, PhaseMetrics>>>
+  >;
+
+  /**
+   * Metrics are disabled by default, recording costs a clock read per phase.
+   * The recorded metrics are kept when disabling them.
+   */
+  export const setEnabled = opaque_setMetricsEnabled;
+  export const getMetrics = opaque_getMetrics;
+  export const resetMetrics = opaque_resetMetrics;
+}